@@ -0,0 +1,129 @@
+﻿using System;
+using NUnit.Framework;
+
+namespace Pyxis.Core.Test.Data
+{
+    /// <summary>
+    /// Compares reading a value tile through the bulk transfers of the .NET binding
+    /// with reading it one cell at a time, and reports the time of both.
+    /// </summary>
+    [TestFixture]
+    internal class ValueTileBulkTransferTests
+    {
+        private const int TileDepth = 8;
+        private const int Repetitions = 5;
+
+        private static PYXValueTile_SPtr CreateTile()
+        {
+            var definition = PYXTableDefinition.create();
+            definition.addFieldDefinition("value", PYXFieldDefinition.eContextType.knContextNone, PYXValue.eType.knDouble, 1);
+
+            var tile = PYXValueTile.create(new PYXIcosIndex("A-0"), 2 + TileDepth, new PYXTableDefinition_CSPtr(definition.get()));
+
+            // leave every 7th cell null.
+            var cellCount = tile.getNumberOfCells();
+            for (var offset = 0; offset < cellCount; ++offset)
+            {
+                if (offset % 7 != 0)
+                {
+                    tile.setValue(offset, 0, new PYXValue(offset * 0.5));
+                }
+            }
+            return tile;
+        }
+
+        [Test]
+        public void BulkTransferMatchesPerCellAccess()
+        {
+            var tile = CreateTile();
+            var cellCount = tile.getNumberOfCells();
+
+            bool[] hasValues;
+            var values = tile.get().GetChannelValues(0, out hasValues);
+
+            Assert.AreEqual(cellCount, values.Length);
+            Assert.AreEqual(cellCount, hasValues.Length);
+
+            for (var offset = 0; offset < cellCount; ++offset)
+            {
+                var value = tile.getValue(offset, 0);
+                Assert.AreEqual(!value.isNull(), hasValues[offset], "null flag of cell " + offset);
+                if (hasValues[offset])
+                {
+                    Assert.AreEqual(value.getDouble(), values[offset], "value of cell " + offset);
+                }
+            }
+
+            var data = tile.get().GetChannelData(0, out hasValues);
+            Assert.AreEqual(cellCount * sizeof(double), data.Length);
+            for (var offset = 0; offset < cellCount; ++offset)
+            {
+                if (hasValues[offset])
+                {
+                    Assert.AreEqual(values[offset], BitConverter.ToDouble(data, offset * sizeof(double)));
+                }
+            }
+
+            var latLons = tile.get().GetCellLatLons();
+            Assert.AreEqual(cellCount * 2, latLons.Length);
+        }
+
+        [Test]
+        public void BenchmarkBulkTransfer()
+        {
+            var tile = CreateTile();
+            var cellCount = tile.getNumberOfCells();
+
+            // warm up both paths once.
+            bool[] hasValues;
+            tile.get().GetChannelValues(0, out hasValues);
+            tile.getValue(0, 0).Dispose();
+
+            var checksum = 0.0;
+            var stopwatch = System.Diagnostics.Stopwatch.StartNew();
+            for (var repetition = 0; repetition < Repetitions; ++repetition)
+            {
+                for (var offset = 0; offset < cellCount; ++offset)
+                {
+                    using (var value = tile.getValue(offset, 0))
+                    {
+                        if (!value.isNull())
+                        {
+                            checksum += value.getDouble();
+                        }
+                    }
+                }
+            }
+            var perCell = stopwatch.Elapsed;
+
+            var bulkChecksum = 0.0;
+            stopwatch.Restart();
+            for (var repetition = 0; repetition < Repetitions; ++repetition)
+            {
+                var values = tile.get().GetChannelValues(0, out hasValues);
+                for (var offset = 0; offset < cellCount; ++offset)
+                {
+                    if (hasValues[offset])
+                    {
+                        bulkChecksum += values[offset];
+                    }
+                }
+            }
+            var bulk = stopwatch.Elapsed;
+
+            stopwatch.Restart();
+            for (var repetition = 0; repetition < Repetitions; ++repetition)
+            {
+                tile.get().GetCellLatLons();
+            }
+            var latLons = stopwatch.Elapsed;
+
+            Assert.AreEqual(checksum, bulkChecksum);
+
+            Trace.info(String.Format(
+                "value tile of {0} cells, {1} reads: per cell {2:F1} ms, bulk values {3:F1} ms ({4:F1}x), bulk lat/lons {5:F1} ms",
+                cellCount, Repetitions, perCell.TotalMilliseconds, bulk.TotalMilliseconds,
+                perCell.TotalMilliseconds / Math.Max(bulk.TotalMilliseconds, 0.001), latLons.TotalMilliseconds));
+        }
+    }
+}
@@ -26,8 +26,11 @@ web			: www.pyxisinnovation.com
 #include "pyxis/derm/sub_index_math.h"
 #include "pyxis/derm/snyder_projection.h"
 #include "pyxis/geometry/cell.h"
+#include "pyxis/geometry/cell_run_iterator.h"
+#include "pyxis/procs/default_feature.h"
 
 #include "pyxis/utility/exception.h"
+#include "pyxis/utility/profile.h"
 #include "pyxis/utility/string_utils.h"
 #include "pyxis/utility/tester.h"
 #include "pyxis/utility/value.h"
@@ -38,7 +41,9 @@ web			: www.pyxisinnovation.com
 #include <boost/thread/xtime.hpp>
 
 // standard includes
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 
 // {E82F5DB8-3BF9-48b5-B529-64BB7819DD38}
 PYXCOM_DEFINE_CLSID(StyledFeatureRasterizer, 
@@ -56,6 +61,72 @@ namespace
 //! Tester class
 Tester<StyledFeatureRasterizer> gTester;
 
+//! A feature collection with styles and a numeric field, for testing.
+class StyledTestFeatureCollection : public DefaultFeatureCollection
+{
+public:
+	StyledTestFeatureCollection() : m_spFeatureDefn(PYXTableDefinition::create())
+	{
+		m_spFeatureDefn->addFieldDefinition("value", PYXFieldDefinition::knContextNone, PYXValue::knDouble, 1);
+	}
+
+	void setStyle(const std::string & strStyle,const std::string & strValue)
+	{
+		m_mapStyles[strStyle] = strValue;
+	}
+
+	virtual std::string STDMETHODCALLTYPE getStyle(const std::string& strStyleToGet) const
+	{
+		std::map<std::string,std::string>::const_iterator it = m_mapStyles.find(strStyleToGet);
+		return it != m_mapStyles.end() ? it->second : "";
+	}
+
+	virtual PYXPointer<const PYXTableDefinition> STDMETHODCALLTYPE getFeatureDefinition() const
+	{
+		return m_spFeatureDefn;
+	}
+
+	virtual PYXPointer<PYXTableDefinition> STDMETHODCALLTYPE getFeatureDefinition()
+	{
+		return m_spFeatureDefn;
+	}
+
+private:
+	PYXPointer<PYXTableDefinition> m_spFeatureDefn;
+	std::map<std::string,std::string> m_mapStyles;
+};
+
+//! A synthetic polygon layer: circles of various sizes around cells of a tile.
+boost::intrusive_ptr<StyledTestFeatureCollection> createPolygonLayer(const PYXIcosIndex & root,int nResolution,int nFeatureCount)
+{
+	boost::intrusive_ptr<StyledTestFeatureCollection> spFC(new StyledTestFeatureCollection());
+
+	unsigned int nSeed = 1;
+	for (int n = 0; n < nFeatureCount; ++n)
+	{
+		nSeed = nSeed * 1103515245u + 12345u;
+		int nCenterResolution = root.getResolution() + 2 + (nSeed >> 8) % 4;
+		int nOffset = (nSeed >> 12) % PYXIcosMath::getCellCount(root,nCenterResolution);
+
+		PYXIcosIndex center = PYXIcosMath::calcIndexFromOffset(root,nCenterResolution,nOffset);
+		PYXPointer<PYXGeometry> spGeometry = PYXVectorGeometry2::create(PYXCircleRegion::create(center,true),nResolution);
+
+		boost::intrusive_ptr<DefaultFeature> spFeature(new DefaultFeature(spGeometry));
+		spFeature->addField("value", PYXFieldDefinition::knContextNone, PYXValue::knDouble, 1, PYXValue(static_cast<double>(n % 100)));
+		spFC->addFeature(spFeature);
+	}
+
+	return spFC;
+}
+
+//! The definition of the rasterized coverage.
+PYXPointer<PYXTableDefinition> createRasterDefinition()
+{
+	PYXPointer<PYXTableDefinition> spDefn = PYXTableDefinition::create();
+	spDefn->addFieldDefinition("RGB", PYXFieldDefinition::knContextRGB, PYXValue::knUInt8, 4);
+	return spDefn;
+}
+
 }
 
 StyledFeatureRasterizer::StyledFeatureRasterizer() : m_useAlpha(false)
@@ -68,6 +139,138 @@ StyledFeatureRasterizer::~StyledFeatureRasterizer()
 
 void StyledFeatureRasterizer::test()
 {
+	const PYXIcosIndex root("1-20");
+	const int nResolution = root.getResolution() + 6;
+	const PYXTile tile(root,nResolution);
+
+	// a single polygon is filled with its fill color
+	{
+		boost::intrusive_ptr<StyledTestFeatureCollection> spFC(new StyledTestFeatureCollection());
+		spFC->setStyle("Area/Colour","uint8_t[3] 127 127 255");
+		spFC->setStyle("Area/Opacity","100");
+		PYXIcosIndex center(root);
+		center.setResolution(root.getResolution() + 2);
+		PYXPointer<PYXGeometry> spGeometry = PYXVectorGeometry2::create(PYXCircleRegion::create(center,true),nResolution);
+		spFC->addFeature(boost::intrusive_ptr<IFeature>(new DefaultFeature(spGeometry)));
+
+		boost::shared_ptr<RasterStateVector> states(new RasterStateVector());
+		states->push_back(RasterState::create(spFC,ProcRef(),createRasterDefinition()));
+
+		RasterContext context(states,root,nResolution);
+		context.raster();
+		PYXPointer<PYXValueTile> spValueTile = context.getResultValueTile();
+		TEST_ASSERT(spValueTile);
+
+		std::vector<bool> inside(tile.getCellCount(),false);
+		for (PYXPointer<PYXCellRunIterator> spRuns = PYXCellRunIterator::create(tile,*spGeometry); !spRuns->end(); spRuns->next())
+		{
+			std::fill(inside.begin() + spRuns->getBegin(),inside.begin() + spRuns->getEnd(),true);
+		}
+
+		for (int nOffset = 0; nOffset < tile.getCellCount(); ++nOffset)
+		{
+			bool bInitialized = false;
+			PYXValue value = spValueTile->getValue(nOffset,0,&bInitialized);
+			TEST_ASSERT_EQUAL(bInitialized,static_cast<bool>(inside[nOffset]));
+			if (bInitialized)
+			{
+				TEST_ASSERT(value.getUInt8(0) == 127 && value.getUInt8(1) == 127 && value.getUInt8(2) == 255 && value.getUInt8(3) == 255);
+			}
+		}
+	}
+
+	// the compiled palette matches the palette
+	{
+		boost::intrusive_ptr<StyledTestFeatureCollection> spFC(new StyledTestFeatureCollection());
+		spFC->setStyle("Area/Palette","2  0 0 0 255 255  100 255 0 0 255");
+		spFC->setStyle("Area/PaletteField","value");
+
+		PYXPointer<RasterState> spState = RasterState::create(spFC,ProcRef(),createRasterDefinition());
+		PYXPointer<PYXValueColorPalette> spPalette = PYXValueColorPalette::create("2  0 0 0 255 255  100 255 0 0 255");
+
+		for (double fValue = -10; fValue < 110; fValue += 0.37)
+		{
+			unsigned char compiledColor[4];
+			unsigned char paletteColor[4];
+			spState->convertPaletteValue(PYXValue(fValue),compiledColor);
+			spPalette->convert(PYXValue(fValue),paletteColor,true);
+
+			for (int i = 0; i < 4; ++i)
+			{
+				TEST_ASSERT(std::abs(compiledColor[i] - paletteColor[i]) <= 2);
+			}
+		}
+	}
+
+	// rasterizing is deterministic, whatever thread rasterized each feature
+	{
+		boost::intrusive_ptr<StyledTestFeatureCollection> spFC = createPolygonLayer(root,nResolution,200);
+		spFC->setStyle("Area/Palette","2  0 0 0 255 255  100 255 0 0 255");
+		spFC->setStyle("Area/PaletteField","value");
+
+		boost::shared_ptr<RasterStateVector> states(new RasterStateVector());
+		states->push_back(RasterState::create(spFC,ProcRef(),createRasterDefinition()));
+
+		RasterContext firstContext(states,root,nResolution);
+		firstContext.raster();
+		RasterContext secondContext(states,root,nResolution);
+		secondContext.raster();
+
+		for (int nOffset = 0; nOffset < tile.getCellCount(); ++nOffset)
+		{
+			TEST_ASSERT(firstContext.getResultValueTile()->getValue(nOffset,0) == secondContext.getResultValueTile()->getValue(nOffset,0));
+		}
+	}
+}
+
+void StyledFeatureRasterizer::benchmark()
+{
+	const PYXIcosIndex root("1-20");
+
+	const int nFeatureCount = 2000;
+	const int nBenchmarkResolution = root.getResolution() + 9;
+
+	boost::intrusive_ptr<StyledTestFeatureCollection> spFC = createPolygonLayer(root,nBenchmarkResolution,nFeatureCount);
+	spFC->setStyle("Area/Palette","2  0 0 0 255 255  100 255 0 0 255");
+	spFC->setStyle("Area/PaletteField","value");
+
+	boost::shared_ptr<RasterStateVector> states(new RasterStateVector());
+	states->push_back(RasterState::create(spFC,ProcRef(),createRasterDefinition()));
+
+	PYXHighQualityTimer timer;
+	timer.start();
+	RasterContext context(states,root,nBenchmarkResolution);
+	context.raster();
+	timer.stop();
+	double fRasterTime = timer.getTime();
+
+	// style evaluation alone
+	const int nEvaluationCount = 1000000;
+	unsigned char color[4];
+	int nSum = 0;
+	PYXPointer<PYXValueColorPalette> spPalette = PYXValueColorPalette::create("2  0 0 0 255 255  100 255 0 0 255");
+
+	timer.start();
+	for (int n = 0; n < nEvaluationCount; ++n)
+	{
+		spPalette->convert(PYXValue((n % 1000) / 10.0),color,true);
+		nSum += color[0];
+	}
+	timer.stop();
+	double fPaletteTime = timer.getTime();
+
+	timer.start();
+	for (int n = 0; n < nEvaluationCount; ++n)
+	{
+		(*states)[0]->convertPaletteValue(PYXValue((n % 1000) / 10.0),color);
+		nSum -= color[0];
+	}
+	timer.stop();
+	double fCompiledTime = timer.getTime();
+
+	TRACE_INFO("StyledFeatureRasterizer: " << nFeatureCount << " polygons rasterized into a tile of " << PYXIcosMath::getCellCount(root,nBenchmarkResolution) <<
+		" cells in " << fRasterTime << "[sec] (" << nFeatureCount / fRasterTime << " features/sec). Palette color: " <<
+		fPaletteTime * 1e9 / nEvaluationCount << "[ns], compiled: " << fCompiledTime * 1e9 / nEvaluationCount << "[ns] (checksum " << nSum << ")");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -264,13 +467,18 @@ StyledFeatureRasterizer::RasterState::RasterState(
 		m_definition(definition),
 		m_hasFillColor(false),
 		m_hasLineColor(false),
-		m_paletteFieldIndex(-1)
+		m_paletteFieldIndex(-1),
+		m_paletteLookupMin(0),
+		m_paletteLookupScale(0)
 {
+	m_hasAlpha = (m_definition->getFieldDefinition(0).getCount()==4);
+
 	loadStyleParameters();
 	if (!m_paletteField.empty())
 	{
 		m_paletteFieldIndex = m_spFC->getFeatureDefinition()->getFieldIndex(m_paletteField);
 	}
+	compileStyle();
 }
 
 PYXValue StyledFeatureRasterizer::RasterState::getColor(const std::string & styleNode) 
@@ -359,11 +567,6 @@ int StyledFeatureRasterizer::RasterState::getFillOpacity(const std::string & sty
 }
 
 
-bool StyledFeatureRasterizer::RasterState::hasAlphaChannel()
-{
-	return (m_definition->getFieldDefinition(0).getCount()==4);
-}
-
 void StyledFeatureRasterizer::RasterState::addAlphaChannel(PYXValue & value,int alphaValue)
 {
 	PYXValue finalColor = m_definition->getFieldDefinition(0).getTypeCompatibleValue();
@@ -421,6 +624,65 @@ void StyledFeatureRasterizer::RasterState::loadStyleParameters()
 #endif
 }
 
+void StyledFeatureRasterizer::RasterState::compileStyle()
+{
+	//the colors are resolved once, features only copy the bytes
+	for(int i=0;i<3;i++)
+	{
+		m_compiledLineColor[i] = m_lineColor.getUInt8(i);
+		m_compiledFillColor[i] = m_fillColor.getUInt8(i);
+	}
+	m_compiledLineColor[3] = m_hasAlpha ? m_lineColor.getUInt8(3) : 255;
+	m_compiledFillColor[3] = m_hasAlpha ? m_fillColor.getUInt8(3) : 255;
+
+	if (!m_hasFillColor)
+	{
+		m_compiledFillColor[3] = 0;
+	}
+
+	if (!m_hasLineColor)
+	{
+		m_compiledLineColor[3] = 0;
+	}
+
+	//sample numeric palettes into a lookup table - finding the palette step of every value is too slow
+	m_paletteLookup.clear();
+	if (m_palette && m_palette->getNumericPalette())
+	{
+		const PYXColorPalette & palette = *m_palette->getNumericPalette();
+		m_paletteLookupMin = palette.getMinPosition();
+		double range = palette.getMaxPosition() - m_paletteLookupMin;
+
+		if (range > 0)
+		{
+			m_paletteLookupScale = (knPaletteLookupSize-1) / range;
+			m_paletteLookup.resize(4*knPaletteLookupSize);
+			for(int i=0;i<knPaletteLookupSize;i++)
+			{
+				palette.convert(m_paletteLookupMin + i / m_paletteLookupScale,&m_paletteLookup[4*i],true);
+			}
+		}
+	}
+}
+
+void StyledFeatureRasterizer::RasterState::convertPaletteValue(const PYXValue & value,unsigned char rgba[4]) const
+{
+	if (!m_paletteLookup.empty() && value.isNumeric())
+	{
+		double position = value.getDouble();
+
+		//nan values are left to the palette
+		if (!_isnan(position))
+		{
+			int entry = static_cast<int>((position - m_paletteLookupMin) * m_paletteLookupScale + 0.5);
+			entry = std::max(0,std::min(knPaletteLookupSize-1,entry));
+			memcpy(rgba,&m_paletteLookup[4*entry],4);
+			return;
+		}
+	}
+	m_palette->convert(value,rgba,true);
+}
+
 bool StyledFeatureRasterizer::RasterState::doesStyleRequireToDrilIntoGroup(const PYXPointer<IFeatureGroup> & group) const
 {
 	return m_palette || (!m_hasFillColor && m_hasLineColor);
@@ -435,34 +697,11 @@ void StyledFeatureRasterizer::RasterState::getStyleForFeature(const PYXPointer<I
 {
 
 	//vector geometries support borders - so, we can use line and borders...
-	lineColor[0] = m_lineColor.getUInt8(0);
-	lineColor[1] = m_lineColor.getUInt8(1);
-	lineColor[2] = m_lineColor.getUInt8(2);
+	memcpy(lineColor,m_compiledLineColor,4);
+	memcpy(fillColor,m_compiledFillColor,4);
 
-	fillColor[0] = m_fillColor.getUInt8(0);
-	fillColor[1] = m_fillColor.getUInt8(1);
-	fillColor[2] = m_fillColor.getUInt8(2);
-
-	if (hasAlphaChannel())
-	{
-		fillColor[3] = m_fillColor.getUInt8(3);
-		lineColor[3] = m_lineColor.getUInt8(3);
-	}
-	else 
-	{
-		lineColor[3] = 255;
-		fillColor[3] = 255;
-	}
-
-	if (!m_hasFillColor)
-	{
-		fillColor[3] = 0;
-	}
-
-	if (!m_hasLineColor)
-	{
-		lineColor[3] = 0;
-	}
+	//the opacity of the fill color applies to the palette colors
+	const int fillOpacity = m_hasAlpha ? m_fillColor.getUInt8(3) : 255;
 
 	if (m_palette)
 	{
@@ -497,7 +736,7 @@ void StyledFeatureRasterizer::RasterState::getStyleForFeature(const PYXPointer<I
 
 					if (it->range.single())
 					{
-						m_palette->convert(it->range.min,minColor,true);
+						convertPaletteValue(it->range.min,minColor);
 						finalColor[0] += minColor[0]*count;
 						finalColor[1] += minColor[1]*count;
 						finalColor[2] += minColor[2]*count;
@@ -505,8 +744,8 @@ void StyledFeatureRasterizer::RasterState::getStyleForFeature(const PYXPointer<I
 					}
 					else 
 					{
-						m_palette->convert(it->range.min,minColor,true);
-						m_palette->convert(it->range.max,maxColor,true);
+						convertPaletteValue(it->range.min,minColor);
+						convertPaletteValue(it->range.max,maxColor);
 						finalColor[0] += (minColor[0]+maxColor[0])*count/2;
 						finalColor[1] += (minColor[1]+maxColor[1])*count/2;
 						finalColor[2] += (minColor[2]+maxColor[2])*count/2;
@@ -519,7 +758,7 @@ void StyledFeatureRasterizer::RasterState::getStyleForFeature(const PYXPointer<I
 					fillColor[0] = (unsigned char)(finalColor[0]/totalCount);
 					fillColor[1] = (unsigned char)(finalColor[1]/totalCount);
 					fillColor[2] = (unsigned char)(finalColor[2]/totalCount);
-					fillColor[3] = (unsigned char)(finalColor[3]/totalCount * m_fillColor.getUInt8(3) / 255 );
+					fillColor[3] = (unsigned char)(finalColor[3]/totalCount * fillOpacity / 255 );
 				}
 				else 
 				{
@@ -529,8 +768,8 @@ void StyledFeatureRasterizer::RasterState::getStyleForFeature(const PYXPointer<I
 		}
 		else 
 		{
-			m_palette->convert(feature->getFieldValue(m_paletteFieldIndex),fillColor,true);
-			fillColor[3] = (unsigned char)(fillColor[3] * m_fillColor.getUInt8(3) / 255 );
+			convertPaletteValue(feature->getFieldValue(m_paletteFieldIndex),fillColor);
+			fillColor[3] = (unsigned char)(fillColor[3] * fillOpacity / 255 );
 		}
 	}
 
@@ -590,6 +829,7 @@ StyledFeatureRasterizer::RasterContext::RasterContext(const boost::shared_ptr<Ra
 	:	m_states(state),
 		m_rootIndex(root),
 		m_nResolution(resoluton),
+		m_nCellCount(PYXIcosMath::getCellCount(root,resoluton)),
 		m_getDistanceCount(0),
 		m_getPointContainedCount(0),
 		m_setValueCount(0)
@@ -599,40 +839,81 @@ StyledFeatureRasterizer::RasterContext::RasterContext(const boost::shared_ptr<Ra
 }
 
 
-void StyledFeatureRasterizer::RasterContext::fillCell(int nPos,unsigned char color[4])
+void StyledFeatureRasterizer::RasterContext::allocateColors()
 {
-	//using 16 looks to minimize looking delays
-	boost::recursive_mutex::scoped_lock lock(m_cacheMutex[nPos % 16]);
-
-	ColorState & colorState = m_colorCache[nPos];
-	
-	colorState.colorSetCount ++;
-	colorState.color[0] += color[0]*color[3];
-	colorState.color[1] += color[1]*color[3];
-	colorState.color[2] += color[2]*color[3];
-	colorState.color[3] += color[3];
+	if (!m_colors)
+	{
+		m_colors.reset(new ColorState[m_nCellCount]);
+		m_colorLocks.reset(new boost::mutex[(m_nCellCount + knCellsPerLock - 1) / knCellsPerLock]);
+	}
 }
 
-void StyledFeatureRasterizer::RasterContext::fillCells(int nPos,int nLength,unsigned char color[4])
+void StyledFeatureRasterizer::RasterContext::fillCell(ColorCache & cache,int nPos,unsigned char color[4])
 {
-	int max = std::min(16,nLength);
+	fillCells(cache,nPos,1,color);
+}
 
-	for(int i=0;i<max;++i)
+void StyledFeatureRasterizer::RasterContext::fillCells(ColorCache & cache,int nPos,int nLength,unsigned char color[4])
+{
+	//every thread has its own queue - no locking needed
+	ColorCache::Fill fill;
+	fill.nPos = nPos;
+	fill.nLength = nLength;
+	fill.color[0] = color[0]*color[3];
+	fill.color[1] = color[1]*color[3];
+	fill.color[2] = color[2]*color[3];
+	fill.color[3] = color[3];
+	cache.fills.push_back(fill);
+
+	if ((int)cache.fills.size() >= knMaxQueuedFills)
 	{
-		//using 16 locks to minimize locking delays
-		boost::recursive_mutex::scoped_lock lock(m_cacheMutex[(nPos+i) % 16]);
+		flushColors(cache);
+	}
+}
 
-		for(int pos = nPos+i;pos<nPos+nLength;pos+=16)
+void StyledFeatureRasterizer::RasterContext::flushColors(ColorCache & cache)
+{
+	//sorted fills lock every range of cells once
+	std::sort(cache.fills.begin(),cache.fills.end(),&ColorCache::Fill::isBefore);
+
+	boost::mutex * lockedMutex = 0;
+	for(auto & fill : cache.fills)
+	{
+		int pos = fill.nPos;
+		const int end = fill.nPos + fill.nLength;
+		while (pos < end)
 		{
-			ColorState & colorState = m_colorCache[pos];
+			const int range = pos / knCellsPerLock;
+			boost::mutex * mutex = &m_colorLocks[range];
+			if (mutex != lockedMutex)
+			{
+				if (lockedMutex != 0)
+				{
+					lockedMutex->unlock();
+				}
+				mutex->lock();
+				lockedMutex = mutex;
+			}
+
+			const int rangeEnd = std::min(end,(range+1)*knCellsPerLock);
+			for(;pos<rangeEnd;++pos)
+			{
+				ColorState & colorState = m_colors[pos];
 
-			colorState.colorSetCount ++;
-			colorState.color[0] += color[0]*color[3];
-			colorState.color[1] += color[1]*color[3];
-			colorState.color[2] += color[2]*color[3];
-			colorState.color[3] += color[3];
+				colorState.colorSetCount ++;
+				colorState.color[0] += fill.color[0];
+				colorState.color[1] += fill.color[1];
+				colorState.color[2] += fill.color[2];
+				colorState.color[3] += fill.color[3];
+			}
 		}
 	}
+	if (lockedMutex != 0)
+	{
+		lockedMutex->unlock();
+	}
+
+	cache.fills.clear();
 }
 
 
@@ -654,13 +935,7 @@ void StyledFeatureRasterizer::RasterContext::raster()
 	SnyderProjection::getInstance()->pyxisToXYZ(m_rootIndex,&opmtimizationCenter);
 	double optimizationRadius = PYXIcosMath::UnitSphere::calcTileCircumRadius(m_rootIndex) + m_lineWidth;
 
-	int cellCount = PYXIcosMath::getCellCount(m_rootIndex,m_nResolution);
-	try
-	{
-		m_colorCache.reset(new ColorState[cellCount]);
-	}
-	CATCH_AND_RETHROW("Failed to alloc colorCache");
-	
+	int cellCount = m_nCellCount;
 
 	m_tileVectorGeom = PYXVectorGeometry::create(PYXCircleRegion::create(m_rootIndex,true),m_rootIndex.getResolution()+11);
 	m_tileBoundCircle = PYXCircleRegion(m_rootIndex,true).getBoundingCircle();
@@ -684,9 +959,25 @@ void StyledFeatureRasterizer::RasterContext::raster()
 
 	m_pipelinesContexts.clear();
 
+	//add the fills still queued by the threads
+	try
+	{
+		for(int i=0;i<m_rasterTasks.getLocalStorageCount();i++)
+		{
+			ColorCache & cache = m_rasterTasks.getLocalStorage(i);
+			if (!cache.fills.empty())
+			{
+				flushColors(cache);
+			}
+		}
+	}
+	CATCH_AND_RETHROW("Failed to flush colorCache");
+
+	boost::shared_array<ColorState> colorCache = m_colors;
+
 	try
 	{
-		if (m_resultValueTile)
+		if (m_resultValueTile && colorCache)
 		{
 			PYXValue colorValue = (*m_states)[0]->getFillColor();
 			unsigned char * color = colorValue.getUInt8Ptr(0);
@@ -695,7 +986,7 @@ void StyledFeatureRasterizer::RasterContext::raster()
 			{
 				for(int i=0;i<cellCount;i++)
 				{
-					ColorState & colorState = m_colorCache[i];
+					ColorState & colorState = colorCache[i];
 					if (colorState.colorSetCount>0 && colorState.color[3]>0)
 					{
 						color[0] = (unsigned char)(colorState.color[0]/colorState.color[3]);
@@ -710,7 +1001,7 @@ void StyledFeatureRasterizer::RasterContext::raster()
 			{
 				for(int i=0;i<cellCount;i++)
 				{
-					ColorState & colorState = m_colorCache[i];
+					ColorState & colorState = colorCache[i];
 					if (colorState.colorSetCount>0 && colorState.color[3]>0)
 					{
 						color[0] = (unsigned char)(colorState.color[0]/colorState.color[3]);
@@ -748,6 +1039,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::raster()
 			try
 			{
 				m_context.m_resultValueTile = PYXValueTile::create(m_context.m_rootIndex, m_context.m_nResolution, m_state->getDefinition() );
+				m_context.allocateColors();
 			}
 			CATCH_AND_RETHROW("Failed to allocate result PYXValueTile");
 		}
@@ -764,20 +1056,27 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::raster()
 			try
 			{
 				m_context.m_resultValueTile = PYXValueTile::create(m_context.m_rootIndex, m_context.m_nResolution, m_state->getDefinition() );
+				m_context.allocateColors();
 			}
 			CATCH_AND_RETHROW("Failed to allocate result PYXValueTile");
 		}
 
+		//features are rasterized in batches while the iterator is still running
+		FeatureVector features;
 		for (; !spFit->end(); spFit->next())
 		{
 #ifdef TRACE_STYLED_FEATURE_RASTERIZER
 			featureCount++;
 #endif
 
-			boost::intrusive_ptr<IFeature> spF = spFit->getFeature();
+			features.push_back(spFit->getFeature());
 
-			m_context.m_rasterTasks.addTask(boost::bind(&StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFeature,this,spF));
+			if ((int)features.size() >= knFeatureBatchSize)
+			{
+				addFeatureTasks(features);
+			}
 		}
+		addFeatureTasks(features);
 #ifdef TRACE_STYLED_FEATURE_RASTERIZER
 		boost::posix_time::time_duration td = boost::posix_time::microsec_clock::local_time() - startTime;
 		double totalTime = static_cast<int>(td.total_milliseconds())/1000.0;
@@ -791,7 +1090,27 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::raster()
 	}
 }
 
-void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFeature(PYXPointer<IFeature> spF)
+void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::addFeatureTasks(FeatureVector & features)
+{
+	for(unsigned int i=0;i<features.size();i+=knFeatureBatchSize)
+	{
+		FeatureVector::iterator batchEnd = features.begin() + std::min<size_t>(features.size(),i+knFeatureBatchSize);
+		boost::shared_ptr<FeatureVector> batch(new FeatureVector(features.begin()+i,batchEnd));
+
+		m_context.m_rasterTasks.addTask(boost::bind(&StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFeatures,this,batch,_1));
+	}
+	features.clear();
+}
+
+void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFeatures(const boost::shared_ptr<FeatureVector> & features,ColorCache & cache)
+{
+	for(auto & feature : *features)
+	{
+		rasterizeFeature(feature,cache);
+	}
+}
+
+void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFeature(const PYXPointer<IFeature> & spF,ColorCache & cache)
 {
 	PYXPointer<const PYXGeometry> spGeom = spF->getGeometry();
 	assert(spGeom);
@@ -818,12 +1137,12 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFea
 			{
 				for(int i=0;i<unionRegion->getRegionCount();i++)
 				{
-					rasterizeRegion(unionRegion->getRegion(i),lineColor,fillColor,hasFillColor);
+					rasterizeRegion(unionRegion->getRegion(i),lineColor,fillColor,hasFillColor,cache);
 				}
 			}
 			else
 			{
-				rasterizeRegion(vectorGeometry->getRegion(),lineColor,fillColor,hasFillColor);
+				rasterizeRegion(vectorGeometry->getRegion(),lineColor,fillColor,hasFillColor,cache);
 			}
 		}
 		else
@@ -831,17 +1150,17 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFea
 			const PYXVectorGeometry2 * vectorGeometry2 = dynamic_cast<const PYXVectorGeometry2 *>(spGeom.get());
 			if(vectorGeometry2)
 			{
-				rasterizeVectorGeometry(*vectorGeometry2,lineColor,fillColor,hasFillColor);
+				rasterizeVectorGeometry(*vectorGeometry2,lineColor,fillColor,hasFillColor,cache);
 			}
 			else
 			{
 				if (hasFillColor)
 				{
-					rasterizeGeometry(*spGeom,fillColor);
+					rasterizeGeometry(*spGeom,fillColor,cache);
 				}
 				else
 				{
-					rasterizeGeometry(*spGeom,lineColor);
+					rasterizeGeometry(*spGeom,lineColor,cache);
 				}
 			}
 		}
@@ -861,11 +1180,12 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGro
 	//if we have no more details available - raster that group as we get it.
 	if (!group->moreDetailsAvailable())
 	{
-		m_context.m_rasterTasks.addTask(boost::bind(&StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFeature,this,group));
+		FeatureVector features(1,group);
+		addFeatureTasks(features);
 		return;
 	}
 
-	std::vector<boost::intrusive_ptr<IFeature>> subFeaturesToRasterize;
+	FeatureVector subFeaturesToRasterize;
 	std::vector<boost::intrusive_ptr<IFeatureGroup>> subGroupToRasterize;
 
 	try
@@ -910,6 +1230,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGro
 			}
 			else
 			{
+				//groups only add tasks, the bound function ignores the thread color cache
 				m_context.m_rasterTasks.addTask(boost::bind(&StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGroup,this,subGroup));
 			}		
 		}	
@@ -920,15 +1241,12 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGro
 	{
 		//put all features at the back - this should improve the speed and memory consumption as the thead pool do tasks in lifo order.
 		//so, we would like to get read of all the features ASAP.
-		for(auto & feature : subFeaturesToRasterize)
-		{
-			m_context.m_rasterTasks.addTask(boost::bind(&StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeFeature,this,feature));
-		}
+		addFeatureTasks(subFeaturesToRasterize);
 	}
 	CATCH_AND_RETHROW("Failed to start features raster tasks for group " << group->getID());	
 }
 
-void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeRegion(const PYXPointer<PYXVectorRegion> & region,unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor)
+void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeRegion(const PYXPointer<PYXVectorRegion> & region,unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor,ColorCache & cache)
 {
 	PYXBoundingCircle regionCircle = region->getBoundingCircle();
 	if (regionCircle.getRadius() < PYXIcosMath::UnitSphere::calcCellCircumRadius(m_context.m_nResolution))
@@ -941,7 +1259,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeReg
 		if (index.isDescendantOf(m_context.m_rootIndex))
 		{
 			int nPos = PYXIcosMath::calcCellPosition(m_context.m_rootIndex, index);
-			m_context.fillCell(nPos,lineColor);
+			m_context.fillCell(cache,nPos,lineColor);
 		}
 		return;
 	}
@@ -971,13 +1289,13 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeReg
 		{
 			if (isBorder)
 			{
-				m_context.fillCell(nPos,lineColor);
+				m_context.fillCell(cache,nPos,lineColor);
 			}
 			else if (useFillColor)
 			{
 				if (region->isPointContained(location,m_context.m_errorThreshold))
 				{
-					m_context.fillCell(nPos,fillColor);
+					m_context.fillCell(cache,nPos,fillColor);
 				}
 			}
 		}
@@ -995,7 +1313,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeReg
 			{
 				if (region->isPointContained(location,m_context.m_errorThreshold))
 				{
-					m_context.fillCells(nPos,tileCellCount,fillColor);
+					m_context.fillCells(cache,nPos,tileCellCount,fillColor);
 				}
 			}
 
@@ -1004,7 +1322,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeReg
 	}
 }
 
-void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGeometry(const PYXGeometry & geom,unsigned char color[4])
+void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGeometry(const PYXGeometry & geom,unsigned char color[4],ColorCache & cache)
 {
 	// Intersect geometry with tile
 	PYXTile tile(m_context.m_rootIndex, m_context.m_nResolution);
@@ -1033,7 +1351,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGeo
 	{
 		if (!intersectionGeom->isEmpty())
 		{
-			m_context.fillCell(0,color);
+			m_context.fillCell(cache,0,color);
 		}
 	}
 	else
@@ -1045,12 +1363,12 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeGeo
 
 			int nPos = PYXIcosMath::calcCellPosition(m_context.m_rootIndex, index2);
 
-			m_context.fillCell(nPos,color);
+			m_context.fillCell(cache,nPos,color);
 		}
 	}
 }
 
-void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeVectorGeometry(const PYXVectorGeometry2 & geom, unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor)
+void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeVectorGeometry(const PYXVectorGeometry2 & geom, unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor,ColorCache & cache)
 {
 	int resolution = m_context.m_nResolution;
 	std::vector<PYXInnerTile> innerTiles = PYXInnerTile::createInnerTiles(PYXTile(m_context.m_rootIndex, m_context.m_nResolution));
@@ -1077,7 +1395,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeVec
 					int nPos = PYXIcosMath::calcCellPosition(m_context.m_rootIndex, index);
 					if(nPos < cellCount)
 					{
-						m_context.fillCell(nPos, color);
+						m_context.fillCell(cache,nPos, color);
 					}
 					else
 					{
@@ -1091,7 +1409,7 @@ void StyledFeatureRasterizer::RasterContext::SinglePipelineContext::rasterizeVec
 					index.setResolution(resolution);
 					int nPos = PYXIcosMath::calcCellPosition(m_context.m_rootIndex, index);
 				
-					m_context.fillCells(nPos,tileCellCount,color);
+					m_context.fillCells(cache,nPos,tileCellCount,color);
 				}
 			}
 		}
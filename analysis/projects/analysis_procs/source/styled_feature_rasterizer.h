@@ -20,6 +20,11 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/color_palette.h"
 #include "pyxis/utility/thread_pool.h"
 
+#include <boost/shared_array.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
+
 /*!
 This process converts a feature collection input into a rasterized coverage.
 Each cell in the coverage will contain an RGBA color with opacity based on the input FeatureCollection style and Feautre style.
@@ -84,6 +89,9 @@ public: // ICoverage
 public:
 	static void test();
 
+	//! Rasterize 2000 polygons into a tile and time the palette evaluation (not run by the tests).
+	static void benchmark();
+
 private:
 	virtual void createGeometry() const;
 
@@ -110,9 +118,20 @@ private:
 		int m_paletteFieldIndex;
 		PYXPointer<PYXValueColorPalette> m_palette;
 
+	private:
+		//the style compiled once per pipeline: the colors as bytes and a lookup table for numeric palettes
+		bool m_hasAlpha;
+		unsigned char m_compiledLineColor[4];
+		unsigned char m_compiledFillColor[4];
+		std::vector<unsigned char> m_paletteLookup;
+		double m_paletteLookupMin;
+		double m_paletteLookupScale;
+
 	private:
 		void loadStyleParameters();
 
+		void compileStyle();
+
 	public:
 		RasterState(const boost::intrusive_ptr<IFeatureCollection> & spFC,
 					const ProcRef & procRef,
@@ -143,12 +162,15 @@ private:
 		void addAlphaChannel(PYXValue & value,int alphaValue);
 
 	public:
+		//! Number of entries in the lookup table of a numeric palette.
+		static const int knPaletteLookupSize = 4096;
+
 		boost::intrusive_ptr<IFeatureCollection> getFeatureCollection() { return m_spFC; }
 
 		PYXPointer<const PYXTableDefinition> getDefinition() { return m_definition; }
 
 		//check if the definition contains alpha channel as well.
-		bool hasAlphaChannel();
+		bool hasAlphaChannel() const { return m_hasAlpha; }
 
 		const PYXValue & getFillColor() const { return m_fillColor; }
 
@@ -162,6 +184,9 @@ private:
 
 		bool doesStyleRequireToDrilIntoGroup(const PYXPointer<IFeatureGroup> & group) const;
 		void getStyleForFeature(const PYXPointer<IFeature> & feature,const PYXPointer<const PYXGeometry> & geom,int resolution,unsigned char lineColor[4],unsigned char fillColor[4],bool & hasFillColor);
+
+		//convert a value of the palette field into a color, using the lookup table for numeric palettes
+		void convertPaletteValue(const PYXValue & value,unsigned char rgba[4]) const;
 	};
 
 	typedef std::vector<PYXPointer<RasterState>> RasterStateVector;
@@ -169,6 +194,50 @@ private:
 	class RasterContext
 	{
 	private:
+		struct ColorState
+		{
+			int colorSetCount;
+			int color [4];
+
+			ColorState() : colorSetCount(0)
+			{
+				color[0]=color[1]=color[2]=color[3]=0;
+			}
+		};
+
+		//cells rasterized by the raster tasks running on a single thread, waiting to be added to the shared colors
+		struct ColorCache
+		{
+			struct Fill
+			{
+				int nPos;
+				int nLength;
+
+				//premultiplied red, green and blue, and alpha
+				int color[4];
+
+				static bool isBefore(const Fill & a,const Fill & b)
+				{
+					return a.nPos < b.nPos;
+				}
+			};
+
+			std::vector<Fill> fills;
+		};
+
+		typedef PYXTaskGroupWithLocalStorage<ColorCache> RasterTaskGroup;
+
+		typedef std::vector<boost::intrusive_ptr<IFeature>> FeatureVector;
+
+		//! Number of features rasterized by a single task.
+		static const int knFeatureBatchSize = 32;
+
+		//! Number of consecutive cells of the shared colors guarded by the same lock.
+		static const int knCellsPerLock = 1024;
+
+		//! Number of fills a thread queues before adding them to the shared colors.
+		static const int knMaxQueuedFills = 256;
+
 		class SinglePipelineContext
 		{
 		private:
@@ -182,15 +251,19 @@ private:
 			void raster();
 
 		private:
-			void rasterizeFeature(PYXPointer<IFeature> spF);
+			void addFeatureTasks(FeatureVector & features);
+
+			void rasterizeFeatures(const boost::shared_ptr<FeatureVector> & features,ColorCache & cache);
+
+			void rasterizeFeature(const PYXPointer<IFeature> & spF,ColorCache & cache);
 
 			void rasterizeGroup(PYXPointer<IFeatureGroup> group);
 
-			void rasterizeRegion(const PYXPointer<PYXVectorRegion> & region,unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor);
+			void rasterizeRegion(const PYXPointer<PYXVectorRegion> & region,unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor,ColorCache & cache);
 
-			void rasterizeGeometry(const PYXGeometry & geom,unsigned char color[4]);
+			void rasterizeGeometry(const PYXGeometry & geom,unsigned char color[4],ColorCache & cache);
 
-			void rasterizeVectorGeometry(const PYXVectorGeometry2 & geom,unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor);
+			void rasterizeVectorGeometry(const PYXVectorGeometry2 & geom,unsigned char lineColor[4],unsigned char fillColor[4],bool useFillColor,ColorCache & cache);
 		};
 
 	private:
@@ -198,24 +271,18 @@ private:
 
 		PYXIcosIndex m_rootIndex;
 		int m_nResolution;
-
-		struct ColorState
-		{
-			int colorSetCount;
-			int color [4];
-
-			ColorState() : colorSetCount(0)
-			{
-				color[0]=color[1]=color[2]=color[3]=0;
-			}
-		};
-		boost::recursive_mutex m_cacheMutex[16];
-		boost::scoped_array<ColorState> m_colorCache;
+		int m_nCellCount;
 
 		PYXPointer<PYXVectorGeometry> m_tileVectorGeom;
 		PYXBoundingCircle m_tileBoundCircle;
 
-		PYXTaskGroup m_rasterTasks;
+		RasterTaskGroup m_rasterTasks;
+
+		//! The colors accumulated by all the raster tasks, allocated with the result tile.
+		boost::shared_array<ColorState> m_colors;
+
+		//! A lock for every knCellsPerLock cells of m_colors.
+		boost::shared_array<boost::mutex> m_colorLocks;
 
 		double   m_lineWidth;
 
@@ -238,8 +305,16 @@ private:
 	public:
 		void raster();
 
-		void fillCell(int nPos,unsigned char color[4]);
-		void fillCells(int nPos,int nLength,unsigned char color[4]);
+		void fillCell(ColorCache & cache,int nPos,unsigned char color[4]);
+		void fillCells(ColorCache & cache,int nPos,int nLength,unsigned char color[4]);
+
+		//add the queued fills of a thread to the shared colors
+		void flushColors(ColorCache & cache);
+
+	private:
+		void allocateColors();
+
+	public:
 
 		PYXPointer<PYXValueTile> getResultValueTile();
 		
@@ -11,6 +11,10 @@ web			: www.pyxisinnovation.com
 #include "attribute_query.h"
 
 #include "feature_collection_process.h"
+#include "pyxis/data/feature_collection_filter.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/trace.h"
 #include "pyxis/utility/xml_transform.h"
 
 // Required by tests
@@ -34,6 +38,39 @@ namespace
 //! Tester class
 Tester<AttributeQuery> gTester;
 
+//! Features with an "Id" and a "Type" that is "city" for one feature of 100.
+boost::intrusive_ptr<DefaultFeatureCollection> createCityCollection(int nFeatures)
+{
+	boost::intrusive_ptr<DefaultFeatureCollection> spFC(new DefaultFeatureCollection);
+	for (int i = 0; i < nFeatures; ++i)
+	{
+		boost::intrusive_ptr<DefaultFeature> spFeature(new DefaultFeature);
+		spFeature->addField("Id", PYXFieldDefinition::knContextNone, PYXValue::knInt32, 1, PYXValue(i));
+		spFeature->addField("Type", PYXFieldDefinition::knContextNone, PYXValue::knString, 1, PYXValue(i % 100 == 0 ? "city" : "town"));
+		spFC->addFeature(spFeature);
+	}
+	return spFC;
+}
+
+//! Query the cities with an Id below nMaxId, with a query the XPath engine is not needed for.
+boost::intrusive_ptr<IFeatureCollection> queryCities(const boost::intrusive_ptr<DefaultFeatureCollection> & spFC,int nMaxId)
+{
+	boost::intrusive_ptr<IProcess> spQueryProcess;
+	PYXCOMCreateInstance(AttributeQuery::clsid, 0, IProcess::iid, (void**)&spQueryProcess);
+
+	std::map<std::string, std::string> mapAttr;
+	mapAttr["query"] = "//field[name='Type' and value='city'] and //field[name='Id' and value<" + StringUtils::toString(nMaxId) + "]";
+	mapAttr["geometry"] = "use_input_geometry";
+	spQueryProcess->setAttributes(mapAttr);
+
+	boost::intrusive_ptr<IProcess> spDataProcess;
+	spFC->QueryInterface(IProcess::iid, (void**)&spDataProcess);
+	spQueryProcess->getParameter(0)->addValue(spDataProcess);
+	spQueryProcess->initProc();
+
+	return spQueryProcess->getOutput()->QueryInterface<IFeatureCollection>();
+}
+
 }
 
 //! Complex Queries will run with the .NET XPath query engine.
@@ -59,63 +96,25 @@ public:
 	};
 };
 
-//! Simple queries "field=value" will run with a fast and simple implementation
-class SimpleQuery : public AttributeQuery::FeatureQuery
+//! Queries supported by PYXAttributePredicate are evaluated without the XPath engine.
+class PredicateQuery : public AttributeQuery::FeatureQuery
 {
 private:
-	std::string m_strFieldName;
-	std::string m_strFieldValue;
+	PYXPointer<PYXAttributePredicate> m_spPredicate;
+
 public:
-	static PYXPointer<AttributeQuery::FeatureQuery> create(const std::string& strQuery)
+	static PYXPointer<AttributeQuery::FeatureQuery> create(const PYXPointer<PYXAttributePredicate> & spPredicate)
 	{
-		//try to parse the followling string: "//field[name='field' and value='value']"
-		if (strQuery.substr(0,14) != "//field[name='")
-		{
-			return PYXPointer<SimpleQuery>();
-		}
-
-		//find second "'"
-		size_t pos = strQuery.find("'",14);
-
-		if (pos == std::string::npos)
-		{
-			return PYXPointer<SimpleQuery>();
-		}
-		
-		std::string fieldName = strQuery.substr(14,pos-14);
-
-		if (strQuery.substr(pos,13) != "' and value='")
-		{
-			return PYXPointer<SimpleQuery>();
-		}
-
-		pos += 13;
-
-		size_t endPos = strQuery.find("'",pos);
-
-		if (endPos == std::string::npos)
-		{
-			return PYXPointer<SimpleQuery>();
-		}
-
-		std::string fieldValue = strQuery.substr(pos,endPos-pos);
-
-		if (strQuery.substr(endPos) != "']")
-		{
-			return PYXPointer<SimpleQuery>();
-		}
-
-		//everything was parsed ok.
-		return PYXNEW(SimpleQuery,fieldName,fieldValue);
+		return PYXNEW(PredicateQuery,spPredicate);
 	};
 
-	SimpleQuery(const std::string & field,const std::string & value) : m_strFieldName(field), m_strFieldValue(value)
+	PredicateQuery(const PYXPointer<PYXAttributePredicate> & spPredicate) : m_spPredicate(spPredicate)
 	{
 	};
 
 	virtual bool match(const boost::intrusive_ptr<IFeature> & spFeature) const
 	{
-		return spFeature->getFieldValueByName(m_strFieldName).getString() == m_strFieldValue;
+		return m_spPredicate->match(*spFeature);
 	};
 };
 
@@ -209,6 +208,49 @@ void AttributeQuery::test()
 		//spIt->next();
 		//TEST_ASSERT(spIt->end());
 	}
+
+	// Selective queries run without the XPath engine.
+	{
+		boost::intrusive_ptr<IFeatureCollection> spOutput = queryCities(createCityCollection(5000), 2500);
+
+		int nMatches = 0;
+		for (PYXPointer<FeatureIterator> spIt = spOutput->getIterator(); !spIt->end(); spIt->next())
+		{
+			TEST_ASSERT(spIt->getFeature()->getFieldValue(1).getString() == "city");
+			TEST_ASSERT(spIt->getFeature()->getFieldValue(0).getInt() < 2500);
+			++nMatches;
+		}
+		TEST_ASSERT_EQUAL(nMatches, 25);
+	}
+}
+
+void AttributeQuery::benchmark()
+{
+	const int nFeatures = 50000;
+	boost::intrusive_ptr<DefaultFeatureCollection> spLargeFC = createCityCollection(nFeatures);
+	boost::intrusive_ptr<IFeatureCollection> spOutput = queryCities(spLargeFC, 25000);
+
+	PYXHighQualityTimer timer;
+	timer.start();
+	int nMatches = 0;
+	for (PYXPointer<FeatureIterator> spIt = spOutput->getIterator(); !spIt->end(); spIt->next())
+	{
+		++nMatches;
+	}
+	timer.stop();
+	double fQueryTime = timer.getTime();
+
+	// the XPath engine needs every feature as XML
+	timer.start();
+	size_t nXmlSize = 0;
+	for (PYXPointer<FeatureIterator> spIt = spLargeFC->getIterator(); !spIt->end(); spIt->next())
+	{
+		nXmlSize += RecordTools::getFieldsAsXml(*spIt->getFeature()).size();
+	}
+	timer.stop();
+
+	TRACE_INFO("AttributeQuery: " << nFeatures << " features filtered in " << fQueryTime << "[sec] (" << nMatches << " matches), " <<
+		"formatting them as XML for the XPath engine takes " << timer.getTime() << "[sec]");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -309,11 +351,11 @@ std::map<std::string, std::string> AttributeQuery::getAttributes() const
 
 PYXPointer<AttributeQuery::FeatureQuery> AttributeQuery::createQuery(const std::string& strQuery)
 {
-	PYXPointer<FeatureQuery> query = SimpleQuery::create(strQuery);
+	m_spPredicate = PYXAttributePredicate::parse(strQuery);
 
-	if (query)
+	if (m_spPredicate)
 	{
-		return query;
+		return PredicateQuery::create(m_spPredicate);
 	}
 	else
 	{
@@ -321,6 +363,30 @@ PYXPointer<AttributeQuery::FeatureQuery> AttributeQuery::createQuery(const std::
 	}
 }
 
+PYXPointer<FeatureIterator> AttributeQuery::createIterator(const PYXGeometry* pGeometry) const
+{
+	if (!m_spPredicate)
+	{
+		return FilteredFeatureIterator::create(
+			pGeometry ? m_spFeaturesInput->getIterator(*pGeometry) : m_spFeaturesInput->getIterator(), m_query);
+	}
+
+	// let the input evaluate the predicate if it can, the features it returns still have to be checked
+	boost::intrusive_ptr<IFeatureCollectionFilter> spFilter = m_spFeaturesInput->QueryInterface<IFeatureCollectionFilter>();
+	if (spFilter)
+	{
+		PYXPointer<FeatureIterator> spIterator =
+			pGeometry ? spFilter->getIterator(*pGeometry, *m_spPredicate) : spFilter->getIterator(*m_spPredicate);
+		if (spIterator)
+		{
+			return FilteredFeatureIterator::create(spIterator, m_query);
+		}
+	}
+
+	return BatchFilteredFeatureIterator::create(
+		pGeometry ? m_spFeaturesInput->getIterator(*pGeometry) : m_spFeaturesInput->getIterator(), m_spPredicate);
+}
+
 
 /*!
 Set the attributes for this process.
@@ -362,7 +428,7 @@ PYXPointer<FeatureIterator> AttributeQuery::getIterator() const
 	}
 	else
 	{
-		return FilteredFeatureIterator::create(m_spFeaturesInput->getIterator(), m_query);
+		return createIterator(0);
 	}
 }
 
@@ -377,7 +443,7 @@ PYXPointer<FeatureIterator> AttributeQuery::getIterator(const PYXGeometry& geome
 	}
 	else
 	{
-		return FilteredFeatureIterator::create(m_spFeaturesInput->getIterator(geometry), m_query);
+		return createIterator(&geometry);
 	}
 }
 
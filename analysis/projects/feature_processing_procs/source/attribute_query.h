@@ -14,6 +14,7 @@ web			: www.pyxisinnovation.com
 
 // pyxlib includes
 #include "pyxis/pipe/process.h"
+#include "pyxis/data/attribute_predicate.h"
 #include "pyxis/data/feature_collection.h"
 
 // boost includes
@@ -22,6 +23,11 @@ web			: www.pyxisinnovation.com
 /*!
 Inputs: feature data set
 Output: feature data set containing only the features that satisfy the query
+
+The queries that PYXAttributePredicate understands are pushed down to the input
+if it implements IFeatureCollectionFilter, and are otherwise evaluated over
+batches of features with BatchFilteredFeatureIterator. Other queries are
+evaluated feature by feature with the XPath engine.
 */
 //! Filters out features that do not satisfy the query.
 class MODULE_FEATURE_PROCESSING_PROCS_DECL AttributeQuery : public ProcessImpl<AttributeQuery>, public IFeatureCollection
@@ -215,6 +221,120 @@ public:
 		const std::string m_strQuery;
 	};
 
+	/*!
+	A Feature iterator that reads the features of another iterator in batches and
+	evaluates an attribute predicate over the field columns of every batch,
+	skipping over the features that don't match it.
+	*/
+	class BatchFilteredFeatureIterator : public FeatureIterator
+	{
+	public:
+
+		//! The number of features read at once.
+		static const int knBatchSize = 256;
+
+		//! Dynamic Creator.
+		static PYXPointer<BatchFilteredFeatureIterator> create(
+			const PYXPointer<FeatureIterator> spIterator,
+			const PYXPointer<PYXAttributePredicate> spPredicate )
+		{
+			return PYXNEW(BatchFilteredFeatureIterator, spIterator, spPredicate);
+		}
+
+		//! Default Constructor.
+		BatchFilteredFeatureIterator(
+			const PYXPointer<FeatureIterator> spIterator,
+			const PYXPointer<PYXAttributePredicate> spPredicate ) :
+			m_spIterator(spIterator),
+			m_spPredicate(spPredicate),
+			m_batch(*spPredicate),
+			m_nCurrent(0)
+		{
+			readBatch();
+		}
+
+		//! Destructor
+		virtual ~BatchFilteredFeatureIterator()
+		{
+		}
+
+		//! Determine if we are done iterating over the features.
+		virtual bool end() const
+		{
+			return m_nCurrent >= m_matches.size();
+		}
+
+		//! Get the current feature the iterator is on.
+		virtual boost::intrusive_ptr<IFeature> getFeature() const
+		{
+			return m_matches[m_nCurrent];
+		}
+
+		//! Move to the next feature.
+		virtual void next()
+		{
+			if (!end())
+			{
+				++m_nCurrent;
+				if (end())
+				{
+					readBatch();
+				}
+			}
+		}
+
+	private:
+
+		//! Read batches until one of them has a matching feature or the input ends.
+		void readBatch()
+		{
+			m_matches.clear();
+			m_nCurrent = 0;
+
+			while (m_matches.empty() && !m_spIterator->end())
+			{
+				m_features.clear();
+				m_batch.clear();
+				for (; !m_spIterator->end() && static_cast<int>(m_features.size()) < knBatchSize; m_spIterator->next())
+				{
+					m_features.push_back(m_spIterator->getFeature());
+					m_batch.addRecord(*m_features.back());
+				}
+
+				m_spPredicate->match(m_batch,m_selection);
+				for (unsigned int i = 0; i < m_features.size(); ++i)
+				{
+					if (m_selection[i])
+					{
+						m_matches.push_back(m_features[i]);
+					}
+				}
+			}
+		}
+
+	private:
+
+		//! The feature iterator.
+		const PYXPointer<FeatureIterator> m_spIterator;
+
+		//! The predicate.
+		const PYXPointer<PYXAttributePredicate> m_spPredicate;
+
+		//! The field values of the current batch.
+		PYXAttributePredicate::ColumnBatch m_batch;
+
+		//! The features of the current batch.
+		std::vector<boost::intrusive_ptr<IFeature> > m_features;
+
+		//! The matching features of the current batch.
+		std::vector<boost::intrusive_ptr<IFeature> > m_matches;
+
+		std::vector<char> m_selection;
+
+		//! The current matching feature.
+		unsigned int m_nCurrent;
+	};
+
 	//! Default Constructor
 	AttributeQuery();
 
@@ -224,11 +344,17 @@ public:
 	//! Test
 	static void test();
 
+	//! Time a selective query over 50000 features against formatting them as XML (not run by the tests).
+	static void benchmark();
+
 private:
 
 	//! create a query object from the query string
 	PYXPointer<FeatureQuery> createQuery(const std::string& strQuery);
 
+	//! create an iterator over the features of the input that satisfy the query
+	PYXPointer<FeatureIterator> createIterator(const PYXGeometry* pGeometry) const;
+
 private:
 
 	//! The query.
@@ -238,6 +364,9 @@ private:
 	boost::intrusive_ptr<IFeatureCollection> m_spFeaturesInput;
 
 	PYXPointer<FeatureQuery> m_query;
+
+	//! The query as a predicate, null if the query is only supported by the XPath engine.
+	PYXPointer<PYXAttributePredicate> m_spPredicate;
 };
 
 #endif
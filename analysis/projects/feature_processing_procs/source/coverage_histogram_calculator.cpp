@@ -17,10 +17,16 @@ web			: www.pyxisinnovation.com
 #include "pyxis/derm/iterator.h"
 #include "pyxis/utility/string_utils.h"
 #include "pyxis/data/constant_record.h"
+#include "pyxis/utility/thread_pool.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/geometry/tile_collection.h"
+#include "pyxis/procs/const_coverage.h"
+#include "pyxis/procs/default_feature.h"
 
 // standard includes
 #include <algorithm>
 #include <cassert>
+#include <map>
 #include "pyxis/derm/snyder_projection.h"
 
 // {5636F858-F2CA-44c9-8E15-F00936FDDE75}
@@ -34,7 +40,7 @@ IPROCESS_SPEC_BEGIN(CoverageHistogramCalculator, "Create Coverage Histogram", "C
 	IPROCESS_SPEC_PARAMETER(ICoverage::iid, 1, 1, "Input Coverage", "The coverage that will be used for histogram calculations")
 IPROCESS_SPEC_END
 
-CoverageHistogramCalculator::CoverageHistogramCalculator()
+CoverageHistogramCalculator::CoverageHistogramCalculator() : m_cellResolution(-1)
 {
 }
 
@@ -42,6 +48,120 @@ CoverageHistogramCalculator::~CoverageHistogramCalculator()
 {
 }
 
+//! Tester class
+Tester<CoverageHistogramCalculator> gTester;
+
+//! Test method
+void CoverageHistogramCalculator::test()
+{
+	//aggregate collects the not null values of the needed cells of a tile
+	{
+		const int nResolution = 8;
+		PYXTile tile(PYXIcosIndex("A-0"),nResolution);
+
+		PYXPointer<PYXTableDefinition> spDefn = PYXTableDefinition::create();
+		spDefn->addFieldDefinition("value",PYXFieldDefinition::knContextNone,PYXValue::knDouble,1);
+		PYXPointer<PYXValueTile> spValueTile = PYXValueTile::create(tile.getRootIndex(),nResolution,spDefn);
+
+		const int cellCount = spValueTile->getNumberOfCells();
+		for(int offset = 0; offset < cellCount; ++offset)
+		{
+			if (offset % 5 != 0)
+			{
+				spValueTile->setValue(offset,0,PYXValue((double)offset));
+			}
+		}
+
+		//a coarse tile (a run of cells) and a single cell
+		PYXIcosIndex coarseIndex("A-02");
+		PYXIcosIndex singleIndex("A-0300001");
+		PYXPointer<PYXTileCollection> spGeometry = PYXTileCollection::create();
+		spGeometry->addTile(coarseIndex,nResolution);
+		spGeometry->addTile(singleIndex,nResolution);
+
+		std::vector<double> tileValues(cellCount);
+		std::vector<unsigned char> tileHasValues(cellCount);
+		spValueTile->getChannelValues(0,&tileValues[0],&tileHasValues[0]);
+
+		std::vector<double> values;
+		std::vector<PYXInnerTile> innerTiles = PYXInnerTile::createInnerTiles(tile);
+		for(auto & innerTile : innerTiles)
+		{
+			PYXPointer<PYXInnerTileIntersectionIterator> geomIt = spGeometry->getInnerTileIterator(innerTile);
+			if (geomIt)
+			{
+				aggregate(tile,&tileValues[0],&tileHasValues[0],1,geomIt,values);
+			}
+		}
+
+		std::vector<double> expected;
+		for(int offset = 0; offset < cellCount; ++offset)
+		{
+			PYXIcosIndex index = PYXIcosMath::calcIndexFromOffset(tile.getRootIndex(),nResolution,offset);
+			if ((coarseIndex.isAncestorOf(index) || index == singleIndex) && offset % 5 != 0)
+			{
+				expected.push_back((double)offset);
+			}
+		}
+
+		std::sort(values.begin(),values.end());
+		TEST_ASSERT(!expected.empty());
+		TEST_ASSERT(values == expected);
+	}
+
+	//the histograms of many features match the histograms of a single feature
+	{
+		boost::intrusive_ptr<ConstCoverage> spCoverage(new ConstCoverage);
+		spCoverage->setReturnValue(PYXValue(3.0),PYXFieldDefinition::knContextNone);
+
+		boost::intrusive_ptr<IProcess> spCoverageProcess;
+		spCoverage->QueryInterface(IProcess::iid,(void**)&spCoverageProcess);
+
+		boost::intrusive_ptr<IProcess> spProcess;
+		PYXCOMCreateInstance(CoverageHistogramCalculator::clsid,0,IProcess::iid,(void**)&spProcess);
+		spProcess->getParameter(0)->addValue(spCoverageProcess);
+
+		const int nResolution = 12;
+		std::map<std::string,std::string> mapAttr;
+		mapAttr["CellResolution"] = StringUtils::toString(nResolution);
+		spProcess->setAttributes(mapAttr);
+		TEST_ASSERT(spProcess->initProc() == IProcess::knInitialized);
+
+		boost::intrusive_ptr<ICoverageHistogramCalculator> spCalculator = spProcess->getOutput()->QueryInterface<ICoverageHistogramCalculator>();
+		TEST_ASSERT(spCalculator);
+
+		PYXIcosIndex indices[2] = { PYXIcosIndex("1-02"), PYXIcosIndex("3-0200") };
+
+		std::vector<PYXPointer<IFeature>> features;
+		for(auto & index : indices)
+		{
+			PYXPointer<PYXTileCollection> spGeometry = PYXTileCollection::create();
+			spGeometry->addTile(index,nResolution);
+			features.push_back(boost::intrusive_ptr<IFeature>(new DefaultFeature(spGeometry)));
+		}
+
+		std::vector<PYXPointer<PYXCellHistogram>> histograms = spCalculator->getHistograms(0,features);
+		TEST_ASSERT(histograms.size() == features.size());
+
+		for(unsigned int i = 0; i < features.size(); ++i)
+		{
+			const int expectedCount = PYXIcosMath::getCellCount(indices[i],nResolution);
+
+			TEST_ASSERT(histograms[i]->getCellResolution() == nResolution);
+			TEST_ASSERT(histograms[i]->getFeatureCount() == Range<int>(expectedCount));
+			TEST_ASSERT(histograms[i]->getBoundaries().min.getDouble() == 3.0);
+			TEST_ASSERT(histograms[i]->getBoundaries().max.getDouble() == 3.0);
+
+			//every call returns the histogram of its own feature, nothing is accumulated
+			for(int repeat = 0; repeat < 2; ++repeat)
+			{
+				PYXPointer<PYXCellHistogram> histogram = spCalculator->getHistogram(0,features[i]);
+				TEST_ASSERT(histogram->getFeatureCount() == Range<int>(expectedCount));
+			}
+		}
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // IProcess
 ////////////////////////////////////////////////////////////////////////////////
@@ -94,7 +214,6 @@ IProcess::eInitStatus CoverageHistogramCalculator::initImpl()
 		m_spInitError->setError("Input is not ICoverage");
 		return knFailedToInit;
 	}
-	m_cellResolution = -1;
 	return knInitialized;
 }
 
@@ -170,63 +289,166 @@ int CoverageHistogramCalculator::findResolution(const PYXPointer<PYXGeometry> &
 
 PYXPointer<PYXCellHistogram> STDMETHODCALLTYPE CoverageHistogramCalculator::getHistogram( int fieldIndex,PYXPointer<IFeature> spFeature )
 {
+	std::vector<PYXPointer<IFeature>> features(1,spFeature);
+
+	return getHistograms(fieldIndex,features).front();
+}
+
+std::vector<PYXPointer<PYXCellHistogram>> CoverageHistogramCalculator::getHistograms( int fieldIndex,const std::vector<PYXPointer<IFeature>> & features )
+{
+	const int zoneCount = (int)features.size();
+
+	std::vector<PYXPointer<PYXGeometry>> geometries;
+	geometries.reserve(zoneCount);
+	for(auto & feature : features)
+	{
+		geometries.push_back(feature->getGeometry());
+	}
 
-	PYXPointer<PYXGeometry> geometry = spFeature->getGeometry();
+	//the resolution is picked for every call, the process is shared by concurrent callers
+	const int cellResolution = m_cellResolution < 0 ? selectResolution(geometries) : m_cellResolution;
 
-	if(m_cellResolution < 0)
+	//found containing cells of all features on a single low resolution, so every tile is fetched once
+	std::map<PYXIcosIndex,ZoneTile> zoneTiles;
+	for(int zone = 0; zone < zoneCount; ++zone)
 	{
-		//find a good resolution to perform aggregation on...
-		m_cellResolution = m_spCoverage->getGeometry()->getCellResolution();
-		//make it a resolution that would be around 1~6 depth-11 tiles.
-		PYXBoundingCircle circle = geometry->getBoundingCircle();
-		if (circle.getRadius() != 0)
+		if (!geometries[zone])
 		{
-			m_cellResolution = std::min(PYXMath::knMaxAbsResolution,PYXBoundingCircle::estimateResolutionFromRadius(circle.getRadius())+11);
-			m_cellResolution = findResolution(geometry,std::max(2,m_cellResolution-11),0.05)+11;
+			continue;
 		}
 
-		m_histogram = PYXNumericCellHistogram::create(m_numericHistogram,m_cellResolution);
-	}
+		PYXPointer<PYXTileCollection> coverGeometry = PYXTileCollection::create();
+		geometries[zone]->copyTo(coverGeometry.get(),std::max(2,cellResolution-11));
 
-	//found containing cells on a single low resolution
-	PYXPointer<PYXTileCollection> coverGeometry = PYXTileCollection::create();
-	geometry->copyTo(coverGeometry.get(),std::max(2,m_cellResolution-11));
+		for(PYXPointer<PYXIterator> iterator = coverGeometry->getIterator();!iterator->end();iterator->next())
+		{
+			ZoneTile & zoneTile = zoneTiles[iterator->getIndex()];
+			zoneTile.index = iterator->getIndex();
+			zoneTile.zones.push_back(zone);
+		}
+	}
 
 	//NOTE: this could lead to 20% error if polygon has many partial cells
-	for(PYXPointer<PYXIterator> iterator = coverGeometry->getIterator();!iterator->end();iterator->next())
+	//tiles are fetched and aggregated on the thread pool, every thread collects its own partial histograms
+	PYXTaskGroupWithLocalStorage<PartialHistograms> tasks;
+	tasks.initLocalStorage(boost::bind(&PartialHistograms::init,_1,zoneCount));
+
+	for(auto & zoneTile : zoneTiles)
 	{
-		PYXTile tile(iterator->getIndex(),m_cellResolution);
+		tasks.addTask(boost::bind(&CoverageHistogramCalculator::aggregateTile,this,fieldIndex,cellResolution,&zoneTile.second,&geometries,_1));
+	}
+	tasks.joinAll();
 
-		std::vector<PYXInnerTile> innerTiles = PYXInnerTile::createInnerTiles(tile);
+	//merge the partial histograms of all threads
+	std::vector<PYXPointer<PYXCellHistogram>> result;
+	result.reserve(zoneCount);
 
-		PYXPointer<PYXValueTile> valueTile = m_spCoverage->getFieldTile(tile.getRootIndex(),tile.getCellResolution(),fieldIndex);
+	for(int zone = 0; zone < zoneCount; ++zone)
+	{
+		NumericHistogram<double> histogram;
 
-		for(std::vector<PYXInnerTile>::iterator it = innerTiles.begin(); it != innerTiles.end(); ++it)
+		for(int i = 0; i < tasks.getLocalStorageCount(); ++i)
 		{
-			PYXPointer<PYXInnerTileIntersectionIterator> geomIt = geometry->getInnerTileIterator(*it);
-			if(valueTile && geomIt)
+			PartialHistograms & partial = tasks.getLocalStorage(i);
+			partial.flush(zone);
+
+			if (partial.histograms[zone])
 			{
-				aggregate(valueTile,geomIt);
+				histogram.add(*partial.histograms[zone]);
 			}
 		}
+
+		result.push_back(PYXNumericCellHistogram::create(histogram,cellResolution));
 	}
 
-	return m_histogram;
+	return result;
 }
 
-void CoverageHistogramCalculator::aggregate(const PYXPointer<PYXValueTile> & tile, const PYXPointer<PYXInnerTileIntersectionIterator> & neededCells)
+int CoverageHistogramCalculator::selectResolution(const std::vector<PYXPointer<PYXGeometry>> & geometries) const
 {
-	const PYXIcosIndex & root = tile->getTile().getRootIndex();
-	int resolution = tile->getTile().getCellResolution();
-	int cellCount = PYXIcosMath::getCellCount(root,resolution);
+	//find a good resolution to perform aggregation on...
+	int cellResolution = m_spCoverage->getGeometry()->getCellResolution();
 
-	double m_posZeroCellSize = SnyderProjection::getInstance()->calcCellAreaOnReferenceSphere(PYXIcosMath::calcIndexFromOffset(root,resolution,0)); //could be pentagon...
-	double m_cellSize = SnyderProjection::getInstance()->calcCellAreaOnReferenceSphere(PYXIcosMath::calcIndexFromOffset(root,resolution,1)); //must be hexagon.
+	//use the largest feature: a resolution good for the small features would make the large ones too expensive.
+	PYXPointer<PYXGeometry> largestGeometry;
+	double largestRadius = 0;
 
-	PYXValue value = tile->getTypeCompatibleValue(0);
+	for(auto & geometry : geometries)
+	{
+		if (!geometry)
+		{
+			continue;
+		}
+
+		double radius = geometry->getBoundingCircle().getRadius();
+		if (radius > largestRadius)
+		{
+			largestRadius = radius;
+			largestGeometry = geometry;
+		}
+	}
+
+	//make it a resolution that would be around 1~6 depth-11 tiles.
+	if (largestGeometry)
+	{
+		cellResolution = std::min(PYXMath::knMaxAbsResolution,PYXBoundingCircle::estimateResolutionFromRadius(largestRadius)+11);
+		cellResolution = findResolution(largestGeometry,std::max(2,cellResolution-11),0.05)+11;
+	}
+
+	return cellResolution;
+}
+
+void CoverageHistogramCalculator::aggregateTile(int fieldIndex,int cellResolution,const ZoneTile * zoneTile,const std::vector<PYXPointer<PYXGeometry>> * geometries,PartialHistograms & partial) const
+{
+	PYXTile tile(zoneTile->index,cellResolution);
+
+	PYXPointer<PYXValueTile> valueTile = m_spCoverage->getFieldTile(tile.getRootIndex(),tile.getCellResolution(),fieldIndex);
+
+	if (!valueTile)
+	{
+		return;
+	}
+
+	//copy the values of the tile once, the runs of all the features are read from it
+	const int nStride = valueTile->getDataChannelCount(0);
+	partial.tileValues.resize(valueTile->getNumberOfCells() * nStride);
+	partial.tileHasValues.resize(valueTile->getNumberOfCells());
+	valueTile->getChannelValues(0,&partial.tileValues[0],&partial.tileHasValues[0]);
+
+	const PYXTile & valueTileExtent = valueTile->getTile();
+
+	std::vector<PYXInnerTile> innerTiles = PYXInnerTile::createInnerTiles(tile);
+
+	for(auto & zone : zoneTile->zones)
+	{
+		const PYXPointer<PYXGeometry> & geometry = (*geometries)[zone];
+
+		for(std::vector<PYXInnerTile>::iterator it = innerTiles.begin(); it != innerTiles.end(); ++it)
+		{
+			PYXPointer<PYXInnerTileIntersectionIterator> geomIt = geometry->getInnerTileIterator(*it);
+			if(geomIt)
+			{
+				aggregate(valueTileExtent,&partial.tileValues[0],&partial.tileHasValues[0],nStride,geomIt,partial.values[zone]);
+			}
+		}
+
+		if ((int)partial.values[zone].size() >= knValuesPerFlush)
+		{
+			partial.flush(zone);
+		}
+	}
+}
 
-	std::vector<double> valuesToAdd;
-	valuesToAdd.reserve(1000);
+void CoverageHistogramCalculator::aggregate(	const PYXTile & tile,
+												const double * tileValues,
+												const unsigned char * hasValues,
+												int nStride,
+												const PYXPointer<PYXInnerTileIntersectionIterator> & neededCells,
+												std::vector<double> & values	)
+{
+	const PYXIcosIndex & root = tile.getRootIndex();
+	int resolution = tile.getCellResolution();
+	int cellCount = PYXIcosMath::getCellCount(root,resolution);
 
 	for(;!neededCells->end();neededCells->next())
 	{
@@ -237,53 +459,81 @@ void CoverageHistogramCalculator::aggregate(const PYXPointer<PYXValueTile> & til
 			continue;
 		}
 
-		//count cover cells
+		//an inner tile above the tile resolution covers a run of consecutive cells
 		PYXIcosIndex index = neededCells->getTile().asTile().getRootIndex();
+		int runLength = 1;
 
-		if(index.getResolution() >= resolution)
+		if (index.getResolution() < resolution)
 		{
-			index.setResolution(resolution);
-			int nPos = PYXIcosMath::calcCellPosition(root, index);
-			if(nPos < cellCount)
+			runLength = PYXIcosMath::getCellCount(index,resolution);
+		}
+
+		index.setResolution(resolution);
+		int firstPos = PYXIcosMath::calcCellPosition(root, index);
+		int endPos = std::min(firstPos + runLength, cellCount);
+
+		if (nStride == 1)
+		{
+			//append every stretch of not null cells of the run at once
+			int pos = firstPos;
+			while (pos < endPos)
 			{
-				if (tile->getValue(nPos, 0, &value))
+				while (pos < endPos && !hasValues[pos])
 				{
-					valuesToAdd.push_back(value.getDouble(0));	
+					++pos;
 				}
+
+				int stretchStart = pos;
+				while (pos < endPos && hasValues[pos])
+				{
+					++pos;
+				}
+
+				values.insert(values.end(),tileValues + stretchStart,tileValues + pos);
 			}
 		}
-		else if (index.getResolution() < resolution)
+		else
 		{
-			int tileCellCount = PYXIcosMath::getCellCount(index,resolution);
-
-			index.setResolution(resolution);
-			int nPos = PYXIcosMath::calcCellPosition(root, index);
-
-			for(int offset = 0;offset < tileCellCount; ++offset)
+			for(int pos = firstPos; pos < endPos; ++pos)
 			{
-				int pos = nPos + offset;
-				if(pos < cellCount)
+				if (hasValues[pos])
 				{
-					if (tile->getValue(pos, 0, &value))
-					{
-						valuesToAdd.push_back(value.getDouble(0));	
-					}
+					values.push_back(tileValues[pos * nStride]);
 				}
 			}
 		}
-
-		if (valuesToAdd.size() >= 1000)
-		{
-			m_histogram->add(*PYXNumericCellHistogram::create(NumericHistogram<double>(valuesToAdd.begin(),valuesToAdd.end()),m_cellResolution));
-			valuesToAdd.clear();
-		}
 	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CoverageHistogramCalculator::PartialHistograms
+////////////////////////////////////////////////////////////////////////////////
+
+void CoverageHistogramCalculator::PartialHistograms::init(int zoneCount)
+{
+	histograms.resize(zoneCount);
+	values.resize(zoneCount);
+}
 
-	if (!valuesToAdd.empty())
+void CoverageHistogramCalculator::PartialHistograms::flush(int zone)
+{
+	std::vector<double> & zoneValues = values[zone];
+
+	if (zoneValues.empty())
 	{
-		m_histogram->add(*PYXNumericCellHistogram::create(NumericHistogram<double>(valuesToAdd.begin(),valuesToAdd.end()),m_cellResolution));
+		return;
 	}
-}
 
+	NumericHistogram<double> histogram(zoneValues.begin(),zoneValues.end());
 
+	if (!histograms[zone])
+	{
+		histograms[zone].reset(new NumericHistogram<double>(histogram));
+	}
+	else
+	{
+		histograms[zone]->add(histogram);
+	}
 
+	zoneValues.clear();
+}
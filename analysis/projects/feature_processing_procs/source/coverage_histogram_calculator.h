@@ -17,6 +17,9 @@ web			: www.pyxisinnovation.com
 #include "pyxis/data/impl/numeric_histogram_impl.h"
 #include "pyxis/data/impl/string_histogram_impl.h"
 
+// boost includes
+#include <boost/shared_ptr.hpp>
+
 
 
 /*!
@@ -29,6 +32,9 @@ class MODULE_FEATURE_PROCESSING_PROCS_DECL CoverageHistogramCalculator : public
 
 public:
 
+	//! Test method
+	static void test();
+
 	//! Constructor
 	CoverageHistogramCalculator();
 
@@ -81,15 +87,73 @@ protected: // ProcessImpl
 public:
 
 	virtual PYXPointer<PYXCellHistogram> STDMETHODCALLTYPE getHistogram( int fieldIndex,PYXPointer<IFeature> feature );
+
+	/*!
+	Calculate the histograms of many features in a single pass over the coverage.
+	Every covering tile is fetched once and shared by all the features that
+	intersect it. The result is ordered like the given features.
+	*/
+	virtual std::vector<PYXPointer<PYXCellHistogram>> STDMETHODCALLTYPE getHistograms( int fieldIndex,const std::vector<PYXPointer<IFeature>> & features );
+
 	int findResolution(const PYXPointer<PYXGeometry> & geometry,int initialResolution,double maxPartialPerecnt) const;
-	void aggregate(const PYXPointer<PYXValueTile> & tile, const PYXPointer<PYXInnerTileIntersectionIterator> & neededCells);
+
+	/*!
+	Collect the values of the needed cells of a tile.
+
+	Every needed inner tile is a run of consecutive cell offsets; the not null
+	values of a run are appended with a single copy per stretch of not null cells.
+
+	\param tile			The tile the values belong to.
+	\param tileValues	The values of the tile, nStride values per cell in offset order.
+	\param hasValues	The not null flag of every cell of the tile.
+	\param nStride		The number of values per cell, only the first one is collected.
+	\param neededCells	The inner tiles of the geometry.
+	\param values		The collected values (out).
+	*/
+	static void aggregate(	const PYXTile & tile,
+							const double * tileValues,
+							const unsigned char * hasValues,
+							int nStride,
+							const PYXPointer<PYXInnerTileIntersectionIterator> & neededCells,
+							std::vector<double> & values	);
+
+private:
+
+	//! Number of values collected before they are added into a partial histogram.
+	static const int knValuesPerFlush = 4096;
+
+	//! A covering tile and the features that intersect it.
+	struct ZoneTile
+	{
+		PYXIcosIndex index;
+		std::vector<int> zones;
+	};
+
+	//! Partial histograms of a single worker thread, one per feature.
+	struct PartialHistograms
+	{
+		std::vector<boost::shared_ptr<NumericHistogram<double>>> histograms;
+		std::vector<std::vector<double>> values;
+
+		//! The values of the tile being aggregated.
+		std::vector<double> tileValues;
+		std::vector<unsigned char> tileHasValues;
+
+		void init(int zoneCount);
+		void flush(int zone);
+	};
+
+	//! Find a cell resolution for the features, good enough for the largest one.
+	int selectResolution(const std::vector<PYXPointer<PYXGeometry>> & geometries) const;
+
+	void aggregateTile(int fieldIndex,int cellResolution,const ZoneTile * zoneTile,const std::vector<PYXPointer<PYXGeometry>> * geometries,PartialHistograms & partial) const;
 
 private:
 
 	boost::intrusive_ptr<ICoverage> m_spCoverage;
 	boost::intrusive_ptr<IFeature> m_spFeature;
-	PYXPointer<PYXCellHistogram> m_histogram;
-	NumericHistogram<double> m_numericHistogram;
+
+	//! The cell resolution attribute, -1 to select it for every call from the features.
 	int m_cellResolution;
 };
 
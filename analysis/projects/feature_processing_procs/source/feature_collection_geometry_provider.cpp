@@ -12,12 +12,148 @@ web			: www.pyxisinnovation.com
 #include "pyxis/pipe/process.h"
 #include "pyxis/procs/feature_collection_index_proc.h"
 #include "pyxis/pipe/pipe_utils.h"
+#include "pyxis/geometry/cell.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+// standard includes
+#include <cstdio>
 
 // {BFFF86DE-90F9-4EA6-9BC1-60075FD91E79}
 PYXCOM_DEFINE_CLSID(FeatureCollectionGeometryProvider, 
 					0xbfff86de, 0x90f9, 0x4ea6, 0x9b, 0xc1, 0x60, 0x7, 0x5f, 0xd9, 0x1e, 0x79);
 
 
+//! Tester class
+Tester<FeatureCollectionGeometryProvider> gTester;
+
+//! Test method
+void FeatureCollectionGeometryProvider::test()
+{
+	//numbers match by value
+	std::string intKey;
+	JoinTable::appendKey(PYXValue(7),intKey);
+	std::string doubleKey;
+	JoinTable::appendKey(PYXValue(7.0),doubleKey);
+	TEST_ASSERT(intKey == doubleKey);
+
+	//strings match by their exact text
+	std::string stringKey;
+	JoinTable::appendKey(PYXValue("7"),stringKey);
+	TEST_ASSERT(intKey != stringKey);
+
+	std::string textKey;
+	JoinTable::appendKey(PYXValue("  Ottawa"),textKey);
+	std::string trimmedKey;
+	JoinTable::appendKey(PYXValue("Ottawa"),trimmedKey);
+	TEST_ASSERT(textKey != trimmedKey);
+
+	//leading zero codes, hex-looking and large integer IDs are not folded into numbers
+	std::string codeKey;
+	JoinTable::appendKey(PYXValue("007"),codeKey);
+	TEST_ASSERT(codeKey != stringKey);
+
+	std::string hexKey;
+	JoinTable::appendKey(PYXValue("0x1A"),hexKey);
+	std::string decimalKey;
+	JoinTable::appendKey(PYXValue("26"),decimalKey);
+	TEST_ASSERT(hexKey != decimalKey);
+
+	std::string largeKey1;
+	JoinTable::appendKey(PYXValue("9007199254740992"),largeKey1);
+	std::string largeKey2;
+	JoinTable::appendKey(PYXValue("9007199254740993"),largeKey2);
+	TEST_ASSERT(largeKey1 != largeKey2);
+
+	std::string nullKey;
+	JoinTable::appendKey(PYXValue(),nullKey);
+	std::string emptyKey;
+	JoinTable::appendKey(PYXValue(""),emptyKey);
+	TEST_ASSERT(nullKey != emptyKey);
+	TEST_ASSERT(nullKey != intKey);
+
+	//composite keys can't be confused by moving characters between fields
+	std::string key1;
+	JoinTable::appendKey(PYXValue("ab"),key1);
+	JoinTable::appendKey(PYXValue("c"),key1);
+	std::string key2;
+	JoinTable::appendKey(PYXValue("a"),key2);
+	JoinTable::appendKey(PYXValue("bc"),key2);
+	TEST_ASSERT(key1 != key2);
+
+	//join: duplicates, spilling and statistics
+	const int nFeatures = 1000;
+	PYXPointer<JoinTable> table = JoinTable::create(nFeatures / 2);
+	PYXPointer<PYXGeometry> spGeometry = PYXCell::create(PYXIcosIndex("A-0"));
+
+	for (int i = 0; i < nFeatures; ++i)
+	{
+		std::string key;
+		JoinTable::appendKey(PYXValue(i % (nFeatures - 10)),key);
+		JoinTable::appendKey(PYXValue("region " + StringUtils::toString(i % 3)),key);
+		table->add(key,StringUtils::toString(i),spGeometry);
+	}
+
+	int nMatches = 0;
+	for (int i = 0; i < nFeatures * 2; ++i)
+	{
+		std::string key;
+		JoinTable::appendKey(PYXValue(static_cast<double>(i)),key);
+		JoinTable::appendKey(PYXValue("region " + StringUtils::toString(i % 3)),key);
+		const JoinTable::Entry * entry = table->find(key);
+		if (entry)
+		{
+			++nMatches;
+			TEST_ASSERT(entry->strFeatureID == StringUtils::toString(i));
+			TEST_ASSERT((i < nFeatures / 2) == (entry->spGeometry != 0));
+		}
+	}
+
+	JoinStatistics statistics = table->getStatistics();
+	TEST_ASSERT_EQUAL(statistics.nFeatures,nFeatures);
+	TEST_ASSERT_EQUAL(statistics.nDuplicates,10);
+	TEST_ASSERT_EQUAL(statistics.nKeys,nFeatures - 10);
+	TEST_ASSERT_EQUAL(statistics.nSpilled,nFeatures / 2 - 10);
+	TEST_ASSERT_EQUAL(statistics.nProbes,nFeatures * 2);
+	TEST_ASSERT_EQUAL(statistics.nMatches,nFeatures - 10);
+	TEST_ASSERT_EQUAL(nMatches,nFeatures - 10);
+}
+
+//! Time building and probing a join table of 100k features (not run by the tests).
+void FeatureCollectionGeometryProvider::benchmark()
+{
+	const int nFeatures = 100000;
+	PYXPointer<JoinTable> table = JoinTable::create(nFeatures / 2);
+	PYXPointer<PYXGeometry> spGeometry = PYXCell::create(PYXIcosIndex("A-0"));
+
+	PYXHighQualityTimer timer;
+	timer.start();
+	for (int i = 0; i < nFeatures; ++i)
+	{
+		std::string key;
+		JoinTable::appendKey(PYXValue(i),key);
+		JoinTable::appendKey(PYXValue("region " + StringUtils::toString(i % 3)),key);
+		table->add(key,StringUtils::toString(i),spGeometry);
+	}
+	timer.stop();
+	double fBuildTime = timer.getTime();
+
+	timer.start();
+	for (int i = 0; i < nFeatures * 2; ++i)
+	{
+		std::string key;
+		JoinTable::appendKey(PYXValue(i),key);
+		JoinTable::appendKey(PYXValue("region " + StringUtils::toString(i % 3)),key);
+		table->find(key);
+	}
+	timer.stop();
+	double fProbeTime = timer.getTime();
+
+	TRACE_INFO("FeatureCollectionGeometryProvider: hash join of " << nFeatures << " features built in " << fBuildTime << "[sec], " <<
+		nFeatures * 2 << " records probed in " << fProbeTime << "[sec] (match rate " << table->getStatistics().getMatchRate() * 100 << "%)");
+}
+
 PYXCOM_CLASS_INTERFACES(FeatureCollectionGeometryProvider, IGeometryProvider::iid, IProcess::iid, PYXCOM_IUnknown::iid);
 
 IPROCESS_SPEC_BEGIN(FeatureCollectionGeometryProvider, "Feature Collection Geometry Provider", "Provides a geometry for a given IRecord based on the input feature collection.", "Analysis/Features/Geotagging",
@@ -28,16 +164,25 @@ IPROCESS_SPEC_BEGIN(FeatureCollectionGeometryProvider, "Feature Collection Geome
 
 					IProcess::eInitStatus FeatureCollectionGeometryProvider::initImpl()
 {
-	if(m_featureFieldIndices.size() == 0  && m_featureFieldIndices.size() == 0)
+	if(m_featureFieldIndices.size() == 0  && m_recordFieldIndices.size() == 0)
 	{
 		setInitProcError<GenericProcInitError>("At least one index should be provided to match a record with a feature");
 		return knFailedToInit;
 	}
-	if(m_featureFieldIndices.size() != m_featureFieldIndices.size()) 
+	if(m_featureFieldIndices.size() != m_recordFieldIndices.size()) 
 	{
 		setInitProcError<GenericProcInitError>("Number of feature indices and record indices do not match");
 		return knFailedToInit;
 	}
+	if(m_strJoinMode != "Hash" && m_strJoinMode != "Index")
+	{
+		setInitProcError<GenericProcInitError>("Unsupported join mode: " + m_strJoinMode);
+		return knFailedToInit;
+	}
+
+	m_inputFC = getParameter(0)->getValue(0)->getOutput()->QueryInterface<IFeatureCollection>();
+	m_featureCollectionIndex.reset();
+	m_joinTable.reset();
 
 	return knInitialized;
 }
@@ -56,10 +201,87 @@ std::map<std::string, std::string> STDMETHODCALLTYPE FeatureCollectionGeometryPr
 	vectorToString(m_featureFieldIndices, fields);
 	mapAttr["FeatureFieldsIndices"] = fields;
 
+	mapAttr["JoinMode"] = m_strJoinMode;
+
 	return mapAttr;
 }
 
 PYXPointer<PYXGeometry> STDMETHODCALLTYPE FeatureCollectionGeometryProvider::getGeometry(boost::intrusive_ptr<IRecord> & record) const
+{
+	if (m_strJoinMode == "Index")
+	{
+		return getGeometryFromIndex(record);
+	}
+
+	{
+		boost::recursive_mutex::scoped_lock lock(m_procMutex);
+		if (!m_joinTable)
+		{
+			buildJoinTable();
+		}
+	}
+
+	std::string key;
+	for (unsigned int i = 0; i < m_recordFieldIndices.size(); i++)
+	{
+		JoinTable::appendKey(record->getFieldValue(m_recordFieldIndices[i]),key);
+	}
+
+	const JoinTable::Entry * entry = m_joinTable->find(key);
+	if (!entry)
+	{
+		return NULL;
+	}
+	if (entry->spGeometry)
+	{
+		return entry->spGeometry;
+	}
+
+	// the geometry was spilled, fetch it from the feature collection
+	auto feature = m_inputFC->getFeature(entry->strFeatureID);
+	return feature ? feature->getGeometry() : NULL;
+}
+
+FeatureCollectionGeometryProvider::JoinStatistics FeatureCollectionGeometryProvider::getJoinStatistics() const
+{
+	boost::recursive_mutex::scoped_lock lock(m_procMutex);
+	if (!m_joinTable)
+	{
+		JoinStatistics statistics = {0,0,0,0,0,0};
+		return statistics;
+	}
+	return m_joinTable->getStatistics();
+}
+
+void FeatureCollectionGeometryProvider::buildJoinTable() const
+{
+	PYXHighQualityTimer timer;
+	timer.start();
+
+	PYXPointer<JoinTable> table = JoinTable::create();
+	std::string key;
+	for (auto it = m_inputFC->getIterator(); !it->end(); it->next())
+	{
+		auto feature = it->getFeature();
+		key.clear();
+		for (unsigned int i = 0; i < m_featureFieldIndices.size(); i++)
+		{
+			JoinTable::appendKey(feature->getFieldValue(m_featureFieldIndices[i]),key);
+		}
+		table->add(key,feature->getID(),feature->getGeometry());
+	}
+
+	timer.stop();
+
+	JoinStatistics statistics = table->getStatistics();
+	TRACE_INFO("FeatureCollectionGeometryProvider: join table of " << statistics.nFeatures << " features (" <<
+		statistics.nKeys << " keys, " << statistics.nDuplicates << " duplicates, " << statistics.nSpilled << " spilled) built in " <<
+		timer.getTime() << "[sec]");
+
+	m_joinTable = table;
+}
+
+PYXPointer<PYXGeometry> FeatureCollectionGeometryProvider::getGeometryFromIndex(boost::intrusive_ptr<IRecord> & record) const
 {
 	{
 		boost::recursive_mutex::scoped_lock lock(m_procMutex);
@@ -109,6 +331,8 @@ void STDMETHODCALLTYPE FeatureCollectionGeometryProvider::setAttributes(const st
 
 	UPDATE_PROCESS_ATTRIBUTE_STRING(mapAttr,"RecordFieldIndices",fields);
 	stringToVector(fields,m_recordFieldIndices);
+
+	UPDATE_PROCESS_ATTRIBUTE_STRING(mapAttr,"JoinMode",m_strJoinMode);
 }
 
 
@@ -122,6 +346,14 @@ std::string STDMETHODCALLTYPE FeatureCollectionGeometryProvider::getAttributeSch
 		"xmlns:mstns=\"http://tempuri.org/XMLSchema.xsd\" "
 		"xmlns:xs=\"http://www.w3.org/2001/XMLSchema\" "
 		">"
+
+		"<xs:simpleType name=\"JoinModeType\">"
+		"<xs:restriction base=\"xs:string\">"
+			"<xs:enumeration value=\"Hash\" />"
+			"<xs:enumeration value=\"Index\" />"
+		"</xs:restriction>"
+		"</xs:simpleType>"
+
 		"<xs:element name=\"FeatureCollectionGeometryProvider\">"
 		"<xs:complexType>"
 		"<xs:sequence>"
@@ -144,12 +376,133 @@ std::string STDMETHODCALLTYPE FeatureCollectionGeometryProvider::getAttributeSch
 		"</xs:annotation>"
 		"</xs:element>"
 
+		"<xs:element name=\"JoinMode\" type=\"JoinModeType\" default=\"Index\">"
+		"<xs:annotation>"
+		"<xs:appinfo>"
+		"<friendlyName>Join Mode</friendlyName>"
+		"<description>Hash: join the records with a hash table of the features built once. Index: look up every record in a full-text index of the first field</description>"
+		"</xs:appinfo>"
+		"</xs:annotation>"
+		"</xs:element>"
+
 		"</xs:sequence>"
 		"</xs:complexType>"
 		"</xs:element>"
 		"</xs:schema>";
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// FeatureCollectionGeometryProvider::JoinTable
+///////////////////////////////////////////////////////////////////////////////
+
+FeatureCollectionGeometryProvider::JoinTable::JoinTable(int nMaxGeometries) :
+	m_nMaxGeometries(nMaxGeometries),
+	m_nFeatures(0),
+	m_nDuplicates(0),
+	m_nSpilled(0),
+	m_nProbes(0),
+	m_nMatches(0)
+{
+}
+
+FeatureCollectionGeometryProvider::JoinTable::~JoinTable()
+{
+	if (m_nProbes > 0)
+	{
+		JoinStatistics statistics = getStatistics();
+		TRACE_INFO("FeatureCollectionGeometryProvider: " << statistics.nMatches << " of " << statistics.nProbes <<
+			" records joined (match rate " << statistics.getMatchRate() * 100 << "%)");
+	}
+}
+
+void FeatureCollectionGeometryProvider::JoinTable::appendKey(const PYXValue & value,std::string & key)
+{
+	// every value is encoded as a type tag, the length of its text and its text,
+	// so composite keys of different values never collide.
+	char tag;
+	std::string text;
+
+	if (value.isNull())
+	{
+		tag = 'z';
+	}
+	else if (PYXValue::isNumeric(value.getType()) || value.isBool())
+	{
+		// numbers of different types match by their value
+		tag = 'n';
+		double number = value.getDouble();
+		char buffer[32];
+		sprintf(buffer,"%.17g",number == 0 ? 0.0 : number);
+		text = buffer;
+	}
+	else
+	{
+		// strings match by their exact text, so IDs like "007" or "9007199254740993" are not folded into numbers
+		tag = 's';
+		text = value.getString();
+	}
+
+	key += tag;
+	key += StringUtils::toString(text.size());
+	key += ':';
+	key += text;
+}
+
+bool FeatureCollectionGeometryProvider::JoinTable::add(const std::string & key,const std::string & strFeatureID,const PYXPointer<PYXGeometry> & spGeometry)
+{
+	++m_nFeatures;
+
+	std::pair<EntryMap::iterator,bool> result = m_entries.insert(std::make_pair(key,Entry()));
+	if (!result.second)
+	{
+		// the first feature of a key wins, like the first match of the index lookup
+		++m_nDuplicates;
+		return false;
+	}
+
+	Entry & entry = result.first->second;
+	entry.strFeatureID = strFeatureID;
+	if (static_cast<int>(m_entries.size()) - m_nSpilled <= m_nMaxGeometries)
+	{
+		entry.spGeometry = spGeometry;
+	}
+	else
+	{
+		++m_nSpilled;
+	}
+	return true;
+}
+
+const FeatureCollectionGeometryProvider::JoinTable::Entry * FeatureCollectionGeometryProvider::JoinTable::find(const std::string & key) const
+{
+	++m_nProbes;
+
+	EntryMap::const_iterator it = m_entries.find(key);
+	if (it == m_entries.end())
+	{
+		return 0;
+	}
+
+	++m_nMatches;
+	return &it->second;
+}
+
+FeatureCollectionGeometryProvider::JoinStatistics FeatureCollectionGeometryProvider::JoinTable::getStatistics() const
+{
+	JoinStatistics statistics;
+	statistics.nFeatures = m_nFeatures;
+	statistics.nKeys = static_cast<int>(m_entries.size());
+	statistics.nDuplicates = m_nDuplicates;
+	statistics.nSpilled = m_nSpilled;
+	statistics.nProbes = static_cast<int>(m_nProbes);
+	statistics.nMatches = static_cast<int>(m_nMatches);
+	return statistics;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FeatureCollectionGeometryProvider helpers
+///////////////////////////////////////////////////////////////////////////////
+
 void FeatureCollectionGeometryProvider::stringToVector(const std::string & input,std::vector<int> & output) const
 {
 	output.clear();
@@ -18,7 +18,16 @@ web			: www.pyxisinnovation.com
 #include "pyxis/data/feature_collection_index.h"
 #include "pyxis/data/record.h"
 #include "pyxis/pipe/process.h"
+#include "pyxis/utility/object.h"
+#include "pyxis/utility/value.h"
 
+// boost includes
+#include <boost/detail/atomic_count.hpp>
+#include <boost/unordered_map.hpp>
+
+// standard includes
+#include <string>
+#include <vector>
 
 
 
@@ -58,8 +67,109 @@ protected: // ProcessImpl
 
 public:
 
+	FeatureCollectionGeometryProvider() : m_strJoinMode("Index")
+	{
+	}
+
+	//! Test method
+	static void test();
+
+	//! Time the hash join of a large feature collection (not run by the tests).
+	static void benchmark();
+
 	virtual PYXPointer<PYXGeometry> STDMETHODCALLTYPE getGeometry(boost::intrusive_ptr<IRecord> & record) const;
 
+public:
+
+	//! Statistics of the hash join.
+	struct JoinStatistics
+	{
+		int nFeatures;		//!< the features added to the join table
+		int nKeys;			//!< the distinct keys of the join table
+		int nDuplicates;	//!< the features whose key was already in the join table (they are never returned)
+		int nSpilled;		//!< the features whose geometry is not kept in memory
+		int nProbes;		//!< the records looked up
+		int nMatches;		//!< the records that matched a feature
+
+		//! The fraction of the records that matched a feature.
+		double getMatchRate() const
+		{
+			return nProbes ? static_cast<double>(nMatches) / nProbes : 0;
+		}
+	};
+
+	//! The statistics of the hash join (all zero until the first record is joined, or in index mode).
+	JoinStatistics getJoinStatistics() const;
+
+private:
+
+	/*!
+	JoinTable is a hash table from the composite key of the features of the
+	input feature collection to their geometries.
+
+	Numbers of different types are compared by their double value, and strings
+	by their exact text, as the index lookup compares them. Numeric looking
+	strings are not converted, so codes with leading zeros and integer IDs
+	larger than a double can represent keep their identity.
+
+	The geometries of the first knMaxGeometries features are kept in the table,
+	the following features only keep their ID and their geometry is fetched from
+	the feature collection when a record matches them, which bounds the memory
+	used to join a large feature collection.
+	*/
+	class JoinTable : public PYXObject
+	{
+	public:
+		//! The maximum number of geometries kept in the table.
+		static const int knMaxGeometries = 250000;
+
+		//! An entry of the table.
+		struct Entry
+		{
+			std::string strFeatureID;
+			PYXPointer<PYXGeometry> spGeometry; //!< null if the geometry is spilled
+		};
+
+		static PYXPointer<JoinTable> create(int nMaxGeometries = knMaxGeometries)
+		{
+			return PYXNEW(JoinTable,nMaxGeometries);
+		}
+
+		explicit JoinTable(int nMaxGeometries);
+
+		virtual ~JoinTable();
+
+		//! Append the normalized value of a key field to a composite key.
+		static void appendKey(const PYXValue & value,std::string & key);
+
+		//! Add a feature, return false if a feature with the same key was already added.
+		bool add(const std::string & key,const std::string & strFeatureID,const PYXPointer<PYXGeometry> & spGeometry);
+
+		//! Find the entry of a key, return null if there is no match.
+		const Entry * find(const std::string & key) const;
+
+		JoinStatistics getStatistics() const;
+
+	private:
+		typedef boost::unordered_map<std::string,Entry> EntryMap;
+
+		EntryMap m_entries;
+		int m_nMaxGeometries;
+		int m_nFeatures;
+		int m_nDuplicates;
+		int m_nSpilled;
+
+		//! The probes are counted from many threads.
+		mutable boost::detail::atomic_count m_nProbes;
+		mutable boost::detail::atomic_count m_nMatches;
+	};
+
+	//! Build the join table from the features of the input feature collection.
+	void buildJoinTable() const;
+
+	//! Find the geometry of a record with the full-text feature collection index.
+	PYXPointer<PYXGeometry> getGeometryFromIndex(boost::intrusive_ptr<IRecord> & record) const;
+
 private:
 
 	void stringToVector(const std::string & input, std::vector<int> & output) const;
@@ -69,6 +179,11 @@ private:
 private:
 
 	mutable boost::intrusive_ptr<IFeatureCollectionIndex> m_featureCollectionIndex;
+	mutable PYXPointer<JoinTable> m_joinTable;
+	boost::intrusive_ptr<IFeatureCollection> m_inputFC;
+
+	//! "Hash" to join the records with a hash table, "Index" to look them up in the full-text index.
+	std::string m_strJoinMode;
 	std::vector<int> m_recordFieldIndices;
 	std::vector<int> m_featureFieldIndices;
 };
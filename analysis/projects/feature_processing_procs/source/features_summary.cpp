@@ -13,6 +13,8 @@ web			: www.pyxisinnovation.com
 #include "icos_tree.h"
 
 // pyxlib includes
+#include "pyxis/data/pyx_feature.h"
+#include "pyxis/data/impl/sketch_histogram_impl.h"
 #include "pyxis/data/value_tile.h"
 #include "pyxis/derm/snyder_projection.h"
 #include "pyxis/derm/sub_index_math.h"
@@ -27,6 +29,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/thread_pool.h"
 #include "pyxis/utility/profile.h"
 #include "pyxis/utility/app_services.h"
+#include "pyxis/procs/default_feature.h"
 #include "pyxis/procs/geopacket_source.h"
 
 #include "boost/algorithm/string.hpp"
@@ -34,12 +37,14 @@ web			: www.pyxisinnovation.com
 
 // standard includes
 #include <cassert>
+#include <cstring>
+#include <set>
 #include "pyxis/utility/ssl_utils.h"
 #include "pyxis/utility/local_storage_impl.h"
 
 
 #define MULTITHREAD_IMPORT
-#define FEATURE_SUMMARY_CHANNEL_ID "FSv6"
+#define FEATURE_SUMMARY_CHANNEL_ID "FSv7"
 
 // {E6C3802D-E7B3-431c-A41F-FBAB79E1CA2D}
 PYXCOM_DEFINE_CLSID(FeaturesSummary,
@@ -627,6 +632,334 @@ public:
 	}
 };
 
+////////////////////////////////////
+// FeaturesSummaryUpdater
+////////////////////////////////////
+
+/*!
+Apply added, modified and removed features to a generated summary tree.
+
+Only the groups on the path from the root to the changed features are modified:
+ - a feature is added to the deepest existing group that contains its index. groups are not split, a full
+   rebuild produce a better balanced tree.
+ - the features count, bounding circle and geometry of the groups on the path are updated. removed features
+   don't shrink the circle and geometry of their groups, which stay a valid superset.
+ - the stored histograms of the groups on the path are removed. they are recomputed on demand by merging the
+   stored histograms of the unchanged sub groups with the features of the group.
+*/
+class FeaturesSummaryUpdater
+{
+private:
+	typedef std::vector<PYXPointer<GenericFeaturesGroup::GroupData>> GroupPath;
+
+	PYXPointer<PYXLocalStorage> m_storage;
+	int m_fieldCount;
+
+	GenericFeaturesGroup::GroupData m_rootData;
+
+	//the children lists loaded by group id
+	std::map<std::string,PYXPointer<GenericFeaturesGroup::ChildrenList>> m_children;
+
+	//the decoded geometries of the modified groups
+	std::map<std::string,std::pair<PYXPointer<GenericFeaturesGroup::GroupData>,PYXPointer<PYXTileCollection>>> m_geometries;
+
+	//groups whose children list need to be written
+	std::set<std::string> m_modifiedGroups;
+
+	//groups whose histograms need to be recomputed
+	std::set<std::string> m_affectedGroups;
+
+	//the new group of the changed features ("" for removed features)
+	std::map<std::string,std::string> m_featureGroups;
+
+public:
+	FeaturesSummaryUpdater(const PYXPointer<PYXLocalStorage> & storage,int fieldCount) : m_storage(storage), m_fieldCount(fieldCount)
+	{
+		std::auto_ptr<PYXConstWireBuffer> buffer = m_storage->get("g:");
+
+		if (buffer.get() == 0)
+		{
+			PYXTHROW(PYXException,"Failed to load the root of the features summary tree");
+		}
+
+		*buffer >> m_rootData;
+	}
+
+public:
+	void addFeature(const boost::intrusive_ptr<IFeature> & feature)
+	{
+		try
+		{
+			PYXPointer<GenericFeaturesGroup::NodeData> nodeData = GroupCreator::createNodeData(feature);
+			PYXIcosIndex index = GroupCreator::getFeatureIndex(nodeData);
+
+			GroupPath path;
+			findPath(index,path);
+
+			if (path.empty())
+			{
+				//no root group covers this feature yet
+				PYXIcosIndex rootIndex = index;
+				rootIndex.setResolution(1);
+
+				PYXPointer<GenericFeaturesGroup::GroupData> groupData = GenericFeaturesGroup::GroupData::create();
+				groupData->id = rootIndex.toString();
+
+				PYXPointer<PYXTileCollection> geometry = PYXTileCollection::create();
+				geometry->setCellResolution(rootIndex.getResolution()+5);
+				m_geometries[groupData->id] = std::make_pair(groupData,geometry);
+
+				getChildren("")->childrenNodes.push_back(groupData);
+				m_modifiedGroups.insert("");
+
+				path.push_back(groupData);
+			}
+
+			const std::string & groupId = path.back()->id;
+
+			getChildren(groupId)->childrenNodes.push_back(nodeData);
+			m_modifiedGroups.insert(groupId);
+			m_featureGroups[nodeData->id] = groupId;
+
+			PYXPointer<const PYXGeometry> featureGeometry = feature->getGeometry();
+
+			for(auto & group : path)
+			{
+				group->featuresCount.min++;
+				group->featuresCount.max++;
+				group->circle += nodeData->circle;
+
+				PYXPointer<PYXTileCollection> groupGeometry = getGeometry(group);
+				PYXTileCollection geomCopy;
+				featureGeometry->copyTo(&geomCopy,groupGeometry->getCellResolution());
+				groupGeometry->addGeometry(geomCopy);
+			}
+
+			m_rootData.featuresCount.min++;
+			m_rootData.featuresCount.max++;
+			m_rootData.circle += nodeData->circle;
+
+			markAffected(path);
+		}
+		CATCH_AND_RETHROW("Failed to add feature into group tree " << feature->getID());
+	}
+
+	//! return false if the feature is not in the tree
+	bool removeFeature(const std::string & featureId)
+	{
+		try
+		{
+			std::string groupId;
+
+			if (!findFeatureGroup(featureId,groupId))
+			{
+				return false;
+			}
+
+			GroupPath path;
+			findPath(PYXIcosIndex(groupId),path);
+
+			if (path.empty() || path.back()->id != groupId)
+			{
+				PYXTHROW(PYXException,"Group " << groupId << " wasn't found in the group tree");
+			}
+
+			GenericFeaturesGroup::ChildrenList::List & nodes = getChildren(groupId)->childrenNodes;
+			GenericFeaturesGroup::ChildrenList::List::iterator it = nodes.begin();
+
+			while (it != nodes.end() && ((*it)->nodeType != GenericFeaturesGroup::knFeature || (*it)->id != featureId))
+			{
+				++it;
+			}
+
+			if (it == nodes.end())
+			{
+				PYXTHROW(PYXException,"Feature wasn't found in group " << groupId);
+			}
+
+			nodes.erase(it);
+			m_modifiedGroups.insert(groupId);
+			m_featureGroups[featureId] = "";
+
+			for(auto & group : path)
+			{
+				group->featuresCount.min--;
+				group->featuresCount.max--;
+			}
+
+			m_rootData.featuresCount.min--;
+			m_rootData.featuresCount.max--;
+
+			markAffected(path);
+
+			return true;
+		}
+		CATCH_AND_RETHROW("Failed to remove feature from group tree " << featureId);
+	}
+
+	void commit()
+	{
+		//write down the modified geometries, they are stored in the children list of the parent group
+		for(auto & item : m_geometries)
+		{
+			PYXStringWireBuffer buffer;
+			buffer << *(item.second.second);
+			item.second.first->serializedGeometry = *buffer.getBuffer();
+		}
+
+		for(auto & groupId : m_modifiedGroups)
+		{
+			PYXStringWireBuffer buffer;
+			buffer << *getChildren(groupId);
+			m_storage->set("g:" + groupId + ":cl",buffer);
+		}
+
+		{
+			PYXStringWireBuffer buffer;
+			buffer << m_rootData;
+			m_storage->set("g:",buffer);
+		}
+
+		//write down feature id lookup
+		std::map<std::string,PYXConstBufferSlice> fids;
+
+		for(auto & item : m_featureGroups)
+		{
+			if (item.second.empty())
+			{
+				m_storage->remove("fid:" + item.first);
+			}
+			else
+			{
+				PYXStringWireBuffer buffer;
+				buffer << item.second;
+				fids["fid:" + item.first] = *buffer.getBuffer();
+			}
+		}
+
+		m_storage->setMany(fids);
+
+		//histograms of the affected groups would be merged again from their sub groups
+		for(auto & groupId : m_affectedGroups)
+		{
+			for(int i=0;i<m_fieldCount;++i)
+			{
+				m_storage->remove("hist:" + StringUtils::toString(i) + ":" + groupId);
+			}
+		}
+
+		TRACE_INFO("features summary delta updated " << m_affectedGroups.size() << " groups");
+	}
+
+private:
+	PYXPointer<GenericFeaturesGroup::ChildrenList> getChildren(const std::string & groupId)
+	{
+		auto it = m_children.find(groupId);
+
+		if (it != m_children.end())
+		{
+			return it->second;
+		}
+
+		PYXPointer<GenericFeaturesGroup::ChildrenList> children = GenericFeaturesGroup::ChildrenList::create();
+
+		std::auto_ptr<PYXConstWireBuffer> buffer = m_storage->get("g:" + groupId + ":cl");
+		if (buffer.get() != 0)
+		{
+			*buffer >> *children;
+		}
+
+		m_children[groupId] = children;
+		return children;
+	}
+
+	PYXPointer<PYXTileCollection> getGeometry(const PYXPointer<GenericFeaturesGroup::GroupData> & group)
+	{
+		auto it = m_geometries.find(group->id);
+
+		if (it != m_geometries.end())
+		{
+			return it->second.second;
+		}
+
+		PYXConstWireBuffer buffer(group->serializedGeometry);
+		PYXPointer<PYXGeometry> geom;
+		buffer >> geom;
+
+		PYXPointer<PYXTileCollection> geometry = boost::dynamic_pointer_cast<PYXTileCollection>(geom);
+
+		if (!geometry)
+		{
+			PYXTHROW(PYXException,"Group " << group->id << " has an invalid geometry");
+		}
+
+		m_geometries[group->id] = std::make_pair(group,geometry);
+		return geometry;
+	}
+
+	//! find the groups from the root to the deepest group that contains the given index
+	void findPath(const PYXIcosIndex & index,GroupPath & path)
+	{
+		path.clear();
+
+		std::string groupId = "";
+		bool found = true;
+
+		while (found)
+		{
+			found = false;
+
+			for(auto & child : getChildren(groupId)->childrenNodes)
+			{
+				if (child->nodeType == GenericFeaturesGroup::knGroup && PYXIcosIndex(child->id).isAncestorOf(index))
+				{
+					path.push_back(boost::dynamic_pointer_cast<GenericFeaturesGroup::GroupData>(child));
+					groupId = child->id;
+					found = true;
+					break;
+				}
+			}
+		}
+	}
+
+	bool findFeatureGroup(const std::string & featureId,std::string & groupId)
+	{
+		auto it = m_featureGroups.find(featureId);
+
+		if (it != m_featureGroups.end())
+		{
+			groupId = it->second;
+			return !groupId.empty();
+		}
+
+		std::auto_ptr<PYXConstWireBuffer> buffer = m_storage->get("fid:" + featureId);
+
+		if (buffer.get() == 0)
+		{
+			return false;
+		}
+
+		*buffer >> groupId;
+		return true;
+	}
+
+	//! the group data of the path is stored in the children list of the parent groups
+	void markAffected(const GroupPath & path)
+	{
+		m_modifiedGroups.insert("");
+		m_affectedGroups.insert("");
+
+		for(unsigned int i=0;i<path.size();++i)
+		{
+			if (i+1 < path.size())
+			{
+				m_modifiedGroups.insert(path[i]->id);
+			}
+			m_affectedGroups.insert(path[i]->id);
+		}
+	}
+};
+
 /*
 transform original storage keys to file based keys for better performance
 
@@ -862,7 +1195,7 @@ private:
 // FeaturesSummary
 ////////////////////////////////////////////////////////////////////////////////
 
-FeaturesSummary::FeaturesSummary()
+FeaturesSummary::FeaturesSummary() : m_bPublished(false)
 {
 }
 
@@ -870,6 +1203,73 @@ FeaturesSummary::~FeaturesSummary()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// FeaturesSummary test
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! Random point features and a 1% delta of them, to compare a delta against a full rebuild.
+struct DeltaTestData
+{
+	PYXPointer<PYXTableDefinition> definition;
+	boost::intrusive_ptr<DefaultFeatureCollection> originalFC;
+	boost::intrusive_ptr<DefaultFeatureCollection> updatedFC;
+	std::vector<std::string> removedIds;
+	std::vector<boost::intrusive_ptr<IFeature>> changedFeatures;
+
+	explicit DeltaTestData(int featuresCount)
+	{
+		const int changeCount = featuresCount / 300;
+
+		definition = PYXTableDefinition::create();
+		definition->addFieldDefinition("value",PYXFieldDefinition::knContextNone,PYXValue::knDouble);
+
+		srand(1);
+		std::vector<boost::intrusive_ptr<IFeature>> features;
+		for(int i=0;i<featuresCount + changeCount * 2;++i)
+		{
+			CoordLatLon ll;
+			ll.setInDegrees(180.0 * rand() / RAND_MAX - 90, 360.0 * rand() / RAND_MAX - 180);
+
+			//the extra features are used as the modified versions of features and as the added features
+			std::string id = StringUtils::toString(i < featuresCount + changeCount ? i : i - changeCount * 2);
+
+			boost::intrusive_ptr<PYXFeature> feature = new PYXFeature(
+				PYXVectorGeometry2::createFromPoint(SphereMath::llxyz(ll),24),id,"",false,definition);
+			feature->setFieldValue(PYXValue(static_cast<double>(i % 1000)),0);
+			features.push_back(feature);
+		}
+
+		originalFC = new DefaultFeatureCollection();
+		for(int i=0;i<featuresCount;++i)
+		{
+			originalFC->addFeature(features[i]);
+		}
+
+		//the 1% delta: remove the first features, add new ids and modify the features with the last ids
+		for(int i=0;i<changeCount;++i)
+		{
+			removedIds.push_back(features[i]->getID());
+			changedFeatures.push_back(features[featuresCount + i]);
+			changedFeatures.push_back(features[featuresCount + changeCount + i]);
+		}
+
+		updatedFC = new DefaultFeatureCollection();
+		for(int i=changeCount;i<featuresCount + changeCount * 2;++i)
+		{
+			//skip the features that were modified
+			if (i < featuresCount - changeCount || i >= featuresCount)
+			{
+				updatedFC->addFeature(features[i]);
+			}
+		}
+	}
+};
+
+}
+
 void FeaturesSummary::test()
 {
 	//Test issue with PYXTileCollection
@@ -890,7 +1290,92 @@ void FeaturesSummary::test()
 
 	TEST_ASSERT(deCollection->isEqual(collection));
 
-	// TODO test something
+	//Test applying a delta against a full rebuild
+	{
+		const int featuresCount = 10000;
+		DeltaTestData data(featuresCount);
+		PYXPointer<PYXTableDefinition> definition = data.definition;
+		std::vector<std::string> & removedIds = data.removedIds;
+		std::vector<boost::intrusive_ptr<IFeature>> & changedFeatures = data.changedFeatures;
+
+		PYXPointer<PYXLocalStorage> storage = PYXTempLocalStorage::create();
+		Context::create(data.originalFC,definition,"",storage,50 * 1024 * 1024)->getRootGroup();
+
+		//the input changed: compare the stored tree with the updated input
+		PYXPointer<Context> context = Context::create(data.updatedFC,definition,"",storage,50 * 1024 * 1024);
+
+		std::vector<std::string> foundRemovedIds;
+		std::vector<boost::intrusive_ptr<IFeature>> foundFeatures;
+
+		context->findDelta(PYXPointer<PYXGeometry>(),foundFeatures,foundRemovedIds);
+		context->applyDelta(foundFeatures,foundRemovedIds);
+
+		TEST_ASSERT(foundRemovedIds.size() == removedIds.size());
+		TEST_ASSERT(foundFeatures.size() == changedFeatures.size());
+
+		//the tree matches its input again
+		foundRemovedIds.clear();
+		foundFeatures.clear();
+		context->findDelta(PYXPointer<PYXGeometry>(),foundFeatures,foundRemovedIds);
+		TEST_ASSERT(foundFeatures.empty() && foundRemovedIds.empty());
+
+		PYXPointer<Context> rebuiltContext = Context::create(data.updatedFC,definition,"",PYXTempLocalStorage::create(),50 * 1024 * 1024);
+		boost::intrusive_ptr<GenericFeaturesGroup> rebuiltRoot = rebuiltContext->getRootGroup();
+
+		boost::intrusive_ptr<GenericFeaturesGroup> updatedRoot = context->getRootGroup();
+
+		TEST_ASSERT(context->getRevision() == 1);
+		TEST_ASSERT(rebuiltContext->getRevision() == 0);
+		TEST_ASSERT(updatedRoot->getFeaturesCount().max == featuresCount);
+		TEST_ASSERT(updatedRoot->getFeaturesCount().max == rebuiltRoot->getFeaturesCount().max);
+
+		PYXPointer<PYXHistogram> updatedHist = updatedRoot->getFieldHistogram(0);
+		PYXPointer<PYXHistogram> rebuiltHist = rebuiltRoot->getFieldHistogram(0);
+		TEST_ASSERT(updatedHist->getFeatureCount().max == rebuiltHist->getFeatureCount().max);
+
+		//the group histograms are sketches merged from the sub groups
+		TEST_ASSERT(dynamic_cast<PYXNumericSketchHistogram*>(updatedHist.get()) != 0);
+		TEST_ASSERT(updatedHist->getSum().getDouble() == rebuiltHist->getSum().getDouble());
+
+		//removed features are gone, modified and added features are found with their new values
+		TEST_ASSERT(context->getFeatureGroupIdForFeature(removedIds[0]).empty());
+		for(auto & feature : changedFeatures)
+		{
+			std::string groupId = context->getFeatureGroupIdForFeature(feature->getID());
+			TEST_ASSERT(!groupId.empty());
+
+			boost::intrusive_ptr<IFeature> stored = updatedRoot->findGroup(groupId)->getFeature(feature->getID());
+			TEST_ASSERT(stored->getFieldValue(0).getDouble() == feature->getFieldValue(0).getDouble());
+		}
+	}
+}
+
+void FeaturesSummary::benchmark()
+{
+	const int featuresCount = 10000;
+	DeltaTestData data(featuresCount);
+
+	PYXHighQualityTimer timer;
+
+	PYXPointer<PYXLocalStorage> storage = PYXTempLocalStorage::create();
+	Context::create(data.originalFC,data.definition,"",storage,50 * 1024 * 1024)->getRootGroup();
+	PYXPointer<Context> context = Context::create(data.updatedFC,data.definition,"",storage,50 * 1024 * 1024);
+
+	std::vector<std::string> foundRemovedIds;
+	std::vector<boost::intrusive_ptr<IFeature>> foundFeatures;
+
+	timer.start();
+	context->findDelta(PYXPointer<PYXGeometry>(),foundFeatures,foundRemovedIds);
+	context->applyDelta(foundFeatures,foundRemovedIds);
+	timer.stop();
+	double deltaTime = timer.getTime();
+
+	timer.start();
+	Context::create(data.updatedFC,data.definition,"",PYXTempLocalStorage::create(),50 * 1024 * 1024)->getRootGroup();
+	timer.stop();
+	double rebuildTime = timer.getTime();
+
+	TRACE_INFO("FeaturesSummary: full rebuild of " << featuresCount << " features took " << rebuildTime << "[sec], finding and applying a " << foundFeatures.size() + foundRemovedIds.size() << " features delta took " << deltaTime << "[sec]");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1114,6 +1599,7 @@ IProcess::eInitStatus FeaturesSummary::initImpl()
 		m_strStyle = m_spInputFC->getStyle();
 		m_featuresDefinition = m_spInputFC->getFeatureDefinition();
 
+		m_revisionChannel.reset();
 		initializeLocalStorage();
 
 		//create the channel, but we not using it on the context.
@@ -1172,10 +1658,21 @@ IProcess::eInitStatus FeaturesSummary::initImpl()
 			return knFailedToInit;
 		}
 
-		initializeLocalStorage();
+		m_spInputFC.reset();
+		m_revisionChannel.reset();
 
 		m_channel = PYXNETChannelProvider::getInstance()->getOrCreateChannel(ProcRef(getProcID(),getProcVersion()),FEATURE_SUMMARY_CHANNEL_ID);
-		m_localStorageWithPyxnet = PYXLocalStorageWithPyxnetChannel::create(m_localStorage,m_channel);
+
+		//the publisher could have applied deltas since the tree was first shared, the keys of every revision are cached apart
+		int revision = downloadRevision();
+		initializeLocalStorage(revision);
+
+		if (revision > 0)
+		{
+			m_revisionChannel = PYXNETChannelProvider::getInstance()->getOrCreateChannel(ProcRef(getProcID(),getProcVersion()),getChannelCode(revision));
+		}
+
+		m_localStorageWithPyxnet = PYXLocalStorageWithPyxnetChannel::create(m_localStorage,m_revisionChannel ? m_revisionChannel : m_channel);
 
 		try
 		{
@@ -1202,6 +1699,12 @@ IProcess::eInitStatus FeaturesSummary::initImpl()
 
 	m_localStorageBuffered->setBufferSize(defaultBuffer);
 
+	//a local tree updated by deltas is shared on the channel of its revision as well
+	if (m_spInputFC && m_channel && m_context->getRevision() > 0)
+	{
+		m_revisionChannel = PYXNETChannelProvider::getInstance()->getOrCreateChannel(ProcRef(getProcID(),getProcVersion()),getChannelCode(m_context->getRevision()));
+	}
+
 	storeMetadata();
 
 	PYXThreadPool::addTask(boost::bind(&FeaturesSummary::pointerSafePublishPyxnetChannel,boost::intrusive_ptr<FeaturesSummary>(this)));
@@ -1210,7 +1713,7 @@ IProcess::eInitStatus FeaturesSummary::initImpl()
 	return knInitialized;
 }
 
-void FeaturesSummary::initializeLocalStorage()
+void FeaturesSummary::initializeLocalStorage(int revision)
 {
 	boost::filesystem::path cacheDir = AppServices::getCacheDir("ProcessCache");
 	const ProcessIdentityCache cache(cacheDir);
@@ -1228,7 +1731,13 @@ void FeaturesSummary::initializeLocalStorage()
 	m_localStorage = m_localStorageBuffered = PYXBufferedLocalStorage::create(PYXLocalStorageFactory::createREST(id));
 *	*/
 	
-	m_localStorage = m_localStorageBuffered = PYXBufferedLocalStorage::create(PYXProcessLocalStorage::create(getIdentity()));
+	std::string identity = getIdentity();
+	if (revision > 0)
+	{
+		identity += "\n" + getChannelCode(revision);
+	}
+
+	m_localStorage = m_localStorageBuffered = PYXBufferedLocalStorage::create(PYXProcessLocalStorage::create(identity));
 
 	//add keys transformation if we are using files storage
 	if (AppServices::getConfiguration(AppServicesConfiguration::localStorageFormat) == AppServicesConfiguration::localStorageFormat_files)
@@ -1342,13 +1851,151 @@ void FeaturesSummary::publishPyxnetChannel()
 
 	if (this->getInitState() == knInitialized && PipeManager::exists())
 	{
+		boost::recursive_mutex::scoped_lock lock(m_procMutex);
+
 		if (m_channel) {
 			TRACE_INFO("publishing features summary for " << getProcName() );
-		
-			m_channel->publish();
-			m_channel->attachLocalProvider(PYXNETChannelKeyProviderFromLocalStorage::create(m_localStorage));
+
+			//the first channel is where the peers find the revision of the tree. A peer caching
+			//an older revision only has the keys of that revision, it shares the revision channel only.
+			if (m_spInputFC || !m_revisionChannel)
+			{
+				m_channel->publish();
+				m_channel->attachLocalProvider(PYXNETChannelKeyProviderFromLocalStorage::create(m_localStorage));
+			}
+
+			if (m_revisionChannel)
+			{
+				m_revisionChannel->publish();
+				m_revisionChannel->attachLocalProvider(PYXNETChannelKeyProviderFromLocalStorage::create(m_localStorage));
+			}
+
+			m_bPublished = true;
+		}
+	}
+}
+
+std::string FeaturesSummary::getChannelCode(int revision)
+{
+	if (revision == 0)
+	{
+		return FEATURE_SUMMARY_CHANNEL_ID;
+	}
+	return std::string(FEATURE_SUMMARY_CHANNEL_ID) + ":r" + StringUtils::toString(revision);
+}
+
+int FeaturesSummary::downloadRevision()
+{
+	int revision = 0;
+
+	try
+	{
+		std::auto_ptr<PYXConstWireBuffer> buffer = m_channel->getKey("tree:revision");
+		if (buffer.get() != 0)
+		{
+			(*buffer) >> revision;
+		}
+	}
+	catch(...)
+	{
+		//older publishers don't store a revision, their tree is the first revision.
+		revision = 0;
+	}
+
+	return revision;
+}
+
+void FeaturesSummary::publishRevisionChannel()
+{
+	if (!m_channel || !m_bPublished)
+	{
+		//publishPyxnetChannel will share the current revision
+		if (m_channel)
+		{
+			m_revisionChannel = PYXNETChannelProvider::getInstance()->getOrCreateChannel(ProcRef(getProcID(),getProcVersion()),getChannelCode(m_context->getRevision()));
+		}
+		return;
+	}
+
+	//peers caching the previous revision will find the new revision on their next initialization
+	if (m_revisionChannel)
+	{
+		m_revisionChannel->unpublish();
+	}
+
+	m_revisionChannel = PYXNETChannelProvider::getInstance()->getOrCreateChannel(ProcRef(getProcID(),getProcVersion()),getChannelCode(m_context->getRevision()));
+	m_revisionChannel->publish();
+	m_revisionChannel->attachLocalProvider(PYXNETChannelKeyProviderFromLocalStorage::create(m_localStorage));
+}
+
+void FeaturesSummary::handleInputDataChanged(PYXPointer<NotifierEvent> eventData)
+{
+	PYXPointer<ProcessDataChangedEvent> processDataChangedEvent =
+		boost::dynamic_pointer_cast<ProcessDataChangedEvent>(eventData);
+
+	//new tiles downloaded by the input don't change its features
+	if (processDataChangedEvent->getDataChangeTrigger() == ProcessDataChangedEvent::knInputDataChange)
+	{
+		try
+		{
+			updateFromInput(processDataChangedEvent->getGeometry());
+		}
+		catch(PYXException & ex)
+		{
+			//an interrupted delta leaves the tree marked as not completed, it is generated again on the next initialization
+			TRACE_ERROR("Failed to update features summary for " << getProcName() << ": " << ex.getFullErrorString());
 		}
 	}
+
+	onDataChanged(processDataChangedEvent->getGeometry(),processDataChangedEvent->getDataChangeTrigger());
+}
+
+void FeaturesSummary::updateFromInput(const PYXPointer<PYXGeometry> & geometry)
+{
+	boost::recursive_mutex::scoped_lock lock(m_procMutex);
+
+	//a tree downloaded over pyxnet is updated by its publisher
+	if (m_initState != knInitialized || !m_spInputFC || !m_context)
+	{
+		return;
+	}
+
+	std::vector<boost::intrusive_ptr<IFeature>> features;
+	std::vector<std::string> removedFeatureIds;
+	m_context->findDelta(geometry,features,removedFeatureIds);
+
+	if (features.empty() && removedFeatureIds.empty())
+	{
+		return;
+	}
+
+	TRACE_INFO("updating features summary for " << getProcName() << ": " << features.size() << " features added or modified, " << removedFeatureIds.size() << " removed");
+
+	applyDelta(features,removedFeatureIds);
+}
+
+void FeaturesSummary::applyDelta(const std::vector<boost::intrusive_ptr<IFeature>> & features,const std::vector<std::string> & removedFeatureIds)
+{
+	boost::recursive_mutex::scoped_lock lock(m_procMutex);
+
+	if (m_initState != knInitialized || !m_context)
+	{
+		PYXTHROW(PYXException,"Can't apply a delta to a features summary that is not initialized");
+	}
+
+	m_context->applyDelta(features,removedFeatureIds);
+
+	//drop the groups and histograms cached by the previous root group
+	m_rootGroup = GenericFeaturesGroup::create(m_context);
+
+	m_localStorageBuffered->commit();
+
+	publishRevisionChannel();
+}
+
+int FeaturesSummary::getRevision() const
+{
+	return m_context ? m_context->getRevision() : 0;
 }
 
 /*
@@ -1664,6 +2311,11 @@ boost::intrusive_ptr<GenericFeaturesGroup> FeaturesSummary::Context::getRootGrou
 				versionBuffer << knCurrentVersion;
 				m_storage->set("tree:version",versionBuffer);
 
+				//the peers ask for the revision to find the channel of the current tree
+				PYXStringWireBuffer revisionBuffer;
+				revisionBuffer << 0;
+				m_storage->set("tree:revision",revisionBuffer);
+
 				if (m_fc)
 				{
 					PYXStringWireBuffer completedLocallyBuffer;
@@ -1706,14 +2358,7 @@ boost::intrusive_ptr<GenericFeaturesGroup> FeaturesSummary::Context::getRootGrou
 
 		if (needToGenerateHistograms)
 		{
-			//generate all histograms...
-			int count = rootGroup->getFeatureDefinition()->getFieldCount();
-			
-			for(int i=0;i<count;i++)
-			{
-				TRACE_INFO("Generating histogram (" << (i+1) << " from " << count << ")");
-				rootGroup->getFieldHistogram(i);
-			}
+			generateHistograms(rootGroup);
 		}
 
 		return rootGroup;
@@ -1722,6 +2367,164 @@ boost::intrusive_ptr<GenericFeaturesGroup> FeaturesSummary::Context::getRootGrou
 	PYXTHROW(PYXException,"we should never get here");
 }
 
+void FeaturesSummary::Context::generateHistograms(const boost::intrusive_ptr<GenericFeaturesGroup> & rootGroup) const
+{
+	//generate all histograms...
+	int count = rootGroup->getFeatureDefinition()->getFieldCount();
+
+	for(int i=0;i<count;i++)
+	{
+		TRACE_INFO("Generating histogram (" << (i+1) << " from " << count << ")");
+		rootGroup->getFieldHistogram(i);
+	}
+}
+
+void FeaturesSummary::Context::applyDelta(const std::vector<boost::intrusive_ptr<IFeature>> & features,const std::vector<std::string> & removedFeatureIds)
+{
+	if (!m_fc)
+	{
+		PYXTHROW(PYXException,"Can't apply a delta to a features summary that wasn't generated locally");
+	}
+
+	//make sure the tree was generated before updating it
+	getRootGroup();
+
+	//an interrupted delta would make the tree to be generated again.
+	{
+		PYXStringWireBuffer completedLocallyBuffer;
+		completedLocallyBuffer << 0;
+		m_storage->set("tree:completedLocally",completedLocallyBuffer);
+	}
+
+	try
+	{
+		int fieldCount = m_featureDefinition ? m_featureDefinition->getFieldCount() : 0;
+
+		FeaturesSummaryUpdater updater(m_storage,fieldCount);
+
+		for(auto & featureId : removedFeatureIds)
+		{
+			updater.removeFeature(featureId);
+		}
+
+		//modified features are removed and added again
+		for(auto & feature : features)
+		{
+			updater.removeFeature(feature->getID());
+			updater.addFeature(feature);
+		}
+
+		updater.commit();
+	}
+	catch(PYXException & ex)
+	{
+		PYXTHROW(PYXException,"Failed to apply delta to feature summary due to the following error:" << ex.getFullErrorString());
+	}
+
+	{
+		PYXStringWireBuffer revisionBuffer;
+		revisionBuffer << (getRevision() + 1);
+		m_storage->set("tree:revision",revisionBuffer);
+	}
+
+	{
+		PYXStringWireBuffer completedLocallyBuffer;
+		completedLocallyBuffer << 1;
+		m_storage->set("tree:completedLocally",completedLocallyBuffer);
+	}
+
+	//merge the histograms of the affected groups again
+	generateHistograms(getRootGroup());
+}
+
+//! return true if two features were serialized to the same data
+static bool isSameSerializedFeature(const PYXConstBufferSlice & a,const PYXConstBufferSlice & b)
+{
+	return a.size() == b.size() && (a.size() == 0 || memcmp(a.begin(),b.begin(),a.size()) == 0);
+}
+
+void FeaturesSummary::Context::findDelta(const PYXPointer<PYXGeometry> & geometry,std::vector<boost::intrusive_ptr<IFeature>> & features,std::vector<std::string> & removedFeatureIds) const
+{
+	if (!m_fc)
+	{
+		PYXTHROW(PYXException,"Can't compare a features summary that wasn't generated locally with its input");
+	}
+
+	boost::intrusive_ptr<GenericFeaturesGroup> rootGroup = getRootGroup();
+
+	//the stored features of the area, by id
+	std::map<std::string,PYXPointer<PYXConstBufferSlice>> storedFeatures;
+
+	for(PYXPointer<FeatureIterator> it = geometry ? rootGroup->getIterator(*geometry) : rootGroup->getIterator(); !it->end(); it->next())
+	{
+		boost::intrusive_ptr<IFeature> feature = it->getFeature();
+		storedFeatures[feature->getID()] = GenericFeature::serializeFeature(feature);
+	}
+
+	for(PYXPointer<FeatureIterator> it = geometry ? m_fc->getIterator(*geometry) : m_fc->getIterator(); !it->end(); it->next())
+	{
+		boost::intrusive_ptr<IFeature> feature = it->getFeature();
+		PYXPointer<PYXConstBufferSlice> data = GenericFeature::serializeFeature(feature);
+
+		auto stored = storedFeatures.find(feature->getID());
+		if (stored != storedFeatures.end())
+		{
+			bool modified = !isSameSerializedFeature(*stored->second,*data);
+			storedFeatures.erase(stored);
+
+			if (!modified)
+			{
+				continue;
+			}
+		}
+		else if (geometry)
+		{
+			//the feature can be stored in a group that doesn't intersect the area
+			std::string groupId = getFeatureGroupIdForFeature(feature->getID());
+
+			if (!groupId.empty() &&
+				isSameSerializedFeature(*GenericFeature::serializeFeature(rootGroup->findGroup(groupId)->getFeature(feature->getID())),*data))
+			{
+				continue;
+			}
+		}
+
+		features.push_back(feature);
+	}
+
+	//stored features missing from the input area were removed, or moved out of the area
+	for(auto & stored : storedFeatures)
+	{
+		boost::intrusive_ptr<IFeature> feature;
+		if (geometry)
+		{
+			feature = m_fc->getFeature(stored.first);
+		}
+
+		if (feature)
+		{
+			features.push_back(feature);
+		}
+		else
+		{
+			removedFeatureIds.push_back(stored.first);
+		}
+	}
+}
+
+int FeaturesSummary::Context::getRevision() const
+{
+	int revision = 0;
+
+	boost::scoped_ptr<PYXWireBuffer> revisionBuffer(m_storage->get("tree:revision"));
+	if (revisionBuffer)
+	{
+		(*revisionBuffer) >> revision;
+	}
+
+	return revision;
+}
+
 boost::intrusive_ptr<IFeature> FeaturesSummary::Context::getFeature(const GenericFeaturesGroup & parent, const std::string & featureId) const
 {
 	PYXPointer<GenericFeaturesGroup::NodeData> feature = getChildren(parent)->findFeature(featureId);
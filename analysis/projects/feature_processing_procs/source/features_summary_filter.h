@@ -31,7 +31,7 @@ public:
 	};
 
 public:
-	const static int knCurrentVersion = 4;
+	const static int knCurrentVersion = 5;
 
 public:
 	virtual boost::intrusive_ptr<GenericFeaturesGroup> getRootGroup() const;
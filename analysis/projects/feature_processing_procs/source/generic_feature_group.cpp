@@ -35,6 +35,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/file_utils.h"
 #include "pyxis/data/impl/numeric_histogram_impl.h"
 #include "pyxis/data/impl/string_histogram_impl.h"
+#include "pyxis/data/impl/sketch_histogram_impl.h"
 #include "pyxis/data/feature_iterator_linq.h"
 
 #include "boost/scoped_ptr.hpp"
@@ -460,43 +461,37 @@ public:
 		std::string key = "hist:"+StringUtils::toString(m_fieldIndex)+":"+m_group.getID();
 		boost::scoped_ptr<PYXWireBuffer> dataBuffer(m_storage->get(key));
 
-		boost::scoped_ptr<NumericHistogram<double>> nodeHist(new NumericHistogram<double>());
-
 		if (dataBuffer)
 		{
-			*dataBuffer >> *nodeHist;
-
-			item = PYXNumericHistogram::create(*nodeHist);
-			itemSize = sizeof(NumericHistogram<double>);
+			item = PYXNumericSketchHistogram::create(*dataBuffer);
+			itemSize = sizeof(QuantileSketch);
 		}
 		else
 		{
-			PYXPointer<PYXNumericHistogram> hist = PYXNumericHistogram::create(*nodeHist);
+			PYXPointer<PYXNumericSketchHistogram> hist = PYXNumericSketchHistogram::create();
 
 			m_group.visitFeatures(boost::bind(&NumericHistogramFactory::addFeatureToHistogram,this,_1,boost::ref(hist)));
 			m_group.visitSubGroupsParallel(boost::bind(&NumericHistogramFactory::addGroupHistogram,this,_1,boost::ref(hist)))->join();
 
-			hist->getDoubleHistogram().limit(1000);
-
 			dataBuffer.reset(new PYXStringWireBuffer);
-			*dataBuffer << hist->getDoubleHistogram();
+			hist->serialize(*dataBuffer);
 
 			m_storage->set(key,*dataBuffer);
 
 			item = hist;
-			itemSize = sizeof(NumericHistogram<double>);
+			itemSize = sizeof(QuantileSketch);
 		}
 
 		assert(item->getFeatureCount() == m_group.getFeaturesCount());
 	}
 
 private:
-	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXNumericHistogram> & histogram) const
+	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXNumericSketchHistogram> & histogram) const
 	{
 		histogram->add(feature->getFieldValue(m_fieldIndex));
 	}
 
-	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXNumericHistogram> & histogram) const
+	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXNumericSketchHistogram> & histogram) const
 	{
 		PYXPointer<PYXHistogram> groupHist = group->getFieldHistogram(m_fieldIndex);
 
@@ -534,7 +529,7 @@ public:
 
 	PYXPointer<PYXHistogram> createHistogram(const GenericFeaturesGroup & group) const
 	{
-		PYXPointer<PYXNumericHistogram> hist = PYXNumericHistogram::create(NumericHistogram<double>());
+		PYXPointer<PYXNumericSketchHistogram> hist = PYXNumericSketchHistogram::create();
 
 		//root geometry have invalide geometries
 		if (group.getID() != "")
@@ -556,13 +551,11 @@ public:
 
 		assert(hist->getFeatureCount().max <= group.getFeaturesCount().max);
 
-		hist->getDoubleHistogram().limit(1000);		
-
 		return hist;
 	}
 
 private:
-	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXNumericHistogram> & histogram) const
+	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXNumericSketchHistogram> & histogram) const
 	{
 		if (feature->getGeometry()->intersects(m_geometry))
 		{
@@ -570,7 +563,7 @@ private:
 		}
 	}
 
-	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXNumericHistogram> & histogram) const
+	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXNumericSketchHistogram> & histogram) const
 	{
 		PYXPointer<PYXHistogram> groupHist = createHistogram(*group);
 
@@ -615,38 +608,33 @@ public:
 
 		if (dataBuffer)
 		{
-			StringHistogram stringHist;
-			*dataBuffer >> stringHist;
-
-			item = PYXStringHistogram::create(stringHist);
-			itemSize = sizeof(StringHistogram);
+			item = PYXStringSketchHistogram::create(*dataBuffer);
+			itemSize = sizeof(StringSketch);
 		}
 		else
 		{
-			PYXPointer<PYXStringHistogram> hist = PYXStringHistogram::create();
+			PYXPointer<PYXStringSketchHistogram> hist = PYXStringSketchHistogram::create();
 
 			m_group.visitFeatures(boost::bind(&StringHistogramFactory::addFeatureToHistogram,this,_1,boost::ref(hist)));
 			m_group.visitSubGroupsParallel(boost::bind(&StringHistogramFactory::addGroupHistogram,this,_1,boost::ref(hist)))->join();
 
-			hist->getStringHistogram().limit(4000);
-
 			dataBuffer.reset(new PYXStringWireBuffer);
-			*dataBuffer << hist->getStringHistogram();
+			hist->serialize(*dataBuffer);
 
 			m_storage->set(key,*dataBuffer);
 
 			item = hist;
-			itemSize = sizeof(StringHistogram);
+			itemSize = sizeof(StringSketch);
 		}
 	}
 
 private:
-	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXStringHistogram> & histogram) const
+	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXStringSketchHistogram> & histogram) const
 	{
 		histogram->add(feature->getFieldValue(m_fieldIndex));
 	}
 
-	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXStringHistogram> & histogram) const
+	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXStringSketchHistogram> & histogram) const
 	{
 		PYXPointer<PYXHistogram> groupHist = group->getFieldHistogram(m_fieldIndex);
 
@@ -683,7 +671,7 @@ public:
 
 	PYXPointer<PYXHistogram> createHistogram(const GenericFeaturesGroup & group) const
 	{
-		PYXPointer<PYXStringHistogram> hist = PYXStringHistogram::create();
+		PYXPointer<PYXStringSketchHistogram> hist = PYXStringSketchHistogram::create();
 
 		//root geometry have invalide geometries
 		if (group.getID() != "")
@@ -707,13 +695,11 @@ public:
 		group.visitFeatures(boost::bind(&StringHistogramSpatialFactory::addFeatureToHistogram,this,_1,boost::ref(hist)),m_geometry);
 		group.visitSubGroupsParallel(boost::bind(&StringHistogramSpatialFactory::addGroupHistogram,this,_1,boost::ref(hist)),m_geometry)->join();
 
-		hist->getStringHistogram().limit(4000);
-
 		return hist;
 	}
 
 private:
-	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXStringHistogram> & histogram) const
+	void addFeatureToHistogram(const boost::intrusive_ptr<IFeature> & feature,const PYXPointer<PYXStringSketchHistogram> & histogram) const
 	{
 		if (feature->getGeometry()->intersects(m_geometry))
 		{
@@ -721,7 +707,7 @@ private:
 		}
 	}
 
-	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXStringHistogram> & histogram) const
+	void addGroupHistogram(const boost::intrusive_ptr<GenericFeaturesGroup> & group,const PYXPointer<PYXStringSketchHistogram> & histogram) const
 	{
 		PYXPointer<PYXHistogram> groupHist = createHistogram(*group);
 
@@ -14,10 +14,16 @@ web			: www.pyxisinnovation.com
 #include "pyxis/procs/default_feature.h"
 #include "pyxis/pipe/process_local_storage.h"
 #include "pyxis/pipe/pipe_utils.h"
-#include "pyxis/data/feature_iterator_linq.h"
+#include "pyxis/geometry/cell.h"
+#include "pyxis/geometry/geometry_serializer.h"
 #include "pyxis/geometry/tile_collection.h"
+#include "pyxis/derm/exhaustive_iterator.h"
+#include "pyxis/utility/thread_pool.h"
 #include "boost/bind.hpp"
 
+#include <algorithm>
+#include <list>
+
 
 // {11E2EBE8-71D3-4D9B-B01A-308BFBB76F71}
 PYXCOM_DEFINE_CLSID(GeotagRecordCollection, 
@@ -38,10 +44,52 @@ namespace
 //! Tester class
 Tester<GeotagRecordCollection> gTester;
 
+//! The version of the saved geometry cache.
+const int knGeometryCacheVersion = 1;
+
+//! The number of records geotagged by a single task.
+const int knGeotagBatchSize = 256;
+
+//! A batch of records to geotag.
+struct GeotagBatch
+{
+	std::vector<boost::intrusive_ptr<IRecord>> records;
+	std::vector<PYXPointer<PYXGeometry>> geometries;
+};
+
+void geotagBatch(const boost::intrusive_ptr<IGeometryProvider> & geometryProvider,GeotagBatch * batch)
+{
+	batch->geometries.reserve(batch->records.size());
+	for (auto & record : batch->records)
+	{
+		batch->geometries.push_back(geometryProvider->getGeometry(record));
+	}
+
+	//release the records as soon as possible
+	batch->records.clear();
+}
+
+//! Collect the indices visited in a spatial set.
+class IndexCollector
+{
+public:
+	std::vector<int> & indices;
+
+	explicit IndexCollector(std::vector<int> & indices) : indices(indices)
+	{
+	}
+
+	void operator()(int index)
+	{
+		indices.push_back(index);
+	}
+};
+
 }
 
 //! Constructor
-GeotagRecordCollection::GeotagRecordCollection()
+GeotagRecordCollection::GeotagRecordCollection() :
+	m_bTaggedRecordsLoaded(false)
 {
 }
 
@@ -52,6 +100,66 @@ GeotagRecordCollection::~GeotagRecordCollection()
 
 void GeotagRecordCollection::test()
 {
+	//every third record is not tagged
+	std::vector<PYXPointer<PYXGeometry>> geometries;
+	for (PYXExhaustiveIterator it(PYXIcosIndex("A-0"),6); !it.end(); it.next())
+	{
+		if (geometries.size() % 3 == 2)
+		{
+			geometries.push_back(PYXPointer<PYXGeometry>());
+		}
+		else
+		{
+			geometries.push_back(PYXCell::create(it.getIndex()));
+		}
+	}
+	const int nRecords = static_cast<int>(geometries.size());
+	std::vector<PYXPointer<PYXGeometry>> expectedGeometries = geometries;
+
+	PYXPointer<GeometryCache> cache = GeometryCache::create(geometries);
+	TEST_ASSERT_EQUAL(cache->getRecordCount(),nRecords);
+
+	//the saved cache gives the same answers
+	PYXStringWireBuffer buffer;
+	cache->save(buffer);
+	buffer.setPos(0);
+	PYXPointer<GeometryCache> loadedCache = GeometryCache::create(buffer);
+	TEST_ASSERT(loadedCache);
+	TEST_ASSERT_EQUAL(loadedCache->getRecordCount(),nRecords);
+
+	const char * queries[] = { "A-0", "A-01", "A-030", "A-0402", "B-0" };
+	for (auto & query : queries)
+	{
+		PYXCell queryCell = PYXCell(PYXIcosIndex(query));
+
+		std::vector<int> expected;
+		for (int i = 0; i < nRecords; ++i)
+		{
+			if (expectedGeometries[i] && queryCell.intersects(*expectedGeometries[i]))
+			{
+				expected.push_back(i);
+			}
+		}
+
+		//the candidates are a superset of the intersecting records
+		std::vector<int> candidates = loadedCache->findCandidates(queryCell.getBoundingCircle());
+		TEST_ASSERT(std::is_sorted(candidates.begin(),candidates.end()));
+		TEST_ASSERT(std::includes(candidates.begin(),candidates.end(),expected.begin(),expected.end()));
+		for (auto & candidate : candidates)
+		{
+			TEST_ASSERT(loadedCache->getGeometry(candidate));
+		}
+
+		std::vector<int> intersecting;
+		for (auto & candidate : candidates)
+		{
+			if (queryCell.intersects(*loadedCache->getGeometry(candidate)))
+			{
+				intersecting.push_back(candidate);
+			}
+		}
+		TEST_ASSERT(intersecting == expected);
+	}
 }
 
 
@@ -87,6 +195,30 @@ IProcess::eInitStatus GeotagRecordCollection::initImpl()
 	PipeUtils::waitUntilPipelineIdentityStable(this);
 	PYXPointer<PYXLocalStorage> storage = PYXProcessLocalStorage::create(this);
 
+	//the geometries of the records are stored by the pipeline identity, so they are geotagged again when the inputs change
+	auto geometriesBuffer = storage->get("geotag:geometries");
+	m_geometryCache.reset();
+
+	{
+		boost::mutex::scoped_lock lock(m_taggedRecordsMutex);
+		m_taggedRecords.clear();
+		m_bTaggedRecordsLoaded = false;
+	}
+
+	if (geometriesBuffer.get()!=NULL)
+	{
+		m_geometryCache = GeometryCache::create(*geometriesBuffer);
+	}
+
+	if (!m_geometryCache)
+	{
+		m_geometryCache = geotagRecords();
+
+		PYXStringWireBuffer cacheBuffer;
+		m_geometryCache->save(cacheBuffer);
+		storage->set("geotag:geometries",cacheBuffer);
+	}
+
 	auto buffer = storage->get("geometry");
 
 	if (buffer.get()!=NULL)
@@ -146,31 +278,20 @@ IProcess::eInitStatus GeotagRecordCollection::initImpl()
 // IFeatureCollection
 ////////////////////////////////////////////////////////////////////////////////
 
-bool goemetryNotNull (const boost::intrusive_ptr<IFeature> & feature)
-{
-	return feature->getGeometry();
-}
-bool goemetryIntersects (const boost::intrusive_ptr<IFeature> & feature, PYXPointer<PYXGeometry> geometry)
-{
-	return goemetryNotNull(feature) && geometry->intersects(*feature->getGeometry());
-}
-
 //! Get an iterator to all the features in this collection.
 PYXPointer<FeatureIterator> GeotagRecordCollection::getIterator() const
 {
-	//Filter the null geometries.
-	return PYXFeatureIteratorLinq(Iterator::create(m_inputRC,m_geometryProvider)).filter(boost::bind(goemetryNotNull,_1)) ;
+	//the records without a geometry are skipped.
+	return Iterator::create(m_inputRC,m_geometryCache);
 }
 
 //! Get an iterator to all the features in this collection that intersect this geometry.
 PYXPointer<FeatureIterator> GeotagRecordCollection::getIterator(const PYXGeometry& geometry) const
 {
-	//filter null goemetries and geometries that do not intersect
-	return PYXFeatureIteratorLinq(Iterator::create(m_inputRC,m_geometryProvider)).filter(boost::bind(goemetryIntersects,_1,geometry.clone())) ;
+	//only the records found in the spatial index are tested for intersection
+	return Iterator::create(m_inputRC,m_geometryCache,geometry.clone());
 }
 
-
-
 //! Get styles that determine how to visualize features in this collection.
 std::vector<FeatureStyle> GeotagRecordCollection::getFeatureStyles() const
 {
@@ -180,18 +301,23 @@ std::vector<FeatureStyle> GeotagRecordCollection::getFeatureStyles() const
 //! Get the feature with the specified ID.
 boost::intrusive_ptr<IFeature> GeotagRecordCollection::getFeature(const std::string& strFeatureID) const
 {
-	auto it = getIterator();
-	
-	while (!it->end())
+	//the feature ID is the position of the record
+	int nRecord = StringUtils::fromString<int>(strFeatureID);
+	if (StringUtils::toString(nRecord) != strFeatureID ||
+		nRecord < 0 || nRecord >= m_geometryCache->getRecordCount() ||
+		!m_geometryCache->getGeometry(nRecord))
 	{
-		if (it->getFeature()->getID() == strFeatureID)
-		{
-			return it->getFeature();
-		}
-		it->next();
+		return 0;
 	}
 
-	return 0;
+	auto record = getTaggedRecord(nRecord);
+	if (!record)
+	{
+		return 0;
+	}
+
+	auto geometry = m_geometryCache->getGeometry(nRecord);
+	return Feature::create(record, geometry, strFeatureID);
 }
 
 //! Get the feature definition.
@@ -212,31 +338,208 @@ bool GeotagRecordCollection::canRasterize() const
 }
 
 
+////////////////////////////////////////////////////////////////////////////
+// GeotagRecordCollection::GeometryCache
+////////////////////////////////////////////////////////////////////////////
+
+PYXPointer<GeotagRecordCollection::GeometryCache> GeotagRecordCollection::geotagRecords() const
+{
+	//the records are read in order and geotagged in batches on the thread pool
+	std::list<GeotagBatch> batches;
+	{
+		PYXTaskGroup tasks;
+		for (auto it = m_inputRC->getIterator(); !it->end(); it->next())
+		{
+			if (batches.empty() || static_cast<int>(batches.back().records.size()) == knGeotagBatchSize)
+			{
+				if (!batches.empty())
+				{
+					tasks.addTask(boost::bind(geotagBatch,m_geometryProvider,&batches.back()));
+				}
+				batches.push_back(GeotagBatch());
+			}
+			batches.back().records.push_back(it->getRecord());
+		}
+		if (!batches.empty())
+		{
+			tasks.addTask(boost::bind(geotagBatch,m_geometryProvider,&batches.back()));
+		}
+		tasks.joinAll();
+	}
+
+	std::vector<PYXPointer<PYXGeometry>> geometries;
+	for (auto & batch : batches)
+	{
+		geometries.insert(geometries.end(),batch.geometries.begin(),batch.geometries.end());
+	}
+
+	return GeometryCache::create(geometries);
+}
+
+boost::intrusive_ptr<IRecord> GeotagRecordCollection::getTaggedRecord(int nRecord) const
+{
+	boost::mutex::scoped_lock lock(m_taggedRecordsMutex);
+
+	if (!m_bTaggedRecordsLoaded)
+	{
+		m_taggedRecords.resize(m_geometryCache->getRecordCount());
+
+		int nPosition = 0;
+		for (auto it = m_inputRC->getIterator(); !it->end() && nPosition < m_geometryCache->getRecordCount(); it->next(), ++nPosition)
+		{
+			if (m_geometryCache->getGeometry(nPosition))
+			{
+				m_taggedRecords[nPosition] = it->getRecord();
+			}
+		}
+		m_bTaggedRecordsLoaded = true;
+	}
+
+	return m_taggedRecords[nRecord];
+}
+
+GeotagRecordCollection::GeometryCache::GeometryCache(std::vector<PYXPointer<PYXGeometry>> & geometries)
+{
+	m_geometries.swap(geometries);
+
+	std::vector<PYXBoundingCircle> circles;
+	std::vector<PYXPointer<PYXGeometry>> values;
+	for (int i = 0; i < static_cast<int>(m_geometries.size()); ++i)
+	{
+		if (m_geometries[i])
+		{
+			m_taggedRecords.push_back(i);
+			circles.push_back(m_geometries[i]->getBoundingCircle());
+			values.push_back(m_geometries[i]);
+		}
+	}
+
+	m_spatialIndex = PYXStaticBoundingCircleSpatialSet<PYXGeometry>::create(circles,values);
+}
+
+PYXPointer<GeotagRecordCollection::GeometryCache> GeotagRecordCollection::GeometryCache::create(PYXWireBuffer & buffer)
+{
+	int nVersion = 0;
+	buffer >> nVersion;
+	if (nVersion != knGeometryCacheVersion)
+	{
+		return PYXPointer<GeometryCache>();
+	}
+
+	PYXPointer<GeometryCache> cache = PYXNEW(GeometryCache);
+
+	int nRecords = 0;
+	buffer >> nRecords;
+	cache->m_geometries.resize(nRecords);
+
+	std::vector<PYXPointer<PYXGeometry>> values;
+	for (int i = 0; i < nRecords; ++i)
+	{
+		unsigned char hasGeometry = 0;
+		buffer >> hasGeometry;
+		if (hasGeometry)
+		{
+			buffer >> cache->m_geometries[i];
+			cache->m_taggedRecords.push_back(i);
+			values.push_back(cache->m_geometries[i]);
+		}
+	}
+
+	cache->m_spatialIndex = PYXStaticBoundingCircleSpatialSet<PYXGeometry>::create(buffer,values);
+	return cache;
+}
+
+void GeotagRecordCollection::GeometryCache::save(PYXWireBuffer & buffer) const
+{
+	buffer << knGeometryCacheVersion;
+	buffer << static_cast<int>(m_geometries.size());
+	for (auto & geometry : m_geometries)
+	{
+		if (geometry)
+		{
+			buffer << static_cast<unsigned char>(1) << *geometry;
+		}
+		else
+		{
+			buffer << static_cast<unsigned char>(0);
+		}
+	}
+
+	m_spatialIndex->save(buffer);
+}
+
+std::vector<int> GeotagRecordCollection::GeometryCache::findCandidates(const PYXBoundingCircle & circle) const
+{
+	std::vector<int> indices;
+	IndexCollector collector(indices);
+	m_spatialIndex->visitIndices(circle,collector);
+
+	std::vector<int> records;
+	records.reserve(indices.size());
+	for (auto & index : indices)
+	{
+		records.push_back(m_taggedRecords[index]);
+	}
+	std::sort(records.begin(),records.end());
+	return records;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // GeotagRecordCollection::Iterator
 ////////////////////////////////////////////////////////////////////////////
 
 GeotagRecordCollection::Iterator::Iterator(const boost::intrusive_ptr<IRecordCollection> & inputs,
-											const boost::intrusive_ptr<IGeometryProvider> & geometryProvider) 
-	: m_geometryProvider(geometryProvider), m_currentID(0)
+											const PYXPointer<GeometryCache> & geometryCache,
+											const PYXPointer<PYXGeometry> & spGeometry) 
+	: m_recordPosition(0), m_currentID(-1), m_geometryCache(geometryCache), m_spGeometry(spGeometry), m_nextCandidate(0)
 {
 	m_recordIterator = inputs->getIterator();
+
+	if (m_spGeometry)
+	{
+		m_candidates = m_geometryCache->findCandidates(m_spGeometry->getBoundingCircle());
+	}
+
+	findNext();
 }
 
+void GeotagRecordCollection::Iterator::findNext()
+{
+	m_currentFeature.reset();
+
+	if (!m_spGeometry)
+	{
+		//the next record with a geometry
+		do
+		{
+			++m_currentID;
+		}
+		while (m_currentID < m_geometryCache->getRecordCount() && !m_geometryCache->getGeometry(m_currentID));
+		return;
+	}
+
+	//the next candidate that really intersects
+	while (m_nextCandidate < m_candidates.size())
+	{
+		m_currentID = m_candidates[m_nextCandidate++];
+		if (m_spGeometry->intersects(*m_geometryCache->getGeometry(m_currentID)))
+		{
+			return;
+		}
+	}
+	m_currentID = m_geometryCache->getRecordCount();
+}
 
 bool GeotagRecordCollection::Iterator::end() const
 {
-	return m_recordIterator->end();
+	return m_currentID >= m_geometryCache->getRecordCount();
 }
 
 void GeotagRecordCollection::Iterator::next()
 {
-	m_currentFeature.reset();
-
-	if(!m_recordIterator->end())
+	if (!end())
 	{
-		m_recordIterator->next();
-		m_currentID++;
+		findNext();
 	}
 }
 
@@ -244,8 +547,18 @@ boost::intrusive_ptr<IFeature> GeotagRecordCollection::Iterator::getFeature() co
 {
 	if (!m_currentFeature && !end())
 	{
-		auto geometry =	m_geometryProvider->getGeometry(m_recordIterator->getRecord());
-		m_currentFeature = Feature::create(m_recordIterator->getRecord(), geometry, StringUtils::toString(m_currentID));
+		//skip the records without a geometry (or not intersecting) without reading them
+		while (m_recordPosition < m_currentID && !m_recordIterator->end())
+		{
+			m_recordIterator->next();
+			++m_recordPosition;
+		}
+
+		if (!m_recordIterator->end())
+		{
+			auto geometry = m_geometryCache->getGeometry(m_currentID);
+			m_currentFeature = Feature::create(m_recordIterator->getRecord(), geometry, StringUtils::toString(m_currentID));
+		}
 	}
 	return m_currentFeature;
-}
\ No newline at end of file
+}
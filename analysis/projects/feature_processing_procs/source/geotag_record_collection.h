@@ -17,6 +17,10 @@ web			: www.pyxisinnovation.com
 #include "pyxis/data/feature_collection.h"
 #include "pyxis/data/record_collection.h"
 #include "pyxis/procs/geometry_provider.h"
+#include "pyxis/utility/bounding_circle_spatial_set.h"
+
+// boost includes
+#include <boost/thread/mutex.hpp>
 
 /*!
 Inputs: Geometry Provider, collection of data records
@@ -145,19 +149,89 @@ public:
 private:
 	typedef std::vector<boost::intrusive_ptr<IFeatureCollection>> FeatureCollectionVector;
 
+private:
+	/*!
+	The geometries of the records, by record position (the feature ID), built once
+	and indexed by a sphere tree for the geometry filtered iterators.
+	*/
+	class GeometryCache : public PYXObject
+	{
+	public:
+		//! Create a cache from the geometries of all the records (null for an untagged record).
+		static PYXPointer<GeometryCache> create(std::vector<PYXPointer<PYXGeometry>> & geometries)
+		{
+			return PYXNEW(GeometryCache,geometries);
+		}
+
+		//! Load a cache saved with save(), return null if the format has changed.
+		static PYXPointer<GeometryCache> create(PYXWireBuffer & buffer);
+
+		//! Save the geometries and the spatial index.
+		void save(PYXWireBuffer & buffer) const;
+
+		//! The number of records.
+		int getRecordCount() const
+		{
+			return static_cast<int>(m_geometries.size());
+		}
+
+		//! The geometry of a record, null if the record has no geometry.
+		const PYXPointer<PYXGeometry> & getGeometry(int nRecord) const
+		{
+			return m_geometries[nRecord];
+		}
+
+		//! The records whose geometry bounding circle intersects a circle, in record order.
+		std::vector<int> findCandidates(const PYXBoundingCircle & circle) const;
+
+	public:
+		explicit GeometryCache(std::vector<PYXPointer<PYXGeometry>> & geometries);
+
+		GeometryCache()
+		{
+		}
+
+	private:
+		void createSpatialIndex();
+
+	private:
+		//! The geometry of every record.
+		std::vector<PYXPointer<PYXGeometry>> m_geometries;
+
+		//! The records with a geometry, in the order of the spatial index values.
+		std::vector<int> m_taggedRecords;
+
+		PYXPointer<PYXStaticBoundingCircleSpatialSet<PYXGeometry>> m_spatialIndex;
+	};
+
+	//! Geotag all the input records, in parallel.
+	PYXPointer<GeometryCache> geotagRecords() const;
+
+	/*!
+	The input record at a position, null if the record has no geometry. The tagged
+	records are read in a single pass on the first call, since getRecord of many
+	record collections (CSV, Excel) scans the collection from the start.
+	*/
+	boost::intrusive_ptr<IRecord> getTaggedRecord(int nRecord) const;
+
 private:
 	class Iterator : public FeatureIterator
 	{
 	public:
 		static PYXPointer<FeatureIterator> create(const boost::intrusive_ptr<IRecordCollection> & inputs,
-			const boost::intrusive_ptr<IGeometryProvider> & geometryProvider)
+			const PYXPointer<GeometryCache> & geometryCache,
+			const PYXPointer<PYXGeometry> & spGeometry = PYXPointer<PYXGeometry>())
 		{
-			return PYXNEW(Iterator,inputs,geometryProvider);
+			return PYXNEW(Iterator,inputs,geometryCache,spGeometry);
 		}
 
 	private:
 		Iterator(const boost::intrusive_ptr<IRecordCollection> & inputs, 
-			const boost::intrusive_ptr<IGeometryProvider> & geometryProvider);
+			const PYXPointer<GeometryCache> & geometryCache,
+			const PYXPointer<PYXGeometry> & spGeometry);
+
+		//! Move to the next record with a geometry (that intersects the geometry of the iterator).
+		void findNext();
 
 	public:
 		virtual bool end() const;
@@ -167,10 +241,16 @@ private:
 		virtual boost::intrusive_ptr<IFeature> getFeature() const;
 
 	private:
-		PYXPointer<RecordIterator> m_recordIterator;
+		mutable PYXPointer<RecordIterator> m_recordIterator;
+		mutable int m_recordPosition;
 		mutable PYXPointer<IFeature> m_currentFeature;
 		int m_currentID;
-		boost::intrusive_ptr<IGeometryProvider> m_geometryProvider;
+		PYXPointer<GeometryCache> m_geometryCache;
+
+		//! The geometry to intersect, null to iterate over all the records with a geometry.
+		PYXPointer<PYXGeometry> m_spGeometry;
+		std::vector<int> m_candidates;
+		unsigned int m_nextCandidate;
 	};
 
 	class Feature : public IFeature
@@ -240,6 +320,12 @@ private:
 	PYXPointer<PYXTableDefinition> m_featuresDefinition;
 	boost::intrusive_ptr<IRecordCollection> m_inputRC;
 	boost::intrusive_ptr<IGeometryProvider> m_geometryProvider;
+	PYXPointer<GeometryCache> m_geometryCache;
+
+	//! The input records with a geometry, by position (see getTaggedRecord).
+	mutable std::vector<boost::intrusive_ptr<IRecord>> m_taggedRecords;
+	mutable bool m_bTaggedRecordsLoaded;
+	mutable boost::mutex m_taggedRecordsMutex;
 };
 
 #endif
@@ -147,7 +147,7 @@ private:
 	class Context : public GenericFeaturesGroup::ContextWithHistograms
 	{
 	public:
-		const static int knCurrentVersion = 4;
+		const static int knCurrentVersion = 5;
 
 	public:
 		virtual boost::intrusive_ptr<GenericFeaturesGroup> getRootGroup() const;
@@ -16,13 +16,20 @@ web			: www.pyxisinnovation.com
 #include "pyxis/derm/iterator.h"
 #include "pyxis/derm/sub_index.h"
 #include "pyxis/derm/sub_index_math.h"
+#include "pyxis/derm/snyder_projection.h"
 #include "pyxis/derm/vertex_iterator.h"
 #include "pyxis/geometry/cell.h"
 #include "pyxis/geometry/tile.h"
+#include "pyxis/data/pyx_feature.h"
 #include "pyxis/procs/exceptions.h"
 #include "pyxis/procs/default_feature.h"
 #include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/profile.h"
 #include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+#include <algorithm>
+#include <cstdlib>
 
 // {EE604B45-F5AD-4290-8B66-31551BF2C8E1}
 PYXCOM_DEFINE_CLSID(PointAggregatorProcess, 
@@ -104,9 +111,11 @@ void PointAggregatorProcess::test()
 	{ //Test Aggregation from Res 6 to Res 5. 
 		PYXTile tile (PYXIcosIndex("H-000"), 6); 
 		boost::intrusive_ptr<DefaultFeatureCollection> spFC (new DefaultFeatureCollection());
+		int nFeatureCount = 0;
 		for (PYXPointer<PYXIterator> it = tile.getIterator(); !it->end(); it->next())
 		{
 			spFC->addFeature(new DefaultFeature(PYXCell::create(it->getIndex())));
+			++nFeatureCount;
 		}
 
 		boost::intrusive_ptr<PointAggregatorProcess> spAggregator (new PointAggregatorProcess());
@@ -139,12 +148,208 @@ void PointAggregatorProcess::test()
 				spDefaultFeatIt->next();
 			}
 		}
+
+		//the aggregated features are found by id and by statistics.
+		boost::intrusive_ptr<IFeature> spAggregated = spAggregator->getFeature("H-0000");
+		TEST_ASSERT(spAggregated && spAggregated->getID() == "H-0000");
+		TEST_ASSERT(!spAggregator->getFeature("H-000"));
+		TEST_ASSERT(!spAggregator->getFeature("not an index"));
+
+		int nCount = 0;
+		PYXCoord3DDouble centroid;
+		TEST_ASSERT(spAggregator->getCellStatistics(PYXIcosIndex("H-000"), nCount, centroid));
+		TEST_ASSERT(nCount == nFeatureCount);
 	}
 
+	{ //co-located features are chained in the cell of their index instead of refining the pyramid.
+		CoordLatLon ll;
+		ll.setInDegrees(45, -75);
+
+		PYXIcosIndex index;
+		SnyderProjection::getInstance()->nativeToPYXIS(ll, &index, 20);
+
+		boost::intrusive_ptr<DefaultFeatureCollection> spFC (new DefaultFeatureCollection());
+		for (int n = 0; n < 50; ++n)
+		{
+			spFC->addFeature(new DefaultFeature(PYXCell::create(index)));
+		}
+
+		//a finer feature off the centroid children of the cell refines it.
+		PYXIcosIndex centroid = index;
+		centroid.setResolution(22);
 
+		PYXIcosIndex finer;
+		for (PYXPointer<PYXIterator> it = PYXTile(index, 22).getIterator(); finer.isNull(); it->next())
+		{
+			if (!(it->getIndex() == centroid))
+			{
+				finer = it->getIndex();
+			}
+		}
+		spFC->addFeature(new DefaultFeature(PYXCell::create(finer)));
+
+		boost::intrusive_ptr<PointAggregatorProcess> spAggregator (new PointAggregatorProcess());
+
+		boost::intrusive_ptr<IProcess> spProc;
+		spFC->QueryInterface(IProcess::iid, (void**) &spProc);
+
+		spAggregator->getParameter(0)->addValue(spProc);
+		spAggregator->initProc();
+		spAggregator->m_nAggregatedResolution = 30;
+
+		int nAggregatedCount = 0;
+		int nMemberCount = 0;
+		for (PYXPointer<FeatureIterator> spFeatIt = spAggregator->getIterator(); !spFeatIt->end(); spFeatIt->next())
+		{
+			boost::intrusive_ptr<IFeatureCollection> spAggregFC;
+			spFeatIt->getFeature()->QueryInterface(IFeatureCollection::iid, (void**) &spAggregFC);
+			for (PYXPointer<FeatureIterator> spIt = spAggregFC->getIterator(); !spIt->end(); spIt->next())
+			{
+				++nMemberCount;
+			}
+			++nAggregatedCount;
+		}
+		TEST_ASSERT(nAggregatedCount == 2);
+		TEST_ASSERT(nMemberCount == 51);
+
+		//the pyramid stops at the resolution of the finest feature.
+		TEST_ASSERT(spAggregator->m_vecPyramid[23].empty());
+
+		int nCount = 0;
+		PYXCoord3DDouble location;
+		TEST_ASSERT(spAggregator->getCellStatistics(index, nCount, location));
+		TEST_ASSERT(nCount == 51);
+		TEST_ASSERT(spAggregator->getCellStatistics(centroid, nCount, location));
+		TEST_ASSERT(nCount == 50);
+
+		//changing the aggregate resolution initializes the process again, but the input isn't read again.
+		std::map<std::string, std::string> mapAttr;
+		mapAttr["AggregatedResolution"] = "18";
+		spAggregator->setAttributes(mapAttr);
+		spAggregator->initProc();
+		TEST_ASSERT(spAggregator->m_bIsAggregated);
+
+		PYXPointer<FeatureIterator> spFeatureIt = spAggregator->getIterator();
+		TEST_ASSERT(!spFeatureIt->end());
+		TEST_ASSERT(spFeatureIt->getFeature()->getID() == spAggregator->getFeature(spFeatureIt->getFeature()->getID())->getID());
+		spFeatureIt->next();
+		TEST_ASSERT(spFeatureIt->end());
+	}
+
+	//the benchmark profiles a million points, it runs on fewer points as a test.
+	benchmark(10000);
+}
+
+void PointAggregatorProcess::benchmark(int nFeatureCount)
+{
+	const int nFeatureResolution = 20;
+
+	boost::intrusive_ptr<DefaultFeatureCollection> spFC (new DefaultFeatureCollection());
+	PYXPointer<PYXTableDefinition> spDefn = PYXTableDefinition::create();
+
+	srand(1);
+	for (int n = 0; n < nFeatureCount; ++n)
+	{
+		CoordLatLon ll;
+		ll.setInDegrees(180.0 * rand() / RAND_MAX - 90, 360.0 * rand() / RAND_MAX - 180);
+
+		PYXIcosIndex index;
+		SnyderProjection::getInstance()->nativeToPYXIS(ll, &index, nFeatureResolution);
+		spFC->addFeature(new PYXFeature(PYXCell::create(index), intToString(n, 0), "", false, spDefn));
+	}
+
+	boost::intrusive_ptr<PointAggregatorProcess> spAggregator (new PointAggregatorProcess());
+
+	boost::intrusive_ptr<IProcess> spProc;
+	spFC->QueryInterface(IProcess::iid, (void**) &spProc);
+
+	spAggregator->getParameter(0)->addValue(spProc);
+	spAggregator->initProc();
+	spAggregator->m_nAggregatedResolution = 5;
+
+	PYXHighQualityTimer timer;
+	timer.start();
+	PYXPointer<FeatureIterator> spFeatureIt = spAggregator->getIterator();
+	timer.stop();
+	double fBuildTime = timer.getTime();
+
+	int nAggregatedCount = 0;
+	int nMemberCount = 0;
+	for (; !spFeatureIt->end(); spFeatureIt->next())
+	{
+		boost::intrusive_ptr<IFeatureCollection> spAggregFC;
+		spFeatureIt->getFeature()->QueryInterface(IFeatureCollection::iid, (void**) &spAggregFC);
+		for (PYXPointer<FeatureIterator> spIt = spAggregFC->getIterator(); !spIt->end(); spIt->next())
+		{
+			++nMemberCount;
+		}
+		++nAggregatedCount;
+	}
+	TEST_ASSERT(nMemberCount == nFeatureCount);
+
+	int nTotalCount = 0;
+	for (int nPrimary = 1; nPrimary <= 12; ++nPrimary)
+	{
+		int nCount = 0;
+		PYXCoord3DDouble centroid;
+		if (spAggregator->getCellStatistics(PYXIcosIndex(intToString(nPrimary, 0)), nCount, centroid))
+		{
+			nTotalCount += nCount;
+		}
+	}
+	for (char cPrimary = 'A'; cPrimary <= 'T'; ++cPrimary)
+	{
+		int nCount = 0;
+		PYXCoord3DDouble centroid;
+		if (spAggregator->getCellStatistics(PYXIcosIndex(std::string(1, cPrimary)), nCount, centroid))
+		{
+			nTotalCount += nCount;
+		}
+	}
+	TEST_ASSERT(nTotalCount == nFeatureCount);
+
+	//zooming in and out changes the aggregate resolution and reads the pyramid, not the input.
+	PYXIcosIndex root("A-0");
+	int nRootCount = 0;
+	PYXCoord3DDouble rootCentroid;
+	spAggregator->getCellStatistics(root, nRootCount, rootCentroid);
+
+	const int nZoomCount = 10;
+	int nZoomMemberCount = 0;
+	timer.start();
+	for (int nZoom = 0; nZoom < nZoomCount; ++nZoom)
+	{
+		//the aggregate resolution is 7 resolutions coarser than the viewed tile.
+		const int nResolution = 5 + (nZoom % 2 == 0 ? nZoom / 2 : 9 - nZoom / 2);
+		PYXTile zoomTile(root, nResolution + 7);
+
+		PYXPointer<FeatureIterator> spZoomIt = spAggregator->getIterator(zoomTile);
+		TEST_ASSERT(spAggregator->m_nAggregatedResolution == nResolution);
+
+		//the aggregated cells intersecting the tile hold all the features of the tile.
+		int nTileMemberCount = 0;
+		for (; !spZoomIt->end(); spZoomIt->next())
+		{
+			boost::intrusive_ptr<IFeatureCollection> spAggregFC;
+			spZoomIt->getFeature()->QueryInterface(IFeatureCollection::iid, (void**) &spAggregFC);
+			for (PYXPointer<FeatureIterator> spIt = spAggregFC->getIterator(); !spIt->end(); spIt->next())
+			{
+				++nTileMemberCount;
+			}
+		}
+		TEST_ASSERT(nTileMemberCount >= nRootCount);
+		nZoomMemberCount += nTileMemberCount;
+	}
+	timer.stop();
+	double fZoomTime = timer.getTime();
+
+	TEST_ASSERT(spAggregator->m_bIsAggregated);
+
+	TRACE_INFO("PointAggregatorProcess: " << nFeatureCount << " points aggregated into " << nAggregatedCount << 
+		" features in " << fBuildTime << "[sec], " << nZoomCount << " zoom changes (" << nZoomMemberCount << 
+		" features) in " << fZoomTime << "[sec]");
 }
 
- 
 AggregatedPointFeature::AggregatedPointFeature()
 {
 	m_spDefn = PYXTableDefinition::create();
@@ -164,6 +369,11 @@ void AggregatedPointFeature::addFeature(boost::intrusive_ptr<IFeature> spFeature
 	calcMetaData();
 }
 
+void AggregatedPointFeature::addFeatures(const std::vector<boost::intrusive_ptr<IFeature> >& vecFeatures)
+{
+	m_vecFeatures.insert(m_vecFeatures.end(), vecFeatures.begin(), vecFeatures.end());
+	calcMetaData();
+}
 
  bool AggregatedPointFeature::isWritable() const
  {
@@ -172,10 +382,10 @@ void AggregatedPointFeature::addFeature(boost::intrusive_ptr<IFeature> spFeature
 
 const std::string& AggregatedPointFeature::getID() const
 {
-	for (std::vector<boost::intrusive_ptr<IFeature> >::const_iterator it = m_vecFeatures.begin();
-		it != m_vecFeatures.end(); ++it)
+	//the aggregated feature is identified by its cell
+	if (m_strID.empty() && m_spGeom)
 	{
-		m_strID = m_strID + (*it)->getID();
+		m_strID = m_spGeom->getIterator()->getIndex().toString();
 	}
 	return m_strID;
 }
@@ -265,13 +475,15 @@ PYXPointer<FeatureIterator> AggregatedPointFeature::getIterator(const PYXGeometr
 	return PointAggregatorFeatureCollectionIterator::create(vecFeatureSet);
 }
 
-PointAggregatorProcess::PointAggregatorProcess() : m_nAggregatedResolution(15)
+PointAggregatorProcess::PointAggregatorProcess() :
+	m_bIsAggregated(false),
+	m_nAggregatedResolution(15),
+	m_nCachedResolution(-1)
 {
 }
 
 IProcess::eInitStatus PointAggregatorProcess::initImpl()
 {
-	m_bIsAggregated = false;
 	m_spGeom = PYXMultiCell::create();
 	m_strId = procRefToStr(ProcRef(this));
 
@@ -300,8 +512,16 @@ IProcess::eInitStatus PointAggregatorProcess::initImpl()
 			return knFailedToInit;
 		}
 
-		m_spInputFeatureCollection = spInputProc->getOutput()->QueryInterface<IFeatureCollection>();
-		assert(m_spInputFeatureCollection);
+		boost::intrusive_ptr<IFeatureCollection> spInputFeatureCollection = spInputProc->getOutput()->QueryInterface<IFeatureCollection>();
+		assert(spInputFeatureCollection);
+
+		//changing the aggregate resolution initializes the process again, the pyramid of the same input is kept.
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		if (spInputFeatureCollection != m_spInputFeatureCollection)
+		{
+			m_spInputFeatureCollection = spInputFeatureCollection;
+			m_bIsAggregated = false;
+		}
 	}
 	return knInitialized;
 }
@@ -332,7 +552,6 @@ void PointAggregatorProcess::setAttributes(const std::map<std::string,std::strin
 			 if (nRes > 0 && nRes < 40)
 			 {
 				m_nAggregatedResolution = nRes;
-				m_bIsAggregated = false;
 			 }
 			 else 
 			 {
@@ -343,48 +562,327 @@ void PointAggregatorProcess::setAttributes(const std::map<std::string,std::strin
 	}
 }
 
-std::vector<boost::intrusive_ptr<AggregatedPointFeature> > PointAggregatorProcess::aggregate(int nAggregateResolution) const
-{	
+void PointAggregatorProcess::aggregate() const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	if (!m_bIsAggregated)
+	{
+		buildPyramid();
+	}
+
+	//the aggregated features of another resolution are created again from the pyramid
+	if (m_nCachedResolution != m_nAggregatedResolution)
+	{
+		m_mapAggregates.clear();
+		m_nCachedResolution = m_nAggregatedResolution;
+	}
+}
+
+void PointAggregatorProcess::buildPyramid() const
+{
 	boost::recursive_mutex::scoped_lock lock(m_mutex);
-	bool bWasAggregated = false;
-	std::vector<boost::intrusive_ptr<AggregatedPointFeature> > vecAggregatedPts;
+
+	m_vecFeatures.clear();
+	m_vecIndices.clear();
+	m_vecLocations.clear();
+	m_vecNextFeature.clear();
+	m_vecPyramid.assign(PYXMath::knMaxAbsResolution + 1, CellMap());
+	m_mapAggregates.clear();
+
 	for (PYXPointer<FeatureIterator> spFeatIt = m_spInputFeatureCollection->getIterator();
 		!spFeatIt->end(); spFeatIt->next())
 	{
-		bWasAggregated = false;
-		boost::intrusive_ptr<IFeature> spCurrentFeature = spFeatIt->getFeature();	
-		for (std::vector<boost::intrusive_ptr<AggregatedPointFeature> >::const_iterator it = 
-			vecAggregatedPts.begin(); it != vecAggregatedPts.end(); ++it)
-		{	
-			if ((*it)->getGeometry()->intersects(*(spCurrentFeature->getGeometry())))
+		boost::intrusive_ptr<IFeature> spCurrentFeature = spFeatIt->getFeature();
+		PYXIcosIndex index = spCurrentFeature->getGeometry()->getIterator()->getIndex();
+
+		PYXCoord3DDouble location;
+		SnyderProjection::getInstance()->pyxisToXYZ(index, &location);
+
+		int nFeature = static_cast<int>(m_vecFeatures.size());
+		m_vecFeatures.push_back(spCurrentFeature);
+		m_vecIndices.push_back(index);
+		m_vecLocations.push_back(location);
+		m_vecNextFeature.push_back(-1);
+
+		addToPyramid(nFeature, PYXIcosIndex::knResolution1, getPrimaryKey(index));
+	}
+
+	m_bIsAggregated = true;
+}
+
+void PointAggregatorProcess::addToPyramid(int nFeature, int nResolution, CellKey key) const
+{
+	const PYXCoord3DDouble& location = m_vecLocations[nFeature];
+	const int nFeatureResolution = m_vecIndices[nFeature].getResolution();
+
+	for (int nRes = nResolution; ; ++nRes)
+	{
+		PyramidCell& cell = m_vecPyramid[nRes][key];
+
+		if (cell.nCount > 0 && !cell.bRefined)
+		{
+			if (nRes == PYXMath::knMaxAbsResolution ||
+				(nFeatureResolution <= nRes && m_vecIndices[cell.nFirstFeature].getResolution() <= nRes))
 			{
-				
- 				(*it)->addFeature(spCurrentFeature);
-				 bWasAggregated = true;
+				//no feature is finer than the cell, they share the centroid children down to the finest resolution: chain them.
+				++cell.nCount;
+				cell.sum[0] += location[0];
+				cell.sum[1] += location[1];
+				cell.sum[2] += location[2];
+
+				m_vecNextFeature[nFeature] = m_vecNextFeature[cell.nFirstFeature];
+				m_vecNextFeature[cell.nFirstFeature] = nFeature;
+				return;
 			}
+
+			//move the single feature or the chained features of the cell to their child cell.
+			PyramidCell& childCell = m_vecPyramid[nRes + 1][getChildKey(key, getDigit(m_vecIndices[cell.nFirstFeature], nRes + 1))];
+			childCell = cell;
+			cell.bRefined = true;
 		}
 
-		//This feature can't aggregate to a higher feature yet.
-		if (!bWasAggregated)
+		++cell.nCount;
+		cell.sum[0] += location[0];
+		cell.sum[1] += location[1];
+		cell.sum[2] += location[2];
+
+		if (cell.nCount == 1)
 		{
-			boost::intrusive_ptr<AggregatedPointFeature> spAggregatedFeature(new AggregatedPointFeature);
-		
-			PYXPointer<PYXGeometry> spAggregatedCell = PYXCell::create(spCurrentFeature->getGeometry()->getIterator()->getIndex());
-			spAggregatedCell->setCellResolution(nAggregateResolution);
-			spAggregatedFeature->setGeometry(spAggregatedCell);
-			vecAggregatedPts.push_back(spAggregatedFeature);
-			if (spAggregatedFeature->getGeometry()->intersects(*(spCurrentFeature->getGeometry())))
+			cell.nFirstFeature = nFeature;
+			return;
+		}
+
+		key = getChildKey(key, getDigit(m_vecIndices[nFeature], nRes + 1));
+	}
+}
+
+std::vector<boost::intrusive_ptr<IFeature> > PointAggregatorProcess::findAggregates(const PYXGeometry* pGeometry) const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	aggregate();
+
+	AggregateVector vecFound;
+	const CellMap& primaryCells = m_vecPyramid[PYXIcosIndex::knResolution1];
+	for (CellMap::const_iterator it = primaryCells.begin(); it != primaryCells.end(); ++it)
+	{
+		findAggregates(pGeometry, PYXIcosIndex::knResolution1, it->first, it->second, vecFound);
+	}
+
+	//keep the order of the input: sort by the first feature of every aggregated feature.
+	std::sort(vecFound.begin(), vecFound.end());
+
+	std::vector<boost::intrusive_ptr<IFeature> > vecFeatureSet;
+	vecFeatureSet.reserve(vecFound.size());
+	for (AggregateVector::const_iterator it = vecFound.begin(); it != vecFound.end(); ++it)
+	{
+		vecFeatureSet.push_back(it->second);
+	}
+	return vecFeatureSet;
+}
+
+void PointAggregatorProcess::findAggregates(const PYXGeometry* pGeometry, int nResolution, const CellKey& key, const PyramidCell& cell, AggregateVector& vecFound) const
+{
+	if (pGeometry)
+	{
+		PYXIcosIndex index = m_vecIndices[cell.nFirstFeature];
+		index.setResolution(nResolution);
+		if (!pGeometry->intersects(PYXCell(index)))
+		{
+			return;
+		}
+	}
+
+	if (nResolution == m_nAggregatedResolution)
+	{
+		vecFound.push_back(std::make_pair(cell.nFirstFeature, getAggregate(key, nResolution, key, cell)));
+		return;
+	}
+
+	if (!cell.bRefined)
+	{
+		//a single feature or co-located features: their aggregated cell is a descendant of this cell.
+		if (pGeometry)
+		{
+			PYXIcosIndex index = m_vecIndices[cell.nFirstFeature];
+			index.setResolution(m_nAggregatedResolution);
+			if (!pGeometry->intersects(PYXCell(index)))
 			{
-				spAggregatedFeature->addFeature(spCurrentFeature);
-				bWasAggregated = true;
+				return;
 			}
 		}
-		assert(bWasAggregated && "Error found cell couldn't aggregate to");
+		vecFound.push_back(std::make_pair(cell.nFirstFeature, 
+			getAggregate(getFeatureKey(cell.nFirstFeature, m_nAggregatedResolution), nResolution, key, cell)));
+		return;
+	}
+
+	const CellMap& childCells = m_vecPyramid[nResolution + 1];
+	for (unsigned int nDigit = 0; nDigit < 7; ++nDigit)
+	{
+		CellKey childKey = getChildKey(key, nDigit);
+		CellMap::const_iterator it = childCells.find(childKey);
+		if (it != childCells.end())
+		{
+			findAggregates(pGeometry, nResolution + 1, childKey, it->second, vecFound);
+		}
+	}
+}
+
+boost::intrusive_ptr<AggregatedPointFeature> PointAggregatorProcess::getAggregate(const CellKey& key, int nResolution, const CellKey& cellKey, const PyramidCell& cell) const
+{
+	boost::unordered_map<CellKey, boost::intrusive_ptr<AggregatedPointFeature>, boost::hash<CellKey> >::const_iterator it = m_mapAggregates.find(key);
+	if (it != m_mapAggregates.end())
+	{
+		return it->second;
+	}
+
+	std::vector<int> vecFeatureIndices;
+	collectFeatures(nResolution, cellKey, cell, vecFeatureIndices);
+	std::sort(vecFeatureIndices.begin(), vecFeatureIndices.end());
+
+	std::vector<boost::intrusive_ptr<IFeature> > vecFeatures;
+	vecFeatures.reserve(vecFeatureIndices.size());
+	for (std::vector<int>::const_iterator itFeature = vecFeatureIndices.begin(); itFeature != vecFeatureIndices.end(); ++itFeature)
+	{
+		vecFeatures.push_back(m_vecFeatures[*itFeature]);
+	}
+
+	PYXIcosIndex index = m_vecIndices[vecFeatureIndices.front()];
+	index.setResolution(m_nAggregatedResolution);
+
+	boost::intrusive_ptr<AggregatedPointFeature> spAggregatedFeature(new AggregatedPointFeature);
+	spAggregatedFeature->setGeometry(PYXCell::create(index));
+	spAggregatedFeature->addFeatures(vecFeatures);
+
+	m_mapAggregates[key] = spAggregatedFeature;
+	return spAggregatedFeature;
+}
+
+const PointAggregatorProcess::PyramidCell* PointAggregatorProcess::findCell(const PYXIcosIndex& index, int& nResolution, CellKey& cellKey) const
+{
+	int nIndexResolution = index.getResolution();
+	CellKey key = getPrimaryKey(index);
+
+	for (int nRes = PYXIcosIndex::knResolution1; nRes <= nIndexResolution; ++nRes)
+	{
+		if (nRes > PYXIcosIndex::knResolution1)
+		{
+			key = getChildKey(key, getDigit(index, nRes));
+		}
+
+		CellMap::const_iterator it = m_vecPyramid[nRes].find(key);
+		if (it == m_vecPyramid[nRes].end())
+		{
+			return 0;
+		}
+
+		const PyramidCell& cell = it->second;
+
+		if (nRes == nIndexResolution)
+		{
+			nResolution = nRes;
+			cellKey = key;
+			return &cell;
+		}
+
+		if (!cell.bRefined)
+		{
+			//a coarser cell holds a single feature or co-located features, check if they are in the index.
+			PYXIcosIndex featureIndex = m_vecIndices[cell.nFirstFeature];
+			featureIndex.setResolution(nIndexResolution);
+			if (!(featureIndex == index))
+			{
+				return 0;
+			}
+
+			nResolution = nRes;
+			cellKey = key;
+			return &cell;
+		}
+	}
+	return 0;
+}
+
+void PointAggregatorProcess::collectFeatures(int nResolution, const CellKey& key, const PyramidCell& cell, std::vector<int>& vecFeatures) const
+{
+	if (!cell.bRefined)
+	{
+		for (int nFeature = cell.nFirstFeature; nFeature != -1; nFeature = m_vecNextFeature[nFeature])
+		{
+			vecFeatures.push_back(nFeature);
+		}
+		return;
+	}
+
+	const CellMap& childCells = m_vecPyramid[nResolution + 1];
+	for (unsigned int nDigit = 0; nDigit < 7; ++nDigit)
+	{
+		CellKey childKey = getChildKey(key, nDigit);
+		CellMap::const_iterator it = childCells.find(childKey);
+		if (it != childCells.end())
+		{
+			collectFeatures(nResolution + 1, childKey, it->second, vecFeatures);
+		}
+	}
+}
+
+PointAggregatorProcess::CellKey PointAggregatorProcess::getFeatureKey(int nFeature, int nResolution) const
+{
+	const PYXIcosIndex& index = m_vecIndices[nFeature];
+
+	CellKey key = getPrimaryKey(index);
+	for (int nRes = PYXIcosIndex::knResolution1 + 1; nRes <= nResolution; ++nRes)
+	{
+		key = getChildKey(key, getDigit(index, nRes));
+	}
+	return key;
+}
+
+PointAggregatorProcess::CellKey PointAggregatorProcess::getPrimaryKey(const PYXIcosIndex& index)
+{
+	CellKey key;
+	key.nHigh = 0;
+	key.nLow = static_cast<boost::uint64_t>(index.getPrimaryResolution());
+	return key;
+}
+
+PointAggregatorProcess::CellKey PointAggregatorProcess::getChildKey(const CellKey& key, unsigned int nDigit)
+{
+	//7 bits of primary resolution and 39 digits of 3 bits fit in 128 bits.
+	CellKey childKey;
+	childKey.nHigh = (key.nHigh << 3) | (key.nLow >> 61);
+	childKey.nLow = (key.nLow << 3) | nDigit;
+	return childKey;
+}
+
+unsigned int PointAggregatorProcess::getDigit(const PYXIcosIndex& index, int nResolution)
+{
+	int nPosition = nResolution - PYXIcosIndex::knMinSubRes;
+	const PYXIndex& subIndex = index.getSubIndex();
+
+	return nPosition < subIndex.getDigitCount() ? subIndex.getDigit(nPosition) : 0;
+}
+
+bool PointAggregatorProcess::getCellStatistics(const PYXIcosIndex& index, int& nCount, PYXCoord3DDouble& centroid) const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	aggregate();
+
+	int nResolution;
+	CellKey cellKey;
+	const PyramidCell* pCell = findCell(index, nResolution, cellKey);
+
+	if (!pCell)
+	{
+		nCount = 0;
+		return false;
 	}
-	
-	m_bIsAggregated = true;
-	return vecAggregatedPts;
 
+	//a coarser cell holds the features of the index only.
+	nCount = pCell->nCount;
+	centroid = pCell->sum;
+	centroid.scale(1.0 / nCount);
+	return true;
 }
 
 std::string PointAggregatorProcess::getAttributeSchema() const
@@ -418,76 +916,52 @@ std::string PointAggregatorProcess::getAttributeSchema() const
 PYXPointer<FeatureIterator> PointAggregatorProcess::getIterator(const PYXGeometry& geometry) const
 {
 	boost::recursive_mutex::scoped_lock lock(m_mutex);
-	if (!m_bIsAggregated || geometry.getCellResolution() != m_nAggregatedResolution)
-	{
-		m_nAggregatedResolution = geometry.getCellResolution() - 7;
-		m_bIsAggregated = false;
-		m_vecAggregatedFeatures = aggregate(m_nAggregatedResolution);
-	}
-	std::vector<boost::intrusive_ptr<IFeature> > vecFeatureSet;
-	for (std::vector<boost::intrusive_ptr<AggregatedPointFeature> >::const_iterator it = m_vecAggregatedFeatures.begin();
-		it != m_vecAggregatedFeatures.end(); ++it)
-	{
-		if (geometry.intersects(*(*it)->getGeometry()))
-		{
-			boost::intrusive_ptr<IFeature> spFeat;
-			(*it)->QueryInterface(IFeature::iid, (void**) &spFeat);
-			if (spFeat)
-			{
-				vecFeatureSet.push_back(spFeat);
-			}
-		}
-	}
 
-	return PointAggregatorFeatureCollectionIterator::create(vecFeatureSet);
+	//zooming only changes the resolution, the pyramid is kept.
+	m_nAggregatedResolution = std::max(PYXIcosIndex::knResolution1, geometry.getCellResolution() - 7);
+
+	return PointAggregatorFeatureCollectionIterator::create(findAggregates(&geometry));
 }
 
 
 PYXPointer<FeatureIterator> PointAggregatorProcess::getIterator() const
 {
-	boost::recursive_mutex::scoped_lock lock(m_mutex);
-	if (!m_bIsAggregated)
-	{
-		m_vecAggregatedFeatures = aggregate(m_nAggregatedResolution);
-	}
-	return PointAggregatorFeatureCollectionIterator::create(convert(m_vecAggregatedFeatures));
+	return PointAggregatorFeatureCollectionIterator::create(findAggregates(0));
 }
 
 //! Get the feature with the specified ID.
 boost::intrusive_ptr<IFeature>  PointAggregatorProcess::getFeature(
 	const std::string& strFeatureID) const
 {
-	if (!m_bIsAggregated)
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	aggregate();
+
+	//the id of an aggregated feature is the index of its cell.
+	PYXIcosIndex index;
+	try
 	{
-		m_vecAggregatedFeatures = aggregate(m_nAggregatedResolution);
+		index = PYXIcosIndex(strFeatureID);
 	}
-	std::vector<boost::intrusive_ptr<AggregatedPointFeature> >::const_iterator vecIt;
-
-	for (vecIt = m_vecAggregatedFeatures.begin(); vecIt != m_vecAggregatedFeatures.end(); ++vecIt)
+	catch (PYXException&)
 	{
-		if ((*vecIt)->getID().compare(strFeatureID) == 0)
-		{
-			return (*vecIt);
-		}
+		return boost::intrusive_ptr<IFeature>();
 	}
-	return boost::intrusive_ptr<IFeature>();
-}
 
+	if (index.isNull() || index.getResolution() != m_nAggregatedResolution)
+	{
+		return boost::intrusive_ptr<IFeature>();
+	}
 
-std::vector<boost::intrusive_ptr<IFeature> > PointAggregatorProcess::convert(std::vector<boost::intrusive_ptr<AggregatedPointFeature> > vecFeatures)const
-{
-	std::vector<boost::intrusive_ptr<IFeature> > vecIFeatures;
-
-	for (std::vector<boost::intrusive_ptr<AggregatedPointFeature> >::const_iterator it = vecFeatures.begin(); it != vecFeatures.end(); ++it)
+	int nResolution;
+	CellKey cellKey;
+	const PyramidCell* pCell = findCell(index, nResolution, cellKey);
+	if (!pCell)
 	{
-		boost::intrusive_ptr<IFeature> spFeature;
-		(*it)->QueryInterface(IFeature::iid, (void**) &spFeature);
-		if (spFeature)
-		{
-			vecIFeatures.push_back(spFeature);
-		}
+		return boost::intrusive_ptr<IFeature>();
 	}
-	return vecIFeatures;
+
+	CellKey key = nResolution == m_nAggregatedResolution ? cellKey : getFeatureKey(pCell->nFirstFeature, m_nAggregatedResolution);
+	return getAggregate(key, nResolution, cellKey, *pCell);
 }
 
 const std::string& PointAggregatorProcess::getID() const
@@ -516,12 +990,9 @@ std::string PointAggregatorProcess::getStyle() const
 
 std::string PointAggregatorProcess::getStyle(const std::string& strStyleToGet) const
 {
-	if (!m_bIsAggregated)
-	{
-		m_vecAggregatedFeatures = aggregate(m_nAggregatedResolution);
-	}
+	std::vector<boost::intrusive_ptr<IFeature> > vecAggregatedFeatures = findAggregates(0);
 
-	if(m_vecAggregatedFeatures.size() == 0)
+	if(vecAggregatedFeatures.size() == 0)
 	{
 		assert(false && 
 			"The features in the Point Aggregator process have not been aggregated!");
@@ -529,25 +1000,18 @@ std::string PointAggregatorProcess::getStyle(const std::string& strStyleToGet) c
 	}
 	else
 	{
-		return m_vecAggregatedFeatures[0]->getStyle(strStyleToGet);
+		return vecAggregatedFeatures[0]->getStyle(strStyleToGet);
 	}	
 }
 
 void PointAggregatorProcess::calcGeometry() const
 {
 	m_spGeom = PYXMultiCell::create();
-	if (!m_bIsAggregated)
-	{
-		m_vecAggregatedFeatures = aggregate(m_nAggregatedResolution);
-	}
 
-	if (m_spGeom->isEmpty())
+	std::vector<boost::intrusive_ptr<IFeature> > vecAggregatedFeatures = findAggregates(0);
+	for (std::vector<boost::intrusive_ptr<IFeature> >::const_iterator it = vecAggregatedFeatures.begin();
+		it != vecAggregatedFeatures.end(); ++it)
 	{
-		for (std::vector<boost::intrusive_ptr<AggregatedPointFeature> >::const_iterator it = m_vecAggregatedFeatures.begin();
-			it != m_vecAggregatedFeatures.end(); ++it)
-		{
-			boost::intrusive_ptr<AggregatedPointFeature> spFeat = (*it);
-			m_spGeom->addCell(PYXCell::create(spFeat->getGeometry()->getIterator()->getIndex()));
-		}
+		m_spGeom->addCell(PYXCell::create((*it)->getGeometry()->getIterator()->getIndex()));
 	}
 }
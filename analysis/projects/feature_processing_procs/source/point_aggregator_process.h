@@ -15,7 +15,10 @@ web			: www.pyxisinnovation.com
 #include "pyxis/geometry/multi_cell.h"
 
 // boost includes
+#include <boost/cstdint.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <boost/unordered_map.hpp>
 
 /*!
 An Aggregated point feature is a feature collection that represents all the features cotained in a larger cell.
@@ -108,6 +111,9 @@ public: //IFeatureCollection
 	//! Add a feature into the aggregated feature.
 	virtual void addFeature(boost::intrusive_ptr<IFeature> spFeature);
 
+	//! Add features into the aggregated feature, the meta data is calculated once.
+	void addFeatures(const std::vector<boost::intrusive_ptr<IFeature> >& vecFeatures);
+
 private:
 
 	//! Calculates the meta data for feature picking.
@@ -123,6 +129,13 @@ private:
 
 /*!
 Aggregates a input feature collection to a set aggregate resolution. 
+
+The input is read once into a pyramid of cells keyed by their index, holding the count and the sum of the
+locations of the features in every resolution. A cell is refined into its children only when it holds more
+than one feature and one of them is finer than the cell, so the pyramid stays proportional to the number of
+features and co-located features stop at the resolution of their index. Changing the aggregate
+resolution (zooming) doesn't read the input again: the aggregated features are created on demand from the
+pyramid, and geometry queries only visit the cells that intersect the geometry.
 */
 class MODULE_FEATURE_PROCESSING_PROCS_DECL PointAggregatorProcess : public ProcessImpl<PointAggregatorProcess>,  
 																  public IFeatureCollection
@@ -231,6 +244,9 @@ public: //IFeatureCollection
 public: //PointAggregatorProcess
 	
 	static void test();
+
+	//! Aggregate random points and zoom through the aggregate resolutions (profile with a million points).
+	static void benchmark(int nFeatureCount);
 	
 	//! Default Constructor
 	PointAggregatorProcess();
@@ -238,15 +254,88 @@ public: //PointAggregatorProcess
 	//! Destructor
 	~PointAggregatorProcess(){;}
 
+	//! Get the number of input features in a cell and their mean location, return false if the cell has no features.
+	bool getCellStatistics(const PYXIcosIndex& index, int& nCount, PYXCoord3DDouble& centroid) const;
+
 private:
 
-	//! Aggregate all the features from resolution n to resolution n - x.
-	std::vector<boost::intrusive_ptr<AggregatedPointFeature> > aggregate(int nAggregateResolution) const;
+	//! The key of a pyramid cell: the primary resolution followed by 3 bits per digit.
+	struct CellKey
+	{
+		boost::uint64_t nHigh;
+		boost::uint64_t nLow;
+
+		bool operator==(const CellKey& other) const
+		{
+			return nHigh == other.nHigh && nLow == other.nLow;
+		}
+
+		friend std::size_t hash_value(const CellKey& key)
+		{
+			std::size_t nSeed = 0;
+			boost::hash_combine(nSeed, key.nHigh);
+			boost::hash_combine(nSeed, key.nLow);
+			return nSeed;
+		}
+	};
+
+	//! A cell of the pyramid.
+	struct PyramidCell
+	{
+		PyramidCell() : nCount(0), nFirstFeature(-1), bRefined(false) {}
 
-	void calcGeometry() const;
+		//! The number of features in the cell.
+		int nCount;
+
+		//! The sum of the locations of the features in the cell.
+		PYXCoord3DDouble sum;
+
+		//! The first feature added to the cell.
+		int nFirstFeature;
+
+		//! True if the features of the cell were added to the children cells. A cell that isn't refined holds
+		//! a single feature, or features chained from nFirstFeature that are not finer than the cell.
+		bool bRefined;
+	};
+
+	typedef boost::unordered_map<CellKey, PyramidCell, boost::hash<CellKey> > CellMap;
+
+	typedef std::vector<std::pair<int, boost::intrusive_ptr<AggregatedPointFeature> > > AggregateVector;
+
+	//! Build the pyramid if needed and drop the aggregated features of another resolution.
+	void aggregate() const;
+
+	//! Read all the input features into the pyramid.
+	void buildPyramid() const;
 
-	//! Utility method to convert from a vector of boost::intrusive_ptr<AggregatedPointFeature> to boost::intrusive_ptr<IFeature>
-	std::vector<boost::intrusive_ptr<IFeature> > convert(std::vector<boost::intrusive_ptr<AggregatedPointFeature> > vecFeatures) const;
+	//! Add a feature to the pyramid, starting from the cell of the given resolution.
+	void addToPyramid(int nFeature, int nResolution, CellKey key) const;
+
+	//! Find the aggregated features that intersect the geometry (all the features if the geometry is null).
+	std::vector<boost::intrusive_ptr<IFeature> > findAggregates(const PYXGeometry* pGeometry) const;
+
+	void findAggregates(const PYXGeometry* pGeometry, int nResolution, const CellKey& key, const PyramidCell& cell, AggregateVector& vecFound) const;
+
+	//! Get (or create) the aggregated feature of a cell at the aggregate resolution.
+	boost::intrusive_ptr<AggregatedPointFeature> getAggregate(const CellKey& key, int nResolution, const CellKey& cellKey, const PyramidCell& cell) const;
+
+	//! Find the pyramid cell of an index, or the coarser cell of the only feature in the index.
+	const PyramidCell* findCell(const PYXIcosIndex& index, int& nResolution, CellKey& cellKey) const;
+
+	//! Collect the features of a pyramid cell.
+	void collectFeatures(int nResolution, const CellKey& key, const PyramidCell& cell, std::vector<int>& vecFeatures) const;
+
+	//! Get the key of the cell of a feature at the given resolution.
+	CellKey getFeatureKey(int nFeature, int nResolution) const;
+
+	static CellKey getPrimaryKey(const PYXIcosIndex& index);
+
+	static CellKey getChildKey(const CellKey& key, unsigned int nDigit);
+
+	//! Get the digit of an index at the given resolution, indices are extended with centroid children.
+	static unsigned int getDigit(const PYXIcosIndex& index, int nResolution);
+
+	void calcGeometry() const;
 
 private: 
 
@@ -256,8 +345,20 @@ private:
 	//! The resolution to aggregate to.
 	mutable int m_nAggregatedResolution;
 
-	//! A Vector of boost intrusive_ptr to AggregatedPointFeature
-	mutable	std::vector<boost::intrusive_ptr<AggregatedPointFeature> > m_vecAggregatedFeatures;
+	//! The input features, their cell and their location.
+	mutable std::vector<boost::intrusive_ptr<IFeature> > m_vecFeatures;
+	mutable std::vector<PYXIcosIndex> m_vecIndices;
+	mutable std::vector<PYXCoord3DDouble> m_vecLocations;
+
+	//! The next feature chained in the same cell (-1 for none), see addToPyramid.
+	mutable std::vector<int> m_vecNextFeature;
+
+	//! The cells of the features for every resolution.
+	mutable std::vector<CellMap> m_vecPyramid;
+
+	//! The aggregated features created at m_nCachedResolution.
+	mutable boost::unordered_map<CellKey, boost::intrusive_ptr<AggregatedPointFeature>, boost::hash<CellKey> > m_mapAggregates;
+	mutable int m_nCachedResolution;
 
 	//! The input feature collection.
 	mutable boost::intrusive_ptr<IFeatureCollection> m_spInputFeatureCollection;
@@ -11,11 +11,8 @@ web			: www.pyxisinnovation.com
 
 // local includes
 #include "exceptions.h"
-#include "zoom_in_process.h"
-#include "zoom_out_process.h"
 
 // pyxis data sources includes
-#include "coverage_cache.h"
 #include "null_coverage.h"
 
 // pyxlib includes
@@ -26,6 +23,12 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/tester.h"
 #include "pyxis/utility/value_math.h"
 
+// boost includes
+#include <boost/bind.hpp>
+
+// standard includes
+#include <algorithm>
+
 // {32C48166-6FDB-46fc-9FAB-705E7469F9A4}
 PYXCOM_DEFINE_CLSID(BlurProcess, 
 0x32c48166, 0x6fdb, 0x46fc, 0x9f, 0xab, 0x70, 0x5e, 0x74, 0x69, 0xf9, 0xa4);
@@ -44,11 +47,55 @@ Tester<BlurProcess> gTester;
 // Constants
 const std::string BlurProcess::kstrSteps = "Number_of_Steps";
 
+namespace
+{
+
+//! Cache weight of a pyramid or a channel tile.
+template<typename T>
+size_t getUnitWeight(const T &)
+{
+	return 1;
+}
+
+//! Cache key of a tile at a cell resolution.
+std::string getCacheKey(const PYXIcosIndex & root,int nRes)
+{
+	return root.toString() + ":" + StringUtils::toString(nRes);
+}
+
+}
+
 /*!
 The unit test method for the class.
 */
 void BlurProcess::test()
 {
+	{ // The channel tiles of several tiles are cached.
+		uint8_t arrayValue[3] = {120, 180, 240};
+		boost::intrusive_ptr<ConstCoverage> spInputCoverage(new ConstCoverage);
+		spInputCoverage->setReturnValue(PYXValue(arrayValue,3),PYXFieldDefinition::knContextRGB,0);
+
+		boost::intrusive_ptr<BlurProcess> spBlurProc(new BlurProcess);
+		spBlurProc->getParameter(0)->addValue(spInputCoverage);
+		std::map<std::string, std::string> attribs;
+		attribs[kstrSteps] = "2";
+		spBlurProc->setAttributes(attribs);
+		TEST_ASSERT(spBlurProc->initProc(true) == IProcess::knInitialized);
+
+		PYXIcosIndex index1 = "A-01000";
+		PYXIcosIndex index2 = "C-020504";
+		PYXPointer<PYXValueTile> spTile1 = spBlurProc->getFieldTile(index1, index1.getResolution() + 3, 1);
+		PYXPointer<PYXValueTile> spTile2 = spBlurProc->getFieldTile(index2, index2.getResolution() + 3, 1);
+
+		TEST_ASSERT(spTile1 != spTile2);
+		TEST_ASSERT(spBlurProc->getFieldTile(index1, index1.getResolution() + 3, 1) == spTile1);
+		TEST_ASSERT(spBlurProc->getFieldTile(index2, index2.getResolution() + 3, 1) == spTile2);
+		TEST_ASSERT(spBlurProc->getFieldTile(index1, index1.getResolution() + 3, 2) != spTile1);
+
+		TEST_ASSERT(spTile1->getValue(0, 0) == PYXValue(arrayValue,3));
+		TEST_ASSERT(spBlurProc->getCoverageValue(index2, 2) == PYXValue(arrayValue,3));
+	}
+
 	//TODO[shatzi,nov 2012]: I remove those test because they take tool long.
 	return;
 
@@ -192,98 +239,6 @@ void BlurProcess::setAttributes(const std::map<std::string, std::string>& mapAtt
 	}
 }
 
-/*!
-Utility helper method to set up the blurring pipeline which consists of a series of
-zoom in, zoom out, and cache processes all connected together. A single step
-consists of a zoom out, zoom in and a cache.
-*/
-void BlurProcess::setUpFilteringPipeline()
-{	
-	m_vecOutputCaches.clear();
-	if (m_spInputCoverage)
-	{
-		// resize the cache vector
-		m_vecOutputCaches.resize(m_nSteps + 1, boost::intrusive_ptr<ICoverage>());
-
-		// examine the input coverage and store the unblurred version in channel 0
-		if (boost::dynamic_pointer_cast<ICache>(m_spInputCoverage))
-		{
-			m_vecOutputCaches[0] = m_spInputCoverage;
-		}
-		else
-		{
-			// the input is not cached, add one to it
-			boost::intrusive_ptr<PYXCoverageCache> spInputCache(new PYXCoverageCache);
-			spInputCache->getParameter(0)->addValue(boost::dynamic_pointer_cast<IProcess>(m_spInputCoverage));
-			spInputCache->initProc();
-			spInputCache->setCachePersistence(true);
-			//spInputCache->setCoverageDefinition(m_spInputCoverage->getCoverageDefinition());
-			m_vecOutputCaches[0] = spInputCache;
-		}
-		
-		// for each step plug the previous input into a new blur level
-		for (size_t nLevel = 0; nLevel < static_cast<size_t>(m_nSteps); ++nLevel)
-		{
-			// First level is a zoom out
-			boost::intrusive_ptr<PYXZoomOutProcess> spZoomOut (new PYXZoomOutProcess());
-			std::map<std::string, std::string> zoomOutAttrib;
-			zoomOutAttrib.clear();
-			zoomOutAttrib[PYXZoomOutProcess::kstrAverage] = PYXZoomOutProcess::kstrYes;
-			zoomOutAttrib[PYXZoomOutProcess::kstrIncNulls] = PYXZoomOutProcess::kstrNo;
-			spZoomOut->setAttributes(zoomOutAttrib);
-			spZoomOut->getParameter(0)->addValue(
-				boost::dynamic_pointer_cast<IProcess>(m_vecOutputCaches[nLevel]));
-			spZoomOut->initProc();
-
-			// Cache the zoom out
-			boost::intrusive_ptr<PYXCoverageCache> spZoomOutCache(new PYXCoverageCache());
-			spZoomOutCache->setCachePersistence(false);
-			spZoomOutCache->getParameter(0)->addValue(
-				boost::dynamic_pointer_cast<IProcess>(spZoomOut));
-			spZoomOutCache->initProc();
-			//spZoomOutCache->setCoverageDefinition(m_spInputCoverage->getCoverageDefinition());
-			
-			/*
-			For every zoom out in the accumulated chain we need to zoom in so second loop creates
-			the zoom in parts of this algorithm and links them together.
-			*/
-			boost::intrusive_ptr<ICoverage> spZoomInInput = spZoomOutCache;
-			for (size_t nZoomInCount = 0; nZoomInCount <= nLevel; ++nZoomInCount)
-			{
-				// Create a zoom in process
-				boost::intrusive_ptr<PYXZoomInProcess> spZoomIn(new PYXZoomInProcess);
-				std::map<std::string, std::string> zoomInAttrib;
-				zoomInAttrib.clear();
-				zoomInAttrib[PYXZoomInProcess::kstrBlurringAlgor] = PYXZoomInProcess::kstrYes;
-				zoomInAttrib[PYXZoomInProcess::kstrIncNulls] = PYXZoomInProcess::kstrNo;
-				spZoomIn->setAttributes(zoomInAttrib);
-				spZoomIn->getParameter(0)->addValue(
-					boost::dynamic_pointer_cast<IProcess>(spZoomInInput));
-				spZoomIn->initProc();
-
-				// cache the zoom in process output
-				boost::intrusive_ptr<PYXCoverageCache> spCache (new PYXCoverageCache);
-				spCache->setCachePersistence(false);
-				spCache->getParameter(0)->addValue(
-					boost::dynamic_pointer_cast<IProcess>(spZoomIn));
-				spCache->initProc();
-				//spCache->setCoverageDefinition(m_spInputCoverage->getCoverageDefinition());
-
-				// prime the input for the next loop
-				spZoomInInput = spCache;
-			}
-
-			//Set up the output caches
-			m_vecOutputCaches[nLevel + 1] = spZoomInInput;
-		}
-		createMetaData();
-	}
-	else
-	{
-		PYXTHROW(ImageProcessingException, "No input provided for blur process.");
-	}
-}
-
 /*!
 Helper method to amend the coverage definition meta data to add any of field
 field definitions, to the coverage definition. Changing the meta data
@@ -311,7 +266,8 @@ void BlurProcess::createMetaData()
 				originalDefinition.getType(),
 				originalDefinition.getCount());
 
-			for (size_t nVecIndex = 1; nVecIndex < m_vecOutputCaches.size(); ++nVecIndex)
+			size_t nChannelCount = static_cast<size_t>(m_nSteps) + 1;
+			for (size_t nVecIndex = 1; nVecIndex < nChannelCount; ++nVecIndex)
 			{
 				std::stringstream name;
 				name << "Channel " << static_cast<unsigned int>(nVecIndex);
@@ -319,7 +275,7 @@ void BlurProcess::createMetaData()
 				{
 					name << ": slightly blurred input.";
 				}
-				else if (nVecIndex == (m_vecOutputCaches.size() - 1))
+				else if (nVecIndex == (nChannelCount - 1))
 				{
 					name << ": most blurred input.";
 				}
@@ -337,17 +293,63 @@ void BlurProcess::createMetaData()
 	}
 }
 
+/*!
+Single values are read from the channel tile of a small tile containing the cell.
+The tile is cached, so the values of the neighbouring cells and of the other
+channels are read from the same pyramid.
+*/
 PYXValue BlurProcess::getCoverageValue(
 		const PYXIcosIndex& index, int nFieldIndex) const
 {
-	return m_vecOutputCaches[nFieldIndex]->getCoverageValue(index);
+	if (nFieldIndex == 0)
+	{
+		return m_spInputCoverage->getCoverageValue(index);
+	}
+
+	PYXIcosIndex root = index;
+	root.setResolution(std::max(std::min(static_cast<int>(PYXIcosIndex::knMinSubRes), index.getResolution()), index.getResolution() - knValueTileDepth));
+
+	PYXPointer<PYXValueTile> spValueTile = getFieldTile(root, index.getResolution(), nFieldIndex);
+	return spValueTile->getValue(index, 0);
 }
 
 PYXPointer<PYXValueTile> BlurProcess::getFieldTile(	const PYXIcosIndex& index,
 													int nRes,
 													int nFieldIndex	) const
 {
-	return m_vecOutputCaches[nFieldIndex]->getFieldTile(index, nRes, 0);
+	if (nFieldIndex == 0)
+	{
+		return m_spInputCoverage->getFieldTile(index, nRes, 0);
+	}
+
+	if (nFieldIndex < 0 || nFieldIndex > m_nSteps)
+	{
+		PYXTHROW(ImageProcessingException, "The blur process has no channel " << nFieldIndex << ".");
+	}
+
+	return m_channelTiles.getOrCreate(
+		getCacheKey(index, nRes) + ":" + StringUtils::toString(nFieldIndex),
+		boost::bind(&BlurProcess::createChannelTile, this, index, nRes, nFieldIndex),
+		&getUnitWeight<PYXPointer<PYXValueTile> >);
+}
+
+PYXPointer<PYXValueTile> BlurProcess::createChannelTile(const PYXIcosIndex& index, int nRes, int nFieldIndex) const
+{
+	return getPyramid(index, nRes)->createValueTile(nFieldIndex, getCoverageDefinition()->getFieldDefinition(nFieldIndex));
+}
+
+PYXPointer<BlurPyramid> BlurProcess::getPyramid(const PYXIcosIndex& index, int nRes) const
+{
+	//the channels of a tile are created from the same pyramid, other tiles are not blocked while it is computed
+	return m_pyramids.getOrCreate(
+		getCacheKey(index, nRes),
+		boost::bind(&BlurProcess::createPyramid, this, index, nRes),
+		&getUnitWeight<PYXPointer<BlurPyramid> >);
+}
+
+PYXPointer<BlurPyramid> BlurProcess::createPyramid(const PYXIcosIndex& index, int nRes) const
+{
+	return BlurPyramid::create(PYXTile(index, nRes), m_nSteps, m_spInputCoverage, 0);
 }
 
 /*!
@@ -391,6 +393,9 @@ IProcess::eInitStatus BlurProcess::initImpl()
 		return knFailedToInit;
 	}
 
-	setUpFilteringPipeline();
+	m_channelTiles.clear();
+	m_pyramids.clear();
+
+	createMetaData();
 	return knInitialized;
 }
\ No newline at end of file
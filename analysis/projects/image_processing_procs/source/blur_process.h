@@ -10,18 +10,22 @@ web			: www.pyxisinnovation.com
 
 // local includes
 #include "module_image_processing_procs.h"
+#include "blur_pyramid.h"
 
 //pyxlib includes
 #include "pyxis/data/coverage_base.h"
 #include "pyxis/pipe/process.h"
+#include "pyxis/utility/concurrent_cache.h"
 
 /*!
 BlurProcess, is a filter which implements a blur algorithm This process takes a 
 single channel coverage as input and turns it into n channels creating a multi 
 channel datasource. Each channel of this coverage is at a different sdpectrum
-resolution. The changes in resolution are accomplished through a series of daisy
-chained, zoom in and zoom out filters, along with cache filters at appropriate 
-places to increase performance.
+resolution. Channel n is the input zoomed out n resolutions and zoomed back in,
+computed for a whole tile at once by a BlurPyramid (see blur_pyramid.h). The
+pyramids and the channel tiles of the recently requested tiles are cached, so
+the channels of a tile are computed from the same downsampled levels, and the
+pyramids are computed without locking the process.
 */
 //! Blurs the input coverage into multiple channels each channel more blurred then the last.
 class MODULE_IMAGE_PROCESSING_PROCS_DECL BlurProcess : public ProcessImpl<BlurProcess>, public CoverageBase
@@ -128,7 +132,7 @@ public:
 	static void test();
 
 	//! Default constructor.
-	BlurProcess() : m_nSteps(1){;}
+	BlurProcess() : m_nSteps(1), m_pyramids(16,1,false), m_channelTiles(64,1,false) {;}
 
 protected:
 	//! Destructor.
@@ -152,16 +156,27 @@ private:
 	//! Creates meta data, representing this as multichannel coverage.
 	void createMetaData();
 
-	//! Creates the internal pipeline
-	void setUpFilteringPipeline();
+	//! Get the pyramid of a tile from the cache, or compute it.
+	PYXPointer<BlurPyramid> getPyramid(const PYXIcosIndex& index, int nRes) const;
 
-	//! A vector of output caches.
-	std::vector<boost::intrusive_ptr<
-		ICoverage> > m_vecOutputCaches;
+	//! Compute the pyramid of a tile.
+	PYXPointer<BlurPyramid> createPyramid(const PYXIcosIndex& index, int nRes) const;
+
+	//! Compute the value tile of a channel from the pyramid of the tile.
+	PYXPointer<PYXValueTile> createChannelTile(const PYXIcosIndex& index, int nRes, int nFieldIndex) const;
+
+	//! The depth of the tiles used to compute single values.
+	static const int knValueTileDepth = 6;
 
 	//! The number of steps, times to zoom out & in.
 	int m_nSteps;
 
+	//! The pyramids of the recently requested tiles, by root and cell resolution.
+	mutable ConcurrentCache<std::string, PYXPointer<BlurPyramid> > m_pyramids;
+
+	//! The channel tiles of the recently requested tiles, by root, cell resolution and channel.
+	mutable ConcurrentCache<std::string, PYXPointer<PYXValueTile> > m_channelTiles;
+
 	//! The input coverage.
 	boost::intrusive_ptr<ICoverage> m_spInputCoverage;
 
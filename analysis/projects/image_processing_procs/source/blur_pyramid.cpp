@@ -0,0 +1,725 @@
+/******************************************************************************
+blur_pyramid.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "stdafx.h"
+#define MODULE_IMAGE_PROCESSING_PROCS_SOURCE
+#include "blur_pyramid.h"
+
+// local includes
+#include "zoom_in_process.h"
+#include "zoom_out_process.h"
+
+// pyxlib includes
+#include "pyxis/derm/index_math.h"
+#include "pyxis/derm/neighbour_iterator.h"
+#include "pyxis/derm/snyder_projection.h"
+#include "pyxis/derm/vertex_iterator.h"
+#include "pyxis/procs/const_coverage.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+#include "pyxis/utility/trace.h"
+
+// boost includes
+#include <boost/bind.hpp>
+
+// standard includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <set>
+
+namespace
+{
+
+//! Tester class
+Tester<BlurPyramid> gTester;
+
+//! Add a weighted cell value into the accumulator, return false if the cell has no value.
+inline bool accumulate(	const std::vector<double> & values,
+						const std::vector<unsigned char> & hasValue,
+						int nOffset,
+						int nComponents,
+						double fWeight,
+						double * pAccumulator	)
+{
+	if (nOffset == BlurPyramid::knNoCell || !hasValue[nOffset])
+	{
+		return false;
+	}
+
+	const double * pValue = &values[nOffset*nComponents];
+	for(int n=0;n<nComponents;++n)
+	{
+		pAccumulator[n] += fWeight * pValue[n];
+	}
+	return true;
+}
+
+//! A smooth field over the sphere.
+double smoothField(const PYXIcosIndex & index)
+{
+	PYXCoord3DDouble xyz;
+	SnyderProjection::getInstance()->pyxisToXYZ(index,&xyz);
+	return 1000 * (xyz.x() + 2 * xyz.y() + 3 * xyz.z());
+}
+
+//! The smooth field as a coverage, at any resolution.
+class SmoothFieldCoverage : public ConstCoverage
+{
+public:
+	SmoothFieldCoverage()
+	{
+		setReturnValue(PYXValue(0.0),PYXFieldDefinition::knContextNone);
+	}
+
+public: // ICoverage
+
+	virtual PYXPointer<PYXValueTile> STDMETHODCALLTYPE getFieldTile(	const PYXIcosIndex& index,
+																		int nRes,
+																		int nFieldIndex = 0	) const
+	{
+		PYXPointer<PYXTableDefinition> spCovDefn = PYXTableDefinition::create();
+		spCovDefn->addFieldDefinition(getCoverageDefinition()->getFieldDefinition(nFieldIndex));
+		PYXPointer<PYXValueTile> spValueTile = PYXValueTile::create(index,nRes,spCovDefn);
+
+		const int nCellCount = spValueTile->getNumberOfCells();
+		for (int n = 0; n < nCellCount; ++n)
+		{
+			spValueTile->setValue(n,0,PYXValue(smoothField(PYXIcosMath::calcIndexFromOffset(index,nRes,n))));
+		}
+		return spValueTile;
+	}
+
+	virtual PYXValue STDMETHODCALLTYPE getCoverageValue(	const PYXIcosIndex& index,
+															int nFieldIndex = 0	) const
+	{
+		return PYXValue(smoothField(index));
+	}
+};
+
+//! Chain nSteps PYXZoomOutProcess and nSteps PYXZoomInProcess (with blurring) on an input.
+boost::intrusive_ptr<ICoverage> createZoomChain(const boost::intrusive_ptr<IProcess> & spInput,int nSteps)
+{
+	boost::intrusive_ptr<IProcess> spChain = spInput;
+	for(int n=0;n<2*nSteps;++n)
+	{
+		boost::intrusive_ptr<IProcess> spProcess;
+		if (n < nSteps)
+		{
+			spProcess = boost::intrusive_ptr<PYXZoomOutProcess>(new PYXZoomOutProcess);
+		}
+		else
+		{
+			spProcess = boost::intrusive_ptr<PYXZoomInProcess>(new PYXZoomInProcess);
+
+			std::map<std::string, std::string> attribs;
+			attribs[PYXZoomInProcess::kstrBlurringAlgor] = PYXZoomInProcess::kstrYes;
+			spProcess->setAttributes(attribs);
+		}
+
+		spProcess->getParameter(0)->addValue(spChain);
+		TEST_ASSERT(spProcess->initProc() == IProcess::knInitialized);
+		spChain = spProcess;
+	}
+	return spChain->getOutput()->QueryInterface<ICoverage>();
+}
+
+}
+
+void BlurPyramid::test()
+{
+	PYXIcosIndex root("A-0");
+	PYXTile tile(root,root.getResolution()+7);
+	const int nSteps = 2;
+
+	PYXPointer<BlurPyramid> pyramid = BlurPyramid::create(tile,nSteps,1);
+	TEST_ASSERT(pyramid->getSteps() == nSteps);
+
+	for(int i=0;i<pyramid->getCellCount(0);++i)
+	{
+		PYXIcosIndex index = pyramid->getIndex(0,i);
+		TEST_ASSERT(pyramid->getOffset(0,index) == i);
+
+		double fValue = smoothField(index);
+		pyramid->setValue(i,&fValue);
+	}
+	pyramid->downsample();
+
+	//the values of the tile, the first channel is the input
+	std::vector<int> tileOffsets;
+	double fMin = 0;
+	double fMax = 0;
+	for(PYXPointer<PYXIterator> it = tile.getIterator();!it->end();it->next())
+	{
+		int nOffset = pyramid->getOffset(0,it->getIndex());
+		TEST_ASSERT(nOffset != knNoCell);
+		tileOffsets.push_back(nOffset);
+
+		double fValue = smoothField(it->getIndex());
+		fMin = tileOffsets.size() == 1 ? fValue : std::min(fMin,fValue);
+		fMax = tileOffsets.size() == 1 ? fValue : std::max(fMax,fValue);
+	}
+	const double fTolerance = (fMax - fMin) / 100;
+
+	std::vector<double> values;
+	std::vector<unsigned char> hasValue;
+	pyramid->getChannel(0,values,hasValue);
+	for(auto nOffset : tileOffsets)
+	{
+		TEST_ASSERT(hasValue[nOffset] && values[nOffset] == smoothField(pyramid->getIndex(0,nOffset)));
+	}
+
+	//every channel matches the chain of zoom processes. The chain reads the vertices of the centroid
+	//children one resolution finer than the pyramid, so channel n is within n times 1% of the value range
+	//of the tile; the vertex children of the first channel match exactly. The chain reads the cells one
+	//by one (7 times more per step), the coarser channels are compared on a sample of the tile.
+	boost::intrusive_ptr<SmoothFieldCoverage> spField(new SmoothFieldCoverage);
+	spField->setGeometryResolution(tile.getCellResolution());
+
+	int nStride = 1;
+	for(int nChannel=1;nChannel<=nSteps;++nChannel,nStride*=7)
+	{
+		boost::intrusive_ptr<ICoverage> spChain = createZoomChain(spField,nChannel);
+		pyramid->getChannel(nChannel,values,hasValue);
+
+		double fMaxError = 0;
+		for(int n=0;n<(int)tileOffsets.size();n+=nStride)
+		{
+			int nOffset = tileOffsets[n];
+			PYXIcosIndex index = pyramid->getIndex(0,nOffset);
+			TEST_ASSERT(hasValue[nOffset]);
+
+			double fError = std::fabs(values[nOffset] - spChain->getCoverageValue(index,0).getDouble());
+			fMaxError = std::max(fMaxError,fError);
+
+			PYXMath::eHexDirection nDirection = PYXMath::knDirectionZero;
+			PYXIcosMath::directionFromParent(index,&nDirection);
+			if (nChannel == 1 && nDirection != PYXMath::knDirectionZero && !PYXIcosMath::getParent(index).isPentagon())
+			{
+				TEST_ASSERT(fError < 0.000001 * (fMax - fMin));
+			}
+		}
+		TEST_ASSERT(fMaxError < nChannel * fTolerance);
+	}
+
+	//blurring a smooth field keeps it close to the input
+	pyramid->getChannel(nSteps,values,hasValue);
+	for(auto nOffset : tileOffsets)
+	{
+		TEST_ASSERT(hasValue[nOffset]);
+		TEST_ASSERT(std::fabs(values[nOffset] - smoothField(pyramid->getIndex(0,nOffset))) < 5 * fTolerance);
+	}
+
+	//cells without values stay without values
+	{
+		PYXPointer<BlurPyramid> emptyPyramid = BlurPyramid::create(tile,nSteps,1);
+		emptyPyramid->downsample();
+		emptyPyramid->getChannel(nSteps,values,hasValue);
+		TEST_ASSERT(std::find(hasValue.begin(),hasValue.end(),1) == hasValue.end());
+	}
+
+	//a constant coverage is blurred into the same constant
+	{
+		uint8_t arrayValue[3] = {120, 180, 240};
+		boost::intrusive_ptr<ConstCoverage> spConstCoverage(new ConstCoverage);
+		spConstCoverage->setReturnValue(PYXValue(arrayValue,3),PYXFieldDefinition::knContextRGB,0);
+
+		PYXPointer<BlurPyramid> constPyramid = BlurPyramid::create(tile,nSteps,spConstCoverage);
+		TEST_ASSERT(constPyramid->getComponentCount() == 3);
+
+		for(int nChannel=0;nChannel<=nSteps;++nChannel)
+		{
+			PYXPointer<PYXValueTile> spValueTile = constPyramid->createValueTile(nChannel,spConstCoverage->getCoverageDefinition()->getFieldDefinition(0));
+			TEST_ASSERT(spValueTile->getNumberOfCells() == tile.getCellCount());
+			TEST_ASSERT(spValueTile->getValue(tile.getRootIndex(),0) == PYXValue(arrayValue,3));
+			TEST_ASSERT(spValueTile->getValue(spValueTile->getNumberOfCells()-1,0) == PYXValue(arrayValue,3));
+		}
+	}
+}
+
+void BlurPyramid::benchmark()
+{
+	PYXIcosIndex root("A-0");
+	std::vector<double> values;
+	std::vector<unsigned char> hasValue;
+
+	PYXTile largeTile(root,root.getResolution()+PYXTile::knDefaultTileDepth);
+	const int nLargeSteps = 4;
+
+	PYXHighQualityTimer timer;
+	timer.start();
+	PYXPointer<BlurPyramid> largePyramid = BlurPyramid::create(largeTile,nLargeSteps,1);
+	timer.stop();
+	double fLayoutTime = timer.getTime();
+
+	for(int i=0;i<largePyramid->getCellCount(0);++i)
+	{
+		double fValue = i % 256;
+		largePyramid->setValue(i,&fValue);
+	}
+
+	timer.start();
+	largePyramid->downsample();
+	for(int nChannel=1;nChannel<=nLargeSteps;++nChannel)
+	{
+		largePyramid->getChannel(nChannel,values,hasValue);
+	}
+	timer.stop();
+
+	TRACE_INFO("BlurPyramid: " << largePyramid->getCellCount(0) << " cells, tables built in " << fLayoutTime <<
+		"[sec], " << nLargeSteps << " channels blurred in " << timer.getTime() << "[sec]");
+}
+
+PYXPointer<BlurPyramid> BlurPyramid::create(const PYXTile & tile,int nSteps,const boost::intrusive_ptr<ICoverage> & spCoverage,int nFieldIndex)
+{
+	const PYXFieldDefinition & fieldDefinition = spCoverage->getCoverageDefinition()->getFieldDefinition(nFieldIndex);
+	PYXPointer<BlurPyramid> pyramid = PYXNEW(BlurPyramid,tile,nSteps,fieldDefinition.getCount());
+
+	const int nResolution = tile.getCellResolution();
+	const int nMaxDepth = PYXTile::knDefaultTileDepth;
+	const Level & level = pyramid->m_levels[0];
+
+	PYXTaskGroup tasks;
+	for(int nCover=0;nCover<(int)pyramid->m_cover.size();++nCover)
+	{
+		const PYXIcosIndex & root = pyramid->m_cover[nCover];
+
+		if (nResolution - root.getResolution() <= nMaxDepth)
+		{
+			tasks.addTask(boost::bind(&BlurPyramid::loadValueTile,pyramid.get(),spCoverage,root,nFieldIndex,level.tileOffsets[nCover]));
+			continue;
+		}
+
+		//deep cover cells are streamed as sub tiles, every sub tile is a run of consecutive cells
+		PYXTile subTiles(root,nResolution-nMaxDepth);
+		for(PYXPointer<PYXIterator> it = subTiles.getIterator();!it->end();it->next())
+		{
+			PYXIcosIndex firstCell = it->getIndex();
+			firstCell.setResolution(nResolution);
+			int nFirstOffset = level.tileOffsets[nCover] + PYXIcosMath::calcCellPosition(root,firstCell);
+
+			tasks.addTask(boost::bind(&BlurPyramid::loadValueTile,pyramid.get(),spCoverage,it->getIndex(),nFieldIndex,nFirstOffset));
+		}
+	}
+	tasks.joinAll();
+
+	pyramid->downsample();
+	return pyramid;
+}
+
+BlurPyramid::BlurPyramid(const PYXTile & tile,int nSteps,int nComponents) :
+	m_tile(tile),
+	m_nComponents(nComponents),
+	m_nCoverResolution(0)
+{
+	assert(nComponents > 0 && "A value needs at least a component");
+	buildLayout(nSteps);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Layout
+////////////////////////////////////////////////////////////////////////////////
+
+/*!
+The cover cells are coarse enough for the margin to hold the cells the kernels
+read around the tile: knMarginResolutions resolutions coarser than the coarsest
+level.
+*/
+void BlurPyramid::buildLayout(int nSteps)
+{
+	const PYXIcosIndex & root = m_tile.getRootIndex();
+	const int nResolution = m_tile.getCellResolution();
+
+	nSteps = std::max(0,std::min(nSteps,nResolution - PYXIcosIndex::knMinSubRes));
+	m_nCoverResolution = std::max(PYXIcosIndex::knMinSubRes,nResolution - nSteps - knMarginResolutions);
+
+	//the cells of the tile at the cover resolution
+	std::vector<PYXIcosIndex> inner;
+	if (m_nCoverResolution >= root.getResolution())
+	{
+		PYXTile innerTile(root,m_nCoverResolution);
+		for(PYXPointer<PYXIterator> it = innerTile.getIterator();!it->end();it->next())
+		{
+			inner.push_back(it->getIndex());
+		}
+	}
+	else
+	{
+		PYXIcosIndex ancestor = root;
+		ancestor.setResolution(m_nCoverResolution);
+		inner.push_back(ancestor);
+	}
+
+	//and their neighbours
+	std::set<PYXIcosIndex> cover;
+	for(auto & index : inner)
+	{
+		for(PYXNeighbourIterator it(index);!it.end();it.next())
+		{
+			cover.insert(it.getIndex());
+		}
+	}
+	m_cover.assign(cover.begin(),cover.end());
+	for(int nCover=0;nCover<(int)m_cover.size();++nCover)
+	{
+		m_coverOffsets[m_cover[nCover]] = nCover;
+	}
+
+	m_levels.resize(nSteps+1);
+	for(int nLevel=0;nLevel<=nSteps;++nLevel)
+	{
+		Level & level = m_levels[nLevel];
+
+		level.tileOffsets.push_back(0);
+		for(auto & index : m_cover)
+		{
+			level.tileOffsets.push_back(level.tileOffsets.back() + PYXIcosMath::getCellCount(index,getResolution(nLevel)));
+		}
+
+		int nCellCount = level.tileOffsets.back();
+		level.values.resize(nCellCount*m_nComponents,0);
+		level.hasValue.resize(nCellCount,0);
+
+		if (nLevel > 0)
+		{
+			level.down.resize(nCellCount);
+		}
+		if (nLevel < nSteps)
+		{
+			level.up.resize(nCellCount);
+		}
+	}
+
+	//every cover cell writes its own range of the tables
+	PYXTaskGroup tasks;
+	for(int nLevel=0;nLevel<=nSteps;++nLevel)
+	{
+		for(int nCover=0;nCover<(int)m_cover.size();++nCover)
+		{
+			tasks.addTask(boost::bind(&BlurPyramid::buildTables,this,nLevel,nCover));
+		}
+	}
+	tasks.joinAll();
+
+	//the cells of the tile are runs of consecutive cells of level 0
+	for(auto & index : inner)
+	{
+		PYXIcosIndex firstCell = index.getResolution() < root.getResolution() ? root : index;
+		firstCell.setResolution(nResolution);
+
+		Run run;
+		run.nTileOffset = PYXIcosMath::calcCellPosition(root,firstCell);
+		run.nLevelOffset = getOffset(0,firstCell);
+		run.nCount = index.getResolution() < root.getResolution() ? m_tile.getCellCount() : PYXIcosMath::getCellCount(index,nResolution);
+		m_runs.push_back(run);
+	}
+}
+
+void BlurPyramid::buildTables(int nLevel,int nCover)
+{
+	Level & level = m_levels[nLevel];
+	const PYXIcosIndex & root = m_cover[nCover];
+	const int nResolution = getResolution(nLevel);
+	const int nFirst = level.tileOffsets[nCover];
+	const int nCount = level.tileOffsets[nCover+1] - nFirst;
+
+	for(int nLocal=0;nLocal<nCount;++nLocal)
+	{
+		const int nOffset = nFirst + nLocal;
+		PYXIcosIndex index = PYXIcosMath::calcIndexFromOffset(root,nResolution,nLocal);
+
+		if (!level.down.empty())
+		{
+			DownCell & cell = level.down[nOffset];
+
+			PYXIcosIndex centroid = index;
+			centroid.incrementResolution();
+			cell.nCentroid = getOffset(nLevel-1,centroid);
+
+			cell.nVertexCount = 0;
+			for(PYXVertexIterator it(index);!it.end() && cell.nVertexCount<6;it.next())
+			{
+				cell.vertices[cell.nVertexCount++] = getOffset(nLevel-1,it.getIndex());
+			}
+		}
+
+		if (!level.up.empty())
+		{
+			UpCell & cell = level.up[nOffset];
+
+			PYXIcosIndex parent = PYXIcosMath::getParent(index);
+			PYXMath::eHexDirection nDirection = PYXMath::knDirectionZero;
+			PYXIcosMath::directionFromParent(index,&nDirection);
+
+			cell.nParent = getOffset(nLevel+1,parent);
+			cell.bCentroid = parent.isPentagon() || nDirection == PYXMath::knDirectionZero;
+			cell.nNeighbourCount = 0;
+
+			if (cell.bCentroid)
+			{
+				//the neighbours are in counter-clockwise order, every two consecutive neighbours share a vertex with the parent
+				PYXNeighbourIterator it(parent);
+				it.next(); //skip self
+
+				for(;!it.end() && cell.nNeighbourCount<6;it.next())
+				{
+					cell.neighbours[cell.nNeighbourCount++] = getOffset(nLevel+1,it.getIndex());
+				}
+			}
+			else
+			{
+				PYXMath::eHexDirection nDirection2 = PYXMath::rotateDirection(nDirection,
+					(PYXMath::getHexClass(parent.getResolution()) == PYXMath::knClassI) ? 1 : -1);
+
+				cell.neighbours[cell.nNeighbourCount++] = getOffset(nLevel+1,PYXIcosMath::move(parent,nDirection));
+				cell.neighbours[cell.nNeighbourCount++] = getOffset(nLevel+1,PYXIcosMath::move(parent,nDirection2));
+			}
+		}
+	}
+}
+
+int BlurPyramid::getOffset(int nLevel,const PYXIcosIndex & index) const
+{
+	if (index.getResolution() != getResolution(nLevel))
+	{
+		return knNoCell;
+	}
+
+	PYXIcosIndex root = index;
+	root.setResolution(m_nCoverResolution);
+
+	std::map<PYXIcosIndex,int>::const_iterator it = m_coverOffsets.find(root);
+	if (it == m_coverOffsets.end())
+	{
+		return knNoCell;
+	}
+
+	return m_levels[nLevel].tileOffsets[it->second] + PYXIcosMath::calcCellPosition(m_cover[it->second],index);
+}
+
+PYXIcosIndex BlurPyramid::getIndex(int nLevel,int nOffset) const
+{
+	assert(nOffset >= 0 && nOffset < getCellCount(nLevel) && "Invalid offset");
+
+	const std::vector<int> & tileOffsets = m_levels[nLevel].tileOffsets;
+	int nCover = (int)(std::upper_bound(tileOffsets.begin(),tileOffsets.end(),nOffset) - tileOffsets.begin()) - 1;
+
+	return PYXIcosMath::calcIndexFromOffset(m_cover[nCover],getResolution(nLevel),nOffset - tileOffsets[nCover]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Values
+////////////////////////////////////////////////////////////////////////////////
+
+void BlurPyramid::setValue(int nOffset,const double * pValues)
+{
+	Level & level = m_levels[0];
+
+	std::copy(pValues,pValues+m_nComponents,level.values.begin()+nOffset*m_nComponents);
+	level.hasValue[nOffset] = 1;
+}
+
+void BlurPyramid::loadValueTile(const boost::intrusive_ptr<ICoverage> & spCoverage,const PYXIcosIndex & root,int nFieldIndex,int nFirstOffset)
+{
+	PYXPointer<PYXValueTile> spValueTile = spCoverage->getFieldTile(root,m_tile.getCellResolution(),nFieldIndex);
+	if (!spValueTile)
+	{
+		return;
+	}
+
+	Level & level = m_levels[0];
+	PYXValue value = spValueTile->getTypeCompatibleValue(0);
+	const int nCount = spValueTile->getNumberOfCells();
+
+	for(int n=0;n<nCount;++n)
+	{
+		if (spValueTile->getValue(n,0,&value) && !value.isNull())
+		{
+			const int nOffset = nFirstOffset + n;
+			for(int nComponent=0;nComponent<m_nComponents;++nComponent)
+			{
+				level.values[nOffset*m_nComponents+nComponent] = value.getDouble(nComponent);
+			}
+			level.hasValue[nOffset] = 1;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Blur
+////////////////////////////////////////////////////////////////////////////////
+
+void BlurPyramid::downsample()
+{
+	for(int nLevel=1;nLevel<(int)m_levels.size();++nLevel)
+	{
+		downsample(nLevel);
+	}
+}
+
+void BlurPyramid::downsample(int nLevel)
+{
+	const Level & fine = m_levels[nLevel-1];
+	Level & level = m_levels[nLevel];
+	const int nCellCount = getCellCount(nLevel);
+	const double kfOneThird = 1.0/3.0;
+
+	std::vector<double> accumulator(m_nComponents);
+
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		const DownCell & cell = level.down[nOffset];
+
+		std::fill(accumulator.begin(),accumulator.end(),0.0);
+		double fTotalWeight = 0;
+
+		if (accumulate(fine.values,fine.hasValue,cell.nCentroid,m_nComponents,1,&accumulator[0]))
+		{
+			fTotalWeight += 1;
+		}
+
+		for(int nVertex=0;nVertex<cell.nVertexCount;++nVertex)
+		{
+			if (accumulate(fine.values,fine.hasValue,cell.vertices[nVertex],m_nComponents,kfOneThird,&accumulator[0]))
+			{
+				fTotalWeight += kfOneThird;
+			}
+		}
+
+		level.hasValue[nOffset] = fTotalWeight > 0;
+		for(int nComponent=0;nComponent<m_nComponents;++nComponent)
+		{
+			level.values[nOffset*m_nComponents+nComponent] = fTotalWeight > 0 ? accumulator[nComponent] / fTotalWeight : 0;
+		}
+	}
+}
+
+void BlurPyramid::upsample(	int nLevel,
+							const std::vector<double> & coarseValues,
+							const std::vector<unsigned char> & coarseHasValue,
+							std::vector<double> & values,
+							std::vector<unsigned char> & hasValue	) const
+{
+	const Level & level = m_levels[nLevel];
+	const int nCellCount = getCellCount(nLevel);
+
+	values.assign(nCellCount*m_nComponents,0);
+	hasValue.assign(nCellCount,0);
+
+	std::vector<double> accumulator(m_nComponents);
+	std::vector<double> vertexAccumulator(m_nComponents);
+
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		const UpCell & cell = level.up[nOffset];
+
+		std::fill(accumulator.begin(),accumulator.end(),0.0);
+		double fTotalWeight = 0;
+
+		if (!cell.bCentroid)
+		{
+			//the average of the 3 cells around the vertex child
+			if (accumulate(coarseValues,coarseHasValue,cell.nParent,m_nComponents,1,&accumulator[0]))
+			{
+				fTotalWeight += 1;
+			}
+			for(int nNeighbour=0;nNeighbour<cell.nNeighbourCount;++nNeighbour)
+			{
+				if (accumulate(coarseValues,coarseHasValue,cell.neighbours[nNeighbour],m_nComponents,1,&accumulator[0]))
+				{
+					fTotalWeight += 1;
+				}
+			}
+		}
+		else
+		{
+			//weight the parent 5 times to a vertex's 2 times
+			if (accumulate(coarseValues,coarseHasValue,cell.nParent,m_nComponents,5,&accumulator[0]))
+			{
+				fTotalWeight += 5;
+			}
+
+			for(int nNeighbour=0;nNeighbour<cell.nNeighbourCount;++nNeighbour)
+			{
+				std::fill(vertexAccumulator.begin(),vertexAccumulator.end(),0.0);
+				int nVertexCount = 0;
+
+				nVertexCount += accumulate(coarseValues,coarseHasValue,cell.nParent,m_nComponents,1,&vertexAccumulator[0]) ? 1 : 0;
+				nVertexCount += accumulate(coarseValues,coarseHasValue,cell.neighbours[nNeighbour],m_nComponents,1,&vertexAccumulator[0]) ? 1 : 0;
+				nVertexCount += accumulate(coarseValues,coarseHasValue,cell.neighbours[(nNeighbour+1)%cell.nNeighbourCount],m_nComponents,1,&vertexAccumulator[0]) ? 1 : 0;
+
+				if (nVertexCount > 0)
+				{
+					for(int nComponent=0;nComponent<m_nComponents;++nComponent)
+					{
+						accumulator[nComponent] += 2 * vertexAccumulator[nComponent] / nVertexCount;
+					}
+					fTotalWeight += 2;
+				}
+			}
+		}
+
+		if (fTotalWeight > 0)
+		{
+			hasValue[nOffset] = 1;
+			for(int nComponent=0;nComponent<m_nComponents;++nComponent)
+			{
+				values[nOffset*m_nComponents+nComponent] = accumulator[nComponent] / fTotalWeight;
+			}
+		}
+	}
+}
+
+void BlurPyramid::getChannel(int nChannel,std::vector<double> & values,std::vector<unsigned char> & hasValue) const
+{
+	nChannel = std::max(0,std::min(nChannel,getSteps()));
+
+	values = m_levels[nChannel].values;
+	hasValue = m_levels[nChannel].hasValue;
+
+	std::vector<double> fineValues;
+	std::vector<unsigned char> fineHasValue;
+	for(int nLevel=nChannel-1;nLevel>=0;--nLevel)
+	{
+		upsample(nLevel,values,hasValue,fineValues,fineHasValue);
+		values.swap(fineValues);
+		hasValue.swap(fineHasValue);
+	}
+}
+
+PYXPointer<PYXValueTile> BlurPyramid::createValueTile(int nChannel,const PYXFieldDefinition & fieldDefinition) const
+{
+	PYXPointer<PYXTableDefinition> spDefinition = PYXTableDefinition::create();
+	spDefinition->addFieldDefinition(fieldDefinition);
+	PYXPointer<PYXValueTile> spValueTile = PYXValueTile::create(m_tile.getRootIndex(),m_tile.getCellResolution(),spDefinition);
+
+	std::vector<double> values;
+	std::vector<unsigned char> hasValue;
+	getChannel(nChannel,values,hasValue);
+
+	PYXValue value = spValueTile->getTypeCompatibleValue(0);
+	for(auto & run : m_runs)
+	{
+		for(int n=0;n<run.nCount;++n)
+		{
+			const int nOffset = run.nLevelOffset + n;
+			if (!hasValue[nOffset])
+			{
+				continue;
+			}
+
+			for(int nComponent=0;nComponent<m_nComponents;++nComponent)
+			{
+				value.setDouble(nComponent,values[nOffset*m_nComponents+nComponent]);
+			}
+			spValueTile->setValue(run.nTileOffset+n,0,value);
+		}
+	}
+	return spValueTile;
+}
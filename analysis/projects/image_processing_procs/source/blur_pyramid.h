@@ -0,0 +1,192 @@
+#ifndef BLUR_PYRAMID_H
+#define BLUR_PYRAMID_H
+/******************************************************************************
+blur_pyramid.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// local includes
+#include "module_image_processing_procs.h"
+
+// pyxlib includes
+#include "pyxis/data/coverage.h"
+#include "pyxis/data/value_tile.h"
+#include "pyxis/geometry/tile.h"
+#include "pyxis/utility/object.h"
+
+// standard includes
+#include <map>
+#include <vector>
+
+/*!
+BlurPyramid computes the channels of the blur process for a tile on dense arrays
+of cells.
+
+The pyramid has a level per resolution, from the tile resolution (level 0) down
+to nSteps resolutions coarser. Every level covers the tile and a margin around
+it: the cover cells are the cells of the tile (or its ancestor) at a coarse
+resolution and their neighbours, and every level lays the descendants of the
+cover cells one after the other, in the usual PYXIS exhaustive order.
+
+The input values are loaded into level 0, one value tile at a time, and the
+coarser levels are computed once by downsampling. The parent, children, vertex
+and neighbour cells used by the kernels are resolved once into offset tables,
+so the blur itself never touches PYXIcosIndex or the coverage.
+
+Channel n is level n upsampled n times back to the tile resolution (channel 0
+is the input). The kernels are the ones of PYXZoomOutProcess (average the
+centroid child and a third of every vertex child) and PYXZoomInProcess with
+blurring (a vertex child is the average of the 3 cells around it, a centroid
+child weights its parent 5 times and each of its vertices twice, the vertex
+values being the average of the 3 coarse cells around them). Null cells and
+cells outside the pyramid are skipped.
+*/
+//! Fused multi-resolution blur of a tile.
+class MODULE_IMAGE_PROCESSING_PROCS_DECL BlurPyramid : public PYXObject
+{
+public:
+	//! Test method
+	static void test();
+
+	//! Time building and blurring a default depth tile with 4 steps (not run by the tests).
+	static void benchmark();
+
+	//! Offset used for cells outside a level.
+	static const int knNoCell = -1;
+
+	//! The margin around the tile, in resolutions coarser than the coarsest level.
+	static const int knMarginResolutions = 3;
+
+public:
+	//! Create a pyramid over a tile and load the values from the coverage.
+	static PYXPointer<BlurPyramid> create(const PYXTile & tile,int nSteps,const boost::intrusive_ptr<ICoverage> & spCoverage,int nFieldIndex = 0);
+
+	//! Create a pyramid over a tile without values (see setValue and downsample).
+	static PYXPointer<BlurPyramid> create(const PYXTile & tile,int nSteps,int nComponents)
+	{
+		return PYXNEW(BlurPyramid,tile,nSteps,nComponents);
+	}
+
+	BlurPyramid(const PYXTile & tile,int nSteps,int nComponents);
+
+public:
+	const PYXTile & getTile() const { return m_tile; }
+
+	//! The number of steps, it can be less than requested for tiles close to the primary resolution.
+	int getSteps() const { return (int)m_levels.size() - 1; }
+
+	int getComponentCount() const { return m_nComponents; }
+
+	//! The cell resolution of a level.
+	int getResolution(int nLevel) const { return m_tile.getCellResolution() - nLevel; }
+
+	//! Number of cells in a level.
+	int getCellCount(int nLevel) const { return m_levels[nLevel].tileOffsets.back(); }
+
+	//! Offset of a cell in a level, or knNoCell if the cell is not in the level.
+	int getOffset(int nLevel,const PYXIcosIndex & index) const;
+
+	//! The index of the cell at the given offset of a level.
+	PYXIcosIndex getIndex(int nLevel,int nOffset) const;
+
+	//! Set the input value of a cell of level 0 (getComponentCount values).
+	void setValue(int nOffset,const double * pValues);
+
+	//! Compute the coarser levels from level 0.
+	void downsample();
+
+	/*!
+	Compute a channel at the tile resolution.
+
+	\param nChannel	The channel, 0 for the input (clamped to getSteps()).
+	\param values	The values of the cells of level 0, getComponentCount values per cell (out).
+	\param hasValue	Whether every cell of level 0 has a value (out).
+	*/
+	void getChannel(int nChannel,std::vector<double> & values,std::vector<unsigned char> & hasValue) const;
+
+	//! Create the value tile of a channel for the tile.
+	PYXPointer<PYXValueTile> createValueTile(int nChannel,const PYXFieldDefinition & fieldDefinition) const;
+
+private:
+	//! The cells of a coarser level used to downsample a cell.
+	struct DownCell
+	{
+		int nCentroid;
+		int vertices[6];
+		int nVertexCount;
+	};
+
+	//! The cells of a coarser level used to upsample a cell.
+	struct UpCell
+	{
+		int nParent;
+		int neighbours[6];
+		int nNeighbourCount;
+
+		//! True if the cell is blurred from the parent and its vertices, false if it is the average of 3 cells.
+		bool bCentroid;
+	};
+
+	struct Level
+	{
+		//! Offset of the first cell of every cover cell, and the total cell count at the end.
+		std::vector<int> tileOffsets;
+
+		std::vector<double> values;
+		std::vector<unsigned char> hasValue;
+
+		//! Cells of the finer level, for every cell (empty for level 0).
+		std::vector<DownCell> down;
+
+		//! Cells of the coarser level, for every cell (empty for the coarsest level).
+		std::vector<UpCell> up;
+	};
+
+	//! A run of consecutive cells of the tile in level 0.
+	struct Run
+	{
+		int nTileOffset;
+		int nLevelOffset;
+		int nCount;
+	};
+
+	//! Find the cover cells and lay out the levels.
+	void buildLayout(int nSteps);
+
+	//! Resolve the offset tables of the cells of a cover cell in a level.
+	void buildTables(int nLevel,int nCover);
+
+	//! Load the values of a cover cell from the coverage.
+	void loadValueTile(const boost::intrusive_ptr<ICoverage> & spCoverage,const PYXIcosIndex & root,int nFieldIndex,int nFirstOffset);
+
+	//! Compute the values of a level from the finer level.
+	void downsample(int nLevel);
+
+	//! Compute the values of a level from the values of the coarser level.
+	void upsample(	int nLevel,
+					const std::vector<double> & coarseValues,
+					const std::vector<unsigned char> & coarseHasValue,
+					std::vector<double> & values,
+					std::vector<unsigned char> & hasValue	) const;
+
+private:
+	PYXTile m_tile;
+
+	int m_nComponents;
+
+	//! The resolution of the cover cells.
+	int m_nCoverResolution;
+
+	std::vector<PYXIcosIndex> m_cover;
+	std::map<PYXIcosIndex,int> m_coverOffsets;
+
+	std::vector<Level> m_levels;
+
+	//! The cells of the tile in level 0.
+	std::vector<Run> m_runs;
+};
+
+#endif // guard
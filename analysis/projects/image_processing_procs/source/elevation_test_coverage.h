@@ -0,0 +1,83 @@
+#ifndef ELEVATION_TEST_COVERAGE_H
+#define ELEVATION_TEST_COVERAGE_H
+/******************************************************************************
+elevation_test_coverage.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxis/derm/index_math.h"
+#include "pyxis/derm/snyder_projection.h"
+#include "pyxis/procs/const_coverage.h"
+
+// standard includes
+#include <cmath>
+
+/*!
+A synthetic elevation coverage used by the hydrology tests: rolling hills made of
+sine waves, rounded to whole meters so there are flat areas, with a few cells
+without elevation acting as sinks. The values only depend on the cell position,
+so any set of tiles sees the same surface.
+*/
+//! Synthetic elevation coverage for tests.
+class ElevationTestCoverage : public ConstCoverage
+{
+public:
+	ElevationTestCoverage()
+	{
+		setReturnValue(PYXValue(0.0),PYXFieldDefinition::knContextElevation);
+	}
+
+	//! The elevation of a cell, returns false if the cell has no elevation.
+	static bool getElevation(const PYXIcosIndex & index,double * pfElevation)
+	{
+		PYXCoord3DDouble xyz;
+		SnyderProjection::getInstance()->pyxisToXYZ(index,&xyz);
+
+		if (sin(997*xyz.x())*sin(1009*xyz.y()) > 0.98)
+		{
+			return false;
+		}
+
+		*pfElevation = floor(100*(sin(157*xyz.x())+sin(211*xyz.y())+sin(263*xyz.z())));
+		return true;
+	}
+
+public: // ICoverage
+
+	virtual PYXPointer<PYXValueTile> STDMETHODCALLTYPE getFieldTile(	const PYXIcosIndex& index,
+																		int nRes,
+																		int nFieldIndex = 0	) const
+	{
+		PYXPointer<PYXTableDefinition> spCovDefn = PYXTableDefinition::create();
+		spCovDefn->addFieldDefinition(getCoverageDefinition()->getFieldDefinition(nFieldIndex));
+		PYXPointer<PYXValueTile> spValueTile = PYXValueTile::create(index,nRes,spCovDefn);
+
+		const int nCellCount = spValueTile->getNumberOfCells();
+		for (int n = 0; n < nCellCount; ++n)
+		{
+			double fElevation;
+			if (getElevation(PYXIcosMath::calcIndexFromOffset(index,nRes,n),&fElevation))
+			{
+				spValueTile->setValue(n,0,PYXValue(fElevation));
+			}
+		}
+		return spValueTile;
+	}
+
+	virtual PYXValue STDMETHODCALLTYPE getCoverageValue(	const PYXIcosIndex& index,
+															int nFieldIndex = 0	) const
+	{
+		double fElevation;
+		if (getElevation(index,&fElevation))
+		{
+			return PYXValue(fElevation);
+		}
+		return PYXValue();
+	}
+};
+
+#endif // guard
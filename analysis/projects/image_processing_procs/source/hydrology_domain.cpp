@@ -0,0 +1,517 @@
+/******************************************************************************
+hydrology_domain.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "stdafx.h"
+#define MODULE_IMAGE_PROCESSING_PROCS_SOURCE
+#include "hydrology_domain.h"
+
+// local includes
+#include "elevation_test_coverage.h"
+
+// pyxlib includes
+#include "pyxis/derm/index_math.h"
+#include "pyxis/derm/neighbour_iterator.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+
+// boost includes
+#include <boost/bind.hpp>
+
+// standard includes
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+
+//! Tester class
+Tester<HydrologyDomain> gTester;
+
+}
+
+void HydrologyDomain::test()
+{
+	boost::intrusive_ptr<ElevationTestCoverage> spElevation(new ElevationTestCoverage);
+
+	//a pentagon and a hexagon domain
+	const char * roots[] = { "A-0", "1-02" };
+	for(auto & strRoot : roots)
+	{
+		PYXIcosIndex index(strRoot);
+		index.setResolution(10);
+
+		PYXPointer<HydrologyDomain> domain = HydrologyDomain::create(index,6,3,spElevation);
+
+		TEST_ASSERT(domain->getRoot().getResolution() == 4);
+		TEST_ASSERT(domain->getRoot().isAncestorOf(index));
+		TEST_ASSERT(domain->findTile(index) >= 0);
+		TRACE_INFO("HydrologyDomain analyzed " << domain->getTiles().size() << " tiles with " << domain->getFillCount() << " fills");
+
+		//the tiled analysis matches the analysis of the whole domain at once
+		PYXPointer<HydrologyGrid> grid = HydrologyGrid::create(domain->getTiles(),spElevation);
+		grid->analyze();
+
+		int nFirst = 0;
+		int nCrossingCells = 0;
+		for(int nTile=0;nTile<(int)domain->getTiles().size();++nTile)
+		{
+			PYXPointer<HydrologyGrid> tileGrid = domain->analyzeTile(nTile);
+
+			for(int i=0;i<tileGrid->getCellCount();++i)
+			{
+				const int n = nFirst + i;
+				TEST_ASSERT(tileGrid->hasElevation(i) == grid->hasElevation(n));
+				if (!grid->hasElevation(n))
+				{
+					continue;
+				}
+
+				TEST_ASSERT(tileGrid->getElevation(i) == grid->getElevation(n));
+				TEST_ASSERT(tileGrid->getFlowDirection(i) == grid->getFlowDirection(n));
+				TEST_ASSERT(tileGrid->getFlowAccumulation(i) == grid->getFlowAccumulation(n));
+				TEST_ASSERT(tileGrid->getBasin(i) == grid->getBasin(n));
+
+				if (tileGrid->getBasin(i) < nFirst || tileGrid->getBasin(i) >= nFirst + tileGrid->getCellCount())
+				{
+					++nCrossingCells;
+				}
+			}
+			nFirst += tileGrid->getCellCount();
+		}
+		TEST_ASSERT(nFirst == grid->getCellCount());
+
+		//the surface has basins larger than a tile
+		TEST_ASSERT(nCrossingCells > 0);
+	}
+}
+
+PYXPointer<HydrologyDomain> HydrologyDomain::create(	const PYXIcosIndex & index,
+														int nDomainDepth,
+														int nTileDepth,
+														const boost::intrusive_ptr<ICoverage> & elevation,
+														int nFieldIndex	)
+{
+	PYXIcosIndex root = index;
+	root.setResolution(std::max(2,index.getResolution()-nDomainDepth));
+
+	const int nTileResolution = std::max(root.getResolution(),index.getResolution()-nTileDepth);
+
+	PYXPointer<HydrologyDomain> domain = PYXNEW(HydrologyDomain,root,index.getResolution(),nTileResolution,elevation,nFieldIndex);
+	domain->calculateBorderElevations();
+	domain->calculateInflows();
+	return domain;
+}
+
+HydrologyDomain::HydrologyDomain(	const PYXIcosIndex & root,
+									int nCellResolution,
+									int nTileResolution,
+									const boost::intrusive_ptr<ICoverage> & elevation,
+									int nFieldIndex	) :
+	m_root(root),
+	m_nCellResolution(nCellResolution),
+	m_nTileResolution(nTileResolution),
+	m_spElevation(elevation),
+	m_nFieldIndex(nFieldIndex),
+	m_nFillCount(0)
+{
+	buildTiles();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tiles
+////////////////////////////////////////////////////////////////////////////////
+
+int HydrologyDomain::findTile(const PYXIcosIndex & index) const
+{
+	if (index.getResolution() < m_nTileResolution)
+	{
+		return -1;
+	}
+
+	PYXIcosIndex tileRoot = index;
+	tileRoot.setResolution(m_nTileResolution);
+
+	std::map<PYXIcosIndex,int>::const_iterator it = m_tileNumbers.find(tileRoot);
+	return it == m_tileNumbers.end() ? -1 : it->second;
+}
+
+void HydrologyDomain::buildTiles()
+{
+	//the tiles of every cell of the domain are consecutive
+	for(PYXNeighbourIterator it(m_root);!it.end();it.next())
+	{
+		if (m_nTileResolution == m_root.getResolution())
+		{
+			m_tileNumbers[it.getIndex()] = (int)m_tiles.size();
+			m_tiles.push_back(PYXTile(it.getIndex(),m_nCellResolution));
+			continue;
+		}
+
+		PYXTile cover(it.getIndex(),m_nTileResolution);
+		for(PYXPointer<PYXIterator> itTile = cover.getIterator();!itTile->end();itTile->next())
+		{
+			m_tileNumbers[itTile->getIndex()] = (int)m_tiles.size();
+			m_tiles.push_back(PYXTile(itTile->getIndex(),m_nCellResolution));
+		}
+	}
+
+	m_tileData.resize(m_tiles.size());
+	int nOffset = 0;
+	for(int nTile=0;nTile<(int)m_tiles.size();++nTile)
+	{
+		m_tileData[nTile].nOffset = nOffset;
+		nOffset += m_tiles[nTile].getCellCount();
+	}
+
+	//the neighbour tile and cell of every edge
+	std::vector<std::vector<std::pair<int,int>>> neighbours(m_tiles.size());
+
+	PYXTaskGroup tasks;
+	for(int nTile=0;nTile<(int)m_tiles.size();++nTile)
+	{
+		tasks.addTask(boost::bind(&HydrologyDomain::buildEdges,this,nTile,&neighbours[nTile]));
+	}
+	tasks.joinAll();
+
+	//the border cells of a tile are the cells its neighbour tiles see
+	for(int nTile=0;nTile<(int)m_tiles.size();++nTile)
+	{
+		for(auto & neighbour : neighbours[nTile])
+		{
+			if (neighbour.first >= 0)
+			{
+				m_tileData[neighbour.first].borderCells.push_back(neighbour.second);
+				m_tileData[neighbour.first].readers.push_back(nTile);
+			}
+		}
+	}
+
+	for(auto & tile : m_tileData)
+	{
+		std::sort(tile.borderCells.begin(),tile.borderCells.end());
+		tile.borderCells.erase(std::unique(tile.borderCells.begin(),tile.borderCells.end()),tile.borderCells.end());
+		std::sort(tile.readers.begin(),tile.readers.end());
+		tile.readers.erase(std::unique(tile.readers.begin(),tile.readers.end()),tile.readers.end());
+
+		tile.borderElevations.assign(tile.borderCells.size(),HydrologyGrid::kfUnknown);
+	}
+
+	for(int nTile=0;nTile<(int)m_tiles.size();++nTile)
+	{
+		std::vector<Edge> & edges = m_tileData[nTile].edges;
+		for(int nEdge=0;nEdge<(int)edges.size();++nEdge)
+		{
+			const std::pair<int,int> & neighbour = neighbours[nTile][nEdge];
+			if (neighbour.first >= 0)
+			{
+				const std::vector<int> & borderCells = m_tileData[neighbour.first].borderCells;
+				edges[nEdge].nBorder = (int)(std::lower_bound(borderCells.begin(),borderCells.end(),neighbour.second) - borderCells.begin());
+			}
+		}
+	}
+}
+
+void HydrologyDomain::buildEdges(int nTile,std::vector<std::pair<int,int>> * pNeighbours)
+{
+	PYXPointer<HydrologyGrid> grid = HydrologyGrid::create(std::vector<PYXTile>(1,m_tiles[nTile]));
+
+	std::vector<Edge> & edges = m_tileData[nTile].edges;
+	for(auto & outside : grid->getOutsideNeighbours())
+	{
+		Edge edge;
+		edge.nCell = outside.nOffset;
+		edge.nSlot = outside.nSlot;
+		edge.nTile = findTile(outside.index);
+		edge.nBorder = -1;
+		edges.push_back(edge);
+
+		pNeighbours->push_back(std::pair<int,int>(
+			edge.nTile,
+			edge.nTile >= 0 ? PYXIcosMath::calcCellPosition(m_tiles[edge.nTile].getRootIndex(),outside.index) : -1));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Analysis
+////////////////////////////////////////////////////////////////////////////////
+
+PYXPointer<HydrologyGrid> HydrologyDomain::fillTile(int nTile) const
+{
+	PYXPointer<HydrologyGrid> grid = HydrologyGrid::create(std::vector<PYXTile>(1,m_tiles[nTile]),m_spElevation,m_nFieldIndex);
+
+	//the edges are in the order of the outside neighbours of the grid
+	for(auto & edge : m_tileData[nTile].edges)
+	{
+		if (edge.nTile >= 0)
+		{
+			double fElevation = m_tileData[edge.nTile].borderElevations[edge.nBorder];
+			if (fElevation != HydrologyGrid::kfDrain)
+			{
+				grid->setOutsideElevation(edge.nCell,edge.nSlot,fElevation);
+			}
+		}
+	}
+
+	grid->fillDepressions();
+	return grid;
+}
+
+void HydrologyDomain::fillBorder(int nTile,std::vector<double> * pBorder) const
+{
+	PYXPointer<HydrologyGrid> grid = fillTile(nTile);
+
+	for(auto & nCell : m_tileData[nTile].borderCells)
+	{
+		pBorder->push_back(grid->hasElevation(nCell) ? grid->getElevation(nCell) : HydrologyGrid::kfDrain);
+	}
+}
+
+/*!
+The border elevations start unknown (no water flows into the tile) and only get
+lower: a tile filled with upper bounds on its border gives upper bounds, and the
+lowest spill path of every cell reaches the tile through one of its border cells.
+The fill stops when no border value changes, which is the filled elevation of the
+whole domain.
+*/
+void HydrologyDomain::calculateBorderElevations()
+{
+	std::vector<unsigned char> dirty(m_tiles.size(),1);
+
+	for(;;)
+	{
+		std::vector<int> tiles;
+		for(int nTile=0;nTile<(int)m_tiles.size();++nTile)
+		{
+			if (dirty[nTile])
+			{
+				tiles.push_back(nTile);
+				dirty[nTile] = 0;
+			}
+		}
+
+		if (tiles.empty())
+		{
+			break;
+		}
+
+		//every round reads the border values of the previous round
+		std::vector<std::vector<double>> borders(tiles.size());
+
+		PYXTaskGroup tasks;
+		for(int i=0;i<(int)tiles.size();++i)
+		{
+			tasks.addTask(boost::bind(&HydrologyDomain::fillBorder,this,tiles[i],&borders[i]));
+		}
+		tasks.joinAll();
+
+		m_nFillCount += (int)tiles.size();
+
+		for(int i=0;i<(int)tiles.size();++i)
+		{
+			Tile & tile = m_tileData[tiles[i]];
+			if (borders[i] != tile.borderElevations)
+			{
+				tile.borderElevations.swap(borders[i]);
+				for(auto & nReader : tile.readers)
+				{
+					dirty[nReader] = 1;
+				}
+			}
+		}
+	}
+}
+
+bool HydrologyDomain::isEdgeBefore(const Edge & a,const Edge & b)
+{
+	return a.nCell < b.nCell || (a.nCell == b.nCell && a.nSlot < b.nSlot);
+}
+
+void HydrologyDomain::summarize(int nTile,Summary * pSummary) const
+{
+	PYXPointer<HydrologyGrid> grid = fillTile(nTile);
+	grid->calculateFlowDirection();
+	grid->calculateFlowAccumulation();
+	grid->calculateBasins();
+
+	const std::vector<Edge> & edges = m_tileData[nTile].edges;
+	for(int nCell=0;nCell<grid->getCellCount();++nCell)
+	{
+		const int nSlot = grid->getFlowSlot(nCell);
+		if (nSlot < 0)
+		{
+			continue;
+		}
+
+		Edge key;
+		key.nCell = nCell;
+		key.nSlot = nSlot;
+		std::vector<Edge>::const_iterator edge = std::lower_bound(edges.begin(),edges.end(),key,&isEdgeBefore);
+		assert(edge != edges.end() && edge->nCell == nCell && edge->nSlot == nSlot);
+		assert(edge->nTile >= 0 && "Water can only flow into the domain");
+
+		Exit exit;
+		exit.nCell = nCell;
+		exit.fElevation = grid->getElevation(nCell);
+		exit.nAccumulation = grid->getFlowAccumulation(nCell);
+		exit.nTargetTile = edge->nTile;
+		exit.nTargetBorder = edge->nBorder;
+		pSummary->exits.push_back(exit);
+	}
+
+	for(auto & nCell : m_tileData[nTile].borderCells)
+	{
+		pSummary->borderBasins.push_back(grid->getBasin(nCell));
+	}
+}
+
+/*!
+Water leaving a tile enters the next tile at a border cell and follows the flow
+to the basin of that cell, which is either an outlet or another exit. The filled
+elevation strictly decreases downstream, so visiting the exits from the highest
+gives every exit its total accumulation before it is passed on.
+*/
+void HydrologyDomain::calculateInflows()
+{
+	const int nTileCount = (int)m_tiles.size();
+
+	std::vector<Summary> summaries(nTileCount);
+
+	PYXTaskGroup tasks;
+	for(int nTile=0;nTile<nTileCount;++nTile)
+	{
+		tasks.addTask(boost::bind(&HydrologyDomain::summarize,this,nTile,&summaries[nTile]));
+	}
+	tasks.joinAll();
+
+	m_nFillCount += nTileCount;
+
+	//number all the exits
+	std::vector<int> exitStart(nTileCount+1,0);
+	for(int nTile=0;nTile<nTileCount;++nTile)
+	{
+		exitStart[nTile+1] = exitStart[nTile] + (int)summaries[nTile].exits.size();
+
+		std::vector<int> & exitCells = m_tileData[nTile].exitCells;
+		exitCells.clear();
+		for(auto & exit : summaries[nTile].exits)
+		{
+			exitCells.push_back(exit.nCell);
+		}
+	}
+	const int nExitCount = exitStart[nTileCount];
+
+	std::vector<const Exit *> exits(nExitCount);
+	std::vector<int> exitTiles(nExitCount);
+	for(int nTile=0;nTile<nTileCount;++nTile)
+	{
+		for(int i=exitStart[nTile];i<exitStart[nTile+1];++i)
+		{
+			exits[i] = &summaries[nTile].exits[i-exitStart[nTile]];
+			exitTiles[i] = nTile;
+		}
+	}
+
+	//the outlet the water of every exit reaches in the next tile, and the exit there if any
+	std::vector<int> outlets(nExitCount);
+	std::vector<int> downstream(nExitCount,-1);
+	for(int i=0;i<nExitCount;++i)
+	{
+		const int nTarget = exits[i]->nTargetTile;
+		outlets[i] = summaries[nTarget].borderBasins[exits[i]->nTargetBorder];
+
+		const std::vector<int> & targetExits = m_tileData[nTarget].exitCells;
+		std::vector<int>::const_iterator it = std::lower_bound(targetExits.begin(),targetExits.end(),outlets[i]);
+		if (it != targetExits.end() && *it == outlets[i])
+		{
+			downstream[i] = exitStart[nTarget] + (int)(it - targetExits.begin());
+		}
+	}
+
+	std::vector<int> order(nExitCount);
+	for(int i=0;i<nExitCount;++i)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(),order.end(),[&exits](int a,int b) { return exits[a]->fElevation > exits[b]->fElevation; });
+
+	std::vector<int> totals(nExitCount);
+	for(int i=0;i<nExitCount;++i)
+	{
+		totals[i] = exits[i]->nAccumulation;
+	}
+	for(auto & i : order)
+	{
+		if (downstream[i] >= 0)
+		{
+			totals[downstream[i]] += totals[i];
+		}
+	}
+
+	//the basin label of an exit is the label of its downstream exit, so go upstream
+	std::vector<int> basins(nExitCount);
+	for(std::vector<int>::reverse_iterator it = order.rbegin();it != order.rend();++it)
+	{
+		const int i = *it;
+		basins[i] = downstream[i] >= 0 ? basins[downstream[i]] : m_tileData[exits[i]->nTargetTile].nOffset + outlets[i];
+	}
+
+	for(auto & tile : m_tileData)
+	{
+		tile.inflows.clear();
+		tile.exitBasins.clear();
+	}
+	for(int i=0;i<nExitCount;++i)
+	{
+		Tile & target = m_tileData[exits[i]->nTargetTile];
+
+		Inflow inflow;
+		inflow.nCell = target.borderCells[exits[i]->nTargetBorder];
+		inflow.nCount = totals[i];
+		target.inflows.push_back(inflow);
+
+		m_tileData[exitTiles[i]].exitBasins.push_back(basins[i]);
+	}
+}
+
+PYXPointer<HydrologyGrid> HydrologyDomain::analyzeTile(int nTile) const
+{
+	const Tile & tile = m_tileData[nTile];
+
+	PYXPointer<HydrologyGrid> grid = fillTile(nTile);
+	grid->calculateFlowDirection();
+	grid->calculateFlowAccumulation();
+
+	for(auto & inflow : tile.inflows)
+	{
+		grid->addInflow(inflow.nCell,inflow.nCount);
+	}
+
+	//label the basins with the outlets in the domain
+	grid->calculateBasins();
+	for(int nCell=0;nCell<grid->getCellCount();++nCell)
+	{
+		const int nBasin = grid->getBasin(nCell);
+		if (nBasin == HydrologyGrid::knNoCell)
+		{
+			continue;
+		}
+
+		if (grid->getFlowSlot(nBasin) >= 0)
+		{
+			std::vector<int>::const_iterator it = std::lower_bound(tile.exitCells.begin(),tile.exitCells.end(),nBasin);
+			assert(it != tile.exitCells.end() && *it == nBasin);
+			grid->setBasin(nCell,tile.exitBasins[it - tile.exitCells.begin()]);
+		}
+		else
+		{
+			grid->setBasin(nCell,tile.nOffset + nBasin);
+		}
+	}
+
+	return grid;
+}
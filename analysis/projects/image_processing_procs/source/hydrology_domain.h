@@ -0,0 +1,206 @@
+#ifndef HYDROLOGY_DOMAIN_H
+#define HYDROLOGY_DOMAIN_H
+/******************************************************************************
+hydrology_domain.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// local includes
+#include "module_image_processing_procs.h"
+#include "hydrology_grid.h"
+
+// pyxlib includes
+#include "pyxis/data/coverage.h"
+#include "pyxis/geometry/tile.h"
+#include "pyxis/utility/object.h"
+
+// standard includes
+#include <map>
+#include <vector>
+
+/*!
+HydrologyDomain performs the hydrology analysis of an area too large to fit in a
+single HydrologyGrid, one tile at a time.
+
+The domain is a cell (the domain root) and its neighbours, split into tiles at a
+finer resolution. Only the values of the cells on the tile borders are kept in
+memory, the elevation of a tile is read again from the coverage every time the
+tile is analyzed.
+
+The analysis has three stages:
+1. Filled elevation - every tile is filled with the current filled elevation of
+   the border cells of its neighbour tiles (unknown at first). Tiles whose border
+   values changed make their neighbours fill again, until nothing changes.
+2. Flow accumulation - every tile is summarized by its exits (the cells draining
+   into another tile, with their local accumulation and the cell they drain into)
+   and the basin of its border cells. The exits are then visited from the highest
+   to the lowest, every exit adding its total accumulation to the exit its water
+   reaches in the next tile.
+3. Tile analysis - analyzeTile fills a tile again, adds the water entering it
+   from the exits of the other tiles and labels the basins.
+
+The result is exactly the analysis of a single HydrologyGrid over getTiles(); the
+basin labels are the offsets of the outlets in such a grid. Water leaving the
+domain is lost, so the domain root is usually much coarser than the analyzed
+basins.
+*/
+//! Tiled hydrology analysis of a cell and its neighbours.
+class MODULE_IMAGE_PROCESSING_PROCS_DECL HydrologyDomain : public PYXObject
+{
+public:
+	//! Test method
+	static void test();
+
+public:
+	/*!
+	Analyze the domain around a cell.
+
+	\param index		A cell of the domain, at the analysis resolution.
+	\param nDomainDepth	The domain root is the ancestor of the cell nDomainDepth resolutions coarser.
+	\param nTileDepth	The depth of the tiles analyzed at once.
+	\param elevation	The elevation coverage.
+	\param nFieldIndex	The elevation field.
+	*/
+	static PYXPointer<HydrologyDomain> create(	const PYXIcosIndex & index,
+												int nDomainDepth,
+												int nTileDepth,
+												const boost::intrusive_ptr<ICoverage> & elevation,
+												int nFieldIndex = 0	);
+
+	HydrologyDomain(	const PYXIcosIndex & root,
+						int nCellResolution,
+						int nTileResolution,
+						const boost::intrusive_ptr<ICoverage> & elevation,
+						int nFieldIndex	);
+
+public:
+	//! The domain root.
+	const PYXIcosIndex & getRoot() const { return m_root; }
+
+	int getCellResolution() const { return m_nCellResolution; }
+
+	//! The resolution of the tile roots.
+	int getTileResolution() const { return m_nTileResolution; }
+
+	//! The analyzed tiles.
+	const std::vector<PYXTile> & getTiles() const { return m_tiles; }
+
+	//! The tile containing a cell, or -1 if the cell is outside the domain.
+	int findTile(const PYXIcosIndex & index) const;
+
+	//! Number of times a tile was filled while analyzing the domain.
+	int getFillCount() const { return m_nFillCount; }
+
+	/*!
+	Analyze a tile. The offsets of the returned grid are the offsets in the tile,
+	the basins are the offsets of the outlets in the domain (see class comment).
+	*/
+	PYXPointer<HydrologyGrid> analyzeTile(int nTile) const;
+
+private:
+	//! A neighbour of a border cell of a tile.
+	struct Edge
+	{
+		int nCell;
+		int nSlot;
+
+		//! The tile of the neighbour, or -1 if the neighbour is outside the domain.
+		int nTile;
+
+		//! The position of the neighbour in the border cells of its tile.
+		int nBorder;
+	};
+
+	//! A cell draining into another tile.
+	struct Exit
+	{
+		int nCell;
+		double fElevation;
+		int nAccumulation;
+		int nTargetTile;
+		int nTargetBorder;
+	};
+
+	//! Water entering a tile.
+	struct Inflow
+	{
+		int nCell;
+		int nCount;
+	};
+
+	struct Tile
+	{
+		//! Offset of the first cell in the domain.
+		int nOffset;
+
+		//! The outside neighbours of the cells, in the order of HydrologyGrid::getOutsideNeighbours.
+		std::vector<Edge> edges;
+
+		//! The cells seen by the other tiles, sorted.
+		std::vector<int> borderCells;
+
+		//! The filled elevation of the border cells.
+		std::vector<double> borderElevations;
+
+		//! The tiles reading the border cells.
+		std::vector<int> readers;
+
+		std::vector<Inflow> inflows;
+
+		//! The cells draining into other tiles and their basin labels, sorted by cell.
+		std::vector<int> exitCells;
+		std::vector<int> exitBasins;
+	};
+
+	//! The results of the flow analysis of a tile.
+	struct Summary
+	{
+		std::vector<Exit> exits;
+
+		//! The local basin of every border cell.
+		std::vector<int> borderBasins;
+	};
+
+	//! Order of the edges of a tile: by cell, then by slot.
+	static bool isEdgeBefore(const Edge & a,const Edge & b);
+
+	//! Lay out the tiles and resolve their edges.
+	void buildTiles();
+
+	//! Resolve the outside neighbours of a tile.
+	void buildEdges(int nTile,std::vector<std::pair<int,int>> * pNeighbours);
+
+	//! Load a tile and fill it with the current border elevations.
+	PYXPointer<HydrologyGrid> fillTile(int nTile) const;
+
+	//! Fill a tile and get the filled elevation of its border cells.
+	void fillBorder(int nTile,std::vector<double> * pBorder) const;
+
+	//! Fill a tile and summarize the flow leaving it.
+	void summarize(int nTile,Summary * pSummary) const;
+
+	//! Stage 1: fill until the border elevations converge.
+	void calculateBorderElevations();
+
+	//! Stage 2: accumulate the flow across the tiles.
+	void calculateInflows();
+
+private:
+	PYXIcosIndex m_root;
+	int m_nCellResolution;
+	int m_nTileResolution;
+
+	boost::intrusive_ptr<ICoverage> m_spElevation;
+	int m_nFieldIndex;
+
+	std::vector<PYXTile> m_tiles;
+	std::vector<Tile> m_tileData;
+	std::map<PYXIcosIndex,int> m_tileNumbers;
+
+	int m_nFillCount;
+};
+
+#endif // guard
@@ -0,0 +1,729 @@
+/******************************************************************************
+hydrology_grid.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "stdafx.h"
+#define MODULE_IMAGE_PROCESSING_PROCS_SOURCE
+#include "hydrology_grid.h"
+
+// pyxlib includes
+#include "pyxis/derm/index_math.h"
+#include "pyxis/derm/neighbour_iterator.h"
+#include "pyxis/derm/snyder_projection.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+
+// boost includes
+#include <boost/bind.hpp>
+
+// standard includes
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace
+{
+
+//! Tester class
+Tester<HydrologyGrid> gTester;
+
+}
+
+const double HydrologyGrid::kfEpsilon = 0.0001;
+const double HydrologyGrid::kfDrain = -std::numeric_limits<double>::infinity();
+const double HydrologyGrid::kfUnknown = std::numeric_limits<double>::infinity();
+
+namespace
+{
+
+//! The filled elevation of a cell draining through a neighbour with the given filled elevation.
+inline double spill(double fOriginal,double fNeighbour)
+{
+	return fOriginal > fNeighbour ? fOriginal : fNeighbour + HydrologyGrid::kfEpsilon;
+}
+
+}
+
+void HydrologyGrid::test()
+{
+	//create a bowl around the center of a tile: all the water flows into a single pit
+	PYXIcosIndex root("A-0");
+	std::vector<PYXTile> tiles(1,PYXTile(root,root.getResolution()+7));
+
+	PYXPointer<HydrologyGrid> grid = HydrologyGrid::create(tiles);
+
+	PYXIcosIndex center = root;
+	center.setResolution(grid->getCellResolution());
+	int nCenter = grid->getOffset(center);
+	TEST_ASSERT(nCenter != knNoCell);
+	TEST_ASSERT(grid->getIndex(nCenter) == center);
+
+	PYXCoord3DDouble centerXYZ;
+	SnyderProjection::getInstance()->pyxisToXYZ(center,&centerXYZ);
+
+	std::vector<double> original(grid->getCellCount());
+	for(int i=0;i<grid->getCellCount();++i)
+	{
+		TEST_ASSERT(grid->getOffset(grid->getIndex(i)) == i);
+
+		PYXCoord3DDouble xyz;
+		SnyderProjection::getInstance()->pyxisToXYZ(grid->getIndex(i),&xyz);
+		original[i] = xyz.distance(centerXYZ) * 1000;
+		grid->setElevation(i,original[i]);
+	}
+
+	grid->analyze();
+
+	//the pit was filled and every cell drains downhill until it leaves the grid
+	TEST_ASSERT(grid->getElevation(nCenter) > original[nCenter]);
+
+	int nOutflow = 0;
+	for(int i=0;i<grid->getCellCount();++i)
+	{
+		TEST_ASSERT(grid->getElevation(i) >= original[i]);
+
+		int nTo = grid->getFlowTo(i);
+		if (nTo == knNoCell)
+		{
+			TEST_ASSERT(grid->isEdge(i));
+			nOutflow += grid->getFlowAccumulation(i);
+		}
+		else
+		{
+			TEST_ASSERT(grid->getElevation(nTo) < grid->getElevation(i));
+			TEST_ASSERT(grid->getFlowDirection(i) != 0);
+		}
+	}
+	TEST_ASSERT(nOutflow == grid->getCellCount());
+
+	//every cell drains to its basin, and the basin of an outlet is itself
+	for(int i=0;i<grid->getCellCount();++i)
+	{
+		int nEnd = i;
+		while (grid->getFlowTo(nEnd) != knNoCell)
+		{
+			nEnd = grid->getFlowTo(nEnd);
+		}
+		TEST_ASSERT(grid->getBasin(i) == nEnd);
+	}
+
+	//the watershed of the largest stream near the center contains the center
+	std::vector<int> watershed;
+	int nOutlet = grid->snapToStream(nCenter,2);
+	grid->getWatershed(nOutlet,watershed);
+	TEST_ASSERT((int)watershed.size() == grid->getFlowAccumulation(nOutlet));
+	TEST_ASSERT(std::find(watershed.begin(),watershed.end(),nOutlet) != watershed.end());
+
+	//a grid over one of the sub tiles gives the same analysis once the elevation around it is known
+	PYXIcosIndex subRoot = root;
+	subRoot.setResolution(root.getResolution()+2);
+	std::vector<PYXTile> subTiles(1,PYXTile(subRoot,grid->getCellResolution()));
+
+	PYXPointer<HydrologyGrid> subGrid = HydrologyGrid::create(subTiles);
+	for(int i=0;i<subGrid->getCellCount();++i)
+	{
+		subGrid->setElevation(i,original[grid->getOffset(subGrid->getIndex(i))]);
+	}
+	for(auto & outside : subGrid->getOutsideNeighbours())
+	{
+		int nOffset = grid->getOffset(outside.index);
+		if (nOffset != knNoCell)
+		{
+			subGrid->setOutsideElevation(outside.nOffset,outside.nSlot,grid->getElevation(nOffset));
+		}
+	}
+	subGrid->analyze();
+
+	for(int i=0;i<subGrid->getCellCount();++i)
+	{
+		int nOffset = grid->getOffset(subGrid->getIndex(i));
+		TEST_ASSERT(subGrid->getElevation(i) == grid->getElevation(nOffset));
+		TEST_ASSERT(subGrid->getFlowDirection(i) == grid->getFlowDirection(nOffset));
+
+		//water leaving the sub grid flows into the same cell of the full grid
+		if (subGrid->getFlowSlot(i) >= 0)
+		{
+			TEST_ASSERT(subGrid->getFlowTo(i) == knNoCell);
+			TEST_ASSERT(grid->getFlowTo(nOffset) != knNoCell);
+		}
+		else if (subGrid->getFlowTo(i) != knNoCell)
+		{
+			TEST_ASSERT(subGrid->getIndex(subGrid->getFlowTo(i)) == grid->getIndex(grid->getFlowTo(nOffset)));
+		}
+	}
+}
+
+PYXPointer<HydrologyGrid> HydrologyGrid::createAround(const PYXIcosIndex & index,int nDepth,const boost::intrusive_ptr<ICoverage> & elevation,int nFieldIndex)
+{
+	PYXIcosIndex root = index;
+	root.setResolution(std::max(2,index.getResolution()-nDepth));
+
+	std::vector<PYXTile> tiles;
+	for(PYXNeighbourIterator it(root);!it.end();it.next())
+	{
+		tiles.push_back(PYXTile(it.getIndex(),index.getResolution()));
+	}
+
+	return create(tiles,elevation,nFieldIndex);
+}
+
+HydrologyGrid::HydrologyGrid(const std::vector<PYXTile> & tiles) :
+	m_tiles(tiles),
+	m_nCellResolution(tiles.empty() ? 0 : tiles.front().getCellResolution())
+{
+	m_tileOffsets.push_back(0);
+	for(auto & tile : m_tiles)
+	{
+		assert(tile.getCellResolution() == m_nCellResolution && "All tiles must have the same cell resolution");
+		m_tileOffsets.push_back(m_tileOffsets.back() + tile.getCellCount());
+	}
+
+	int nCellCount = m_tileOffsets.back();
+	m_elevation.resize(nCellCount,0);
+	m_hasElevation.resize(nCellCount,0);
+
+	buildNeighbours();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Cells
+////////////////////////////////////////////////////////////////////////////////
+
+int HydrologyGrid::findTile(const PYXIcosIndex & index,int nHint) const
+{
+	if (nHint >= 0 && m_tiles[nHint].getRootIndex().isAncestorOf(index))
+	{
+		return nHint;
+	}
+
+	for(int i=0;i<(int)m_tiles.size();++i)
+	{
+		if (m_tiles[i].getRootIndex().isAncestorOf(index))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+int HydrologyGrid::getOffset(const PYXIcosIndex & index) const
+{
+	if (index.getResolution() != m_nCellResolution)
+	{
+		return knNoCell;
+	}
+
+	int nTile = findTile(index,-1);
+	if (nTile < 0)
+	{
+		return knNoCell;
+	}
+
+	return m_tileOffsets[nTile] + PYXIcosMath::calcCellPosition(m_tiles[nTile].getRootIndex(),index);
+}
+
+PYXIcosIndex HydrologyGrid::getIndex(int nOffset) const
+{
+	assert(nOffset >= 0 && nOffset < getCellCount() && "Invalid offset");
+
+	int nTile = (int)(std::upper_bound(m_tileOffsets.begin(),m_tileOffsets.end(),nOffset) - m_tileOffsets.begin()) - 1;
+
+	return PYXIcosMath::calcIndexFromOffset(m_tiles[nTile].getRootIndex(),m_nCellResolution,nOffset - m_tileOffsets[nTile]);
+}
+
+bool HydrologyGrid::isEdge(int nOffset) const
+{
+	for(int nSlot=0;nSlot<knNeighbourCount;++nSlot)
+	{
+		//a missing direction (pentagon) is not an edge
+		if (m_directions[nOffset*knNeighbourCount+nSlot] != 0 && getNeighbour(nOffset,nSlot) == knNoCell)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void HydrologyGrid::buildNeighbours()
+{
+	m_neighbours.assign(getCellCount()*knNeighbourCount,knNoCell);
+	m_directions.assign(getCellCount()*knNeighbourCount,0);
+
+	//every tile writes its own range of the tables and its own list of outside neighbours
+	std::vector<std::vector<OutsideNeighbour>> outside(m_tiles.size());
+
+	PYXTaskGroup tasks;
+	for(int nTile=0;nTile<(int)m_tiles.size();++nTile)
+	{
+		tasks.addTask(boost::bind(&HydrologyGrid::buildTileNeighbours,this,nTile,&outside[nTile]));
+	}
+	tasks.joinAll();
+
+	m_outsideNeighbours.clear();
+	for(auto & tileOutside : outside)
+	{
+		m_outsideNeighbours.insert(m_outsideNeighbours.end(),tileOutside.begin(),tileOutside.end());
+	}
+}
+
+void HydrologyGrid::buildTileNeighbours(int nTile,std::vector<OutsideNeighbour> * pOutside)
+{
+	const PYXIcosIndex & root = m_tiles[nTile].getRootIndex();
+	const int nFirst = m_tileOffsets[nTile];
+	const int nCount = m_tileOffsets[nTile+1] - nFirst;
+
+	for(int nLocal=0;nLocal<nCount;++nLocal)
+	{
+		const int nOffset = nFirst + nLocal;
+		PYXIcosIndex index = PYXIcosMath::calcIndexFromOffset(root,m_nCellResolution,nLocal);
+
+		PYXNeighbourIterator it(index);
+		it.next(); //skip self
+
+		for(int nSlot=0;!it.end() && nSlot<knNeighbourCount;it.next(),++nSlot)
+		{
+			const PYXIcosIndex & neighbour = it.getIndex();
+			int nNeighbourTile = findTile(neighbour,nTile);
+
+			m_directions[nOffset*knNeighbourCount+nSlot] = (unsigned char)it.getDirection();
+			if (nNeighbourTile >= 0)
+			{
+				m_neighbours[nOffset*knNeighbourCount+nSlot] = m_tileOffsets[nNeighbourTile] + PYXIcosMath::calcCellPosition(m_tiles[nNeighbourTile].getRootIndex(),neighbour);
+			}
+			else
+			{
+				OutsideNeighbour outside;
+				outside.nOffset = nOffset;
+				outside.nSlot = nSlot;
+				outside.index = neighbour;
+				pOutside->push_back(outside);
+			}
+		}
+	}
+}
+
+void HydrologyGrid::setOutsideElevation(int nOffset,int nSlot,double fElevation)
+{
+	assert(getNeighbour(nOffset,nSlot) == knNoCell && "Not an outside neighbour");
+
+	if (m_outsideElevation.empty())
+	{
+		m_outsideElevation.assign(getCellCount()*knNeighbourCount,kfDrain);
+	}
+	m_outsideElevation[nOffset*knNeighbourCount+nSlot] = fElevation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Elevation
+////////////////////////////////////////////////////////////////////////////////
+
+void HydrologyGrid::loadElevation(const boost::intrusive_ptr<ICoverage> & elevation,int nFieldIndex)
+{
+	const int nMaxDepth = PYXTile::knDefaultTileDepth;
+
+	PYXTaskGroup tasks;
+	for(int nTile=0;nTile<(int)m_tiles.size();++nTile)
+	{
+		const PYXTile & tile = m_tiles[nTile];
+		const PYXIcosIndex & root = tile.getRootIndex();
+
+		if (tile.getDepth() <= nMaxDepth)
+		{
+			tasks.addTask(boost::bind(&HydrologyGrid::loadValueTile,this,elevation,root,nFieldIndex,m_tileOffsets[nTile]));
+			continue;
+		}
+
+		//deep tiles are streamed as sub tiles, every sub tile is a run of consecutive cells
+		PYXTile subTiles(root,m_nCellResolution-nMaxDepth);
+		for(PYXPointer<PYXIterator> it = subTiles.getIterator();!it->end();it->next())
+		{
+			PYXIcosIndex firstCell = it->getIndex();
+			firstCell.setResolution(m_nCellResolution);
+			int nFirstOffset = m_tileOffsets[nTile] + PYXIcosMath::calcCellPosition(root,firstCell);
+
+			tasks.addTask(boost::bind(&HydrologyGrid::loadValueTile,this,elevation,it->getIndex(),nFieldIndex,nFirstOffset));
+		}
+	}
+	tasks.joinAll();
+}
+
+void HydrologyGrid::loadValueTile(const boost::intrusive_ptr<ICoverage> & elevation,const PYXIcosIndex & root,int nFieldIndex,int nFirstOffset)
+{
+	PYXPointer<PYXValueTile> valueTile = elevation->getFieldTile(root,m_nCellResolution,nFieldIndex);
+	if (valueTile)
+	{
+		copyValueTile(*valueTile,nFirstOffset);
+	}
+}
+
+void HydrologyGrid::copyValueTile(const PYXValueTile & valueTile,int nFirstOffset)
+{
+	PYXValue value = valueTile.getTypeCompatibleValue(0);
+	const int nCount = valueTile.getNumberOfCells();
+
+	for(int n=0;n<nCount;++n)
+	{
+		if (valueTile.getValue(n,0,&value) && !value.isNull())
+		{
+			setElevation(nFirstOffset+n,value.getDouble());
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Analysis
+////////////////////////////////////////////////////////////////////////////////
+
+/*!
+Priority-flood: the filled elevation of a cell is the lowest elevation water can
+spill out of it, following any path to a sink. Draining through a neighbour
+raises the cell to the neighbour filled elevation plus epsilon, unless the cell
+is higher.
+
+The cells next to a sink (a cell without elevation, or an outside cell) are the
+initial shore. The lowest shore cell is removed and its neighbours join the shore
+if draining through it lowers them, so every cell gets the lowest value over all
+paths. The result only depends on the elevations and the outside values, not on
+the processing order, so tiles analyzed separately agree on their borders (see
+HydrologyDomain). Cells that can not reach a sink keep kfUnknown.
+*/
+void HydrologyGrid::fillDepressions()
+{
+	typedef std::pair<double,int> Candidate;
+	std::priority_queue<Candidate,std::vector<Candidate>,std::greater<Candidate>> open;
+
+	std::vector<double> filled(getCellCount(),kfUnknown);
+
+	for(int nOffset=0;nOffset<getCellCount();++nOffset)
+	{
+		if (!hasElevation(nOffset))
+		{
+			continue;
+		}
+
+		double fLowest = kfUnknown;
+		for(int nSlot=0;nSlot<knNeighbourCount;++nSlot)
+		{
+			int nNeighbour = getNeighbour(nOffset,nSlot);
+			if (nNeighbour == knNoCell)
+			{
+				//a missing direction (pentagon) is not an outside cell
+				if (m_directions[nOffset*knNeighbourCount+nSlot] != 0)
+				{
+					fLowest = std::min(fLowest,spill(m_elevation[nOffset],getOutsideElevation(nOffset,nSlot)));
+				}
+			}
+			else if (!hasElevation(nNeighbour))
+			{
+				fLowest = std::min(fLowest,m_elevation[nOffset]);
+			}
+		}
+
+		if (fLowest < kfUnknown)
+		{
+			filled[nOffset] = fLowest;
+			open.push(Candidate(fLowest,nOffset));
+		}
+	}
+
+	while (!open.empty())
+	{
+		const Candidate candidate = open.top();
+		open.pop();
+
+		const int nOffset = candidate.second;
+		if (candidate.first > filled[nOffset])
+		{
+			//already lowered
+			continue;
+		}
+
+		for(int nSlot=0;nSlot<knNeighbourCount;++nSlot)
+		{
+			int nNeighbour = getNeighbour(nOffset,nSlot);
+			if (nNeighbour == knNoCell || !hasElevation(nNeighbour))
+			{
+				continue;
+			}
+
+			double fSpill = spill(m_elevation[nNeighbour],candidate.first);
+			if (fSpill < filled[nNeighbour])
+			{
+				filled[nNeighbour] = fSpill;
+				open.push(Candidate(fSpill,nNeighbour));
+			}
+		}
+	}
+
+	for(int nOffset=0;nOffset<getCellCount();++nOffset)
+	{
+		if (hasElevation(nOffset))
+		{
+			m_elevation[nOffset] = filled[nOffset];
+		}
+	}
+}
+
+void HydrologyGrid::calculateFlowDirection()
+{
+	m_flowTo.assign(getCellCount(),knNoCell);
+	m_flowSlot.assign(getCellCount(),-1);
+	m_donorStart.clear();
+	m_donors.clear();
+
+	for(int nOffset=0;nOffset<getCellCount();++nOffset)
+	{
+		if (!hasElevation(nOffset))
+		{
+			continue;
+		}
+
+		double fLowest = m_elevation[nOffset];
+		for(int nSlot=0;nSlot<knNeighbourCount;++nSlot)
+		{
+			int nNeighbour = getNeighbour(nOffset,nSlot);
+			if (nNeighbour == knNoCell)
+			{
+				//an analyzed outside cell receives the water like any other cell
+				double fOutside = getOutsideElevation(nOffset,nSlot);
+				if (fOutside > kfDrain && fOutside < fLowest)
+				{
+					fLowest = fOutside;
+					m_flowTo[nOffset] = knNoCell;
+					m_flowSlot[nOffset] = (signed char)nSlot;
+				}
+			}
+			else if (hasElevation(nNeighbour) && m_elevation[nNeighbour] < fLowest)
+			{
+				fLowest = m_elevation[nNeighbour];
+				m_flowTo[nOffset] = nNeighbour;
+				m_flowSlot[nOffset] = -1;
+			}
+		}
+	}
+}
+
+void HydrologyGrid::calculateFlowAccumulation()
+{
+	const int nCellCount = getCellCount();
+
+	std::vector<int> upstreamCount(nCellCount,0);
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		if (m_flowTo[nOffset] != knNoCell)
+		{
+			upstreamCount[m_flowTo[nOffset]]++;
+		}
+	}
+
+	m_accumulation.assign(nCellCount,0);
+
+	//start from the cells nothing flows into, and move a cell downstream once all its upstream cells are done
+	std::vector<int> ready;
+	ready.reserve(nCellCount);
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		if (hasElevation(nOffset))
+		{
+			m_accumulation[nOffset] = 1;
+			if (upstreamCount[nOffset] == 0)
+			{
+				ready.push_back(nOffset);
+			}
+		}
+	}
+
+	while (!ready.empty())
+	{
+		int nOffset = ready.back();
+		ready.pop_back();
+
+		int nTo = m_flowTo[nOffset];
+		if (nTo != knNoCell)
+		{
+			m_accumulation[nTo] += m_accumulation[nOffset];
+			if (--upstreamCount[nTo] == 0)
+			{
+				ready.push_back(nTo);
+			}
+		}
+	}
+}
+
+void HydrologyGrid::addInflow(int nOffset,int nCount)
+{
+	for(int nCell = nOffset;nCell != knNoCell;nCell = m_flowTo[nCell])
+	{
+		m_accumulation[nCell] += nCount;
+	}
+}
+
+void HydrologyGrid::calculateBasins()
+{
+	const int nCellCount = getCellCount();
+
+	m_basins.assign(nCellCount,knNoCell);
+
+	//follow the flow until a cell with a known basin, then label the path
+	std::vector<int> path;
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		if (!hasElevation(nOffset) || m_basins[nOffset] != knNoCell)
+		{
+			continue;
+		}
+
+		path.clear();
+		int nCell = nOffset;
+		while (m_basins[nCell] == knNoCell)
+		{
+			path.push_back(nCell);
+			if (m_flowTo[nCell] == knNoCell)
+			{
+				m_basins[nCell] = nCell;
+				break;
+			}
+			nCell = m_flowTo[nCell];
+		}
+
+		for(auto & nPathCell : path)
+		{
+			m_basins[nPathCell] = m_basins[nCell];
+		}
+	}
+}
+
+void HydrologyGrid::analyze()
+{
+	fillDepressions();
+	calculateFlowDirection();
+	calculateFlowAccumulation();
+	calculateBasins();
+}
+
+int HydrologyGrid::getFlowDirection(int nOffset) const
+{
+	if (m_flowSlot[nOffset] >= 0)
+	{
+		return m_directions[nOffset*knNeighbourCount+m_flowSlot[nOffset]];
+	}
+
+	int nTo = m_flowTo[nOffset];
+	if (nTo == knNoCell)
+	{
+		return 0;
+	}
+
+	for(int nSlot=0;nSlot<knNeighbourCount;++nSlot)
+	{
+		if (getNeighbour(nOffset,nSlot) == nTo)
+		{
+			return m_directions[nOffset*knNeighbourCount+nSlot];
+		}
+	}
+	return 0;
+}
+
+int HydrologyGrid::snapToStream(int nOffset,int nRings) const
+{
+	int nBest = nOffset;
+	std::vector<int> ring(1,nOffset);
+	std::vector<int> visited(1,nOffset);
+
+	for(int nRing=0;nRing<nRings;++nRing)
+	{
+		std::vector<int> nextRing;
+		for(auto & nCell : ring)
+		{
+			for(int nSlot=0;nSlot<knNeighbourCount;++nSlot)
+			{
+				int nNeighbour = getNeighbour(nCell,nSlot);
+				if (nNeighbour == knNoCell || std::find(visited.begin(),visited.end(),nNeighbour) != visited.end())
+				{
+					continue;
+				}
+				visited.push_back(nNeighbour);
+				nextRing.push_back(nNeighbour);
+
+				if (m_accumulation[nNeighbour] > m_accumulation[nBest])
+				{
+					nBest = nNeighbour;
+				}
+			}
+		}
+		ring.swap(nextRing);
+	}
+	return nBest;
+}
+
+void HydrologyGrid::buildDonors() const
+{
+	const int nCellCount = getCellCount();
+
+	m_donorStart.assign(nCellCount+1,0);
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		if (m_flowTo[nOffset] != knNoCell)
+		{
+			m_donorStart[m_flowTo[nOffset]+1]++;
+		}
+	}
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		m_donorStart[nOffset+1] += m_donorStart[nOffset];
+	}
+
+	m_donors.resize(m_donorStart[nCellCount]);
+	std::vector<int> fill(m_donorStart.begin(),m_donorStart.end()-1);
+	for(int nOffset=0;nOffset<nCellCount;++nOffset)
+	{
+		if (m_flowTo[nOffset] != knNoCell)
+		{
+			m_donors[fill[m_flowTo[nOffset]]++] = nOffset;
+		}
+	}
+}
+
+bool HydrologyGrid::getWatershed(int nOutlet,std::vector<int> & cells) const
+{
+	if (m_donorStart.empty())
+	{
+		buildDonors();
+	}
+
+	bool bReachesEdge = false;
+
+	cells.clear();
+	cells.push_back(nOutlet);
+
+	//the watershed is the upstream tree of the outlet, no cell can be reached twice
+	for(std::size_t i=0;i<cells.size();++i)
+	{
+		int nCell = cells[i];
+		bReachesEdge |= isEdge(nCell);
+
+		for(int nDonor = m_donorStart[nCell];nDonor < m_donorStart[nCell+1];++nDonor)
+		{
+			cells.push_back(m_donors[nDonor]);
+		}
+	}
+
+	return bReachesEdge;
+}
+
+PYXPointer<PYXTileCollection> HydrologyGrid::toGeometry(const std::vector<int> & cells) const
+{
+	PYXPointer<PYXTileCollection> tileCollection = PYXTileCollection::create();
+
+	for(auto & nCell : cells)
+	{
+		tileCollection->addTile(getIndex(nCell),m_nCellResolution);
+	}
+	return tileCollection;
+}
@@ -0,0 +1,248 @@
+#ifndef HYDROLOGY_GRID_H
+#define HYDROLOGY_GRID_H
+/******************************************************************************
+hydrology_grid.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "pyxis/data/coverage.h"
+#include "pyxis/data/value_tile.h"
+#include "pyxis/geometry/tile.h"
+#include "pyxis/geometry/tile_collection.h"
+#include "pyxis/utility/object.h"
+
+// standard includes
+#include <vector>
+
+/*!
+HydrologyGrid performs hydrology analysis of an elevation model on a dense array
+of cells.
+
+The grid covers a set of tiles at the same cell resolution. The tiles are laid one
+after the other and every cell is addressed by its offset in the grid, the cells
+of each tile being in the usual PYXIS exhaustive order. The elevation is streamed
+from the input coverage one value tile at a time, and the neighbours of every cell
+are resolved once into an offset table, so the analysis itself never touches
+PYXIcosIndex or the coverage.
+
+The analysis steps are:
+1. fillDepressions - priority-flood depression filling. Every cell is raised to
+   the lowest spill elevation towards the edge of the grid, plus a small epsilon
+   so flat areas drain.
+2. calculateFlowDirection - every cell drains to its lowest neighbour.
+3. calculateFlowAccumulation - number of cells draining through every cell.
+4. calculateBasins - the cell every cell drains to before leaving the grid.
+
+Cells without elevation and cells outside the grid act as sinks. Water that
+reaches the edge of the grid leaves it, therefore large basins need a grid large
+enough to contain them (see createAround), or a HydrologyDomain.
+
+The filled elevation of a cell outside the grid can be given with
+setOutsideElevation; the grid is then analyzed as a part of a larger area (see
+HydrologyDomain): the cell drains into the outside cell only if it is lower, and
+water flowing into it leaves the grid through getFlowSlot.
+*/
+//! Dense array hydrology analysis of an elevation coverage.
+class MODULE_IMAGE_PROCESSING_PROCS_DECL HydrologyGrid : public PYXObject
+{
+public:
+	//! Test method
+	static void test();
+
+	//! Offset used for cells outside the grid.
+	static const int knNoCell = -1;
+
+	//! Number of neighbour slots for every cell.
+	static const int knNeighbourCount = 6;
+
+	//! The elevation difference used to drain flat areas.
+	static const double kfEpsilon;
+
+	//! Elevation of an outside cell that drains the water (no elevation or outside the analyzed area).
+	static const double kfDrain;
+
+	//! Elevation of an outside cell that is not analyzed yet, no water flows into it.
+	static const double kfUnknown;
+
+	//! A neighbour of a cell of the grid that is outside the grid.
+	struct OutsideNeighbour
+	{
+		int nOffset;
+		int nSlot;
+		PYXIcosIndex index;
+	};
+
+public:
+	//! Create a grid over the given tiles and load the elevation from the coverage.
+	static PYXPointer<HydrologyGrid> create(const std::vector<PYXTile> & tiles,const boost::intrusive_ptr<ICoverage> & elevation,int nFieldIndex = 0)
+	{
+		PYXPointer<HydrologyGrid> grid = PYXNEW(HydrologyGrid,tiles);
+		grid->loadElevation(elevation,nFieldIndex);
+		return grid;
+	}
+
+	//! Create a grid over the given tiles without elevation (see setElevation).
+	static PYXPointer<HydrologyGrid> create(const std::vector<PYXTile> & tiles)
+	{
+		return PYXNEW(HydrologyGrid,tiles);
+	}
+
+	/*!
+	Create a grid around a cell: the tile containing the cell with the given depth
+	and its neighbour tiles.
+	*/
+	static PYXPointer<HydrologyGrid> createAround(const PYXIcosIndex & index,int nDepth,const boost::intrusive_ptr<ICoverage> & elevation,int nFieldIndex = 0);
+
+	explicit HydrologyGrid(const std::vector<PYXTile> & tiles);
+
+public:
+	//! Number of cells in the grid.
+	int getCellCount() const { return (int)m_elevation.size(); }
+
+	//! The resolution of the cells.
+	int getCellResolution() const { return m_nCellResolution; }
+
+	//! The tiles covered by the grid.
+	const std::vector<PYXTile> & getTiles() const { return m_tiles; }
+
+	//! Offset of a cell, or knNoCell if the cell is not in the grid.
+	int getOffset(const PYXIcosIndex & index) const;
+
+	//! The index of the cell at the given offset.
+	PYXIcosIndex getIndex(int nOffset) const;
+
+	//! Offset of a neighbour of a cell, or knNoCell.
+	int getNeighbour(int nOffset,int nSlot) const { return m_neighbours[nOffset*knNeighbourCount+nSlot]; }
+
+	//! Whether a cell has a neighbour outside the grid.
+	bool isEdge(int nOffset) const;
+
+	//! The neighbours of the cells of the grid that are outside the grid.
+	const std::vector<OutsideNeighbour> & getOutsideNeighbours() const { return m_outsideNeighbours; }
+
+	//! Set the filled elevation of a neighbour outside the grid (kfDrain by default).
+	void setOutsideElevation(int nOffset,int nSlot,double fElevation);
+
+	//! The filled elevation of a neighbour outside the grid.
+	double getOutsideElevation(int nOffset,int nSlot) const
+	{
+		return m_outsideElevation.empty() ? kfDrain : m_outsideElevation[nOffset*knNeighbourCount+nSlot];
+	}
+
+	bool hasElevation(int nOffset) const { return m_hasElevation[nOffset] != 0; }
+
+	double getElevation(int nOffset) const { return m_elevation[nOffset]; }
+
+	void setElevation(int nOffset,double fElevation)
+	{
+		m_elevation[nOffset] = fElevation;
+		m_hasElevation[nOffset] = 1;
+	}
+
+public:
+	//! Raise the elevation of all depressions to their spill elevation.
+	void fillDepressions();
+
+	//! Calculate the downstream neighbour of every cell.
+	void calculateFlowDirection();
+
+	//! Calculate the number of upstream cells of every cell (including itself).
+	void calculateFlowAccumulation();
+
+	//! Calculate the last cell of the grid every cell drains to.
+	void calculateBasins();
+
+	//! Run fillDepressions, calculateFlowDirection, calculateFlowAccumulation and calculateBasins.
+	void analyze();
+
+	//! Offset of the downstream cell, or knNoCell if the water leaves the grid.
+	int getFlowTo(int nOffset) const { return m_flowTo[nOffset]; }
+
+	//! The neighbour slot of the outside cell the water flows into, or -1.
+	int getFlowSlot(int nOffset) const { return m_flowSlot[nOffset]; }
+
+	//! Add the water entering the grid at a cell to the accumulation of the cells downstream.
+	void addInflow(int nOffset,int nCount);
+
+	//! The basin of a cell: the offset of the last cell of the grid it drains to, unless set with setBasin.
+	int getBasin(int nOffset) const { return m_basins[nOffset]; }
+
+	void setBasin(int nOffset,int nBasin) { m_basins[nOffset] = nBasin; }
+
+	//! The hex direction of the downstream cell, or 0 if the water leaves the grid.
+	int getFlowDirection(int nOffset) const;
+
+	//! Number of cells draining through the cell.
+	int getFlowAccumulation(int nOffset) const { return m_accumulation[nOffset]; }
+
+	//! Find the cell with the largest accumulation within nRings rings of a cell.
+	int snapToStream(int nOffset,int nRings) const;
+
+	/*!
+	Find all the cells draining into the outlet.
+
+	\return true if the watershed reaches the edge of the grid (the watershed may be larger than the grid).
+	*/
+	bool getWatershed(int nOutlet,std::vector<int> & cells) const;
+
+	//! Convert a list of cell offsets into a geometry.
+	PYXPointer<PYXTileCollection> toGeometry(const std::vector<int> & cells) const;
+
+private:
+	//! Stream the elevation values from the coverage.
+	void loadElevation(const boost::intrusive_ptr<ICoverage> & elevation,int nFieldIndex);
+
+	//! Load a single value tile into the grid.
+	void loadValueTile(const boost::intrusive_ptr<ICoverage> & elevation,const PYXIcosIndex & root,int nFieldIndex,int nFirstOffset);
+
+	//! Copy a value tile into the grid.
+	void copyValueTile(const PYXValueTile & valueTile,int nFirstOffset);
+
+	//! Resolve the neighbours of all cells into offsets.
+	void buildNeighbours();
+
+	//! Resolve the neighbours of the cells of a single tile.
+	void buildTileNeighbours(int nTile,std::vector<OutsideNeighbour> * pOutside);
+
+	//! Index of the tile containing the cell, or -1.
+	int findTile(const PYXIcosIndex & index,int nHint) const;
+
+	//! Build the upstream cells table from the flow directions.
+	void buildDonors() const;
+
+private:
+	std::vector<PYXTile> m_tiles;
+
+	//! Offset of the first cell of every tile, and the total cell count at the end.
+	std::vector<int> m_tileOffsets;
+
+	int m_nCellResolution;
+
+	std::vector<double> m_elevation;
+	std::vector<unsigned char> m_hasElevation;
+
+	//! knNeighbourCount offsets per cell.
+	std::vector<int> m_neighbours;
+
+	//! knNeighbourCount hex directions per cell.
+	std::vector<unsigned char> m_directions;
+
+	std::vector<OutsideNeighbour> m_outsideNeighbours;
+
+	//! knNeighbourCount outside elevations per cell, empty if they are all kfDrain.
+	std::vector<double> m_outsideElevation;
+
+	std::vector<int> m_flowTo;
+	std::vector<signed char> m_flowSlot;
+	std::vector<int> m_accumulation;
+	std::vector<int> m_basins;
+
+	//! Upstream cells, compressed: the donors of cell i are m_donors[m_donorStart[i]..m_donorStart[i+1]).
+	mutable std::vector<int> m_donorStart;
+	mutable std::vector<int> m_donors;
+};
+
+#endif // guard
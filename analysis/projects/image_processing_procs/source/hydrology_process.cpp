@@ -0,0 +1,365 @@
+/******************************************************************************
+hydrology_process.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "stdafx.h"
+#define MODULE_IMAGE_PROCESSING_PROCS_SOURCE
+#include "hydrology_process.h"
+
+// local includes
+#include "elevation_test_coverage.h"
+
+// pyxlib includes
+#include "pyxis/data/exceptions.h"
+#include "pyxis/data/value_tile.h"
+#include "pyxis/derm/index_math.h"
+#include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/value.h"
+
+// boost includes
+#include <boost/bind.hpp>
+
+// standard includes
+#include <algorithm>
+#include <cassert>
+
+// {2E0C4D6B-8A51-4F0E-9C1D-6B7A3F5E2D94}
+PYXCOM_DEFINE_CLSID(HydrologyProcess,
+0x2e0c4d6b, 0x8a51, 0x4f0e, 0x9c, 0x1d, 0x6b, 0x7a, 0x3f, 0x5e, 0x2d, 0x94);
+
+PYXCOM_CLASS_INTERFACES(HydrologyProcess, IProcess::iid, ICoverage::iid, IFeature::iid, PYXCOM_IUnknown::iid);
+
+IPROCESS_SPEC_BEGIN(HydrologyProcess, "Hydrology", "A coverage of the filled elevation, flow direction, flow accumulation and basins of an elevation coverage.", "Analysis/Elevations",
+					ICoverage::iid, IFeature::iid, PYXCOM_IUnknown::iid)
+	IPROCESS_SPEC_PARAMETER(ICoverage::iid, 1, 1, "Elevation Coverage", "The surface elevation input coverage.")
+IPROCESS_SPEC_END
+
+namespace
+{
+
+//! Tester class
+Tester<HydrologyProcess> gTester;
+
+//! Cache weight of a domain or a tile analysis.
+template<typename T>
+size_t getUnitWeight(const T &)
+{
+	return 1;
+}
+
+//! Cache key of a tile at a cell resolution.
+std::string getCacheKey(const PYXIcosIndex & root,int nRes)
+{
+	return root.toString() + ":" + StringUtils::toString(nRes);
+}
+
+}
+
+HydrologyProcess::HydrologyProcess() :
+	m_domains(4,1,false),
+	m_analyses(64,1,false)
+{
+}
+
+HydrologyProcess::~HydrologyProcess()
+{
+}
+
+void HydrologyProcess::test()
+{
+	boost::intrusive_ptr<ElevationTestCoverage> spElevation(new ElevationTestCoverage);
+
+	boost::intrusive_ptr<IProcess> spElevationProcess;
+	spElevation->QueryInterface(IProcess::iid,(void**)&spElevationProcess);
+
+	boost::intrusive_ptr<IProcess> spProcess;
+	PYXCOMCreateInstance(HydrologyProcess::clsid,0,IProcess::iid,(void**)&spProcess);
+	spProcess->getParameter(0)->addValue(spElevationProcess);
+	TEST_ASSERT(spProcess->initProc() == IProcess::knInitialized);
+
+	boost::intrusive_ptr<ICoverage> spCoverage = spProcess->getOutput()->QueryInterface<ICoverage>();
+	TEST_ASSERT(spCoverage->getCoverageDefinition()->getFieldCount() == 4);
+
+	//analyze the whole domain of a cell at once
+	const int nRes = 11;
+	PYXIcosIndex cell("1-02");
+	cell.setResolution(nRes);
+
+	PYXIcosIndex domainRoot = cell;
+	domainRoot.setResolution(std::max(2,nRes-knDomainDepth));
+
+	PYXPointer<HydrologyDomain> layout = PYXNEW(HydrologyDomain,domainRoot,nRes,getTileResolution(nRes),spElevation,0);
+	PYXPointer<HydrologyGrid> grid = HydrologyGrid::create(layout->getTiles(),spElevation);
+	grid->analyze();
+
+	//value tiles larger than the analyzed tiles, and smaller
+	PYXIcosIndex requests[] = { domainRoot, cell };
+	requests[1].setResolution(nRes-5);
+
+	for(auto & request : requests)
+	{
+		for(int nField=knFilledElevation;nField<=knBasin;++nField)
+		{
+			PYXPointer<PYXValueTile> spValueTile = spCoverage->getFieldTile(request,nRes,nField);
+			TEST_ASSERT(spValueTile);
+
+			PYXValue expected = spCoverage->getCoverageDefinition()->getFieldDefinition(nField).getTypeCompatibleValue();
+			PYXValue value = expected;
+
+			const int nCellCount = spValueTile->getNumberOfCells();
+			for(int n=0;n<nCellCount;++n)
+			{
+				PYXIcosIndex index = PYXIcosMath::calcIndexFromOffset(request,nRes,n);
+				int nOffset = grid->getOffset(index);
+				TEST_ASSERT(nOffset != HydrologyGrid::knNoCell);
+
+				bool bHasValue = getValue(*grid,nOffset,nField,expected);
+				TEST_ASSERT(spValueTile->getValue(n,0,&value) == bHasValue);
+				if (bHasValue)
+				{
+					TEST_ASSERT(value == expected);
+
+					//single values come from the cached analysis
+					if (n % 97 == 0)
+					{
+						TEST_ASSERT(spCoverage->getCoverageValue(index,nField) == expected);
+					}
+				}
+			}
+		}
+	}
+
+	//the flows matched above cross the analyzed tiles
+	std::vector<int> tileOffsets(1,0);
+	for(auto & tile : layout->getTiles())
+	{
+		tileOffsets.push_back(tileOffsets.back() + tile.getCellCount());
+	}
+
+	int nCrossingCells = 0;
+	for(int nOffset=0;nOffset<grid->getCellCount();++nOffset)
+	{
+		if (grid->hasElevation(nOffset) &&
+			std::upper_bound(tileOffsets.begin(),tileOffsets.end(),nOffset) != std::upper_bound(tileOffsets.begin(),tileOffsets.end(),grid->getBasin(nOffset)))
+		{
+			++nCrossingCells;
+		}
+	}
+	TEST_ASSERT(nCrossingCells > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// IProcess
+////////////////////////////////////////////////////////////////////////////////
+
+IProcess::eInitStatus HydrologyProcess::initImpl()
+{
+	boost::recursive_mutex::scoped_lock lock(m_procMutex);
+
+	m_strID = "Hydrology " + procRefToStr(ProcRef(getProcID(), getProcVersion()));
+
+	m_spCov = getParameter(0)->getValue(0)->getOutput()->QueryInterface<ICoverage>();
+	m_analyses.clear();
+	m_domains.clear();
+
+	if (!m_spCov)
+	{
+		m_spInitError = boost::intrusive_ptr<IProcessInitError>(new GenericProcInitError());
+		m_spInitError->setError("Input coverage not set");
+		return knFailedToInit;
+	}
+
+	if (m_spCov->getCoverageDefinition()->getFieldCount() == 0)
+	{
+		m_spInitError = boost::intrusive_ptr<IProcessInitError>(new GenericProcInitError());
+		m_spInitError->setError("Input coverage should always have at least one field");
+		return knFailedToInit;
+	}
+
+	m_spCovDefn = PYXTableDefinition::create();
+	m_spCovDefn->addFieldDefinition("FilledElevation", PYXFieldDefinition::knContextElevation, PYXValue::knDouble, 1);
+	m_spCovDefn->addFieldDefinition("FlowDirection", PYXFieldDefinition::knContextNone, PYXValue::knInt32, 1);
+	m_spCovDefn->addFieldDefinition("FlowAccumulation", PYXFieldDefinition::knContextNone, PYXValue::knInt32, 1);
+	m_spCovDefn->addFieldDefinition("Basin", PYXFieldDefinition::knContextClass, PYXValue::knInt32, 1);
+
+	return knInitialized;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ICoverage
+////////////////////////////////////////////////////////////////////////////////
+
+PYXValue HydrologyProcess::getCoverageValue(
+	const PYXIcosIndex& index,
+	int nFieldIndex	) const
+{
+	PYXIcosIndex root = index;
+	root.setResolution(getTileResolution(index.getResolution()));
+
+	PYXPointer<HydrologyGrid> grid = getAnalysis(root, index.getResolution());
+
+	PYXValue value = getCoverageDefinition()->getFieldDefinition(nFieldIndex).getTypeCompatibleValue();
+	if (!getValue(*grid, PYXIcosMath::calcCellPosition(root, index), nFieldIndex, value))
+	{
+		return PYXValue();
+	}
+	return value;
+}
+
+PYXPointer<PYXValueTile> HydrologyProcess::getFieldTile(
+	const PYXIcosIndex& index,
+	int nRes,
+	int nFieldIndex	) const
+{
+	assert(m_spCov);
+
+	PYXPointer<PYXTableDefinition> spCovDefn = PYXTableDefinition::create();
+	spCovDefn->addFieldDefinition(getCoverageDefinition()->getFieldDefinition(nFieldIndex));
+	PYXPointer<PYXValueTile> spValueTile = PYXValueTile::create(index, nRes, spCovDefn);
+
+	const int nTileResolution = getTileResolution(nRes);
+
+	if (index.getResolution() >= nTileResolution)
+	{
+		//the requested tile is a run of cells of an analyzed tile
+		PYXIcosIndex root = index;
+		root.setResolution(nTileResolution);
+
+		PYXIcosIndex firstCell = index;
+		firstCell.setResolution(nRes);
+
+		PYXPointer<HydrologyGrid> grid = getAnalysis(root, nRes);
+		copyCells(*grid, PYXIcosMath::calcCellPosition(root, firstCell), spValueTile->getNumberOfCells(), nFieldIndex, *spValueTile, 0);
+	}
+	else
+	{
+		//the analyzed tiles are consecutive runs of the requested tile
+		int nTileOffset = 0;
+		PYXTile cover(index, nTileResolution);
+		for (PYXPointer<PYXIterator> it = cover.getIterator(); !it->end(); it->next())
+		{
+			PYXPointer<HydrologyGrid> grid = getAnalysis(it->getIndex(), nRes);
+			copyCells(*grid, 0, grid->getCellCount(), nFieldIndex, *spValueTile, nTileOffset);
+			nTileOffset += grid->getCellCount();
+		}
+	}
+
+	return spValueTile;
+}
+
+void HydrologyProcess::copyCells(
+	const HydrologyGrid & grid,
+	int nFirst,
+	int nCount,
+	int nFieldIndex,
+	PYXValueTile & valueTile,
+	int nFirstTileOffset	) const
+{
+	PYXValue value = getCoverageDefinition()->getFieldDefinition(nFieldIndex).getTypeCompatibleValue();
+
+	for (int n = 0; n < nCount; ++n)
+	{
+		if (getValue(grid, nFirst + n, nFieldIndex, value))
+		{
+			valueTile.setValue(nFirstTileOffset + n, 0, value);
+		}
+	}
+}
+
+bool HydrologyProcess::getValue(const HydrologyGrid & grid,int nOffset,int nFieldIndex,PYXValue & value)
+{
+	if (!grid.hasElevation(nOffset))
+	{
+		return false;
+	}
+
+	switch (nFieldIndex)
+	{
+	case knFilledElevation:
+		//cells that can not drain anywhere have no filled elevation
+		if (grid.getElevation(nOffset) == HydrologyGrid::kfUnknown)
+		{
+			return false;
+		}
+		value.setDouble(grid.getElevation(nOffset));
+		break;
+	case knFlowDirection:
+		value.setInt(grid.getFlowDirection(nOffset));
+		break;
+	case knFlowAccumulation:
+		value.setInt(grid.getFlowAccumulation(nOffset));
+		break;
+	case knBasin:
+		value.setInt(grid.getBasin(nOffset));
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Analysis
+////////////////////////////////////////////////////////////////////////////////
+
+int HydrologyProcess::getTileResolution(int nRes)
+{
+	return std::max(std::max(2, nRes - knDomainDepth), nRes - knTileDepth);
+}
+
+PYXPointer<HydrologyGrid> HydrologyProcess::getAnalysis(const PYXIcosIndex& root,int nRes) const
+{
+	assert(root.getResolution() == getTileResolution(nRes));
+
+	return m_analyses.getOrCreate(
+		getCacheKey(root, nRes),
+		boost::bind(&HydrologyProcess::analyzeTile, this, root, nRes),
+		&getUnitWeight<PYXPointer<HydrologyGrid>>);
+}
+
+PYXPointer<HydrologyGrid> HydrologyProcess::analyzeTile(const PYXIcosIndex& root,int nRes) const
+{
+	PYXIcosIndex firstCell = root;
+	firstCell.setResolution(nRes);
+
+	PYXPointer<HydrologyDomain> domain = getDomain(firstCell);
+
+	int nTile = domain->findTile(firstCell);
+	assert(nTile >= 0 && domain->getTiles()[nTile].getRootIndex() == root);
+
+	return domain->analyzeTile(nTile);
+}
+
+PYXPointer<HydrologyDomain> HydrologyProcess::getDomain(const PYXIcosIndex& cell) const
+{
+	PYXIcosIndex domainRoot = cell;
+	domainRoot.setResolution(std::max(2, cell.getResolution() - knDomainDepth));
+
+	return m_domains.getOrCreate(
+		getCacheKey(domainRoot, cell.getResolution()),
+		boost::bind(&HydrologyDomain::create, cell, (int)knDomainDepth, (int)knTileDepth, m_spCov, 0),
+		&getUnitWeight<PYXPointer<HydrologyDomain>>);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Misc
+////////////////////////////////////////////////////////////////////////////////
+
+void HydrologyProcess::createGeometry() const
+{
+	assert(m_spCov);
+	PYXPointer<PYXGeometry> spGeometry = m_spCov->getGeometry();
+	if (!spGeometry)
+	{
+		m_spGeom = PYXEmptyGeometry::create();
+	}
+	else
+	{
+		m_spGeom = spGeometry->clone();
+	}
+}
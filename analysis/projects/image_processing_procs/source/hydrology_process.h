@@ -0,0 +1,150 @@
+#ifndef HYDROLOGY_PROCESS_H
+#define HYDROLOGY_PROCESS_H
+/******************************************************************************
+hydrology_process.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "hydrology_domain.h"
+#include "hydrology_grid.h"
+
+#include "pyxis/data/coverage_base.h"
+#include "pyxis/pipe/process.h"
+#include "pyxis/utility/concurrent_cache.h"
+
+// standard includes
+#include <cassert>
+#include <string>
+#include <vector>
+
+/*!
+A coverage of the hydrology of an elevation coverage. The output has four fields:
+the filled elevation, the flow direction (the hex direction of the downstream cell,
+0 if the water leaves the analyzed area), the flow accumulation (number of cells
+draining through the cell) and the basin (a label shared by all the cells draining
+to the same outlet).
+
+The analysis is done by a HydrologyDomain: the ancestor of the cells knDomainDepth
+resolutions coarser and its neighbours, analyzed in tiles of depth knTileDepth, so
+flows and basins are carried across the tiles. A tile is always analyzed in the
+domain of its own ancestor, so it is surrounded by a full neighbour cell of margin;
+only basins larger than the domain are cut.
+
+The domains and the analyzed tiles are cached, a value tile or a single value is
+copied from the cached analysis.
+*/
+//! Hydrology (filled elevation, flow direction and flow accumulation) coverage process.
+class MODULE_IMAGE_PROCESSING_PROCS_DECL HydrologyProcess : public ProcessImpl<HydrologyProcess>, public CoverageBase
+{
+	PYXCOM_DECLARE_CLASS();
+
+public:
+
+	enum eOutputField
+	{
+		knFilledElevation = 0,
+		knFlowDirection,
+		knFlowAccumulation,
+		knBasin
+	};
+
+	//! Resolutions between the cells and the domain root.
+	static const int knDomainDepth = 11;
+
+	//! Depth of the tiles analyzed at once.
+	static const int knTileDepth = 8;
+
+public:
+
+	//! Constructor
+	HydrologyProcess();
+
+protected:
+	//! Destructor
+	virtual ~HydrologyProcess();
+
+public: // PYXCOM_IUnknown
+
+	IUNKNOWN_QI_BEGIN
+		IUNKNOWN_QI_CASE(IProcess)
+		IUNKNOWN_QI_CASE(IFeature)
+		IUNKNOWN_QI_CASE(IFeatureCollection)
+		IUNKNOWN_QI_CASE(ICoverage)
+	IUNKNOWN_QI_END
+
+	IUNKNOWN_RC_IMPL_FINALIZE();
+
+public: // IProcess
+
+	IPROCESS_GETSPEC_IMPL();
+
+	virtual boost::intrusive_ptr<const PYXCOM_IUnknown> STDMETHODCALLTYPE getOutput() const
+	{
+		return static_cast<const ICoverage*>(this);
+	}
+
+	virtual boost::intrusive_ptr<PYXCOM_IUnknown> STDMETHODCALLTYPE getOutput()
+	{
+		return static_cast<ICoverage*>(this);
+	}
+
+protected: // ProcessImpl
+
+	virtual IProcess::eInitStatus initImpl();
+
+public: // ICoverage
+
+	virtual PYXValue STDMETHODCALLTYPE getCoverageValue(	const PYXIcosIndex& index,
+															int nFieldIndex = 0	) const;
+
+	virtual PYXPointer<PYXValueTile> STDMETHODCALLTYPE getFieldTile(		const PYXIcosIndex& index,
+																			int nRes,
+																			int nFieldIndex = 0	) const;
+
+public:
+
+	static void test();
+
+private:
+
+	virtual void createGeometry() const;
+
+	//! The resolution of the roots of the analyzed tiles for a cell resolution.
+	static int getTileResolution(int nRes);
+
+	//! Get the analysis of a tile (the root at getTileResolution) from the cache, or analyze it.
+	PYXPointer<HydrologyGrid> getAnalysis(const PYXIcosIndex& root,int nRes) const;
+
+	//! Analyze a tile in the domain of its ancestor.
+	PYXPointer<HydrologyGrid> analyzeTile(const PYXIcosIndex& root,int nRes) const;
+
+	//! Get the domain of a cell from the cache, or analyze it.
+	PYXPointer<HydrologyDomain> getDomain(const PYXIcosIndex& cell) const;
+
+	//! Copy a run of cells of an analysis into a value tile.
+	void copyCells(	const HydrologyGrid & grid,
+					int nFirst,
+					int nCount,
+					int nFieldIndex,
+					PYXValueTile & valueTile,
+					int nFirstTileOffset	) const;
+
+	//! The value of a field of a cell of an analysis.
+	static bool getValue(const HydrologyGrid & grid,int nOffset,int nFieldIndex,PYXValue & value);
+
+private:
+
+	//! The input coverage.
+	boost::intrusive_ptr<ICoverage> m_spCov;
+
+	//! The analyzed domains, by root and cell resolution.
+	mutable ConcurrentCache<std::string,PYXPointer<HydrologyDomain>> m_domains;
+
+	//! The analyzed tiles, by root and cell resolution.
+	mutable ConcurrentCache<std::string,PYXPointer<HydrologyGrid>> m_analyses;
+};
+
+#endif // guard
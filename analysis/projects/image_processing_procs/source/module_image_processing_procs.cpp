@@ -17,6 +17,7 @@ web			: www.pyxisinnovation.com
 #include "coverage_geometry_mask_process.h"
 #include "greyscale_to_rgb_process.h"
 #include "hillshade_process.h"
+#include "hydrology_process.h"
 #include "multi_res_spatial_analysis_process.h"
 #include "zoom_in_process.h"
 #include "zoom_out_process.h"
@@ -36,6 +37,7 @@ PYXCOM_BEGIN_CLASS_OBJECT_TABLE
 	PYXCOM_CLASS_OBJECT_TABLE_ENTRY(CoverageGeometryMaskProcess),
 	PYXCOM_CLASS_OBJECT_TABLE_ENTRY(GreyscaleToRGBProcess), // TODO: Drop
 	PYXCOM_CLASS_OBJECT_TABLE_ENTRY(HillShader),
+	PYXCOM_CLASS_OBJECT_TABLE_ENTRY(HydrologyProcess),
 	PYXCOM_CLASS_OBJECT_TABLE_ENTRY(MultiResSpatialAnalysisProcess), // TODO: Drop
 	PYXCOM_CLASS_OBJECT_TABLE_ENTRY(PYXZoomInProcess), // TODO: Drop
 	PYXCOM_CLASS_OBJECT_TABLE_ENTRY(PYXZoomOutProcess), // TODO: Drop
@@ -9,22 +9,20 @@ web			: www.pyxisinnovation.com
 #include "stdafx.h"
 #define MODULE_IMAGE_PROCESSING_PROCS_SOURCE
 #include "watershed_process.h"
+#include "elevation_test_coverage.h"
+#include "hydrology_grid.h"
 
 // pyxlib includes
 #include "pyxis/data/exceptions.h"
-#include "pyxis/derm/iterator_linq.h"
 #include "pyxis/derm/snyder_projection.h"
+#include "pyxis/geometry/cell.h"
 #include "pyxis/geometry/tile_collection.h"
 #include "pyxis/geometry/vector_geometry2.h"
-#include "pyxis/region/circle_region.h"
+#include "pyxis/procs/default_feature.h"
 #include "pyxis/region/multi_curve_region.h"
 #include "pyxis/utility/tester.h"
 #include "pyxis/utility/value.h"
 
-// boost includes
-#include <boost/thread/thread.hpp>
-#include <boost/bind.hpp>
-
 // standard includes
 #include <cassert>
 
@@ -32,190 +30,42 @@ web			: www.pyxisinnovation.com
 // Watershed Algorithm
 ////////////////////////////////////////////////////////////////////////////////
 //
-// Watershed algorithm is a weighted variation on the floodfill algorithm.
-// In the fill flood algorithm, we move from a cell to it's neighboring cells.
-//
-// On the watershed algorithm, we move from a cell to it's neighbor if the neighbor
-// cell has higher elevation. 
+// The watershed is calculated with a HydrologyGrid around the destination cell:
 //
-// Because elevation dataset have different way of been generated (average value,
-// max value, lowest value, creek simulation etc) - we need to "fix" the elevation
-// model so our algorithm will run as expected.
+// 1. The elevation of a window of tiles around the destination is loaded into a
+//    dense grid, and its depressions ("local-minimum" cells caused by the lower
+//    resolution estimation of elevation) are filled with a priority-flood, so the
+//    water in every cell flows somewhere.
 //
-// "Fixing" elevation means resolving "local-minimum" cells. a "local-minimum" is 
-// a cell that has elevation lower than all its neighbors. those cells are caused
-// from "lower resolution" estimation of elevation. but in reality, there would be
-// a creek that will allow the water to flow or it will be a lake. we would like
-// to fix the elevation model to find where water in this cell would probably 
-// flow. 
+// 2. Every cell drains to its lowest neighbour, and the flow accumulation (number
+//    of cells draining through a cell) is calculated.
 //
-// The "Fix" is to dig a tunnel from a "local-minimum" cell to "nearest" cell with 
-// lower elevation (could be few cells away). the "nearest" cell is not calculated
-// by distance, but it calculated by the amount of "dirt" we will need to dig to
-// create a tunnel between those 2 cells.
+// 3. The destination is moved to the largest stream nearby, and the watershed is
+//    all the cells draining into it.
 //
-// Once we found the best "tunnel" to to fix that local-minimum", we create
-// a temporary and modified elevation model with that tunnel. And continue to fix
-// the next local-minimum cell in the area. 
-//
-// The implementation heavily uses: PYXIteratorLinq and boost::bind
+// If the watershed reaches the edge of the window, the window is enlarged and the
+// analysis repeated, up to knMaxGridDepth. The basins of a whole area are given by
+// HydrologyProcess, which analyzes a much larger domain tile by tile.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-PYXCoord3DDouble toCoord3D(const PYXIcosIndex & index)
-{
-	PYXCoord3DDouble coord;
-	SnyderProjection::getInstance()->pyxisToXYZ(index, &coord);
-
-	return coord;	
-}
-
-
-/*
-isLowerElevation - return if the elevation (taken from elevationCoverage) at target position is lower the given value (sourceElevation)
-
-boost::bind will be used to inject elevationCoverage and sourceElevation
-*/
-bool isLowerElevation(const PYXIcosIndex & target,const boost::intrusive_ptr<ICoverage> & elevationCoverage,const PYXValue & sourceElevation)
-{
-	PYXValue value = elevationCoverage->getCoverageValue(target,0);
-	if (value.isNull())
-	{
-		return true;
-	}
-	return value.getDouble() < sourceElevation.getDouble();
-}
-
-/*
-elevationDiffCost - return the watershed cost of moving between two positions (from - to)
-
-the cost is equal to amount of "dirt" we will need to dig. aka - the difference between elevation (taken form elevationCoverage) at "to" location and the
-starting elevation (sourceElevation)
-
-boost::bind will be used to inject elevationCoverage and sourceElevation
-*/
-double elevationDiffCost(const PYXIcosIndex & from,const PYXIcosIndex & to,const boost::intrusive_ptr<ICoverage> & elevationCoverage,const PYXValue & sourceElevation)
-{
-	return elevationCoverage->getCoverageValue(to,0).getDouble() - sourceElevation.getDouble();
-}
-
-/*
-maxCost - aggregate the cost. in our case is the highest cost between the totalCost and moveCost.
-*/
-double maxCost(double totalCost,double moveCost)
-{
-	return 0.0001 + std::max(totalCost,moveCost);
-}
-
-/*
-findPathNearestLowerPlace - find the tunnel from location (index) to another cell that is lower.
-
-See "watershed algorithm" details above.
-*/
-PYXPointer<PYXIterator> findPathNearestLowerPlace(const PYXIcosIndex & index,const boost::intrusive_ptr<ICoverage> & elevationCoverage)
-{
-	PYXValue sourceElevation = elevationCoverage->getCoverageValue(index,0);
-	return PYXIteratorLinq::findShortestPath(index,
-		boost::bind(isLowerElevation,_1,elevationCoverage,sourceElevation),
-		boost::bind(elevationDiffCost,_1,_2,elevationCoverage,sourceElevation),
-		boost::bind(maxCost,_1,_2));
-}
-
-/*
-fixElevation - fix elevation for a single location (source) - "local-minimum" cell.
-
-Note: this function modifies elevationCoverage by digging a tunnel from the source location to the nearest lower elevation cell.
-
-See "watershed algorithm" details above.
-*/
-void fixElevation(const PYXIcosIndex & source,const boost::intrusive_ptr<ICoverage> & elevationCoverage)
+namespace
 {
-	std::list<PYXIcosIndex> way;
-	PYXIteratorLinq(findPathNearestLowerPlace(source,elevationCoverage)).pushBackToList(way);
-
-	double startElevation = elevationCoverage->getCoverageValue(*way.begin(),0).getDouble();
-	double endElevation = elevationCoverage->getCoverageValue(*way.rbegin(),0).getDouble();
-	int length = (int)way.size();
 
-	double delta = endElevation-startElevation;
+//! Depth of the tiles of the first window used to look for the watershed.
+const int knInitialGridDepth = 7;
 
-	if (startElevation<=endElevation)
-	{
-		//we have nothing to fix, this can happen when shortest path reach a null value.
-		return;
-	}
+//! Depth of the tiles of the largest window (7 tiles of ~3^11 cells).
+const int knMaxGridDepth = 11;
 
-	int i=0;
-	PYXValue val = elevationCoverage->getCoverageDefinition()->getFieldDefinition(0).getTypeCompatibleValue();
-	for(std::list<PYXIcosIndex>::iterator it = way.begin(); it != way.end();++it,++i)
-	{
-		val.setDouble(startElevation + (delta*i)/(length-1));
-		assert(startElevation + (delta*i)/(length-1) >= endElevation-0.0001);
-		elevationCoverage->setCoverageValue(val,*it,0);
-	}
 }
 
-/*
-applyFixArea - fix elevation for a large area
-
-Note: this function modifies elevationCoverage by digging a tunnels from all local minimum cells in the given area
-
-See "watershed algorithm" details above.
-*/
-void applyFixArea(const PYXIcosIndex & rootIndex,const boost::intrusive_ptr<ICoverage> & elevationCoverage,const PYXPointer<PYXTileCollection> fixedArea)
-{
-	if (!fixedArea->isEmpty() && fixedArea->intersects(rootIndex))
-	{
-		//we already fixed this area...
-		return;
-	}
-	PYXIcosIndex tileIndex = rootIndex;
-	tileIndex.setResolution(rootIndex.getResolution()-9);
-	PYXIteratorLinq::fromGeometry(PYXVectorGeometry2::create(PYXCircleRegion::create(toCoord3D(rootIndex),PYXIcosMath::UnitSphere::calcTileCircumRadius(tileIndex)),rootIndex.getResolution()))
-		.filter(_value.localMinimumOf(elevationCoverage,0))
-		.orderBy(_value.of(elevationCoverage))
-		.foreach(boost::bind(fixElevation,_1,elevationCoverage));
-
-	PYXPointer<PYXTileCollection> safeArea = PYXTileCollection::create();
-	PYXVectorGeometry2::create(PYXCircleRegion::create(toCoord3D(rootIndex),PYXIcosMath::UnitSphere::calcTileCircumRadius(tileIndex)/3),rootIndex.getResolution())->copyTo(safeArea.get());
-
-	fixedArea->addGeometry(*safeArea);
-}
-
-/*
-watershedFlow - check the water will flow from cell (to) into cell (from).
-
-I think the name are kind of confusing. but this function is used by "calculateWatershedFlow" function to visualize the watershed flow.
-
-the building of that flow is building from the destination to the source of the watershed. Therefore, the from and to are used to mark
-how the algorithm is tracing back the watershed, which is in reverse how the water is flowing. 
-*/
-bool watershedFlow(const PYXIcosIndex & from,const PYXIcosIndex & to,const boost::intrusive_ptr<ICoverage> & elevationCoverage)
-{
-	PYXValue fromValue = elevationCoverage->getCoverageValue(from,0);
-	PYXValue toValue = elevationCoverage->getCoverageValue(to,0);
-	return fromValue < toValue && PYXIteratorLinq::fromNeighboursWithoutSelf(to).select(elevationCoverage).minValueIndex() == from;
-}
-
-/*
-showElevationFix - debug function to highlight the elevation fixes.
-
-this function return a geometry of all cells that their elevation has been modified.
-*/
-PYXPointer<PYXGeometry> showElevationFix(const boost::intrusive_ptr<IProcess> & elevationProc,const PYXIcosIndex & rootIndex)
+PYXCoord3DDouble toCoord3D(const PYXIcosIndex & index)
 {
-	PYXIcosIndex tileIndex = rootIndex;
-	tileIndex.setResolution(tileIndex.getResolution()-11);
-
-	boost::intrusive_ptr<ICoverage> elevationCoverage = elevationProc->getOutput()->QueryInterface<ICoverage>();
-
-	boost::intrusive_ptr<ICoverage> modifiedElevation = new PYXTemporaryCoverage(elevationCoverage);
+	PYXCoord3DDouble coord;
+	SnyderProjection::getInstance()->pyxisToXYZ(index, &coord);
 
-	//return PYXIteratorLinq::fromGeometry(PYXTile(tileIndex,rootIndex.getResolution()))
-	return PYXIteratorLinq::fromGeometry(PYXVectorGeometry2::create(PYXCircleRegion::create(toCoord3D(rootIndex),PYXIcosMath::UnitSphere::calcTileCircumRadius(tileIndex)),rootIndex.getResolution()))
-		.filter(_value.localMinimumOf(modifiedElevation,0))
-		.selectMany(boost::bind(findPathNearestLowerPlace,_1,modifiedElevation))
-		.toGeometry();
+	return coord;	
 }
 
 /*
@@ -242,77 +92,66 @@ PYXIcosIndex findResolutionToPerformWatershedAnalysis(const boost::intrusive_ptr
 }
 
 /*
-calculateWatershed - calculate a watershed for a given elevation and a destination cell
+findWatershed - analyze the elevation around the destination cell and find the cells of its watershed.
+
+return the grid the cells offsets refer to.
 */
-PYXPointer<PYXGeometry> calculateWatershed(const boost::intrusive_ptr<IProcess> & elevationProc,const PYXIcosIndex & rootIndex)
+PYXPointer<HydrologyGrid> findWatershed(const boost::intrusive_ptr<IProcess> & elevationProc,const PYXIcosIndex & rootIndex,std::vector<int> & cells)
 {
-	//create watershed creation state
 	boost::intrusive_ptr<ICoverage> elevationCoverage = elevationProc->getOutput()->QueryInterface<ICoverage>();
 	PYXIcosIndex root = findResolutionToPerformWatershedAnalysis(elevationCoverage, rootIndex);
-	boost::intrusive_ptr<ICoverage> modifiedElevation = new PYXTemporaryCoverage(elevationCoverage);	
-	PYXPointer<PYXTileCollection> fixedArea = PYXTileCollection::create();
 
-	//fix DEM around the root
-	applyFixArea(root,modifiedElevation,fixedArea);
+	for(int depth = knInitialGridDepth; ; ++depth)
+	{
+		PYXPointer<HydrologyGrid> grid = HydrologyGrid::createAround(root,depth,elevationCoverage);
+		grid->analyze();
+
+		//move root to the largest stream nearby (2xcell width) - larger accumulation means larger watershed
+		int outlet = grid->snapToStream(grid->getOffset(root),2);
 
-	//find min elevation neighbor (2xcell width) - move root to nearest place - min elevation means for larger watershed
-	PYXIcosIndex betterRoot = PYXIteratorLinq::fromSelfAndNeighbours(root).select(modifiedElevation).minValueIndex();
-	betterRoot = PYXIteratorLinq::fromSelfAndNeighbours(betterRoot).select(modifiedElevation).minValueIndex();
+		bool reachesEdge = grid->getWatershed(outlet,cells);
 
-	return PYXIteratorLinq::fromIndex(betterRoot)
-		.floodFill(boost::bind(watershedFlow,_1,_2,modifiedElevation))
-		.beforeEachItem(boost::bind(applyFixArea,_1,modifiedElevation,fixedArea))
-		.toGeometry();
+		if (!reachesEdge || depth >= knMaxGridDepth || root.getResolution() - depth <= 2)
+		{
+			return grid;
+		}
+	}
 }
 
 /*
-addFlowCurve - add a single geometry curve to the result geometry that mark how the water flow in the watershed.
+calculateWatershed - calculate a watershed for a given elevation and a destination cell
 */
-void addFlowCurve(std::vector<PYXPointer<PYXCurveRegion>> & curves,const PYXIcosIndex & index,const boost::intrusive_ptr<ICoverage> & elevationCoverage)
+PYXPointer<PYXGeometry> calculateWatershed(const boost::intrusive_ptr<IProcess> & elevationProc,const PYXIcosIndex & rootIndex)
 {
-	auto dest = PYXIteratorLinq::fromNeighboursWithoutSelf(index).select(elevationCoverage).minValueIndex();
-	if (elevationCoverage->getCoverageValue(dest,0) < elevationCoverage->getCoverageValue(index,0))
-	{
-		curves.push_back(PYXCurveRegion::create(toCoord3D(index),toCoord3D(dest)));
-	}
+	std::vector<int> cells;
+	PYXPointer<HydrologyGrid> grid = findWatershed(elevationProc,rootIndex,cells);
+
+	return grid->toGeometry(cells);
 }
 
 /*
 calculateWatershedFlow - calculate a watershed and generate a watershed flow geometry
 
 watershed flow geometry is a multi-curve geometry that shows how the water flow between cells.
-
-it uses "watershedFlow" function to find the connective between all cells in the watershed.
-
 */
 PYXPointer<PYXGeometry> calculateWatershedFlow(const boost::intrusive_ptr<IProcess> & elevationProc,const PYXIcosIndex & rootIndex)
 {
-	//create watershed creation state
-	boost::intrusive_ptr<ICoverage> elevationCoverage = elevationProc->getOutput()->QueryInterface<ICoverage>();
-	PYXIcosIndex root = findResolutionToPerformWatershedAnalysis(elevationCoverage, rootIndex);
-	boost::intrusive_ptr<ICoverage> modifiedElevation = new PYXTemporaryCoverage(elevationCoverage);
-	PYXPointer<PYXTileCollection> fixedArea = PYXTileCollection::create();
-
-	//fix DEM around the root
-	applyFixArea(root,modifiedElevation,fixedArea);
-
-	//find min elevation neighbor (2xcell width) - move rootIndex to nearest place - min elevation means for larger watershed
-	PYXIcosIndex betterRoot = PYXIteratorLinq::fromSelfAndNeighbours(root).select(modifiedElevation).minValueIndex();
-	betterRoot = PYXIteratorLinq::fromSelfAndNeighbours(betterRoot).select(modifiedElevation).minValueIndex();
-
-	auto watershed = PYXIteratorLinq::fromIndex(betterRoot)
-		.floodFill(boost::bind(watershedFlow,_1,_2,modifiedElevation))
-		.beforeEachItem(boost::bind(applyFixArea,_1,modifiedElevation,fixedArea))
-		.toGeometry();
+	std::vector<int> cells;
+	PYXPointer<HydrologyGrid> grid = findWatershed(elevationProc,rootIndex,cells);
 
 	std::vector<PYXPointer<PYXCurveRegion>> curves;
-	PYXIteratorLinq::fromGeometry(watershed).foreach(boost::bind(addFlowCurve,boost::ref(curves),_1,modifiedElevation));
+	curves.reserve(cells.size());
 
-	auto geometry = PYXVectorGeometry2::create(PYXMultiCurveRegion::create(curves),root.getResolution());
-
-	geometry->getInnerTileIterator(PYXInnerTile(root,root.getResolution()+1));
+	for(auto & cell : cells)
+	{
+		int dest = grid->getFlowTo(cell);
+		if (dest != HydrologyGrid::knNoCell)
+		{
+			curves.push_back(PYXCurveRegion::create(toCoord3D(grid->getIndex(cell)),toCoord3D(grid->getIndex(dest))));
+		}
+	}
 
-	return geometry;
+	return PYXVectorGeometry2::create(PYXMultiCurveRegion::create(curves),grid->getCellResolution());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -337,6 +176,37 @@ namespace
 //! Tester class
 Tester<WatershedProcess> gTester;
 
+//! The resolution of the test watersheds.
+const int knTestResolution = 12;
+
+//! Create a synthetic elevation process for the tests, detailed enough for watersheds at knTestResolution.
+boost::intrusive_ptr<IProcess> createTestElevation()
+{
+	boost::intrusive_ptr<ElevationTestCoverage> spElevation(new ElevationTestCoverage);
+	spElevation->setGeometryResolution(knTestResolution+1);
+
+	boost::intrusive_ptr<IProcess> spProcess;
+	spElevation->QueryInterface(IProcess::iid,(void**)&spProcess);
+	return spProcess;
+}
+
+//! Create a watershed process to a destination cell.
+boost::intrusive_ptr<IProcess> createTestProcess(REFCLSID clsid,const boost::intrusive_ptr<IProcess> & spElevation,const PYXIcosIndex & destination)
+{
+	boost::intrusive_ptr<DefaultFeature> spFeature(new DefaultFeature(PYXCell::create(destination)));
+
+	boost::intrusive_ptr<IProcess> spDestination;
+	spFeature->QueryInterface(IProcess::iid,(void**)&spDestination);
+
+	boost::intrusive_ptr<IProcess> spProcess;
+	PYXCOMCreateInstance(clsid,0,IProcess::iid,(void**)&spProcess);
+	spProcess->getParameter(0)->addValue(spElevation);
+	spProcess->getParameter(1)->addValue(spDestination);
+	TEST_ASSERT(spProcess->initProc() == IProcess::knInitialized);
+
+	return spProcess;
+}
+
 }
 
 WatershedProcess::WatershedProcess()
@@ -349,7 +219,52 @@ WatershedProcess::~WatershedProcess()
 
 void WatershedProcess::test()
 {
-	//TODO [shatzi]: add some unit testing!
+	boost::intrusive_ptr<IProcess> spElevation = createTestElevation();
+
+	PYXIcosIndex destination("1-02");
+	destination.setResolution(knTestResolution);
+
+	std::vector<int> cells;
+	PYXPointer<HydrologyGrid> grid = findWatershed(spElevation,destination,cells);
+	TEST_ASSERT(grid->getCellResolution() == knTestResolution);
+	TEST_ASSERT(!cells.empty());
+
+	//the watershed is the outlet and every cell draining into it, once
+	const int nOutlet = cells.front();
+	TEST_ASSERT((int)cells.size() == grid->getFlowAccumulation(nOutlet));
+
+	std::vector<unsigned char> inWatershed(grid->getCellCount(),0);
+	for(auto & nCell : cells)
+	{
+		TEST_ASSERT(!inWatershed[nCell]);
+		inWatershed[nCell] = 1;
+
+		int nDownstream = nCell;
+		while (nDownstream != nOutlet && nDownstream != HydrologyGrid::knNoCell)
+		{
+			nDownstream = grid->getFlowTo(nDownstream);
+		}
+		TEST_ASSERT(nDownstream == nOutlet);
+	}
+
+	for(int nCell=0;nCell<grid->getCellCount();++nCell)
+	{
+		int nTo = grid->getFlowTo(nCell);
+		if (nTo != HydrologyGrid::knNoCell && nCell != nOutlet && inWatershed[nTo])
+		{
+			TEST_ASSERT(inWatershed[nCell]);
+		}
+	}
+
+	//the outlet is the largest stream near the destination
+	TEST_ASSERT(grid->getFlowAccumulation(nOutlet) >= grid->getFlowAccumulation(grid->getOffset(destination)));
+
+	//the process geometry is the watershed
+	boost::intrusive_ptr<IProcess> spProcess = createTestProcess(WatershedProcess::clsid,spElevation,destination);
+	PYXPointer<PYXTileCollection> spGeometry = boost::dynamic_pointer_cast<PYXTileCollection>(spProcess->getOutput()->QueryInterface<IFeature>()->getGeometry());
+	TEST_ASSERT(spGeometry);
+	TEST_ASSERT(spGeometry->getCellCount() == (long)cells.size());
+	TEST_ASSERT(spGeometry->intersects(grid->getIndex(nOutlet)));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -462,7 +377,32 @@ WatershedFlowProcess::~WatershedFlowProcess()
 
 void WatershedFlowProcess::test()
 {
-	//TODO [shatzi]: add some unit testing!
+	boost::intrusive_ptr<IProcess> spElevation = createTestElevation();
+
+	PYXIcosIndex destination("1-02");
+	destination.setResolution(knTestResolution);
+
+	std::vector<int> cells;
+	findWatershed(spElevation,destination,cells);
+
+	//a curve from every cell of the watershed to its downstream cell, joined into polylines
+	PYXPointer<PYXVectorGeometry2> spFlow = boost::dynamic_pointer_cast<PYXVectorGeometry2>(calculateWatershedFlow(spElevation,destination));
+	TEST_ASSERT(spFlow);
+	TEST_ASSERT(spFlow->getCellResolution() == knTestResolution);
+
+	PYXPointer<PYXMultiCurveRegion> spCurves = boost::dynamic_pointer_cast<PYXMultiCurveRegion>(spFlow->getRegion());
+	TEST_ASSERT(spCurves);
+	TEST_ASSERT(cells.size() == 1 || spCurves->getCurveCount() > 0);
+	TEST_ASSERT(spCurves->getCurveCount() <= (int)cells.size());
+
+	//the process geometry is the same flow
+	boost::intrusive_ptr<IProcess> spProcess = createTestProcess(WatershedFlowProcess::clsid,spElevation,destination);
+	PYXPointer<PYXVectorGeometry2> spGeometry = boost::dynamic_pointer_cast<PYXVectorGeometry2>(spProcess->getOutput()->QueryInterface<IFeature>()->getGeometry());
+	TEST_ASSERT(spGeometry);
+
+	PYXPointer<PYXMultiCurveRegion> spGeometryCurves = boost::dynamic_pointer_cast<PYXMultiCurveRegion>(spGeometry->getRegion());
+	TEST_ASSERT(spGeometryCurves);
+	TEST_ASSERT(spGeometryCurves->getCurveCount() == spCurves->getCurveCount());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,925 @@
+/******************************************************************************
+csv_file_index.cpp
+
+begin      : 19/10/2026 10:00:00 AM
+copyright  : (c) 2026 by the PYXIS innovation inc.
+web        : www.pyxisinnovation.com
+******************************************************************************/
+
+#include "stdafx.h"
+
+#define EXCEL_SOURCE
+
+// local includes
+#include "csv_file_index.h"
+
+// pyxlib includes
+#include "pyxis/utility/app_services.h"
+#include "pyxis/utility/exceptions.h"
+#include "pyxis/utility/file_utils.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+
+// boost includes
+#include <boost/bind.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+// standard includes
+#include <algorithm>
+
+namespace
+{
+
+//! The version of the saved index.
+const int knIndexVersion = 2;
+
+//! The window used to read a single record.
+const std::size_t knRandomAccessWindowSize = 64 * 1024;
+
+void writeUInt64(PYXWireBuffer & buffer,boost::uint64_t nValue)
+{
+	buffer << static_cast<unsigned int>(nValue >> 32) << static_cast<unsigned int>(nValue & 0xFFFFFFFF);
+}
+
+boost::uint64_t readUInt64(PYXWireBuffer & buffer)
+{
+	unsigned int nHigh = 0;
+	unsigned int nLow = 0;
+	buffer >> nHigh >> nLow;
+	return (static_cast<boost::uint64_t>(nHigh) << 32) | nLow;
+}
+
+//! The modification time of a file, as stored in the saved index.
+boost::uint64_t getModifiedTime(const boost::filesystem::path & file)
+{
+	return static_cast<boost::uint64_t>(boost::filesystem::last_write_time(file));
+}
+
+//! A read only mapping of a byte range of a file.
+class MappedRange
+{
+public:
+	MappedRange(const boost::filesystem::path & file,boost::uint64_t nBegin,boost::uint64_t nEnd)
+	{
+		try
+		{
+			m_mapping.reset(new boost::interprocess::file_mapping(FileUtils::pathToString(file).c_str(),boost::interprocess::read_only));
+			m_region.reset(new boost::interprocess::mapped_region(
+				*m_mapping,
+				boost::interprocess::read_only,
+				static_cast<boost::interprocess::offset_t>(nBegin),
+				static_cast<std::size_t>(nEnd - nBegin)));
+		}
+		catch (boost::interprocess::interprocess_exception & e)
+		{
+			PYXTHROW(PYXFileException,"Failed to map '" << FileUtils::pathToString(file) << "': " << e.what());
+		}
+	}
+
+	const char * begin() const
+	{
+		return static_cast<const char *>(m_region->get_address());
+	}
+
+	const char * end() const
+	{
+		return begin() + m_region->get_size();
+	}
+
+private:
+	boost::scoped_ptr<boost::interprocess::file_mapping> m_mapping;
+	boost::scoped_ptr<boost::interprocess::mapped_region> m_region;
+};
+
+//! The kind of a value, as far as the type detection is concerned.
+enum eValueClass
+{
+	knEmptyValue,
+	knIntegerValue,
+	knDecimalValue,
+	knTextValue
+};
+
+eValueClass classifyValue(const std::string & value)
+{
+	std::string trimmedValue = StringUtils::trim(value);
+
+	//empty value - aka - null
+	if (trimmedValue.empty())
+	{
+		return knEmptyValue;
+	}
+
+	//check if this is a number
+	std::string valueStr;
+	if (StringUtils::tryParseFormattedNumber(trimmedValue,valueStr))
+	{
+		return StringUtils::countDecimalPlaces(valueStr)==0 ? knIntegerValue : knDecimalValue;
+	}
+
+	return knTextValue;
+}
+
+}
+
+///////////////////////////////////////////
+// CsvMappedReader
+///////////////////////////////////////////
+
+CsvMappedReader::CsvMappedReader(
+	const boost::filesystem::path & file,
+	boost::uint64_t nFileSize,
+	boost::uint64_t nBegin,
+	boost::uint64_t nEnd,
+	std::size_t nWindowSize) :
+	m_file(file),
+	m_pWindow(0),
+	m_nWindowBegin(0),
+	m_nWindowEnd(0),
+	m_nWindowSize(nWindowSize),
+	m_nFileSize(nFileSize),
+	m_nPosition(nBegin),
+	m_nEnd(std::min(nEnd,nFileSize))
+{
+	if (endOfRange())
+	{
+		return;
+	}
+
+	try
+	{
+		m_mapping.reset(new boost::interprocess::file_mapping(FileUtils::pathToString(m_file).c_str(),boost::interprocess::read_only));
+	}
+	catch (boost::interprocess::interprocess_exception & e)
+	{
+		PYXTHROW(PYXFileException,"Failed to open file: " << m_file << ": " << e.what());
+	}
+}
+
+void CsvMappedReader::mapWindow(boost::uint64_t nOffset,std::size_t nSize)
+{
+	nSize = static_cast<std::size_t>(std::min<boost::uint64_t>(nSize,m_nFileSize - nOffset));
+
+	m_region.reset();
+	try
+	{
+		m_region.reset(new boost::interprocess::mapped_region(
+			*m_mapping,
+			boost::interprocess::read_only,
+			static_cast<boost::interprocess::offset_t>(nOffset),
+			nSize));
+	}
+	catch (boost::interprocess::interprocess_exception & e)
+	{
+		PYXTHROW(PYXFileException,"Failed to map '" << FileUtils::pathToString(m_file) << "': " << e.what());
+	}
+
+	m_pWindow = static_cast<const char *>(m_region->get_address());
+	m_nWindowBegin = nOffset;
+	m_nWindowEnd = nOffset + nSize;
+}
+
+boost::uint64_t CsvMappedReader::findRecordEnd()
+{
+	if (endOfRange())
+	{
+		PYXTHROW(PYXException,"Reading past the end of file: " << m_file);
+	}
+
+	if (m_pWindow == 0 || m_nPosition < m_nWindowBegin || m_nPosition >= m_nWindowEnd)
+	{
+		mapWindow(m_nPosition,m_nWindowSize);
+	}
+
+	for(;;)
+	{
+		const char * pBegin = m_pWindow + (m_nPosition - m_nWindowBegin);
+		const char * pEnd = m_pWindow + (m_nWindowEnd - m_nWindowBegin);
+
+		//a new line ends the record only outside of a qouted value
+		bool bInQuotes = false;
+		const char * pQuote = pBegin;
+		for(const char * p = pBegin; p != pEnd; ++p)
+		{
+			if (*p == '"')
+			{
+				bInQuotes = !bInQuotes;
+				pQuote = p;
+			}
+			else if (*p == '\n')
+			{
+				if (!bInQuotes)
+				{
+					return m_nWindowBegin + (p - m_pWindow);
+				}
+				if (static_cast<std::size_t>(p - pQuote) > knMaxQuotedValueSize)
+				{
+					PYXTHROW(PYXException,"Unbalanced quote in the record at offset " << (m_nWindowBegin + (pQuote - m_pWindow)) << " of file: " << m_file);
+				}
+			}
+		}
+
+		if (m_nWindowEnd == m_nFileSize)
+		{
+			return m_nFileSize;
+		}
+
+		//the record is cut by the window - move the window to the record, and grow it if the record is larger than the window
+		if (m_nWindowBegin == m_nPosition)
+		{
+			m_nWindowSize *= 2;
+		}
+		mapWindow(m_nPosition,m_nWindowSize);
+	}
+}
+
+void CsvMappedReader::skipRecord()
+{
+	m_nPosition = std::min(findRecordEnd() + 1,m_nFileSize);
+}
+
+void CsvMappedReader::readRecord(std::vector<std::string> & values)
+{
+	enum ReaderState
+	{
+		knNormalValue,
+		knStringValue,
+		knStringEnding
+	};
+
+	boost::uint64_t nRecordEnd = findRecordEnd();
+
+	const char * p = m_pWindow + (m_nPosition - m_nWindowBegin);
+	const char * pEnd = m_pWindow + (nRecordEnd - m_nWindowBegin);
+	if (p != pEnd && *(pEnd-1) == '\r')
+	{
+		--pEnd;
+	}
+
+	m_nPosition = std::min(nRecordEnd + 1,m_nFileSize);
+
+	std::size_t nCount = 0;
+	if (values.empty())
+	{
+		values.resize(1);
+	}
+	std::string * pValue = &values[0];
+	pValue->clear();
+
+	ReaderState state = knNormalValue;
+
+	while (p != pEnd)
+	{
+		switch(state)
+		{
+		case knNormalValue:
+			{
+				const char * pRun = p;
+				while (p != pEnd && *p != ',' && *p != '"')
+				{
+					++p;
+				}
+				pValue->append(pRun,p);
+				if (p == pEnd)
+				{
+					break;
+				}
+				if (*p == ',')
+				{
+					++nCount;
+					if (nCount == values.size())
+					{
+						values.push_back(std::string());
+					}
+					pValue = &values[nCount];
+					pValue->clear();
+				}
+				else
+				{
+					state = knStringValue;
+					pValue->clear(); //ignore everything before the '"'
+				}
+				++p;
+			}
+			break;
+
+		case knStringValue:
+			{
+				const char * pRun = p;
+				while (p != pEnd && *p != '"')
+				{
+					++p;
+				}
+				pValue->append(pRun,p);
+				if (p == pEnd)
+				{
+					break;
+				}
+				//we move to knStringEnding because this could double quote...
+				state = knStringEnding;
+				++p;
+			}
+			break;
+
+		case knStringEnding:
+			switch(*p)
+			{
+			case '"': //double "" - which is translted as single '"' value
+				pValue->push_back('"');
+				state = knStringValue;
+				break;
+			case ',':
+				++nCount;
+				if (nCount == values.size())
+				{
+					values.push_back(std::string());
+				}
+				pValue = &values[nCount];
+				pValue->clear();
+				state = knNormalValue;
+				break;
+			default: // do nothing - this should be only white space
+				break;
+			}
+			++p;
+			break;
+		}
+	}
+
+	values.resize(nCount + 1);
+}
+
+///////////////////////////////////////////
+// CsvFieldTypeDetector
+///////////////////////////////////////////
+
+CsvFieldTypeDetector::CsvFieldTypeDetector(int nFieldCount) : m_states(nFieldCount)
+{
+	for(auto & transitions : m_states)
+	{
+		for(int nState = 0; nState < knStateCount; ++nState)
+		{
+			transitions.state[nState] = static_cast<unsigned char>(nState);
+		}
+	}
+}
+
+void CsvFieldTypeDetector::addRecord(const std::vector<std::string> & values)
+{
+	// may have less values than field names
+	auto end = std::min(values.size(),m_states.size());
+	for (unsigned int i = 0; i < end; ++i)
+	{
+		const std::string & value = values[i];
+		bool bLongValue = value.size() > 1;
+		bool bClassified = false;
+		eValueClass valueClass = knEmptyValue;
+
+		for(int nState = 0; nState < knStateCount; ++nState)
+		{
+			unsigned char & state = m_states[i].state[nState];
+
+			//if this is string value - nothing left to do
+			if (state == knStringState)
+			{
+				continue;
+			}
+
+			//if this is a char - make sure the value is 1 char long
+			if (state == knCharState)
+			{
+				if (bLongValue)
+				{
+					state = knStringState;
+				}
+				continue;
+			}
+
+			if (!bClassified)
+			{
+				valueClass = classifyValue(value);
+				bClassified = true;
+			}
+
+			switch(valueClass)
+			{
+			case knEmptyValue:
+				//null, nothing to do here
+				break;
+			case knIntegerValue:
+				//if the type is double already - there is nothing to do
+				if (state != knDoubleState)
+				{
+					state = knIntState;
+				}
+				break;
+			case knDecimalValue:
+				state = knDoubleState;
+				break;
+			case knTextValue:
+				state = bLongValue ? knStringState : knCharState;
+				break;
+			}
+		}
+	}
+}
+
+void CsvFieldTypeDetector::append(const CsvFieldTypeDetector & next)
+{
+	if (m_states.empty())
+	{
+		m_states = next.m_states;
+		return;
+	}
+
+	auto end = std::min(next.m_states.size(),m_states.size());
+	for (unsigned int i = 0; i < end; ++i)
+	{
+		for(int nState = 0; nState < knStateCount; ++nState)
+		{
+			unsigned char & state = m_states[i].state[nState];
+			state = next.m_states[i].state[state];
+		}
+	}
+}
+
+PYXValue::eType CsvFieldTypeDetector::getFieldType(int nField) const
+{
+	switch(m_states[nField].state[knNullState])
+	{
+	case knIntState:
+		return PYXValue::knInt32;
+	case knDoubleState:
+		return PYXValue::knDouble;
+	case knCharState:
+		return PYXValue::knChar;
+	case knStringState:
+		return PYXValue::knString;
+	default:
+		return PYXValue::knNull;
+	}
+}
+
+///////////////////////////////////////////
+// CsvFileIndex
+///////////////////////////////////////////
+
+CsvFileIndex::CsvFileIndex(const boost::filesystem::path & file,boost::uint64_t nFileSize,boost::uint64_t nModifiedTime) :
+	m_file(file),
+	m_nFileSize(nFileSize),
+	m_nModifiedTime(nModifiedTime),
+	m_nRecordCount(0)
+{
+}
+
+PYXPointer<CsvFileIndex> CsvFileIndex::create(
+	const boost::filesystem::path & file,
+	bool bDetectTypes,
+	boost::uint64_t nChunkSize)
+{
+	if (!FileUtils::exists(file))
+	{
+		PYXTHROW(PYXFileException,"Failed to open file: " << file);
+	}
+
+	PYXPointer<CsvFileIndex> spIndex = PYXNEW(CsvFileIndex,file,boost::filesystem::file_size(file),getModifiedTime(file));
+	const boost::uint64_t nFileSize = spIndex->m_nFileSize;
+
+	if (nFileSize == 0)
+	{
+		spIndex->m_fieldTypes = CsvFieldTypeDetector(0);
+		return spIndex;
+	}
+
+	//read the field names
+	{
+		CsvMappedReader reader(file,nFileSize,0,1,knRandomAccessWindowSize);
+		reader.readRecord(spIndex->m_header);
+	}
+	const int nFieldCount = static_cast<int>(spIndex->m_header.size());
+
+	const std::size_t nChunks = static_cast<std::size_t>((nFileSize + nChunkSize - 1) / nChunkSize);
+
+	//first pass: count the quotes and new lines of every chunk
+	std::vector<ChunkScan> scans(nChunks);
+	{
+		PYXTaskGroup tasks;
+		for (std::size_t nChunk = 0; nChunk < nChunks; ++nChunk)
+		{
+			const boost::uint64_t nBegin = nChunk * nChunkSize;
+			const boost::uint64_t nEnd = std::min(nBegin + nChunkSize,nFileSize);
+			tasks.addTask(boost::bind(&CsvFileIndex::scanChunk,spIndex.get(),nBegin,nEnd,&scans[nChunk]));
+		}
+		tasks.joinAll();
+	}
+
+	//second pass: every chunk reads the records that start after its new lines (and the first chunk the header)
+	std::vector<ChunkRecords> records(nChunks);
+	{
+		PYXTaskGroup tasks;
+		bool bInQuotes = false;
+		boost::uint64_t nFirstRecord = 0;
+		for (std::size_t nChunk = 0; nChunk < nChunks; ++nChunk)
+		{
+			const boost::uint64_t nBegin = nChunk * nChunkSize;
+			const boost::uint64_t nEnd = std::min(nBegin + nChunkSize,nFileSize);
+
+			records[nChunk].fieldTypes = CsvFieldTypeDetector(nFieldCount);
+			tasks.addTask(boost::bind(&CsvFileIndex::readChunk,spIndex.get(),nBegin,nEnd,bInQuotes,nFirstRecord,bDetectTypes,&records[nChunk]));
+
+			nFirstRecord += scans[nChunk].nNewLines[bInQuotes ? 1 : 0] + (nChunk == 0 ? 1 : 0);
+			bInQuotes = bInQuotes != scans[nChunk].bOddQuotes;
+		}
+		tasks.joinAll();
+	}
+
+	spIndex->m_fieldTypes = CsvFieldTypeDetector(nFieldCount);
+	for (std::size_t nChunk = 0; nChunk < nChunks; ++nChunk)
+	{
+		const ChunkRecords & chunk = records[nChunk];
+		spIndex->m_nRecordCount += chunk.nRecords;
+		spIndex->m_offsets.insert(spIndex->m_offsets.end(),chunk.offsets.begin(),chunk.offsets.end());
+		spIndex->m_fieldTypes.append(chunk.fieldTypes);
+	}
+
+	return spIndex;
+}
+
+void CsvFileIndex::scanChunk(boost::uint64_t nBegin,boost::uint64_t nEnd,ChunkScan * pScan) const
+{
+	MappedRange range(m_file,nBegin,nEnd);
+
+	bool bOddQuotes = false;
+	boost::uint64_t nNewLines[2] = { 0, 0 };
+	for(const char * p = range.begin(); p != range.end(); ++p)
+	{
+		if (*p == '"')
+		{
+			bOddQuotes = !bOddQuotes;
+		}
+		else if (*p == '\n')
+		{
+			++nNewLines[bOddQuotes ? 1 : 0];
+		}
+	}
+
+	pScan->bOddQuotes = bOddQuotes;
+	pScan->nNewLines[0] = nNewLines[0];
+	pScan->nNewLines[1] = nNewLines[1];
+}
+
+void CsvFileIndex::readChunk(
+	boost::uint64_t nBegin,
+	boost::uint64_t nEnd,
+	bool bInQuotes,
+	boost::uint64_t nFirstRecord,
+	bool bDetectTypes,
+	ChunkRecords * pRecords) const
+{
+	pRecords->nRecords = 0;
+
+	//find the first record that starts in the chunk
+	boost::uint64_t nStart = nBegin;
+	if (nBegin > 0)
+	{
+		MappedRange range(m_file,nBegin,nEnd);
+		const char * p = range.begin();
+		for(; p != range.end(); ++p)
+		{
+			if (*p == '"')
+			{
+				bInQuotes = !bInQuotes;
+			}
+			else if (*p == '\n' && !bInQuotes)
+			{
+				break;
+			}
+		}
+
+		if (p == range.end())
+		{
+			//the chunk is inside a single record
+			return;
+		}
+		nStart = nBegin + (p - range.begin()) + 1;
+	}
+
+	//the records that start after the new lines of the chunk
+	const std::size_t nWindowSize = static_cast<std::size_t>(std::min<boost::uint64_t>(CsvMappedReader::knDefaultWindowSize,nEnd - nStart + knRandomAccessWindowSize));
+	CsvMappedReader reader(m_file,m_nFileSize,nStart,nEnd + 1,nWindowSize);
+	std::vector<std::string> values;
+	boost::uint64_t nRecord = nFirstRecord;
+	while (!reader.endOfRange())
+	{
+		if (nRecord % knRecordStride == 0)
+		{
+			pRecords->offsets.push_back(reader.getPosition());
+		}
+
+		if (bDetectTypes && nRecord > 0)
+		{
+			reader.readRecord(values);
+			pRecords->fieldTypes.addRecord(values);
+		}
+		else
+		{
+			reader.skipRecord();
+		}
+		++nRecord;
+	}
+
+	pRecords->nRecords = nRecord - nFirstRecord;
+}
+
+PYXPointer<CsvFileIndex> CsvFileIndex::create(const boost::filesystem::path & file,PYXWireBuffer & buffer)
+{
+	int nVersion = 0;
+	buffer >> nVersion;
+	if (nVersion != knIndexVersion || !FileUtils::exists(file))
+	{
+		return PYXPointer<CsvFileIndex>();
+	}
+
+	//a file edited in place can keep its size, so the modification time is checked too
+	boost::uint64_t nFileSize = readUInt64(buffer);
+	boost::uint64_t nModifiedTime = readUInt64(buffer);
+	if (nFileSize != boost::filesystem::file_size(file) || nModifiedTime != getModifiedTime(file))
+	{
+		return PYXPointer<CsvFileIndex>();
+	}
+
+	PYXPointer<CsvFileIndex> spIndex = PYXNEW(CsvFileIndex,file,nFileSize,nModifiedTime);
+	spIndex->m_nRecordCount = readUInt64(buffer);
+
+	int nStride = 0;
+	buffer >> nStride;
+	if (nStride != knRecordStride)
+	{
+		return PYXPointer<CsvFileIndex>();
+	}
+
+	buffer >> spIndex->m_header;
+
+	int nOffsets = 0;
+	buffer >> nOffsets;
+	spIndex->m_offsets.resize(nOffsets);
+	for(int i = 0; i < nOffsets; ++i)
+	{
+		spIndex->m_offsets[i] = readUInt64(buffer);
+	}
+
+	return spIndex;
+}
+
+void CsvFileIndex::save(PYXWireBuffer & buffer) const
+{
+	buffer << knIndexVersion;
+	writeUInt64(buffer,m_nFileSize);
+	writeUInt64(buffer,m_nModifiedTime);
+	writeUInt64(buffer,m_nRecordCount);
+	buffer << knRecordStride;
+	buffer << m_header;
+
+	buffer << static_cast<int>(m_offsets.size());
+	for(auto & nOffset : m_offsets)
+	{
+		writeUInt64(buffer,nOffset);
+	}
+}
+
+std::auto_ptr<CsvMappedReader> CsvFileIndex::createReader(boost::uint64_t nRecord,std::size_t nWindowSize) const
+{
+	if (nRecord >= m_nRecordCount)
+	{
+		return std::auto_ptr<CsvMappedReader>(new CsvMappedReader(m_file,m_nFileSize,m_nFileSize,m_nFileSize,nWindowSize));
+	}
+
+	std::auto_ptr<CsvMappedReader> reader(new CsvMappedReader(
+		m_file,
+		m_nFileSize,
+		m_offsets[static_cast<std::size_t>(nRecord / knRecordStride)],
+		m_nFileSize,
+		nWindowSize));
+
+	for(int nSkip = static_cast<int>(nRecord % knRecordStride); nSkip > 0; --nSkip)
+	{
+		reader->skipRecord();
+	}
+
+	return reader;
+}
+
+boost::uint64_t CsvFileIndex::getRecordOffset(boost::uint64_t nRecord) const
+{
+	if (nRecord >= m_nRecordCount)
+	{
+		PYXTHROW(PYXException,"Record is out of range: " << nRecord);
+	}
+	return createReader(nRecord,knRandomAccessWindowSize)->getPosition();
+}
+
+void CsvFileIndex::readRecord(boost::uint64_t nRecord,std::vector<std::string> & values) const
+{
+	if (nRecord >= m_nRecordCount)
+	{
+		PYXTHROW(PYXException,"Record is out of range: " << nRecord);
+	}
+	createReader(nRecord,knRandomAccessWindowSize)->readRecord(values);
+}
+
+///////////////////////////////////////////
+// Testing
+///////////////////////////////////////////
+
+namespace
+{
+	//! The unit test class
+	Tester< CsvFileIndex > gTester;
+
+	boost::filesystem::path writeTestFile(const std::string & strContent)
+	{
+		boost::filesystem::path file = AppServices::makeTempFile(".csv");
+		boost::filesystem::ofstream out(file,std::ios::out | std::ios::binary);
+		out << strContent;
+		return file;
+	}
+}
+
+/*!
+The unit test method for the class.
+*/
+void CsvFileIndex::test()
+{
+	//quoted values, new lines inside values, missing values and no new line at the end
+	boost::filesystem::path file = writeTestFile(
+		"name,value,note\r\n"
+		"a,1,\"x, y\"\r\n"
+		"b,2.5,\"multi\nline\"\r\n"
+		"c,,\"say \"\"hi\"\"\"\r\n"
+		"d,4\r\n"
+		"e,5,last");
+
+	//every chunk size must find the same records, including chunks that start inside a quoted value
+	boost::uint64_t chunkSizes[] = { 1, 2, 3, 5, 7, 16, 1000 };
+	for(auto & nChunkSize : chunkSizes)
+	{
+		PYXPointer<CsvFileIndex> spIndex = CsvFileIndex::create(file,true,nChunkSize);
+		TEST_ASSERT_EQUAL(spIndex->getRecordCount(),6u);
+
+		TEST_ASSERT_EQUAL(spIndex->getHeader().size(),3u);
+		TEST_ASSERT_EQUAL(spIndex->getHeader()[2],"note");
+
+		std::vector<std::string> values;
+		spIndex->readRecord(1,values);
+		TEST_ASSERT_EQUAL(values[2],"x, y");
+		spIndex->readRecord(2,values);
+		TEST_ASSERT_EQUAL(values[2],"multi\nline");
+		spIndex->readRecord(3,values);
+		TEST_ASSERT_EQUAL(values[1],"");
+		TEST_ASSERT_EQUAL(values[2],"say \"hi\"");
+		spIndex->readRecord(4,values);
+		TEST_ASSERT_EQUAL(values.size(),2u);
+		spIndex->readRecord(5,values);
+		TEST_ASSERT_EQUAL(values[0],"e");
+		TEST_ASSERT_EQUAL(values[2],"last");
+
+		TEST_ASSERT_EQUAL(spIndex->getFieldTypes().getFieldType(0),PYXValue::knChar);
+		TEST_ASSERT_EQUAL(spIndex->getFieldTypes().getFieldType(1),PYXValue::knDouble);
+		TEST_ASSERT_EQUAL(spIndex->getFieldTypes().getFieldType(2),PYXValue::knString);
+	}
+
+	//the type detection depends on the order of the values
+	{
+		std::vector<std::string> values(1);
+		CsvFieldTypeDetector first(1);
+		values[0] = "12";
+		first.addRecord(values);
+		values[0] = "x";
+		first.addRecord(values);
+		TEST_ASSERT_EQUAL(first.getFieldType(0),PYXValue::knChar);
+
+		CsvFieldTypeDetector second(1);
+		values[0] = "12";
+		second.addRecord(values);
+		TEST_ASSERT_EQUAL(second.getFieldType(0),PYXValue::knInt32);
+
+		first.append(second);
+		TEST_ASSERT_EQUAL(first.getFieldType(0),PYXValue::knString);
+	}
+
+	boost::filesystem::remove(file);
+
+	//random access and a saved index on a larger file
+	const int nRows = 2000;
+	std::string strContent = "id,x,y,label\n";
+	for(int i = 0; i < nRows; ++i)
+	{
+		strContent += StringUtils::toString(i) + "," + StringUtils::toString(i * 0.5) + "," + StringUtils::toString(-i) + ",\"row, " + StringUtils::toString(i) + "\"\n";
+	}
+	file = writeTestFile(strContent);
+
+	PYXPointer<CsvFileIndex> spSequential = CsvFileIndex::create(file,true,strContent.size());
+	PYXPointer<CsvFileIndex> spParallel = CsvFileIndex::create(file,true,strContent.size() / 16 + 1);
+
+	TEST_ASSERT_EQUAL(spSequential->getRecordCount(),static_cast<boost::uint64_t>(nRows + 1));
+	TEST_ASSERT_EQUAL(spParallel->getRecordCount(),static_cast<boost::uint64_t>(nRows + 1));
+	for(int i = 0; i < 4; ++i)
+	{
+		TEST_ASSERT_EQUAL(spSequential->getFieldTypes().getFieldType(i),spParallel->getFieldTypes().getFieldType(i));
+	}
+	TEST_ASSERT_EQUAL(spParallel->getFieldTypes().getFieldType(0),PYXValue::knInt32);
+	TEST_ASSERT_EQUAL(spParallel->getFieldTypes().getFieldType(1),PYXValue::knDouble);
+	TEST_ASSERT_EQUAL(spParallel->getFieldTypes().getFieldType(3),PYXValue::knString);
+
+	PYXStringWireBuffer buffer;
+	spParallel->save(buffer);
+	buffer.setPos(0);
+	PYXPointer<CsvFileIndex> spLoaded = CsvFileIndex::create(file,buffer);
+	TEST_ASSERT(spLoaded);
+	TEST_ASSERT_EQUAL(spLoaded->getRecordCount(),spParallel->getRecordCount());
+
+	std::vector<std::string> values;
+	for(int i = 0; i < nRows; i += 97)
+	{
+		spLoaded->readRecord(i + 1,values);
+		TEST_ASSERT_EQUAL(values[0],StringUtils::toString(i));
+		TEST_ASSERT_EQUAL(values[3],"row, " + StringUtils::toString(i));
+		TEST_ASSERT_EQUAL(spLoaded->getRecordOffset(i + 1),spSequential->getRecordOffset(i + 1));
+	}
+
+	int nRead = 0;
+	std::auto_ptr<CsvMappedReader> reader = spLoaded->createReader(1);
+	while (!reader->endOfRange())
+	{
+		reader->readRecord(values);
+		++nRead;
+	}
+	TEST_ASSERT_EQUAL(nRead,nRows);
+	reader.reset();
+
+	//the saved index is dropped when the file is modified, even if its size did not change
+	boost::filesystem::last_write_time(file,boost::filesystem::last_write_time(file) + 10);
+	buffer.setPos(0);
+	TEST_ASSERT(!CsvFileIndex::create(file,buffer));
+
+	boost::filesystem::remove(file);
+
+	//an unbalanced quote is reported instead of making the rest of the file a single record
+	strContent = "id,note\n1,\"unbalanced\n";
+	while (strContent.size() < CsvMappedReader::knMaxQuotedValueSize + 64 * 1024)
+	{
+		strContent += "2,x\n";
+	}
+	file = writeTestFile(strContent);
+	TEST_ASSERT_EXCEPTION(CsvFileIndex::create(file,false,strContent.size()),PYXException);
+	TEST_ASSERT_EXCEPTION(CsvFileIndex::create(file,false,64 * 1024),PYXException);
+	boost::filesystem::remove(file);
+}
+
+/*!
+Time the indexing of a large file with one and 16 chunks, and reading all its records.
+*/
+void CsvFileIndex::benchmark()
+{
+	const int nRows = 200000;
+	std::string strContent = "id,x,y,label\n";
+	for(int i = 0; i < nRows; ++i)
+	{
+		strContent += StringUtils::toString(i) + "," + StringUtils::toString(i * 0.5) + "," + StringUtils::toString(-i) + ",\"row, " + StringUtils::toString(i) + "\"\n";
+	}
+	boost::filesystem::path file = writeTestFile(strContent);
+
+	PYXHighQualityTimer timer;
+
+	timer.start();
+	PYXPointer<CsvFileIndex> spSequential = CsvFileIndex::create(file,true,strContent.size());
+	timer.stop();
+	double fSequentialTime = timer.getTime();
+
+	timer.start();
+	PYXPointer<CsvFileIndex> spParallel = CsvFileIndex::create(file,true,strContent.size() / 16 + 1);
+	timer.stop();
+	double fParallelTime = timer.getTime();
+
+	//read all the records sequentially
+	std::vector<std::string> values;
+	timer.start();
+	int nRead = 0;
+	std::auto_ptr<CsvMappedReader> reader = spParallel->createReader(1);
+	while (!reader->endOfRange())
+	{
+		reader->readRecord(values);
+		++nRead;
+	}
+	timer.stop();
+	double fReadTime = timer.getTime();
+
+	TRACE_INFO("CsvFileIndex: " << nRows << " rows indexed and typed in " << fSequentialTime << "[sec] (" << nRows / std::max(fSequentialTime,1e-6) << " rows/sec) with one chunk, " <<
+		fParallelTime << "[sec] (" << nRows / std::max(fParallelTime,1e-6) << " rows/sec) with 16 chunks, read " << nRead << " rows in " << fReadTime << "[sec] (" << nRows / std::max(fReadTime,1e-6) << " rows/sec)");
+
+	reader.reset();
+	boost::filesystem::remove(file);
+}
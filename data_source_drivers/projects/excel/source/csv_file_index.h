@@ -0,0 +1,298 @@
+#ifndef EXCEL__CSV_FILE_INDEX_H
+#define EXCEL__CSV_FILE_INDEX_H
+
+/******************************************************************************
+csv_file_index.h
+
+begin      : 19/10/2026 10:00:00 AM
+copyright  : (c) 2026 by the PYXIS innovation inc.
+web        : www.pyxisinnovation.com
+******************************************************************************/
+
+#include "excel.h"
+
+// pyxlib includes
+#include "pyxis/utility/object.h"
+#include "pyxis/utility/value.h"
+#include "pyxis/utility/wire_buffer.h"
+
+// boost includes
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/scoped_ptr.hpp>
+
+// standard includes
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////
+// CsvMappedReader
+///////////////////////////////////////////
+//
+// CVS format we follow:
+// 1) ',' is a sperator.
+// 2) if a line ends with ',' - that mean there is an empty value after that ','
+// 3) if a value contain ',' - it must be encapsualted with '"'
+// 4) escaping '"' is double quote '""' - and it treaded as '"' inside a value
+// 5) leading spaces and trailing spaces are included if value is not qouted ('"')
+// 6) a new line inside a qouted value is part of the value
+// 7) a '\r' before the new line that ends a record is ignored
+///////////////////////////////////////////
+
+/*!
+CsvMappedReader reads the records of a CSV file through a memory mapped window.
+
+The reader reads the records that start in a byte range of the file. The last
+record of the range is read to its end even if it ends after the range, so
+consecutive ranges split on record boundaries read every record exactly once.
+
+The window is moved along the file as the records are read, and grows when a
+single record is larger than the window. Only the window is mapped at any time,
+so files larger than the address space can be read.
+
+A quoted value with new lines that is larger than knMaxQuotedValueSize is
+reported as a malformed record, so an unbalanced quote does not make the rest
+of the file a single record.
+*/
+class CsvMappedReader
+{
+public:
+	//! The default size of the mapped window.
+	static const std::size_t knDefaultWindowSize = 16 * 1024 * 1024;
+
+	//! The largest quoted value that spans lines, a larger one is reported as an unbalanced quote.
+	static const std::size_t knMaxQuotedValueSize = 1024 * 1024;
+
+	//! Create a reader for the records starting in [nBegin,nEnd) of a file of the given size.
+	CsvMappedReader(
+		const boost::filesystem::path & file,
+		boost::uint64_t nFileSize,
+		boost::uint64_t nBegin,
+		boost::uint64_t nEnd,
+		std::size_t nWindowSize = knDefaultWindowSize);
+
+	//! Return true if all the records of the range have been read.
+	bool endOfRange() const
+	{
+		return m_nPosition >= m_nEnd;
+	}
+
+	//! The offset of the next record in the file.
+	boost::uint64_t getPosition() const
+	{
+		return m_nPosition;
+	}
+
+	//! Read the next record. The strings of the vector are reused to avoid allocations.
+	void readRecord(std::vector<std::string> & values);
+
+	//! Skip the next record.
+	void skipRecord();
+
+private:
+
+	//! Find the end of the record at the current position and make sure the window contains it.
+	//! Throws if a quoted value of the record is larger than knMaxQuotedValueSize.
+	boost::uint64_t findRecordEnd();
+
+	//! Map a window of the file starting at the given offset.
+	void mapWindow(boost::uint64_t nOffset,std::size_t nSize);
+
+private:
+	boost::filesystem::path m_file;
+	boost::scoped_ptr<boost::interprocess::file_mapping> m_mapping;
+	boost::scoped_ptr<boost::interprocess::mapped_region> m_region;
+
+	//! The mapped window [m_nWindowBegin,m_nWindowEnd) of the file.
+	const char * m_pWindow;
+	boost::uint64_t m_nWindowBegin;
+	boost::uint64_t m_nWindowEnd;
+	std::size_t m_nWindowSize;
+
+	boost::uint64_t m_nFileSize;
+	boost::uint64_t m_nPosition;
+	boost::uint64_t m_nEnd;
+};
+
+///////////////////////////////////////////
+// CsvFieldTypeDetector
+///////////////////////////////////////////
+
+/*!
+CsvFieldTypeDetector detects the type of the fields of a CSV file from their
+values.
+
+The detected type depends on the order of the values (for example a column of
+integers with a single letter is a char column, but it is a string column if
+the letter comes first and a longer value follows). To allow the records of a
+file to be scanned in parallel, the detector tracks the type reached from every
+possible initial type, so the detectors of consecutive parts of a file can be
+chained with append() to get the exact type of a sequential scan.
+*/
+class CsvFieldTypeDetector
+{
+public:
+	//! Create a detector for the given number of fields.
+	explicit CsvFieldTypeDetector(int nFieldCount = 0);
+
+	//! Add the values of a record. Missing and extra values are ignored.
+	void addRecord(const std::vector<std::string> & values);
+
+	//! Chain the detector of the records that follow the records of this detector.
+	void append(const CsvFieldTypeDetector & next);
+
+	//! The detected type of a field (knNull if the field has no value).
+	PYXValue::eType getFieldType(int nField) const;
+
+	//! The number of fields.
+	int getFieldCount() const
+	{
+		return static_cast<int>(m_states.size());
+	}
+
+private:
+	enum eState
+	{
+		knNullState = 0,
+		knIntState,
+		knDoubleState,
+		knCharState,
+		knStringState,
+		knStateCount
+	};
+
+	//! The type reached by a field from every initial type.
+	struct Transitions
+	{
+		unsigned char state[knStateCount];
+	};
+
+	std::vector<Transitions> m_states;
+};
+
+///////////////////////////////////////////
+// CsvFileIndex
+///////////////////////////////////////////
+
+/*!
+CsvFileIndex is a row offset index of a CSV file, used to read any record in
+constant time.
+
+The index is built by splitting the file into chunks that are scanned in
+parallel. The quotes make the record boundaries depend on the text before a
+chunk, so the chunks are scanned twice: the first pass counts the quotes and
+the new lines of every chunk, from which the quote state and the first record
+number of every chunk are known, and the second pass reads the records that
+start in every chunk to record their offsets (and optionally detect the field
+types).
+
+Every knRecordStride-th record offset is stored, which keeps the index small
+for files with hundreds of millions of records. Record 0 is the header.
+*/
+class CsvFileIndex : public PYXObject
+{
+public:
+	//! The distance between two stored record offsets.
+	static const int knRecordStride = 32;
+
+	//! The default size of the chunks scanned in parallel.
+	static const boost::uint64_t knDefaultChunkSize = 4 * 1024 * 1024;
+
+	//! Test method
+	static void test();
+
+	//! Time the indexing and reading of a large file (not run by the tests).
+	static void benchmark();
+
+	//! Build the index of a file, detecting the field types if requested.
+	static PYXPointer<CsvFileIndex> create(
+		const boost::filesystem::path & file,
+		bool bDetectTypes,
+		boost::uint64_t nChunkSize = knDefaultChunkSize);
+
+	//! Load an index saved with save(), return null if the file size or modification time changed.
+	static PYXPointer<CsvFileIndex> create(const boost::filesystem::path & file,PYXWireBuffer & buffer);
+
+	//! Save the index.
+	void save(PYXWireBuffer & buffer) const;
+
+	//! The number of records in the file, including the header.
+	boost::uint64_t getRecordCount() const
+	{
+		return m_nRecordCount;
+	}
+
+	//! The size of the indexed file.
+	boost::uint64_t getFileSize() const
+	{
+		return m_nFileSize;
+	}
+
+	//! The offset of a record in the file.
+	boost::uint64_t getRecordOffset(boost::uint64_t nRecord) const;
+
+	//! Read a record.
+	void readRecord(boost::uint64_t nRecord,std::vector<std::string> & values) const;
+
+	//! Create a reader for the records from nRecord to the end of the file.
+	std::auto_ptr<CsvMappedReader> createReader(boost::uint64_t nRecord,std::size_t nWindowSize = CsvMappedReader::knDefaultWindowSize) const;
+
+	//! The values of the header (record 0).
+	const std::vector<std::string> & getHeader() const
+	{
+		return m_header;
+	}
+
+	//! The detected field types, only available if the index was built with bDetectTypes.
+	const CsvFieldTypeDetector & getFieldTypes() const
+	{
+		return m_fieldTypes;
+	}
+
+public:
+	CsvFileIndex(const boost::filesystem::path & file,boost::uint64_t nFileSize,boost::uint64_t nModifiedTime);
+
+private:
+	//! The result of the first pass over a chunk.
+	struct ChunkScan
+	{
+		bool bOddQuotes; //!< the chunk has an odd number of quotes
+		boost::uint64_t nNewLines[2]; //!< the new lines, by quote parity relative to the chunk start
+	};
+
+	//! The result of the second pass over a chunk.
+	struct ChunkRecords
+	{
+		boost::uint64_t nRecords;
+		std::vector<boost::uint64_t> offsets;
+		CsvFieldTypeDetector fieldTypes;
+	};
+
+	//! First pass: count the quotes and new lines of a chunk.
+	void scanChunk(boost::uint64_t nBegin,boost::uint64_t nEnd,ChunkScan * pScan) const;
+
+	//! Second pass: read the records that start in a chunk.
+	void readChunk(
+		boost::uint64_t nBegin,
+		boost::uint64_t nEnd,
+		bool bInQuotes,
+		boost::uint64_t nFirstRecord,
+		bool bDetectTypes,
+		ChunkRecords * pRecords) const;
+
+private:
+	boost::filesystem::path m_file;
+	boost::uint64_t m_nFileSize;
+	boost::uint64_t m_nModifiedTime;
+	boost::uint64_t m_nRecordCount;
+
+	//! The offset of every knRecordStride-th record.
+	std::vector<boost::uint64_t> m_offsets;
+
+	std::vector<std::string> m_header;
+	CsvFieldTypeDetector m_fieldTypes;
+};
+
+#endif
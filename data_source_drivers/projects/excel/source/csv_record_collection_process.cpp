@@ -412,6 +412,7 @@ boost::intrusive_ptr<IRecord> STDMETHODCALLTYPE CsvRecordCollectionProcess::getR
 	while(!iterator->end() && currentRecord < recordId)
 	{
 		iterator->next();
+		++currentRecord;
 	}
 
 	if (iterator->end())
@@ -392,6 +392,7 @@ boost::intrusive_ptr<IRecord> STDMETHODCALLTYPE CsvRecordCollectionProcess_v1::g
 	while(!iterator->end() && currentRecord < recordId)
 	{
 		iterator->next();
+		++currentRecord;
 	}
 
 	if (iterator->end())
@@ -22,7 +22,8 @@ web        : www.pyxisinnovation.com
 #include "pyxis/utility/tester.h"
 #include "pyxis/utility/app_services.h"
 
-#include <fstream>
+// standard includes
+#include <cstdlib>
 
 // {D2178619-22AF-4F74-8E3B-CF9B5DC0A18B}
 PYXCOM_DEFINE_CLSID(CsvRecordCollectionProcess_v2,
@@ -57,166 +58,6 @@ void CsvRecordCollectionProcess_v2::test()
 // IRecordCollection
 ////////////////////////////////////////////////////////////////////////////////
 
-///////////////////////////////////////////
-// CsvReader_v2
-///////////////////////////////////////////
-//
-// CVS format we follow:
-// 1) ',' is a sperator.
-// 2) if a line ends with ',' - that mean there is an empty value after that ','
-// 3) if a value contain ',' - it must be encapsualted with '"'
-// 4) escaping '"' is double quote '""' - and it treaded as '"' inside a value
-// 5) leading spaces and trailing spaces are included if value is not qouted ('"')
-///////////////////////////////////////////
-
-class CsvReader_v2
-{
-private:
-	boost::filesystem::path m_file;
-	std::ifstream m_fileStream;
-	bool m_fileIsOpen;
-	bool m_eof;
-	std::string m_currentLine;
-
-public:
-	CsvReader_v2(boost::filesystem::path file) : m_file(file), m_fileIsOpen(false),m_eof(false)
-	{
-		//should be outside of the constructor
-		openFile();
-		getNextLine();
-	}
-
-	~CsvReader_v2()
-	{
-		if (m_fileIsOpen)
-		{
-			m_fileStream.close();
-		}
-	}
-
-public:
-	void openFile()
-	{
-		if (!m_fileIsOpen)
-		{
-			m_fileStream.open(FileUtils::pathToString(m_file).c_str(), std::ios::in);
-			// open the file
-			if (!m_fileStream.good())
-			{
-				PYXTHROW(PYXException,"Failed to open file: " << m_file);
-			}
-			m_fileIsOpen = true;
-		}
-	}
-
-	bool endOfFile() const
-	{
-		return m_eof;
-	}
-
-private:
-	std::string getNextLine()
-	{
-		if (!m_fileIsOpen)
-		{
-			PYXTHROW(PYXException,"file not opened");
-		}
-
-		//get the last line we read
-		std::string strLine = m_currentLine;
-
-		// try to read the next next line - to see if we got EOF.
-		if (!std::getline(m_fileStream, m_currentLine))
-		{
-			m_eof = true;
-		}
-
-		//return the previous line we read
-		return strLine;
-	}
-
-public:
-	enum ReaderState
-	{
-		knNormalValue,
-		knStringValue,
-		knStringEnding
-	};
-
-	std::vector<std::string> readRecord()
-	{
-		if (!m_fileIsOpen)
-		{
-			PYXTHROW(PYXException,"file not opened");
-		}
-
-		std::vector<std::string> record;
-
-		ReaderState state = knNormalValue;
-
-		std::string line = getNextLine();
-		std::string currentValue;
-
-		for(auto & c : line)
-		{
-			switch(state)
-			{
-			case knNormalValue:
-				switch(c)
-				{
-				case ',':
-					record.push_back(currentValue);
-					currentValue.clear();
-					break;
-				case '"':
-					state = knStringValue;
-					currentValue.clear(); //ignore everything before the '"'
-					break;
-				default:
-					currentValue.push_back(c);
-					break;
-				}
-				break;
-
-			case knStringValue:
-				switch(c)
-				{
-				case '"':
-					//we move to knStringEnding because this could double quote...
-					state = knStringEnding;
-					break;
-				default:
-					currentValue.push_back(c);
-					break;
-				}
-				break;
-
-			case knStringEnding:
-				switch(c)
-				{
-				case '"': //double "" - which is translted as single '"' value
-					currentValue.push_back('"');
-					state = knStringValue;
-					break;
-				case ',':
-					record.push_back(currentValue);
-					currentValue.clear();
-					state = knNormalValue;
-					break;
-
-				default: // do nothing - this should be only white space
-					break;
-				}
-				break;
-			}
-		}
-
-		record.push_back(currentValue);
-
-		return record;
-	}
-};
-
 class CsvRecord_v2 : public IRecord
 {
 private:
@@ -300,10 +141,12 @@ public:
 		auto record = boost::intrusive_ptr<CsvRecord_v2>(new CsvRecord_v2());
 		record->m_definition = definition;
 
+		record->m_values.reserve(definition->getFieldCount());
+
 		for(int fieldIndex = 0; fieldIndex < definition->getFieldCount(); ++fieldIndex)
 		{
 			auto & field = definition->getFieldDefinition(fieldIndex);
-			if (values[fieldIndex].empty())
+			if (fieldIndex >= static_cast<int>(values.size()) || values[fieldIndex].empty())
 			{
 				//push null value
 				record->m_values.push_back(PYXValue());
@@ -320,9 +163,26 @@ public:
 				{
 					trimmedValue = values[fieldIndex];
 				}
-				PYXValue value = field.getTypeCompatibleValue();
-				value.setString(trimmedValue);
-				record->m_values.push_back(value);
+
+				//numbers are converted directly to the field type (same as PYXValue::setString, without the string stream)
+				switch (field.getType())
+				{
+				case PYXValue::knInt32:
+					record->m_values.push_back(PYXValue(static_cast<int>(strtoul(trimmedValue.c_str(),0,10))));
+					break;
+
+				case PYXValue::knDouble:
+					record->m_values.push_back(PYXValue(strtod(trimmedValue.c_str(),0)));
+					break;
+
+				default:
+					{
+						PYXValue value = field.getTypeCompatibleValue();
+						value.setString(trimmedValue);
+						record->m_values.push_back(value);
+					}
+					break;
+				}
 			}
 		}
 
@@ -333,10 +193,13 @@ public:
 class CsvRecordIterator_v2 : public RecordIterator
 {
 private:
-	CsvReader_v2 m_reader;
+	std::auto_ptr<CsvMappedReader> m_reader;
 	PYXPointer<PYXTableDefinition> m_definition;
 	boost::intrusive_ptr<IRecord> m_currentRecord;
 
+	//! The values of the current record, reused between records.
+	std::vector<std::string> m_values;
+
 public:
 
 	virtual bool end() const
@@ -346,9 +209,10 @@ public:
 
 	virtual void next()
 	{
-		if (!m_reader.endOfFile())
+		if (!m_reader->endOfRange())
 		{
-			m_currentRecord = CsvRecord_v2::create(m_reader.readRecord(),m_definition);
+			m_reader->readRecord(m_values);
+			m_currentRecord = CsvRecord_v2::create(m_values,m_definition);
 		}
 		else
 		{
@@ -362,15 +226,15 @@ public:
 	}
 
 public:
-	static PYXPointer<CsvRecordIterator_v2> create(const boost::filesystem::path & file,const PYXPointer<PYXTableDefinition> & definition)
+	static PYXPointer<CsvRecordIterator_v2> create(const PYXPointer<CsvFileIndex> & index,const PYXPointer<PYXTableDefinition> & definition)
 	{
-		return PYXNEW(CsvRecordIterator_v2,file,definition);
+		return PYXNEW(CsvRecordIterator_v2,index,definition);
 	}
 
-	CsvRecordIterator_v2(const boost::filesystem::path & file,const PYXPointer<PYXTableDefinition> & definition) : m_reader(file),m_definition(definition)
+	CsvRecordIterator_v2(const PYXPointer<CsvFileIndex> & index,const PYXPointer<PYXTableDefinition> & definition) : m_definition(definition)
 	{
 		//skip headers
-		m_reader.readRecord();
+		m_reader = index->createReader(1);
 
 		//read first record
 		next();
@@ -379,7 +243,7 @@ public:
 
 PYXPointer<RecordIterator> STDMETHODCALLTYPE CsvRecordCollectionProcess_v2::getIterator() const
 {
-	return CsvRecordIterator_v2::create(m_inputFile,m_recordDefinition);
+	return CsvRecordIterator_v2::create(m_index,m_recordDefinition);
 }
 
 PYXPointer<PYXTableDefinition> STDMETHODCALLTYPE CsvRecordCollectionProcess_v2::getRecordDefinition() const
@@ -389,20 +253,18 @@ PYXPointer<PYXTableDefinition> STDMETHODCALLTYPE CsvRecordCollectionProcess_v2::
 
 boost::intrusive_ptr<IRecord> STDMETHODCALLTYPE CsvRecordCollectionProcess_v2::getRecord(const std::string & strRecordID) const
 {
-	PYXPointer<RecordIterator> iterator = getIterator();
-	int recordId= StringUtils::fromString<int>(strRecordID);
-	int currentRecord = 0;
-	while(!iterator->end() && currentRecord < recordId)
-	{
-		iterator->next();
-	}
+	int recordId = StringUtils::fromString<int>(strRecordID);
 
-	if (iterator->end())
+	//record 0 of the file is the header
+	if (recordId < 0 || static_cast<boost::uint64_t>(recordId) + 1 >= m_index->getRecordCount())
 	{
 		PYXTHROW(PYXException,"Record ID is out of range");
 	}
 
-	return iterator->getRecord();
+	std::vector<std::string> values;
+	m_index->readRecord(recordId + 1,values);
+
+	return CsvRecord_v2::create(values,m_recordDefinition);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -445,7 +307,16 @@ IProcess::eInitStatus CsvRecordCollectionProcess_v2::initImpl()
 
 	m_inputFile = FileUtils::stringToPath(pathProcess->getLocallyResolvedPath());
 
-	if (!extractRecordDefinitionFromCache() && !extractRecordDefinition())
+	bool hasDefinition = extractRecordDefinitionFromCache();
+
+	if (!hasDefinition || !extractIndexFromCache())
+	{
+		//index the file in parallel, and detect the field types on the way if needed
+		m_index = CsvFileIndex::create(m_inputFile,!hasDefinition);
+		writeIndexToCache();
+	}
+
+	if (!hasDefinition && !extractRecordDefinition())
 	{
 		return knFailedToInit;
 	}
@@ -500,77 +371,59 @@ bool CsvRecordCollectionProcess_v2::writeRecordDefinitionToCache()
 	return true;
 }
 
-bool CsvRecordCollectionProcess_v2::extractRecordDefinition()
+bool CsvRecordCollectionProcess_v2::extractIndexFromCache()
 {
-	CsvReader_v2 reader(m_inputFile);
+	if (!PipeUtils::isPipelineIdentityStable(this)) {
+		return false;
+	}
 
-	std::vector<std::string> fieldNames = reader.readRecord();
-	std::vector<PYXValue::eType> fieldTypes(fieldNames.size(),PYXValue::knNull);
+	auto storage = PYXProcessLocalStorage::create(getIdentity());
 
-	while(!reader.endOfFile())
-	{
-		std::vector<std::string> values = reader.readRecord();
+	std::auto_ptr<PYXConstWireBuffer> indexBuffer = storage->get("csv:index");
 
-		// may have less values than field names
-		auto end = std::min(values.size(), fieldNames.size());
-		for (unsigned int i = 0; i < end; ++i)
-		{
-			//if this is string value - nothing left to do
-			if (fieldTypes[i]==PYXValue::knString)
-			{
-				continue;
-			}
+	m_index.reset();
+	if (indexBuffer.get() != 0)
+	{
+		//the index is ignored if the file has changed
+		m_index = CsvFileIndex::create(m_inputFile,*indexBuffer);
+	}
 
-			//if this is a char - make sure the value is 1 char long
-			if (fieldTypes[i]==PYXValue::knChar)
-			{
-				if (values[i].size() > 1)
-				{
-					fieldTypes[i]=PYXValue::knString;
-				}
-				continue;
-			}
+	return m_index.get() != 0;
+}
 
-			std::string trimmedValue = StringUtils::trim(values[i]);
+bool CsvRecordCollectionProcess_v2::writeIndexToCache()
+{
+	if (!PipeUtils::isPipelineIdentityStable(this)) {
+		return false;
+	}
 
-			//empty value - aka - null, nothing to do here
-			if (trimmedValue.empty())
-			{
-				continue;
-			}
+	auto storage = PYXProcessLocalStorage::create(getIdentity());
 
-			//check if this is a number
-			std::string valueStr;
-			if (StringUtils::tryParseFormattedNumber(trimmedValue,valueStr))
-			{
-				//if the type is double already - there is nothing to do
-				if (fieldTypes[i]==PYXValue::knDouble)
-				{
-					continue;
-				}
-				bool isInteger = StringUtils::countDecimalPlaces(valueStr)==0;
+	PYXStringWireBuffer buffer;
+	m_index->save(buffer);
 
-				//try to set it as unsigned integer or a double
-				fieldTypes[i]=isInteger? PYXValue::knInt32 : PYXValue::knDouble;
-				continue;
-			}
+	storage->set("csv:index",buffer);
+	return true;
+}
 
-			// this column is string
-			fieldTypes[i]=values[i].size()==1?PYXValue::knChar:PYXValue::knString;
-		}
-	}
+bool CsvRecordCollectionProcess_v2::extractRecordDefinition()
+{
+	const std::vector<std::string> & fieldNames = m_index->getHeader();
+	const CsvFieldTypeDetector & fieldTypes = m_index->getFieldTypes();
 
 	m_recordDefinition = PYXTableDefinition::create();
 
 	for(unsigned int i=0;i<fieldNames.size();++i)
 	{
+		PYXValue::eType fieldType = fieldTypes.getFieldType(i);
+
 		//if we werent able to detect the value type
-		if (fieldTypes[i] == PYXValue::knNull)
+		if (fieldType == PYXValue::knNull)
 		{
 			//make it string as default
-			fieldTypes[i] = PYXValue::knString;
+			fieldType = PYXValue::knString;
 		}
-		m_recordDefinition->addFieldDefinition(fieldNames[i],PYXFieldDefinition::knContextNone,fieldTypes[i]);
+		m_recordDefinition->addFieldDefinition(fieldNames[i],PYXFieldDefinition::knContextNone,fieldType);
 	}
 
 	//store definition for next time.
@@ -10,6 +10,7 @@ web        : www.pyxisinnovation.com
 ******************************************************************************/
 
 #include "excel.h"
+#include "csv_file_index.h"
 
 // pyxlib includes
 #include "pyxis/data/record_collection.h"
@@ -91,10 +92,15 @@ private:
 	bool extractRecordDefinitionFromCache();
 	bool writeRecordDefinitionToCache();
 	bool extractRecordDefinition();
+	bool extractIndexFromCache();
+	bool writeIndexToCache();
 
 private:
 	PYXPointer<PYXTableDefinition> m_recordDefinition;
 	boost::filesystem::path m_inputFile;
+
+	//! The record offsets, used to read any record without reading the records before it.
+	PYXPointer<CsvFileIndex> m_index;
 };
 
 #endif
@@ -277,6 +277,7 @@ boost::intrusive_ptr<IRecord> STDMETHODCALLTYPE ExcelRecordCollectionProcess ::g
 	while(!iterator->end() && currentRecord < recordId)
 	{
 		iterator->next();
+		++currentRecord;
 	}
 
 	if (iterator->end())
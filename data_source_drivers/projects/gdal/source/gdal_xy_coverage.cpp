@@ -2912,8 +2912,8 @@ bool GDALXYCoverage::Buffer::read(const PYXCoord2DInt& raster,byte * dest)
 	return true;
 }
 
-boost::mutex GDALXYCoverage::BufferCache::s_mutex;
-CacheMap<GDALXYCoverage::BufferCache*,std::list<PYXPointer<GDALXYCoverage::Buffer>>> GDALXYCoverage::BufferCache::s_allBufferCache(10);
+//a single shard without admission: the cache is small and a coverage must always get its list
+ConcurrentCache<GDALXYCoverage::BufferCache*,PYXPointer<GDALXYCoverage::BufferCache::BufferList>> GDALXYCoverage::BufferCache::s_allBufferCache(10,1,false);
 
 GDALXYCoverage::BufferCache::BufferCache()
 {
@@ -2921,14 +2921,19 @@ GDALXYCoverage::BufferCache::BufferCache()
 
 GDALXYCoverage::BufferCache::~BufferCache()
 {
-	boost::mutex::scoped_lock lock(s_mutex);
 	s_allBufferCache.erase(this);
 }
 
+PYXPointer<GDALXYCoverage::BufferCache::BufferList> GDALXYCoverage::BufferCache::getBufferList()
+{
+	return s_allBufferCache.getOrCreate(this,&BufferList::create,&BufferList::getWeight);
+}
+
 void GDALXYCoverage::BufferCache::add( PYXPointer<Buffer> buffer)
 {
-	boost::mutex::scoped_lock lock(s_mutex);
-	auto & list = s_allBufferCache[this];
+	auto bufferList = getBufferList();
+	boost::mutex::scoped_lock lock(bufferList->m_mutex);
+	auto & list = bufferList->m_buffers;
 	list.push_front(buffer);
 	if (list.size()>20)
 	{
@@ -2938,8 +2943,9 @@ void GDALXYCoverage::BufferCache::add( PYXPointer<Buffer> buffer)
 
 void GDALXYCoverage::BufferCache::freeLargeBuffers()
 {
-	boost::mutex::scoped_lock lock(s_mutex);
-	auto & list = s_allBufferCache[this];
+	auto bufferList = getBufferList();
+	boost::mutex::scoped_lock lock(bufferList->m_mutex);
+	auto & list = bufferList->m_buffers;
 	while (list.size()>3)
 	{
 		list.pop_back();
@@ -2948,9 +2954,10 @@ void GDALXYCoverage::BufferCache::freeLargeBuffers()
 
 PYXPointer<GDALXYCoverage::Buffer> GDALXYCoverage::BufferCache::findContainingBuffer( const PYXRect2DInt& bufferBounds)
 {
-	boost::mutex::scoped_lock lock(s_mutex);
+	auto bufferList = getBufferList();
+	boost::mutex::scoped_lock lock(bufferList->m_mutex);
 
-	auto & list = s_allBufferCache[this];
+	auto & list = bufferList->m_buffers;
 	for(auto item = list.begin();item != list.end(); ++item)
 	{
 		if ((*item)->getReadBounds().contains(bufferBounds))
@@ -2968,9 +2975,10 @@ PYXPointer<GDALXYCoverage::Buffer> GDALXYCoverage::BufferCache::findContainingBu
 
 PYXPointer<GDALXYCoverage::Buffer> GDALXYCoverage::BufferCache::findContainingBuffer( const PYXCoord2DInt & raster)
 {
-	boost::mutex::scoped_lock lock(s_mutex);
+	auto bufferList = getBufferList();
+	boost::mutex::scoped_lock lock(bufferList->m_mutex);
 
-	auto & list = s_allBufferCache[this];
+	auto & list = bufferList->m_buffers;
 	for(auto item = list.begin();item != list.end(); ++item)
 	{
 		if ((*item)->getReadBounds().inside(raster))
@@ -26,7 +26,7 @@ web        : www.pyxisinnovation.com
 #include "pyxis/utility/object.h"
 #include "pyxis/utility/value.h"
 #include "pyxis/utility/memory_manager.h"
-#include "pyxis/utility/cache_map.h"
+#include "pyxis/utility/concurrent_cache.h"
 
 // GDAL includes
 #include "gdal_metadata.h"
@@ -571,8 +571,31 @@ private:
 		void freeLargeBuffers();
 
 	private:
-		static boost::mutex s_mutex;		
-		static CacheMap<BufferCache*,std::list<PYXPointer<Buffer> > > s_allBufferCache;
+		//! The buffers of a single coverage, most recently used first.
+		class BufferList : public PYXObject
+		{
+		public:
+			static PYXPointer<BufferList> create()
+			{
+				return PYXNEW(BufferList);
+			}
+
+			//! Every coverage counts as one entry in s_allBufferCache.
+			static size_t getWeight(const PYXPointer<BufferList> & list)
+			{
+				return 1;
+			}
+
+		public:
+			boost::mutex m_mutex;
+			std::list<PYXPointer<Buffer> > m_buffers;
+		};
+
+		PYXPointer<BufferList> getBufferList();
+
+	private:
+		//! The buffers of the 10 most used coverages. Every list has its own lock, so coverages don't wait for each other.
+		static ConcurrentCache<BufferCache*,PYXPointer<BufferList> > s_allBufferCache;
 	};
 
 
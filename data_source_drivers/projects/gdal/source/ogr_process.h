@@ -73,13 +73,13 @@ public: // IProcess
 
 	virtual boost::intrusive_ptr<const PYXCOM_IUnknown> STDMETHODCALLTYPE getOutput() const
 	{
-		return m_spDS;
+		return static_cast<const IFeatureCollection*>(m_spDS.get());
 		//return static_cast<const IFeatureCollection*>(this);
 	}
 
 	virtual boost::intrusive_ptr<PYXCOM_IUnknown> STDMETHODCALLTYPE getOutput()
 	{
-		return m_spDS;
+		return static_cast<IFeatureCollection*>(m_spDS.get());
 		//return static_cast<IFeatureCollection*>(this);
 	}
 
@@ -26,7 +26,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/exception.h"
 #include "pyxis/utility/great_circle_arc.h"
 #include "pyxis/utility/string_utils.h"
-#include "pyxis/utility/checksum_calculator.h"
+#include "pyxis/utility/native_checksum_calculator.h"
 #include "pyxis/pipe/process_local_storage.h"
 #include "pyxis/procs/user_credentials_provider.h"
 
@@ -35,6 +35,7 @@ web			: www.pyxisinnovation.com
 
 // standard includes
 #include <cassert>
+#include <cstdio>
 #include <fstream>
 #include <limits>
 #include <boost/algorithm/string.hpp>
@@ -410,14 +411,9 @@ void PYXOGRDataSource::buildRTree(	const std::string& strName,
 	{
 		strFileName = strName;
 
-		std::string checkSum = ChecksumCalculator::getChecksumCalculator()->calculateFileCheckSum(strFileName);
-
-		//TODO: we need a better way to detect checksum calculation error, this is an infinite loop if there is some error
-		while(checkSum.empty())
-		{
-			boost::this_thread::sleep(boost::posix_time::milliseconds(100));
-			checkSum = ChecksumCalculator::getChecksumCalculator()->calculateFileCheckSum(strFileName);
-		}
+		// the checksum only keys the local rtree cache, so use the native calculator:
+		// it hashes large files in parallel and remembers checksums of unchanged files.
+		std::string checkSum = NativeChecksumCalculator::getInstance()->calculateFileCheckSum(strFileName);
 
 		boost::filesystem::path root = AppServices::getCacheDir("rtree");
 		boost::replace_all(checkSum,"/","_");
@@ -874,9 +870,12 @@ PYXPointer<FeatureIterator> PYXOGRDataSource::getFeatureIterator(
 		{
 			auto safePointer = OGRFeatureObject::create(pOGRFeature);
 			OGRGeometry* pOGRGeometry = pOGRFeature->GetGeometryRef();
-			if (pOGRGeometry != nullptr) 
+			if (pOGRGeometry == nullptr) 
 			{
 				TRACE_INFO("Warning, skipping feature with no geometry. FeatureID=" << pOGRFeature->GetFID() );
+			}
+			else
+			{
 				setFID.insert(pOGRFeature->GetFID());
 			}
 		}
@@ -953,9 +952,12 @@ PYXPointer<FeatureIterator> PYXOGRDataSource::getFeatureIterator(
 			{
 				auto safePointer = OGRFeatureObject::create(pOGRFeature);
 				OGRGeometry* pOGRGeometry = pOGRFeature->GetGeometryRef();
-				if (pOGRGeometry != nullptr) 
+				if (pOGRGeometry == nullptr) 
 				{
 					TRACE_INFO("Warning, skipping feature with no geometry. FeatureID=" << pOGRFeature->GetFID() );
+				}
+				else
+				{
 					setFID.insert(pOGRFeature->GetFID());
 				}
 			}
@@ -982,9 +984,12 @@ PYXPointer<FeatureIterator> PYXOGRDataSource::getFeatureIterator(
 			{
 				auto safePointer = OGRFeatureObject::create(pOGRFeature);
 				OGRGeometry* pOGRGeometry = pOGRFeature->GetGeometryRef();
-				if (pOGRGeometry != nullptr) 
+				if (pOGRGeometry == nullptr) 
 				{
 					TRACE_INFO("Warning, skipping feature with no geometry. FeatureID=" << pOGRFeature->GetFID() );
+				}
+				else
+				{
 					setFID.insert(pOGRFeature->GetFID());
 				}
 			}
@@ -1003,6 +1008,137 @@ PYXPointer<FeatureIterator> PYXOGRDataSource::getFeatureIterator(
 												geometry.getCellResolution() );	
 }
 
+namespace
+{
+
+/*!
+Translate a predicate to an OGR SQL where clause.
+
+The clause selects a superset of the features that match the predicate: the
+string comparisons of OGR may be case insensitive, and null values don't follow
+the XPath rules under a NOT, so only = on strings, comparisons of numeric fields
+with numbers and the supported operands of AND/OR are translated.
+
+\return false if the predicate can't be translated.
+*/
+bool toOGRWhere(const PYXAttributePredicate & predicate,const PYXTableDefinition & definition,std::string & strWhere)
+{
+	switch (predicate.getType())
+	{
+	case PYXAttributePredicate::knAnd:
+		{
+			// the operands that can't be translated are dropped, which selects more features
+			std::vector<std::string> operands;
+			for (unsigned int i = 0; i < predicate.getChildren().size(); ++i)
+			{
+				std::string strOperand;
+				if (toOGRWhere(*predicate.getChildren()[i],definition,strOperand))
+				{
+					operands.push_back("(" + strOperand + ")");
+				}
+			}
+			if (operands.empty())
+			{
+				return false;
+			}
+			strWhere = boost::algorithm::join(operands," AND ");
+			return true;
+		}
+
+	case PYXAttributePredicate::knOr:
+		{
+			std::vector<std::string> operands;
+			for (unsigned int i = 0; i < predicate.getChildren().size(); ++i)
+			{
+				std::string strOperand;
+				if (!toOGRWhere(*predicate.getChildren()[i],definition,strOperand))
+				{
+					return false;
+				}
+				operands.push_back("(" + strOperand + ")");
+			}
+			strWhere = boost::algorithm::join(operands," OR ");
+			return true;
+		}
+
+	case PYXAttributePredicate::knCompare:
+		{
+			int nFieldIndex = definition.getFieldIndex(predicate.getFieldName());
+			if (nFieldIndex < 0 || predicate.getFieldName().find('"') != std::string::npos)
+			{
+				return false;
+			}
+
+			const PYXFieldDefinition & field = definition.getFieldDefinition(nFieldIndex);
+			std::string strField = "\"" + predicate.getFieldName() + "\"";
+
+			if (predicate.isStringComparison())
+			{
+				if (field.isNumeric() || predicate.getOperator() != PYXAttributePredicate::knEqual)
+				{
+					return false;
+				}
+				strWhere = strField + " = '" + boost::algorithm::replace_all_copy(predicate.getLiteral().getString(),"'","''") + "'";
+				return true;
+			}
+
+			double fLiteral = predicate.getLiteral().getDouble();
+			if (!field.isNumeric() || fLiteral != fLiteral)
+			{
+				return false;
+			}
+
+			static const char * operators[] = { " = ", " <> ", " < ", " <= ", " > ", " >= " };
+			char buffer[32];
+			sprintf(buffer,"%.17g",fLiteral);
+			strWhere = strField + operators[predicate.getOperator()] + buffer;
+			return true;
+		}
+
+	default:
+		return false;
+	}
+}
+
+}
+
+/*!
+Get an iterator to the features that may match a predicate, using the attribute
+filter of the OGR layer.
+
+\param	predicate	The attribute predicate.
+
+\return	The iterator, or null if the predicate can't be translated.
+*/
+PYXPointer<FeatureIterator> PYXOGRDataSource::getIterator(const PYXAttributePredicate & predicate) const
+{
+	std::string strWhere;
+	if (!toOGRWhere(predicate,*m_spFeatDefn,strWhere))
+	{
+		return PYXPointer<FeatureIterator>();
+	}
+	return getFeatureIterator(strWhere);
+}
+
+/*!
+Get an iterator to the features that intersect a geometry and may match a
+predicate, using the spatial and attribute filters of the OGR layer.
+
+\param	geometry	The spatial qualification.
+\param	predicate	The attribute predicate.
+
+\return	The iterator, or null if the predicate can't be translated.
+*/
+PYXPointer<FeatureIterator> PYXOGRDataSource::getIterator(const PYXGeometry & geometry,const PYXAttributePredicate & predicate) const
+{
+	std::string strWhere;
+	if (!toOGRWhere(predicate,*m_spFeatDefn,strWhere))
+	{
+		return PYXPointer<FeatureIterator>();
+	}
+	return getFeatureIterator(geometry,strWhere);
+}
+
 /*!
 Calculate the bounding rectangles that cover the specified PYXIS geometry. Most
 of the time only one rectangle will be returned (the other will be empty). For
@@ -15,6 +15,8 @@ web			: www.pyxisinnovation.com
 
 // pyxlib includes
 #include "pyxis/data/feature_collection.h"
+#include "pyxis/data/feature_collection_filter.h"
+#include "pyxis/pipe/process.h"
 #include "pyxis/procs/srs.h"
 #include "pyxis/utility/local_storage.h"
 #include "pyxis/utility/rect_2d.h"
@@ -78,7 +80,7 @@ public:
 PYXOGRDataSource wraps an OGR data source to provide a PYXDataSource interface.
 */
 //! Provides access to data sources through the OGR class library.
-class PYXOGRDataSource : public IFeatureCollection
+class PYXOGRDataSource : public IFeatureCollection, public IFeatureCollectionFilter
 {
 	friend class PYXSharedGDALDataSet;
 	friend class OGRFeatureObject;
@@ -95,10 +97,13 @@ public: // PYXCOM_IUnknown
 		IUNKNOWN_QI_CASE(IRecord)
 		IUNKNOWN_QI_CASE(IFeature)
 		IUNKNOWN_QI_CASE(IFeatureCollection)
+		IUNKNOWN_QI_CASE(IFeatureCollectionFilter)
 	IUNKNOWN_QI_END
 
 	IUNKNOWN_RC_IMPL();
 
+	IUNKNOWN_DEFAULT_CAST(PYXOGRDataSource, IFeatureCollection);
+
 public: // IRecord
 
 	IRECORD_IMPL();
@@ -160,6 +165,12 @@ public: // IFeatureCollection
 	}
 
 	IFEATURECOLLECTION_IMPL_HINTS();
+
+public: // IFeatureCollectionFilter
+
+	virtual PYXPointer<FeatureIterator> STDMETHODCALLTYPE getIterator(const PYXAttributePredicate & predicate) const;
+
+	virtual PYXPointer<FeatureIterator> STDMETHODCALLTYPE getIterator(const PYXGeometry & geometry,const PYXAttributePredicate & predicate) const;
 	
 public: // misc holding area
 
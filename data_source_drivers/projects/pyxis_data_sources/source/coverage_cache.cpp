@@ -26,6 +26,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/procs/geopacket_source.h"
 #include "pyxis/utility/profile.h"
 #include "pyxis/storage/pyxis_blob_provider.h"
+#include "pyxis/storage/tiered_blob_provider.h"
 
 
 #define Airborne_Imaging_Demo
@@ -706,7 +707,12 @@ PYXPointer<PYXValueTile>
 	if (cacheHasDataSupply())
 	{
 		notifyProcessing(ProcessProcessingEvent::Processing);
+
+		//the time to generate the tile is the cost to rebuild it if it gets evicted
+		PYXHighQualityTimer timer;
+		timer.start();
 		spTile = getInput()->getCoverageTile(tile);
+		timer.stop();
 
 		if (spTile)
 		{
@@ -716,7 +722,7 @@ PYXPointer<PYXValueTile>
 			spTile->setIsComplete(true);
 
 			//Got the tile from our input. Add to cache and return.
-			getCache()->setCoverageTile(spTile);
+			getCache()->setCoverageTile(spTile,PYXCost(timer.getTime()));
 
 			m_tileHasValuesCache[tile] = true;
 			return spTile;
@@ -740,7 +746,7 @@ PYXPointer<PYXValueTile>
 			spTile->setIsComplete(true);
 
 			//Got the tile from Blob Storage. Add to cache and return.
-			getCache()->setCoverageTile(spTile);
+			getCache()->setCoverageTile(spTile,PYXCost::knNetworkCost);
 
 			m_tileHasValuesCache[tile] = true;
 			return spTile;
@@ -779,12 +785,39 @@ PYXPointer<PYXValueTile>
 }
 
 
+namespace
+{
+
+//! Protects s_spBlobProvider.
+boost::mutex s_blobProviderMutex;
+
+//! The blob provider shared by the coverage caches.
+std::shared_ptr<TieredBlobProvider> s_spBlobProvider;
+
+/*!
+Get the blob provider shared by the coverage caches: the PYXIS storage behind a
+local tier in the cache directory, so the tiles are downloaded once and the
+concurrent requests for a tile are sent once.
+*/
+std::shared_ptr<TieredBlobProvider> getBlobProvider()
+{
+	boost::mutex::scoped_lock lock(s_blobProviderMutex);
+	if (!s_spBlobProvider)
+	{
+		s_spBlobProvider = std::make_shared<TieredBlobProvider>(
+			std::make_shared<LocalBlobProvider>(AppServices::getCacheDir("Blobs")),
+			std::make_shared<PyxisBlobProvider>());
+	}
+	return s_spBlobProvider;
+}
+
+}
+
 PYXPointer <PYXValueTile> PYXCoverageCache::streamFromBlob ( const PYXTile& tile) const
 {
 	auto key = "Version2:" +procRefToStr(ProcRef(getProcID(), getProcVersion())) + "-Depth:" +  StringUtils::toString(tile.getDepth()) + "-Index:" + tile.getRootIndex().toString();
-	PyxisBlobProvider bprovider;
 	std::stringstream downloaded;
-	if(bprovider.getBlob(key, downloaded))
+	if(getBlobProvider()->getBlob(key, downloaded))
 	{
 		PYXPointer <PYXValueTile> result = PYXValueTile::create(downloaded); 
 		return result;
@@ -797,10 +830,9 @@ bool PYXCoverageCache::streamToBlob (PYXPointer <PYXValueTile>  spValueTile) con
 {
 	auto tile = spValueTile->getTile();
 	auto key = "Version2:" +procRefToStr(ProcRef(getProcID(), getProcVersion())) + "-Depth:" +  StringUtils::toString(tile.getDepth()) + "-Index:" + tile.getRootIndex().toString();
-	PyxisBlobProvider blobProvider;
 	std::stringstream toUpload;
 	spValueTile->serialize(toUpload);
-	auto result = blobProvider.addBlob(key, toUpload);
+	auto result = getBlobProvider()->addBlob(key, toUpload);
 	return result;
 }
 
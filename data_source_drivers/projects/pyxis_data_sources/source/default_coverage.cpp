@@ -307,7 +307,7 @@ PYXPointer<PYXValueTile> PYXDefaultCoverage::getTile(const PYXTile& tile) const
 			return spVT;
 		}
 
-		m_tileCache.add(spVT);
+		m_tileCache.add(spVT,PYXCost::knImmediateCost);
 	}
 
 	{		
@@ -522,12 +522,24 @@ Set coverage values for an entire tile (all fields).
 \param	spInputTile	Shared pointer to a PYXValueTile containing value data.
 */
 void PYXDefaultCoverage::setCoverageTile(PYXPointer<PYXValueTile> spInputTile)
+{
+	setCoverageTile(spInputTile,PYXCost::knDefaultCost);
+}
+
+/*!
+Set coverage values for an entire tile (all fields). The tile is registered with
+the memory manager so it can be evicted according to its size and rebuild cost.
+
+\param	spInputTile	Shared pointer to a PYXValueTile containing value data.
+\param	rebuildCost	The cost to rebuild the tile (for example, the input ICoverage::getTileCost).
+*/
+void PYXDefaultCoverage::setCoverageTile(PYXPointer<PYXValueTile> spInputTile,const PYXCost & rebuildCost)
 {
 	PYXPointer<PYXValueTile> spExistingTile = m_tileCache.getTile(spInputTile->getTile());
 
 	if (!spExistingTile)
 	{
-		m_tileCache.add(spInputTile);
+		m_tileCache.add(spInputTile,rebuildCost);
 		if (m_bPersistent)
 		{
 			persistTile(spInputTile.get());
@@ -874,7 +886,7 @@ void PYXDefaultCoverage::addTileFile(const std::string& strFullFileName)
 	PYXPointer<PYXValueTile> pDataTile = PYXValueTile::create(in);
 
 	// might as well put this tile in our cache, since we've read it
-	m_tileCache.add(pDataTile);
+	m_tileCache.add(pDataTile,PYXCost::knImmediateCost);
 
 	// TODO:: we need to figure out if we are managing our own geometry, or
 	// if the geometry has been supplied for us.
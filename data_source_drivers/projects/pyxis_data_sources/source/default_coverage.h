@@ -176,6 +176,9 @@ public:
 	//! Set coverage values for an entire tile.
 	virtual void setCoverageTile(PYXPointer<PYXValueTile> spValueTile);
 
+	//! Set coverage values for an entire tile, with the cost to rebuild the tile if it is evicted.
+	void setCoverageTile(PYXPointer<PYXValueTile> spValueTile,const PYXCost & rebuildCost);
+
 	//! Set tile cache size limit.
 	void setCacheMaxTileCount(const int nTileCount) {m_tileCache.setMaxTileCount(nTileCount);}
 
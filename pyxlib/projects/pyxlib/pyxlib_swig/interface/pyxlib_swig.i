@@ -997,6 +997,12 @@ namespace std
   %template(Vector_IFeature) vector< boost::intrusive_ptr<IFeature> >;
 }
 
+SWIG_STD_VECTOR_SPECIALIZE_MINIMUM(PYXCellHistogram_SPtr, boost::intrusive_ptr<PYXCellHistogram>)
+namespace std
+{
+  %template(Vector_CellHistogram) vector< boost::intrusive_ptr<PYXCellHistogram> >;
+}
+
 SWIG_STD_VECTOR_SPECIALIZE_MINIMUM(IUnknown_SPtr, boost::intrusive_ptr<PYXCOM_IUnknown>)
 namespace std
 {
@@ -1290,6 +1296,9 @@ public:
 %ignore writeHex;
 %include "pyxis/utility/string_utils.h"
 %include "pyxis/utility/tester.h"
+%ignore Trace::CallSite;
+%ignore Trace::isAllowed;
+%ignore Trace::post;
 %include "pyxis/utility/trace.h"
 %include "pyxis/utility/value.h"
 %include "pyxis/utility/value_math.h"
@@ -1589,7 +1598,99 @@ public:
 %include "pyxis/data/feature_collection_index.h"
 %include "pyxis/data/feature_group.h"
 %include "pyxis/data/coverage.h"
+// Bulk transfers of value tiles. The arrays are blittable, so the marshaller
+// pins them for the duration of the call and the C++ side copies straight into
+// the managed memory.
+%define PYX_CSHARP_ARRAY(CTYPE, CSTYPE, NAME)
+%typemap(ctype) CTYPE* NAME "CTYPE*"
+%typemap(imtype) CTYPE* NAME "[System.Runtime.InteropServices.In, System.Runtime.InteropServices.Out] CSTYPE[]"
+%typemap(cstype) CTYPE* NAME "CSTYPE[]"
+%typemap(csin) CTYPE* NAME "$csinput"
+%typemap(in) CTYPE* NAME %{ $1 = $input; %}
+%enddef
+
+PYX_CSHARP_ARRAY(double, double, pValues)
+PYX_CSHARP_ARRAY(double, double, pLatLons)
+PYX_CSHARP_ARRAY(unsigned char, byte, pData)
+PYX_CSHARP_ARRAY(unsigned char, byte, pHasValues)
+PYX_CSHARP_ARRAY(unsigned char, byte, pIndices)
+
+%csmethodmodifiers PYXValueTile::getChannelValues "private";
+%csmethodmodifiers PYXValueTile::getChannelData "private";
+%csmethodmodifiers PYXValueTile::getCellIndices "private";
+%csmethodmodifiers PYXValueTile::getCellLatLons "private";
+
+%typemap(cscode) PYXValueTile %{
+	/// <summary>
+	/// Get all the values of a channel, converted to double, in a single call.
+	/// </summary>
+	/// <param name="nChannelIndex">The field index.</param>
+	/// <param name="hasValues">Receives a flag per cell, true where the cell is not null.</param>
+	/// <returns>getDataChannelCount() values per cell, in offset order (0 for null cells).</returns>
+	public double[] GetChannelValues(int nChannelIndex, out bool[] hasValues)
+	{
+		int nCells = getNumberOfCells();
+		double[] values = new double[nCells * getDataChannelCount(nChannelIndex)];
+		byte[] flags = new byte[nCells];
+		getChannelValues(nChannelIndex, values, flags);
+		hasValues = ToBooleans(flags);
+		return values;
+	}
+
+	/// <summary>
+	/// Get the packed data of a numeric channel in a single call, without conversion.
+	/// </summary>
+	/// <param name="nChannelIndex">The field index.</param>
+	/// <param name="hasValues">Receives a flag per cell, true where the cell is not null.</param>
+	/// <returns>getDataChannelCount() values of the channel type per cell, in offset order.</returns>
+	public byte[] GetChannelData(int nChannelIndex, out bool[] hasValues)
+	{
+		byte[] data = new byte[getChannelDataBytes(nChannelIndex)];
+		byte[] flags = new byte[getNumberOfCells()];
+		getChannelData(nChannelIndex, data, flags);
+		hasValues = ToBooleans(flags);
+		return data;
+	}
+
+	/// <summary>
+	/// Get the indices of the cells in a single call, in offset order.
+	/// </summary>
+	/// <returns>A CompactIndex of knCellIndexBytes bytes per cell.</returns>
+	public byte[] GetCellIndices()
+	{
+		byte[] indices = new byte[getNumberOfCells() * knCellIndexBytes];
+		int nCells = getCellIndices(indices);
+		System.Array.Resize(ref indices, nCells * knCellIndexBytes);
+		return indices;
+	}
+
+	/// <summary>
+	/// Get the WGS84 coordinates of the cells in a single call, in offset order.
+	/// </summary>
+	/// <returns>The latitude and longitude in degrees of each cell.</returns>
+	public double[] GetCellLatLons()
+	{
+		double[] latLons = new double[getNumberOfCells() * 2];
+		int nCells = getCellLatLons(latLons);
+		System.Array.Resize(ref latLons, nCells * 2);
+		return latLons;
+	}
+
+	private static bool[] ToBooleans(byte[] flags)
+	{
+		bool[] booleans = new bool[flags.Length];
+		System.Buffer.BlockCopy(flags, 0, booleans, 0, flags.Length);
+		return booleans;
+	}
+%}
+
 %include "pyxis/data/value_tile.h"
+
+%clear double* pValues;
+%clear double* pLatLons;
+%clear unsigned char* pData;
+%clear unsigned char* pHasValues;
+%clear unsigned char* pIndices;
 %include "pyxis/data/tile_aggregator.h"
 %include "pyxis/data/pyx_feature.h"
 %include "pyxis/data/histogram.h"
@@ -835,6 +835,9 @@ namespace boost{
 %ignore writeHex;
 %include "pyxis/utility/string_utils.h"
 %include "pyxis/utility/tester.h"
+%ignore Trace::CallSite;
+%ignore Trace::isAllowed;
+%ignore Trace::post;
 %include "pyxis/utility/trace.h"
 %include "pyxis/utility/value.h"
 %include "pyxis/utility/value_math.h"
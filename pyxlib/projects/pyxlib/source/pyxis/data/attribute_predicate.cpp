@@ -0,0 +1,624 @@
+/******************************************************************************
+attribute_predicate.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/data/attribute_predicate.h"
+
+// pyxlib includes
+#include "pyxis/procs/default_feature.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+// standard includes
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+//! Tester class
+Tester<PYXAttributePredicate> gTester;
+
+namespace
+{
+
+//! Convert a string to a number like the XPath number() function (NaN if the string is not a number).
+double toNumber(const std::string & str)
+{
+	std::string::size_type nBegin = str.find_first_not_of(" \t\r\n");
+	std::string::size_type nEnd = str.find_last_not_of(" \t\r\n");
+	if (nBegin == std::string::npos)
+	{
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+
+	// XPath numbers are an optional minus sign and digits with an optional decimal point
+	std::string::size_type n = nBegin;
+	if (str[n] == '-')
+	{
+		++n;
+	}
+	int nDigits = 0;
+	int nPoints = 0;
+	for (; n <= nEnd; ++n)
+	{
+		if (isdigit(static_cast<unsigned char>(str[n])))
+		{
+			++nDigits;
+		}
+		else if (str[n] == '.' && nPoints == 0)
+		{
+			++nPoints;
+		}
+		else
+		{
+			return std::numeric_limits<double>::quiet_NaN();
+		}
+	}
+	if (nDigits == 0)
+	{
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	return strtod(str.c_str() + nBegin,0);
+}
+
+template <typename T>
+bool compare(PYXAttributePredicate::eOperator nOperator,const T & a,const T & b)
+{
+	switch (nOperator)
+	{
+	case PYXAttributePredicate::knEqual:
+		return a == b;
+	case PYXAttributePredicate::knNotEqual:
+		return a != b;
+	case PYXAttributePredicate::knLess:
+		return a < b;
+	case PYXAttributePredicate::knLessOrEqual:
+		return a <= b;
+	case PYXAttributePredicate::knGreater:
+		return a > b;
+	case PYXAttributePredicate::knGreaterOrEqual:
+		return a >= b;
+	default:
+		assert(false && "Unknown operator.");
+		return false;
+	}
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PYXAttributePredicate::Parser
+////////////////////////////////////////////////////////////////////////////////
+
+//! A recursive descent parser of the supported XPath subset.
+class PYXAttributePredicate::Parser
+{
+public:
+	explicit Parser(const std::string & strQuery) : m_str(strQuery), m_nPos(0)
+	{
+	}
+
+	PYXPointer<PYXAttributePredicate> parse()
+	{
+		PYXPointer<PYXAttributePredicate> spPredicate = parseOr();
+		skipSpaces();
+		if (!spPredicate || m_nPos != m_str.size())
+		{
+			return PYXPointer<PYXAttributePredicate>();
+		}
+		return spPredicate;
+	}
+
+private:
+
+	void skipSpaces()
+	{
+		while (m_nPos < m_str.size() && isspace(static_cast<unsigned char>(m_str[m_nPos])))
+		{
+			++m_nPos;
+		}
+	}
+
+	//! Consume a symbol.
+	bool accept(const char * szSymbol)
+	{
+		skipSpaces();
+		std::string::size_type nLength = strlen(szSymbol);
+		if (m_str.compare(m_nPos,nLength,szSymbol) != 0)
+		{
+			return false;
+		}
+		m_nPos += nLength;
+		return true;
+	}
+
+	//! Consume a keyword (a symbol that is not followed by a name character).
+	bool acceptKeyword(const char * szKeyword)
+	{
+		std::string::size_type nPos = m_nPos;
+		if (!accept(szKeyword))
+		{
+			return false;
+		}
+		if (m_nPos < m_str.size() && (isalnum(static_cast<unsigned char>(m_str[m_nPos])) || m_str[m_nPos] == '_' || m_str[m_nPos] == '-'))
+		{
+			m_nPos = nPos;
+			return false;
+		}
+		return true;
+	}
+
+	bool parseLiteral(std::string & strValue)
+	{
+		skipSpaces();
+		if (m_nPos >= m_str.size() || (m_str[m_nPos] != '\'' && m_str[m_nPos] != '"'))
+		{
+			return false;
+		}
+		std::string::size_type nEnd = m_str.find(m_str[m_nPos],m_nPos + 1);
+		if (nEnd == std::string::npos)
+		{
+			return false;
+		}
+		strValue = m_str.substr(m_nPos + 1,nEnd - m_nPos - 1);
+		m_nPos = nEnd + 1;
+		return true;
+	}
+
+	bool parseNumber(double & fValue)
+	{
+		skipSpaces();
+		std::string::size_type nEnd = m_nPos;
+		if (nEnd < m_str.size() && m_str[nEnd] == '-')
+		{
+			++nEnd;
+		}
+		while (nEnd < m_str.size() && (isdigit(static_cast<unsigned char>(m_str[nEnd])) || m_str[nEnd] == '.'))
+		{
+			++nEnd;
+		}
+		fValue = toNumber(m_str.substr(m_nPos,nEnd - m_nPos));
+		if (fValue != fValue)
+		{
+			return false;
+		}
+		m_nPos = nEnd;
+		return true;
+	}
+
+	bool parseOperator(eOperator & nOperator)
+	{
+		// the two character operators first
+		if (accept("!=")) { nOperator = knNotEqual; return true; }
+		if (accept("<=")) { nOperator = knLessOrEqual; return true; }
+		if (accept(">=")) { nOperator = knGreaterOrEqual; return true; }
+		if (accept("=")) { nOperator = knEqual; return true; }
+		if (accept("<")) { nOperator = knLess; return true; }
+		if (accept(">")) { nOperator = knGreater; return true; }
+		return false;
+	}
+
+	PYXPointer<PYXAttributePredicate> parseOr()
+	{
+		PYXPointer<PYXAttributePredicate> spFirst = parseAnd();
+		if (!spFirst || !acceptKeyword("or"))
+		{
+			return spFirst;
+		}
+
+		PYXPointer<PYXAttributePredicate> spOr = PYXNEW(PYXAttributePredicate,knOr);
+		spOr->m_children.push_back(spFirst);
+		do
+		{
+			PYXPointer<PYXAttributePredicate> spNext = parseAnd();
+			if (!spNext)
+			{
+				return PYXPointer<PYXAttributePredicate>();
+			}
+			spOr->m_children.push_back(spNext);
+		}
+		while (acceptKeyword("or"));
+		return spOr;
+	}
+
+	PYXPointer<PYXAttributePredicate> parseAnd()
+	{
+		PYXPointer<PYXAttributePredicate> spFirst = parseUnary();
+		if (!spFirst || !acceptKeyword("and"))
+		{
+			return spFirst;
+		}
+
+		PYXPointer<PYXAttributePredicate> spAnd = PYXNEW(PYXAttributePredicate,knAnd);
+		spAnd->m_children.push_back(spFirst);
+		do
+		{
+			PYXPointer<PYXAttributePredicate> spNext = parseUnary();
+			if (!spNext)
+			{
+				return PYXPointer<PYXAttributePredicate>();
+			}
+			spAnd->m_children.push_back(spNext);
+		}
+		while (acceptKeyword("and"));
+		return spAnd;
+	}
+
+	PYXPointer<PYXAttributePredicate> parseUnary()
+	{
+		if (acceptKeyword("not"))
+		{
+			if (!accept("("))
+			{
+				return PYXPointer<PYXAttributePredicate>();
+			}
+			PYXPointer<PYXAttributePredicate> spChild = parseOr();
+			if (!spChild || !accept(")"))
+			{
+				return PYXPointer<PYXAttributePredicate>();
+			}
+			PYXPointer<PYXAttributePredicate> spNot = PYXNEW(PYXAttributePredicate,knNot);
+			spNot->m_children.push_back(spChild);
+			return spNot;
+		}
+
+		if (accept("("))
+		{
+			PYXPointer<PYXAttributePredicate> spChild = parseOr();
+			if (!spChild || !accept(")"))
+			{
+				return PYXPointer<PYXAttributePredicate>();
+			}
+			return spChild;
+		}
+
+		return parseField();
+	}
+
+	//! Parse "//field[name='...' and value<op>literal]".
+	PYXPointer<PYXAttributePredicate> parseField()
+	{
+		std::string strName;
+		eOperator nOperator;
+		if (!accept("//field") || !accept("[") ||
+			!acceptKeyword("name") || !accept("=") || !parseLiteral(strName) ||
+			!acceptKeyword("and") ||
+			!acceptKeyword("value") || !parseOperator(nOperator))
+		{
+			return PYXPointer<PYXAttributePredicate>();
+		}
+
+		PYXPointer<PYXAttributePredicate> spCompare = PYXNEW(PYXAttributePredicate,knCompare);
+		spCompare->m_strFieldName = strName;
+		spCompare->m_nOperator = nOperator;
+
+		std::string strLiteral;
+		double fLiteral;
+		if (parseLiteral(strLiteral))
+		{
+			// = and != compare strings, the other operators convert the literal to a number
+			spCompare->m_bStringComparison = (nOperator == knEqual || nOperator == knNotEqual);
+			spCompare->m_literal = spCompare->m_bStringComparison ? PYXValue(strLiteral) : PYXValue(toNumber(strLiteral));
+		}
+		else if (parseNumber(fLiteral))
+		{
+			spCompare->m_bStringComparison = false;
+			spCompare->m_literal = PYXValue(fLiteral);
+		}
+		else
+		{
+			return PYXPointer<PYXAttributePredicate>();
+		}
+
+		if (!accept("]"))
+		{
+			return PYXPointer<PYXAttributePredicate>();
+		}
+		return spCompare;
+	}
+
+private:
+	const std::string & m_str;
+	std::string::size_type m_nPos;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// PYXAttributePredicate
+////////////////////////////////////////////////////////////////////////////////
+
+void PYXAttributePredicate::test()
+{
+	// parsing
+	TEST_ASSERT(parse("//field[name='Name' and value='Ottawa']"));
+	TEST_ASSERT(parse(" ( //field[ name = \"A\" and value >= -2.5 ] or not(//field[name='B' and value!='x']) ) and //field[name='C' and value<3]"));
+	TEST_ASSERT(!parse("//field[name='Name']"));
+	TEST_ASSERT(!parse("//field[name='Name' and value='Ottawa'"));
+	TEST_ASSERT(!parse("//field[name='Name' and contains(value,'Ott')]"));
+	TEST_ASSERT(!parse("//field[name='A' and value=1] and"));
+	TEST_ASSERT(!parse("count(//field) > 2"));
+	TEST_ASSERT(!parse(""));
+
+	PYXPointer<PYXAttributePredicate> spPredicate = parse(
+		"//field[name='Type' and value='city'] and (//field[name='Population' and value>=1000] or not(//field[name='Name' and value!='Ottawa']))");
+	TEST_ASSERT(spPredicate->getType() == knAnd);
+	TEST_ASSERT_EQUAL(static_cast<int>(spPredicate->getChildren().size()),2);
+	TEST_ASSERT(spPredicate->getChildren()[1]->getType() == knOr);
+	TEST_ASSERT_EQUAL(static_cast<int>(spPredicate->getFieldNames().size()),3);
+
+	// matching follows the XPath rules
+	boost::intrusive_ptr<DefaultFeature> spFeature(new DefaultFeature);
+	spFeature->addField("Name",PYXFieldDefinition::knContextNone,PYXValue::knString,1,PYXValue("Ottawa"));
+	spFeature->addField("Type",PYXFieldDefinition::knContextNone,PYXValue::knString,1,PYXValue("city"));
+	spFeature->addField("Population",PYXFieldDefinition::knContextNone,PYXValue::knInt32,1,PYXValue(900));
+	spFeature->addField("Code",PYXFieldDefinition::knContextNone,PYXValue::knString,1,PYXValue(" 12 "));
+	spFeature->addField("Empty",PYXFieldDefinition::knContextNone,PYXValue::knString,1,PYXValue());
+
+	TEST_ASSERT(spPredicate->match(*spFeature));
+	TEST_ASSERT(parse("//field[name='Population' and value='900']")->match(*spFeature));
+	TEST_ASSERT(parse("//field[name='Population' and value=900.0]")->match(*spFeature));
+	TEST_ASSERT(!parse("//field[name='Population' and value>900]")->match(*spFeature));
+	TEST_ASSERT(parse("//field[name='Code' and value>11.5]")->match(*spFeature));
+	TEST_ASSERT(!parse("//field[name='Code' and value='12']")->match(*spFeature));
+	TEST_ASSERT(!parse("//field[name='Name' and value>1]")->match(*spFeature));
+	TEST_ASSERT(parse("//field[name='Name' and value!=1]")->match(*spFeature));
+	TEST_ASSERT(!parse("//field[name='Empty' and value!='x']")->match(*spFeature));
+	TEST_ASSERT(!parse("//field[name='Missing' and value!='x']")->match(*spFeature));
+	TEST_ASSERT(parse("not(//field[name='Missing' and value='x'])")->match(*spFeature));
+
+	// batch evaluation gives the same answers as the record evaluation
+	std::vector<boost::intrusive_ptr<IFeature> > features;
+	for (int i = 0; i < 1000; ++i)
+	{
+		boost::intrusive_ptr<DefaultFeature> spNext(new DefaultFeature);
+		spNext->addField("Id",PYXFieldDefinition::knContextNone,PYXValue::knInt32,1,PYXValue(i));
+		spNext->addField("Type",PYXFieldDefinition::knContextNone,PYXValue::knString,1,
+			i % 5 == 0 ? PYXValue() : PYXValue(i % 3 == 0 ? "city" : "town"));
+		features.push_back(spNext);
+	}
+
+	const char * queries[] = {
+		"//field[name='Type' and value='city']",
+		"//field[name='Id' and value<100] and //field[name='Type' and value!='town']",
+		"//field[name='Id' and value>=990] or //field[name='Type' and value='city'] and //field[name='Id' and value<30]",
+		"not(//field[name='Type' and value='town'] or //field[name='Id' and value>500])",
+		"//field[name='Missing' and value='x'] or //field[name='Id' and value=7]"
+	};
+	for (unsigned int q = 0; q < sizeof(queries) / sizeof(queries[0]); ++q)
+	{
+		PYXPointer<PYXAttributePredicate> spQuery = parse(queries[q]);
+		TEST_ASSERT(spQuery);
+
+		ColumnBatch batch(*spQuery);
+		for (unsigned int i = 0; i < features.size(); ++i)
+		{
+			batch.addRecord(*features[i]);
+		}
+		std::vector<char> selection;
+		spQuery->match(batch,selection);
+
+		int nMatches = 0;
+		for (unsigned int i = 0; i < features.size(); ++i)
+		{
+			TEST_ASSERT_EQUAL(selection[i] != 0,spQuery->match(*features[i]));
+			nMatches += selection[i];
+		}
+		TEST_ASSERT(nMatches > 0);
+	}
+}
+
+PYXPointer<PYXAttributePredicate> PYXAttributePredicate::parse(const std::string & strQuery)
+{
+	PYXPointer<PYXAttributePredicate> spPredicate = Parser(strQuery).parse();
+	if (spPredicate)
+	{
+		spPredicate->collectFields(spPredicate->m_fieldNames);
+	}
+	return spPredicate;
+}
+
+PYXAttributePredicate::PYXAttributePredicate(eNodeType nType) :
+	m_nType(nType),
+	m_nOperator(knEqual),
+	m_bStringComparison(true),
+	m_nField(-1)
+{
+}
+
+void PYXAttributePredicate::collectFields(std::vector<std::string> & fieldNames)
+{
+	if (m_nType == knCompare)
+	{
+		m_nField = static_cast<int>(std::find(fieldNames.begin(),fieldNames.end(),m_strFieldName) - fieldNames.begin());
+		if (m_nField == static_cast<int>(fieldNames.size()))
+		{
+			fieldNames.push_back(m_strFieldName);
+		}
+		return;
+	}
+
+	for (unsigned int i = 0; i < m_children.size(); ++i)
+	{
+		m_children[i]->collectFields(fieldNames);
+	}
+}
+
+bool PYXAttributePredicate::matchValue(const PYXValue & value) const
+{
+	// a field matches if any of its values matches (a null field has no value)
+	int nCount = value.getArraySize();
+	if (m_bStringComparison)
+	{
+		const std::string & strLiteral = m_literal.getString();
+		for (int n = 0; n < nCount; ++n)
+		{
+			if (compare(m_nOperator,value.getString(n),strLiteral))
+			{
+				return true;
+			}
+		}
+	}
+	else
+	{
+		double fLiteral = m_literal.getDouble();
+		bool bNumeric = PYXValue::isNumeric(value.getArrayType());
+		for (int n = 0; n < nCount; ++n)
+		{
+			double fValue = bNumeric ? value.getDouble(n) : toNumber(value.getString(n));
+			if (compare(m_nOperator,fValue,fLiteral))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool PYXAttributePredicate::match(const IRecord & record) const
+{
+	switch (m_nType)
+	{
+	case knAnd:
+		for (unsigned int i = 0; i < m_children.size(); ++i)
+		{
+			if (!m_children[i]->match(record))
+			{
+				return false;
+			}
+		}
+		return true;
+
+	case knOr:
+		for (unsigned int i = 0; i < m_children.size(); ++i)
+		{
+			if (m_children[i]->match(record))
+			{
+				return true;
+			}
+		}
+		return false;
+
+	case knNot:
+		return !m_children[0]->match(record);
+
+	default:
+		{
+			int nFieldIndex = record.getDefinition()->getFieldIndex(m_strFieldName);
+			return nFieldIndex >= 0 && matchValue(record.getFieldValue(nFieldIndex));
+		}
+	}
+}
+
+void PYXAttributePredicate::match(const ColumnBatch & batch,std::vector<char> & selection) const
+{
+	std::vector<char> active(batch.getRecordCount(),1);
+	match(batch,active,selection);
+}
+
+void PYXAttributePredicate::match(const ColumnBatch & batch,const std::vector<char> & active,std::vector<char> & result) const
+{
+	int nRecords = batch.getRecordCount();
+	result.assign(nRecords,0);
+
+	switch (m_nType)
+	{
+	case knAnd:
+		{
+			// every operand is only evaluated for the records that matched the previous operands
+			std::vector<char> remaining(active);
+			for (unsigned int i = 0; i < m_children.size(); ++i)
+			{
+				m_children[i]->match(batch,remaining,result);
+				remaining.swap(result);
+			}
+			result.swap(remaining);
+		}
+		break;
+
+	case knOr:
+		{
+			// every operand is only evaluated for the records that did not match the previous operands
+			std::vector<char> remaining(active);
+			std::vector<char> childResult;
+			for (unsigned int i = 0; i < m_children.size(); ++i)
+			{
+				m_children[i]->match(batch,remaining,childResult);
+				for (int n = 0; n < nRecords; ++n)
+				{
+					result[n] |= childResult[n];
+					remaining[n] &= !childResult[n];
+				}
+			}
+		}
+		break;
+
+	case knNot:
+		{
+			std::vector<char> childResult;
+			m_children[0]->match(batch,active,childResult);
+			for (int n = 0; n < nRecords; ++n)
+			{
+				result[n] = active[n] && !childResult[n];
+			}
+		}
+		break;
+
+	default:
+		for (int n = 0; n < nRecords; ++n)
+		{
+			if (active[n])
+			{
+				result[n] = matchValue(batch.getValue(m_nField,n));
+			}
+		}
+		break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PYXAttributePredicate::ColumnBatch
+////////////////////////////////////////////////////////////////////////////////
+
+PYXAttributePredicate::ColumnBatch::ColumnBatch(const PYXAttributePredicate & predicate) :
+	m_fieldNames(predicate.getFieldNames()),
+	m_fieldIndices(predicate.getFieldNames().size(),-1),
+	m_columns(predicate.getFieldNames().size()),
+	m_nRecordCount(0)
+{
+}
+
+void PYXAttributePredicate::ColumnBatch::clear()
+{
+	for (unsigned int i = 0; i < m_columns.size(); ++i)
+	{
+		m_columns[i].clear();
+	}
+	m_nRecordCount = 0;
+}
+
+void PYXAttributePredicate::ColumnBatch::addRecord(const IRecord & record)
+{
+	PYXPointer<const PYXTableDefinition> spDefinition = record.getDefinition();
+	if (spDefinition != m_spDefinition)
+	{
+		m_spDefinition = spDefinition;
+		for (unsigned int i = 0; i < m_fieldNames.size(); ++i)
+		{
+			m_fieldIndices[i] = m_spDefinition->getFieldIndex(m_fieldNames[i]);
+		}
+	}
+
+	for (unsigned int i = 0; i < m_fieldNames.size(); ++i)
+	{
+		// a missing field has no value, like a null value
+		m_columns[i].push_back(m_fieldIndices[i] >= 0 ? record.getFieldValue(m_fieldIndices[i]) : PYXValue());
+	}
+	++m_nRecordCount;
+}
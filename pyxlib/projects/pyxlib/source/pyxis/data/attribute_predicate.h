@@ -0,0 +1,214 @@
+#ifndef PYXIS__DATA__ATTRIBUTE_PREDICATE_H
+#define PYXIS__DATA__ATTRIBUTE_PREDICATE_H
+/******************************************************************************
+attribute_predicate.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "pyxis/data/record.h"
+#include "pyxis/utility/object.h"
+#include "pyxis/utility/value.h"
+
+// standard includes
+#include <string>
+#include <vector>
+
+/*!
+PYXAttributePredicate is a condition on the field values of a record, parsed
+from the XPath queries that are run over the fields of a record as formatted
+by RecordTools::getFieldsAsXml().
+
+Only a subset of XPath is understood: comparisons of a named field with a
+literal, combined with and, or, not() and parentheses:
+
+\verbatim
+//field[name='Name' and value='Ottawa']
+//field[name='Population' and value>=100000] and not(//field[name='Type' and value!='city'])
+\endverbatim
+
+parse() returns null for any other query, which should then be evaluated by an
+XPath engine. The predicate follows the XPath rules: a field matches if any of
+its values satisfies the comparison (a null field has no value and never
+matches), = and != with a string literal compare strings, and the other
+comparisons compare numbers.
+
+Because the predicate is a tree of simple comparisons, it can be translated for
+a data source that filters its features natively (see IFeatureCollectionFilter),
+and it can be evaluated over a batch of records, one field column at a time,
+without serializing every record to XML.
+*/
+//! A condition on the field values of a record.
+class PYXLIB_DECL PYXAttributePredicate : public PYXObject
+{
+public:
+
+	//! The type of a node of the predicate tree.
+	enum eNodeType
+	{
+		knAnd,
+		knOr,
+		knNot,
+		knCompare
+	};
+
+	//! The comparison operators.
+	enum eOperator
+	{
+		knEqual,
+		knNotEqual,
+		knLess,
+		knLessOrEqual,
+		knGreater,
+		knGreaterOrEqual
+	};
+
+	/*!
+	ColumnBatch holds the values of the fields used by a predicate for a batch
+	of records, one column per field.
+
+	The field indices are resolved once per table definition, so the records
+	that share their definition (the features of a data source) are gathered
+	without looking up the fields by name.
+	*/
+	class PYXLIB_DECL ColumnBatch
+	{
+	public:
+
+		//! Create a batch for the fields used by a predicate.
+		explicit ColumnBatch(const PYXAttributePredicate & predicate);
+
+		//! Remove all the records.
+		void clear();
+
+		//! Add the values of a record.
+		void addRecord(const IRecord & record);
+
+		//! The number of records in the batch.
+		int getRecordCount() const
+		{
+			return m_nRecordCount;
+		}
+
+		//! The value of a field (by its position in PYXAttributePredicate::getFieldNames()) for a record of the batch.
+		const PYXValue & getValue(int nField,int nRecord) const
+		{
+			return m_columns[nField][nRecord];
+		}
+
+	private:
+
+		//! The names of the fields.
+		std::vector<std::string> m_fieldNames;
+
+		//! The definition the field indices were resolved for.
+		PYXPointer<const PYXTableDefinition> m_spDefinition;
+
+		//! The index of every field in m_spDefinition (-1 if the field is missing).
+		std::vector<int> m_fieldIndices;
+
+		//! The values, by field then record.
+		std::vector<std::vector<PYXValue> > m_columns;
+
+		int m_nRecordCount;
+	};
+
+public:
+
+	//! Test method
+	static void test();
+
+	//! Parse an XPath query, return null if the query is not supported.
+	static PYXPointer<PYXAttributePredicate> parse(const std::string & strQuery);
+
+	//! Constructor (use parse).
+	explicit PYXAttributePredicate(eNodeType nType);
+
+	//! Destructor
+	virtual ~PYXAttributePredicate() {}
+
+public:
+
+	//! The type of the node.
+	eNodeType getType() const
+	{
+		return m_nType;
+	}
+
+	//! The operands of an and, or and not node.
+	const std::vector<PYXPointer<PYXAttributePredicate> > & getChildren() const
+	{
+		return m_children;
+	}
+
+	//! The field of a comparison.
+	const std::string & getFieldName() const
+	{
+		return m_strFieldName;
+	}
+
+	//! The operator of a comparison.
+	eOperator getOperator() const
+	{
+		return m_nOperator;
+	}
+
+	//! The literal of a comparison (a string or a double).
+	const PYXValue & getLiteral() const
+	{
+		return m_literal;
+	}
+
+	//! True if the comparison compares strings, false if it compares numbers.
+	bool isStringComparison() const
+	{
+		return m_bStringComparison;
+	}
+
+	//! The distinct fields used by the predicate (only valid for the root of the tree).
+	const std::vector<std::string> & getFieldNames() const
+	{
+		return m_fieldNames;
+	}
+
+	//! Return true if a record satisfies the predicate.
+	bool match(const IRecord & record) const;
+
+	//! Evaluate the predicate for every record of a batch (selection[i] is set to 1 for the matching records).
+	void match(const ColumnBatch & batch,std::vector<char> & selection) const;
+
+private:
+
+	//! Return true if a field value satisfies the comparison.
+	bool matchValue(const PYXValue & value) const;
+
+	//! Evaluate the predicate for the records of a batch that are active.
+	void match(const ColumnBatch & batch,const std::vector<char> & active,std::vector<char> & result) const;
+
+	//! Assign the position in the field names of the root to every comparison.
+	void collectFields(std::vector<std::string> & fieldNames);
+
+	class Parser;
+
+private:
+
+	eNodeType m_nType;
+
+	std::vector<PYXPointer<PYXAttributePredicate> > m_children;
+
+	std::string m_strFieldName;
+	eOperator m_nOperator;
+	PYXValue m_literal;
+	bool m_bStringComparison;
+
+	//! The position of the field of a comparison in the field names of the root.
+	int m_nField;
+
+	std::vector<std::string> m_fieldNames;
+};
+
+#endif // guard
@@ -0,0 +1,16 @@
+/******************************************************************************
+feature_collection_filter.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h" 
+#include "pyxis/data/feature_collection_filter.h"
+
+
+// {E8A48026-EA7E-401A-901E-BF64EDFBE1D3}
+PYXCOM_DEFINE_IID(IFeatureCollectionFilter, 
+0xe8a48026, 0xea7e, 0x401a, 0x90, 0x1e, 0xbf, 0x64, 0xed, 0xfb, 0xe1, 0xd3);
@@ -0,0 +1,40 @@
+#ifndef PYXIS__DATA__FEATURE_COLLECTION_FILTER_H
+#define PYXIS__DATA__FEATURE_COLLECTION_FILTER_H
+/******************************************************************************
+feature_collection_filter.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+
+#include "pyxis/data/attribute_predicate.h"
+#include "pyxis/data/feature_collection.h"
+
+/*!
+A feature collection that can evaluate an attribute predicate natively (for
+example with the attribute filter of an OGR layer), so the features that don't
+match are never created.
+
+The iterators may return features that don't match the predicate (a data source
+may only be able to evaluate a part of it), the caller is expected to check the
+returned features with PYXAttributePredicate::match().
+*/
+//! A feature collection that filters its features natively.
+struct PYXLIB_DECL IFeatureCollectionFilter : public PYXCOM_IUnknown
+{
+	PYXCOM_DECLARE_INTERFACE();
+
+public:
+
+	//! Return the features that may match the predicate, or null if the predicate can't be evaluated.
+	virtual PYXPointer<FeatureIterator> STDMETHODCALLTYPE getIterator(const PYXAttributePredicate & predicate) const = 0;
+
+	//! Return the features that intersect the geometry and may match the predicate, or null if the predicate can't be evaluated.
+	virtual PYXPointer<FeatureIterator> STDMETHODCALLTYPE getIterator(const PYXGeometry & geometry,const PYXAttributePredicate & predicate) const = 0;
+};
+
+#endif // guard
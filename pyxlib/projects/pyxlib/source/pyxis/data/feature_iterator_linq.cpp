@@ -431,4 +431,29 @@ PYXFeatureIteratorLinq PYXFeatureIteratorLinq::expandGroupToGeometry( PYXPointer
 PYXFeatureIteratorLinq PYXFeatureIteratorLinq::orderForTrip(PYXCoord3DDouble startLocation) const
 {
 	return PYXFeatureIteratorLinq(PYXSmoothTripFeatureIterator::create(m_iterator,startLocation));
-}
\ No newline at end of file
+}
+
+PYXFeatureIteratorLinq PYXFeatureIteratorLinq::select(const PYXFeaturePipelineStage::Transform & transform, const PYXFeaturePipelineStage::Options & options) const
+{
+	return PYXFeatureIteratorLinq(PYXFeaturePipelineStage::create(m_iterator,transform,options));
+}
+
+boost::intrusive_ptr<IFeature> filterTransform(const boost::intrusive_ptr<IFeature> & feature,const boost::function< bool (PYXPointer<IFeature>) > & filterFunction)
+{
+	return filterFunction(feature) ? feature : boost::intrusive_ptr<IFeature>();
+}
+
+PYXFeatureIteratorLinq PYXFeatureIteratorLinq::filter(boost::function< bool (PYXPointer<IFeature>) > filterFunction, const PYXFeaturePipelineStage::Options & options) const
+{
+	return select(boost::bind(filterTransform,_1,filterFunction),options);
+}
+
+boost::intrusive_ptr<IFeature> identityTransform(const boost::intrusive_ptr<IFeature> & feature)
+{
+	return feature;
+}
+
+PYXFeatureIteratorLinq PYXFeatureIteratorLinq::buffer(int nQueueSize, const PYXTaskCancelationToken & cancelToken) const
+{
+	return select(identityTransform,PYXFeaturePipelineStage::Options(1,nQueueSize,true,cancelToken));
+}
@@ -15,6 +15,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/object.h"
 #include "pyxis/utility/coord_3d.h"
 #include "pyxis/data/feature_group.h"
+#include "pyxis/data/feature_pipeline.h"
 
 #include "boost/function.hpp"
 //! Abstract base for classes that iterate over PYXIS features.
@@ -42,6 +43,13 @@ public:
 	static PYXFeatureIteratorLinq expandGroupToGeometry(PYXPointer<IFeature> feature, const PYXPointer<PYXGeometry> & geometry);
 	PYXFeatureIteratorLinq orderForTrip(PYXCoord3DDouble startLocation) const;
 
+	//! Run a per-feature transform on worker threads behind a bounded queue (see PYXFeaturePipelineStage).
+	PYXFeatureIteratorLinq select(const PYXFeaturePipelineStage::Transform & transform, const PYXFeaturePipelineStage::Options & options) const;
+	//! Run a filter on worker threads behind a bounded queue (see PYXFeaturePipelineStage).
+	PYXFeatureIteratorLinq filter(boost::function< bool (PYXPointer<IFeature>) > filterFunction, const PYXFeaturePipelineStage::Options & options) const;
+	//! Read the features ahead of the consumer on a worker thread.
+	PYXFeatureIteratorLinq buffer(int nQueueSize, const PYXTaskCancelationToken & cancelToken = PYXTaskCancelationToken()) const;
+
 public:
 	operator const PYXPointer<FeatureIterator> & () const
 	{
@@ -0,0 +1,503 @@
+/******************************************************************************
+feature_pipeline.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/data/feature_pipeline.h"
+
+// pyxlib includes
+#include "pyxis/data/feature_iterator_linq.h"
+#include "pyxis/data/pyx_feature.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+// boost includes
+#include <boost/detail/atomic_count.hpp>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////////////////
+// PYXFeaturePipelineStage test
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+class FeaturePipelineTester
+{
+public:
+	typedef std::vector<boost::intrusive_ptr<IFeature> > FeatureVector;
+
+	//! Features with the IDs 0 to nCount-1.
+	static FeatureVector createFeatures(int nCount)
+	{
+		FeatureVector features;
+		for (int i = 0; i < nCount; ++i)
+		{
+			boost::intrusive_ptr<PYXFeature> feature(new PYXFeature());
+			feature->setID(StringUtils::toString(i));
+			features.push_back(feature);
+		}
+		return features;
+	}
+
+	static PYXPointer<FeatureIterator> createIterator(const FeatureVector & features)
+	{
+		return createDefaultFeatureIterator(features.begin(),features.end());
+	}
+
+	static std::vector<int> readIds(const PYXPointer<FeatureIterator> & iterator)
+	{
+		std::vector<int> ids;
+		for (; !iterator->end(); iterator->next())
+		{
+			ids.push_back(StringUtils::fromString<int>(iterator->getFeature()->getID()));
+		}
+		return ids;
+	}
+
+	//! Drop the features with an ID divisible by 3.
+	static boost::intrusive_ptr<IFeature> dropThirds(const boost::intrusive_ptr<IFeature> & feature)
+	{
+		return StringUtils::fromString<int>(feature->getID()) % 3 == 0 ? boost::intrusive_ptr<IFeature>() : feature;
+	}
+
+	static bool keepEven(PYXPointer<IFeature> feature)
+	{
+		return StringUtils::fromString<int>(feature->getID()) % 2 == 0;
+	}
+
+	//! Some CPU work per feature, the feature is kept.
+	static boost::intrusive_ptr<IFeature> work(const boost::intrusive_ptr<IFeature> & feature)
+	{
+		double sum = 0;
+		for (int i = 1; i < 20000; ++i)
+		{
+			sum += std::sqrt(static_cast<double>(i));
+		}
+		return sum > 0 ? feature : boost::intrusive_ptr<IFeature>();
+	}
+
+	static bool workFilter(PYXPointer<IFeature> feature)
+	{
+		return work(feature) != 0;
+	}
+
+	static boost::intrusive_ptr<IFeature> countCalls(const boost::intrusive_ptr<IFeature> & feature,boost::detail::atomic_count * pCount)
+	{
+		++*pCount;
+		return feature;
+	}
+
+	static boost::intrusive_ptr<IFeature> throwAt(const boost::intrusive_ptr<IFeature> & feature,int nId)
+	{
+		if (StringUtils::fromString<int>(feature->getID()) == nId)
+		{
+			PYXTHROW(PYXException,"transform failed");
+		}
+		return feature;
+	}
+
+	static void testDelivery()
+	{
+		FeatureVector features = createFeatures(5000);
+
+		std::vector<int> expected;
+		for (int i = 0; i < 5000; ++i)
+		{
+			if (i % 3 != 0)
+			{
+				expected.push_back(i);
+			}
+		}
+
+		// ordered delivery keeps the order of the input
+		std::vector<int> ordered = readIds(PYXFeaturePipelineStage::create(
+			createIterator(features),dropThirds,PYXFeaturePipelineStage::Options(4,16,true)));
+		TEST_ASSERT(ordered == expected);
+
+		// unordered delivery gets the same features
+		std::vector<int> unordered = readIds(PYXFeaturePipelineStage::create(
+			createIterator(features),dropThirds,PYXFeaturePipelineStage::Options(4,16,false)));
+		std::sort(unordered.begin(),unordered.end());
+		TEST_ASSERT(unordered == expected);
+
+		// connected stages
+		std::vector<int> chained = readIds(
+			PYXFeatureIteratorLinq(createIterator(features))
+				.select(dropThirds,PYXFeaturePipelineStage::Options(3,8,true))
+				.filter(keepEven,PYXFeaturePipelineStage::Options(2,8,true)));
+		std::vector<int> expectedEven;
+		for (auto id : expected)
+		{
+			if (id % 2 == 0)
+			{
+				expectedEven.push_back(id);
+			}
+		}
+		TEST_ASSERT(chained == expectedEven);
+
+		// empty input
+		FeatureVector noFeatures;
+		TEST_ASSERT(readIds(PYXFeaturePipelineStage::create(createIterator(noFeatures),dropThirds)).empty());
+
+		// every feature dropped
+		FeatureVector thirds;
+		thirds.push_back(features[0]);
+		thirds.push_back(features[3]);
+		TEST_ASSERT(readIds(PYXFeaturePipelineStage::create(createIterator(thirds),dropThirds)).empty());
+	}
+
+	static void testBackpressure()
+	{
+		FeatureVector features = createFeatures(1000);
+		boost::detail::atomic_count nCalls(0);
+
+		PYXPointer<FeatureIterator> stage = PYXFeaturePipelineStage::create(
+			createIterator(features),
+			boost::bind(countCalls,_1,&nCalls),
+			PYXFeaturePipelineStage::Options(4,8,false));
+
+		// the consumer holds one feature, so at most the queue size plus one were read
+		boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+		TEST_ASSERT(nCalls <= 9);
+
+		TEST_ASSERT_EQUAL(static_cast<int>(readIds(stage).size()),1000);
+		TEST_ASSERT_EQUAL(static_cast<int>(nCalls),1000);
+	}
+
+	static void testCancelation()
+	{
+		FeatureVector features = createFeatures(100000);
+		PYXPointer<PYXTaskCancelationSource> cancelSource = PYXTaskCancelationSource::create();
+
+		PYXPointer<FeatureIterator> stage = PYXFeaturePipelineStage::create(
+			createIterator(features),
+			work,
+			PYXFeaturePipelineStage::Options(2,16,true,PYXTaskCancelationToken(cancelSource)));
+
+		for (int i = 0; i < 10; ++i)
+		{
+			stage->next();
+		}
+		cancelSource->setCanceled();
+
+		bool bCanceled = false;
+		try
+		{
+			while (!stage->end())
+			{
+				stage->next();
+			}
+		}
+		catch (PYXTaskCanceledException &)
+		{
+			bCanceled = true;
+		}
+		TEST_ASSERT(bCanceled);
+
+		// an error of the transform is thrown to the consumer
+		bool bFailed = false;
+		try
+		{
+			readIds(PYXFeaturePipelineStage::create(createIterator(features),boost::bind(throwAt,_1,500),PYXFeaturePipelineStage::Options(2,16,true)));
+		}
+		catch (PYXException &)
+		{
+			bFailed = true;
+		}
+		TEST_ASSERT(bFailed);
+	}
+
+	static void benchmark()
+	{
+		FeatureVector features = createFeatures(4000);
+		PYXHighQualityTimer timer;
+
+		timer.start();
+		int nSequential = static_cast<int>(readIds(PYXFeatureIteratorLinq(createIterator(features)).filter(workFilter)).size());
+		timer.stop();
+		double fSequentialTime = timer.getTime();
+
+		timer.start();
+		int nPipelined = static_cast<int>(readIds(PYXFeatureIteratorLinq(createIterator(features)).filter(workFilter,PYXFeaturePipelineStage::Options())).size());
+		timer.stop();
+		double fPipelinedTime = timer.getTime();
+
+		TRACE_INFO("PYXFeaturePipelineStage: " << nSequential << " of " << features.size() << " features filtered in " << fSequentialTime << "[sec] (sequential), " <<
+			nPipelined << " in " << fPipelinedTime << "[sec] (" << boost::thread::hardware_concurrency() << " workers)");
+	}
+
+	static void test()
+	{
+		testDelivery();
+		testBackpressure();
+		testCancelation();
+	}
+};
+
+//! Tester class
+Tester<FeaturePipelineTester> gFeaturePipelineTester;
+
+}
+
+void benchmarkFeaturePipeline()
+{
+	FeaturePipelineTester::benchmark();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PYXFeaturePipelineStage
+////////////////////////////////////////////////////////////////////////////////
+
+PYXFeaturePipelineStage::PYXFeaturePipelineStage(const PYXPointer<FeatureIterator> & input,const Transform & transform,const Options & options) :
+	m_input(input),
+	m_transform(transform),
+	m_options(options),
+	m_bInputStarted(false),
+	m_bInputEnd(false),
+	m_nNextSequence(0),
+	m_nReserved(0),
+	m_nDelivered(0),
+	m_nCount(0),
+	m_bCountKnown(false),
+	m_bStopping(false),
+	m_bCanceled(false)
+{
+	if (m_options.nWorkers <= 0)
+	{
+		m_options.nWorkers = std::max(1,static_cast<int>(boost::thread::hardware_concurrency()));
+	}
+	m_options.nQueueSize = std::max(1,m_options.nQueueSize);
+
+	for (int i = 0; i < m_options.nWorkers; ++i)
+	{
+		m_workers.addSlowTask(boost::bind(&PYXFeaturePipelineStage::work,this));
+	}
+
+	try
+	{
+		advance();
+	}
+	catch (...)
+	{
+		stop();
+		throw;
+	}
+}
+
+PYXFeaturePipelineStage::~PYXFeaturePipelineStage()
+{
+	stop();
+}
+
+bool PYXFeaturePipelineStage::end() const
+{
+	return !m_feature;
+}
+
+void PYXFeaturePipelineStage::next()
+{
+	if (m_feature)
+	{
+		advance();
+	}
+}
+
+boost::intrusive_ptr<IFeature> PYXFeaturePipelineStage::getFeature() const
+{
+	return m_feature;
+}
+
+void PYXFeaturePipelineStage::advance()
+{
+	boost::intrusive_ptr<IFeature> feature;
+	while (popResult(feature))
+	{
+		if (feature)
+		{
+			m_feature = feature;
+			return;
+		}
+	}
+	m_feature.reset();
+}
+
+/*!
+Wait for the next result and remove it from the queue.
+
+\param feature	Set to the result, null if the feature was dropped.
+
+\return false if all the results were delivered.
+\throws PYXTaskCanceledException if the stage was canceled, or the error of a worker.
+*/
+bool PYXFeaturePipelineStage::popResult(boost::intrusive_ptr<IFeature> & feature)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	for (;;)
+	{
+		if (m_bCanceled || m_options.cancelToken.wasCanceled())
+		{
+			PYXTHROW(PYXTaskCanceledException,"Feature pipeline stage was canceled");
+		}
+		if (!m_strError.empty())
+		{
+			PYXTHROW(PYXException,"Feature pipeline stage failed: " << m_strError);
+		}
+
+		if (m_options.bOrdered)
+		{
+			auto it = m_orderedResults.find(m_nDelivered);
+			if (it != m_orderedResults.end())
+			{
+				feature = it->second;
+				m_orderedResults.erase(it);
+				break;
+			}
+		}
+		else if (!m_unorderedResults.empty())
+		{
+			feature = m_unorderedResults.front();
+			m_unorderedResults.pop_front();
+			break;
+		}
+
+		if (m_bCountKnown && m_nDelivered == m_nCount)
+		{
+			return false;
+		}
+
+		// the token is checked again if no worker wakes us up
+		m_hasResults.timed_wait(lock,boost::posix_time::milliseconds(100));
+	}
+
+	++m_nDelivered;
+	m_hasRoom.notify_one();
+	return true;
+}
+
+void PYXFeaturePipelineStage::stop()
+{
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_hasRoom.notify_all();
+	m_workers.joinAll(false);
+}
+
+void PYXFeaturePipelineStage::work()
+{
+	try
+	{
+		for (;;)
+		{
+			// wait for room in the queue
+			{
+				boost::mutex::scoped_lock lock(m_mutex);
+				while (!m_bStopping && !m_bCountKnown && m_nReserved - m_nDelivered >= m_options.nQueueSize)
+				{
+					m_hasRoom.wait(lock);
+				}
+				if (m_bStopping || m_bCountKnown)
+				{
+					return;
+				}
+				if (m_options.cancelToken.wasCanceled())
+				{
+					m_bCanceled = true;
+					m_hasResults.notify_all();
+					return;
+				}
+				++m_nReserved;
+			}
+
+			// read the next feature
+			boost::intrusive_ptr<IFeature> feature;
+			long nSequence = 0;
+			{
+				boost::mutex::scoped_lock lock(m_inputMutex);
+				if (!m_bInputEnd)
+				{
+					if (m_bInputStarted)
+					{
+						m_input->next();
+					}
+					m_bInputStarted = true;
+					m_bInputEnd = m_input->end();
+				}
+				if (!m_bInputEnd)
+				{
+					feature = m_input->getFeature();
+					nSequence = m_nNextSequence++;
+				}
+				else
+				{
+					boost::mutex::scoped_lock resultLock(m_mutex);
+					m_nCount = m_nNextSequence;
+					m_bCountKnown = true;
+					m_hasResults.notify_all();
+					m_hasRoom.notify_all();
+					return;
+				}
+			}
+
+			boost::intrusive_ptr<IFeature> result = m_transform(feature);
+
+			{
+				boost::mutex::scoped_lock lock(m_mutex);
+				if (m_options.bOrdered)
+				{
+					m_orderedResults[nSequence] = result;
+				}
+				else
+				{
+					m_unorderedResults.push_back(result);
+				}
+				m_hasResults.notify_all();
+			}
+		}
+	}
+	catch (PYXTaskCanceledException & e)
+	{
+		fail(e.getFullErrorString(),true);
+	}
+	catch (PYXException & e)
+	{
+		fail(e.getFullErrorString(),false);
+	}
+	catch (std::exception & e)
+	{
+		fail(e.what(),false);
+	}
+	catch (...)
+	{
+		fail("unknown error",false);
+	}
+}
+
+void PYXFeaturePipelineStage::fail(const std::string & strError,bool bCanceled)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	if (bCanceled)
+	{
+		m_bCanceled = true;
+	}
+	else if (m_strError.empty())
+	{
+		m_strError = strError.empty() ? "unknown error" : strError;
+	}
+	m_bStopping = true;
+	m_hasResults.notify_all();
+	m_hasRoom.notify_all();
+}
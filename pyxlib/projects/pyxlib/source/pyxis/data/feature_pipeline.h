@@ -0,0 +1,165 @@
+#ifndef PYXIS__DATA__FEATURE_PIPELINE_H
+#define PYXIS__DATA__FEATURE_PIPELINE_H
+/******************************************************************************
+feature_pipeline.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "pyxis/data/feature_collection.h"
+#include "pyxis/utility/object.h"
+#include "pyxis/utility/thread_pool.h"
+
+// boost includes
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+// standard includes
+#include <deque>
+#include <map>
+#include <string>
+
+/*!
+PYXFeaturePipelineStage runs a per-feature transform over a feature iterator on
+worker threads, and delivers the results through a bounded queue.
+
+The workers read the input one feature at a time (feature iterators are not
+thread safe) and run the transform concurrently. At most Options::nQueueSize
+features are read ahead of the consumer: when the queue is full the workers
+wait, so a slow consumer holds back the stage and, through it, the stages
+before it. Passing a stage as the input of another stage connects them by
+their queues, each stage running on its own workers.
+
+The transform is called concurrently, so it must not depend on the order of
+the features. It returns null to drop a feature. The results are delivered in
+the order of the input (Options::bOrdered) or as soon as they are ready.
+
+When the cancelation token is canceled the workers stop, and next() throws a
+PYXTaskCanceledException. An exception thrown by the transform or by the input
+is thrown again by next().
+*/
+//! Runs a per-feature transform over a feature iterator on worker threads.
+class PYXLIB_DECL PYXFeaturePipelineStage : public FeatureIterator
+{
+public:
+
+	//! The transform of a feature, returns null to drop the feature.
+	typedef boost::function<boost::intrusive_ptr<IFeature> (const boost::intrusive_ptr<IFeature> &)> Transform;
+
+	//! How a stage is run.
+	class Options
+	{
+	public:
+		//! The number of worker threads (0 for one per core).
+		int nWorkers;
+
+		//! The maximum number of features read ahead of the consumer.
+		int nQueueSize;
+
+		//! Deliver the features in the order of the input.
+		bool bOrdered;
+
+		//! Stops the stage when canceled.
+		PYXTaskCancelationToken cancelToken;
+
+		Options(int nWorkers = 0,int nQueueSize = 64,bool bOrdered = true,const PYXTaskCancelationToken & cancelToken = PYXTaskCancelationToken()) :
+			nWorkers(nWorkers),
+			nQueueSize(nQueueSize),
+			bOrdered(bOrdered),
+			cancelToken(cancelToken)
+		{
+		}
+	};
+
+public:
+
+	//! Test method
+	static void test();
+
+	static PYXPointer<PYXFeaturePipelineStage> create(const PYXPointer<FeatureIterator> & input,const Transform & transform,const Options & options = Options())
+	{
+		return PYXNEW(PYXFeaturePipelineStage,input,transform,options);
+	}
+
+	PYXFeaturePipelineStage(const PYXPointer<FeatureIterator> & input,const Transform & transform,const Options & options);
+
+	//! Stops the workers.
+	virtual ~PYXFeaturePipelineStage();
+
+public:
+
+	virtual bool end() const;
+
+	virtual void next();
+
+	virtual boost::intrusive_ptr<IFeature> getFeature() const;
+
+private:
+
+	//! Wait for the next feature that was not dropped.
+	void advance();
+
+	//! Wait for a result, return false at the end of the input.
+	bool popResult(boost::intrusive_ptr<IFeature> & feature);
+
+	//! Stop the workers and wait for them to exit.
+	void stop();
+
+	//! The loop of a worker thread.
+	void work();
+
+	//! Record an error of a worker and stop the stage.
+	void fail(const std::string & strError,bool bCanceled);
+
+private:
+
+	PYXPointer<FeatureIterator> m_input;
+	Transform m_transform;
+	Options m_options;
+
+	//! Protects the input and m_nNextSequence, held while a feature is read.
+	boost::mutex m_inputMutex;
+	bool m_bInputStarted;
+	bool m_bInputEnd;
+	long m_nNextSequence;
+
+	//! Protects the results and the state below.
+	boost::mutex m_mutex;
+	boost::condition_variable m_hasResults;
+	boost::condition_variable m_hasRoom;
+
+	//! The features read by the workers (including the one reading past the end).
+	long m_nReserved;
+
+	//! The results delivered to the consumer, or dropped.
+	long m_nDelivered;
+
+	//! The number of features of the input, known once the input ended.
+	long m_nCount;
+	bool m_bCountKnown;
+
+	//! The results by sequence number (ordered delivery).
+	std::map<long,boost::intrusive_ptr<IFeature> > m_orderedResults;
+
+	//! The results in the order they are ready (unordered delivery).
+	std::deque<boost::intrusive_ptr<IFeature> > m_unorderedResults;
+
+	bool m_bStopping;
+	bool m_bCanceled;
+	std::string m_strError;
+
+	PYXTaskGroup m_workers;
+
+	//! The current feature of the consumer, null at the end.
+	boost::intrusive_ptr<IFeature> m_feature;
+};
+
+//! Time filtering 4000 features sequentially and with a pipeline stage (not run by the tests).
+PYXLIB_DECL void benchmarkFeaturePipeline();
+
+#endif // guard
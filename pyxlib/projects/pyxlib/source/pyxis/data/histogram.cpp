@@ -13,6 +13,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/string_histogram.h"
 #include "pyxis/data/impl/numeric_histogram_impl.h"
 #include "pyxis/data/impl/string_histogram_impl.h"
+#include "pyxis/data/impl/sketch_histogram_impl.h"
 
 std::vector<PYXHistogramBin> PYXHistogram::getNormalizedBins(PYXHistogram::Normalization mode,int binCount) const
 {
@@ -164,4 +165,43 @@ PYXPointer<PYXHistogram> PYXHistogram::createFromFeatures(PYXPointer<FeatureIter
 		return PYXStringHistogram::create(StringHistogram(values.begin(),values.end()));
 	}
 
-}
\ No newline at end of file
+}
+
+//creates a bounded memory sketch histogram of values of the given field collected from the given feature iterator.
+PYXPointer<PYXHistogram> PYXHistogram::createSketchFromFeatures(PYXPointer<FeatureIterator> features, int fieldIndex)
+{
+	if (features->end()) 
+	{
+		return nullptr;
+	}
+
+	auto firstFeature = features->getFeature();
+
+	if (!firstFeature) 
+	{
+		return nullptr;
+	}
+
+	if (firstFeature->getDefinition()->getFieldDefinition(fieldIndex).isNumeric())
+	{
+		QuantileSketch sketch;
+
+		for (;!features->end();features->next())
+		{
+			sketch.add(features->getFeature()->getFieldValue(fieldIndex).getDouble());
+		}
+
+		return PYXNumericSketchHistogram::create(sketch);
+	}
+	else 
+	{
+		StringSketch sketch;
+
+		for (;!features->end();features->next())
+		{
+			sketch.add(features->getFeature()->getFieldValue(fieldIndex).getString());
+		}
+
+		return PYXStringSketchHistogram::create(sketch);
+	}
+}
@@ -41,6 +41,9 @@ public:
 	//creates an histogram of values of the given field collected from the given feature iterator.
 	static PYXPointer<PYXHistogram> createFromFeatures(PYXPointer<FeatureIterator> features, int fieldIndex);
 
+	//creates a bounded memory sketch histogram of values of the given field collected from the given feature iterator.
+	static PYXPointer<PYXHistogram> createSketchFromFeatures(PYXPointer<FeatureIterator> features, int fieldIndex);
+
 public:
 	//get the feature count that was used to build the histogram.
 	virtual Range<int> getFeatureCount() const = 0;
@@ -0,0 +1,517 @@
+/******************************************************************************
+sketch_histogram_impl.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/data/impl/sketch_histogram_impl.h"
+#include "pyxis/data/impl/numeric_histogram_impl.h"
+#include "pyxis/derm/snyder_projection.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/exceptions.h"
+#include "pyxis/utility/string_utils.h"
+
+// standard includes
+#include <cassert>
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXNumericSketchHistogram
+///////////////////////////////////////////////////////////////////////////////
+
+//! Tester class
+Tester<PYXNumericSketchHistogram> gTester;
+
+//! Test method
+void PYXNumericSketchHistogram::test()
+{
+	srand(10);
+
+	std::vector<double> values;
+	for(int i=0;i<20000;i++)
+	{
+		values.push_back(rand()%1000+(rand()%100000)/100000.0);
+	}
+
+	PYXPointer<PYXNumericHistogram> exact = PYXNumericHistogram::create(NumericHistogram<double>(values.begin(),values.end()));
+
+	// build the sketch histogram from two halves to exercise merging
+	PYXPointer<PYXNumericSketchHistogram> sketch = PYXNumericSketchHistogram::create();
+	PYXPointer<PYXNumericSketchHistogram> other = PYXNumericSketchHistogram::create();
+	for(unsigned int i=0;i<values.size();++i)
+	{
+		(i%2 ? sketch : other)->add(PYXValue(values[i]));
+	}
+	sketch->add(*other);
+
+	TEST_ASSERT(sketch->getFeatureCount() == exact->getFeatureCount());
+	TEST_ASSERT(sketch->getBoundaries().min.getDouble() == exact->getBoundaries().min.getDouble());
+	TEST_ASSERT(sketch->getBoundaries().max.getDouble() == exact->getBoundaries().max.getDouble());
+
+	// the sketch count brackets the exact count of the full histogram
+	for(int i=0;i<1000;i+=100)
+	{
+		Range<PYXValue> range = Range<PYXValue>::createClosedOpen(PYXValue((double)i),PYXValue((double)i+100));
+		int realCount = 0;
+		for(unsigned int j=0;j<values.size();++j)
+		{
+			if (values[j] >= i && values[j] < i+100)
+			{
+				realCount++;
+			}
+		}
+		TEST_ASSERT(sketch->getFeatureCount(range).contains(realCount));
+	}
+
+	// normalized bins cover all values with similar counts
+	std::vector<PYXHistogramBin> bins = sketch->getNormalizedBins(knNormalizedBin,10);
+	TEST_ASSERT(bins.size() <= 10 && bins.size() >= 8);
+	int total = 0;
+	for(unsigned int i=0;i<bins.size();++i)
+	{
+		total += bins[i].count.middle();
+	}
+	TEST_ASSERT(std::abs(total - (int)values.size()) <= (int)bins.size());
+
+	// mixing histogram implementations is not allowed
+	bool thrown = false;
+	try
+	{
+		sketch->add(*exact);
+	}
+	catch(PYXException &)
+	{
+		thrown = true;
+	}
+	TEST_ASSERT(thrown);
+
+	// serialization round trip
+	{
+		PYXStringWireBuffer buffer;
+		sketch->serialize(buffer);
+		buffer.setPos(0);
+
+		PYXPointer<PYXNumericSketchHistogram> loaded = PYXNumericSketchHistogram::create(buffer);
+		TEST_ASSERT(loaded->getFeatureCount() == sketch->getFeatureCount());
+		TEST_ASSERT(loaded->getBoundaries().min.getDouble() == sketch->getBoundaries().min.getDouble());
+		TEST_ASSERT(loaded->getBoundaries().max.getDouble() == sketch->getBoundaries().max.getDouble());
+		TEST_ASSERT(loaded->getNormalizedBins(knNormalizedBin,10).size() == bins.size());
+	}
+}
+
+Range<int> PYXNumericSketchHistogram::getFeatureCount(Range<PYXValue> range) const
+{
+	Range<double> doubleRange(
+		range.minType == knInfinite ? 0 : range.min.getDouble(),
+		range.maxType == knInfinite ? 0 : range.max.getDouble(),
+		range.minType,
+		range.maxType);
+
+	return m_sketch.count(doubleRange);
+}
+
+std::vector<PYXHistogramBin> PYXNumericSketchHistogram::getBins() const
+{
+	return getEqualDepthBins(knDefaultBinCount);
+}
+
+std::vector<PYXHistogramBin> PYXNumericSketchHistogram::getNormalizedBins(Normalization mode,int binCount) const
+{
+	if (mode == knNormalizedBin)
+	{
+		return getEqualDepthBins(binCount);
+	}
+	return PYXHistogram::getNormalizedBins(mode,binCount);
+}
+
+std::vector<PYXHistogramBin> PYXNumericSketchHistogram::getEqualDepthBins(int binCount) const
+{
+	std::vector<PYXHistogramBin> result;
+
+	if (m_sketch.count() == 0 || binCount <= 0)
+	{
+		return result;
+	}
+
+	std::vector<QuantileSketch::WeightedValue> view;
+	m_sketch.getSortedView(view);
+
+	const int countPerBin = std::max(1,m_sketch.count() / binCount);
+	const int error = m_sketch.getMaxError();
+
+	PYXHistogramBin bin;
+	double binStart = view.front().first;
+	int binCountEstimate = 0;
+
+	for(unsigned int i=0;i<view.size();++i)
+	{
+		binCountEstimate += view[i].second;
+
+		const bool last = (i+1 == view.size());
+
+		// never split a single value between two bins
+		if (!last && (binCountEstimate < countPerBin || view[i+1].first == view[i].first))
+		{
+			continue;
+		}
+
+		if (last)
+		{
+			bin.range = Range<PYXValue>::createClosedClosed(PYXValue(binStart),PYXValue(m_sketch.getBoundaries().max));
+		}
+		else
+		{
+			bin.range = Range<PYXValue>::createClosedOpen(PYXValue(binStart),PYXValue(view[i+1].first));
+			binStart = view[i+1].first;
+		}
+
+		bin.count = Range<int>::createClosedClosed(std::max(0,binCountEstimate-error),binCountEstimate+error);
+		result.push_back(bin);
+
+		binCountEstimate = 0;
+	}
+
+	return result;
+}
+
+void PYXNumericSketchHistogram::add(const PYXHistogram & histogram)
+{
+	const PYXNumericSketchHistogram * other = dynamic_cast<const PYXNumericSketchHistogram*>(&histogram);
+
+	if (!other)
+	{
+		PYXTHROW(PYXException,"other histogram is not PYXNumericSketchHistogram");
+	}
+
+	m_sketch.add(other->m_sketch);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXNumericSketchCellHistogram
+///////////////////////////////////////////////////////////////////////////////
+
+//! Tester class
+Tester<PYXNumericSketchCellHistogram> gCellTester;
+
+//! Test method
+void PYXNumericSketchCellHistogram::test()
+{
+	const int nResolution = 10;
+
+	PYXIcosIndex index("A-0");
+	index.setResolution(nResolution);
+	const double cellArea = SnyderProjection::getInstance()->calcCellAreaOnReferenceSphere(index);
+
+	QuantileSketch values;
+	QuantileSketch otherValues;
+	for(int i=0;i<5000;i++)
+	{
+		(i%2 ? values : otherValues).add((double)(i%500));
+	}
+
+	PYXPointer<PYXNumericSketchCellHistogram> histogram = PYXNumericSketchCellHistogram::create(values,nResolution);
+	histogram->add(*PYXNumericSketchCellHistogram::create(otherValues,nResolution));
+
+	TEST_ASSERT(histogram->getCellResolution() == nResolution);
+	TEST_ASSERT(histogram->getFeatureCount() == Range<int>(5000));
+	TEST_ASSERT(histogram->getBoundaries().min.getDouble() == 0);
+	TEST_ASSERT(histogram->getBoundaries().max.getDouble() == 499);
+
+	// the area is the count times the area of a cell
+	Range<double> area = histogram->getArea();
+	TEST_ASSERT(area.min == 5000*cellArea);
+	TEST_ASSERT(area.max == 5000*cellArea);
+
+	Range<PYXValue> range = Range<PYXValue>::createClosedOpen(PYXValue(100.0),PYXValue(200.0));
+	Range<int> count = histogram->getFeatureCount(range);
+	TEST_ASSERT(count.contains(1000));
+	area = histogram->getArea(range);
+	TEST_ASSERT(area.min == count.min*cellArea);
+	TEST_ASSERT(area.max == count.max*cellArea);
+
+	// the cell bins match the bins, with their area
+	std::vector<PYXHistogramBin> bins = histogram->getNormalizedBins(knNormalizedBin,10);
+	std::vector<PYXCellHistogramBin> cellBins = histogram->getCellNormalizedBins(knNormalizedBin,10);
+	TEST_ASSERT(!cellBins.empty());
+	TEST_ASSERT(cellBins.size() == bins.size());
+	for(unsigned int i=0;i<cellBins.size();++i)
+	{
+		TEST_ASSERT(cellBins[i].count == bins[i].count);
+		TEST_ASSERT(cellBins[i].area.min == bins[i].count.min*cellArea);
+		TEST_ASSERT(cellBins[i].area.max == bins[i].count.max*cellArea);
+	}
+
+	// mixing histogram implementations is not allowed
+	bool thrown = false;
+	try
+	{
+		histogram->add(*PYXNumericSketchHistogram::create(values));
+	}
+	catch(PYXException &)
+	{
+		thrown = true;
+	}
+	TEST_ASSERT(thrown);
+
+	// serialization round trip keeps the resolution and the area
+	{
+		PYXStringWireBuffer buffer;
+		histogram->serialize(buffer);
+		buffer.setPos(0);
+
+		PYXPointer<PYXNumericSketchCellHistogram> loaded = PYXNumericSketchCellHistogram::create(buffer);
+		TEST_ASSERT(loaded->getCellResolution() == nResolution);
+		TEST_ASSERT(loaded->getFeatureCount() == histogram->getFeatureCount());
+		TEST_ASSERT(loaded->getFeatureCount(range) == count);
+		TEST_ASSERT(loaded->getArea().min == histogram->getArea().min);
+	}
+}
+
+PYXNumericSketchCellHistogram::PYXNumericSketchCellHistogram(const QuantileSketch & sketch,int wantedResolution) :
+	m_histogram(sketch)
+{
+	setCellResolution(wantedResolution);
+}
+
+void PYXNumericSketchCellHistogram::setCellResolution(int cellResolution)
+{
+	m_cellResolution = cellResolution;
+
+	PYXIcosIndex index = PYXIcosIndex("A-0");
+	index.setResolution(cellResolution);
+	m_cellArea = SnyderProjection::getInstance()->calcCellAreaOnReferenceSphere(index);
+}
+
+void PYXNumericSketchCellHistogram::deserialize(PYXWireBuffer & buffer)
+{
+	int cellResolution;
+	buffer >> cellResolution;
+	m_histogram.deserialize(buffer);
+	setCellResolution(cellResolution);
+}
+
+void PYXNumericSketchCellHistogram::serialize(PYXWireBuffer & buffer) const
+{
+	buffer << m_cellResolution;
+	m_histogram.serialize(buffer);
+}
+
+void PYXNumericSketchCellHistogram::add(const PYXHistogram & histogram)
+{
+	const PYXNumericSketchCellHistogram * other = dynamic_cast<const PYXNumericSketchCellHistogram*>(&histogram);
+
+	if (!other)
+	{
+		PYXTHROW(PYXException,"other histogram is not PYXNumericSketchCellHistogram");
+	}
+
+	m_histogram.add(other->m_histogram);
+}
+
+std::vector<PYXCellHistogramBin> PYXNumericSketchCellHistogram::getCellBins() const
+{
+	return toCellBins(m_histogram.getBins());
+}
+
+std::vector<PYXCellHistogramBin> PYXNumericSketchCellHistogram::getCellNormalizedBins(Normalization mode,int binCount) const
+{
+	return toCellBins(getNormalizedBins(mode,binCount));
+}
+
+Range<double> PYXNumericSketchCellHistogram::getArea() const
+{
+	Range<int> count = m_histogram.getFeatureCount();
+	return Range<double>::createClosedOpen(count.min*m_cellArea,count.max*m_cellArea);
+}
+
+Range<double> PYXNumericSketchCellHistogram::getArea(Range<PYXValue> range) const
+{
+	Range<int> count = m_histogram.getFeatureCount(range);
+	return Range<double>::createClosedOpen(count.min*m_cellArea,count.max*m_cellArea);
+}
+
+std::vector<PYXCellHistogramBin> PYXNumericSketchCellHistogram::toCellBins(const std::vector<PYXHistogramBin> & bins) const
+{
+	std::vector<PYXCellHistogramBin> result;
+	result.reserve(bins.size());
+
+	PYXCellHistogramBin areaBin;
+	for(auto & bin : bins)
+	{
+		areaBin.range = bin.range;
+		areaBin.count = bin.count;
+		areaBin.area = Range<double>::createClosedOpen((bin.count.min * m_cellArea),(bin.count.max * m_cellArea));
+		result.push_back(areaBin);
+	}
+
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXStringSketchHistogram
+///////////////////////////////////////////////////////////////////////////////
+
+//! Tester class
+Tester<PYXStringSketchHistogram> gStringTester;
+
+//! Test method
+void PYXStringSketchHistogram::test()
+{
+	// a few frequent values and many rare ones, more than the sketch can track
+	std::map<std::string,int> realCounts;
+	StringSketch sketch(16);
+	for(int i=0;i<4000;i++)
+	{
+		std::string value = (i%2) ? "m" + StringUtils::toString(i%4) : "r" + StringUtils::toString(i);
+		sketch.add(value);
+		realCounts[value]++;
+	}
+
+	PYXPointer<PYXStringSketchHistogram> histogram = PYXStringSketchHistogram::create(sketch);
+	std::vector<PYXHistogramBin> bins = histogram->getBins();
+	TEST_ASSERT(!bins.empty());
+
+	int minTotal = 0;
+	int maxTotal = 0;
+	for(unsigned int i=0;i<bins.size();++i)
+	{
+		minTotal += bins[i].count.min;
+		maxTotal += bins[i].count.max;
+
+		// the bins are ordered and never overlap
+		if (i > 0)
+		{
+			const Range<PYXValue> & previous = bins[i-1].range;
+			const Range<PYXValue> & current = bins[i].range;
+			TEST_ASSERT(previous.max.getString() < current.min.getString() ||
+				(previous.max.getString() == current.min.getString() && (previous.maxType == knOpen || current.minType == knOpen)));
+		}
+
+		// every bin brackets the real count of the values it covers
+		int realCount = 0;
+		for(auto & value : realCounts)
+		{
+			if (bins[i].range.contains(PYXValue(value.first)))
+			{
+				realCount += value.second;
+			}
+		}
+		TEST_ASSERT(bins[i].count.contains(realCount));
+	}
+	TEST_ASSERT(minTotal <= 4000 && 4000 <= maxTotal);
+
+	// the frequent values are tracked in bins of their own
+	for(int i=1;i<4;i+=2)
+	{
+		std::string value = "m" + StringUtils::toString(i);
+		TEST_ASSERT(histogram->getFeatureCount(Range<PYXValue>(PYXValue(value))).contains(realCounts[value]));
+	}
+
+	// serialization round trip
+	{
+		PYXStringWireBuffer buffer;
+		histogram->serialize(buffer);
+		buffer.setPos(0);
+
+		PYXPointer<PYXStringSketchHistogram> loaded = PYXStringSketchHistogram::create(buffer);
+		TEST_ASSERT(loaded->getFeatureCount() == histogram->getFeatureCount());
+		TEST_ASSERT(loaded->getDistinctCount() == histogram->getDistinctCount());
+		TEST_ASSERT(loaded->getBins().size() == bins.size());
+	}
+}
+
+std::vector<PYXHistogramBin> PYXStringSketchHistogram::getBins() const
+{
+	std::vector<StringSketch::HeavyHitter> hitters;
+	m_sketch.getHeavyHitters(hitters);
+
+	std::vector<PYXHistogramBin> result;
+
+	if (m_sketch.count() == 0)
+	{
+		return result;
+	}
+
+	result.reserve(2*hitters.size()+1);
+
+	// the untracked values are somewhere between the tracked values. At least
+	// the values not claimed by the tracked counts are untracked, at most the
+	// values not claimed by the tracked lower bounds.
+	int minUntracked = m_sketch.count();
+	for(auto & hitter : hitters)
+	{
+		minUntracked -= hitter.count;
+	}
+	minUntracked = std::max(0,minUntracked);
+	const int maxUntracked = m_sketch.getUntrackedCount();
+
+	// a bin for every gap between the tracked values, clipped to the boundaries
+	std::vector<PYXHistogramBin> gaps;
+	const RangeString & boundaries = m_sketch.getBoundaries();
+	PYXHistogramBin bin;
+	if (maxUntracked > 0)
+	{
+		std::string gapStart = boundaries.min;
+		RangeBorderType gapStartType = knClosed;
+		for(unsigned int i=0;i<=hitters.size();++i)
+		{
+			const bool last = (i == hitters.size());
+			const std::string & gapEnd = last ? boundaries.max : hitters[i].value;
+			const RangeBorderType gapEndType = last ? knClosed : knOpen;
+
+			if (gapStart < gapEnd || (gapStart == gapEnd && gapStartType == knClosed && gapEndType == knClosed))
+			{
+				bin.range = Range<PYXValue>(PYXValue(gapStart),PYXValue(gapEnd),gapStartType,gapEndType);
+				gaps.push_back(bin);
+			}
+
+			if (!last)
+			{
+				gapStart = hitters[i].value;
+				gapStartType = knOpen;
+			}
+		}
+	}
+
+	// the lower bound can only be assigned when there is a single gap
+	const int minGapCount = gaps.size() == 1 ? minUntracked : 0;
+
+	std::vector<PYXHistogramBin>::iterator gap = gaps.begin();
+	for(auto & hitter : hitters)
+	{
+		while (gap != gaps.end() && gap->range.max.getString() <= hitter.value)
+		{
+			gap->count = Range<int>::createClosedClosed(minGapCount,maxUntracked);
+			result.push_back(*gap);
+			++gap;
+		}
+
+		bin.range = Range<PYXValue>(PYXValue(hitter.value));
+		bin.count = hitter.getCountRange();
+		result.push_back(bin);
+	}
+	for(;gap != gaps.end();++gap)
+	{
+		gap->count = Range<int>::createClosedClosed(minGapCount,maxUntracked);
+		result.push_back(*gap);
+	}
+
+	return result;
+}
+
+void PYXStringSketchHistogram::add(const PYXHistogram & histogram)
+{
+	const PYXStringSketchHistogram * other = dynamic_cast<const PYXStringSketchHistogram*>(&histogram);
+
+	if (!other)
+	{
+		PYXTHROW(PYXException,"other histogram is not PYXStringSketchHistogram");
+	}
+
+	m_sketch.add(other->m_sketch);
+}
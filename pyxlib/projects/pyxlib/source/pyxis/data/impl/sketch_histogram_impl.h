@@ -0,0 +1,315 @@
+#ifndef PYXIS__DATA__IMPL_SKETCH_HISTOGRAM_H
+#define PYXIS__DATA__IMPL_SKETCH_HISTOGRAM_H
+/******************************************************************************
+sketch_histogram_impl.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "pyxis/derm/index.h"
+#include "pyxis/utility/value.h"
+#include "pyxis/utility/range.h"
+#include "pyxis/utility/wire_buffer.h"
+#include "pyxis/utility/quantile_sketch.h"
+#include "pyxis/utility/string_sketch.h"
+#include "pyxis/data/histogram.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXNumericSketchHistogram
+///////////////////////////////////////////////////////////////////////////////
+
+/*!
+A numeric histogram backed by a QuantileSketch. Memory is bounded, merging is
+O(sketch) and counts are approximate (see QuantileSketch::getMaxError).
+*/
+class PYXLIB_DECL PYXNumericSketchHistogram : public PYXHistogram
+{
+public:
+	//! Test method
+	static void test();
+
+	//! Number of bins returned by getBins().
+	static const int knDefaultBinCount = 100;
+
+protected:
+	QuantileSketch m_sketch;
+
+public:
+	static PYXPointer<PYXNumericSketchHistogram> create()
+	{
+		return PYXNEW(PYXNumericSketchHistogram,QuantileSketch());
+	}
+
+	static PYXPointer<PYXNumericSketchHistogram> create(const QuantileSketch & sketch)
+	{
+		return PYXNEW(PYXNumericSketchHistogram,sketch);
+	}
+
+	//! Create a histogram from a buffer written by serialize.
+	static PYXPointer<PYXNumericSketchHistogram> create(PYXWireBuffer & buffer)
+	{
+		PYXPointer<PYXNumericSketchHistogram> histogram = create();
+		histogram->deserialize(buffer);
+		return histogram;
+	}
+
+	PYXNumericSketchHistogram(const QuantileSketch & sketch) : m_sketch(sketch)
+	{
+	}
+
+public: // I/O Methods
+
+	//! Read the histogram from the buffer.
+	void deserialize(PYXWireBuffer & buffer)
+	{
+		buffer >> m_sketch;
+	}
+
+	//! Write the histogram to the buffer.
+	void serialize(PYXWireBuffer & buffer) const
+	{
+		buffer << m_sketch;
+	}
+
+public:
+	virtual Range<int> getFeatureCount() const
+	{
+		return Range<int>(m_sketch.count());
+	}
+
+	virtual Range<int> getFeatureCount(Range<PYXValue> range) const;
+
+	virtual PYXValue getSum() const
+	{
+		return PYXValue(m_sketch.getSum());
+	}
+
+	virtual PYXValue getAverage() const
+	{
+		return PYXValue(m_sketch.getAverage());
+	}
+
+	virtual PYXValue getSumSquare() const
+	{
+		return PYXValue(m_sketch.getSumSquare());
+	}
+
+	virtual Range<PYXValue> getBoundaries() const
+	{
+		return Range<PYXValue>::createClosedClosed(PYXValue(m_sketch.getBoundaries().min),PYXValue(m_sketch.getBoundaries().max));
+	}
+
+	//! Equal depth bins computed from the sketch.
+	virtual std::vector<PYXHistogramBin> getBins() const;
+
+	//! Normalized bins are read directly from the sketch quantiles.
+	virtual std::vector<PYXHistogramBin> getNormalizedBins(Normalization mode,int binCount) const;
+
+	virtual void add(const PYXValue & value)
+	{
+		m_sketch.add(value.getDouble());
+	}
+
+	virtual void add(const PYXHistogram & histogram);
+
+	QuantileSketch & getSketch() { return m_sketch; }
+
+	const QuantileSketch & getSketch() const { return m_sketch; }
+
+protected:
+	//! Split the sketch into up to binCount bins of similar count.
+	std::vector<PYXHistogramBin> getEqualDepthBins(int binCount) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXNumericSketchCellHistogram
+///////////////////////////////////////////////////////////////////////////////
+
+class PYXLIB_DECL PYXNumericSketchCellHistogram : public PYXCellHistogram
+{
+public:
+	//! Test method
+	static void test();
+
+protected:
+	PYXNumericSketchHistogram m_histogram;
+	double m_cellArea;
+	int m_cellResolution;
+
+public:
+	static PYXPointer<PYXNumericSketchCellHistogram> create(const QuantileSketch & sketch, int wantedResolution)
+	{
+		return PYXNEW(PYXNumericSketchCellHistogram,sketch,wantedResolution);
+	}
+
+	//! Create a histogram from a buffer written by serialize.
+	static PYXPointer<PYXNumericSketchCellHistogram> create(PYXWireBuffer & buffer)
+	{
+		PYXPointer<PYXNumericSketchCellHistogram> histogram = PYXNEW(PYXNumericSketchCellHistogram,QuantileSketch(),PYXIcosIndex::knMinSubRes);
+		histogram->deserialize(buffer);
+		return histogram;
+	}
+
+	PYXNumericSketchCellHistogram(const QuantileSketch & sketch,int wantedResolution);
+
+public: // I/O Methods
+
+	//! Read the histogram from the buffer.
+	void deserialize(PYXWireBuffer & buffer);
+
+	//! Write the histogram to the buffer.
+	void serialize(PYXWireBuffer & buffer) const;
+
+public:
+	virtual Range<int> getFeatureCount() const { return m_histogram.getFeatureCount(); }
+
+	virtual Range<int> getFeatureCount(Range<PYXValue> range) const { return m_histogram.getFeatureCount(range); }
+
+	virtual PYXValue getSum() const { return m_histogram.getSum(); }
+
+	virtual PYXValue getAverage() const { return m_histogram.getAverage(); }
+
+	virtual PYXValue getSumSquare() const { return m_histogram.getSumSquare(); }
+
+	virtual Range<PYXValue> getBoundaries() const { return m_histogram.getBoundaries(); }
+
+	virtual std::vector<PYXHistogramBin> getBins() const { return m_histogram.getBins(); }
+
+	virtual std::vector<PYXHistogramBin> getNormalizedBins(Normalization mode,int binCount) const
+	{
+		return m_histogram.getNormalizedBins(mode,binCount);
+	}
+
+	virtual void add(const PYXValue & value) { m_histogram.add(value); }
+
+	virtual void add(const PYXHistogram & histogram);
+
+	QuantileSketch & getSketch() { return m_histogram.getSketch(); }
+
+	const QuantileSketch & getSketch() const { return m_histogram.getSketch(); }
+
+	virtual std::vector<PYXCellHistogramBin> getCellBins() const;
+
+	virtual std::vector<PYXCellHistogramBin> getCellNormalizedBins(Normalization mode,int binCount) const;
+
+	virtual int getCellResolution() const { return m_cellResolution; }
+
+	virtual Range<double> getArea() const;
+
+	virtual Range<double> getArea(Range<PYXValue> range) const;
+
+private:
+	//! Set the resolution of the cells and the area of a cell.
+	void setCellResolution(int cellResolution);
+
+	std::vector<PYXCellHistogramBin> toCellBins(const std::vector<PYXHistogramBin> & bins) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXStringSketchHistogram
+///////////////////////////////////////////////////////////////////////////////
+
+/*!
+A string histogram backed by a StringSketch. The bins are the most frequent
+values, plus a bin for every range between them that may hold values that are
+not tracked.
+*/
+class PYXLIB_DECL PYXStringSketchHistogram : public PYXHistogram
+{
+public:
+	//! Test method
+	static void test();
+
+protected:
+	StringSketch m_sketch;
+
+public:
+	static PYXPointer<PYXStringSketchHistogram> create()
+	{
+		return PYXNEW(PYXStringSketchHistogram,StringSketch());
+	}
+
+	static PYXPointer<PYXStringSketchHistogram> create(const StringSketch & sketch)
+	{
+		return PYXNEW(PYXStringSketchHistogram,sketch);
+	}
+
+	//! Create a histogram from a buffer written by serialize.
+	static PYXPointer<PYXStringSketchHistogram> create(PYXWireBuffer & buffer)
+	{
+		PYXPointer<PYXStringSketchHistogram> histogram = create();
+		histogram->deserialize(buffer);
+		return histogram;
+	}
+
+	PYXStringSketchHistogram(const StringSketch & sketch) : m_sketch(sketch)
+	{
+	}
+
+public: // I/O Methods
+
+	//! Read the histogram from the buffer.
+	void deserialize(PYXWireBuffer & buffer)
+	{
+		buffer >> m_sketch;
+	}
+
+	//! Write the histogram to the buffer.
+	void serialize(PYXWireBuffer & buffer) const
+	{
+		buffer << m_sketch;
+	}
+
+public:
+	virtual Range<int> getFeatureCount() const
+	{
+		return Range<int>(m_sketch.count());
+	}
+
+	virtual Range<int> getFeatureCount(Range<PYXValue> range) const
+	{
+		return m_sketch.count(RangeString(range.min.getString(),range.max.getString(),range.minType,range.maxType));
+	}
+
+	virtual PYXValue getSum() const
+	{
+		PYXTHROW_NOT_IMPLEMENTED();
+	}
+
+	virtual PYXValue getAverage() const
+	{
+		PYXTHROW_NOT_IMPLEMENTED();
+	}
+
+	virtual PYXValue getSumSquare() const
+	{
+		PYXTHROW_NOT_IMPLEMENTED();
+	}
+
+	virtual Range<PYXValue> getBoundaries() const
+	{
+		return Range<PYXValue>::createClosedClosed(PYXValue(m_sketch.getBoundaries().min),PYXValue(m_sketch.getBoundaries().max));
+	}
+
+	virtual std::vector<PYXHistogramBin> getBins() const;
+
+	virtual void add(const PYXValue & value)
+	{
+		m_sketch.add(value.getString());
+	}
+
+	virtual void add(const PYXHistogram & histogram);
+
+	//! Estimated number of distinct values.
+	int getDistinctCount() const { return m_sketch.getDistinctCount(); }
+
+	StringSketch & getSketch() { return m_sketch; }
+
+	const StringSketch & getSketch() const { return m_sketch; }
+};
+
+#endif // guard
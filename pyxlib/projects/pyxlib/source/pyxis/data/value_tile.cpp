@@ -13,11 +13,15 @@ web			: www.pyxisinnovation.com
 // pyxlib includes
 #include "pyxis/data/exceptions.h"
 #include "pyxis/data/record.h"
+#include "pyxis/derm/compact_index.h"
 #include "pyxis/derm/index_math.h"
 #include "pyxis/derm/iterator.h"
+#include "pyxis/derm/point_location.h"
+#include "pyxis/derm/wgs84_coord_converter.h"
 #include "pyxis/utility/app_services.h"
 #include "pyxis/utility/file_utils.h"
 #include "pyxis/utility/memory_manager.h"
+#include "pyxis/utility/profile.h"
 #include "pyxis/utility/string_utils.h"
 #include "pyxis/utility/tester.h"
 #include "pyxis/utility/value_math.h"
@@ -27,6 +31,9 @@ web			: www.pyxisinnovation.com
 // third party includes
 #include "zlib.h"
 
+// boost includes
+#include <boost/static_assert.hpp>
+
 // standard includes
 #include <sstream>
 
@@ -235,6 +242,97 @@ void PYXValueTile::test()
 			TEST_ASSERT(zoomTile->getValue(index, 0) == myInt16);
 		}
 	}
+
+	// Test the bulk copies against the per cell accessors.
+	{
+		const int nCells = vt.getNumberOfCells();
+
+		std::vector<double> vecValues(nCells * 3);
+		std::vector<unsigned char> vecHasValues(nCells);
+		TEST_ASSERT(vt.getChannelValues(2, &vecValues[0], &vecHasValues[0]) == 1);
+
+		TEST_ASSERT(vt.getChannelDataBytes(0) == nCells * (int)sizeof(int16_t));
+		std::vector<int16_t> vecData(nCells);
+		TEST_ASSERT(vt.getChannelData(0, reinterpret_cast<unsigned char*>(&vecData[0])) == nCells);
+
+		std::vector<unsigned char> vecIndices(nCells * knCellIndexBytes);
+		std::vector<double> vecLatLons(nCells * 2);
+		TEST_ASSERT(vt.getCellIndices(&vecIndices[0]) == nCells);
+		TEST_ASSERT(vt.getCellLatLons(&vecLatLons[0]) == nCells);
+
+		int nOffset = 0;
+		for (PYXPointer<PYXIterator> spIt(vt.getIterator()); !spIt->end(); spIt->next(), ++nOffset)
+		{
+			const PYXIcosIndex& cellIndex = spIt->getIndex();
+			const bool bSet = (cellIndex == aValidCellIndex);
+			TEST_ASSERT(vecHasValues[nOffset] == (bSet ? 1 : 0));
+			for (int nElement = 0; nElement < 3; ++nElement)
+			{
+				TEST_ASSERT(vecValues[3 * nOffset + nElement] == (bSet ? rgb[nElement] : 0.0));
+			}
+			TEST_ASSERT(vecData[nOffset] == myInt16.getInt16());
+
+			CompactIndex compactIndex;
+			memcpy(&compactIndex, &vecIndices[nOffset * knCellIndexBytes], knCellIndexBytes);
+			TEST_ASSERT(PYXIcosIndex(compactIndex) == cellIndex);
+
+			const PYXCoord2DDouble lonLat = PointLocation::fromPYXIndex(cellIndex).asWGS84();
+			TEST_ASSERT(vecLatLons[2 * nOffset] == lonLat.y() && vecLatLons[2 * nOffset + 1] == lonLat.x());
+		}
+
+		// strings have no packed data
+		bool bThrown = false;
+		try
+		{
+			vt.getChannelData(3, reinterpret_cast<unsigned char*>(&vecData[0]));
+		}
+		catch (PYXException&)
+		{
+			bThrown = true;
+		}
+		TEST_ASSERT(bThrown);
+	}
+}
+
+void PYXValueTile::benchmark()
+{
+	std::vector<PYXValue::eType> vecFloatTypes(1, PYXValue::knFloat);
+	PYXValueTile floatTile(PYXTile(PYXIcosIndex("A-0"), 13), vecFloatTypes);
+	const int nCells = floatTile.getNumberOfCells();
+	for (int nOffset = 0; nOffset < nCells; ++nOffset)
+	{
+		floatTile.setValue(nOffset, 0, PYXValue(static_cast<float>(nOffset)));
+	}
+
+	std::vector<double> vecValues(nCells);
+	std::vector<unsigned char> vecHasValues(nCells);
+	PYXHighQualityTimer timer;
+
+	timer.start();
+	PYXValue value = floatTile.getTypeCompatibleValue(0);
+	for (int nOffset = 0; nOffset < nCells; ++nOffset)
+	{
+		vecHasValues[nOffset] = floatTile.getValue(nOffset, 0, &value) ? 1 : 0;
+		vecValues[nOffset] = value.getDouble();
+	}
+	timer.stop();
+	double fPerCellTime = timer.getTime();
+
+	timer.start();
+	floatTile.getChannelValues(0, &vecValues[0], &vecHasValues[0]);
+	timer.stop();
+	double fBulkTime = timer.getTime();
+
+	timer.start();
+	std::vector<double> vecLatLons(nCells * 2);
+	floatTile.getCellLatLons(&vecLatLons[0]);
+	timer.stop();
+	double fLatLonTime = timer.getTime();
+
+	assert(vecValues[nCells - 1] == nCells - 1);
+
+	TRACE_INFO("PYXValueTile: transfer of " << nCells << " cells in " << fPerCellTime << "[sec] (per cell), " <<
+		fBulkTime << "[sec] (bulk), " << fLatLonTime << "[sec] (lat/lon)");
 }
 
 /*!
@@ -578,6 +676,124 @@ void PYXValueTile::setValue(	const int nOffset,
 	}
 }
 
+/*!
+Copy the values of a channel in a single call, converted to double.  This is
+the bulk counterpart of getValue(), for transferring a whole tile through the
+binding.  Null cells are set to 0.
+
+\param nChannelIndex	The field index.
+\param pValues			Receives getNumberOfCells() * getDataChannelCount() values.
+\param pHasValues		Optional (may be 0), receives getNumberOfCells() flags,
+						1 where the cell is not null.
+
+\return The number of cells that are not null.
+*/
+int PYXValueTile::getChannelValues(	const int nChannelIndex,
+									double* pValues,
+									unsigned char* pHasValues	) const
+{
+	if (nChannelIndex < 0 || nChannelIndex >= getNumberOfDataChannels())
+	{
+		PYXTHROW(PYXValueTileException, "Invalid data channel: " << nChannelIndex);
+	}
+
+	return m_spValueTable->getColumnValues(nChannelIndex, pValues, pHasValues);
+}
+
+/*!
+Get the size in bytes of the packed data of a numeric channel.
+
+\param nChannelIndex	The field index.
+
+\return The number of bytes copied by getChannelData().
+*/
+int PYXValueTile::getChannelDataBytes(const int nChannelIndex) const
+{
+	if (nChannelIndex < 0 || nChannelIndex >= getNumberOfDataChannels())
+	{
+		PYXTHROW(PYXValueTileException, "Invalid data channel: " << nChannelIndex);
+	}
+
+	return m_spValueTable->getColumnDataBytes(nChannelIndex);
+}
+
+/*!
+Copy the packed data of a numeric channel in a single call, without conversion:
+getDataChannelCount() values of the channel type per cell, in offset order.  The
+data of null cells is undefined.
+
+\param nChannelIndex	The field index.
+\param pData			Receives getChannelDataBytes() bytes.
+\param pHasValues		Optional (may be 0), receives getNumberOfCells() flags,
+						1 where the cell is not null.
+
+\return The number of cells that are not null.
+*/
+int PYXValueTile::getChannelData(	const int nChannelIndex,
+									unsigned char* pData,
+									unsigned char* pHasValues	) const
+{
+	if (nChannelIndex < 0 || nChannelIndex >= getNumberOfDataChannels())
+	{
+		PYXTHROW(PYXValueTileException, "Invalid data channel: " << nChannelIndex);
+	}
+
+	return m_spValueTable->getColumnData(nChannelIndex, pData, pHasValues);
+}
+
+/*!
+Copy the indices of the cells in a single call, in offset order, each packed as a
+CompactIndex of knCellIndexBytes bytes.
+
+\param pIndices	Receives knCellIndexBytes bytes for each cell of the tile (at
+					most getNumberOfCells() cells).
+
+\return The number of cells copied.
+*/
+int PYXValueTile::getCellIndices(unsigned char* pIndices) const
+{
+	BOOST_STATIC_ASSERT(sizeof(CompactIndex) == knCellIndexBytes);
+	assert(pIndices != 0);
+
+	int nOffset = 0;
+	for (PYXPointer<PYXIterator> spIt(getIterator()); !spIt->end(); spIt->next())
+	{
+		assert(nOffset < m_nTableRows);
+		const CompactIndex index(spIt->getIndex());
+		memcpy(pIndices + nOffset * knCellIndexBytes, &index, knCellIndexBytes);
+		++nOffset;
+	}
+	return nOffset;
+}
+
+/*!
+Copy the WGS84 coordinates of the cells in a single call, in offset order, as
+pairs of latitude and longitude in degrees.
+
+\param pLatLons	Receives two values for each cell of the tile (at most
+					getNumberOfCells() cells).
+
+\return The number of cells copied.
+*/
+int PYXValueTile::getCellLatLons(double* pLatLons) const
+{
+	assert(pLatLons != 0);
+
+	WGS84CoordConverter converter;
+	PYXCoord2DDouble lonLat;
+
+	int nOffset = 0;
+	for (PYXPointer<PYXIterator> spIt(getIterator()); !spIt->end(); spIt->next())
+	{
+		assert(nOffset < m_nTableRows);
+		converter.pyxisToNative(spIt->getIndex(), &lonLat);
+		pLatLons[2 * nOffset] = lonLat.y();
+		pLatLons[2 * nOffset + 1] = lonLat.x();
+		++nOffset;
+	}
+	return nOffset;
+}
+
 /*!
 Current I/O format version: increment every time format changes.
 */
@@ -65,6 +65,9 @@ public:
 	//! Unit test method
 	static void test();
 
+	//! Time the transfer of a resolution 13 tile per cell and in bulk (not run by the tests).
+	static void benchmark();
+
 	//! Create a value tile by reading it from a stream.
 	static PYXPointer<PYXValueTile> create(std::istream& in)
 	{
@@ -196,6 +199,28 @@ public:
 					const int nChannelIndex,
 					const PYXValue& value	);
 
+	//! Copy the values of a channel converted to double, and a not-null flag per cell
+	int getChannelValues(	const int nChannelIndex,
+							double* pValues,
+							unsigned char* pHasValues = 0	) const;
+
+	//! Get the size in bytes of the packed data of a numeric channel
+	int getChannelDataBytes(const int nChannelIndex) const;
+
+	//! Copy the packed data of a numeric channel, and a not-null flag per cell
+	int getChannelData(	const int nChannelIndex,
+						unsigned char* pData,
+						unsigned char* pHasValues = 0	) const;
+
+	//! Copy the indices of the cells, packed as CompactIndex, in offset order
+	int getCellIndices(unsigned char* pIndices) const;
+
+	//! Copy the WGS84 latitude and longitude of the cells, in offset order
+	int getCellLatLons(double* pLatLons) const;
+
+	//! The size in bytes of a cell index copied by getCellIndices()
+	static const int knCellIndexBytes = 12;
+
 	//! Get the dirty flag
 	bool isDirty() {return m_bDirty;}
 
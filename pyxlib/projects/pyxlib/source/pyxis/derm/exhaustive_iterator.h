@@ -71,6 +71,9 @@ public:
 	//! Get the PYXIS index for the current cell.
 	virtual const PYXIcosIndex& getIndex() const {return m_index;}
 
+	//! Get the PYXIS index of the root cell.
+	const PYXIcosIndex& getRootIndex() const {return m_rootIndex;}
+
 	//! Reset to the specified root index and resolution.
 	void reset(const PYXIcosIndex& rootIndex, int nResolution);
 
@@ -13,9 +13,19 @@ web			: www.pyxisinnovation.com
 #include "pyxis/data/value_tile.h"
 #include "pyxis/geometry/tile_collection.h"
 #include "pyxis/derm/neighbour_iterator.h"
+#include "pyxis/derm/index_math.h"
+#include "pyxis/geometry/tile.h"
+#include "pyxis/utility/profile.h"
 
 #include "boost/bind.hpp"
 
+// standard includes
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <queue>
+
 //////////////////////////////////////////////////////////////////////////
 // PYXGeometrySafeIterator
 //////////////////////////////////////////////////////////////////////////
@@ -508,6 +518,137 @@ private:
 	boost::function< bool (const PYXIcosIndex &,const PYXIcosIndex &) > m_floodFunction;
 };
 
+//////////////////////////////////////////////////////////////////////////
+// TileFloodFillIterator
+//////////////////////////////////////////////////////////////////////////
+
+/*!
+Flood fill limited to the cells of a tile. The candidated cells are marked in a
+flat array indexed by the cell position in the tile instead of a tile collection.
+*/
+class TileFloodFillIterator : public PYXIterator
+{
+public:
+	static PYXPointer<TileFloodFillIterator> create(PYXPointer<PYXIterator> iterator,const PYXTile & bounds,const boost::function< bool (const PYXIcosIndex &,const PYXIcosIndex &) > & floodFunction)
+	{
+		return PYXNEW(TileFloodFillIterator,iterator,bounds,floodFunction);
+	}
+
+	TileFloodFillIterator(PYXPointer<PYXIterator> iterator,const PYXTile & bounds,const boost::function< bool (const PYXIcosIndex &,const PYXIcosIndex &) > & floodFunction) :
+		m_iterator(iterator),
+		m_bounds(bounds),
+		m_candidatedCells(bounds.getCellCount(),0),
+		m_floodFunction(floodFunction)
+	{
+		fetchNewSourceIndex();
+	}
+
+public:
+	virtual bool end() const
+	{
+		return m_candidates.empty() && m_iterator->end();
+	}
+
+	virtual void next()
+	{
+		if (end())
+		{
+			return;
+		}
+
+		//move to next candidate
+		if(!m_candidates.empty())
+		{
+			m_candidates.pop_front();
+		}
+
+		if (m_candidates.empty())
+		{
+			//search for a new source...
+			fetchNewSourceIndex();
+		}
+		else
+		{
+			//we need to add all matching neighbors as candidates for the new current index
+			addCandidates();
+		}
+	}
+
+	virtual const PYXIcosIndex& getIndex() const
+	{
+		return m_candidates.front();
+	}
+	virtual PYXValue getFieldValue(int nFieldIndex = 0) const
+	{
+		return PYXValue();
+	}
+
+private:
+	//! mark a cell as candidated, return false if the cell is outside the tile or already candidated.
+	bool markCandidated(const PYXIcosIndex & index)
+	{
+		if (!m_bounds.hasIndex(index))
+		{
+			return false;
+		}
+		unsigned char & candidated = m_candidatedCells[PYXIcosMath::calcCellPosition(m_bounds.getRootIndex(),index)];
+		if (candidated)
+		{
+			return false;
+		}
+		candidated = 1;
+		return true;
+	}
+
+	void fetchNewSourceIndex()
+	{
+		while (!m_iterator->end())
+		{
+			const PYXIcosIndex & index = m_iterator->getIndex();
+			if (markCandidated(index))
+			{
+				m_candidates.push_back(index);
+				m_iterator->next();
+
+				addCandidates();
+				return;
+			}
+			m_iterator->next();
+		}
+	}
+
+	void addCandidates()
+	{
+		//deque::push_back keeps the references to the existing items valid
+		const PYXIcosIndex & currentIndex = m_candidates.front();
+
+		PYXNeighbourIterator it(currentIndex);
+
+		//skip self
+		for(it.next();!it.end();it.next())
+		{
+			const PYXIcosIndex & index = it.getIndex();
+			if (!m_bounds.hasIndex(index))
+			{
+				continue;
+			}
+			unsigned char & candidated = m_candidatedCells[PYXIcosMath::calcCellPosition(m_bounds.getRootIndex(),index)];
+			if (!candidated && m_floodFunction(currentIndex,index))
+			{
+				m_candidates.push_back(index);
+				candidated = 1;
+			}
+		}
+	}
+
+private:
+	PYXPointer<PYXIterator> m_iterator;
+	PYXTile m_bounds;
+	std::vector<unsigned char> m_candidatedCells;
+	std::deque<PYXIcosIndex> m_candidates;
+	boost::function< bool (const PYXIcosIndex &,const PYXIcosIndex &) > m_floodFunction;
+};
+
 //////////////////////////////////////////////////////////////////////////
 // _value lambda helper
 //////////////////////////////////////////////////////////////////////////
@@ -728,6 +869,11 @@ PYXIteratorLinq PYXIteratorLinq::floodFill( const boost::function< bool (const P
 	return FloodFillIterator::create(m_iterator,canFloodFunction);
 }
 
+PYXIteratorLinq PYXIteratorLinq::floodFill( const PYXTile & bounds,const boost::function< bool (const PYXIcosIndex &,const PYXIcosIndex &) > & canFloodFunction )
+{
+	return TileFloodFillIterator::create(m_iterator,bounds,canFloodFunction);
+}
+
 PYXIteratorLinq PYXIteratorLinq::findShortestPath(	const PYXIcosIndex & source,
 													const boost::function<bool(const PYXIcosIndex &)> & isTargetFunction ,
 													const boost::function<double(const PYXIcosIndex &,const PYXIcosIndex &)> & costFunction,
@@ -799,6 +945,175 @@ PYXIteratorLinq PYXIteratorLinq::findShortestPath(	const PYXIcosIndex & source,
 	return fromList(way);
 }
 
+namespace
+{
+
+//! Move cost given by a cost function, called for every edge.
+class EdgeMoveCost
+{
+public:
+	EdgeMoveCost(const boost::function<double(const PYXIcosIndex &,const PYXIcosIndex &)> & costFunction) : m_costFunction(costFunction)
+	{
+	}
+
+	double operator()(const PYXIcosIndex & from,const PYXIcosIndex & to,unsigned int nToPosition) const
+	{
+		return m_costFunction(from,to);
+	}
+
+private:
+	const boost::function<double(const PYXIcosIndex &,const PYXIcosIndex &)> & m_costFunction;
+};
+
+//! Move cost read from the costs of the tile cells, evaluated by a single call.
+class CellMoveCost
+{
+public:
+	CellMoveCost(const PYXTile & bounds,const boost::function<void(const PYXTile &,std::vector<double> &)> & tileCostFunction) :
+		m_costs(bounds.getCellCount(),0)
+	{
+		tileCostFunction(bounds,m_costs);
+	}
+
+	double operator()(const PYXIcosIndex & from,const PYXIcosIndex & to,unsigned int nToPosition) const
+	{
+		return m_costs[nToPosition];
+	}
+
+private:
+	std::vector<double> m_costs;
+};
+
+/*!
+Dijkstra search limited to the cells of a tile. The search state is kept in flat
+arrays indexed by the cell position in the tile.
+*/
+template<typename MoveCost>
+PYXIteratorLinq findShortestPathInTile(	const PYXTile & bounds,
+										const PYXIcosIndex & source,
+										const boost::function<bool(const PYXIcosIndex &)> & isTargetFunction,
+										const MoveCost & moveCost,
+										const boost::function<double(double,double)> & costAggregationFunction )
+{
+	static const unsigned int knNoCell = std::numeric_limits<unsigned int>::max();
+
+	const PYXIcosIndex & root = bounds.getRootIndex();
+	const int nCellCount = bounds.getCellCount();
+
+	//search state, indexed by cell position in the tile
+	std::vector<double> costs(nCellCount,std::numeric_limits<double>::max());
+	std::vector<unsigned int> sources(nCellCount,knNoCell);
+	std::vector<unsigned char> settled(nCellCount,0);
+
+	//binary heap with lazy deletion: a cell can be pushed several times, only the entry matching its cost is used
+	struct Candidate
+	{
+		double cost;
+		unsigned int position;
+		PYXIcosIndex index;
+
+		Candidate(double aCost,unsigned int aPosition,const PYXIcosIndex & anIndex) : cost(aCost), position(aPosition), index(anIndex) {}
+
+		bool operator > (const Candidate & other) const
+		{
+			return cost > other.cost;
+		}
+	};
+	std::priority_queue<Candidate,std::vector<Candidate>,std::greater<Candidate>> candidates;
+
+	const unsigned int nSource = PYXIcosMath::calcCellPosition(root,source);
+	costs[nSource] = 0;
+	candidates.push(Candidate(0,nSource,source));
+
+	unsigned int nTarget = knNoCell;
+
+	while(!candidates.empty())
+	{
+		const Candidate current = candidates.top();
+		candidates.pop();
+
+		if (settled[current.position] || current.cost != costs[current.position])
+		{
+			continue;
+		}
+		settled[current.position] = 1;
+
+		if (isTargetFunction(current.index))
+		{
+			nTarget = current.position;
+			break;
+		}
+
+		PYXNeighbourIterator it(current.index);
+		for(it.next();!it.end();it.next())
+		{
+			const PYXIcosIndex & neighbour = it.getIndex();
+			if (!bounds.hasIndex(neighbour))
+			{
+				continue;
+			}
+			const unsigned int nPosition = PYXIcosMath::calcCellPosition(root,neighbour);
+			if (settled[nPosition])
+			{
+				continue;
+			}
+			const double totalCost = costAggregationFunction(current.cost,moveCost(current.index,neighbour,nPosition));
+			if (totalCost < costs[nPosition])
+			{
+				costs[nPosition] = totalCost;
+				sources[nPosition] = current.position;
+				candidates.push(Candidate(totalCost,nPosition,neighbour));
+			}
+		}
+	}
+
+	if (nTarget == knNoCell)
+	{
+		return PYXEmptyIterator::create();
+	}
+
+	std::list<std::pair<PYXIcosIndex,PYXValue>> way;
+
+	for(unsigned int nPosition = nTarget;nPosition != nSource;nPosition = sources[nPosition])
+	{
+		way.push_front(std::make_pair(PYXIcosMath::calcIndexFromOffset(root,bounds.getCellResolution(),nPosition),PYXValue(costs[nPosition])));
+	}
+
+	way.push_front(std::make_pair(source,PYXValue(0.0)));
+
+	return PYXIteratorLinq::fromList(way);
+}
+
+}
+
+PYXIteratorLinq PYXIteratorLinq::findShortestPath(	const PYXTile & bounds,
+													const PYXIcosIndex & source,
+													const boost::function<bool(const PYXIcosIndex &)> & isTargetFunction ,
+													const boost::function<double(const PYXIcosIndex &,const PYXIcosIndex &)> & costFunction,
+													const boost::function<double(double,double)> & costAggregationFunction )
+{
+	if (!bounds.hasIndex(source))
+	{
+		return PYXEmptyIterator::create();
+	}
+
+	return findShortestPathInTile(bounds,source,isTargetFunction,EdgeMoveCost(costFunction),costAggregationFunction);
+}
+
+PYXIteratorLinq PYXIteratorLinq::findShortestPathByCellCost(	const PYXTile & bounds,
+																const PYXIcosIndex & source,
+																const boost::function<bool(const PYXIcosIndex &)> & isTargetFunction ,
+																const boost::function<void(const PYXTile &,std::vector<double> &)> & tileCostFunction,
+																const boost::function<double(double,double)> & costAggregationFunction )
+{
+	if (!bounds.hasIndex(source))
+	{
+		return PYXEmptyIterator::create();
+	}
+
+	return findShortestPathInTile(bounds,source,isTargetFunction,CellMoveCost(bounds,tileCostFunction),costAggregationFunction);
+}
+
 PYXPointer<PYXGeometry> PYXIteratorLinq::toGeometry()
 {
 	PYXPointer<PYXTileCollection> tileCollection = PYXTileCollection::create();
@@ -1204,8 +1519,112 @@ public:
 		return PYXIteratorLinq::fromNeighboursWithoutSelf(index);
 	}
 
+	//! unit cost inside the tile, leaving the tile is expensive so the unbounded search stays inside it
+	static double tileCost(const PYXTile & tile,const PYXIcosIndex & from,const PYXIcosIndex & to)
+	{
+		return tile.hasIndex(to) ? 1.0 : 1000.0;
+	}
+
+	//! unit cost for every cell of the tile
+	static void tileCellCosts(const PYXTile & tile,std::vector<double> & costs)
+	{
+		std::fill(costs.begin(),costs.end(),1.0);
+	}
+
+	static double sumCost(double total,double move)
+	{
+		return total + move;
+	}
+
+	static bool isIndex(const PYXIcosIndex & target,const PYXIcosIndex & index)
+	{
+		return index == target;
+	}
+
+	static bool canFlood(const PYXIcosIndex & from,const PYXIcosIndex & to)
+	{
+		return true;
+	}
+
+	static bool isInTile(const PYXTile & tile,const PYXIcosIndex & from,const PYXIcosIndex & to)
+	{
+		return tile.hasIndex(to);
+	}
+
+	static void testTileSearch()
+	{
+		PYXTile tile(PYXIcosIndex("A-0"),7);
+		PYXIcosIndex source = PYXIcosMath::calcIndexFromOffset(tile.getRootIndex(),tile.getCellResolution(),0);
+		PYXIcosIndex target = PYXIcosMath::calcIndexFromOffset(tile.getRootIndex(),tile.getCellResolution(),tile.getCellCount()-1);
+
+		PYXValue unboundedCost = PYXIteratorLinq::findShortestPath(source,boost::bind(isIndex,target,_1),boost::bind(tileCost,tile,_1,_2),sumCost).max();
+		PYXValue boundedCost = PYXIteratorLinq::findShortestPath(tile,source,boost::bind(isIndex,target,_1),boost::bind(tileCost,tile,_1,_2),sumCost).max();
+		TEST_ASSERT_EQUAL(boundedCost.getDouble(),unboundedCost.getDouble());
+
+		int nSteps = PYXIteratorLinq::findShortestPath(tile,source,boost::bind(isIndex,target,_1),boost::bind(tileCost,tile,_1,_2),sumCost).count().getInt();
+		TEST_ASSERT_EQUAL(nSteps,(int)boundedCost.getDouble()+1);
+		TEST_ASSERT_EQUAL(PYXIteratorLinq::findShortestPath(tile,source,boost::bind(isIndex,target,_1),boost::bind(tileCost,tile,_1,_2),sumCost).firstIndex(),source);
+
+		//the cell costs of the tile give the same path cost as the move costs
+		PYXValue cellCost = PYXIteratorLinq::findShortestPathByCellCost(tile,source,boost::bind(isIndex,target,_1),tileCellCosts,sumCost).max();
+		TEST_ASSERT_EQUAL(cellCost.getDouble(),boundedCost.getDouble());
+		TEST_ASSERT_EQUAL(PYXIteratorLinq::findShortestPathByCellCost(tile,source,boost::bind(isIndex,target,_1),tileCellCosts,sumCost).count().getInt(),nSteps);
+
+		//a target outside the tile can not be found
+		PYXIcosIndex outside("B-0");
+		outside.setResolution(7);
+		TEST_ASSERT_EQUAL(PYXIteratorLinq::findShortestPath(tile,source,boost::bind(isIndex,outside,_1),boost::bind(tileCost,tile,_1,_2),sumCost).count().getInt(),0);
+		TEST_ASSERT_EQUAL(PYXIteratorLinq::findShortestPathByCellCost(tile,source,boost::bind(isIndex,outside,_1),tileCellCosts,sumCost).count().getInt(),0);
+
+		//flood fill covers the tile exactly once
+		TEST_ASSERT_EQUAL(PYXIteratorLinq::fromIndex(source).floodFill(tile,canFlood).count().getInt(),tile.getCellCount());
+		TEST_ASSERT_EQUAL(PYXIteratorLinq::fromIndex(outside).floodFill(tile,canFlood).count().getInt(),0);
+		TEST_ASSERT(PYXIteratorLinq::fromIndex(source).floodFill(tile,canFlood).toGeometry()->contains(tile));
+	}
+
+	static void benchmarkTileSearch()
+	{
+		PYXIcosIndex root("A-0");
+		root.setResolution(8);
+		PYXTile tile(root,16);
+		PYXIcosIndex source = PYXIcosMath::calcIndexFromOffset(tile.getRootIndex(),tile.getCellResolution(),0);
+		PYXIcosIndex target = PYXIcosMath::calcIndexFromOffset(tile.getRootIndex(),tile.getCellResolution(),tile.getCellCount()-1);
+
+		PYXHighQualityTimer timer;
+
+		timer.start();
+		PYXValue unboundedCost = PYXIteratorLinq::findShortestPath(source,boost::bind(isIndex,target,_1),boost::bind(tileCost,tile,_1,_2),sumCost).max();
+		timer.stop();
+		double unboundedTime = timer.getTime();
+
+		timer.start();
+		PYXValue boundedCost = PYXIteratorLinq::findShortestPath(tile,source,boost::bind(isIndex,target,_1),boost::bind(tileCost,tile,_1,_2),sumCost).max();
+		timer.stop();
+		double boundedTime = timer.getTime();
+
+		timer.start();
+		PYXValue cellCost = PYXIteratorLinq::findShortestPathByCellCost(tile,source,boost::bind(isIndex,target,_1),tileCellCosts,sumCost).max();
+		timer.stop();
+		double cellCostTime = timer.getTime();
+
+		timer.start();
+		int nUnboundedCount = PYXIteratorLinq::fromIndex(source).floodFill(boost::bind(isInTile,tile,_1,_2)).count().getInt();
+		timer.stop();
+		double unboundedFloodTime = timer.getTime();
+
+		timer.start();
+		int nBoundedCount = PYXIteratorLinq::fromIndex(source).floodFill(tile,canFlood).count().getInt();
+		timer.stop();
+		double boundedFloodTime = timer.getTime();
+
+		TRACE_INFO("findShortestPath on a " << tile.getCellCount() << " cells res 16 tile: map " << unboundedTime << "[sec], flat arrays " << boundedTime << "[sec], cell costs of the tile " << cellCostTime << "[sec] (cost " << unboundedCost.getDouble() << ", " << boundedCost.getDouble() << ", " << cellCost.getDouble() << ")");
+		TRACE_INFO("floodFill on a " << tile.getCellCount() << " cells res 16 tile: tile collection " << unboundedFloodTime << "[sec] (" << nUnboundedCount << " cells), flat arrays " << boundedFloodTime << "[sec] (" << nBoundedCount << " cells)");
+	}
+
 	static void test()
 	{
+		testTileSearch();
+
 		std::list<std::pair<PYXIcosIndex,PYXValue>> indicesAndValues;
 
 		indicesAndValues.push_back(std::make_pair(PYXIcosIndex("A-000000"),PYXValue(1)));
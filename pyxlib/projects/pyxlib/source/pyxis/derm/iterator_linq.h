@@ -152,8 +152,43 @@ public:
 		const boost::function<double(const PYXIcosIndex &,const PYXIcosIndex &)> & costFunction,
 		const boost::function<double(double,double)> & costAggregationFunction);
 
+	/*!
+	find the shortest path from a source cell to any matching target cell, limited to the cells of the given tile.
+
+	The search state is kept in flat arrays indexed by the cell position in the tile,
+	which is much faster than the unbounded search for large searches. Cells outside
+	the tile are never visited.
+	*/
+	static PYXIteratorLinq findShortestPath(
+		const PYXTile & bounds,
+		const PYXIcosIndex & source,
+		const boost::function<bool(const PYXIcosIndex &)> & isTargetFunction ,
+		const boost::function<double(const PYXIcosIndex &,const PYXIcosIndex &)> & costFunction,
+		const boost::function<double(double,double)> & costAggregationFunction);
+
+	/*!
+	find the shortest path from a source cell to any matching target cell, limited to the cells of the given tile,
+	where moving into a cell costs the cost of that cell.
+
+	The costs of all the cells of the tile are evaluated by a single call of tileCostFunction, which fills
+	a vector indexed by the cell position in the tile (already sized to the tile cell count), instead of
+	calling a cost function for every move.
+	*/
+	static PYXIteratorLinq findShortestPathByCellCost(
+		const PYXTile & bounds,
+		const PYXIcosIndex & source,
+		const boost::function<bool(const PYXIcosIndex &)> & isTargetFunction ,
+		const boost::function<void(const PYXTile &,std::vector<double> &)> & tileCostFunction,
+		const boost::function<double(double,double)> & costAggregationFunction);
+
+	//! Compare the tile bounded searches with the unbounded ones on a res 16 tile (not run by the tests).
+	static void benchmark();
+
 	PYXIteratorLinq floodFill(const boost::function< bool (const PYXIcosIndex &,const PYXIcosIndex &) > & canFloodFunction );
 
+	//! flood fill limited to the cells of the given tile, source cells outside the tile are ignored.
+	PYXIteratorLinq floodFill(const PYXTile & bounds,const boost::function< bool (const PYXIcosIndex &,const PYXIcosIndex &) > & canFloodFunction );
+
 //filter functions
 public:
 	PYXIteratorLinq filter(const boost::function< bool (const PYXIcosIndex &) > & filterFunc ) const;
@@ -0,0 +1,944 @@
+/******************************************************************************
+tile_range_set.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/derm/tile_range_set.h"
+
+#include "pyxis/derm/exceptions.h"
+#include "pyxis/derm/index_math.h"
+#include "pyxis/derm/sub_index_math.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+#include "pyxis/utility/trace.h"
+
+// boost includes
+#include <boost/bind.hpp>
+
+// standard includes
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+
+//! The number of digits in the high part of a key (after the root).
+const int knHighDigitCount = 19;
+
+//! The number of digits in the low part of a key.
+const int knLowDigitCount = knMaxDigits - knHighDigitCount;
+
+//! The number of roots (12 vertices and 20 faces).
+const unsigned int knRootCount = 32;
+
+//! The number of vertex roots.
+const unsigned int knVertexRootCount = 12;
+
+//! The version of the serialization format.
+const char kcSerializationVersion = 1;
+
+//! The powers of 7, up to 7^knLowDigitCount.
+const boost::uint64_t knPow7[knLowDigitCount + 1] =
+{
+	1ULL,
+	7ULL,
+	49ULL,
+	343ULL,
+	2401ULL,
+	16807ULL,
+	117649ULL,
+	823543ULL,
+	5764801ULL,
+	40353607ULL,
+	282475249ULL,
+	1977326743ULL,
+	13841287201ULL,
+	96889010407ULL,
+	678223072849ULL,
+	4747561509943ULL,
+	33232930569601ULL,
+	232630513987207ULL,
+	1628413597910449ULL,
+	11398895185373143ULL,
+	79792266297612001ULL,
+	558545864083284007ULL
+};
+
+typedef PYXTileRangeSet::Key Key;
+typedef PYXTileRangeSet::Range Range;
+
+//! Convert the primary resolution of an index to a root (same order as PYXTileSet).
+unsigned int getRootIndex(int nPrimaryResolution)
+{
+	if (nPrimaryResolution <= PYXIcosIndex::knLastVertex)
+	{
+		assert(nPrimaryResolution >= PYXIcosIndex::knFirstVertex);
+		return nPrimaryResolution - PYXIcosIndex::knFirstVertex;
+	}
+	return nPrimaryResolution - PYXIcosIndex::kcFaceFirstChar + knVertexRootCount;
+}
+
+//! Convert a root to the primary resolution of an index.
+int getPrimaryResolution(unsigned int nRoot)
+{
+	if (nRoot < knVertexRootCount)
+	{
+		return nRoot + PYXIcosIndex::knFirstVertex;
+	}
+	return nRoot - knVertexRootCount + PYXIcosIndex::kcFaceFirstChar;
+}
+
+//! The first key of a root.
+inline Key getRootKey(unsigned int nRoot)
+{
+	return Key(nRoot * knPow7[knHighDigitCount], 0);
+}
+
+//! Return the key following the tile of nDigits digits starting at the key.
+inline Key nextTile(const Key& key, int nDigits)
+{
+	if (nDigits <= knHighDigitCount)
+	{
+		return Key(key.nHigh + knPow7[knHighDigitCount - nDigits], key.nLow);
+	}
+	Key next(key.nHigh, key.nLow + knPow7[knMaxDigits - nDigits]);
+	if (next.nLow >= knPow7[knLowDigitCount])
+	{
+		next.nLow -= knPow7[knLowDigitCount];
+		++next.nHigh;
+	}
+	return next;
+}
+
+//! Return true if the key is the first key of a tile of nDigits digits.
+inline bool isTileKey(const Key& key, int nDigits)
+{
+	if (nDigits <= knHighDigitCount)
+	{
+		return key.nLow == 0 && key.nHigh % knPow7[knHighDigitCount - nDigits] == 0;
+	}
+	return key.nLow % knPow7[knMaxDigits - nDigits] == 0;
+}
+
+//! Unpack the digits of a key, returning its root.
+unsigned int unpackKey(const Key& key, int* pnDigits)
+{
+	boost::uint64_t nLow = key.nLow;
+	for (int n = knMaxDigits - 1; n >= knHighDigitCount; --n)
+	{
+		pnDigits[n] = static_cast<int>(nLow % 7);
+		nLow /= 7;
+	}
+	boost::uint64_t nHigh = key.nHigh;
+	for (int n = knHighDigitCount - 1; n >= 0; --n)
+	{
+		pnDigits[n] = static_cast<int>(nHigh % 7);
+		nHigh /= 7;
+	}
+	return static_cast<unsigned int>(nHigh);
+}
+
+//! Get the key of an index, and its number of digits.
+Key getKey(const PYXIcosIndex& index, int* pnDigits)
+{
+	if (index.isNull())
+	{
+		PYXTHROW(PYXIndexException, "Null index in a tile range set.");
+	}
+
+	const PYXIndex& subIndex = index.getSubIndex();
+	const int nDigits = subIndex.getDigitCount();
+	assert(nDigits <= knMaxDigits);
+
+	Key key(getRootIndex(index.getPrimaryResolution()), 0);
+	for (int n = 0; n < knHighDigitCount; ++n)
+	{
+		key.nHigh = key.nHigh * 7 + (n < nDigits ? subIndex.getDigit(n) : 0);
+	}
+	for (int n = knHighDigitCount; n < knMaxDigits; ++n)
+	{
+		key.nLow = key.nLow * 7 + (n < nDigits ? subIndex.getDigit(n) : 0);
+	}
+
+	*pnDigits = nDigits;
+	return key;
+}
+
+//! Get the index of the tile of nDigits digits starting at the key.
+PYXIcosIndex getIndex(const Key& key, int nDigits)
+{
+	int pnDigits[knMaxDigits];
+	unsigned int nRoot = unpackKey(key, pnDigits);
+
+	PYXIcosIndex index;
+	index.setPrimaryResolution(getPrimaryResolution(nRoot));
+	for (int n = 0; n < nDigits; ++n)
+	{
+		index.getSubIndex().appendDigit(pnDigits[n]);
+	}
+	return index;
+}
+
+/*!
+Return true if the tile of nDigits digits starting at the key is a valid cell.
+
+The children of a face are its centroid child, the children of a vertex child
+are its centroid child, and a pentagon has no child in its gap direction.
+*/
+bool isValidTile(const Key& key, int nDigits)
+{
+	int pnDigits[knMaxDigits];
+	unsigned int nRoot = unpackKey(key, pnDigits);
+	const bool bVertex = nRoot < knVertexRootCount;
+
+	// True while the tile is a pentagon (a vertex and centroid children).
+	bool bPentagon = bVertex;
+	int nPrevious = 0;
+	for (int n = 0; n < nDigits; ++n)
+	{
+		const int nDigit = pnDigits[n];
+		if (nDigit != 0)
+		{
+			if ((n == 0 && !bVertex) || nPrevious != 0)
+			{
+				return false;
+			}
+			if (bPentagon &&
+				!PYXIcosMath::isValidDirection(
+					getPrimaryResolution(nRoot),
+					static_cast<PYXMath::eHexDirection>(nDigit)))
+			{
+				return false;
+			}
+			bPentagon = false;
+		}
+		nPrevious = nDigit;
+	}
+	return true;
+}
+
+/*!
+Call a function on the largest tiles covering a range, in order, until it
+returns false. The function is called with the first key of the tile and its
+number of digits.
+*/
+template <typename Func>
+void forEachTile(const Range& range, Func func)
+{
+	Key key = range.begin;
+	while (key < range.end)
+	{
+		int nDigits = 0;
+		while (!isTileKey(key, nDigits) || range.end < nextTile(key, nDigits))
+		{
+			++nDigits;
+		}
+		if (!func(key, nDigits))
+		{
+			return;
+		}
+		key = nextTile(key, nDigits);
+	}
+}
+
+//! Return true if some keys of the range are valid cells.
+bool hasValidCell(const Range& range)
+{
+	// A valid tile has valid descendants, so it is enough to check the largest
+	// tiles covering the range.
+	bool bValid = false;
+	forEachTile(range, [&bValid] (const Key& key, int nDigits) -> bool
+	{
+		bValid = isValidTile(key, nDigits);
+		return !bValid;
+	});
+	return bValid;
+}
+
+//! Return the first key of a valid cell not before the key (or the end of the keys).
+Key getNextValidKey(const Key& key)
+{
+	Key next = getRootKey(knRootCount);
+	forEachTile(Range(key, next), [&next] (const Key& tileKey, int nDigits) -> bool
+	{
+		if (isValidTile(tileKey, nDigits))
+		{
+			next = tileKey;
+			return false;
+		}
+		return true;
+	});
+	return next;
+}
+
+//! Order ranges by their end.
+bool endLess(const Range& lhs, const Range& rhs)
+{
+	return lhs.end < rhs.end;
+}
+
+//! Order ranges by their begin.
+bool beginLess(const Range& lhs, const Range& rhs)
+{
+	return lhs.begin < rhs.begin;
+}
+
+void writeCount(std::basic_ostream<char>& out, boost::uint64_t nCount)
+{
+	while (nCount >= 0x80)
+	{
+		out.put(static_cast<char>((nCount & 0x7F) | 0x80));
+		nCount >>= 7;
+	}
+	out.put(static_cast<char>(nCount));
+}
+
+boost::uint64_t readCount(std::basic_istream<char>& in)
+{
+	boost::uint64_t nCount = 0;
+	for (int nShift = 0; nShift < 64; nShift += 7)
+	{
+		char c;
+		if (!in.get(c))
+		{
+			PYXTHROW(PYXIndexException, "Unexpected end of a tile range set stream.");
+		}
+		nCount |= static_cast<boost::uint64_t>(c & 0x7F) << nShift;
+		if (0 == (c & 0x80))
+		{
+			return nCount;
+		}
+	}
+	PYXTHROW(PYXIndexException, "Invalid count in a tile range set stream.");
+}
+
+//! Write a key as a difference from a preceding key.
+void writeKey(std::basic_ostream<char>& out, const Key& previous, const Key& key)
+{
+	assert(previous <= key);
+	const boost::uint64_t nHigh = key.nHigh - previous.nHigh;
+	writeCount(out, nHigh);
+	writeCount(out, nHigh == 0 ? key.nLow - previous.nLow : key.nLow);
+}
+
+//! Read a key written by writeKey().
+Key readKey(std::basic_istream<char>& in, const Key& previous)
+{
+	const boost::uint64_t nHigh = readCount(in);
+	const boost::uint64_t nLow = readCount(in);
+	return nHigh == 0 ? Key(previous.nHigh, previous.nLow + nLow) : Key(previous.nHigh + nHigh, nLow);
+}
+
+}
+
+//! The unit test class
+Tester<PYXTileRangeSet> gTester;
+
+namespace
+{
+
+//! Create a random valid index on a face.
+PYXIcosIndex createRandomIndex(int nDigits)
+{
+	PYXIcosIndex index;
+	index.setPrimaryResolution(PYXIcosIndex::kcFaceFirstChar + rand() % 20);
+	int nPrevious = 0;
+	for (int n = 0; n < nDigits; ++n)
+	{
+		const int nDigit = (n == 0 || nPrevious != 0) ? 0 : rand() % 7;
+		index.getSubIndex().appendDigit(nDigit);
+		nPrevious = nDigit;
+	}
+	return index;
+}
+
+//! Create a tile set of random tiles.
+void createRandomTiles(PYXTileSet& set, int nCount, int nMinDigits, int nMaxDigits)
+{
+	for (int n = 0; n < nCount; ++n)
+	{
+		set.insert(createRandomIndex(nMinDigits + rand() % (nMaxDigits - nMinDigits + 1)), false);
+	}
+}
+
+}
+
+//! Test method
+void PYXTileRangeSet::test()
+{
+	// The ranges of tiles.
+	{
+		Range range = getRange(PYXIcosIndex("A"));
+		TEST_ASSERT(range.begin == getRootKey(getRootIndex('A')));
+		TEST_ASSERT(range.end == getRootKey(getRootIndex('B')));
+		TEST_ASSERT(getRange(PYXIcosIndex("T")).end == getRootKey(knRootCount));
+
+		// "A-1" is not a valid cell, so the end of "A-0" is moved to "B".
+		TEST_ASSERT(getRange(PYXIcosIndex("A-0")).end == range.end);
+		TEST_ASSERT(!isValidTile(nextTile(getRange(PYXIcosIndex("A-06")).begin, 2), 1));
+		TEST_ASSERT(getNextValidKey(range.end) == range.end);
+
+		// The ranges of descendants are nested.
+		Range child = getRange(PYXIcosIndex("A-0302"));
+		TEST_ASSERT(range.begin <= child.begin && child.end <= range.end);
+
+		// Beyond the high part of the key.
+		PYXIcosIndex index("A-0");
+		for (int n = 1; n < knMaxDigits; ++n)
+		{
+			index.getSubIndex().appendDigit(n % 2 == 0 ? 0 : 4);
+		}
+		Range deep = getRange(index);
+		TEST_ASSERT(range.begin <= deep.begin && deep.end <= range.end);
+		TEST_ASSERT(nextTile(deep.begin, knMaxDigits) == deep.end);
+		TEST_ASSERT(getIndex(deep.begin, knMaxDigits) == index);
+	}
+
+	// The children of a hexagon coalesce into the range of the hexagon.
+	{
+		PYXTileRangeSet set;
+		for (int nDigit = 6; nDigit >= 0; --nDigit)
+		{
+			PYXIcosIndex index("A-03");
+			index.getSubIndex().appendDigit(nDigit);
+			set.insert(index);
+		}
+		PYXTileRangeSet hexagon;
+		hexagon.insert(PYXIcosIndex("A-03"));
+		TEST_ASSERT(set.getRanges().size() == 1);
+		TEST_ASSERT(set == hexagon);
+		TEST_ASSERT(set.contains(PYXIcosIndex("A-03")));
+		TEST_ASSERT(!set.contains(PYXIcosIndex("A-0")));
+
+		// "A" has the only child "A-0".
+		hexagon.insert(PYXIcosIndex("A-0"));
+		TEST_ASSERT(hexagon.contains(PYXIcosIndex("A")));
+	}
+
+	// The only child of a vertex child covers it.
+	{
+		PYXTileRangeSet set;
+		set.insert(PYXIcosIndex("M-010"));
+		TEST_ASSERT(set.contains(PYXIcosIndex("M-01")));
+		TEST_ASSERT(set.contains(PYXIcosIndex("M-0100")));
+		TEST_ASSERT(!set.contains(PYXIcosIndex("M-0")));
+		TEST_ASSERT(set.intersects(PYXIcosIndex("M-0")));
+		TEST_ASSERT(!set.intersects(PYXIcosIndex("M-02")));
+
+		// The invalid keys between vertex children are skipped.
+		set.insert(PYXIcosIndex("M-020"));
+		TEST_ASSERT(set.getRanges().size() == 1);
+	}
+
+	// The valid children of a pentagon cover it.
+	{
+		PYXTileRangeSet set;
+		set.insert(PYXIcosIndex("1-00"));
+		int nChildren = 1;
+		for (int nDigit = 1; nDigit <= 6; ++nDigit)
+		{
+			if (PYXIcosMath::isValidDirection(1, static_cast<PYXMath::eHexDirection>(nDigit)))
+			{
+				PYXIcosIndex index("1-0");
+				index.getSubIndex().appendDigit(nDigit);
+				set.insert(index);
+				++nChildren;
+			}
+		}
+		TEST_ASSERT(nChildren == 6);
+		TEST_ASSERT(set.contains(PYXIcosIndex("1-0")));
+		TEST_ASSERT(set.getRanges().size() == 1);
+	}
+
+	// Conversion from and to a tile set (the same tiles as the test of PYXTileSet).
+	{
+		const char* pcTiles[] =
+		{
+			"3-2", "3-30", "4-2", "M-02", "M-0302", "M-0303004",
+			"M-050", "M-060002", "M-060010", "M-0600503", "M-0600504"
+		};
+		PYXTileSet set;
+		for (int n = 0; n < sizeof(pcTiles) / sizeof(pcTiles[0]); ++n)
+		{
+			set.insert(PYXIcosIndex(pcTiles[n]), false);
+		}
+
+		PYXTileRangeSet ranges(set);
+		for (int n = 0; n < sizeof(pcTiles) / sizeof(pcTiles[0]); ++n)
+		{
+			TEST_ASSERT(ranges.contains(PYXIcosIndex(pcTiles[n])));
+		}
+		TEST_ASSERT(ranges.contains(PYXIcosIndex("M-06000203")));
+		TEST_ASSERT(!ranges.contains(PYXIcosIndex("M-060")));
+		TEST_ASSERT(!ranges.contains(PYXIcosIndex("M-0600")));
+		TEST_ASSERT(ranges.intersects(PYXIcosIndex("M-0600")));
+
+		// Unlike the tree, the ranges contain "M-05", which has the only child "M-050".
+		TEST_ASSERT(ranges.contains(PYXIcosIndex("M-05")));
+
+		// The tile set is converted to the largest tiles, covering the same cells.
+		PYXTileSet converted;
+		ranges.toTileSet(converted, false);
+		TEST_ASSERT(converted.contains(PYXIcosIndex("M-05")));
+		TEST_ASSERT(PYXTileRangeSet(converted) == ranges);
+
+		// Serialize.
+		std::stringstream stream;
+		ranges.serialize(stream);
+		PYXTileRangeSet loaded(stream);
+		TEST_ASSERT(loaded == ranges);
+	}
+
+	// Set algebra, compared with the tree.
+	{
+		srand(43);
+		PYXTileSet a;
+		PYXTileSet b;
+		createRandomTiles(a, 400, 2, 5);
+		createRandomTiles(b, 400, 2, 5);
+
+		PYXTileRangeSet rangesA(a);
+		PYXTileRangeSet rangesB(b);
+
+		PYXTileRangeSet disjunction = rangesA.disjunction(rangesB);
+		PYXTileRangeSet intersection = rangesA.intersection(rangesB);
+		PYXTileRangeSet difference = rangesA.difference(rangesB);
+
+		TEST_ASSERT(disjunction == rangesA.disjunction(rangesB, true));
+		TEST_ASSERT(intersection == rangesA.intersection(rangesB, true));
+		TEST_ASSERT(difference == rangesA.difference(rangesB, true));
+		TEST_ASSERT(rangesA.difference(rangesA).empty());
+		TEST_ASSERT(rangesA.intersection(rangesA) == rangesA);
+
+		for (int n = 0; n < 4000; ++n)
+		{
+			PYXIcosIndex index = createRandomIndex(6);
+			const bool bA = a.contains(index);
+			const bool bB = b.contains(index);
+			TEST_ASSERT(rangesA.contains(index) == bA);
+			TEST_ASSERT(disjunction.contains(index) == (bA || bB));
+			TEST_ASSERT(intersection.contains(index) == (bA && bB));
+			TEST_ASSERT(difference.contains(index) == (bA && !bB));
+		}
+
+		// Compare the size of the serializations.
+		std::stringstream treeStream;
+		a.serialize(treeStream);
+		std::stringstream rangeStream;
+		rangesA.serialize(rangeStream);
+		TRACE_INFO("PYXTileRangeSet: " << a.count() << " tiles serialized in " << rangeStream.str().size() <<
+			" bytes (" << treeStream.str().size() << " bytes for the tree)");
+	}
+}
+
+void PYXTileRangeSet::benchmark()
+{
+	srand(44);
+	PYXTileSet a;
+	PYXTileSet b;
+	createRandomTiles(a, 100000, 8, 12);
+	createRandomTiles(b, 100000, 8, 12);
+
+	PYXHighQualityTimer timer;
+
+	timer.start();
+	PYXTileSet treeResult;
+	for (PYXTileSet::Iterator iTiles(a); !iTiles.end(); iTiles.next())
+	{
+		if (b.contains(*iTiles))
+		{
+			treeResult.insert(*iTiles, false);
+		}
+	}
+	for (PYXTileSet::Iterator iTiles(b); !iTiles.end(); iTiles.next())
+	{
+		if (a.contains(*iTiles))
+		{
+			treeResult.insert(*iTiles, false);
+		}
+	}
+	timer.stop();
+	double fTreeTime = timer.getTime();
+
+	PYXTileRangeSet rangesA(a);
+	PYXTileRangeSet rangesB(b);
+
+	timer.start();
+	PYXTileRangeSet result = rangesA.intersection(rangesB);
+	timer.stop();
+	double fSerialTime = timer.getTime();
+
+	timer.start();
+	PYXTileRangeSet parallelResult = rangesA.intersection(rangesB, true);
+	timer.stop();
+	double fParallelTime = timer.getTime();
+
+	assert(result == parallelResult);
+	assert(result == PYXTileRangeSet(treeResult));
+
+	TRACE_INFO("PYXTileRangeSet: intersection of " << a.count() << " and " << b.count() << " tiles in " <<
+		fTreeTime << "[sec] (tree), " << fSerialTime << "[sec] (ranges), " << fParallelTime << "[sec] (ranges, parallel)");
+}
+
+PYXTileRangeSet::PYXTileRangeSet(int nResolution) :
+	m_nResolution(nResolution)
+{
+}
+
+PYXTileRangeSet::PYXTileRangeSet(const PYXTileSet& set) :
+	m_nResolution(set.resolution())
+{
+	std::vector<Range> vRanges;
+	for (PYXTileSet::Iterator iTiles(set); !iTiles.end(); iTiles.next())
+	{
+		vRanges.push_back(getRange(*iTiles));
+	}
+
+	// The tree iterates the tiles depth first, which is already the order of the keys.
+	if (!std::is_sorted(vRanges.begin(), vRanges.end(), beginLess))
+	{
+		std::sort(vRanges.begin(), vRanges.end(), beginLess);
+	}
+
+	m_vRanges.reserve(vRanges.size());
+	for (std::vector<Range>::const_iterator it = vRanges.begin(); it != vRanges.end(); ++it)
+	{
+		append(m_vRanges, *it);
+	}
+}
+
+PYXTileRangeSet::PYXTileRangeSet(std::basic_istream<char>& in)
+{
+	char cVersion;
+	if (!in.get(cVersion) || cVersion != kcSerializationVersion)
+	{
+		PYXTHROW(PYXIndexException, "Unsupported tile range set stream.");
+	}
+	m_nResolution = static_cast<int>(readCount(in));
+
+	const boost::uint64_t nCount = readCount(in);
+	m_vRanges.reserve(static_cast<size_t>(nCount));
+	Key previous;
+	for (boost::uint64_t n = 0; n < nCount; ++n)
+	{
+		Range range;
+		range.begin = readKey(in, previous);
+		range.end = readKey(in, range.begin);
+		m_vRanges.push_back(range);
+		previous = range.end;
+	}
+}
+
+/*!
+Serialize to stream. The keys are written as differences from the preceding
+key, in a variable number of bytes.
+
+\param out	The stream.
+*/
+void PYXTileRangeSet::serialize(std::basic_ostream<char>& out) const
+{
+	out.put(kcSerializationVersion);
+	writeCount(out, m_nResolution);
+	writeCount(out, m_vRanges.size());
+
+	Key previous;
+	for (std::vector<Range>::const_iterator it = m_vRanges.begin(); it != m_vRanges.end(); ++it)
+	{
+		writeKey(out, previous, it->begin);
+		writeKey(out, it->begin, it->end);
+		previous = it->end;
+	}
+}
+
+/*!
+Convert to a tile set. Each range is inserted as the largest tiles it covers
+that are valid cells.
+
+\param set			The tile set (out).
+\param bAggregate	Aggregate the tiles in the tile set.
+*/
+void PYXTileRangeSet::toTileSet(PYXTileSet& set, bool bAggregate) const
+{
+	if (m_nResolution != 0)
+	{
+		set.setResolution(m_nResolution);
+	}
+	for (std::vector<Range>::const_iterator it = m_vRanges.begin(); it != m_vRanges.end(); ++it)
+	{
+		forEachTile(*it, [&set, bAggregate] (const Key& key, int nDigits) -> bool
+		{
+			if (isValidTile(key, nDigits))
+			{
+				set.insert(getIndex(key, nDigits), bAggregate);
+			}
+			return true;
+		});
+	}
+}
+
+/*!
+Insert a tile, coalescing it with the ranges it touches.
+
+\param index	The tile.
+*/
+void PYXTileRangeSet::insert(const PYXIcosIndex& index)
+{
+	Range range = getRange(index);
+	if (range.end <= range.begin)
+	{
+		return;
+	}
+
+	// The ranges overlapping or touching the tile.
+	std::vector<Range>::iterator itFirst =
+		std::lower_bound(m_vRanges.begin(), m_vRanges.end(), Range(range.begin, range.begin), endLess);
+	std::vector<Range>::iterator itLast =
+		std::upper_bound(itFirst, m_vRanges.end(), Range(range.end, range.end), beginLess);
+	if (itFirst != itLast)
+	{
+		range.begin = std::min(range.begin, itFirst->begin);
+		range.end = std::max(range.end, (itLast - 1)->end);
+	}
+	m_vRanges.insert(m_vRanges.erase(itFirst, itLast), range);
+}
+
+bool PYXTileRangeSet::intersects(const PYXIcosIndex& index) const
+{
+	const Range range = getRange(index);
+	for (std::vector<Range>::const_iterator it =
+			std::upper_bound(m_vRanges.begin(), m_vRanges.end(), Range(range.begin, range.begin), endLess);
+		it != m_vRanges.end() && it->begin < range.end; ++it)
+	{
+		if (hasValidCell(Range(std::max(it->begin, range.begin), std::min(it->end, range.end))))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool PYXTileRangeSet::contains(const PYXIcosIndex& index) const
+{
+	const Range range = getRange(index);
+
+	// The keys of the tile not covered by the ranges must not be valid cells.
+	Key key = range.begin;
+	for (std::vector<Range>::const_iterator it =
+			std::upper_bound(m_vRanges.begin(), m_vRanges.end(), Range(range.begin, range.begin), endLess);
+		it != m_vRanges.end() && it->begin < range.end; ++it)
+	{
+		if (key < it->begin && hasValidCell(Range(key, it->begin)))
+		{
+			return false;
+		}
+		key = it->end;
+		if (range.end <= key)
+		{
+			return true;
+		}
+	}
+	return !hasValidCell(Range(key, range.end));
+}
+
+PYXTileRangeSet PYXTileRangeSet::disjunction(const PYXTileRangeSet& other, bool bParallel) const
+{
+	return combine(other, knDisjunction, bParallel);
+}
+
+PYXTileRangeSet PYXTileRangeSet::intersection(const PYXTileRangeSet& other, bool bParallel) const
+{
+	return combine(other, knIntersection, bParallel);
+}
+
+PYXTileRangeSet PYXTileRangeSet::difference(const PYXTileRangeSet& other, bool bParallel) const
+{
+	return combine(other, knDifference, bParallel);
+}
+
+/*!
+Get the range of keys of a tile.
+
+\param index	The tile.
+
+\return The range.
+*/
+PYXTileRangeSet::Range PYXTileRangeSet::getRange(const PYXIcosIndex& index)
+{
+	int nDigits;
+	Key key = getKey(index, &nDigits);
+	return Range(getNextValidKey(key), getNextValidKey(nextTile(key, nDigits)));
+}
+
+PYXTileRangeSet PYXTileRangeSet::combine(const PYXTileRangeSet& other, eOperation nOperation, bool bParallel) const
+{
+	PYXTileRangeSet result(std::max(m_nResolution, other.m_nResolution));
+
+	if (!bParallel)
+	{
+		merge(	m_vRanges.data(), m_vRanges.data() + m_vRanges.size(),
+				other.m_vRanges.data(), other.m_vRanges.data() + other.m_vRanges.size(),
+				nOperation,
+				result.m_vRanges	);
+	}
+	else
+	{
+		// Each root is merged by its own task, then the results are concatenated.
+		std::vector<std::vector<Range> > vRootRanges(knRootCount);
+		{
+			PYXTaskGroup tasks;
+			for (unsigned int nRoot = 0; nRoot < knRootCount; ++nRoot)
+			{
+				tasks.addTask(boost::bind(
+					&PYXTileRangeSet::mergeRoot,
+					boost::cref(m_vRanges),
+					boost::cref(other.m_vRanges),
+					nRoot,
+					nOperation,
+					boost::ref(vRootRanges[nRoot])));
+			}
+			tasks.joinAll();
+		}
+		for (unsigned int nRoot = 0; nRoot < knRootCount; ++nRoot)
+		{
+			for (std::vector<Range>::const_iterator it = vRootRanges[nRoot].begin(); it != vRootRanges[nRoot].end(); ++it)
+			{
+				append(result.m_vRanges, *it);
+			}
+		}
+	}
+
+	return result;
+}
+
+/*!
+Merge the ranges of two sets within a root.
+
+\param vA			The ranges of the first set.
+\param vB			The ranges of the second set.
+\param nRoot		The root.
+\param nOperation	The operation.
+\param vResult		The ranges of the result within the root (out).
+*/
+void PYXTileRangeSet::mergeRoot(	const std::vector<Range>& vA,
+									const std::vector<Range>& vB,
+									unsigned int nRoot,
+									eOperation nOperation,
+									std::vector<Range>& vResult	)
+{
+	const Range root(getRootKey(nRoot), getRootKey(nRoot + 1));
+
+	// Clip the ranges of both sets to the root.
+	std::vector<Range> vClipped[2];
+	const std::vector<Range>* pvRanges[2] = {&vA, &vB};
+	for (int n = 0; n < 2; ++n)
+	{
+		for (std::vector<Range>::const_iterator it =
+				std::upper_bound(pvRanges[n]->begin(), pvRanges[n]->end(), Range(root.begin, root.begin), endLess);
+			it != pvRanges[n]->end() && it->begin < root.end; ++it)
+		{
+			vClipped[n].push_back(Range(std::max(it->begin, root.begin), std::min(it->end, root.end)));
+		}
+	}
+
+	merge(	vClipped[0].data(), vClipped[0].data() + vClipped[0].size(),
+			vClipped[1].data(), vClipped[1].data() + vClipped[1].size(),
+			nOperation,
+			vResult	);
+}
+
+/*!
+Merge the ranges of two sets with a boolean operation, by walking the bounds
+of the ranges of both sets in order.
+*/
+void PYXTileRangeSet::merge(	const Range* pA, const Range* pAEnd,
+								const Range* pB, const Range* pBEnd,
+								eOperation nOperation,
+								std::vector<Range>& vResult	)
+{
+	bool bInA = false;
+	bool bInB = false;
+	bool bInResult = false;
+	Key begin;
+
+	while (pA != pAEnd || pB != pBEnd)
+	{
+		// Nothing more can be in the result.
+		if ((pA == pAEnd && nOperation != knDisjunction) ||
+			(pB == pBEnd && nOperation == knIntersection))
+		{
+			break;
+		}
+
+		// The next bound of each set.
+		const Key* pNextA = (pA != pAEnd) ? (bInA ? &pA->end : &pA->begin) : 0;
+		const Key* pNextB = (pB != pBEnd) ? (bInB ? &pB->end : &pB->begin) : 0;
+		const Key key = (pNextB == 0 || (pNextA != 0 && *pNextA < *pNextB)) ? *pNextA : *pNextB;
+
+		if (pNextA != 0 && *pNextA == key)
+		{
+			if (bInA)
+			{
+				++pA;
+			}
+			bInA = !bInA;
+		}
+		if (pNextB != 0 && *pNextB == key)
+		{
+			if (bInB)
+			{
+				++pB;
+			}
+			bInB = !bInB;
+		}
+
+		bool bIn;
+		switch (nOperation)
+		{
+		case knDisjunction:
+			bIn = bInA || bInB;
+			break;
+		case knIntersection:
+			bIn = bInA && bInB;
+			break;
+		default:
+			bIn = bInA && !bInB;
+			break;
+		}
+
+		if (bIn != bInResult)
+		{
+			if (bIn)
+			{
+				begin = key;
+			}
+			else
+			{
+				append(vResult, Range(begin, key));
+			}
+			bInResult = bIn;
+		}
+	}
+}
+
+void PYXTileRangeSet::append(std::vector<Range>& vRanges, const Range& range)
+{
+	if (!vRanges.empty() && range.begin <= vRanges.back().end)
+	{
+		if (vRanges.back().end < range.end)
+		{
+			vRanges.back().end = range.end;
+		}
+	}
+	else
+	{
+		vRanges.push_back(range);
+	}
+}
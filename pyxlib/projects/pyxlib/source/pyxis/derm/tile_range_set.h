@@ -0,0 +1,178 @@
+#ifndef PYXIS__DERM__TILE_RANGE_SET_H
+#define PYXIS__DERM__TILE_RANGE_SET_H
+/******************************************************************************
+tile_range_set.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "pyxis/derm/index.h"
+#include "pyxis/derm/tile_set.h"
+
+// boost includes
+#include <boost/cstdint.hpp>
+
+// standard includes
+#include <iosfwd>
+#include <vector>
+
+/*!
+PYXTileRangeSet stores a set of tiles as sorted ranges of packed cell keys.
+
+\verbatim
+A cell key packs the root of an index and its sub index digits, padded with
+zeros to knMaxDigits digits, as a base 7 number:
+
+	high:	root (0-11 for the vertices 1-12, 12-31 for the faces 'A'-'T')
+			followed by the digits 0 to 18
+	low:	the digits 19 to 39
+\endverbatim
+
+A tile with n digits covers the keys [key, key + 7^(knMaxDigits - n)). The
+keys of the descendants of a tile are within the range of the tile, and the
+ranges of the children of a tile follow each other, so the tiles of a set are
+stored as disjoint ranges, sorted and coalesced, in a flat array.
+
+Union, intersection and difference are linear merges of the ranges. They can
+be run in parallel, one task per root.
+
+Some keys are not valid cells (the children of a vertex child other than its
+centroid, the gap of a pentagon). The bounds of the ranges are moved to the
+next valid cell, so the ranges of the tiles coalesce as the tiles do and two
+sets covering the same cells have the same ranges. The set algebra is exact on
+the valid cells.
+*/
+//! A set of tiles stored as sorted ranges of packed cell keys.
+class PYXLIB_DECL PYXTileRangeSet
+{
+public:
+
+	//! A packed cell key.
+	struct Key
+	{
+		boost::uint64_t nHigh;
+		boost::uint64_t nLow;
+
+		Key() : nHigh(0), nLow(0) {}
+		Key(boost::uint64_t nHigh, boost::uint64_t nLow) : nHigh(nHigh), nLow(nLow) {}
+
+		bool operator ==(const Key& rhs) const {return nHigh == rhs.nHigh && nLow == rhs.nLow;}
+		bool operator !=(const Key& rhs) const {return !(*this == rhs);}
+		bool operator <(const Key& rhs) const {return nHigh < rhs.nHigh || (nHigh == rhs.nHigh && nLow < rhs.nLow);}
+		bool operator <=(const Key& rhs) const {return !(rhs < *this);}
+	};
+
+	//! The keys [begin, end).
+	struct Range
+	{
+		Key begin;
+		Key end;
+
+		Range() {}
+		Range(const Key& begin, const Key& end) : begin(begin), end(end) {}
+
+		bool operator ==(const Range& rhs) const {return begin == rhs.begin && end == rhs.end;}
+	};
+
+	//! Test method.
+	static void test();
+
+	//! Time the intersection of two sets of 100000 tiles against the tree (not run by the tests).
+	static void benchmark();
+
+	//! Construct an empty set.
+	explicit PYXTileRangeSet(int nResolution = 0);
+
+	//! Construct from the tiles of a tile set.
+	explicit PYXTileRangeSet(const PYXTileSet& set);
+
+	//! Construct by deserializing from stream.
+	explicit PYXTileRangeSet(std::basic_istream<char>& in);
+
+	//! Serialize to stream.
+	void serialize(std::basic_ostream<char>& out) const;
+
+	//! Convert to a tile set, inserting the largest tiles covered by the ranges.
+	void toTileSet(PYXTileSet& set, bool bAggregate) const;
+
+	//! Insert a tile.
+	void insert(const PYXIcosIndex& index);
+
+	//! Return true if the set intersects the index.
+	bool intersects(const PYXIcosIndex& index) const;
+
+	//! Return true if the set contains the index.
+	bool contains(const PYXIcosIndex& index) const;
+
+	//! The tiles in this set or in the other.
+	PYXTileRangeSet disjunction(const PYXTileRangeSet& other, bool bParallel = false) const;
+
+	//! The tiles in this set and in the other.
+	PYXTileRangeSet intersection(const PYXTileRangeSet& other, bool bParallel = false) const;
+
+	//! The tiles in this set and not in the other.
+	PYXTileRangeSet difference(const PYXTileRangeSet& other, bool bParallel = false) const;
+
+	//! Get the resolution of the cells of the set (0 if not set).
+	int resolution() const {return m_nResolution;}
+
+	//! Set the resolution of the cells of the set.
+	void setResolution(int nResolution) {m_nResolution = nResolution;}
+
+	//! Returns true if empty.
+	bool empty() const {return m_vRanges.empty();}
+
+	//! Clear the set.
+	void clear() {m_vRanges.clear();}
+
+	//! Get the ranges, sorted and coalesced.
+	const std::vector<Range>& getRanges() const {return m_vRanges;}
+
+	//! Get the range of keys of a tile, its end moved to the next valid cell.
+	static Range getRange(const PYXIcosIndex& index);
+
+	bool operator ==(const PYXTileRangeSet& rhs) const {return m_vRanges == rhs.m_vRanges;}
+
+private:
+
+	//! The boolean operations of merge().
+	enum eOperation
+	{
+		knDisjunction,
+		knIntersection,
+		knDifference
+	};
+
+	//! Run a boolean operation on the sets, on all roots or one task per root.
+	PYXTileRangeSet combine(const PYXTileRangeSet& other, eOperation nOperation, bool bParallel) const;
+
+	//! Merge the ranges of two sets with a boolean operation, appending to vResult.
+	static void merge(	const Range* pA, const Range* pAEnd,
+						const Range* pB, const Range* pBEnd,
+						eOperation nOperation,
+						std::vector<Range>& vResult	);
+
+	//! Merge the ranges of two sets within a root.
+	static void mergeRoot(	const std::vector<Range>& vA,
+							const std::vector<Range>& vB,
+							unsigned int nRoot,
+							eOperation nOperation,
+							std::vector<Range>& vResult	);
+
+	//! Append a range, coalescing it with the last range if they touch.
+	static void append(std::vector<Range>& vRanges, const Range& range);
+
+private:
+
+	//! The ranges, sorted and coalesced.
+	std::vector<Range> m_vRanges;
+
+	//! The resolution of the cells (0 if not set).
+	int m_nResolution;
+};
+
+#endif // guard
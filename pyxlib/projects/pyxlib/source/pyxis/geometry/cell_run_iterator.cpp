@@ -0,0 +1,455 @@
+/******************************************************************************
+cell_run_iterator.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/geometry/cell_run_iterator.h"
+
+// pyxlib includes
+#include "pyxis/derm/child_iterator.h"
+#include "pyxis/derm/exhaustive_iterator.h"
+#include "pyxis/derm/index_math.h"
+#include "pyxis/geometry/cell.h"
+#include "pyxis/geometry/inner_tile.h"
+#include "pyxis/geometry/inner_tile_intersection_iterator.h"
+#include "pyxis/geometry/tile_collection.h"
+#include "pyxis/geometry/vector_geometry2.h"
+#include "pyxis/region/circle_region.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+// standard includes
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXCellRunIterator
+///////////////////////////////////////////////////////////////////////////////
+
+int PYXCellRunIterator::getTotalCellCount() const
+{
+	int nCount = 0;
+	for (unsigned int n = 0; n < m_runs.size(); ++n)
+	{
+		nCount += m_runs[n].second - m_runs[n].first;
+	}
+	return nCount;
+}
+
+/*!
+Add the cells of a geometry inside the tile.
+
+\param geometry		The geometry.
+\param bIntersect	Whether an unsupported geometry can be intersected with the tile.
+*/
+void PYXCellRunIterator::addGeometry(const PYXGeometry & geometry,bool bIntersect)
+{
+	if (geometry.isEmpty())
+	{
+		return;
+	}
+
+	if (geometry.getCellResolution() != m_tile.getCellResolution())
+	{
+		PYXPointer<PYXGeometry> spGeometry = geometry.clone();
+		spGeometry->setCellResolution(m_tile.getCellResolution());
+		if (spGeometry->getCellResolution() != m_tile.getCellResolution())
+		{
+			return;
+		}
+		addGeometry(*spGeometry,bIntersect);
+		return;
+	}
+
+	if (addKnownGeometry(geometry))
+	{
+		return;
+	}
+
+	if (bIntersect)
+	{
+		// the intersection is often a tile collection
+		PYXPointer<PYXGeometry> spIntersection = geometry.intersection(m_tile);
+		addGeometry(*spIntersection,false);
+		return;
+	}
+
+	// slow path: visit every cell
+	PYXPointer<PYXIterator> spIterator = geometry.getIterator();
+	addIterator(*spIterator);
+}
+
+bool PYXCellRunIterator::addKnownGeometry(const PYXGeometry & geometry)
+{
+	const PYXTileCollection* const pTileCollection = dynamic_cast<const PYXTileCollection*>(&geometry);
+	if (pTileCollection != 0)
+	{
+		for (PYXTileCollection::Iterator it(*pTileCollection); !it.end(); it.next())
+		{
+			addDescendants(*it);
+		}
+		return true;
+	}
+
+	const PYXVectorGeometry2* const pVectorGeometry = dynamic_cast<const PYXVectorGeometry2*>(&geometry);
+	if (pVectorGeometry != 0)
+	{
+		// the inner tile iterator returns complete tiles, or cells at the tile resolution
+		std::vector<PYXInnerTile> innerTiles = PYXInnerTile::createInnerTiles(m_tile);
+		for (unsigned int n = 0; n < innerTiles.size(); ++n)
+		{
+			for (PYXPointer<PYXInnerTileIntersectionIterator> spIterator = pVectorGeometry->getInnerTileIterator(innerTiles[n]);
+				!spIterator->end();
+				spIterator->next())
+			{
+				if (spIterator->getIntersection() != knIntersectionNone)
+				{
+					addDescendants(spIterator->getTile().asTile().getRootIndex());
+				}
+			}
+		}
+		return true;
+	}
+
+	const PYXTile* const pTile = dynamic_cast<const PYXTile*>(&geometry);
+	if (pTile != 0)
+	{
+		addDescendants(pTile->getRootIndex());
+		return true;
+	}
+
+	const PYXInnerTile* const pInnerTile = dynamic_cast<const PYXInnerTile*>(&geometry);
+	if (pInnerTile != 0)
+	{
+		addDescendants(pInnerTile->asTile().getRootIndex());
+		return true;
+	}
+
+	const PYXCell* const pCell = dynamic_cast<const PYXCell*>(&geometry);
+	if (pCell != 0)
+	{
+		addDescendants(pCell->getIndex());
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+Add the remaining cells of a cell iterator. The remaining cells of an exhaustive
+iterator are a single run, other iterators are visited cell by cell.
+
+\param iterator	The iterator (consumed).
+*/
+void PYXCellRunIterator::addIterator(PYXIterator & iterator)
+{
+	if (iterator.end())
+	{
+		return;
+	}
+
+	const PYXIcosIndex & root = m_tile.getRootIndex();
+	const int nResolution = m_tile.getCellResolution();
+
+	PYXExhaustiveIterator* pExhaustive = dynamic_cast<PYXExhaustiveIterator*>(&iterator);
+	if (pExhaustive != 0 && iterator.getIndex().getResolution() == nResolution)
+	{
+		const PYXIcosIndex & exhaustiveRoot = pExhaustive->getRootIndex();
+
+		if (root.isAncestorOf(exhaustiveRoot))
+		{
+			// the remaining cells of the iterator, all in the tile
+			PYXIcosIndex first(exhaustiveRoot);
+			first.setResolution(nResolution);
+			int nBegin = PYXIcosMath::calcCellPosition(root,iterator.getIndex());
+			int nEnd = PYXIcosMath::calcCellPosition(root,first) + PYXIcosMath::getCellCount(exhaustiveRoot,nResolution);
+			addRun(nBegin,nEnd);
+		}
+		else if (exhaustiveRoot.isAncestorOf(root))
+		{
+			// the cells of the tile, in the order of the iterator, clipped to the remaining cells
+			PYXIcosIndex first(root);
+			first.setResolution(nResolution);
+			int nTileBegin = PYXIcosMath::calcCellPosition(exhaustiveRoot,first);
+			int nCurrent = PYXIcosMath::calcCellPosition(exhaustiveRoot,iterator.getIndex());
+			addRun(std::max(nTileBegin,nCurrent) - nTileBegin,m_tile.getCellCount());
+		}
+
+		pExhaustive->setEnd();
+		return;
+	}
+
+	for (; !iterator.end(); iterator.next())
+	{
+		const PYXIcosIndex & index = iterator.getIndex();
+		if (m_tile.hasIndex(index))
+		{
+			int nOffset = PYXIcosMath::calcCellPosition(root,index);
+			if (!m_runs.empty() && m_runs.back().second == nOffset)
+			{
+				++m_runs.back().second;
+			}
+			else
+			{
+				addRun(nOffset,nOffset + 1);
+			}
+		}
+	}
+}
+
+/*!
+Add the descendants of an index at the tile resolution. The descendants of an
+ancestor of the tile root are the whole tile.
+
+\param index	The index.
+*/
+void PYXCellRunIterator::addDescendants(const PYXIcosIndex & index)
+{
+	const PYXIcosIndex & root = m_tile.getRootIndex();
+	const int nResolution = m_tile.getCellResolution();
+
+	if (index.getResolution() > nResolution)
+	{
+		return;
+	}
+
+	if (root.isAncestorOf(index))
+	{
+		PYXIcosIndex first(index);
+		first.setResolution(nResolution);
+		int nBegin = PYXIcosMath::calcCellPosition(root,first);
+		addRun(nBegin,nBegin + PYXIcosMath::getCellCount(index,nResolution));
+	}
+	else if (index.isAncestorOf(root))
+	{
+		addRun(0,m_tile.getCellCount());
+	}
+}
+
+void PYXCellRunIterator::addRun(int nBegin,int nEnd)
+{
+	if (nBegin < nEnd)
+	{
+		m_runs.push_back(std::make_pair(nBegin,nEnd));
+	}
+}
+
+void PYXCellRunIterator::mergeRuns()
+{
+	if (m_runs.empty())
+	{
+		return;
+	}
+
+	std::sort(m_runs.begin(),m_runs.end());
+
+	std::vector< std::pair<int,int> >::iterator itLast = m_runs.begin();
+	for (std::vector< std::pair<int,int> >::iterator it = m_runs.begin() + 1; it != m_runs.end(); ++it)
+	{
+		if (it->first <= itLast->second)
+		{
+			itLast->second = std::max(itLast->second,it->second);
+		}
+		else
+		{
+			*(++itLast) = *it;
+		}
+	}
+	m_runs.erase(itLast + 1,m_runs.end());
+	m_nCurrent = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Testing
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! Tester class
+Tester<PYXCellRunIterator> gTester;
+
+//! The offsets of the cells of an iterator in a tile, visiting every cell.
+std::vector<int> getCellOffsets(const PYXTile & tile,PYXIterator & iterator)
+{
+	std::vector<int> offsets;
+	for (; !iterator.end(); iterator.next())
+	{
+		if (tile.hasIndex(iterator.getIndex()))
+		{
+			offsets.push_back(PYXIcosMath::calcCellPosition(tile.getRootIndex(),iterator.getIndex()));
+		}
+	}
+	std::sort(offsets.begin(),offsets.end());
+	return offsets;
+}
+
+//! The offsets of the cells of the runs.
+std::vector<int> getRunOffsets(PYXCellRunIterator & runs)
+{
+	std::vector<int> offsets;
+	int nLastEnd = -1;
+	for (; !runs.end(); runs.next())
+	{
+		// sorted, disjoint and maximal
+		TEST_ASSERT(runs.getBegin() > nLastEnd);
+		nLastEnd = runs.getEnd();
+
+		for (int nOffset = runs.getBegin(); nOffset < runs.getEnd(); ++nOffset)
+		{
+			offsets.push_back(nOffset);
+		}
+	}
+	return offsets;
+}
+
+void testGeometry(const PYXTile & tile,const PYXGeometry & geometry)
+{
+	PYXPointer<PYXIterator> spCells = geometry.getIterator();
+	std::vector<int> expected = getCellOffsets(tile,*spCells);
+
+	PYXPointer<PYXCellRunIterator> spRuns = PYXCellRunIterator::create(tile,geometry);
+	TEST_ASSERT_EQUAL(spRuns->getTotalCellCount(),static_cast<int>(expected.size()));
+	TEST_ASSERT(getRunOffsets(*spRuns) == expected);
+}
+
+void testTile(const PYXTile & tile)
+{
+	const PYXIcosIndex & root = tile.getRootIndex();
+	const int nResolution = tile.getCellResolution();
+
+	// the tile itself, a child tile, an ancestor tile
+	testGeometry(tile,tile);
+
+	PYXChildIterator itChild(root);
+	itChild.next();
+	PYXTile childTile(itChild.getIndex(),nResolution);
+	testGeometry(tile,childTile);
+
+	PYXIcosIndex parent(root);
+	parent.decrementResolution();
+	testGeometry(tile,PYXTile(parent,nResolution));
+
+	// a circle around a cell of the tile: complete and partial inner tiles, and its tile collection
+	PYXIcosIndex center(itChild.getIndex());
+	center.setResolution(nResolution - 3);
+	PYXPointer<PYXVectorGeometry2> spCircle = PYXVectorGeometry2::create(PYXCircleRegion::create(center,true),nResolution);
+	testGeometry(tile,*spCircle);
+
+	PYXTileCollection collection;
+	spCircle->copyTo(&collection);
+	testGeometry(tile,collection);
+
+	// a collection at a lower resolution is converted to the tile resolution
+	PYXTileCollection coarseCollection;
+	spCircle->copyTo(&coarseCollection,nResolution - 1);
+	testGeometry(tile,coarseCollection);
+
+	// exhaustive iterators: over the tile, over a child, partially consumed, over an ancestor
+	{
+		PYXExhaustiveIterator itTile(root,nResolution);
+		TEST_ASSERT_EQUAL(PYXCellRunIterator::create(tile,itTile)->getRunCount(),1);
+		TEST_ASSERT(itTile.end());
+
+		PYXExhaustiveIterator itExpected(itChild.getIndex(),nResolution);
+		std::vector<int> expected = getCellOffsets(tile,itExpected);
+		PYXExhaustiveIterator itRuns(itChild.getIndex(),nResolution);
+		TEST_ASSERT(getRunOffsets(*PYXCellRunIterator::create(tile,itRuns)) == expected);
+
+		PYXExhaustiveIterator itPartialExpected(root,nResolution);
+		PYXExhaustiveIterator itPartialRuns(root,nResolution);
+		for (int n = 0; n < 10; ++n)
+		{
+			itPartialExpected.next();
+			itPartialRuns.next();
+		}
+		expected = getCellOffsets(tile,itPartialExpected);
+		TEST_ASSERT(getRunOffsets(*PYXCellRunIterator::create(tile,itPartialRuns)) == expected);
+
+		PYXExhaustiveIterator itParent(parent,nResolution);
+		PYXPointer<PYXCellRunIterator> spRuns = PYXCellRunIterator::create(tile,itParent);
+		TEST_ASSERT_EQUAL(spRuns->getTotalCellCount(),tile.getCellCount());
+	}
+
+	// the generic adapter
+	{
+		PYXPointer<PYXIterator> spExpected = spCircle->getIterator();
+		std::vector<int> expected = getCellOffsets(tile,*spExpected);
+		PYXPointer<PYXIterator> spIterator = spCircle->getIterator();
+		TEST_ASSERT(getRunOffsets(*PYXCellRunIterator::create(tile,*spIterator)) == expected);
+	}
+}
+
+}
+
+void PYXCellRunIterator::test()
+{
+	// a hexagon tile and a pentagon tile
+	testTile(PYXTile(PYXIcosIndex("1-20"),9));
+	testTile(PYXTile(PYXIcosIndex("A-00"),9));
+
+	// runs of an empty geometry
+	TEST_ASSERT(PYXCellRunIterator::create(PYXTile(PYXIcosIndex("1-20"),9),*PYXEmptyGeometry::create())->end());
+}
+
+void PYXCellRunIterator::benchmark()
+{
+	PYXTile tile(PYXIcosIndex("1-20"),14);
+	PYXIcosIndex center("1-20");
+	center.setResolution(9);
+	PYXPointer<PYXVectorGeometry2> spCircle = PYXVectorGeometry2::create(PYXCircleRegion::create(center,true),14);
+
+	PYXHighQualityTimer timer;
+
+	// cell by cell
+	timer.start();
+	PYXPointer<PYXGeometry> spIntersection = spCircle->intersection(tile);
+	PYXPointer<PYXIterator> spIterator = spIntersection->getIterator();
+	int nCellCount = 0;
+	long long nSum = 0;
+	for (; !spIterator->end(); spIterator->next())
+	{
+		nSum += PYXIcosMath::calcCellPosition(tile.getRootIndex(),spIterator->getIndex());
+		++nCellCount;
+	}
+	timer.stop();
+	double fCellTime = timer.getTime();
+
+	// runs
+	timer.start();
+	PYXPointer<PYXCellRunIterator> spRuns = PYXCellRunIterator::create(tile,*spCircle);
+	long long nRunSum = 0;
+	for (; !spRuns->end(); spRuns->next())
+	{
+		for (int nOffset = spRuns->getBegin(); nOffset < spRuns->getEnd(); ++nOffset)
+		{
+			nRunSum += nOffset;
+		}
+	}
+	timer.stop();
+	double fRunTime = timer.getTime();
+
+	TEST_ASSERT_EQUAL(spRuns->getTotalCellCount(),nCellCount);
+	TEST_ASSERT_EQUAL(nRunSum,nSum);
+
+	// exhaustive tile
+	timer.start();
+	PYXExhaustiveIterator itTile(tile.getRootIndex(),tile.getCellResolution());
+	int nTileCells = 0;
+	for (; !itTile.end(); itTile.next())
+	{
+		nTileCells += PYXIcosMath::calcCellPosition(tile.getRootIndex(),itTile.getIndex()) >= 0 ? 1 : 0;
+	}
+	timer.stop();
+	double fExhaustiveTime = timer.getTime();
+
+	TRACE_INFO("PYXCellRunIterator: circle of " << nCellCount << " cells in " << spRuns->getRunCount() << " runs, " <<
+		fCellTime * 1e9 / std::max(nCellCount,1) << "[ns/cell] visiting cells, " <<
+		fRunTime * 1e9 / std::max(nCellCount,1) << "[ns/cell] with runs. Exhaustive iterator: " <<
+		fExhaustiveTime * 1e9 / std::max(nTileCells,1) << "[ns/cell]");
+}
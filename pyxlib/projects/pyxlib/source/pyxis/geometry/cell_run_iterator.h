@@ -0,0 +1,171 @@
+#ifndef PYXIS__GEOMETRY__CELL_RUN_ITERATOR_H
+#define PYXIS__GEOMETRY__CELL_RUN_ITERATOR_H
+/******************************************************************************
+cell_run_iterator.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "pyxis/derm/iterator.h"
+#include "pyxis/geometry/geometry.h"
+#include "pyxis/geometry/tile.h"
+#include "pyxis/utility/abstract_iterator.h"
+#include "pyxis/utility/object.h"
+
+// standard includes
+#include <utility>
+#include <vector>
+
+/*!
+PYXCellRunIterator iterates over the cells of a geometry (or a cell iterator)
+that are inside a tile, as runs of consecutive cell offsets in the tile, the
+offsets being the positions in the standard PYXIS order (see
+PYXIcosMath::calcCellPosition and PYXValueTile).
+
+In the PYXIS order, the descendants of a cell at the tile resolution occupy a
+contiguous range of offsets, therefore a tile of a tile collection, a complete
+inner tile of a vector geometry or an exhaustive iterator is a single run and
+the runs are computed without visiting the cells:
+
+\verbatim
+PYXPointer<PYXCellRunIterator> spRuns = PYXCellRunIterator::create(valueTile.getTile(),*spGeometry);
+for (; !spRuns->end(); spRuns->next())
+{
+	for (int nOffset = spRuns->getBegin(); nOffset < spRuns->getEnd(); ++nOffset)
+	{
+		...
+	}
+}
+\endverbatim
+
+PYXTile, PYXInnerTile, PYXCell, PYXTileCollection and PYXVectorGeometry2 are
+converted directly. Other geometries are intersected with the tile and iterated
+cell by cell, with consecutive offsets merged into runs.
+
+The runs are sorted, disjoint and maximal (two runs are never adjacent).
+*/
+//! Iterates over runs of consecutive cell offsets of a geometry in a tile.
+class PYXLIB_DECL PYXCellRunIterator : public PYXAbstractIterator, public PYXObject
+{
+public:
+
+	//! Test method
+	static void test();
+
+	//! Time the runs of a res 14 circle against visiting its cells (not run by the tests).
+	static void benchmark();
+
+	//! Create an iterator over the cells of a geometry inside a tile.
+	static PYXPointer<PYXCellRunIterator> create(const PYXTile & tile,const PYXGeometry & geometry)
+	{
+		PYXPointer<PYXCellRunIterator> spIterator = PYXNEW(PYXCellRunIterator,tile);
+		spIterator->addGeometry(geometry,true);
+		spIterator->mergeRuns();
+		return spIterator;
+	}
+
+	//! Create an iterator over the remaining cells of a cell iterator inside a tile (the cell iterator is consumed).
+	static PYXPointer<PYXCellRunIterator> create(const PYXTile & tile,PYXIterator & iterator)
+	{
+		PYXPointer<PYXCellRunIterator> spIterator = PYXNEW(PYXCellRunIterator,tile);
+		spIterator->addIterator(iterator);
+		spIterator->mergeRuns();
+		return spIterator;
+	}
+
+	//! Constructor
+	explicit PYXCellRunIterator(const PYXTile & tile) :
+		m_tile(tile),
+		m_nCurrent(0)
+	{
+	}
+
+	//! Destructor
+	virtual ~PYXCellRunIterator() {}
+
+public: // PYXAbstractIterator
+
+	//! Move to the next run.
+	virtual void next()
+	{
+		++m_nCurrent;
+	}
+
+	//! See if we have covered all the runs.
+	virtual bool end() const
+	{
+		return m_nCurrent >= m_runs.size();
+	}
+
+public:
+
+	//! The tile the offsets are relative to.
+	const PYXTile & getTile() const
+	{
+		return m_tile;
+	}
+
+	//! The offset of the first cell of the current run.
+	int getBegin() const
+	{
+		return m_runs[m_nCurrent].first;
+	}
+
+	//! The offset after the last cell of the current run.
+	int getEnd() const
+	{
+		return m_runs[m_nCurrent].second;
+	}
+
+	//! The number of cells in the current run.
+	int getCellCount() const
+	{
+		return getEnd() - getBegin();
+	}
+
+	//! The number of runs.
+	int getRunCount() const
+	{
+		return static_cast<int>(m_runs.size());
+	}
+
+	//! The number of cells in all the runs.
+	int getTotalCellCount() const;
+
+private:
+
+	//! Add the cells of a geometry.
+	void addGeometry(const PYXGeometry & geometry,bool bIntersect);
+
+	//! Add the cells of a geometry that can be converted to runs directly, return false if the geometry is not supported.
+	bool addKnownGeometry(const PYXGeometry & geometry);
+
+	//! Add the remaining cells of a cell iterator.
+	void addIterator(PYXIterator & iterator);
+
+	//! Add the descendants of an index at the tile resolution.
+	void addDescendants(const PYXIcosIndex & index);
+
+	//! Add a run of cell offsets.
+	void addRun(int nBegin,int nEnd);
+
+	//! Sort the runs and merge the adjacent runs.
+	void mergeRuns();
+
+private:
+
+	//! The tile the offsets are relative to.
+	PYXTile m_tile;
+
+	//! The runs as [begin,end) offsets.
+	std::vector< std::pair<int,int> > m_runs;
+
+	//! The current run.
+	unsigned int m_nCurrent;
+};
+
+#endif // guard
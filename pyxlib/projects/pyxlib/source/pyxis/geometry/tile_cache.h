@@ -22,6 +22,7 @@ web			: www.pyxisinnovation.com
 
 // standard includes
 #include <list>
+#include <map>
 
 // forward declarations
 
@@ -187,6 +188,10 @@ call.
 This class implements a thread safe interface to all public methods.
 
 At the current time stored objects must also be reference counted.
+
+Tiles added with a rebuild cost are also registered with the MemoryManager,
+which can evict them one by one (see freeMemoryItem) when the memory is low,
+cheapest to rebuild per byte first.
 */
 //! Templated and memory managed storage for tile based memory objects.
 template<class T> class PYXTileCache 
@@ -267,6 +272,33 @@ public:
 		m_mapTiles.insert(std::make_pair(spTile->getTile(), spTile));
 	}
 
+	/*!
+	Add a tile to the tile cache and register it with the memory manager, so
+	it can be evicted according to its size and the cost to rebuild it.
+
+	\param spTile	The tile to add to the cache (must provide getHeapBytes).
+	\param cost		The cost to rebuild the tile.
+	*/
+	//! Add a tile with a known rebuild cost to the cache
+	void add(PYXPointer<T> spTile,const PYXCost & cost)
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+		add(spTile);
+
+		typename TileItemMap::iterator itItem = m_tileItems.find(spTile.get());
+		if (itItem != m_tileItems.end())
+		{
+			// the tile was already registered
+			accessMemoryItem(itItem->second);
+			return;
+		}
+
+		MemoryItemId nItemId = registerMemoryItem(spTile->getHeapBytes(),cost);
+		m_tileItems[spTile.get()] = nItemId;
+		m_itemTiles[nItemId] = spTile.get();
+	}
+
 	//! Return the number of tiles in the cache
 	int size() const
 	{
@@ -328,6 +360,13 @@ public:
 			PYXTileCacheEvent<T>::create(PYXPointer<T>());
 		spEvent->setEventType(PYXTileCacheEvent<T>::knDeleteAllTiles);
 		notify(spEvent);
+
+		for (typename TileItemMap::iterator it = m_tileItems.begin(); it != m_tileItems.end(); ++it)
+		{
+			unregisterMemoryItem(it->second);
+		}
+		m_tileItems.clear();
+		m_itemTiles.clear();
 		m_mapTiles.clear();
 	}
 
@@ -354,6 +393,7 @@ public:
 			{
 				// first non-expired instance found: update accessed status and return
 				itTile->second->getCacheStatus()->setAccessed();
+				accessTileItem(itTile->second.get());
 				return itTile->second;
 			}
 			else
@@ -367,7 +407,7 @@ public:
 						"Default event type has changed.");
 				notify(spEvent);
 
-				m_mapTiles.erase(itDelete);
+				eraseTile(itDelete);
 			}
 		}
 
@@ -402,6 +442,7 @@ public:
 			{
 				// add the tile to the set and increment the count
 				itTile->second->getCacheStatus()->setAccessed();
+				accessTileItem(itTile->second.get());
 				pTileList->push_back(itTile->second);
 				++nTileCount;
 				++itTile;
@@ -418,7 +459,7 @@ public:
 						"Default event type has changed.");
 				notify(spEvent);
 
-				m_mapTiles.erase(itDelete);
+				eraseTile(itDelete);
 			}
 		}
 		return nTileCount;
@@ -446,6 +487,50 @@ public:
 		}
 	}
 
+	/*!
+	Called by the memory manager to evict a single registered tile. The tile is
+	only removed if it is held by the cache alone.
+
+	\param nItemId	The memory item of the tile.
+
+	\return true if the tile was removed.
+	*/
+	//! Called by the memory manager to evict a tile.
+	virtual bool freeMemoryItem(MemoryItemId nItemId)
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+		typename ItemTileMap::iterator itItem = m_itemTiles.find(nItemId);
+		if (itItem == m_itemTiles.end())
+		{
+			return false;
+		}
+
+		// find the tile entry in the cache
+		std::pair<typename TileMap::iterator, typename TileMap::iterator> range = 
+			m_mapTiles.equal_range(itItem->second->getTile());
+		for (typename TileMap::iterator itTile = range.first; itTile != range.second; ++itTile)
+		{
+			if (itTile->second.get() == itItem->second)
+			{
+				// the tile is in use
+				if (itTile->second->getRefCount() > 1)
+				{
+					return false;
+				}
+
+				PYXPointer< PYXTileCacheEvent<T> > spEvent = 
+					PYXTileCacheEvent<T>::create(itTile->second);
+				notify(spEvent);
+
+				eraseTile(itTile);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	//! Definition of a multi map of intrusive pointers keyed on tile geometry
 	typedef std::multimap< PYXTile, PYXPointer<T> > TileMap;
  
@@ -493,7 +578,7 @@ public:
 					PYXTileCacheEvent<T>::create(itTiles->second);
 
 				notify(spEvent);
-				m_mapTiles.erase(itTiles);
+				eraseTile(itTiles);
 				--nBlockSize;
 				continue;
 			}
@@ -523,7 +608,7 @@ public:
 			PYXPointer< PYXTileCacheEvent<T> > spEvent = 
 				PYXTileCacheEvent<T>::create((*itVec)->second);
 			notify(spEvent);
-			m_mapTiles.erase(*itVec);
+			eraseTile(*itVec);
 		}
 
 		if (nNumToDelete < nBlockSize)
@@ -541,11 +626,43 @@ public:
 
 protected:
 
+private:
+
+	//! Remove a tile from the container and from the memory manager.
+	void eraseTile(typename TileMap::iterator itTile)
+	{
+		typename TileItemMap::iterator itItem = m_tileItems.find(itTile->second.get());
+		if (itItem != m_tileItems.end())
+		{
+			unregisterMemoryItem(itItem->second);
+			m_itemTiles.erase(itItem->second);
+			m_tileItems.erase(itItem);
+		}
+		m_mapTiles.erase(itTile);
+	}
+
+	//! Notify the memory manager a registered tile was used.
+	void accessTileItem(T* pTile)
+	{
+		typename TileItemMap::iterator itItem = m_tileItems.find(pTile);
+		if (itItem != m_tileItems.end())
+		{
+			accessMemoryItem(itItem->second);
+		}
+	}
+
 private:
 
 	//! The container that holds the display tiles
 	TileMap m_mapTiles;
 
+	//! The memory items of the tiles added with a cost (the tiles are held by m_mapTiles).
+	typedef std::map<T*, MemoryItemId> TileItemMap;
+	TileItemMap m_tileItems;
+
+	typedef std::map<MemoryItemId, T*> ItemTileMap;
+	ItemTileMap m_itemTiles;
+
 	//! The maximum number of tiles that can be held in the container
 	int m_nMaxTileCount;
 
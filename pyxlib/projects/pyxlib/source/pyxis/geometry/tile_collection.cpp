@@ -18,6 +18,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/derm/pentagon.h"
 #include "pyxis/derm/vertex_iterator.h"
 #include "pyxis/derm/snyder_projection.h"
+#include "pyxis/derm/tile_range_set.h"
 #include "pyxis/derm/wgs84_coord_converter.h"
 #include "pyxis/geometry/exceptions.h"
 #include "pyxis/geometry/polygon.h"
@@ -858,21 +859,15 @@ PYXPointer<PYXGeometry> PYXTileCollection::intersection(const PYXTileCollection&
 
 	int nResolution = std::max(getCellResolution(), collection.getCellResolution());
 
+	// Intersect the sorted ranges of the tiles instead of looking up every tile in the other tree.
 	assert(0 != m_spTileSet.get());
 	assert(0 != collection.m_spTileSet.get());
-	for (PYXTileSet::Iterator iTiles(*m_spTileSet); iTiles; ++iTiles)
+	PYXTileRangeSet ranges =
+		PYXTileRangeSet(*m_spTileSet).intersection(PYXTileRangeSet(*collection.m_spTileSet));
+	if (!ranges.empty())
 	{
-		if (collection.m_spTileSet->contains(*iTiles))
-		{
-			spCollection->addTile(*iTiles, nResolution);
-		}
-	}
-	for (PYXTileSet::Iterator iTiles(*collection.m_spTileSet); iTiles; ++iTiles)
-	{
-		if (m_spTileSet->contains(*iTiles))
-		{
-			spCollection->addTile(*iTiles, nResolution);
-		}
+		spCollection->m_spTileSet->setResolution(nResolution);
+		ranges.toTileSet(*spCollection->m_spTileSet, spCollection->getAutoAggregate());
 	}
 
 	if (!spCollection->isEmpty())
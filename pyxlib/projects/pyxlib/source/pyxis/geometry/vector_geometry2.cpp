@@ -21,8 +21,11 @@ web			: www.pyxisinnovation.com
 #include "pyxis/derm/snyder_projection.h"
 #include "pyxis/derm/sub_index_math.h"
 #include "pyxis/utility/coord_lat_lon.h"
+#include "pyxis/utility/profile.h"
 #include "pyxis/utility/sphere_math.h"
 #include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+#include "pyxis/utility/trace.h"
 #include "pyxis/utility/bit_utils.h"
 #include "pyxis/region/curve_region.h"
 #include "pyxis/region/region.h"
@@ -31,6 +34,9 @@ web			: www.pyxisinnovation.com
 
 
 
+// boost includes
+#include <boost/bind.hpp>
+
 // standard includes
 #include <cfloat>
 #include <stack>
@@ -48,7 +54,7 @@ const int SMALL_ENOUGH_TILE_DEPTH = 9;
 const int MAX_TILE_COLLECTION_SIZE_TO_PERFORM_PER_TILE_INTERSECTION = 50;
 
 // TEST
-Tester<PYXVectorGeometry2> tester();
+Tester<PYXVectorGeometry2> gTester;
 
 
 /////////////////////////////////////////////////////
@@ -374,17 +380,62 @@ void PYXVectorGeometry2::copyTo(PYXTileCollection* pTileCollection, int nTargetR
 
 	assert(pTileCollection != 0);
 	pTileCollection->clear();
+	pTileCollection->setCellResolution(nTargetResolution);
+
+	//skip the prime tiles outside the bounding circle of the region (other regions would need the tile collection to get their bounding circle)
+	std::vector<PYXIcosIndex> primes;
+	PYXVectorRegion * vectorRegion = dynamic_cast<PYXVectorRegion*>(m_region.get());
+	PYXBoundingCircle circle;
+	if (vectorRegion != 0)
+	{
+		circle = vectorRegion->getBoundingCircle();
+	}
 	for(PYXPrimeInnerTileIterator prime; !prime.end(); prime.next())
 	{
-		for(PYXPointer<PYXInnerTileIntersectionIterator> iterator=
-			m_serialized->getIterator(PYXInnerTile(prime.getIndex(),nTargetResolution));
-			!iterator->end();
-			iterator->next())
+		if (vectorRegion == 0 || circle.intersects(PYXInnerTile(prime.getIndex(),nTargetResolution).getBoundingCircle()))
 		{
-			if(iterator->getIntersection()!=knIntersectionNone)
-			{
-				pTileCollection->addTile(iterator->getTile().asTile());
-			}
+			primes.push_back(prime.getIndex());
+		}
+	}
+
+	if (primes.size() == 1)
+	{
+		copyPrimeTileTo(primes[0],nTargetResolution,pTileCollection);
+		return;
+	}
+
+	//rasterize every prime tile on the thread pool into its own tile collection, where the complete subtrees get aggregated
+	std::vector<PYXPointer<PYXTileCollection>> collections(primes.size());
+	{
+		PYXTaskGroup tasks;
+		for(unsigned int i=0;i<primes.size();++i)
+		{
+			collections[i] = PYXTileCollection::create();
+			tasks.addTask(boost::bind(&PYXVectorGeometry2::copyPrimeTileTo,this,boost::cref(primes[i]),nTargetResolution,collections[i].get()));
+		}
+		tasks.joinAll();
+	}
+
+	//merge the tile collections in the order of the prime tiles
+	for(auto & collection : collections)
+	{
+		if (!collection->isEmpty())
+		{
+			pTileCollection->addGeometry(*collection);
+		}
+	}
+}
+
+void PYXVectorGeometry2::copyPrimeTileTo(const PYXIcosIndex& primeIndex, int nTargetResolution, PYXTileCollection* pTileCollection) const
+{
+	for(PYXPointer<PYXInnerTileIntersectionIterator> iterator=
+		m_serialized->getIterator(PYXInnerTile(primeIndex,nTargetResolution));
+		!iterator->end();
+		iterator->next())
+	{
+		if(iterator->getIntersection()!=knIntersectionNone)
+		{
+			pTileCollection->addTile(iterator->getTile().asTile());
 		}
 	}
 }
@@ -427,6 +478,82 @@ void PYXVectorGeometry2::test()
 		PYXInnerTile tile= iterator1->getTile();
 		PYXInnerTileIntersection intersection = iterator1->getIntersection();
 	}
+
+	//copyTo rasterizes the prime tiles in parallel, it must give the tiles of a serial pass over all the prime tiles
+	std::vector<PYXPointer<PYXVectorGeometry2>> geometries;
+	PYXCoord3DDouble center;
+	SnyderProjection::getInstance()->pyxisToXYZ(PYXIcosIndex("1-0"),&center);
+	geometries.push_back(PYXVectorGeometry2::create(PYXCircleRegion::create(center,0.3),12));
+	geometries.push_back(PYXVectorGeometry2::create(PYXCircleRegion::create(PYXIcosIndex("A-0020"),true),12));
+	geometries.push_back(PYXVectorGeometry2::create(curve,12));
+	PYXCoord3DDouble pointA;
+	PYXCoord3DDouble pointB;
+	SnyderProjection::getInstance()->pyxisToXYZ(PYXIcosIndex("1-20"),&pointA);
+	SnyderProjection::getInstance()->pyxisToXYZ(PYXIcosIndex("9-30"),&pointB);
+	geometries.push_back(PYXVectorGeometry2::createFromLine(pointA,pointB,12));
+
+	for(auto & geometry : geometries)
+	{
+		for(int nResolution = 6; nResolution <= 12; nResolution += 3)
+		{
+			PYXTileCollection serial;
+			geometry->copySerialTo(&serial,nResolution);
+
+			PYXTileCollection parallel;
+			geometry->copyTo(&parallel,nResolution);
+
+			TEST_ASSERT_EQUAL(parallel.getCellResolution(),nResolution);
+			TEST_ASSERT_EQUAL(parallel.getCellCount(),serial.getCellCount());
+			TEST_ASSERT(parallel.isEqual(serial));
+		}
+	}
+}
+
+void PYXVectorGeometry2::benchmark()
+{
+	const int knBenchmarkResolution = 15;
+	PYXCoord3DDouble center;
+	SnyderProjection::getInstance()->pyxisToXYZ(PYXIcosIndex("1-0"),&center);
+	PYXPointer<PYXVectorGeometry2> circle = PYXVectorGeometry2::create(PYXCircleRegion::create(center,0.5),knBenchmarkResolution);
+	circle->generateDermIndex();
+
+	PYXHighQualityTimer timer;
+
+	timer.start();
+	PYXTileCollection serial;
+	circle->copySerialTo(&serial,knBenchmarkResolution);
+	timer.stop();
+	double fSerialTime = timer.getTime();
+
+	timer.start();
+	PYXTileCollection parallel;
+	circle->copyTo(&parallel,knBenchmarkResolution);
+	timer.stop();
+	double fParallelTime = timer.getTime();
+
+	assert(parallel.isEqual(serial));
+
+	TRACE_INFO("PYXVectorGeometry2::copyTo: circle of " << parallel.getCellCount() << " cells at resolution " << knBenchmarkResolution <<
+		" in " << fParallelTime << "[sec] over the prime tiles in parallel, " << fSerialTime << "[sec] serially");
+}
+
+void PYXVectorGeometry2::copySerialTo(PYXTileCollection* pTileCollection, int nTargetResolution) const
+{
+	generateDermIndex();
+	pTileCollection->setCellResolution(nTargetResolution);
+	for(PYXPrimeInnerTileIterator prime; !prime.end(); prime.next())
+	{
+		for(PYXPointer<PYXInnerTileIntersectionIterator> iterator=
+			m_serialized->getIterator(PYXInnerTile(prime.getIndex(),nTargetResolution));
+			!iterator->end();
+			iterator->next())
+		{
+			if(iterator->getIntersection()!=knIntersectionNone)
+			{
+				pTileCollection->addTile(iterator->getTile().asTile());
+			}
+		}
+	}
 }
 
 void PYXVectorGeometry2::generateDermIndex() const
@@ -389,11 +389,20 @@ public: // PYXGeometry
 
 	static void test();
 
+	//! Time rasterizing a large circle serially and over the prime tiles in parallel (not run by the tests).
+	static void benchmark();
+
 private:
 	void initTileCollection() const;
 
 	void generateDermIndex() const;
 
+	//! Copies the cells of a prime inner tile intersecting this geometry into a tile collection.
+	void copyPrimeTileTo(const PYXIcosIndex& primeIndex, int nTargetResolution, PYXTileCollection* pTileCollection) const;
+
+	//! Copies the cells of every prime inner tile one after the other, the reference for the parallel copyTo.
+	void copySerialTo(PYXTileCollection* pTileCollection, int nTargetResolution) const;
+
 protected:
 
 	//Emptry constructor. to allow derived classes to create them self from streams.
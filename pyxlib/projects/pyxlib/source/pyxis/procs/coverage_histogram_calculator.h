@@ -16,6 +16,9 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/value.h"
 #include "pyxis/data/histogram.h"
 
+// standard includes
+#include <vector>
+
 //! Perform a calculation on a feature.
 struct PYXLIB_DECL ICoverageHistogramCalculator : public PYXCOM_IUnknown
 {
@@ -23,7 +26,18 @@ struct PYXLIB_DECL ICoverageHistogramCalculator : public PYXCOM_IUnknown
 
 public:
 
+	/*!
+	Calculate the histogram of the coverage inside a feature. Every call returns
+	a new histogram of the given feature only, it is not accumulated with the
+	histograms of the previous calls.
+	*/
 	virtual PYXPointer<PYXCellHistogram> STDMETHODCALLTYPE getHistogram(int fieldIndex,PYXPointer<IFeature> feature) = 0;
+
+	/*!
+	Calculate the histograms of the coverage inside many features in a single pass
+	over the coverage. The result is ordered like the given features.
+	*/
+	virtual std::vector<PYXPointer<PYXCellHistogram>> STDMETHODCALLTYPE getHistograms(int fieldIndex,const std::vector<PYXPointer<IFeature>> & features) = 0;
 };
 
 #endif // guard
\ No newline at end of file
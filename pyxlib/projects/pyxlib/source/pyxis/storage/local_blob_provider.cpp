@@ -0,0 +1,439 @@
+/******************************************************************************
+local_blob_provider.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/storage/local_blob_provider.h"
+
+// Pyxis includes
+#include "pyxis/storage/storage_exceptions.h"
+#include "pyxis/utility/app_services.h"
+#include "pyxis/utility/exceptions.h"
+#include "pyxis/utility/ssl_utils.h"
+#include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/tester.h"
+
+// Boost includes
+#include <boost/filesystem/operations.hpp>
+
+// standard includes
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <functional>
+
+//! Tester class
+Tester<LocalBlobProvider> gTester;
+
+//! Test method
+void LocalBlobProvider::test()
+{
+	const boost::filesystem::path directory = AppServices::makeTempDir() / "blobs";
+
+	const std::string dataA(400, 'a');
+	const std::string dataB(400, 'b');
+	const std::string dataC(400, 'c');
+	const std::string dataD(2000, 'd');
+
+	{
+		LocalBlobProvider provider(directory, 1000);
+
+		std::istringstream issA(dataA);
+		TEST_ASSERT(provider.addBlob("A", issA));
+		std::istringstream issB(dataB);
+		TEST_ASSERT(provider.addBlob("B", issB));
+		TEST_ASSERT(provider.blobExists("A"));
+		TEST_ASSERT(provider.blobExists("B"));
+		TEST_ASSERT_EQUAL(provider.getSize(), 800);
+
+		// repeated add
+		std::istringstream issA2(dataA);
+		TEST_ASSERT(!provider.addBlob("A", issA2));
+
+		// blob comparison test, also makes A the most recently used blob
+		std::ostringstream downloaded;
+		TEST_ASSERT(provider.getBlob("A", downloaded));
+		TEST_ASSERT(downloaded.str() == dataA);
+
+		// adding C goes over the maximum size and evicts B, the least recently used blob
+		std::istringstream issC(dataC);
+		TEST_ASSERT(provider.addBlob("C", issC));
+		TEST_ASSERT(provider.blobExists("A"));
+		TEST_ASSERT(!provider.blobExists("B"));
+		TEST_ASSERT(provider.blobExists("C"));
+		TEST_ASSERT_EQUAL(provider.getSize(), 800);
+
+		std::ostringstream missing;
+		TEST_ASSERT(!provider.getBlob("B", missing));
+
+		// a blob larger than the maximum size is not stored
+		std::istringstream issD(dataD);
+		TEST_ASSERT(!provider.addBlob("D", issD));
+		TEST_ASSERT(!provider.blobExists("D"));
+		TEST_ASSERT(provider.blobExists("A"));
+
+		TEST_ASSERT(provider.removeBlob("C"));
+		TEST_ASSERT(!provider.removeBlob("C"));
+		TEST_ASSERT_EQUAL(provider.getSize(), 400);
+
+		// empty blob
+		std::istringstream issE;
+		TEST_ASSERT(provider.addBlob("E", issE));
+		std::ostringstream empty;
+		TEST_ASSERT(provider.getBlob("E", empty));
+		TEST_ASSERT(empty.str().empty());
+
+		std::vector<std::string> keys;
+		keys.push_back("A");
+		keys.push_back("B");
+		keys.push_back("E");
+		auto blobMap = provider.getBlobs(keys);
+		TEST_ASSERT(blobMap->size() == 2);
+		TEST_ASSERT(*(*blobMap)["A"] == dataA);
+
+		auto missingKeys = provider.missingBlobs(keys);
+		TEST_ASSERT(missingKeys->size() == 1);
+		TEST_ASSERT((*missingKeys)[0] == "B");
+	}
+
+	{
+		// the blobs are found again after a restart
+		LocalBlobProvider provider(directory, 1000);
+		TEST_ASSERT_EQUAL(provider.getCount(), 2);
+		TEST_ASSERT_EQUAL(provider.getSize(), 400);
+		TEST_ASSERT(provider.blobExists("A"));
+		TEST_ASSERT(provider.blobExists("E"));
+
+		std::ostringstream downloaded;
+		TEST_ASSERT(provider.getBlob("A", downloaded));
+		TEST_ASSERT(downloaded.str() == dataA);
+	}
+
+	{
+		// a smaller maximum size evicts on restart
+		LocalBlobProvider provider(directory, 100);
+		TEST_ASSERT(provider.getSize() <= 100);
+		TEST_ASSERT(!provider.blobExists("A"));
+	}
+}
+
+/*!
+Constructor, indexes the blobs already in the directory.
+
+The blobs are ordered by the modification time of their files, which is set
+every time a blob is used.
+
+\param directory	The directory of the blobs (created if needed)
+\param nMaxSize		The maximum size of the blobs, in bytes
+
+\throws PYXStorageException if the directory can't be created or read.
+*/
+LocalBlobProvider::LocalBlobProvider(const boost::filesystem::path& directory, boost::uintmax_t nMaxSize) :
+	m_directory(directory),
+	m_nMaxSize(nMaxSize),
+	m_nSize(0),
+	m_nTempCount(0)
+{
+	std::vector<std::pair<std::time_t, std::string> > files;
+
+	try
+	{
+		boost::filesystem::create_directories(m_directory);
+
+		for (boost::filesystem::directory_iterator it(m_directory), end; it != end; ++it)
+		{
+			if (!boost::filesystem::is_regular_file(it->status()))
+			{
+				continue;
+			}
+
+			boost::system::error_code ec;
+			if (it->path().extension() == ".tmp")
+			{
+				// left over by an interrupted write
+				boost::filesystem::remove(it->path(), ec);
+				continue;
+			}
+
+			files.push_back(std::make_pair(boost::filesystem::last_write_time(it->path(), ec), it->path().filename().string()));
+		}
+	}
+	catch (const boost::filesystem::filesystem_error& e)
+	{
+		PYXTHROW(PYXStorageException, "Unable to open blob directory: " << m_directory.string() << " " << e.what());
+	}
+
+	// most recently used first
+	std::sort(files.begin(), files.end(), std::greater<std::pair<std::time_t, std::string> >());
+
+	for (auto& file : files)
+	{
+		boost::system::error_code ec;
+		boost::uintmax_t nSize = boost::filesystem::file_size(getPath(file.second), ec);
+		if (ec)
+		{
+			continue;
+		}
+
+		m_order.push_back(file.second);
+
+		Entry entry;
+		entry.nSize = nSize;
+		entry.itOrder = --m_order.end();
+		m_entries[file.second] = entry;
+
+		m_nSize += nSize;
+	}
+
+	evict();
+}
+
+/*!
+Get a blob with the given key from storage.
+
+\param key		The blob key
+\param ostream	The stream to write the blob into
+
+\return true if the blob is found, otherwise false.
+*/
+bool LocalBlobProvider::getBlob(const std::string& key, std::ostream& ostream)
+{
+	const std::string strFileName = getFileName(key);
+	boost::uintmax_t nSize = 0;
+
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+		auto it = m_entries.find(strFileName);
+		if (it == m_entries.end())
+		{
+			return false;
+		}
+		nSize = it->second.nSize;
+
+		// most recently used
+		m_order.splice(m_order.begin(), m_order, it->second.itOrder);
+	}
+
+	// the file is read without holding the lock
+	const boost::filesystem::path path = getPath(strFileName);
+	std::ifstream file(path.string().c_str(), std::ios::binary);
+	if (!file)
+	{
+		// the file was removed from the disk
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		removeFile(strFileName);
+		return false;
+	}
+
+	if (nSize > 0)
+	{
+		ostream << file.rdbuf();
+	}
+
+	// keep the order across restarts
+	boost::system::error_code ec;
+	boost::filesystem::last_write_time(path, std::time(0), ec);
+
+	return true;
+}
+
+/*!
+Add a blob with the given key to storage.
+
+\param key		The blob key
+\param istream	The contents of the blob
+
+\return true if the blob was added or false if the key already exists or the
+		blob is larger than the maximum size.
+\throws PYXStorageException if the blob can't be written.
+*/
+bool LocalBlobProvider::addBlob(const std::string& key, std::istream& istream)
+{
+	const std::string strFileName = getFileName(key);
+	boost::filesystem::path tempPath;
+
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+		if (m_entries.find(strFileName) != m_entries.end())
+		{
+			return false;
+		}
+		tempPath = getPath(strFileName + "." + StringUtils::toString(++m_nTempCount) + ".tmp");
+	}
+
+	// write the blob to a temporary file without holding the lock
+	boost::uintmax_t nSize = 0;
+	bool bWritten = false;
+	{
+		std::ofstream file(tempPath.string().c_str(), std::ios::binary);
+
+		char buffer[64 * 1024];
+		while (file && istream)
+		{
+			istream.read(buffer, sizeof(buffer));
+			if (istream.gcount() > 0)
+			{
+				file.write(buffer, istream.gcount());
+				nSize += istream.gcount();
+			}
+		}
+		bWritten = !file.fail();
+	}
+
+	boost::system::error_code ec;
+	if (!bWritten)
+	{
+		boost::filesystem::remove(tempPath, ec);
+		PYXTHROW(PYXStorageException, "Unable to write blob: " << key);
+	}
+
+	if (nSize > m_nMaxSize)
+	{
+		boost::filesystem::remove(tempPath, ec);
+		return false;
+	}
+
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	// added by another thread while writing
+	if (m_entries.find(strFileName) != m_entries.end())
+	{
+		boost::filesystem::remove(tempPath, ec);
+		return false;
+	}
+
+	boost::filesystem::rename(tempPath, getPath(strFileName), ec);
+	if (ec)
+	{
+		boost::filesystem::remove(tempPath, ec);
+		PYXTHROW(PYXStorageException, "Unable to write blob: " << key);
+	}
+
+	m_order.push_front(strFileName);
+
+	Entry entry;
+	entry.nSize = nSize;
+	entry.itOrder = m_order.begin();
+	m_entries[strFileName] = entry;
+
+	m_nSize += nSize;
+	evict();
+
+	return true;
+}
+
+/*!
+Remove the blob with the given key from storage.
+
+\param key		The blob key
+
+\return true if the blob was removed, otherwise false
+*/
+bool LocalBlobProvider::removeBlob(const std::string& key)
+{
+	const std::string strFileName = getFileName(key);
+
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	if (m_entries.find(strFileName) == m_entries.end())
+	{
+		return false;
+	}
+
+	removeFile(strFileName);
+	return true;
+}
+
+/*!
+Check if a blob exists.
+
+\param key	The blob key
+
+\return true if a blob exists for the given key, otherwise false
+*/
+bool LocalBlobProvider::blobExists(const std::string& key)
+{
+	const std::string strFileName = getFileName(key);
+
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	return m_entries.find(strFileName) != m_entries.end();
+}
+
+//! The total size of the blobs, in bytes.
+boost::uintmax_t LocalBlobProvider::getSize() const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	return m_nSize;
+}
+
+//! The number of blobs.
+int LocalBlobProvider::getCount() const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	return static_cast<int>(m_entries.size());
+}
+
+/*!
+The name of the file of a key.
+
+\param key	The blob key
+
+\return The SHA256 hash of the key.
+*/
+std::string LocalBlobProvider::getFileName(const std::string& key)
+{
+	SSLUtils::Checksum checksumSHA256("SHA256");
+	if (!checksumSHA256.generate(key))
+	{
+		PYXTHROW(PYXStorageException, "Unable to hash blob key: " << key);
+	}
+	return checksumSHA256.toHexString();
+}
+
+//! The path of a blob file.
+boost::filesystem::path LocalBlobProvider::getPath(const std::string& strFileName) const
+{
+	return m_directory / strFileName;
+}
+
+/*!
+Remove the least recently used blobs until the size is within the maximum.
+Must be called with the lock held.
+*/
+void LocalBlobProvider::evict()
+{
+	while (m_nSize > m_nMaxSize && !m_order.empty())
+	{
+		const std::string strFileName = m_order.back();
+		removeFile(strFileName);
+	}
+}
+
+/*!
+Remove a blob file from the index and the disk. Must be called with the lock held.
+
+A file that is being read can't be removed on Windows. It is still removed from
+the index, and found again by the next instance of the provider.
+*/
+void LocalBlobProvider::removeFile(const std::string& strFileName)
+{
+	auto it = m_entries.find(strFileName);
+	if (it == m_entries.end())
+	{
+		return;
+	}
+
+	m_nSize -= it->second.nSize;
+	m_order.erase(it->second.itOrder);
+	m_entries.erase(it);
+
+	boost::system::error_code ec;
+	boost::filesystem::remove(getPath(strFileName), ec);
+}
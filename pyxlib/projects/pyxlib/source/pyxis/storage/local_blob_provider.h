@@ -0,0 +1,120 @@
+#ifndef LOCAL_BLOB_PROVIDER_H
+#define LOCAL_BLOB_PROVIDER_H
+/******************************************************************************
+local_blob_provider.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// Pyxis includes
+#include "i_blob_provider.h"
+
+// Boost includes
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+
+// Standard includes
+#include <list>
+#include <unordered_map>
+
+/*!
+Provides methods for adding and removing blobs of data from a directory on the
+local disk, used as a persistent tier in front of a remote blob provider.
+
+Every blob is stored in its own file, named after the SHA256 hash of its key
+(the keys of the PYXIS storage are themselves hashes of the blob contents, so
+the files are addressed by content). The total size of the blobs is bounded:
+when it is exceeded, the least recently used blobs are removed. The recency of
+a blob is kept in the modification time of its file, so the order survives a
+restart.
+
+A blob is written to a temporary file that is renamed once complete, so a blob
+is never read partially written.
+*/
+class PYXLIB_DECL LocalBlobProvider : public AbstractBlobProvider
+{
+public:
+
+	//! Default maximum size of the blobs (1GB).
+	static const boost::uintmax_t knDefaultMaxSize = 1024 * 1024 * 1024;
+
+	//! Test method
+	static void test();
+
+	/*!
+	Constructor, indexes the blobs already in the directory.
+
+	\param directory	The directory of the blobs (created if needed)
+	\param nMaxSize		The maximum size of the blobs, in bytes
+	*/
+	LocalBlobProvider(const boost::filesystem::path& directory, boost::uintmax_t nMaxSize = knDefaultMaxSize);
+
+    //! Get a blob with the given key from storage.
+    bool getBlob(const std::string& key, std::ostream& ostream);
+
+    //! Add a blob with the given key to storage.
+    bool addBlob(const std::string& key, std::istream& istream);
+
+    //! Remove the blob with the given key from storage.
+    bool removeBlob(const std::string& key);
+
+    //! Check if a blob exists.
+    bool blobExists(const std::string& key);
+
+	//! The total size of the blobs, in bytes.
+	boost::uintmax_t getSize() const;
+
+	//! The number of blobs.
+	int getCount() const;
+
+private:
+
+	//! A blob file in the index.
+	struct Entry
+	{
+		//! The size of the file
+		boost::uintmax_t nSize;
+
+		//! The position of the file in m_order
+		std::list<std::string>::iterator itOrder;
+	};
+
+	//! The name of the file of a key.
+	static std::string getFileName(const std::string& key);
+
+	//! The path of a blob file.
+	boost::filesystem::path getPath(const std::string& strFileName) const;
+
+	//! Remove the least recently used blobs until the size is within the maximum.
+	void evict();
+
+	//! Remove a blob file from the index and the disk.
+	void removeFile(const std::string& strFileName);
+
+private:
+
+	//! The mutex for thread safety, only held to access the index.
+	mutable boost::recursive_mutex m_mutex;
+
+	//! The directory of the blobs.
+	boost::filesystem::path m_directory;
+
+	//! The maximum size of the blobs.
+	boost::uintmax_t m_nMaxSize;
+
+	//! The total size of the blobs.
+	boost::uintmax_t m_nSize;
+
+	//! The blob files, most recently used first.
+	std::list<std::string> m_order;
+
+	//! The blob files indexed by name.
+	std::unordered_map<std::string, Entry> m_entries;
+
+	//! Counter used to name the temporary files.
+	boost::uint32_t m_nTempCount;
+};
+#endif // guard
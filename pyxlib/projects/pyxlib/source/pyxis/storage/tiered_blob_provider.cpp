@@ -0,0 +1,726 @@
+/******************************************************************************
+tiered_blob_provider.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/storage/tiered_blob_provider.h"
+
+// Pyxis includes
+#include "pyxis/storage/pyxis_blob_provider.h"
+#include "pyxis/storage/storage_exceptions.h"
+#include "pyxis/utility/app_services.h"
+#include "pyxis/utility/exceptions.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+#include "pyxis/utility/trace.h"
+
+// Casablanca includes
+#include <cpprest/http_listener.h>
+
+// Boost includes
+#include <boost/thread/thread.hpp>
+
+// standard includes
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+/*!
+A local stand-in for the PYXIS storage server, serving the requests of a
+PyxisBlobProvider from memory with a fixed latency per request.
+*/
+class StandInBlobServer
+{
+public:
+
+	/*!
+	Constructor
+
+	\param strURL		The server URL
+	\param nLatency		The latency of every request, in milliseconds
+	*/
+	StandInBlobServer(const std::string& strURL, int nLatency) :
+		m_listener(utility::conversions::to_string_t(strURL + "/api/v1/storage/blobs/")),
+		m_nLatency(nLatency),
+		m_nRequests(0)
+	{
+		m_listener.support([this](web::http::http_request request) { handle(request); });
+	}
+
+	//! Start listening, return false if the server can't be started.
+	bool open()
+	{
+		try
+		{
+			m_listener.open().wait();
+			return true;
+		}
+		catch (const std::exception& e)
+		{
+			TRACE_INFO("Unable to start the stand-in blob server: " << e.what());
+			return false;
+		}
+	}
+
+	//! Stop listening.
+	void close()
+	{
+		m_listener.close().wait();
+	}
+
+	//! Add a blob to the server.
+	void addBlob(const std::string& key, const std::string& blob)
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_blobs[key] = blob;
+	}
+
+	//! The number of requests received.
+	long getRequestCount() const
+	{
+		return m_nRequests;
+	}
+
+private:
+
+	void handle(web::http::http_request request)
+	{
+		++m_nRequests;
+		boost::this_thread::sleep(boost::posix_time::milliseconds(m_nLatency));
+
+		auto path = web::uri::split_path(request.relative_uri().path());
+
+		if (path.size() == 2 && path[0] == U("blob"))
+		{
+			// the key is encoded twice by the client
+			auto key = utility::conversions::to_utf8string(web::uri::decode(web::uri::decode(path[1])));
+
+			if (request.method() == web::http::methods::GET)
+			{
+				boost::mutex::scoped_lock lock(m_mutex);
+				auto it = m_blobs.find(key);
+				if (it != m_blobs.end())
+				{
+					request.reply(web::http::status_codes::OK, it->second, "application/octet-stream");
+				}
+				else
+				{
+					request.reply(web::http::status_codes::NotFound);
+				}
+				return;
+			}
+
+			if (request.method() == web::http::methods::POST)
+			{
+				auto body = request.extract_vector().get();
+				addBlob(key, std::string(body.begin(), body.end()));
+				request.reply(web::http::status_codes::Created);
+				return;
+			}
+		}
+		else if (path.size() == 1 && request.method() == web::http::methods::POST)
+		{
+			auto keys = web::json::value::parse(request.extract_string(true).get());
+
+			if (path[0] == U("multiblobs"))
+			{
+				auto blobs = web::json::value::object();
+				boost::mutex::scoped_lock lock(m_mutex);
+				for (auto key : keys.as_array())
+				{
+					auto it = m_blobs.find(utility::conversions::to_utf8string(key.as_string()));
+					if (it != m_blobs.end())
+					{
+						blobs[key.as_string()] = web::json::value::string(utility::conversions::to_string_t(it->second));
+					}
+				}
+				request.reply(web::http::status_codes::OK, blobs);
+				return;
+			}
+
+			if (path[0] == U("missingblobs"))
+			{
+				int i = 0;
+				auto missingKeys = web::json::value::array();
+				boost::mutex::scoped_lock lock(m_mutex);
+				for (auto key : keys.as_array())
+				{
+					if (m_blobs.find(utility::conversions::to_utf8string(key.as_string())) == m_blobs.end())
+					{
+						missingKeys[i++] = key;
+					}
+				}
+				request.reply(web::http::status_codes::OK, missingKeys);
+				return;
+			}
+		}
+
+		request.reply(web::http::status_codes::BadRequest);
+	}
+
+private:
+
+	web::http::experimental::listener::http_listener m_listener;
+	int m_nLatency;
+	boost::detail::atomic_count m_nRequests;
+
+	boost::mutex m_mutex;
+	std::map<std::string, std::string> m_blobs;
+};
+
+}
+
+//! Tester class
+Tester<TieredBlobProvider> gTester;
+
+//! Test method
+void TieredBlobProvider::test()
+{
+	const std::string strURL = "http://localhost:34568";
+	StandInBlobServer server(strURL, 5);
+	if (!server.open())
+	{
+		TRACE_INFO("TieredBlobProvider test skipped, the stand-in blob server is not available.");
+		return;
+	}
+
+	// tiles of 16KB
+	const int nTileCount = 256;
+	std::vector<std::string> keys;
+	std::vector<std::string> blobs;
+	for (int i = 0; i < nTileCount; ++i)
+	{
+		keys.push_back("Tile-" + StringUtils::toString(i));
+		blobs.push_back(std::string(16 * 1024, static_cast<char>('a' + i % 26)) + keys.back());
+		server.addBlob(keys.back(), blobs.back());
+	}
+
+	auto spRemote = std::make_shared<PyxisBlobProvider>(strURL);
+
+	{
+		TieredBlobProvider provider(std::make_shared<LocalBlobProvider>(AppServices::makeTempDir()), spRemote);
+
+		// the second get is served by the local tier
+		std::ostringstream downloaded;
+		TEST_ASSERT(provider.getBlob(keys[0], downloaded));
+		TEST_ASSERT(downloaded.str() == blobs[0]);
+
+		long nRequests = server.getRequestCount();
+		std::ostringstream downloadedAgain;
+		TEST_ASSERT(provider.getBlob(keys[0], downloadedAgain));
+		TEST_ASSERT(downloadedAgain.str() == blobs[0]);
+		TEST_ASSERT_EQUAL(server.getRequestCount(), nRequests);
+		TEST_ASSERT_EQUAL(provider.getStatistics().nLocalHits, 1);
+
+		std::ostringstream missing;
+		TEST_ASSERT(!provider.getBlob("Missing", missing));
+
+		// concurrent gets of the same blob send a single request
+		nRequests = server.getRequestCount();
+		std::vector<std::string> results(8);
+		PYXTaskGroup tasks;
+		for (int i = 0; i < static_cast<int>(results.size()); ++i)
+		{
+			tasks.addSlowTask([&provider, &keys, &results, i]
+			{
+				std::ostringstream oss;
+				provider.getBlob(keys[1], oss);
+				results[i] = oss.str();
+			});
+		}
+		tasks.joinAll();
+		for (auto& result : results)
+		{
+			TEST_ASSERT(result == blobs[1]);
+		}
+		TEST_ASSERT_EQUAL(server.getRequestCount(), nRequests + 1);
+
+		// batched fetch
+		KeyVector batchKeys(keys.begin(), keys.begin() + 100);
+		batchKeys.push_back("Missing");
+		auto blobMap = provider.getBlobs(batchKeys);
+		TEST_ASSERT(blobMap->size() == 100);
+		for (int i = 0; i < 100; ++i)
+		{
+			auto it = blobMap->find(keys[i]);
+			TEST_ASSERT(it != blobMap->end());
+			TEST_ASSERT(*it->second == blobs[i]);
+		}
+
+		auto missingKeys = provider.missingBlobs(batchKeys);
+		TEST_ASSERT(missingKeys->size() == 1);
+		TEST_ASSERT((*missingKeys)[0] == "Missing");
+	}
+
+	server.close();
+}
+
+//! Compare the tiles/sec without the tier, with a cold tier and with a warm tier.
+void TieredBlobProvider::benchmark()
+{
+	const std::string strURL = "http://localhost:34568";
+	StandInBlobServer server(strURL, 5);
+	if (!server.open())
+	{
+		TRACE_INFO("TieredBlobProvider benchmark skipped, the stand-in blob server is not available.");
+		return;
+	}
+
+	// tiles of 16KB
+	const int nTileCount = 256;
+	std::vector<std::string> keys;
+	for (int i = 0; i < nTileCount; ++i)
+	{
+		keys.push_back("Tile-" + StringUtils::toString(i));
+		server.addBlob(keys.back(), std::string(16 * 1024, static_cast<char>('a' + i % 26)) + keys.back());
+	}
+
+	auto spRemote = std::make_shared<PyxisBlobProvider>(strURL);
+
+	PYXHighQualityTimer timer;
+
+	timer.start();
+	int nDirect = 0;
+	for (auto& key : keys)
+	{
+		std::ostringstream oss;
+		nDirect += spRemote->getBlob(key, oss) ? 1 : 0;
+	}
+	timer.stop();
+	const double fDirectTime = timer.getTime();
+
+	TieredBlobProvider provider(std::make_shared<LocalBlobProvider>(AppServices::makeTempDir()), spRemote);
+
+	timer.start();
+	auto coldMap = provider.getBlobs(keys);
+	timer.stop();
+	const double fColdTime = timer.getTime();
+
+	timer.start();
+	auto warmMap = provider.getBlobs(keys);
+	timer.stop();
+	const double fWarmTime = timer.getTime();
+
+	TRACE_INFO("PyxisBlobProvider: " << nDirect << " tiles in " << fDirectTime << "[sec] (" << nDirect / fDirectTime << " tiles/sec)");
+	TRACE_INFO("TieredBlobProvider: " << coldMap->size() << " tiles in " << fColdTime << "[sec] (" << coldMap->size() / fColdTime << " tiles/sec) cold, " <<
+		warmMap->size() << " in " << fWarmTime << "[sec] (" << warmMap->size() / fWarmTime << " tiles/sec) warm");
+
+	server.close();
+}
+
+/*!
+Constructor
+
+\param spLocal				The local tier
+\param spRemote				The remote provider
+\param nBatchSize			The number of keys per remote request of getBlobs()
+\param nMaxParallelBatches	The number of remote requests of getBlobs() in flight at once
+*/
+TieredBlobProvider::TieredBlobProvider(
+	const std::shared_ptr<LocalBlobProvider>& spLocal,
+	const std::shared_ptr<IBlobProvider>& spRemote,
+	int nBatchSize,
+	int nMaxParallelBatches) :
+	m_spLocal(spLocal),
+	m_spRemote(spRemote),
+	m_nBatchSize(std::max(nBatchSize, 1)),
+	m_nMaxParallelBatches(std::max(nMaxParallelBatches, 1)),
+	m_nLocalHits(0),
+	m_nRemoteRequests(0),
+	m_nCoalesced(0),
+	m_nBatches(0)
+{
+}
+
+/*!
+Get a blob with the given key from storage.
+
+\param key		The blob key
+\param ostream	The stream to write the blob into
+
+\return true if the blob is found, otherwise false.
+\throws PYXStorageException if the operation failed.
+*/
+bool TieredBlobProvider::getBlob(const std::string& key, std::ostream& ostream)
+{
+	if (m_spLocal->getBlob(key, ostream))
+	{
+		++m_nLocalHits;
+		return true;
+	}
+
+	bool bLeader = false;
+	auto spFetch = beginFetch(key, bLeader);
+
+	if (!bLeader)
+	{
+		++m_nCoalesced;
+		auto spBlob = waitFetch(key, spFetch);
+		if (spBlob)
+		{
+			ostream << *spBlob;
+			return true;
+		}
+		return false;
+	}
+
+	std::shared_ptr<std::string> spBlob;
+	try
+	{
+		// the fetch that stored the blob may have completed since the first check
+		std::ostringstream oss;
+		if (m_spLocal->getBlob(key, oss))
+		{
+			++m_nLocalHits;
+			spBlob = std::make_shared<std::string>(oss.str());
+		}
+		else
+		{
+			++m_nRemoteRequests;
+			if (m_spRemote->getBlob(key, oss))
+			{
+				spBlob = std::make_shared<std::string>(oss.str());
+			}
+		}
+	}
+	catch (...)
+	{
+		endFetch(key, spFetch, std::shared_ptr<std::string>(), true);
+		throw;
+	}
+
+	endFetch(key, spFetch, spBlob, false);
+
+	if (spBlob)
+	{
+		ostream << *spBlob;
+		return true;
+	}
+	return false;
+}
+
+/*!
+Retrieve multiple blobs at once.
+
+The blobs missing from the local tier are fetched from the remote provider in
+batches, with a bounded number of batches in flight at once.
+
+\param keys	The blob keys.
+
+\return A map of blobs indexed by their keys.
+\throws PYXStorageException if the operation failed.
+*/
+std::shared_ptr<TieredBlobProvider::BlobMap> TieredBlobProvider::getBlobs(const KeyVector& keys)
+{
+	auto blobMap = std::make_shared<BlobMap>();
+
+	// the keys fetched by this request, and the keys fetched by other requests
+	KeyVector fetchKeys;
+	std::vector<std::shared_ptr<PendingFetch> > fetches;
+	std::vector<std::pair<std::string, std::shared_ptr<PendingFetch> > > waits;
+
+	for (auto& key : keys)
+	{
+		if (blobMap->find(key) != blobMap->end())
+		{
+			continue;
+		}
+
+		std::ostringstream oss;
+		if (m_spLocal->getBlob(key, oss))
+		{
+			++m_nLocalHits;
+			(*blobMap)[key] = std::make_shared<std::string>(oss.str());
+			continue;
+		}
+
+		bool bLeader = false;
+		auto spFetch = beginFetch(key, bLeader);
+		if (bLeader)
+		{
+			fetchKeys.push_back(key);
+			fetches.push_back(spFetch);
+		}
+		else
+		{
+			++m_nCoalesced;
+			waits.push_back(std::make_pair(key, spFetch));
+		}
+	}
+
+	// fetch the batches, every task takes the next batch until none are left
+	const int nKeyCount = static_cast<int>(fetchKeys.size());
+	const int nBatchCount = (nKeyCount + m_nBatchSize - 1) / m_nBatchSize;
+	std::vector<std::shared_ptr<BlobMap> > batchMaps(nBatchCount);
+
+	auto fetch = [&](int nBatch)
+	{
+		KeyVector batchKeys(
+			fetchKeys.begin() + nBatch * m_nBatchSize,
+			fetchKeys.begin() + std::min((nBatch + 1) * m_nBatchSize, nKeyCount));
+		try
+		{
+			batchMaps[nBatch] = fetchBatch(batchKeys);
+		}
+		catch (PYXException& e)
+		{
+			TRACE_INFO("Unable to get a batch of " << batchKeys.size() << " blobs: " << e.getFullErrorString());
+		}
+		catch (const std::exception& e)
+		{
+			TRACE_INFO("Unable to get a batch of " << batchKeys.size() << " blobs: " << e.what());
+		}
+	};
+
+	if (nBatchCount == 1)
+	{
+		fetch(0);
+	}
+	else if (nBatchCount > 1)
+	{
+		boost::detail::atomic_count nNextBatch(0);
+		PYXTaskGroup tasks;
+		for (int i = 0; i < std::min(nBatchCount, m_nMaxParallelBatches); ++i)
+		{
+			tasks.addSlowTask([&]
+			{
+				for (int nBatch = ++nNextBatch - 1; nBatch < nBatchCount; nBatch = ++nNextBatch - 1)
+				{
+					fetch(nBatch);
+				}
+			});
+		}
+		tasks.joinAll();
+	}
+
+	// complete the fetches, a failed batch fails the fetches of its keys
+	bool bFailed = false;
+	for (int i = 0; i < nKeyCount; ++i)
+	{
+		const auto& spBatchMap = batchMaps[i / m_nBatchSize];
+		if (!spBatchMap)
+		{
+			bFailed = true;
+			endFetch(fetchKeys[i], fetches[i], std::shared_ptr<std::string>(), true);
+			continue;
+		}
+
+		auto it = spBatchMap->find(fetchKeys[i]);
+		if (it != spBatchMap->end())
+		{
+			(*blobMap)[fetchKeys[i]] = it->second;
+			endFetch(fetchKeys[i], fetches[i], it->second, false);
+		}
+		else
+		{
+			endFetch(fetchKeys[i], fetches[i], std::shared_ptr<std::string>(), false);
+		}
+	}
+
+	if (bFailed)
+	{
+		PYXTHROW(PYXStorageException, "Unable to get blobs.");
+	}
+
+	for (auto& wait : waits)
+	{
+		auto spBlob = waitFetch(wait.first, wait.second);
+		if (spBlob)
+		{
+			(*blobMap)[wait.first] = spBlob;
+		}
+	}
+
+	return blobMap;
+}
+
+/*!
+Add a blob with the given key to storage. The blob is added to both tiers.
+
+\param key		The blob key
+\param istream	The contents of the blob
+
+\return true if the blob was added to the remote provider or false if the key already exists.
+\throws PYXStorageException if the operation failed.
+*/
+bool TieredBlobProvider::addBlob(const std::string& key, std::istream& istream)
+{
+	const std::string blob((std::istreambuf_iterator<char>(istream)), std::istreambuf_iterator<char>());
+
+	std::istringstream remoteStream(blob);
+	const bool bAdded = m_spRemote->addBlob(key, remoteStream);
+
+	std::istringstream localStream(blob);
+	m_spLocal->addBlob(key, localStream);
+
+	return bAdded;
+}
+
+/*!
+Remove the blob with the given key from storage.
+
+\param key		The blob key
+
+\return true if the blob was removed, otherwise false
+*/
+bool TieredBlobProvider::removeBlob(const std::string& key)
+{
+	const bool bRemoved = m_spLocal->removeBlob(key);
+	return m_spRemote->removeBlob(key) || bRemoved;
+}
+
+/*!
+Check if a blob exists.
+
+\param key	The blob key
+
+\return true if a blob exists for the given key, otherwise false
+*/
+bool TieredBlobProvider::blobExists(const std::string& key)
+{
+	return m_spLocal->blobExists(key) || m_spRemote->blobExists(key);
+}
+
+/*!
+Check for the existence of multiple blobs. Only the keys missing from the local
+tier are checked by the remote provider.
+
+\param keys	The keys to check for existence.
+
+\return Keys for the missing blobs.
+*/
+std::shared_ptr<TieredBlobProvider::KeyVector> TieredBlobProvider::missingBlobs(const KeyVector& keys)
+{
+	KeyVector remoteKeys;
+	for (auto& key : keys)
+	{
+		if (!m_spLocal->blobExists(key))
+		{
+			remoteKeys.push_back(key);
+		}
+	}
+
+	if (remoteKeys.empty())
+	{
+		return std::make_shared<KeyVector>();
+	}
+	return m_spRemote->missingBlobs(remoteKeys);
+}
+
+//! The counters of the requests served so far.
+TieredBlobProvider::Statistics TieredBlobProvider::getStatistics() const
+{
+	Statistics statistics;
+	statistics.nLocalHits = m_nLocalHits;
+	statistics.nRemoteRequests = m_nRemoteRequests;
+	statistics.nCoalesced = m_nCoalesced;
+	statistics.nBatches = m_nBatches;
+	return statistics;
+}
+
+/*!
+Find the pending fetch of a key, or start one if there is none.
+
+\param key		The blob key
+\param bLeader	Set to true if the fetch was started, in which case the caller
+				must complete it with endFetch().
+
+\return The pending fetch.
+*/
+std::shared_ptr<TieredBlobProvider::PendingFetch> TieredBlobProvider::beginFetch(const std::string& key, bool& bLeader)
+{
+	boost::mutex::scoped_lock lock(m_pendingMutex);
+
+	auto& spFetch = m_pendingFetches[key];
+	bLeader = !spFetch;
+	if (bLeader)
+	{
+		spFetch = std::make_shared<PendingFetch>();
+	}
+	return spFetch;
+}
+
+/*!
+Complete a fetch started with beginFetch(), storing the blob in the local tier
+and waking up the requests waiting for it.
+
+\param key		The blob key
+\param spFetch	The fetch
+\param spBlob	The blob, null if it is missing
+\param bFailed	True if the fetch failed
+*/
+void TieredBlobProvider::endFetch(const std::string& key, const std::shared_ptr<PendingFetch>& spFetch, const std::shared_ptr<std::string>& spBlob, bool bFailed)
+{
+	if (spBlob)
+	{
+		// the blob is in the local tier before the fetch is removed, so it is never fetched twice
+		try
+		{
+			std::istringstream iss(*spBlob);
+			m_spLocal->addBlob(key, iss);
+		}
+		catch (PYXException& e)
+		{
+			TRACE_INFO("Unable to store blob in the local tier: " << e.getFullErrorString());
+		}
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_pendingMutex);
+		m_pendingFetches.erase(key);
+	}
+
+	{
+		boost::mutex::scoped_lock lock(spFetch->mutex);
+		spFetch->spBlob = spBlob;
+		spFetch->bFailed = bFailed;
+		spFetch->bCompleted = true;
+	}
+	spFetch->completed.notify_all();
+}
+
+/*!
+Wait for a fetch started by another request.
+
+\param key		The blob key
+\param spFetch	The fetch
+
+\return The blob, null if it is missing.
+\throws PYXStorageException if the fetch failed.
+*/
+std::shared_ptr<std::string> TieredBlobProvider::waitFetch(const std::string& key, const std::shared_ptr<PendingFetch>& spFetch)
+{
+	boost::mutex::scoped_lock lock(spFetch->mutex);
+	while (!spFetch->bCompleted)
+	{
+		spFetch->completed.wait(lock);
+	}
+
+	if (spFetch->bFailed)
+	{
+		PYXTHROW(PYXStorageException, "Unable to get blob: " << key);
+	}
+	return spFetch->spBlob;
+}
+
+/*!
+Fetch a batch of keys from the remote provider.
+
+\param keys	The blob keys.
+
+\return A map of blobs indexed by their keys.
+*/
+std::shared_ptr<TieredBlobProvider::BlobMap> TieredBlobProvider::fetchBatch(const KeyVector& keys)
+{
+	++m_nBatches;
+	return m_spRemote->getBlobs(keys);
+}
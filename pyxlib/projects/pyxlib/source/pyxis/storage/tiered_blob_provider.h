@@ -0,0 +1,148 @@
+#ifndef TIERED_BLOB_PROVIDER_H
+#define TIERED_BLOB_PROVIDER_H
+/******************************************************************************
+tiered_blob_provider.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// Pyxis includes
+#include "i_blob_provider.h"
+#include "local_blob_provider.h"
+
+// Boost includes
+#include <boost/detail/atomic_count.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Standard includes
+#include <memory>
+#include <unordered_map>
+
+/*!
+Provides blobs from a local blob provider in front of a remote one (usually a
+PyxisBlobProvider).
+
+The local tier is consulted first, and the blobs fetched from the remote
+provider are stored in it. Concurrent requests for a blob that is being
+fetched wait for that fetch instead of sending their own request. getBlobs()
+fetches the missing blobs in batches of knDefaultBatchSize keys, with at most
+knDefaultMaxParallelBatches batches in flight at once.
+*/
+class PYXLIB_DECL TieredBlobProvider : public AbstractBlobProvider
+{
+public:
+
+	//! Default number of keys per remote request of getBlobs().
+	static const int knDefaultBatchSize = 32;
+
+	//! Default number of remote requests of getBlobs() in flight at once.
+	static const int knDefaultMaxParallelBatches = 4;
+
+	//! Counters of the requests served by the provider.
+	struct Statistics
+	{
+		//! The blobs found in the local tier.
+		long nLocalHits;
+
+		//! The blobs requested one at a time from the remote provider by getBlob().
+		long nRemoteRequests;
+
+		//! The requests that waited for a fetch of another request.
+		long nCoalesced;
+
+		//! The batches requested from the remote provider by getBlobs().
+		long nBatches;
+	};
+
+	//! Test method
+	static void test();
+
+	//! Time getting 256 tiles without the tier and with a cold and a warm tier (not run by the tests).
+	static void benchmark();
+
+	/*!
+	Constructor
+
+	\param spLocal				The local tier
+	\param spRemote				The remote provider
+	\param nBatchSize			The number of keys per remote request of getBlobs()
+	\param nMaxParallelBatches	The number of remote requests of getBlobs() in flight at once
+	*/
+	TieredBlobProvider(
+		const std::shared_ptr<LocalBlobProvider>& spLocal,
+		const std::shared_ptr<IBlobProvider>& spRemote,
+		int nBatchSize = knDefaultBatchSize,
+		int nMaxParallelBatches = knDefaultMaxParallelBatches);
+
+    //! Get a blob with the given key from storage.
+    bool getBlob(const std::string& key, std::ostream& ostream);
+
+    //! Retrieve multiple blobs at once.
+    std::shared_ptr<BlobMap> getBlobs(const KeyVector& keys);
+
+    //! Add a blob with the given key to storage.
+    bool addBlob(const std::string& key, std::istream& istream);
+
+    //! Remove the blob with the given key from storage.
+    bool removeBlob(const std::string& key);
+
+    //! Check if a blob exists.
+    bool blobExists(const std::string& key);
+
+    //! Check for the existence of multiple blobs.
+    std::shared_ptr<KeyVector> missingBlobs(const KeyVector& keys);
+
+	//! The counters of the requests served so far.
+	Statistics getStatistics() const;
+
+private:
+
+	//! A fetch from the remote provider that other requests can wait for.
+	struct PendingFetch
+	{
+		boost::mutex mutex;
+		boost::condition_variable completed;
+		bool bCompleted;
+		bool bFailed;
+
+		//! The blob, null if it is missing
+		std::shared_ptr<std::string> spBlob;
+
+		PendingFetch() : bCompleted(false), bFailed(false) {}
+	};
+
+	//! Find the pending fetch of a key, or start one if there is none (bLeader is set to true).
+	std::shared_ptr<PendingFetch> beginFetch(const std::string& key, bool& bLeader);
+
+	//! Complete a fetch started with beginFetch(), storing the blob in the local tier.
+	void endFetch(const std::string& key, const std::shared_ptr<PendingFetch>& spFetch, const std::shared_ptr<std::string>& spBlob, bool bFailed);
+
+	//! Wait for a fetch started by another request, return the blob (null if it is missing).
+	static std::shared_ptr<std::string> waitFetch(const std::string& key, const std::shared_ptr<PendingFetch>& spFetch);
+
+	//! Fetch a batch of keys from the remote provider.
+	std::shared_ptr<BlobMap> fetchBatch(const KeyVector& keys);
+
+private:
+
+	std::shared_ptr<LocalBlobProvider> m_spLocal;
+	std::shared_ptr<IBlobProvider> m_spRemote;
+
+	int m_nBatchSize;
+	int m_nMaxParallelBatches;
+
+	//! Protects m_pendingFetches.
+	boost::mutex m_pendingMutex;
+
+	//! The fetches in progress, by key.
+	std::unordered_map<std::string, std::shared_ptr<PendingFetch> > m_pendingFetches;
+
+	boost::detail::atomic_count m_nLocalHits;
+	boost::detail::atomic_count m_nRemoteRequests;
+	boost::detail::atomic_count m_nCoalesced;
+	boost::detail::atomic_count m_nBatches;
+};
+#endif // guard
@@ -10,4 +10,226 @@ web			: www.pyxisinnovation.com
 #include "stdafx.h"
 #include "pyxis/utility/bounding_circle_spatial_set.h"
 
-// Nothing here yet
+// pyxlib includes
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+namespace
+{
+
+class SpatialSetTester
+{
+public:
+	class Item : public PYXObject
+	{
+	public:
+		int id;
+
+		explicit Item(int nId) : id(nId)
+		{
+		}
+
+		static PYXPointer<Item> create(int nId)
+		{
+			return PYXNEW(Item,nId);
+		}
+	};
+
+	//! Count the visited elements.
+	class CountVisitor
+	{
+	public:
+		int count;
+
+		CountVisitor() : count(0)
+		{
+		}
+
+		void operator()(const PYXPointer<Item> & item)
+		{
+			++count;
+		}
+	};
+
+	//! Collect the indices of the visited elements.
+	class IndexVisitor
+	{
+	public:
+		std::vector<int> indices;
+
+		void operator()(int index)
+		{
+			indices.push_back(index);
+		}
+	};
+
+	//! Random circles over the sphere, with a radius of 1km to 100km.
+	static void createCircles(int nCount,std::vector<PYXBoundingCircle> & circles,std::vector<PYXPointer<Item>> & items)
+	{
+		unsigned int nSeed = 1;
+		for(int i=0;i<nCount;++i)
+		{
+			double coord[4];
+			for(int j=0;j<4;++j)
+			{
+				nSeed = nSeed * 1103515245u + 12345u;
+				coord[j] = ((nSeed >> 8) & 0xFFFF) / 32768.0 - 1;
+			}
+
+			PYXCoord3DDouble center(coord[0],coord[1],coord[2]+0.001);
+			center.normalize();
+
+			double radius = (1 + 99 * (coord[3] + 1) / 2) / SphereMath::knEarthRadius * 1000;
+
+			circles.push_back(PYXBoundingCircle(center,radius));
+			items.push_back(Item::create(i));
+		}
+	}
+
+	static std::vector<int> bruteForce(const std::vector<PYXBoundingCircle> & circles,const PYXBoundingCircle & query)
+	{
+		std::vector<int> result;
+		for(unsigned int i=0;i<circles.size();++i)
+		{
+			if (query.intersects(circles[i]))
+			{
+				result.push_back(i);
+			}
+		}
+		return result;
+	}
+
+	static void testQueries()
+	{
+		std::vector<PYXBoundingCircle> circles;
+		std::vector<PYXPointer<Item>> items;
+		createCircles(2000,circles,items);
+
+		PYXPointer<PYXStaticBoundingCircleSpatialSet<Item>> staticSet = PYXStaticBoundingCircleSpatialSet<Item>::create(circles,items);
+		TEST_ASSERT_EQUAL(staticSet->getCount(),2000);
+
+		for(unsigned int i=0;i<circles.size();++i)
+		{
+			TEST_ASSERT(staticSet->getBoundingCircle().contains(circles[i]));
+		}
+
+		//the saved tree gives the same answers
+		PYXStringWireBuffer buffer;
+		staticSet->save(buffer);
+		buffer.setPos(0);
+		PYXPointer<PYXStaticBoundingCircleSpatialSet<Item>> loadedSet = PYXStaticBoundingCircleSpatialSet<Item>::create(buffer,items);
+
+		for(int q=0;q<100;++q)
+		{
+			PYXBoundingCircle query(circles[q*7].getCenter(),circles[q*7].getRadius()*(q%5+1)*10);
+			std::vector<int> expected = bruteForce(circles,query);
+
+			std::vector<PYXPointer<Item>> values;
+			staticSet->get(query,values);
+			std::vector<int> ids;
+			for(unsigned int i=0;i<values.size();++i)
+			{
+				ids.push_back(values[i]->id);
+			}
+			std::sort(ids.begin(),ids.end());
+			TEST_ASSERT(ids == expected);
+
+			IndexVisitor indexVisitor;
+			loadedSet->visitIndices(query,indexVisitor);
+			std::sort(indexVisitor.indices.begin(),indexVisitor.indices.end());
+			TEST_ASSERT(indexVisitor.indices == expected);
+		}
+
+		//empty and single element sets
+		std::vector<PYXBoundingCircle> noCircles;
+		std::vector<PYXPointer<Item>> noItems;
+		CountVisitor emptyVisitor;
+		PYXStaticBoundingCircleSpatialSet<Item>::create(noCircles,noItems)->visit(PYXBoundingCircle::global(),emptyVisitor);
+		TEST_ASSERT_EQUAL(emptyVisitor.count,0);
+
+		noCircles.push_back(circles[0]);
+		noItems.push_back(items[0]);
+		CountVisitor singleVisitor;
+		PYXStaticBoundingCircleSpatialSet<Item>::create(noCircles,noItems)->visit(PYXBoundingCircle::global(),singleVisitor);
+		TEST_ASSERT_EQUAL(singleVisitor.count,1);
+	}
+
+	static void benchmark()
+	{
+		const int nCount = 20000;
+		const int nQueries = 20000;
+
+		std::vector<PYXBoundingCircle> circles;
+		std::vector<PYXPointer<Item>> items;
+		createCircles(nCount,circles,items);
+
+		PYXHighQualityTimer timer;
+
+		timer.start();
+		PYXPointer<PYXBoundingCircleSpatialSet<Item>> incrementalSet = PYXBoundingCircleSpatialSet<Item>::create();
+		for(int i=0;i<nCount;++i)
+		{
+			incrementalSet->add(circles[i],items[i]);
+		}
+		timer.stop();
+		double fIncrementalBuildTime = timer.getTime();
+
+		timer.start();
+		PYXPointer<PYXStaticBoundingCircleSpatialSet<Item>> staticSet = PYXStaticBoundingCircleSpatialSet<Item>::create(circles,items);
+		timer.stop();
+		double fStaticBuildTime = timer.getTime();
+
+		int nListCount = 0;
+		timer.start();
+		for(int q=0;q<nQueries;++q)
+		{
+			std::list<PYXPointer<Item>> values;
+			incrementalSet->get(circles[q % nCount],values);
+			nListCount += static_cast<int>(values.size());
+		}
+		timer.stop();
+		double fListQueryTime = timer.getTime();
+
+		CountVisitor incrementalVisitor;
+		timer.start();
+		for(int q=0;q<nQueries;++q)
+		{
+			incrementalSet->visit(circles[q % nCount],incrementalVisitor);
+		}
+		timer.stop();
+		double fIncrementalVisitTime = timer.getTime();
+
+		CountVisitor staticVisitor;
+		timer.start();
+		for(int q=0;q<nQueries;++q)
+		{
+			staticSet->visit(circles[q % nCount],staticVisitor);
+		}
+		timer.stop();
+		double fStaticVisitTime = timer.getTime();
+
+		TEST_ASSERT_EQUAL(incrementalVisitor.count,nListCount);
+		TEST_ASSERT_EQUAL(staticVisitor.count,nListCount);
+
+		TRACE_INFO("PYXBoundingCircleSpatialSet: " << nCount << " circles built in " << fIncrementalBuildTime << "[sec], " <<
+			nQueries << " queries in " << fListQueryTime << "[sec] (list), " << fIncrementalVisitTime << "[sec] (visitor)");
+		TRACE_INFO("PYXStaticBoundingCircleSpatialSet: " << nCount << " circles built in " << fStaticBuildTime << "[sec], " <<
+			nQueries << " queries in " << fStaticVisitTime << "[sec] (visitor)");
+	}
+
+	static void test()
+	{
+		testQueries();
+	}
+};
+
+//! Tester class
+Tester<SpatialSetTester> gSpatialSetTester;
+
+}
+
+void benchmarkBoundingCircleSpatialSets()
+{
+	SpatialSetTester::benchmark();
+}
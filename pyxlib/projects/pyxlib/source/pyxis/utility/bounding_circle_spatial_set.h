@@ -12,6 +12,13 @@ web			: www.pyxisinnovation.com
 #include "pyxlib.h"
 #include "pyxis/utility/sphere_math.h"
 #include "pyxis/utility/bounding_shape.h"
+#include "pyxis/utility/wire_buffer.h"
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <vector>
 
 
 /*! PYXBoundingCircleSpatialSet<T> class
@@ -22,9 +29,11 @@ the API:
 1. add(BoundingCircle,PYXPointer<T> value) - adds an element into a set.
 2. get(BoundingCircle,std::list<PYXPointer<T> values) - to retrieve all elements 
 	 intersect an area on earth.
+3. visit(BoundingCircle,visitor) - call visitor(const PYXPointer<T> &) for all elements
+	 intersect an area on earth, without building a list.
 	 
 To perform more refined iterations of the tree.
-3. getRoot() - return the RootNode of the tree.
+4. getRoot() - return the RootNode of the tree.
 
 PYXBoundingCircleSpatialSet<T>::Node API:
 1. hasSingleValue - return true if this node contains a single value
@@ -340,6 +349,27 @@ public:
 				}
 			}
 		}
+
+		template<class Visitor>
+		void visit(const PYXBoundingCircle & circle,Visitor & visitor) const
+		{
+			for(NodeList::const_iterator it = m_subNodes.begin();it != m_subNodes.end();++it)
+			{
+				const Node & node = (**it);
+
+				if (circle.intersects(node.m_circle))
+				{
+					if (node.hasSingleValue())
+					{
+						visitor(node.m_value);
+					}
+					else
+					{
+						node.visit(circle,visitor);
+					}
+				}
+			}
+		}
 	};
 
 protected:
@@ -361,6 +391,14 @@ public:
 		m_root.get(circle,values);
 	}
 
+	template<class Visitor>
+	void visit(const PYXBoundingCircle & circle,Visitor & visitor) const
+	{
+		assert(!circle.isEmpty() && "can't add empty circle into the tree");
+
+		m_root.visit(circle,visitor);
+	}
+
 	const Node & getRoot() const { return m_root; }
 
 public:
@@ -374,5 +412,364 @@ public:
 	}
 };
 
+/*! PYXStaticBoundingCircleSpatialSet<T> class
+
+PYXStaticBoundingCircleSpatialSet is a sphere tree with values of PYXPointer<T>,
+built once from all the elements of a static set (a layer that doesn't change).
+
+The elements are sorted along a space filling curve on the sphere (a Z-order
+curve on the faces of a cube) and grouped bottom up into nodes of knNodeSize
+children. The nodes and the elements are stored in flat arrays, which makes the
+tree cheaper to build and to query than PYXBoundingCircleSpatialSet, and allows
+saving the tree into a PYXWireBuffer.
+
+The API:
+1. create(circles,values) - build the tree, circles[i] is the bounding circle of values[i].
+2. visit(BoundingCircle,visitor) - call visitor(const PYXPointer<T> &) for all elements
+	 intersect an area on earth.
+3. visitIndices(BoundingCircle,visitor) - call visitor(int) with the index (in the
+	 create vectors) of all elements intersect an area on earth.
+4. get(BoundingCircle,std::vector<PYXPointer<T>> values) - to retrieve all elements
+	 intersect an area on earth.
+5. save(buffer) / create(buffer,values) - persist the tree. The values are not saved,
+	 they are attached again by their index when the tree is loaded.
+*/
+template<class T>
+class PYXStaticBoundingCircleSpatialSet : public PYXObject
+{
+public:
+	//! The amount of children of a node.
+	static const int knNodeSize = 8;
+
+private:
+	struct Node
+	{
+		PYXBoundingCircle circle;
+
+		//! The first child: an element for a leaf node, a node otherwise.
+		int first;
+
+		//! The amount of children.
+		int count;
+
+		//! True if the children are elements.
+		bool leaf;
+	};
+
+	//! The nodes, the root node is the last one.
+	std::vector<Node> m_nodes;
+
+	//! The bounding circles of the elements, in tree order.
+	std::vector<PYXBoundingCircle> m_circles;
+
+	//! The elements, in tree order.
+	std::vector<PYXPointer<T>> m_values;
+
+	//! The index of every element in the vectors the tree was created from.
+	std::vector<int> m_indices;
+
+public:
+	static PYXPointer<PYXStaticBoundingCircleSpatialSet> create(const std::vector<PYXBoundingCircle> & circles,const std::vector<PYXPointer<T>> & values)
+	{
+		return PYXNEW(PYXStaticBoundingCircleSpatialSet,circles,values);
+	}
+
+	static PYXPointer<PYXStaticBoundingCircleSpatialSet> create(PYXWireBuffer & buffer,const std::vector<PYXPointer<T>> & values)
+	{
+		return PYXNEW(PYXStaticBoundingCircleSpatialSet,buffer,values);
+	}
+
+	PYXStaticBoundingCircleSpatialSet(const std::vector<PYXBoundingCircle> & circles,const std::vector<PYXPointer<T>> & values)
+	{
+		assert(circles.size() == values.size() && "every value needs a bounding circle");
+
+		//sort the elements along the curve
+		std::vector<std::pair<unsigned long long,int>> keys(circles.size());
+		for(unsigned int i=0;i<circles.size();++i)
+		{
+			assert(!circles[i].isEmpty() && "can't add empty circle into the tree");
+			keys[i] = std::make_pair(calcCurveKey(circles[i].getCenter()),static_cast<int>(i));
+		}
+		std::sort(keys.begin(),keys.end());
+
+		m_circles.reserve(keys.size());
+		m_values.reserve(keys.size());
+		m_indices.reserve(keys.size());
+		for(unsigned int i=0;i<keys.size();++i)
+		{
+			m_indices.push_back(keys[i].second);
+			m_circles.push_back(circles[keys[i].second]);
+			m_values.push_back(values[keys[i].second]);
+		}
+
+		build();
+	}
+
+	PYXStaticBoundingCircleSpatialSet(PYXWireBuffer & buffer,const std::vector<PYXPointer<T>> & values)
+	{
+		int count = 0;
+		buffer >> count;
+
+		m_circles.resize(count);
+		m_values.resize(count);
+		m_indices.resize(count);
+		for(int i=0;i<count;++i)
+		{
+			buffer >> m_indices[i];
+			m_circles[i] = loadCircle(buffer);
+
+			if (m_indices[i] < 0 || m_indices[i] >= static_cast<int>(values.size()))
+			{
+				PYXTHROW(PYXException,"Spatial set element " << m_indices[i] << " is out of range, " << values.size() << " values were given");
+			}
+			m_values[i] = values[m_indices[i]];
+		}
+
+		int nodeCount = 0;
+		buffer >> nodeCount;
+
+		m_nodes.resize(nodeCount);
+		for(int i=0;i<nodeCount;++i)
+		{
+			unsigned char leaf = 0;
+			m_nodes[i].circle = loadCircle(buffer);
+			buffer >> m_nodes[i].first >> m_nodes[i].count >> leaf;
+			m_nodes[i].leaf = leaf != 0;
+		}
+	}
+
+public:
+	void save(PYXWireBuffer & buffer) const
+	{
+		buffer << static_cast<int>(m_circles.size());
+		for(unsigned int i=0;i<m_circles.size();++i)
+		{
+			buffer << m_indices[i];
+			saveCircle(buffer,m_circles[i]);
+		}
+
+		buffer << static_cast<int>(m_nodes.size());
+		for(unsigned int i=0;i<m_nodes.size();++i)
+		{
+			saveCircle(buffer,m_nodes[i].circle);
+			buffer << m_nodes[i].first << m_nodes[i].count << static_cast<unsigned char>(m_nodes[i].leaf ? 1 : 0);
+		}
+	}
+
+	int getCount() const { return static_cast<int>(m_values.size()); }
+
+	//! The bounding circle of all the elements.
+	PYXBoundingCircle getBoundingCircle() const
+	{
+		return m_nodes.empty() ? PYXBoundingCircle() : m_nodes.back().circle;
+	}
+
+	template<class Visitor>
+	void visit(const PYXBoundingCircle & circle,Visitor & visitor) const
+	{
+		ElementVisitor<std::vector<PYXPointer<T>>,Visitor> valueVisitor(m_values,visitor);
+		visitPositions(circle,valueVisitor);
+	}
+
+	template<class Visitor>
+	void visitIndices(const PYXBoundingCircle & circle,Visitor & visitor) const
+	{
+		ElementVisitor<std::vector<int>,Visitor> indexVisitor(m_indices,visitor);
+		visitPositions(circle,indexVisitor);
+	}
+
+	void get(const PYXBoundingCircle & circle,std::vector<PYXPointer<T>> & values) const
+	{
+		ValueCollector collector(values);
+		visit(circle,collector);
+	}
+
+private:
+	//! Calls a visitor with the value or the index of the element at a tree position.
+	template<class Elements,class Visitor>
+	class ElementVisitor
+	{
+	private:
+		const Elements & m_elements;
+		Visitor & m_visitor;
+
+	public:
+		ElementVisitor(const Elements & elements,Visitor & visitor) : m_elements(elements), m_visitor(visitor)
+		{
+		}
+
+		void operator()(int position)
+		{
+			m_visitor(m_elements[position]);
+		}
+	};
+
+	class ValueCollector
+	{
+	private:
+		std::vector<PYXPointer<T>> & m_values;
+
+	public:
+		explicit ValueCollector(std::vector<PYXPointer<T>> & values) : m_values(values)
+		{
+		}
+
+		void operator()(const PYXPointer<T> & value)
+		{
+			m_values.push_back(value);
+		}
+	};
+
+	//! Call the visitor with the tree position of all elements that intersect the circle.
+	template<class Visitor>
+	void visitPositions(const PYXBoundingCircle & circle,Visitor & visitor) const
+	{
+		assert(!circle.isEmpty() && "can't search an empty circle");
+
+		if (!m_nodes.empty())
+		{
+			visitNode(static_cast<int>(m_nodes.size())-1,circle,visitor);
+		}
+	}
+
+	template<class Visitor>
+	void visitNode(int nodeIndex,const PYXBoundingCircle & circle,Visitor & visitor) const
+	{
+		const Node & node = m_nodes[nodeIndex];
+
+		if (!circle.intersects(node.circle))
+		{
+			return;
+		}
+
+		const int end = node.first + node.count;
+		if (node.leaf)
+		{
+			for(int i=node.first;i<end;++i)
+			{
+				if (circle.intersects(m_circles[i]))
+				{
+					visitor(i);
+				}
+			}
+		}
+		else
+		{
+			for(int i=node.first;i<end;++i)
+			{
+				visitNode(i,circle,visitor);
+			}
+		}
+	}
+
+	//! Build the nodes bottom up: every node groups knNodeSize consecutive children.
+	void build()
+	{
+		const int nodeSize = knNodeSize;
+		const int count = static_cast<int>(m_circles.size());
+		if (count == 0)
+		{
+			return;
+		}
+
+		m_nodes.reserve(count / (nodeSize-1) + 2);
+
+		for(int first=0;first<count;first+=nodeSize)
+		{
+			Node node;
+			node.first = first;
+			node.count = std::min(nodeSize,count-first);
+			node.leaf = true;
+			for(int i=first;i<first+node.count;++i)
+			{
+				node.circle += m_circles[i];
+			}
+			m_nodes.push_back(node);
+		}
+
+		int levelBegin = 0;
+		int levelEnd = static_cast<int>(m_nodes.size());
+		while(levelEnd - levelBegin > 1)
+		{
+			for(int first=levelBegin;first<levelEnd;first+=nodeSize)
+			{
+				Node node;
+				node.first = first;
+				node.count = std::min(nodeSize,levelEnd-first);
+				node.leaf = false;
+				for(int i=first;i<first+node.count;++i)
+				{
+					node.circle += m_nodes[i].circle;
+				}
+				m_nodes.push_back(node);
+			}
+			levelBegin = levelEnd;
+			levelEnd = static_cast<int>(m_nodes.size());
+		}
+	}
+
+	//! The position of a point along a Z-order curve on the faces of a cube around the sphere.
+	static unsigned long long calcCurveKey(const PYXCoord3DDouble & point)
+	{
+		const double ax = std::abs(point.x());
+		const double ay = std::abs(point.y());
+		const double az = std::abs(point.z());
+
+		//project on the face of the largest coordinate
+		unsigned int face;
+		double u;
+		double v;
+		if (ax >= ay && ax >= az)
+		{
+			face = point.x() > 0 ? 0 : 1;
+			u = point.y() / ax;
+			v = point.z() / ax;
+		}
+		else if (ay >= az)
+		{
+			face = point.y() > 0 ? 2 : 3;
+			u = point.z() / ay;
+			v = point.x() / ay;
+		}
+		else
+		{
+			face = point.z() > 0 ? 4 : 5;
+			u = point.x() / az;
+			v = point.y() / az;
+		}
+
+		const unsigned int iu = static_cast<unsigned int>(std::min(65535.0,std::max(0.0,(u + 1) * 32768)));
+		const unsigned int iv = static_cast<unsigned int>(std::min(65535.0,std::max(0.0,(v + 1) * 32768)));
+
+		return (static_cast<unsigned long long>(face) << 32) | (spreadBits(iu) << 1) | spreadBits(iv);
+	}
+
+	//! Spread the 16 low bits of a value to the even bits.
+	static unsigned long long spreadBits(unsigned int value)
+	{
+		unsigned long long x = value & 0xFFFF;
+		x = (x | (x << 8)) & 0x00FF00FFull;
+		x = (x | (x << 4)) & 0x0F0F0F0Full;
+		x = (x | (x << 2)) & 0x33333333ull;
+		x = (x | (x << 1)) & 0x55555555ull;
+		return x;
+	}
+
+	static void saveCircle(PYXWireBuffer & buffer,const PYXBoundingCircle & circle)
+	{
+		buffer << circle.getCenter().x() << circle.getCenter().y() << circle.getCenter().z() << circle.getRadius();
+	}
+
+	static PYXBoundingCircle loadCircle(PYXWireBuffer & buffer)
+	{
+		double x,y,z,radius;
+		buffer >> x >> y >> z >> radius;
+		return PYXBoundingCircle(PYXCoord3DDouble(x,y,z),radius);
+	}
+};
+
+
+//! Time building and querying 20000 circles with both spatial sets (not run by the tests).
+PYXLIB_DECL void benchmarkBoundingCircleSpatialSets();
 
 #endif // guard
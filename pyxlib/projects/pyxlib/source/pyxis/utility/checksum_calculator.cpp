@@ -10,14 +10,23 @@ web			: www.pyxisinnovation.com
 
 #include "pyxis/utility/checksum_calculator.h"
 #include "pyxis/utility/exception.h"
+#include "pyxis/utility/native_checksum_calculator.h"
 #include "pyxis/utility/tester.h"
 
 static PYXPointer<ChecksumCalculator> getChecksumCalculator();
 
 PYXPointer<ChecksumCalculator> ChecksumCalculator::m_pCalculator;
 
+/*!
+Return the calculator injected with setChecksumCalculator(), or the native
+calculator if none was injected.
+*/
 PYXPointer<ChecksumCalculator> ChecksumCalculator::getChecksumCalculator()
 {
+	if (!m_pCalculator)
+	{
+		return NativeChecksumCalculator::getInstance();
+	}
 	return m_pCalculator;
 }
 
@@ -73,6 +73,12 @@ public:
 
 	PYXValue convert(double position,bool alpha = true) const;
 
+	//! The position of the first step, positions below it are converted to the first color.
+	double getMinPosition() const { return m_steps.empty() ? 0 : m_steps.front().position; }
+
+	//! The position of the last step, positions above it are converted to the last color.
+	double getMaxPosition() const { return m_steps.empty() ? 0 : m_steps.back().position; }
+
 public:
 	//! Unit test
 	static void test();
@@ -172,6 +178,9 @@ public:
 	bool isNumericPalette() { return m_numericPalette; }
 	bool isStringPalette() { return m_stringPalette; }
 
+	//! The palette used for numeric values, null for a string palette.
+	const PYXPointer<PYXColorPalette> & getNumericPalette() const { return m_numericPalette; }
+
 	void convert(const PYXValue & value,uint8_t *rgba, bool alpha = true) const;
 	void convert(const PYXValue & value,PYXValue & rgba) const;
 	PYXValue convert(const PYXValue & value,bool alpha = true) const;
@@ -0,0 +1,558 @@
+/******************************************************************************
+concurrent_cache.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/utility/concurrent_cache.h"
+
+// pyxlib includes
+#include "pyxis/utility/cache_map.h"
+#include "pyxis/utility/exception.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+#include "pyxis/utility/trace.h"
+
+// boost includes
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+// standard includes
+#include <algorithm>
+#include <cmath>
+
+///////////////////////////////////////////////////////////////////////////////
+// PYXFrequencySketch
+///////////////////////////////////////////////////////////////////////////////
+
+PYXFrequencySketch::PYXFrequencySketch(int nWidth) :
+	m_nWidth(knCountersPerWord),
+	m_nSamples(0)
+{
+	while (m_nWidth < nWidth)
+	{
+		m_nWidth *= 2;
+	}
+	m_nWordCount = knRows * m_nWidth / knCountersPerWord;
+	m_words.reset(new std::atomic<boost::uint64_t>[m_nWordCount]);
+	clear();
+}
+
+int PYXFrequencySketch::getCounterIndex(size_t nHash,int nRow) const
+{
+	//every row spreads the hash with a different odd multiplier
+	static const unsigned int knSeeds[knRows] = { 0x9E3779B1u, 0x85EBCA77u, 0xC2B2AE3Du, 0x27D4EB2Fu };
+
+	unsigned int nValue = static_cast<unsigned int>(nHash) * knSeeds[nRow];
+	nValue ^= nValue >> 15;
+
+	return nRow * m_nWidth + static_cast<int>(nValue & (m_nWidth - 1));
+}
+
+void PYXFrequencySketch::add(size_t nHash,int nCount)
+{
+	for(int nRow = 0;nRow < knRows;++nRow)
+	{
+		const int nIndex = getCounterIndex(nHash,nRow);
+		std::atomic<boost::uint64_t> & word = m_words[nIndex / knCountersPerWord];
+		const int nShift = (nIndex % knCountersPerWord) * 4;
+
+		boost::uint64_t nWord = word.load(std::memory_order_relaxed);
+		for(;;)
+		{
+			const int nCounter = static_cast<int>((nWord >> nShift) & knMaxCount);
+			if (nCounter == knMaxCount)
+			{
+				break;
+			}
+			const boost::uint64_t nNewCounter = std::min<int>(knMaxCount,nCounter + nCount);
+			const boost::uint64_t nNewWord = (nWord & ~(static_cast<boost::uint64_t>(knMaxCount) << nShift)) | (nNewCounter << nShift);
+			if (word.compare_exchange_weak(nWord,nNewWord,std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+	}
+
+	//only the thread crossing the threshold ages the counters
+	const int nAgeThreshold = 10 * m_nWidth;
+	const int nSamples = m_nSamples.fetch_add(nCount) + nCount;
+	if (nSamples >= nAgeThreshold && nSamples - nCount < nAgeThreshold)
+	{
+		age();
+		m_nSamples.fetch_sub(nAgeThreshold / 2);
+	}
+}
+
+int PYXFrequencySketch::estimate(size_t nHash) const
+{
+	int nEstimate = knMaxCount;
+	for(int nRow = 0;nRow < knRows;++nRow)
+	{
+		const int nIndex = getCounterIndex(nHash,nRow);
+		const boost::uint64_t nWord = m_words[nIndex / knCountersPerWord].load(std::memory_order_relaxed);
+		nEstimate = std::min<int>(nEstimate,static_cast<int>((nWord >> ((nIndex % knCountersPerWord) * 4)) & knMaxCount));
+	}
+	return nEstimate;
+}
+
+void PYXFrequencySketch::clear()
+{
+	for(int i=0;i<m_nWordCount;++i)
+	{
+		m_words[i].store(0,std::memory_order_relaxed);
+	}
+	m_nSamples = 0;
+}
+
+void PYXFrequencySketch::age()
+{
+	//halve the 16 counters of a word at once, dropping the bit shifted in from the next counter
+	for(int i=0;i<m_nWordCount;++i)
+	{
+		boost::uint64_t nWord = m_words[i].load(std::memory_order_relaxed);
+		while (!m_words[i].compare_exchange_weak(nWord,(nWord >> 1) & 0x7777777777777777ull,std::memory_order_relaxed))
+		{
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Testing
+///////////////////////////////////////////////////////////////////////////////
+
+//! Tester class
+Tester<PYXFrequencySketch> gTester;
+
+//! Test method
+void PYXFrequencySketch::test()
+{
+	PYXFrequencySketch sketch(64);
+
+	for(int i=0;i<5;++i)
+	{
+		sketch.add(1);
+	}
+	sketch.add(2,3);
+
+	TEST_ASSERT(sketch.estimate(1) >= 5);
+	TEST_ASSERT(sketch.estimate(2) >= 3);
+
+	sketch.add(1,100);
+	TEST_ASSERT_EQUAL(sketch.estimate(1),knMaxCount);
+
+	//enough samples to age the counters
+	for(int i=0;i<10*64;++i)
+	{
+		sketch.add(1000+i);
+	}
+	TEST_ASSERT(sketch.estimate(1) < knMaxCount);
+
+	sketch.clear();
+	TEST_ASSERT_EQUAL(sketch.estimate(1),0);
+
+	//concurrent updates of the same counters are not lost
+	{
+		PYXTaskGroup tasks;
+		for(int i=0;i<4;++i)
+		{
+			tasks.addTask(boost::bind(&PYXFrequencySketch::add,&sketch,7,3));
+		}
+		tasks.joinAll();
+	}
+	TEST_ASSERT(sketch.estimate(7) >= 12);
+}
+
+namespace
+{
+
+class ConcurrentCacheTester
+{
+public:
+	typedef boost::shared_ptr<std::vector<int> > TileData;
+	typedef ConcurrentCache<int,TileData> TileCache;
+	typedef ConcurrentCache<int,int> IntCache;
+
+	static const int knTileSize = 256;
+	static const int knTileCount = 20000;
+	static const int knRequestsPerTask = 50000;
+
+	//! Pick a tile with a skewed distribution: few tiles are requested often.
+	static int nextTile(unsigned int & nSeed)
+	{
+		nSeed = nSeed * 1103515245u + 12345u;
+		double fRandom = ((nSeed >> 8) & 0xFFFF) / 65536.0;
+		return static_cast<int>(knTileCount * fRandom * fRandom * fRandom);
+	}
+
+	static TileData loadTile(int nTile)
+	{
+		TileData tile(new std::vector<int>(knTileSize));
+		for(int i=0;i<knTileSize;++i)
+		{
+			(*tile)[i] = nTile * i;
+		}
+		return tile;
+	}
+
+	static void loadTilesFromConcurrentCache(TileCache * cache,unsigned int nSeed,int nRequests)
+	{
+		for(int i=0;i<nRequests;++i)
+		{
+			int nTile = nextTile(nSeed);
+			TileData tile;
+			if (!cache->tryGet(nTile,tile))
+			{
+				tile = cache->getOrPut(nTile,loadTile(nTile),knTileSize * sizeof(int));
+			}
+			assert((*tile)[1] == nTile);
+		}
+	}
+
+	static void loadTilesFromCacheMap(CacheMap<int,TileData> * cache,boost::mutex * mutex,unsigned int nSeed)
+	{
+		for(int i=0;i<knRequestsPerTask;++i)
+		{
+			int nTile = nextTile(nSeed);
+			TileData tile;
+			{
+				boost::mutex::scoped_lock lock(*mutex);
+				if (cache->exists(nTile))
+				{
+					tile = (*cache)[nTile];
+				}
+			}
+			if (!tile)
+			{
+				tile = loadTile(nTile);
+				boost::mutex::scoped_lock lock(*mutex);
+				(*cache)[nTile] = tile;
+			}
+			assert((*tile)[1] == nTile);
+		}
+	}
+
+	static size_t getUnitWeight(const int &)
+	{
+		return 1;
+	}
+
+	static int createValue(int nValue)
+	{
+		return nValue;
+	}
+
+	//! Create a value that depends on another value of the same shard.
+	static int createDependentValue(IntCache * cache)
+	{
+		return cache->getOrCreate(2,boost::bind(&createValue,20),&getUnitWeight) + 1;
+	}
+
+	static int createFailure()
+	{
+		PYXTHROW(PYXException,"The value can not be created.");
+	}
+
+	//! Create a value while the key is invalidated.
+	static int createErasedValue(IntCache * cache,int nKey)
+	{
+		cache->erase(nKey);
+		return 30;
+	}
+
+	//! Create a value slowly, counting the calls.
+	static int createSlowValue(boost::detail::atomic_count * pCalls)
+	{
+		++*pCalls;
+		boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+		return 40;
+	}
+
+	static void getSlowValue(IntCache * cache,boost::detail::atomic_count * pCalls,boost::detail::atomic_count * pWrongValues)
+	{
+		if (cache->getOrCreate(4,boost::bind(&createSlowValue,pCalls),&getUnitWeight) != 40)
+		{
+			++*pWrongValues;
+		}
+	}
+
+	static void testCreate()
+	{
+		IntCache cache(10,1,false);
+
+		//the factory runs without the shard lock, so it can use the cache
+		TEST_ASSERT_EQUAL(cache.getOrCreate(1,boost::bind(&createDependentValue,&cache),&getUnitWeight),21);
+		TEST_ASSERT(cache.exists(1));
+		TEST_ASSERT(cache.exists(2));
+		TEST_ASSERT_EQUAL(cache.getOrCreate(1,boost::bind(&createValue,0),&getUnitWeight),21);
+
+		//a failed creation can be retried
+		bool bThrown = false;
+		try
+		{
+			cache.getOrCreate(3,&createFailure,&getUnitWeight);
+		}
+		catch (PYXException&)
+		{
+			bThrown = true;
+		}
+		TEST_ASSERT(bThrown);
+		TEST_ASSERT(!cache.exists(3));
+		TEST_ASSERT_EQUAL(cache.getOrCreate(3,boost::bind(&createValue,3),&getUnitWeight),3);
+
+		//a value created while the key is erased is returned but not kept
+		cache.erase(3);
+		TEST_ASSERT_EQUAL(cache.getOrCreate(3,boost::bind(&createErasedValue,&cache,3),&getUnitWeight),30);
+		TEST_ASSERT(!cache.exists(3));
+
+		//concurrent requests of the same key create the value once
+		boost::detail::atomic_count nCalls(0);
+		boost::detail::atomic_count nWrongValues(0);
+		{
+			PYXTaskGroup tasks;
+			for(int i=0;i<8;++i)
+			{
+				tasks.addTask(boost::bind(&ConcurrentCacheTester::getSlowValue,&cache,&nCalls,&nWrongValues));
+			}
+			tasks.joinAll();
+		}
+		TEST_ASSERT_EQUAL((long)nCalls,1);
+		TEST_ASSERT_EQUAL((long)nWrongValues,0);
+	}
+
+	static void testAdmission()
+	{
+		IntCache cache(100,1,true);
+		int value = 0;
+
+		TEST_ASSERT(cache.put(1,1,40));
+		TEST_ASSERT(cache.put(2,2,40));
+		for(int i=0;i<10;++i)
+		{
+			TEST_ASSERT(cache.tryGet(2,value));
+		}
+
+		//key 3 needs both entries evicted but is less frequent than key 2: nothing is evicted
+		for(int i=0;i<3;++i)
+		{
+			TEST_ASSERT(!cache.tryGet(3,value));
+		}
+		TEST_ASSERT(!cache.put(3,3,60));
+		TEST_ASSERT(!cache.exists(3));
+		TEST_ASSERT(cache.exists(1));
+		TEST_ASSERT(cache.exists(2));
+		TEST_ASSERT_EQUAL(cache.getStatistics().evictions,0);
+		TEST_ASSERT_EQUAL(cache.getStatistics().rejections,1);
+
+		//key 4 is more frequent than both
+		for(int i=0;i<12;++i)
+		{
+			TEST_ASSERT(!cache.tryGet(4,value));
+		}
+		TEST_ASSERT(cache.put(4,4,60));
+		TEST_ASSERT(!cache.exists(1));
+		TEST_ASSERT(!cache.exists(2));
+		TEST_ASSERT_EQUAL(cache.getStatistics().evictions,2);
+	}
+
+	static void testClock()
+	{
+		ConcurrentCache<int,int> cache(10,1,false);
+
+		for(int i=1;i<=10;++i)
+		{
+			TEST_ASSERT(cache.put(i,i+1));
+		}
+		TEST_ASSERT_EQUAL(cache.size(),10u);
+
+		int value = 0;
+		TEST_ASSERT(cache.tryGet(5,value));
+		TEST_ASSERT_EQUAL(value,6);
+		TEST_ASSERT(!cache.tryGet(11,value));
+
+		//the first entry the hand reaches is evicted
+		TEST_ASSERT(cache.put(11,12));
+		TEST_ASSERT_EQUAL(cache.size(),10u);
+		TEST_ASSERT(!cache.exists(1));
+
+		//entries accessed since the hand passed get a second chance
+		for(int i=2;i<=9;++i)
+		{
+			TEST_ASSERT(cache.tryGet(i,value));
+		}
+		TEST_ASSERT(cache.put(12,13));
+		for(int i=2;i<=9;++i)
+		{
+			TEST_ASSERT(cache.exists(i));
+		}
+		TEST_ASSERT(!cache.exists(10));
+
+		cache.erase(12);
+		TEST_ASSERT(!cache.exists(12));
+		TEST_ASSERT_EQUAL(cache.size(),9u);
+
+		ConcurrentCache<int,int>::Statistics statistics = cache.getStatistics();
+		TEST_ASSERT_EQUAL(statistics.hits,9);
+		TEST_ASSERT_EQUAL(statistics.misses,1);
+		TEST_ASSERT_EQUAL(statistics.evictions,2);
+	}
+
+	static void testWeight()
+	{
+		ConcurrentCache<int,int> cache(100,1,false);
+
+		TEST_ASSERT(cache.put(1,1,60));
+		TEST_ASSERT(cache.put(2,2,30));
+		TEST_ASSERT_EQUAL(cache.getWeight(),90u);
+
+		TEST_ASSERT(cache.put(3,3,60));
+		TEST_ASSERT(!cache.exists(1));
+		TEST_ASSERT(cache.getWeight() <= 100u);
+
+		//heavier than the cache
+		TEST_ASSERT(!cache.put(4,4,200));
+		TEST_ASSERT(!cache.exists(4));
+		TEST_ASSERT_EQUAL(cache.getStatistics().rejections,1);
+
+		//getOrPut keeps the cached value
+		TEST_ASSERT_EQUAL(cache.getOrPut(3,30,60),3);
+
+		cache.setMaxWeight(50);
+		TEST_ASSERT(cache.getWeight() <= 50u);
+
+		cache.clear();
+		TEST_ASSERT_EQUAL(cache.size(),0u);
+		TEST_ASSERT_EQUAL(cache.getWeight(),0u);
+	}
+
+	static void testScanResistance()
+	{
+		const int nHotCount = 50;
+		ConcurrentCache<int,int> cache(100,1,true);
+		CacheMap<int,int> lru(100);
+
+		int value = 0;
+		for(int nRound=0;nRound<5;++nRound)
+		{
+			for(int i=0;i<nHotCount;++i)
+			{
+				if (!cache.tryGet(i,value))
+				{
+					cache.put(i,i);
+				}
+				lru[i] = i;
+			}
+		}
+
+		//a scan of keys used once
+		for(int i=1000;i<2000;++i)
+		{
+			if (!cache.tryGet(i,value))
+			{
+				cache.put(i,i);
+			}
+			lru[i] = i;
+		}
+
+		int nHotInCache = 0;
+		int nHotInLru = 0;
+		for(int i=0;i<nHotCount;++i)
+		{
+			nHotInCache += cache.exists(i) ? 1 : 0;
+			nHotInLru += lru.exists(i) ? 1 : 0;
+		}
+
+		TEST_ASSERT_EQUAL(nHotInLru,0);
+		TEST_ASSERT(nHotInCache >= nHotCount * 9 / 10);
+		TEST_ASSERT(cache.getStatistics().rejections > 0);
+	}
+
+	static void testConcurrentRequests()
+	{
+		const int nTasks = 4;
+		const int nRequests = 2000;
+		const size_t nCacheWeight = knTileCount / 100 * knTileSize * sizeof(int);
+
+		TileCache cache(nCacheWeight);
+		{
+			PYXTaskGroup tasks;
+			for(int i=0;i<nTasks;++i)
+			{
+				tasks.addTask(boost::bind(&ConcurrentCacheTester::loadTilesFromConcurrentCache,&cache,i+1,nRequests));
+			}
+			tasks.joinAll();
+		}
+
+		TileCache::Statistics statistics = cache.getStatistics();
+		TEST_ASSERT_EQUAL(statistics.hits+statistics.misses,(long)(nTasks*nRequests));
+		TEST_ASSERT(statistics.hits > 0);
+		TEST_ASSERT(statistics.weight <= nCacheWeight);
+	}
+
+	static void benchmark()
+	{
+		const int nTasks = 8;
+		const size_t nCacheWeight = knTileCount / 10 * knTileSize * sizeof(int);
+
+		PYXHighQualityTimer timer;
+
+		TileCache cache(nCacheWeight);
+		timer.start();
+		{
+			PYXTaskGroup tasks;
+			for(int i=0;i<nTasks;++i)
+			{
+				tasks.addTask(boost::bind(&ConcurrentCacheTester::loadTilesFromConcurrentCache,&cache,i+1,knRequestsPerTask));
+			}
+			tasks.joinAll();
+		}
+		timer.stop();
+		double fConcurrentTime = timer.getTime();
+
+		TileCache::Statistics statistics = cache.getStatistics();
+
+		CacheMap<int,TileData> lru(knTileCount / 10);
+		boost::mutex mutex;
+		timer.start();
+		{
+			PYXTaskGroup tasks;
+			for(int i=0;i<nTasks;++i)
+			{
+				tasks.addTask(boost::bind(&ConcurrentCacheTester::loadTilesFromCacheMap,&lru,&mutex,i+1));
+			}
+			tasks.joinAll();
+		}
+		timer.stop();
+		double fCacheMapTime = timer.getTime();
+
+		TRACE_INFO("ConcurrentCache: " << nTasks << " threads, " << nTasks*knRequestsPerTask << " tile requests in " << fConcurrentTime << "[sec], hit rate " << statistics.getHitRate()*100 << "%, " << statistics.evictions << " evictions, " << statistics.rejections << " rejections");
+		TRACE_INFO("CacheMap with a global mutex: " << nTasks << " threads, " << nTasks*knRequestsPerTask << " tile requests in " << fCacheMapTime << "[sec]");
+	}
+
+	static void test()
+	{
+		testClock();
+		testWeight();
+		testScanResistance();
+		testAdmission();
+		testCreate();
+		testConcurrentRequests();
+	}
+};
+
+//! Tester class
+Tester<ConcurrentCacheTester> gConcurrentCacheTester;
+
+}
+
+void benchmarkConcurrentCache()
+{
+	ConcurrentCacheTester::benchmark();
+}
@@ -0,0 +1,773 @@
+#ifndef PYXIS__UTILITY__CONCURRENT_CACHE_H
+#define PYXIS__UTILITY__CONCURRENT_CACHE_H
+/******************************************************************************
+concurrent_cache.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+
+// boost includes
+#include <boost/cstdint.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+// standard includes
+#include <atomic>
+#include <list>
+#include <vector>
+
+/*!
+Approximate access frequency of keys, used by ConcurrentCache to decide if a new
+key is worth evicting a resident one.
+
+A count-min sketch of 4 rows of 4 bit counters, packed 16 to a 64 bit word. The
+counters are updated with atomic compare and swap, so the sketch needs no lock and
+can be shared by concurrent readers. The counters are halved every 10 * width
+samples so the frequencies follow the recent workload.
+*/
+//! Count-min frequency sketch with aging.
+class PYXLIB_DECL PYXFrequencySketch : boost::noncopyable
+{
+public:
+	//! Test method
+	static void test();
+
+	static const int knRows = 4;
+	static const int knMaxCount = 15;
+
+public:
+	//! Create a sketch with at least the given number of counters per row.
+	explicit PYXFrequencySketch(int nWidth = 1024);
+
+	//! Record nCount accesses of the key with the given hash.
+	void add(size_t nHash,int nCount = 1);
+
+	//! Estimated number of recent accesses of the key with the given hash.
+	int estimate(size_t nHash) const;
+
+	//! Forget all the accesses.
+	void clear();
+
+private:
+	//! The position of the counter of a key in a row, over all the rows.
+	int getCounterIndex(size_t nHash,int nRow) const;
+
+	//! Halve all the counters.
+	void age();
+
+private:
+	static const int knCountersPerWord = 16;
+
+	int m_nWidth;
+	int m_nWordCount;
+	std::atomic<int> m_nSamples;
+	boost::scoped_array<std::atomic<boost::uint64_t>> m_words;
+};
+
+/*!
+ConcurrentCache is a thread safe cache intended to replace a CacheMap guarded by a
+global mutex on hot paths.
+
+- The keys are spread over independent shards by hash, every shard has its own lock
+  and its own share of the capacity.
+- Lookups take a shared lock only. A hit increments the entry access count atomically.
+- The capacity is a total weight (usually bytes), every entry has its own weight.
+- New entries go into a small FIFO window (1% of the capacity). The entries leaving
+  the window are candidates for the main space, which uses the CLOCK algorithm: the
+  hand gives a second chance to entries accessed since it last passed, and folds
+  their accesses into a frequency sketch.
+- When admission is enabled (W-TinyLFU), a candidate only evicts the entries the
+  hand selects if it was requested more often recently than each of them, otherwise
+  the candidate is dropped and nothing is evicted. A scan of keys used once can
+  therefore not flush the frequently used entries, while the window still gives
+  new keys a chance to build up their frequency.
+- Hit, miss, eviction and rejection counters are kept for tuning.
+
+Values are copied in and out of the cache, so Value should be cheap to copy
+(usually a PYXPointer).
+
+Usage:
+\code
+	PYXPointer<Tile> tile;
+	if (!s_cache.tryGet(key,tile))
+	{
+		tile = loadTile(key);
+		tile = s_cache.getOrPut(key,tile,tile->getMemorySize());
+	}
+
+	//or, to load every tile only once
+	tile = s_cache.getOrCreate(key,boost::bind(&loadTile,key),&getTileWeight);
+\endcode
+*/
+//! Sharded thread safe cache with weight based capacity and frequency based admission.
+template<typename Key,typename Value,typename Hash = boost::hash<Key> >
+class ConcurrentCache : boost::noncopyable
+{
+public:
+	struct Statistics
+	{
+		long hits;
+		long misses;
+		long evictions;
+		long rejections;
+		size_t count;
+		size_t weight;
+
+		double getHitRate() const
+		{
+			return hits+misses > 0 ? (double)hits/(hits+misses) : 0;
+		}
+	};
+
+public:
+	/*!
+	Create a cache.
+
+	\param nMaxWeight	The total weight of the entries kept in the cache.
+	\param nShardCount	Number of shards (rounded up to a power of 2). Every shard holds
+						nMaxWeight/nShardCount, so small caches should use a single shard.
+	\param bAdmission	Whether new keys have to be more frequent than the evicted ones.
+	*/
+	explicit ConcurrentCache(size_t nMaxWeight,int nShardCount = 16,bool bAdmission = true) :
+		m_nMaxWeight(nMaxWeight),
+		m_bAdmission(bAdmission),
+		m_hits(0),
+		m_misses(0),
+		m_evictions(0),
+		m_rejections(0)
+	{
+		int nShards = 1;
+		while (nShards < nShardCount)
+		{
+			nShards *= 2;
+		}
+
+		for(int i=0;i<nShards;++i)
+		{
+			m_shards.push_back(new Shard());
+		}
+		for(unsigned int i=0;i<m_shards.size();++i)
+		{
+			setShardCapacity(*m_shards[i]);
+		}
+	}
+
+	~ConcurrentCache()
+	{
+		clear();
+		for(unsigned int i=0;i<m_shards.size();++i)
+		{
+			delete m_shards[i];
+		}
+	}
+
+public:
+	//! Find a value in the cache, return false on a miss.
+	bool tryGet(const Key & key,Value & value)
+	{
+		const size_t nHash = m_hash(key);
+		Shard & shard = getShard(nHash);
+
+		{
+			boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+
+			typename EntryMap::const_iterator it = shard.map.find(key);
+			if (it != shard.map.end())
+			{
+				++it->second->accessCount;
+				value = it->second->value;
+				++m_hits;
+				return true;
+			}
+		}
+
+		++m_misses;
+		shard.sketch.add(nHash);
+		return false;
+	}
+
+	//! Check if a key is in the cache, without counting an access.
+	bool exists(const Key & key) const
+	{
+		const size_t nHash = m_hash(key);
+		Shard & shard = getShard(nHash);
+
+		boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+		return shard.map.find(key) != shard.map.end();
+	}
+
+	/*!
+	Add or replace a value.
+
+	\return false if the key was rejected by the admission policy (or is heavier than a shard).
+	*/
+	bool put(const Key & key,const Value & value,size_t nWeight = 1)
+	{
+		const size_t nHash = m_hash(key);
+		Shard & shard = getShard(nHash);
+
+		boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+
+		//a replaced value starts over in the window
+		typename EntryMap::iterator it = shard.map.find(key);
+		if (it != shard.map.end())
+		{
+			remove(shard,it->second);
+		}
+
+		if (nWeight > shard.capacity)
+		{
+			++m_rejections;
+			return false;
+		}
+
+		insert(shard,key,nHash,value,nWeight);
+		return shard.map.find(key) != shard.map.end();
+	}
+
+	/*!
+	Add a value unless the key is already in the cache.
+
+	\return The value in the cache, or the given value if it was not admitted.
+	*/
+	Value getOrPut(const Key & key,const Value & value,size_t nWeight = 1)
+	{
+		const size_t nHash = m_hash(key);
+		Shard & shard = getShard(nHash);
+
+		boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+
+		typename EntryMap::iterator it = shard.map.find(key);
+		if (it != shard.map.end())
+		{
+			++it->second->accessCount;
+			return it->second->value;
+		}
+
+		if (nWeight > shard.capacity)
+		{
+			++m_rejections;
+			return value;
+		}
+
+		insert(shard,key,nHash,value,nWeight);
+		return value;
+	}
+
+	/*!
+	Find a value, or create it. The value is created once: the first caller leaves a
+	placeholder in the shard and runs the factory without holding any lock, and the
+	other callers of the same key wait for it. Other keys of the shard are not blocked,
+	so the factory may use the cache, but not for the key being created.
+
+	If the key is erased while its value is being created, the value is returned to the
+	callers waiting for it but not kept, so an invalidation can not be overwritten by a
+	value created from stale data. If the factory throws, the exception goes to the
+	caller that ran it and the waiting callers try again.
+
+	\param factory		Value () - create the value.
+	\param getWeight	size_t (const Value &) - weight of the created value.
+	*/
+	template<typename Factory,typename WeightFunction>
+	Value getOrCreate(const Key & key,Factory factory,WeightFunction getWeight)
+	{
+		const size_t nHash = m_hash(key);
+		Shard & shard = getShard(nHash);
+
+		Value value;
+		for(;;)
+		{
+			if (tryGet(key,value))
+			{
+				return value;
+			}
+
+			boost::shared_ptr<Pending> pending;
+			bool bCreate = false;
+			{
+				boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+
+				typename EntryMap::iterator it = shard.map.find(key);
+				if (it != shard.map.end())
+				{
+					++it->second->accessCount;
+					return it->second->value;
+				}
+
+				typename PendingMap::iterator itPending = shard.pending.find(key);
+				if (itPending != shard.pending.end())
+				{
+					pending = itPending->second;
+				}
+				else
+				{
+					pending.reset(new Pending());
+					shard.pending[key] = pending;
+					bCreate = true;
+				}
+			}
+
+			if (!bCreate)
+			{
+				if (pending->wait(value))
+				{
+					return value;
+				}
+				continue;
+			}
+
+			try
+			{
+				value = factory();
+			}
+			catch (...)
+			{
+				{
+					boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+					dropPending(shard,key,pending);
+				}
+				pending->fail();
+				throw;
+			}
+			const size_t nWeight = getWeight(value);
+
+			{
+				boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+
+				if (dropPending(shard,key,pending))
+				{
+					if (nWeight > shard.capacity)
+					{
+						++m_rejections;
+					}
+					else
+					{
+						insert(shard,key,nHash,value,nWeight);
+					}
+				}
+			}
+
+			pending->complete(value);
+			return value;
+		}
+	}
+
+	void erase(const Key & key)
+	{
+		Shard & shard = getShard(m_hash(key));
+
+		boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+
+		typename EntryMap::iterator it = shard.map.find(key);
+		if (it != shard.map.end())
+		{
+			remove(shard,it->second);
+		}
+
+		//a value being created will not be kept
+		shard.pending.erase(key);
+	}
+
+	//! Remove all entries, the frequency history is kept.
+	void clear()
+	{
+		for(unsigned int i=0;i<m_shards.size();++i)
+		{
+			Shard & shard = *m_shards[i];
+			boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+
+			for(typename EntryMap::iterator it = shard.map.begin();it != shard.map.end();++it)
+			{
+				delete it->second;
+			}
+			shard.map.clear();
+			shard.pending.clear();
+			shard.window.clear();
+			shard.clock.clear();
+			shard.windowWeight = 0;
+			shard.mainWeight = 0;
+			shard.hand = 0;
+		}
+	}
+
+	size_t size() const
+	{
+		size_t nCount = 0;
+		for(unsigned int i=0;i<m_shards.size();++i)
+		{
+			boost::shared_lock<boost::shared_mutex> lock(m_shards[i]->mutex);
+			nCount += m_shards[i]->map.size();
+		}
+		return nCount;
+	}
+
+	size_t getWeight() const
+	{
+		size_t nWeight = 0;
+		for(unsigned int i=0;i<m_shards.size();++i)
+		{
+			boost::shared_lock<boost::shared_mutex> lock(m_shards[i]->mutex);
+			nWeight += m_shards[i]->windowWeight + m_shards[i]->mainWeight;
+		}
+		return nWeight;
+	}
+
+	size_t getMaxWeight() const
+	{
+		return m_nMaxWeight;
+	}
+
+	void setMaxWeight(size_t nMaxWeight)
+	{
+		m_nMaxWeight = nMaxWeight;
+
+		for(unsigned int i=0;i<m_shards.size();++i)
+		{
+			boost::unique_lock<boost::shared_mutex> lock(m_shards[i]->mutex);
+			setShardCapacity(*m_shards[i]);
+			drainWindow(*m_shards[i]);
+			evictToCapacity(*m_shards[i]);
+		}
+	}
+
+	Statistics getStatistics() const
+	{
+		Statistics statistics;
+		statistics.hits = m_hits;
+		statistics.misses = m_misses;
+		statistics.evictions = m_evictions;
+		statistics.rejections = m_rejections;
+		statistics.count = size();
+		statistics.weight = getWeight();
+		return statistics;
+	}
+
+private:
+	struct Entry
+	{
+		Key key;
+		Value value;
+		size_t hash;
+		size_t weight;
+
+		//! whether the entry is in the window or in the clock
+		bool inWindow;
+
+		//! position in the window
+		typename std::list<Entry*>::iterator windowPosition;
+
+		//! position in the clock
+		size_t slot;
+
+		//! set while the clock hand selects victims
+		bool selected;
+
+		//! incremented by the lookups (under a shared lock)
+		boost::detail::atomic_count accessCount;
+
+		//! the access count last folded into the sketch (under the exclusive lock)
+		long sweepCount;
+
+		Entry(const Key & aKey,size_t nHash,const Value & aValue,size_t nWeight) :
+			key(aKey), value(aValue), hash(nHash), weight(nWeight), inWindow(false), slot(0), selected(false), accessCount(0), sweepCount(0)
+		{
+		}
+	};
+
+	//! A value being created by getOrCreate.
+	class Pending : boost::noncopyable
+	{
+	public:
+		Pending() : m_bDone(false), m_bFailed(false)
+		{
+		}
+
+		void complete(const Value & value)
+		{
+			boost::mutex::scoped_lock lock(m_mutex);
+			m_value = value;
+			m_bDone = true;
+			m_done.notify_all();
+		}
+
+		void fail()
+		{
+			boost::mutex::scoped_lock lock(m_mutex);
+			m_bFailed = true;
+			m_bDone = true;
+			m_done.notify_all();
+		}
+
+		//! Wait for the value, return false if the creation failed.
+		bool wait(Value & value)
+		{
+			boost::mutex::scoped_lock lock(m_mutex);
+			while (!m_bDone)
+			{
+				m_done.wait(lock);
+			}
+			if (m_bFailed)
+			{
+				return false;
+			}
+			value = m_value;
+			return true;
+		}
+
+	private:
+		boost::mutex m_mutex;
+		boost::condition_variable m_done;
+		bool m_bDone;
+		bool m_bFailed;
+		Value m_value;
+	};
+
+	typedef boost::unordered_map<Key,Entry*,Hash> EntryMap;
+	typedef boost::unordered_map<Key,boost::shared_ptr<Pending>,Hash> PendingMap;
+
+	struct Shard : boost::noncopyable
+	{
+		mutable boost::shared_mutex mutex;
+		EntryMap map;
+		PendingMap pending;
+
+		//! new entries, oldest first
+		std::list<Entry*> window;
+		size_t windowWeight;
+		size_t windowCapacity;
+
+		std::vector<Entry*> clock;
+		size_t hand;
+		size_t mainWeight;
+		size_t mainCapacity;
+
+		//! windowCapacity + mainCapacity
+		size_t capacity;
+
+		PYXFrequencySketch sketch;
+
+		Shard() : windowWeight(0), windowCapacity(0), hand(0), mainWeight(0), mainCapacity(0), capacity(0)
+		{
+		}
+	};
+
+private:
+	Shard & getShard(size_t nHash) const
+	{
+		//use the high bits for the shard, the low bits are used by the map buckets
+		return *m_shards[((nHash >> 16) ^ nHash) & (m_shards.size()-1)];
+	}
+
+	//! Split the max weight over the shards, the caller holds the lock of the shard.
+	void setShardCapacity(Shard & shard)
+	{
+		const size_t nCapacity = (m_nMaxWeight + m_shards.size() - 1) / m_shards.size();
+		shard.capacity = nCapacity;
+		shard.windowCapacity = nCapacity / 100;
+		shard.mainCapacity = nCapacity - nCapacity / 100;
+	}
+
+	//! Remove the placeholder of a key if it is still there, return false if it was erased.
+	bool dropPending(Shard & shard,const Key & key,const boost::shared_ptr<Pending> & pending)
+	{
+		typename PendingMap::iterator it = shard.pending.find(key);
+		if (it == shard.pending.end() || it->second != pending)
+		{
+			return false;
+		}
+		shard.pending.erase(it);
+		return true;
+	}
+
+	//! Add an entry to the window, the entries leaving the window may be rejected.
+	void insert(Shard & shard,const Key & key,size_t nHash,const Value & value,size_t nWeight)
+	{
+		Entry * entry = new Entry(key,nHash,value,nWeight);
+		entry->inWindow = true;
+		entry->windowPosition = shard.window.insert(shard.window.end(),entry);
+		shard.windowWeight += nWeight;
+		shard.map[key] = entry;
+
+		drainWindow(shard);
+	}
+
+	void remove(Shard & shard,Entry * entry)
+	{
+		if (entry->inWindow)
+		{
+			shard.window.erase(entry->windowPosition);
+			shard.windowWeight -= entry->weight;
+		}
+		else
+		{
+			Entry * last = shard.clock.back();
+			shard.clock[entry->slot] = last;
+			last->slot = entry->slot;
+			shard.clock.pop_back();
+			shard.mainWeight -= entry->weight;
+		}
+
+		shard.map.erase(entry->key);
+		delete entry;
+	}
+
+	//! Record the accesses of an entry since the last time in the sketch.
+	void foldAccesses(Shard & shard,Entry * entry)
+	{
+		const long nAccessCount = entry->accessCount;
+		if (nAccessCount != entry->sweepCount)
+		{
+			shard.sketch.add(entry->hash,nAccessCount - entry->sweepCount);
+			entry->sweepCount = nAccessCount;
+		}
+	}
+
+	//! Move the oldest entries of the window to the main space while the window is too heavy.
+	void drainWindow(Shard & shard)
+	{
+		while (shard.windowWeight > shard.windowCapacity && !shard.window.empty())
+		{
+			Entry * candidate = shard.window.front();
+			shard.window.pop_front();
+			shard.windowWeight -= candidate->weight;
+			candidate->inWindow = false;
+
+			admit(shard,candidate);
+		}
+	}
+
+	/*!
+	Move a candidate from the window to the clock, if it is worth the entries it evicts.
+	The victims are selected first and compared to the candidate, so a rejected candidate
+	does not evict anything.
+	*/
+	void admit(Shard & shard,Entry * candidate)
+	{
+		foldAccesses(shard,candidate);
+
+		std::vector<Entry*> victims;
+		if (candidate->weight <= shard.mainCapacity &&
+			shard.mainWeight + candidate->weight > shard.mainCapacity)
+		{
+			selectVictims(shard,shard.mainWeight + candidate->weight - shard.mainCapacity,victims);
+		}
+
+		bool bAdmit = candidate->weight <= shard.mainCapacity;
+		if (bAdmit && m_bAdmission && !victims.empty())
+		{
+			const int nFrequency = shard.sketch.estimate(candidate->hash);
+			for(unsigned int i=0;i<victims.size() && bAdmit;++i)
+			{
+				bAdmit = nFrequency > shard.sketch.estimate(victims[i]->hash);
+			}
+		}
+
+		for(unsigned int i=0;i<victims.size();++i)
+		{
+			victims[i]->selected = false;
+		}
+
+		if (!bAdmit)
+		{
+			//the candidate is not in the window nor in the clock anymore
+			shard.map.erase(candidate->key);
+			delete candidate;
+			++m_rejections;
+			return;
+		}
+
+		for(unsigned int i=0;i<victims.size();++i)
+		{
+			remove(shard,victims[i]);
+			++m_evictions;
+		}
+
+		candidate->slot = shard.clock.size();
+		shard.clock.push_back(candidate);
+		shard.mainWeight += candidate->weight;
+	}
+
+	/*!
+	Move the clock hand until the entries it stops at weigh nWeight. Entries accessed
+	since the hand last passed get a second chance, and their accesses are recorded in
+	the sketch. The victims are marked selected and are not removed.
+	*/
+	void selectVictims(Shard & shard,size_t nWeight,std::vector<Entry*> & victims)
+	{
+		size_t nSelectedWeight = 0;
+		while (nSelectedWeight < nWeight && victims.size() < shard.clock.size())
+		{
+			if (shard.hand >= shard.clock.size())
+			{
+				shard.hand = 0;
+			}
+
+			Entry * entry = shard.clock[shard.hand++];
+			if (entry->selected)
+			{
+				continue;
+			}
+
+			if (entry->accessCount != entry->sweepCount)
+			{
+				foldAccesses(shard,entry);
+				continue;
+			}
+
+			entry->selected = true;
+			victims.push_back(entry);
+			nSelectedWeight += entry->weight;
+		}
+
+		//the hand stays at the first victim, the slot is reused by the clock when it is removed
+		if (!victims.empty())
+		{
+			shard.hand = victims[0]->slot;
+		}
+	}
+
+	//! Evict entries until the main space fits its capacity.
+	void evictToCapacity(Shard & shard)
+	{
+		std::vector<Entry*> victims;
+		while (shard.mainWeight > shard.mainCapacity && !shard.clock.empty())
+		{
+			victims.clear();
+			selectVictims(shard,shard.mainWeight - shard.mainCapacity,victims);
+			for(unsigned int i=0;i<victims.size();++i)
+			{
+				remove(shard,victims[i]);
+				++m_evictions;
+			}
+		}
+	}
+
+private:
+	std::vector<Shard*> m_shards;
+	Hash m_hash;
+	size_t m_nMaxWeight;
+	bool m_bAdmission;
+
+	boost::detail::atomic_count m_hits;
+	boost::detail::atomic_count m_misses;
+	boost::detail::atomic_count m_evictions;
+	boost::detail::atomic_count m_rejections;
+};
+
+//! Compare ConcurrentCache with a CacheMap guarded by a global mutex under 8 threads (not run by the tests).
+PYXLIB_DECL void benchmarkConcurrentCache();
+
+#endif // guard
@@ -20,9 +20,10 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/ssl_utils.h"
 #include "pyxis/utility/tester.h"
 #include "pyxis/utility/profile.h"
-#include "pyxis/utility/cache_map.h"
+#include "pyxis/utility/concurrent_cache.h"
 #include "pyxis/utility/app_services.h"
 
+#include "boost/bind.hpp"
 #include "boost/shared_ptr.hpp"
 #include "boost/weak_ptr.hpp"
 #include "boost/algorithm/string/predicate.hpp"
@@ -553,6 +554,20 @@ public:
 		m_stream.read((char *)&m_records[0],m_records.size() * sizeof(Record));
 	}
 
+	//! an open chunk also holds a file handle, it is accounted as 64K so a 16MB cache keeps at most 256 files open.
+	static const int knOpenFileWeight = 64 * 1024;
+
+	//! memory used by an open chunk: the records table and the file stream.
+	size_t getMemorySize() const
+	{
+		return sizeof(HashedKeyValueChunk) + m_records.size() * sizeof(Record) + knOpenFileWeight;
+	}
+
+	static size_t getMemorySizeOf(const PYXPointer<HashedKeyValueChunk> & chunk)
+	{
+		return chunk->getMemorySize();
+	}
+
 	bool has(const std::string & key) const
 	{
 		RecordId id(key);
@@ -701,44 +716,29 @@ private:
 	std::string m_path;
 
 protected:
-	static boost::recursive_mutex s_liveChunksMutex;
-	static CacheMap<std::string, PYXPointer<HashedKeyValueChunk>> s_liveChunks;
+	static ConcurrentCache<std::string, PYXPointer<HashedKeyValueChunk>> s_liveChunks;
 
 	static PYXPointer<HashedKeyValueChunk> getChunk(const std::string & file) 
 	{
-		static int requests = 0;
-		static int hits = 0;
-
-		boost::recursive_mutex::scoped_lock lock(s_liveChunksMutex);
+		static boost::detail::atomic_count requests(0);
 
-		if (requests == 1000)
+		if (++requests % 1000 == 0)
 		{
-			TRACE_INFO("getChunk hit rate" << (100.0*hits/requests) << "%");
-			requests=0;
-			hits=0;
+			TRACE_INFO("getChunk hit rate " << (100.0*s_liveChunks.getStatistics().getHitRate()) << "%");
 		}
 
-		requests++;
-
-		if (s_liveChunks.exists(file)) 
-		{
-			hits++;
-			return s_liveChunks[file];
-		}
-		auto newChunk = HashedKeyValueChunk::create(file);
-		s_liveChunks[file] = newChunk;
-		return newChunk;
+		//the chunk is loaded outside the cache lock. invalidateChunk drops the pending placeholder,
+		//so a load that started before the file changed is returned to its caller but never cached
+		return s_liveChunks.getOrCreate(file,boost::bind(&HashedKeyValueChunk::create,file),&HashedKeyValueChunk::getMemorySizeOf);
 	}
 
 	static void invalidateChunk(const std::string & file)
 	{
-		boost::recursive_mutex::scoped_lock lock(s_liveChunksMutex);
 		s_liveChunks.erase(file);
 	}
 
 	static void invalidateAllChunks()
 	{
-		boost::recursive_mutex::scoped_lock lock(s_liveChunksMutex);
 		s_liveChunks.clear();
 	}
 
@@ -1047,8 +1047,8 @@ public:
 	}
 };
 
-boost::recursive_mutex VerySimpleFileBasedLocalStorage::s_liveChunksMutex;
-CacheMap<std::string, PYXPointer<HashedKeyValueChunk>> VerySimpleFileBasedLocalStorage::s_liveChunks(256);
+//16MB of open chunks (at most 256 open files), sharded so concurrent tile loading does not contend on a single lock
+ConcurrentCache<std::string, PYXPointer<HashedKeyValueChunk>> VerySimpleFileBasedLocalStorage::s_liveChunks(16 * 1024 * 1024);
 
 
 class RESTLocalStorage : public PYXLocalStorage
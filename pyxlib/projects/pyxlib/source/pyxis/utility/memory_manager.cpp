@@ -23,7 +23,9 @@ web			: www.pyxisinnovation.com
 #include "sqlite3.h"
 
 // standard includes
+#include <algorithm>
 #include <cassert>
+#include <typeinfo>
 
 //! The singleton instance of the memory manager
 MemoryManager* MemoryManager::m_pInstance = 0;
@@ -60,6 +62,35 @@ void MemoryConsumer::unregisterConsumer()
 	MemoryManager::getInstance()->unregisterConsumer(this);
 }
 
+std::string MemoryConsumer::getMemoryConsumerName() const
+{
+	return typeid(*this).name();
+}
+
+/*!
+Register an item for global eviction. The memory manager will call freeMemoryItem
+when the item is the cheapest to rebuild per byte.
+
+\param	nBytes	The memory used by the item.
+\param	cost	The cost to rebuild the item (for example ICoverage::getTileCost).
+
+\return	The item identifier.
+*/
+MemoryItemId MemoryConsumer::registerMemoryItem(size_t nBytes,const PYXCost & cost)
+{
+	return MemoryManager::getInstance()->registerItem(this,nBytes,cost);
+}
+
+void MemoryConsumer::accessMemoryItem(MemoryItemId nItemId)
+{
+	MemoryManager::getInstance()->accessItem(nItemId);
+}
+
+void MemoryConsumer::unregisterMemoryItem(MemoryItemId nItemId)
+{
+	MemoryManager::getInstance()->unregisterItem(nItemId);
+}
+
 
 VaryingMemoryUsed::VaryingMemoryUsed(size_t nNumBytes) : m_nNumBytes(0)
 {
@@ -159,10 +190,111 @@ MemoryResource::~MemoryResource()
 	delete[] m_ptr;
 }
 
+namespace
+{
+
+//! A consumer of items with known sizes and costs, used to test the item eviction.
+class MemoryItemTestConsumer : public MemoryConsumer
+{
+public:
+	MemoryItemTestConsumer() : m_lockedItem(0)
+	{
+	}
+
+	virtual ~MemoryItemTestConsumer()
+	{
+		for(std::map<MemoryItemId,std::string>::iterator it = m_items.begin(); it != m_items.end(); ++it)
+		{
+			unregisterMemoryItem(it->first);
+		}
+	}
+
+	MemoryItemId add(const std::string & name,size_t nBytes,const PYXCost & cost)
+	{
+		MemoryItemId nItemId = registerMemoryItem(nBytes,cost);
+		m_items[nItemId] = name;
+		return nItemId;
+	}
+
+	void access(MemoryItemId nItemId)
+	{
+		accessMemoryItem(nItemId);
+	}
+
+	//! the item can't be freed, as if it was in use
+	void lock(MemoryItemId nItemId)
+	{
+		m_lockedItem = nItemId;
+	}
+
+	virtual void freeMemory()
+	{
+	}
+
+	virtual bool freeMemoryItem(MemoryItemId nItemId)
+	{
+		if (nItemId == m_lockedItem)
+		{
+			return false;
+		}
+		m_freed.push_back(m_items[nItemId]);
+		m_items.erase(nItemId);
+		unregisterMemoryItem(nItemId);
+		return true;
+	}
+
+	virtual std::string getMemoryConsumerName() const
+	{
+		return "test items";
+	}
+
+	std::vector<std::string> m_freed;
+
+private:
+	std::map<MemoryItemId,std::string> m_items;
+	MemoryItemId m_lockedItem;
+};
+
+}
+
+void MemoryManager::testMemoryItems()
+{
+	const size_t MB = 1024 * 1024;
+
+	MemoryItemTestConsumer consumer;
+	MemoryManager* pMemManager = MemoryManager::getInstance();
+
+	MemoryItemId expensive = consumer.add("expensive",MB,PYXCost(10));
+	consumer.add("cheap",MB,PYXCost(0.01));
+	consumer.add("large",10*MB,PYXCost(1));
+	MemoryItemId small = consumer.add("small",MB/10,PYXCost(0.01));
+
+	TEST_ASSERT_EQUAL(pMemManager->getMemoryStatus()["cache:test items"],(long)(12*MB+MB/10));
+
+	//the cheapest to rebuild per byte is evicted first
+	TEST_ASSERT_EQUAL(pMemManager->freeMemoryItems(1),MB);
+	TEST_ASSERT_EQUAL(consumer.m_freed.back(),"cheap");
+
+	//large and small have the same cost per byte, but small was used recently
+	consumer.access(small);
+	TEST_ASSERT_EQUAL(pMemManager->freeMemoryItems(1),10*MB);
+	TEST_ASSERT_EQUAL(consumer.m_freed.back(),"large");
+
+	//an item that can't be freed is skipped
+	consumer.lock(small);
+	TEST_ASSERT_EQUAL(pMemManager->freeMemoryItems(1),MB);
+	TEST_ASSERT_EQUAL(consumer.m_freed.back(),"expensive");
+	TEST_ASSERT_EQUAL(consumer.m_freed.size(),3u);
+
+	TEST_ASSERT_EQUAL(pMemManager->getMemoryStatus()["cache:test items"],(long)(MB/10));
+}
+
 //! The unit test class
 Tester<MemoryManager> gTester( knRunTestOnlyInForeground);
 void MemoryManager::test()
 {
+	testMemoryItems();
+
 	return;
 	TRACE_INFO("MEMORY Manager Test");
 
@@ -326,7 +458,10 @@ MemoryManager::MemoryManager() :
 	m_nMaximumAllocation(0),
 	m_nNextConsumerToFreeMemory(0),
 	m_ticksToUpdateOtherMemoryAllocated(0),
-	m_nOtherMemoryAllocated(0)
+	m_nOtherMemoryAllocated(0),
+	m_fInflation(0),
+	m_nNextItemId(1),
+	m_nAccessTick(0)
 {
 	MemUtils::MemStatus memStatus;
 
@@ -438,9 +573,143 @@ std::map<std::string,long> MemoryManager::getMemoryStatus()
 		status[it->first] = it->second->getByteCount();
 	}
 
+	//memory of the registered items, per consumer
+	for(std::map<MemoryConsumer*,size_t>::iterator it = m_consumerItemBytes.begin(); it != m_consumerItemBytes.end(); ++it)
+	{
+		status["cache:" + it->first->getMemoryConsumerName()] += (long)it->second;
+	}
+
 	return status;
 }
 
+MemoryManager::MemoryItemOrder MemoryManager::getItemOrder(MemoryItemId nItemId,const MemoryItem & item)
+{
+	MemoryItemOrder order;
+	order.fPriority = item.fPriority;
+	order.nLastAccess = item.nLastAccess;
+	order.nItemId = nItemId;
+	return order;
+}
+
+void MemoryManager::renewItem(MemoryItemId nItemId,MemoryItem & item)
+{
+	const double MB = 1024 * 1024;
+
+	m_itemsOrder.erase(getItemOrder(nItemId,item));
+	item.fPriority = m_fInflation + item.fCost * MB / std::max<size_t>(item.nBytes,1);
+	item.nLastAccess = ++m_nAccessTick;
+	m_itemsOrder.insert(getItemOrder(nItemId,item));
+}
+
+MemoryItemId MemoryManager::registerItem(MemoryConsumer* pConsumer,size_t nBytes,const PYXCost & cost)
+{
+	boost::recursive_mutex::scoped_lock lock(s_memoryManagerMutex);
+
+	MemoryItemId nItemId = m_nNextItemId++;
+	if (m_nNextItemId == 0)
+	{
+		m_nNextItemId = 1;
+	}
+
+	MemoryItem & item = m_items[nItemId];
+	item.pConsumer = pConsumer;
+	item.nBytes = nBytes;
+	item.fCost = cost.getAverageCost();
+	item.fPriority = 0;
+	item.nLastAccess = 0;
+	renewItem(nItemId,item);
+
+	m_consumerItemBytes[pConsumer] += nBytes;
+
+	return nItemId;
+}
+
+void MemoryManager::accessItem(MemoryItemId nItemId)
+{
+	boost::recursive_mutex::scoped_lock lock(s_memoryManagerMutex);
+
+	std::map<MemoryItemId,MemoryItem>::iterator it = m_items.find(nItemId);
+	if (it != m_items.end())
+	{
+		renewItem(nItemId,it->second);
+	}
+}
+
+void MemoryManager::unregisterItem(MemoryItemId nItemId)
+{
+	boost::recursive_mutex::scoped_lock lock(s_memoryManagerMutex);
+
+	std::map<MemoryItemId,MemoryItem>::iterator it = m_items.find(nItemId);
+	if (it == m_items.end())
+	{
+		return;
+	}
+
+	m_itemsOrder.erase(getItemOrder(nItemId,it->second));
+
+	std::map<MemoryConsumer*,size_t>::iterator itBytes = m_consumerItemBytes.find(it->second.pConsumer);
+	if (itBytes != m_consumerItemBytes.end())
+	{
+		itBytes->second -= std::min(itBytes->second,it->second.nBytes);
+		if (itBytes->second == 0)
+		{
+			m_consumerItemBytes.erase(itBytes);
+		}
+	}
+
+	m_items.erase(it);
+}
+
+size_t MemoryManager::freeMemoryItems(size_t nBytes)
+{
+	size_t nFreed = 0;
+
+	//every item is asked at most once
+	size_t nAttempts;
+	{
+		boost::recursive_mutex::scoped_lock lock(s_memoryManagerMutex);
+		nAttempts = m_items.size();
+	}
+
+	while (nFreed < nBytes && nAttempts-- > 0)
+	{
+		MemoryItemId nItemId;
+		MemoryConsumer* pConsumer;
+		size_t nItemBytes;
+		double fPriority;
+
+		{
+			boost::recursive_mutex::scoped_lock lock(s_memoryManagerMutex);
+
+			if (m_itemsOrder.empty())
+			{
+				break;
+			}
+
+			nItemId = m_itemsOrder.begin()->nItemId;
+			MemoryItem & item = m_items[nItemId];
+			pConsumer = item.pConsumer;
+			nItemBytes = item.nBytes;
+			fPriority = item.fPriority;
+
+			//move the item back in the queue, in case it can't be freed now
+			renewItem(nItemId,item);
+		}
+
+		//the consumer is called without holding the manager lock, it will call unregisterMemoryItem
+		if (pConsumer->freeMemoryItem(nItemId))
+		{
+			unregisterItem(nItemId);
+			nFreed += nItemBytes;
+
+			boost::recursive_mutex::scoped_lock lock(s_memoryManagerMutex);
+			m_fInflation = std::max(m_fInflation,fPriority);
+		}
+	}
+
+	return nFreed;
+}
+
 void MemoryManager::freeConsumerMemory()
 {
 	try
@@ -458,6 +727,21 @@ void MemoryManager::freeConsumerMemory()
 			//TRACE_INFO("sqllite soft memory limit : " << sqliteLimit << " bytes");
 		}
 
+		// Evict the registered items first, until the usage is back to 90% of the allowed memory.
+		size_t nUsed;
+		size_t nTarget;
+		{
+			boost::recursive_mutex::scoped_lock lock(s_memoryManagerMutex);
+			nUsed = m_nMemoryAllocated + m_nOtherMemoryAllocated;
+			nTarget = m_nMaximumAllocation / 10 * 9;
+		}
+
+		if (nUsed > nTarget && freeMemoryItems(nUsed - nTarget) >= nUsed - nTarget)
+		{
+			m_releasingMemory = false;
+			return;
+		}
+
 		if (m_nNextConsumerToFreeMemory >= m_vecConsumers.size())
 		{
 			m_nNextConsumerToFreeMemory = 0;
@@ -680,6 +964,21 @@ void MemoryManager::unregisterConsumer(MemoryConsumer* pConsumer)
 	{
 		m_vecConsumers.erase(it);
 	}
+
+	// Forget the items the consumer did not unregister.
+	for (std::map<MemoryItemId,MemoryItem>::iterator itItem = m_items.begin(); itItem != m_items.end();)
+	{
+		if (itItem->second.pConsumer == pConsumer)
+		{
+			m_itemsOrder.erase(getItemOrder(itItem->first,itItem->second));
+			m_items.erase(itItem++);
+		}
+		else
+		{
+			++itItem;
+		}
+	}
+	m_consumerItemBytes.erase(pConsumer);
 }
 
 /*!
@@ -10,6 +10,7 @@ web			: www.pyxisinnovation.com
 
 // pyxlib includes
 #include "pyxlib.h"
+#include "pyxis/utility/cost.h"
 
 // boost includes
 #include <boost/detail/atomic_count.hpp>
@@ -19,11 +20,16 @@ web			: www.pyxisinnovation.com
 #include <new.h>
 #include <queue>
 #include <map>
+#include <set>
+#include <string>
 
 // forward declarations
 class MemoryResource;
 class MemoryToken;
 
+//! Identifier of a memory item registered by a MemoryConsumer (0 is never used).
+typedef unsigned int MemoryItemId;
+
 //! Pure virtual interface for a class that consumes memory.
 /*!
 The MemoryConsumer is a class the cooperates with the memory manager to
@@ -41,6 +47,19 @@ public:
 	//! Called by the memory manager to free up memory.
 	virtual void freeMemory() = 0;
 
+	/*!
+	This method is called by the memory manager when an item registered with
+	registerMemoryItem is the cheapest item to rebuild, per byte, of all
+	the consumers. The consumer should release the item and unregister it.
+
+	\return false if the item can not be released now (for example it is in use).
+	*/
+	//! Called by the memory manager to free a registered item.
+	virtual bool freeMemoryItem(MemoryItemId nItemId) { return false; }
+
+	//! The name used to report the memory of the registered items in MemoryManager::getMemoryStatus.
+	virtual std::string getMemoryConsumerName() const;
+
 protected:
 
 	//! Constructor.
@@ -49,6 +68,15 @@ protected:
 	//! Destructor.
 	virtual ~MemoryConsumer();
 
+	//! Register an item of the given size and rebuild cost for global eviction.
+	MemoryItemId registerMemoryItem(size_t nBytes,const PYXCost & cost);
+
+	//! Notify the memory manager that an item was used.
+	void accessMemoryItem(MemoryItemId nItemId);
+
+	//! Unregister an item that was released.
+	void unregisterMemoryItem(MemoryItemId nItemId);
+
 	// TODO: Move to private when no longer needed in DTED file.
 	//! Unregister a memory consumer.
 	void unregisterConsumer();
@@ -186,9 +214,14 @@ on a computer. The process works as follows:
    for the desired number of bytes.
 2) If sufficient memory is available, the memory manager allocates and returns
    a memory resource.
-3) If memory is low, the memory manager asks each of the memory consumers from
-   the least recently used to the most recently used to free up memory
-   resources until sufficient memory is available to satisfy the request.
+3) If memory is low, the memory manager first evicts the items registered by
+   the consumers (see MemoryConsumer::registerMemoryItem) across all consumers,
+   using the GreedyDual-Size policy: every item has a priority of
+   L + cost / size, the item with the lowest priority is evicted first and L is
+   raised to its priority. Items that are cheap to rebuild per byte go first,
+   and items that were not used for a while lose their advantage as L grows.
+4) If that is not enough, the memory manager asks each of the memory consumers
+   to free up memory resources.
 */
 class PYXLIB_DECL MemoryManager
 {
@@ -239,6 +272,21 @@ private:
 	//! Ask memory consumers to free some memory.
 	void freeConsumerMemory();
 
+	//! Evict registered items by GreedyDual-Size priority until nBytes were freed, return the bytes freed.
+	size_t freeMemoryItems(size_t nBytes);
+
+	//! Register a memory item of a consumer.
+	MemoryItemId registerItem(MemoryConsumer* pConsumer,size_t nBytes,const PYXCost & cost);
+
+	//! Renew the priority of an item.
+	void accessItem(MemoryItemId nItemId);
+
+	//! Unregister a memory item.
+	void unregisterItem(MemoryItemId nItemId);
+
+	//! Test the GreedyDual-Size eviction of registered items.
+	static void testMemoryItems();
+
 	//! Register a memory consumer.
 	void registerConsumer(MemoryConsumer* pConsumer);
 
@@ -316,6 +364,64 @@ private:
 
 	std::map<std::string,boost::shared_ptr<VaryingMemoryUsed>> m_usedSections;
 
+	//! A memory item registered by a consumer.
+	struct MemoryItem
+	{
+		MemoryConsumer* pConsumer;
+		size_t nBytes;
+
+		//! rebuild cost in seconds
+		double fCost;
+
+		//! GreedyDual-Size priority: inflation + cost per MB
+		double fPriority;
+
+		//! access tick, breaks priority ties in favour of the recently used items
+		unsigned int nLastAccess;
+	};
+
+	//! Eviction order of the items: priority, then last access.
+	struct MemoryItemOrder
+	{
+		double fPriority;
+		unsigned int nLastAccess;
+		MemoryItemId nItemId;
+
+		bool operator<(const MemoryItemOrder & other) const
+		{
+			if (fPriority != other.fPriority)
+			{
+				return fPriority < other.fPriority;
+			}
+			if (nLastAccess != other.nLastAccess)
+			{
+				return nLastAccess < other.nLastAccess;
+			}
+			return nItemId < other.nItemId;
+		}
+	};
+
+	//! Update the priority of an item to the current inflation.
+	void renewItem(MemoryItemId nItemId,MemoryItem & item);
+
+	static MemoryItemOrder getItemOrder(MemoryItemId nItemId,const MemoryItem & item);
+
+	//! The registered items.
+	std::map<MemoryItemId,MemoryItem> m_items;
+
+	//! The registered items by eviction order.
+	std::set<MemoryItemOrder> m_itemsOrder;
+
+	//! Bytes registered per consumer.
+	std::map<MemoryConsumer*,size_t> m_consumerItemBytes;
+
+	//! GreedyDual-Size inflation value (L): the priority of the last evicted item.
+	double m_fInflation;
+
+	MemoryItemId m_nNextItemId;
+
+	unsigned int m_nAccessTick;
+
 	//! Ensure MemoryResource and MemoryToken can see private methods.
 	friend class MemoryResource;
 	friend class MemoryToken;
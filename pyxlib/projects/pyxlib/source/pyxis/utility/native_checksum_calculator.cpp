@@ -0,0 +1,512 @@
+/******************************************************************************
+native_checksum_calculator.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "pyxis/utility/native_checksum_calculator.h"
+
+// pyxlib includes
+#include "pyxis/utility/app_services.h"
+#include "pyxis/utility/exceptions.h"
+#include "pyxis/utility/file_utils.h"
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/thread_pool.h"
+
+// boost includes
+#include <boost/bind.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// standard includes
+#include <algorithm>
+#include <vector>
+
+#ifdef WIN32
+#	include <windows.h>
+#else
+#	include <sys/stat.h>
+#endif
+
+namespace
+{
+
+//! The hash used for all checksums.
+const std::string kstrHashType("SHA256");
+
+//! Prefix of the data hashed to combine chunk digests, so a tree hash never collides with a flat hash.
+const std::string kstrTreeHashPrefix("PYXIS-SHA256-TREE:");
+
+//! Separator of the fields in the persistent cache file.
+const char kcSeparator = '\t';
+
+//! Return the raw bytes of a generated checksum.
+std::string getDigestBytes(const SSLUtils::Checksum & checksum)
+{
+	std::string strDigest;
+	strDigest.reserve(checksum.getLength());
+	for (unsigned int nIndex = 0; nIndex < checksum.getLength(); ++nIndex)
+	{
+		strDigest.push_back(static_cast<char>(checksum.getByte(nIndex)));
+	}
+	return strDigest;
+}
+
+}
+
+//! Tester class
+Tester<NativeChecksumCalculator> gTester;
+
+//! Test method
+void NativeChecksumCalculator::test()
+{
+	boost::filesystem::path cacheFile = AppServices::makeTempFile(".txt");
+	boost::filesystem::path dataFile = AppServices::makeTempFile(".dat");
+
+	std::string strData;
+	for (int n = 0; n < 10000; ++n)
+	{
+		strData += StringUtils::toString(n) + ",";
+	}
+	{
+		boost::filesystem::ofstream out(dataFile, std::ios::out | std::ios::binary);
+		out << strData;
+	}
+
+	// a file smaller than a chunk hashes to the same value as the string content
+	{
+		PYXPointer<NativeChecksumCalculator> spCalculator = NativeChecksumCalculator::create(cacheFile);
+		std::string strFromFile = spCalculator->calculateFileCheckSum(FileUtils::pathToString(dataFile));
+		TEST_ASSERT(!strFromFile.empty());
+		TEST_ASSERT_EQUAL(strFromFile, spCalculator->calculateCheckSum(strData));
+		TEST_ASSERT_EQUAL(spCalculator->getHashedFileCount(), 1);
+
+		// the second request is served from the cache
+		TEST_ASSERT_EQUAL(strFromFile, spCalculator->calculateFileCheckSum(FileUtils::pathToString(dataFile)));
+		TEST_ASSERT_EQUAL(spCalculator->getHashedFileCount(), 1);
+
+		TEST_ASSERT_EQUAL(spCalculator->findFileMatchingChecksum(strFromFile), FileUtils::pathToString(boost::filesystem::absolute(dataFile)));
+		TEST_ASSERT(spCalculator->findFileMatchingChecksum("not a checksum").empty());
+	}
+
+	// the persistent cache is reused by a new calculator
+	{
+		PYXPointer<NativeChecksumCalculator> spCalculator = NativeChecksumCalculator::create(cacheFile);
+		std::string strChecksum = spCalculator->calculateFileCheckSum(FileUtils::pathToString(dataFile));
+		TEST_ASSERT_EQUAL(strChecksum, spCalculator->calculateCheckSum(strData));
+		TEST_ASSERT_EQUAL(spCalculator->getHashedFileCount(), 0);
+	}
+
+	// a tree hash over small chunks is stable, and differs from the flat hash
+	std::string strTreeHash;
+	{
+		PYXPointer<NativeChecksumCalculator> spCalculator = NativeChecksumCalculator::create(boost::filesystem::path(), 4096);
+		strTreeHash = spCalculator->calculateFileCheckSum(FileUtils::pathToString(dataFile));
+		TEST_ASSERT(strTreeHash != spCalculator->calculateCheckSum(strData));
+
+		PYXPointer<NativeChecksumCalculator> spOther = NativeChecksumCalculator::create(boost::filesystem::path(), 4096);
+		TEST_ASSERT_EQUAL(strTreeHash, spOther->calculateFileCheckSum(FileUtils::pathToString(dataFile)));
+	}
+
+	// modifying the file invalidates the cached value
+	{
+		boost::filesystem::ofstream out(dataFile, std::ios::out | std::ios::binary | std::ios::app);
+		out << "more data";
+	}
+	{
+		PYXPointer<NativeChecksumCalculator> spCalculator = NativeChecksumCalculator::create(cacheFile);
+		std::string strChecksum = spCalculator->calculateFileCheckSum(FileUtils::pathToString(dataFile));
+		TEST_ASSERT_EQUAL(strChecksum, spCalculator->calculateCheckSum(strData + "more data"));
+		TEST_ASSERT_EQUAL(spCalculator->getHashedFileCount(), 1);
+	}
+
+	FileUtils::remove(dataFile);
+	FileUtils::remove(cacheFile);
+}
+
+//! Compare the cold (hashing) and warm (cached) cost of a multi chunk file.
+void NativeChecksumCalculator::benchmark()
+{
+	boost::filesystem::path dataFile = AppServices::makeTempFile(".dat");
+
+	std::string strData;
+	for (int n = 0; n < 10000; ++n)
+	{
+		strData += StringUtils::toString(n) + ",";
+	}
+	{
+		boost::filesystem::ofstream out(dataFile, std::ios::out | std::ios::binary);
+		for (int n = 0; n < 64; ++n)
+		{
+			out << strData;
+		}
+	}
+
+	PYXPointer<NativeChecksumCalculator> spCalculator = NativeChecksumCalculator::create(boost::filesystem::path(), 256 * 1024);
+
+	PYXHighQualityTimer timer;
+	timer.start();
+	spCalculator->calculateFileCheckSum(FileUtils::pathToString(dataFile));
+	timer.stop();
+	double coldTime = timer.getTime();
+
+	timer.start();
+	spCalculator->calculateFileCheckSum(FileUtils::pathToString(dataFile));
+	timer.stop();
+
+	TRACE_INFO("NativeChecksumCalculator: hashed " << FileUtils::calcSize(dataFile) << " bytes in " << (int)(1000 * coldTime) << "ms, cached lookup in " << (int)(1000 * timer.getTime()) << "ms");
+
+	FileUtils::remove(dataFile);
+}
+
+PYXPointer<NativeChecksumCalculator> NativeChecksumCalculator::getInstance()
+{
+	static boost::recursive_mutex s_mutex;
+	static PYXPointer<NativeChecksumCalculator> s_spInstance;
+
+	boost::recursive_mutex::scoped_lock lock(s_mutex);
+	if (!s_spInstance)
+	{
+		s_spInstance = create(AppServices::getCacheDir("checksum") / "file_checksums.txt");
+	}
+	return s_spInstance;
+}
+
+NativeChecksumCalculator::NativeChecksumCalculator(const boost::filesystem::path & cacheFile, boost::uint64_t nChunkSize) :
+	m_cacheFile(cacheFile),
+	m_nChunkSize(nChunkSize),
+	m_bCacheLoaded(false),
+	m_nHashedFileCount(0)
+{
+	assert(m_nChunkSize > 0);
+}
+
+NativeChecksumCalculator::~NativeChecksumCalculator()
+{
+}
+
+std::string NativeChecksumCalculator::calculateCheckSum(const std::string& str)
+{
+	SSLUtils::Checksum checksum(kstrHashType);
+	if (!checksum.generate(str))
+	{
+		PYXTHROW(PYXException, "Failed to calculate checksum.");
+	}
+	return checksum.toBase64String();
+}
+
+/*!
+Calculate the checksum of a file. The cached value is returned if the file size,
+modification time and identity did not change since it was computed.
+
+\param path	The path of the file.
+
+\return The base 64 checksum of the file.
+*/
+std::string NativeChecksumCalculator::calculateFileCheckSum(const std::string& path)
+{
+	boost::filesystem::path filePath = boost::filesystem::absolute(FileUtils::stringToPath(path));
+	std::string strKey = FileUtils::pathToString(filePath);
+
+	FileStamp stamp;
+	if (!getFileStamp(filePath, stamp))
+	{
+		PYXTHROW(PYXFileException, "Can't calculate checksum of missing file '" << path << "'.");
+	}
+
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		loadCache();
+
+		CacheMap::const_iterator it = m_cache.find(strKey);
+		if (it != m_cache.end() && it->second.m_stamp == stamp)
+		{
+			return it->second.m_strChecksum;
+		}
+	}
+
+	// hash without holding the lock, so other files can be served from the cache meanwhile
+	CacheEntry entry;
+	entry.m_stamp = stamp;
+	entry.m_strChecksum = hashFile(filePath, stamp.m_nSize);
+
+	// only remember the value if the file didn't change while we were reading it
+	FileStamp stampAfter;
+	if (getFileStamp(filePath, stampAfter) && stampAfter == stamp)
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		m_cache[strKey] = entry;
+		saveCacheEntry(strKey, entry);
+	}
+
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	++m_nHashedFileCount;
+	return entry.m_strChecksum;
+}
+
+std::string NativeChecksumCalculator::findFileMatchingChecksum(const std::string &checksum)
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	loadCache();
+
+	for (CacheMap::const_iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+	{
+		if (it->second.m_strChecksum != checksum)
+		{
+			continue;
+		}
+
+		FileStamp stamp;
+		if (getFileStamp(FileUtils::stringToPath(it->first), stamp) && stamp == it->second.m_stamp)
+		{
+			return it->first;
+		}
+	}
+	return "";
+}
+
+int NativeChecksumCalculator::getHashedFileCount() const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+	return m_nHashedFileCount;
+}
+
+bool NativeChecksumCalculator::getFileStamp(const boost::filesystem::path & path, FileStamp & stamp)
+{
+	boost::system::error_code ec;
+
+	stamp.m_nSize = boost::filesystem::file_size(path, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	stamp.m_modified = boost::filesystem::last_write_time(path, ec);
+	if (ec)
+	{
+		return false;
+	}
+
+	stamp.m_nFileId = 0;
+
+#ifdef WIN32
+	HANDLE hFile = CreateFileW(
+		path.wstring().c_str(),
+		0,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_FLAG_BACKUP_SEMANTICS,
+		NULL);
+
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		BY_HANDLE_FILE_INFORMATION info;
+		if (GetFileInformationByHandle(hFile, &info))
+		{
+			// the file index is only unique within a volume
+			stamp.m_nFileId = ((static_cast<boost::uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow) ^
+				(static_cast<boost::uint64_t>(info.dwVolumeSerialNumber) << 48);
+		}
+		CloseHandle(hFile);
+	}
+#else
+	struct stat fileStat;
+	if (stat(path.string().c_str(), &fileStat) == 0)
+	{
+		stamp.m_nFileId = (static_cast<boost::uint64_t>(fileStat.st_ino)) ^
+			(static_cast<boost::uint64_t>(fileStat.st_dev) << 48);
+	}
+#endif
+
+	return true;
+}
+
+/*!
+Hash the content of a file. A file that spans more than one chunk is hashed in
+parallel: every chunk digest is computed on the thread pool and the checksum is
+the hash of all chunk digests.
+*/
+std::string NativeChecksumCalculator::hashFile(const boost::filesystem::path & path, boost::uint64_t nSize) const
+{
+	if (nSize <= m_nChunkSize)
+	{
+		SSLUtils::Checksum checksum(kstrHashType);
+		hashRegion(path, 0, nSize, checksum);
+		return checksum.toBase64String();
+	}
+
+	const std::size_t nChunks = static_cast<std::size_t>((nSize + m_nChunkSize - 1) / m_nChunkSize);
+	std::vector<std::string> vecDigests(nChunks);
+
+	PYXTaskGroup tasks;
+	for (std::size_t nChunk = 0; nChunk < nChunks; ++nChunk)
+	{
+		const boost::uint64_t nOffset = nChunk * m_nChunkSize;
+		const boost::uint64_t nLength = std::min(m_nChunkSize, nSize - nOffset);
+		tasks.addTask(boost::bind(&NativeChecksumCalculator::hashChunk, &path, nOffset, nLength, &vecDigests[nChunk]));
+	}
+	tasks.joinAll();
+
+	SSLUtils::Checksum root(kstrHashType);
+	std::string strTree = kstrTreeHashPrefix + StringUtils::toString(m_nChunkSize) + ":";
+	for (std::size_t nChunk = 0; nChunk < nChunks; ++nChunk)
+	{
+		strTree += vecDigests[nChunk];
+	}
+	if (!root.generate(strTree))
+	{
+		PYXTHROW(PYXException, "Failed to calculate checksum of '" << FileUtils::pathToString(path) << "'.");
+	}
+	return root.toBase64String();
+}
+
+void NativeChecksumCalculator::hashRegion(
+	const boost::filesystem::path & path,
+	boost::uint64_t nOffset,
+	boost::uint64_t nLength,
+	SSLUtils::Checksum & checksum)
+{
+	if (nLength == 0)
+	{
+		checksum.generate(std::string());
+		return;
+	}
+
+	try
+	{
+		boost::interprocess::file_mapping mapping(FileUtils::pathToString(path).c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region region(
+			mapping,
+			boost::interprocess::read_only,
+			static_cast<boost::interprocess::offset_t>(nOffset),
+			static_cast<std::size_t>(nLength));
+
+		if (!checksum.generate(region.get_address(), region.get_size()))
+		{
+			PYXTHROW(PYXException, "Failed to calculate checksum of '" << FileUtils::pathToString(path) << "'.");
+		}
+	}
+	catch (boost::interprocess::interprocess_exception & e)
+	{
+		PYXTHROW(PYXFileException, "Failed to map '" << FileUtils::pathToString(path) << "': " << e.what());
+	}
+}
+
+void NativeChecksumCalculator::hashChunk(
+	const boost::filesystem::path * pPath,
+	boost::uint64_t nOffset,
+	boost::uint64_t nLength,
+	std::string * pDigest)
+{
+	SSLUtils::Checksum checksum(kstrHashType);
+	hashRegion(*pPath, nOffset, nLength, checksum);
+	*pDigest = getDigestBytes(checksum);
+}
+
+/*!
+Load the persistent cache. Entries are appended to the file as they are
+computed, so later lines override earlier ones. The file is compacted when it
+contains many outdated lines.
+*/
+void NativeChecksumCalculator::loadCache()
+{
+	if (m_bCacheLoaded)
+	{
+		return;
+	}
+	m_bCacheLoaded = true;
+
+	if (m_cacheFile.empty() || !FileUtils::exists(m_cacheFile))
+	{
+		return;
+	}
+
+	int nLines = 0;
+	{
+		boost::filesystem::ifstream in(m_cacheFile);
+		std::string strLine;
+		while (std::getline(in, strLine))
+		{
+			std::vector<std::string> vecFields;
+			std::string::size_type nStart = 0;
+			for (int nField = 0; nField < 4; ++nField)
+			{
+				std::string::size_type nEnd = strLine.find(kcSeparator, nStart);
+				if (nEnd == std::string::npos)
+				{
+					break;
+				}
+				vecFields.push_back(strLine.substr(nStart, nEnd - nStart));
+				nStart = nEnd + 1;
+			}
+			if (vecFields.size() != 4 || nStart >= strLine.size())
+			{
+				TRACE_INFO("Ignoring corrupted line in checksum cache '" << FileUtils::pathToString(m_cacheFile) << "'.");
+				continue;
+			}
+
+			CacheEntry entry;
+			entry.m_strChecksum = vecFields[0];
+			entry.m_stamp.m_nSize = StringUtils::fromString<boost::uint64_t>(vecFields[1]);
+			entry.m_stamp.m_modified = StringUtils::fromString<std::time_t>(vecFields[2]);
+			entry.m_stamp.m_nFileId = StringUtils::fromString<boost::uint64_t>(vecFields[3]);
+			m_cache[strLine.substr(nStart)] = entry;
+			++nLines;
+		}
+	}
+
+	// compact the file when most lines are outdated
+	if (nLines > 2 * static_cast<int>(m_cache.size()) + 100)
+	{
+		boost::filesystem::path tempFile = m_cacheFile;
+		tempFile.replace_extension(".tmp");
+		{
+			boost::filesystem::ofstream out(tempFile, std::ios::out | std::ios::trunc);
+			for (CacheMap::const_iterator it = m_cache.begin(); it != m_cache.end(); ++it)
+			{
+				out << it->second.m_strChecksum << kcSeparator
+					<< it->second.m_stamp.m_nSize << kcSeparator
+					<< it->second.m_stamp.m_modified << kcSeparator
+					<< it->second.m_stamp.m_nFileId << kcSeparator
+					<< it->first << "\n";
+			}
+		}
+
+		boost::system::error_code ec;
+		boost::filesystem::rename(tempFile, m_cacheFile, ec);
+		if (ec)
+		{
+			TRACE_INFO("Failed to compact checksum cache '" << FileUtils::pathToString(m_cacheFile) << "'.");
+		}
+	}
+}
+
+void NativeChecksumCalculator::saveCacheEntry(const std::string & strPath, const CacheEntry & entry)
+{
+	if (m_cacheFile.empty())
+	{
+		return;
+	}
+
+	boost::filesystem::ofstream out(m_cacheFile, std::ios::out | std::ios::app);
+	if (!out)
+	{
+		TRACE_INFO("Failed to write checksum cache '" << FileUtils::pathToString(m_cacheFile) << "'.");
+		return;
+	}
+
+	out << entry.m_strChecksum << kcSeparator
+		<< entry.m_stamp.m_nSize << kcSeparator
+		<< entry.m_stamp.m_modified << kcSeparator
+		<< entry.m_stamp.m_nFileId << kcSeparator
+		<< strPath << "\n";
+}
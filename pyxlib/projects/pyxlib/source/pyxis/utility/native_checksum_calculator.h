@@ -0,0 +1,159 @@
+#ifndef PYXIS__UTILITY__NATIVE_CHECKSUM_CALCULATOR_H
+#define PYXIS__UTILITY__NATIVE_CHECKSUM_CALCULATOR_H
+/******************************************************************************
+native_checksum_calculator.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "pyxis/utility/checksum_calculator.h"
+#include "pyxis/utility/ssl_utils.h"
+
+// boost includes
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+
+// standard includes
+#include <ctime>
+#include <map>
+#include <string>
+
+/*!
+NativeChecksumCalculator computes SHA256 file checksums without a managed
+implementation being injected into ChecksumCalculator.
+
+Files are read through memory mapped regions. Files that fit in a single chunk
+are hashed as a whole, so their checksum matches a plain SHA256 of the file
+(base 64 encoded, like the managed calculator). Larger files are split into
+fixed size chunks that are hashed in parallel on the thread pool, and the
+checksum is the SHA256 of the chunk digests (a tree hash).
+
+Computed checksums are remembered in a persistent cache keyed by the file path
+and validated against the file size, modification time and file identity, so an
+unchanged file is never hashed twice.
+*/
+//! Native, cached and parallel implementation of ChecksumCalculator.
+class PYXLIB_DECL NativeChecksumCalculator : public ChecksumCalculator
+{
+public:
+
+	//! Test method
+	static void test();
+
+	//! Time hashing a multi chunk file and its cached lookup (not run by the tests).
+	static void benchmark();
+
+	//! Default size of the chunks hashed in parallel (16 MB).
+	static const boost::uint64_t knDefaultChunkSize = 16 * 1024 * 1024;
+
+public:
+
+	//! Create a calculator with a persistent cache in the given file (empty path for no persistence).
+	static PYXPointer<NativeChecksumCalculator> create(
+		const boost::filesystem::path & cacheFile,
+		boost::uint64_t nChunkSize = knDefaultChunkSize)
+	{
+		return PYXNEW(NativeChecksumCalculator, cacheFile, nChunkSize);
+	}
+
+	//! Return the shared calculator that persists its cache in the application cache directory.
+	static PYXPointer<NativeChecksumCalculator> getInstance();
+
+	NativeChecksumCalculator(const boost::filesystem::path & cacheFile, boost::uint64_t nChunkSize);
+
+	virtual ~NativeChecksumCalculator();
+
+public:
+
+	//! Calculate the base 64 SHA256 checksum of a string.
+	virtual std::string calculateCheckSum(const std::string& str);
+
+	//! Calculate the checksum of a file, using the cache when the file did not change.
+	virtual std::string calculateFileCheckSum(const std::string& path);
+
+	//! Find a cached file that still matches the given checksum (empty string if none).
+	virtual std::string findFileMatchingChecksum(const std::string &checksum);
+
+	//! Return the number of files that were actually hashed (cache misses).
+	int getHashedFileCount() const;
+
+private:
+
+	//! The properties of a file used to detect changes.
+	struct FileStamp
+	{
+		boost::uint64_t m_nSize;
+		std::time_t m_modified;
+		boost::uint64_t m_nFileId;
+
+		FileStamp() : m_nSize(0), m_modified(0), m_nFileId(0) {}
+
+		bool operator==(const FileStamp & other) const
+		{
+			return m_nSize == other.m_nSize &&
+				m_modified == other.m_modified &&
+				m_nFileId == other.m_nFileId;
+		}
+	};
+
+	struct CacheEntry
+	{
+		FileStamp m_stamp;
+		std::string m_strChecksum;
+	};
+
+	typedef std::map<std::string, CacheEntry> CacheMap;
+
+	//! Read the stamp of a file, return false if the file doesn't exist.
+	static bool getFileStamp(const boost::filesystem::path & path, FileStamp & stamp);
+
+	//! Hash the file content, using a tree hash if the file spans more than one chunk.
+	std::string hashFile(const boost::filesystem::path & path, boost::uint64_t nSize) const;
+
+	//! Feed a memory mapped region of a file into a checksum.
+	static void hashRegion(
+		const boost::filesystem::path & path,
+		boost::uint64_t nOffset,
+		boost::uint64_t nLength,
+		SSLUtils::Checksum & checksum);
+
+	//! Hash a single chunk of a mapped file into a raw digest.
+	static void hashChunk(
+		const boost::filesystem::path * pPath,
+		boost::uint64_t nOffset,
+		boost::uint64_t nLength,
+		std::string * pDigest);
+
+	//! Load the persistent cache if not loaded yet.
+	void loadCache();
+
+	//! Append an entry to the persistent cache.
+	void saveCacheEntry(const std::string & strPath, const CacheEntry & entry);
+
+private:
+
+	//! The file holding the persistent cache.
+	const boost::filesystem::path m_cacheFile;
+
+	//! Size of the chunks hashed in parallel.
+	const boost::uint64_t m_nChunkSize;
+
+	//! True once the persistent cache was read.
+	bool m_bCacheLoaded;
+
+	//! Cached checksums by file path.
+	CacheMap m_cache;
+
+	//! Number of files hashed.
+	int m_nHashedFileCount;
+
+	//! Protects the cache.
+	mutable boost::recursive_mutex m_mutex;
+};
+
+#endif // guard
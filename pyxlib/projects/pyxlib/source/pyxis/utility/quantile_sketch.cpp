@@ -0,0 +1,493 @@
+/******************************************************************************
+quantile_sketch.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "quantile_sketch.h"
+#include "numeric_histogram.h"
+#include "profile.h"
+#include "tester.h"
+#include "exceptions.h"
+#include "math_utils.h"
+
+// standard includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+
+//! Lower bound on the capacity of a level.
+const int knMinLevelCapacity = 8;
+
+//! Ratio between the capacities of consecutive levels.
+const double kfLevelCapacityRatio = 2.0/3.0;
+
+//! The serialization version of the sketch.
+const unsigned char knSketchVersion = 1;
+
+}
+
+//! Tester class
+Tester<QuantileSketch> gTester;
+
+//! Test method
+void QuantileSketch::test()
+{
+	srand(10);
+
+	std::vector<double> values;
+	for(int i=0;i<100000;i++)
+	{
+		values.push_back(rand()%1000+(rand()%100000)/100000.0);
+	}
+
+	// exact count, sum and boundaries
+	QuantileSketch sketch(values.begin(),values.end());
+	{
+		double sum = 0;
+		for(unsigned int i=0;i<values.size();++i)
+		{
+			sum += values[i];
+		}
+
+		TEST_ASSERT(sketch.count() == (int)values.size());
+		TEST_ASSERT(MathUtils::equal(sketch.getSum()/sum,1.0));
+		TEST_ASSERT(MathUtils::equal(sketch.getBoundaries().min,*std::min_element(values.begin(),values.end())));
+		TEST_ASSERT(MathUtils::equal(sketch.getBoundaries().max,*std::max_element(values.begin(),values.end())));
+
+		// memory is bounded
+		TEST_ASSERT(sketch.getRetainedItemsCount() < 3 * knDefaultK + 100);
+	}
+
+	std::vector<double> sorted(values);
+	std::sort(sorted.begin(),sorted.end());
+
+	// quantiles are within the expected error
+	{
+		const double maxRankError = 0.03 * values.size();
+		for(int i=1;i<20;i++)
+		{
+			double q = i/20.0;
+			double estimate = sketch.quantile(q);
+			int realRank = (int)(std::lower_bound(sorted.begin(),sorted.end(),estimate) - sorted.begin());
+			TEST_ASSERT(std::abs(realRank - q * values.size()) <= maxRankError);
+		}
+	}
+
+	// range counts are within the reported error
+	{
+		for(int i=0;i<1000;i+=50)
+		{
+			Range<double> r(i,i+100,knClosed,knOpen);
+			int realCount = (int)(std::lower_bound(sorted.begin(),sorted.end(),(double)(i+100)) - std::lower_bound(sorted.begin(),sorted.end(),(double)i));
+			Range<int> sketchCount = sketch.count(r);
+			TEST_ASSERT(sketchCount.contains(realCount));
+		}
+
+		//ranges covering all or none of the values are exact
+		TEST_ASSERT(sketch.count(Range<double>::createClosedClosed(-1,1001)) == Range<int>(sketch.count()));
+		TEST_ASSERT(sketch.count(Range<double>::createClosedClosed(2000,3000)) == Range<int>(0));
+	}
+
+	// merging gives the same accuracy as building from all values
+	{
+		QuantileSketch first(values.begin(),values.begin()+values.size()/2);
+		QuantileSketch second(values.begin()+values.size()/2,values.end());
+		first.add(second);
+
+		TEST_ASSERT(first.count() == sketch.count());
+		TEST_ASSERT(MathUtils::equal(first.getSum()/sketch.getSum(),1.0));
+		double median = first.quantile(0.5);
+		int realRank = (int)(std::lower_bound(sorted.begin(),sorted.end(),median) - sorted.begin());
+		TEST_ASSERT(std::abs(realRank - 0.5 * values.size()) <= 0.03 * values.size());
+	}
+
+	// serialization round trip
+	{
+		PYXStringWireBuffer buffer;
+		buffer << sketch;
+
+		QuantileSketch loaded;
+		buffer.setPos(0);
+		buffer >> loaded;
+
+		TEST_ASSERT(loaded.count() == sketch.count());
+		TEST_ASSERT(loaded.getRetainedItemsCount() == sketch.getRetainedItemsCount());
+		TEST_ASSERT(MathUtils::equal(loaded.quantile(0.25),sketch.quantile(0.25)));
+		TEST_ASSERT(MathUtils::equal(loaded.getSumSquare(),sketch.getSumSquare()));
+	}
+
+	// small sketches are exact
+	{
+		QuantileSketch small;
+		small.add(1);
+		small.add(2);
+		small.add(2);
+		TEST_ASSERT(small.count(Range<double>(2)) == Range<int>(2));
+		TEST_ASSERT(small.getMaxError() == 0);
+	}
+}
+
+//! Benchmark method
+void QuantileSketch::benchmark()
+{
+	srand(10);
+
+	std::vector<double> values;
+	for(int i=0;i<100000;i++)
+	{
+		values.push_back(rand()%1000+(rand()%100000)/100000.0);
+	}
+
+	std::vector<double> sorted(values);
+	std::sort(sorted.begin(),sorted.end());
+
+	//build 100 groups and merge them, with the exact histogram and with the sketch
+	const int groups = 100;
+	const int groupSize = (int)values.size() / groups;
+
+	PYXHighQualityTimer timer;
+
+	timer.start();
+	NumericHistogram<double> exact;
+	for(int g=0;g<groups;++g)
+	{
+		NumericHistogram<double> group(values.begin()+g*groupSize,values.begin()+(g+1)*groupSize);
+		group.limit(1000);
+		exact.add(group);
+	}
+	exact.limit(1000);
+	timer.stop();
+	double exactTime = timer.getTime();
+	PYXStringWireBuffer exactBuffer;
+	exactBuffer << exact;
+
+	timer.start();
+	QuantileSketch merged;
+	for(int g=0;g<groups;++g)
+	{
+		QuantileSketch group(values.begin()+g*groupSize,values.begin()+(g+1)*groupSize);
+		merged.add(group);
+	}
+	timer.stop();
+	PYXStringWireBuffer sketchBuffer;
+	sketchBuffer << merged;
+
+	double median = merged.quantile(0.5);
+	int realRank = (int)(std::lower_bound(sorted.begin(),sorted.end(),median) - sorted.begin());
+
+	TRACE_INFO("QuantileSketch benchmark: exact histogram " << (int)(1000*exactTime) << "ms, " << exactBuffer.size() << " bytes; "
+		<< "sketch " << (int)(1000*timer.getTime()) << "ms, " << sketchBuffer.size() << " bytes, "
+		<< "median rank error " << std::abs(realRank - 0.5 * values.size()) / values.size() * 100 << "%");
+}
+
+QuantileSketch::QuantileSketch(int k) :
+	m_k(k), m_count(0), m_sum(0), m_sumSquare(0), m_itemCount(0), m_coin(false)
+{
+	m_levels.resize(1);
+}
+
+void QuantileSketch::add(double value)
+{
+	if (m_count == 0)
+	{
+		m_boundaries = Range<double>::createClosedClosed(value,value);
+	}
+	else
+	{
+		m_boundaries.min = std::min(m_boundaries.min,value);
+		m_boundaries.max = std::max(m_boundaries.max,value);
+	}
+
+	m_count++;
+	m_sum += value;
+	m_sumSquare += value * value;
+
+	m_levels[0].push_back(value);
+	m_itemCount++;
+
+	if (m_itemCount >= getTotalCapacity())
+	{
+		compress();
+	}
+}
+
+/*!
+Merge another sketch into this one. The levels of the other sketch are appended
+to the matching levels of this sketch and the result is compacted, so the cost
+is proportional to the size of the sketches and not to the number of values.
+*/
+void QuantileSketch::add(const QuantileSketch & other)
+{
+	if (other.m_count == 0)
+	{
+		return;
+	}
+
+	if (m_count == 0)
+	{
+		m_boundaries = other.m_boundaries;
+	}
+	else
+	{
+		m_boundaries.min = std::min(m_boundaries.min,other.m_boundaries.min);
+		m_boundaries.max = std::max(m_boundaries.max,other.m_boundaries.max);
+	}
+
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+	m_sumSquare += other.m_sumSquare;
+
+	if (m_levels.size() < other.m_levels.size())
+	{
+		m_levels.resize(other.m_levels.size());
+	}
+
+	for(unsigned int level=0;level<other.m_levels.size();++level)
+	{
+		m_levels[level].insert(m_levels[level].end(),other.m_levels[level].begin(),other.m_levels[level].end());
+		m_itemCount += (int)other.m_levels[level].size();
+	}
+
+	compress();
+}
+
+Range<int> QuantileSketch::count(const Range<double> & range) const
+{
+	if (m_count == 0)
+	{
+		return Range<int>(0);
+	}
+
+	//the boundaries are exact, so are the ranges covering all or none of the values
+	if (range.contains(m_boundaries))
+	{
+		return Range<int>(m_count);
+	}
+	if (!range.intersects(m_boundaries))
+	{
+		return Range<int>(0);
+	}
+
+	int estimate = 0;
+	for(unsigned int level=0;level<m_levels.size();++level)
+	{
+		const int weight = 1 << level;
+		for(std::vector<double>::const_iterator it = m_levels[level].begin();it != m_levels[level].end();++it)
+		{
+			if (range.contains(*it))
+			{
+				estimate += weight;
+			}
+		}
+	}
+
+	const int error = 2 * getMaxError();
+	return Range<int>::createClosedClosed(std::max(0,estimate-error),std::min(m_count,estimate+error));
+}
+
+int QuantileSketch::rank(double value,bool inclusive) const
+{
+	int result = 0;
+	for(unsigned int level=0;level<m_levels.size();++level)
+	{
+		const int weight = 1 << level;
+		for(std::vector<double>::const_iterator it = m_levels[level].begin();it != m_levels[level].end();++it)
+		{
+			if (*it < value || (inclusive && *it == value))
+			{
+				result += weight;
+			}
+		}
+	}
+	return result;
+}
+
+double QuantileSketch::quantile(double q) const
+{
+	if (m_count == 0)
+	{
+		PYXTHROW(PYXException,"Can't calculate a quantile of an empty sketch.");
+	}
+
+	if (q <= 0)
+	{
+		return m_boundaries.min;
+	}
+	if (q >= 1)
+	{
+		return m_boundaries.max;
+	}
+
+	std::vector<WeightedValue> view;
+	getSortedView(view);
+
+	const double wantedRank = q * m_count;
+	int accumulated = 0;
+	for(std::vector<WeightedValue>::const_iterator it = view.begin();it != view.end();++it)
+	{
+		accumulated += it->second;
+		if (accumulated > wantedRank)
+		{
+			return it->first;
+		}
+	}
+	return m_boundaries.max;
+}
+
+/*!
+The maximum expected rank error. Zero while no compaction happened, otherwise
+about 2/k of the count, which covers the KLL error at high probability.
+*/
+int QuantileSketch::getMaxError() const
+{
+	if (m_levels.size() <= 1)
+	{
+		return 0;
+	}
+	return (int)std::ceil(2.0 * m_count / m_k);
+}
+
+void QuantileSketch::getSortedView(std::vector<WeightedValue> & result) const
+{
+	result.clear();
+	result.reserve(m_itemCount);
+
+	for(unsigned int level=0;level<m_levels.size();++level)
+	{
+		const int weight = 1 << level;
+		for(std::vector<double>::const_iterator it = m_levels[level].begin();it != m_levels[level].end();++it)
+		{
+			result.push_back(WeightedValue(*it,weight));
+		}
+	}
+
+	std::sort(result.begin(),result.end());
+}
+
+int QuantileSketch::getLevelCapacity(int level) const
+{
+	const int depth = (int)m_levels.size() - level - 1;
+	return std::max(knMinLevelCapacity,(int)std::ceil(m_k * std::pow(kfLevelCapacityRatio,depth)));
+}
+
+int QuantileSketch::getTotalCapacity() const
+{
+	int total = 0;
+	for(int level=0;level<(int)m_levels.size();++level)
+	{
+		total += getLevelCapacity(level);
+	}
+	return total;
+}
+
+void QuantileSketch::compress()
+{
+	while (m_itemCount >= getTotalCapacity())
+	{
+		int level = 0;
+		while (level < (int)m_levels.size() && (int)m_levels[level].size() < getLevelCapacity(level))
+		{
+			level++;
+		}
+
+		if (level == (int)m_levels.size())
+		{
+			// no single level is full (can happen after merge) - compact the lowest non empty level
+			level = 0;
+			while (level < (int)m_levels.size() && m_levels[level].size() < 2)
+			{
+				level++;
+			}
+			if (level == (int)m_levels.size())
+			{
+				return;
+			}
+		}
+
+		compactLevel(level);
+	}
+}
+
+void QuantileSketch::compactLevel(int level)
+{
+	if (level + 1 == (int)m_levels.size())
+	{
+		m_levels.push_back(std::vector<double>());
+	}
+
+	std::vector<double> & items = m_levels[level];
+	std::vector<double> & above = m_levels[level+1];
+
+	std::sort(items.begin(),items.end());
+
+	// an odd item stays at this level
+	const bool odd = (items.size() % 2) == 1;
+	const unsigned int first = odd ? 1 : 0;
+
+	// alternate which half survives to keep the rank error unbiased
+	m_coin = !m_coin;
+	const unsigned int offset = m_coin ? 1 : 0;
+
+	const int before = (int)items.size();
+	for(unsigned int i=first+offset;i<items.size();i+=2)
+	{
+		above.push_back(items[i]);
+	}
+
+	if (odd)
+	{
+		items.resize(1);
+	}
+	else
+	{
+		items.clear();
+	}
+
+	m_itemCount += (int)items.size() + (before - (int)first)/2 - before;
+}
+
+PYXWireBuffer & operator >> (PYXWireBuffer & buffer,QuantileSketch & sketch)
+{
+	unsigned char version;
+	buffer >> version;
+	if (version != knSketchVersion)
+	{
+		PYXTHROW(PYXException,"Unsupported quantile sketch version " << (int)version);
+	}
+
+	buffer >> sketch.m_k >> sketch.m_count >> sketch.m_sum >> sketch.m_sumSquare;
+	buffer >> sketch.m_boundaries.min >> sketch.m_boundaries.max;
+	sketch.m_boundaries.minType = knClosed;
+	sketch.m_boundaries.maxType = knClosed;
+	buffer >> sketch.m_levels;
+
+	if (sketch.m_levels.empty())
+	{
+		sketch.m_levels.resize(1);
+	}
+
+	sketch.m_itemCount = 0;
+	for(unsigned int level=0;level<sketch.m_levels.size();++level)
+	{
+		sketch.m_itemCount += (int)sketch.m_levels[level].size();
+	}
+	return buffer;
+}
+
+PYXWireBuffer & operator << (PYXWireBuffer & buffer,const QuantileSketch & sketch)
+{
+	buffer << knSketchVersion;
+	buffer << sketch.m_k << sketch.m_count << sketch.m_sum << sketch.m_sumSquare;
+	buffer << sketch.m_boundaries.min << sketch.m_boundaries.max;
+	buffer << sketch.m_levels;
+	return buffer;
+}
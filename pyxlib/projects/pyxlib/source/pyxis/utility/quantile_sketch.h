@@ -0,0 +1,141 @@
+#ifndef PYXIS__UTILITY__QUANTILE_SKETCH_H
+#define PYXIS__UTILITY__QUANTILE_SKETCH_H
+/******************************************************************************
+quantile_sketch.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "range.h"
+#include "wire_buffer.h"
+
+// standard includes
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// QuantileSketch
+///////////////////////////////////////////////////////////////////////////////
+
+/*!
+QuantileSketch is a KLL quantile sketch over double values.
+
+The sketch keeps a stack of compactors. Level h holds items that each represent
+2^h input values. When a level is full it is sorted and every other item is
+promoted to the next level, so the memory used is O(k) regardless of the number
+of values added, and two sketches are merged by concatenating their levels and
+compacting again.
+
+Rank and count queries have an additive error of roughly 1.7/k of the total
+count (about 1% for the default k of 200). Sum, sum of squares and boundaries
+are kept exactly.
+*/
+//! Mergeable, bounded memory quantile sketch.
+class PYXLIB_DECL QuantileSketch
+{
+public:
+	//! Test method.
+	static void test();
+
+	//! Compare building and merging 100 groups with the exact NumericHistogram (not run by the tests).
+	static void benchmark();
+
+	//! Default accuracy parameter.
+	static const int knDefaultK = 200;
+
+public:
+	//! A value and the number of input values it represents.
+	typedef std::pair<double,int> WeightedValue;
+
+public:
+	explicit QuantileSketch(int k = knDefaultK);
+
+	template<class InputIterator>
+	QuantileSketch(InputIterator first,InputIterator last,int k = knDefaultK) :
+		m_k(k), m_count(0), m_sum(0), m_sumSquare(0), m_itemCount(0), m_coin(false)
+	{
+		m_levels.resize(1);
+		while(first != last)
+		{
+			add(*first);
+			++first;
+		}
+	}
+
+public:
+	//! Add a single value.
+	void add(double value);
+
+	//! Merge another sketch into this one.
+	void add(const QuantileSketch & other);
+
+	//! Number of values added to the sketch.
+	int count() const { return m_count; }
+
+	//! Estimated number of values contained by the range, with error bounds.
+	Range<int> count(const Range<double> & range) const;
+
+	//! Estimated number of values smaller than (or equal to, when inclusive) the given value.
+	int rank(double value,bool inclusive) const;
+
+	//! Estimated value at the given quantile (0..1).
+	double quantile(double q) const;
+
+	//! The maximum expected error of count queries.
+	int getMaxError() const;
+
+	const double & getSum() const { return m_sum; }
+	const double & getSumSquare() const { return m_sumSquare; }
+	double getAverage() const { return m_count > 0 ? m_sum/m_count : 0; }
+
+	//! The exact min/max of the values added to the sketch.
+	const Range<double> & getBoundaries() const { return m_boundaries; }
+
+	//! Return the retained items sorted by value, with their weights.
+	void getSortedView(std::vector<WeightedValue> & result) const;
+
+	//! Number of items retained in memory.
+	int getRetainedItemsCount() const { return m_itemCount; }
+
+private:
+	//! Capacity of a given level.
+	int getLevelCapacity(int level) const;
+
+	//! Total capacity of all levels.
+	int getTotalCapacity() const;
+
+	//! Compact levels until the retained items fit the total capacity.
+	void compress();
+
+	//! Promote half of the items of a level to the level above.
+	void compactLevel(int level);
+
+private:
+	int m_k;
+	int m_count;
+	double m_sum;
+	double m_sumSquare;
+	Range<double> m_boundaries;
+
+	//! m_levels[h] holds items of weight 2^h.
+	std::vector<std::vector<double>> m_levels;
+
+	//! Number of items in all levels.
+	int m_itemCount;
+
+	//! Alternates the half kept during compaction.
+	bool m_coin;
+
+public:
+	friend PYXLIB_DECL PYXWireBuffer & operator >> (PYXWireBuffer & buffer,QuantileSketch & sketch);
+	friend PYXLIB_DECL PYXWireBuffer & operator << (PYXWireBuffer & buffer,const QuantileSketch & sketch);
+};
+
+PYXLIB_DECL PYXWireBuffer & operator >> (PYXWireBuffer & buffer,QuantileSketch & sketch);
+PYXLIB_DECL PYXWireBuffer & operator << (PYXWireBuffer & buffer,const QuantileSketch & sketch);
+
+#endif // guard
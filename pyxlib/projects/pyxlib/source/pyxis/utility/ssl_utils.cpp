@@ -255,6 +255,15 @@ bool SSLUtils::Checksum::generate(const PYXConstBufferSlice & source)
 	return mdctx.update(source.begin(), source.size());
 }
 
+//! Generate the checksum from an unowned block of memory.
+bool SSLUtils::Checksum::generate(const void * pData, std::size_t nSize)
+{
+	boost::recursive_mutex::scoped_lock lock(m_state->m_mutex);
+
+	MessageDigestContext mdctx(*m_state->m_md, m_state->m_arrBytes, m_state->m_nLength);
+	return mdctx.update(pData, nSize);
+}
+
 
 
 bool SSLUtils::Checksum::generate(const std::vector<const std::string>& vecSources)
@@ -66,6 +66,9 @@ struct SSLUtils
 		//! Generate the checksum from the source memory.
 		bool generate(const PYXConstBufferSlice & source);
 
+		//! Generate the checksum from an unowned block of memory (e.g. a mapped file region).
+		bool generate(const void * pData, std::size_t nSize);
+
 		//! Generate the checksum from the source strings.
 		bool generate(const std::vector<const std::string>& vecSources);
 
@@ -0,0 +1,544 @@
+/******************************************************************************
+string_sketch.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#define PYXLIB_SOURCE
+#include "stdafx.h"
+#include "string_sketch.h"
+#include "string_histogram.h"
+#include "string_utils.h"
+#include "profile.h"
+#include "tester.h"
+#include "exceptions.h"
+
+// standard includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <set>
+
+namespace
+{
+
+//! The serialization version of the sketches.
+const unsigned char knSketchVersion = 1;
+
+bool heavyHitterByCountDesc(const StringSketch::HeavyHitter & a,const StringSketch::HeavyHitter & b)
+{
+	return a.count > b.count || (a.count == b.count && a.value < b.value);
+}
+
+bool heavyHitterByValue(const StringSketch::HeavyHitter & a,const StringSketch::HeavyHitter & b)
+{
+	return a.value < b.value;
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HyperLogLog
+///////////////////////////////////////////////////////////////////////////////
+
+HyperLogLog::HyperLogLog(int precision) : m_precision(precision), m_registers(1 << precision,0)
+{
+	assert(precision >= 4 && precision <= 16);
+}
+
+/*!
+FNV-1a followed by a 64 bit finalizer, so short strings spread over all the bits
+used to select registers.
+*/
+boost::uint64_t HyperLogLog::hash(const std::string & value)
+{
+	boost::uint64_t h = 14695981039346656037ULL;
+	for(std::string::const_iterator it = value.begin();it != value.end();++it)
+	{
+		h ^= (unsigned char)*it;
+		h *= 1099511628211ULL;
+	}
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+void HyperLogLog::addHash(boost::uint64_t hash)
+{
+	const unsigned int index = (unsigned int)(hash >> (64 - m_precision));
+	boost::uint64_t rest = hash << m_precision;
+
+	unsigned char rank = 1;
+	const unsigned char maxRank = (unsigned char)(64 - m_precision + 1);
+	while (rank < maxRank && (rest & 0x8000000000000000ULL) == 0)
+	{
+		rank++;
+		rest <<= 1;
+	}
+
+	if (m_registers[index] < rank)
+	{
+		m_registers[index] = rank;
+	}
+}
+
+void HyperLogLog::add(const std::string & value)
+{
+	addHash(hash(value));
+}
+
+void HyperLogLog::add(const HyperLogLog & other)
+{
+	if (other.m_precision != m_precision)
+	{
+		PYXTHROW(PYXException,"Can't merge HyperLogLog estimators with different precision.");
+	}
+
+	for(unsigned int i=0;i<m_registers.size();++i)
+	{
+		m_registers[i] = std::max(m_registers[i],other.m_registers[i]);
+	}
+}
+
+double HyperLogLog::estimate() const
+{
+	const double m = (double)m_registers.size();
+	const double alpha = 0.7213 / (1 + 1.079 / m);
+
+	double sum = 0;
+	int zeros = 0;
+	for(unsigned int i=0;i<m_registers.size();++i)
+	{
+		sum += std::pow(2.0,-(int)m_registers[i]);
+		if (m_registers[i] == 0)
+		{
+			zeros++;
+		}
+	}
+
+	double estimate = alpha * m * m / sum;
+
+	// small range correction: use linear counting
+	if (estimate <= 2.5 * m && zeros > 0)
+	{
+		estimate = m * std::log(m / zeros);
+	}
+	return estimate;
+}
+
+PYXWireBuffer & operator >> (PYXWireBuffer & buffer,HyperLogLog & hll)
+{
+	unsigned char precision;
+	buffer >> precision;
+	hll.m_precision = precision;
+	hll.m_registers.resize(1 << precision);
+	buffer.read(&hll.m_registers[0],hll.m_registers.size());
+	return buffer;
+}
+
+PYXWireBuffer & operator << (PYXWireBuffer & buffer,const HyperLogLog & hll)
+{
+	buffer << (unsigned char)hll.m_precision;
+	buffer.write(const_cast<unsigned char *>(&hll.m_registers[0]),hll.m_registers.size());
+	return buffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// StringSketch
+///////////////////////////////////////////////////////////////////////////////
+
+//! Tester class
+Tester<StringSketch> gTester;
+
+//! Test method
+void StringSketch::test()
+{
+	srand(10);
+
+	// zipf like distribution: few very common values and a long tail
+	std::vector<std::string> values;
+	std::map<std::string,int> realCounts;
+	for(int i=0;i<100000;i++)
+	{
+		int rank = 1 + (int)(std::pow((double)(rand()%10000+1),2.0) / 10000);
+		std::string value = "value" + StringUtils::toString(rank);
+		values.push_back(value);
+		realCounts[value]++;
+	}
+
+	StringSketch sketch(values.begin(),values.end());
+
+	TEST_ASSERT(sketch.count() == (int)values.size());
+	TEST_ASSERT(sketch.getBoundaries().min == realCounts.begin()->first);
+	TEST_ASSERT(sketch.getBoundaries().max == realCounts.rbegin()->first);
+
+	// distinct count is within 5%
+	TEST_ASSERT(std::abs(sketch.getDistinctCount() - (int)realCounts.size()) < 0.05 * realCounts.size());
+
+	// every tracked value brackets the real count
+	std::vector<HeavyHitter> hitters;
+	sketch.getHeavyHitters(hitters);
+	TEST_ASSERT(!hitters.empty() && (int)hitters.size() <= knDefaultCapacity);
+	for(std::vector<HeavyHitter>::iterator it = hitters.begin();it != hitters.end();++it)
+	{
+		TEST_ASSERT(it->getCountRange().contains(realCounts[it->value]));
+	}
+
+	// the most common value is tracked
+	std::string mostCommon;
+	int mostCommonCount = 0;
+	for(std::map<std::string,int>::iterator it = realCounts.begin();it != realCounts.end();++it)
+	{
+		if (it->second > mostCommonCount)
+		{
+			mostCommon = it->first;
+			mostCommonCount = it->second;
+		}
+	}
+	TEST_ASSERT(sketch.count(RangeString(mostCommon)).contains(mostCommonCount));
+
+	// merge keeps the guarantees
+	{
+		StringSketch first(values.begin(),values.begin()+values.size()/2);
+		StringSketch second(values.begin()+values.size()/2,values.end());
+		first.add(second);
+
+		TEST_ASSERT(first.count() == sketch.count());
+		TEST_ASSERT(first.count(RangeString(mostCommon)).contains(mostCommonCount));
+		TEST_ASSERT(std::abs(first.getDistinctCount() - sketch.getDistinctCount()) <= 1);
+	}
+
+	// serialization round trip
+	{
+		PYXStringWireBuffer buffer;
+		buffer << sketch;
+		buffer.setPos(0);
+
+		StringSketch loaded;
+		buffer >> loaded;
+
+		TEST_ASSERT(loaded.count() == sketch.count());
+		TEST_ASSERT(loaded.getDistinctCount() == sketch.getDistinctCount());
+		TEST_ASSERT(loaded.count(RangeString(mostCommon)) == sketch.count(RangeString(mostCommon)));
+	}
+}
+
+//! Benchmark method
+void StringSketch::benchmark()
+{
+	srand(10);
+
+	std::vector<std::string> values;
+	std::set<std::string> distinctValues;
+	for(int i=0;i<100000;i++)
+	{
+		int rank = 1 + (int)(std::pow((double)(rand()%10000+1),2.0) / 10000);
+		values.push_back("value" + StringUtils::toString(rank));
+		distinctValues.insert(values.back());
+	}
+
+	//build 100 groups and merge them, with the exact histogram and with the sketch
+	const int groups = 100;
+	const int groupSize = (int)values.size() / groups;
+
+	PYXHighQualityTimer timer;
+
+	timer.start();
+	StringHistogram exact;
+	for(int g=0;g<groups;++g)
+	{
+		StringHistogram group(values.begin()+g*groupSize,values.begin()+(g+1)*groupSize);
+		exact.add(group);
+	}
+	exact.limit(4000);
+	timer.stop();
+	double exactTime = timer.getTime();
+	PYXStringWireBuffer exactBuffer;
+	exactBuffer << exact;
+
+	timer.start();
+	StringSketch merged;
+	for(int g=0;g<groups;++g)
+	{
+		StringSketch group(values.begin()+g*groupSize,values.begin()+(g+1)*groupSize);
+		merged.add(group);
+	}
+	timer.stop();
+	PYXStringWireBuffer sketchBuffer;
+	sketchBuffer << merged;
+
+	TRACE_INFO("StringSketch benchmark: exact histogram " << (int)(1000*exactTime) << "ms, " << exactBuffer.size() << " bytes; "
+		<< "sketch " << (int)(1000*timer.getTime()) << "ms, " << sketchBuffer.size() << " bytes, "
+		<< "distinct " << merged.getDistinctCount() << " (real " << distinctValues.size() << ")");
+}
+
+StringSketch::StringSketch(int capacity) : m_capacity(capacity), m_count(0)
+{
+}
+
+StringSketch::StringSketch(const StringSketch & other) :
+	m_capacity(other.m_capacity),
+	m_count(other.m_count),
+	m_boundaries(other.m_boundaries),
+	m_distinct(other.m_distinct),
+	m_counters(other.m_counters),
+	m_order(other.m_order)
+{
+}
+
+StringSketch & StringSketch::operator=(const StringSketch & other)
+{
+	m_capacity = other.m_capacity;
+	m_count = other.m_count;
+	m_boundaries = other.m_boundaries;
+	m_distinct = other.m_distinct;
+	m_counters = other.m_counters;
+	m_order = other.m_order;
+	return *this;
+}
+
+void StringSketch::add(const std::string & value)
+{
+	if (m_count == 0)
+	{
+		m_boundaries = RangeString::createClosedClosed(value,value);
+	}
+	else if (value < m_boundaries.min)
+	{
+		m_boundaries.min = value;
+	}
+	else if (m_boundaries.max < value)
+	{
+		m_boundaries.max = value;
+	}
+
+	m_count++;
+	m_distinct.add(value);
+	increment(value,1,0);
+}
+
+/*!
+Merge another sketch. A value tracked by only one of the sketches may have been
+evicted from the other one, so it is charged the smallest count of the other
+sketch as both count and error. The merged counters are then cut back to the
+capacity.
+*/
+void StringSketch::add(const StringSketch & other)
+{
+	if (other.m_count == 0)
+	{
+		return;
+	}
+
+	if (m_count == 0)
+	{
+		m_boundaries = other.m_boundaries;
+	}
+	else
+	{
+		if (other.m_boundaries.min < m_boundaries.min)
+		{
+			m_boundaries.min = other.m_boundaries.min;
+		}
+		if (m_boundaries.max < other.m_boundaries.max)
+		{
+			m_boundaries.max = other.m_boundaries.max;
+		}
+	}
+
+	m_count += other.m_count;
+	m_distinct.add(other.m_distinct);
+
+	const int thisMin = getMinTrackedCount();
+	const int otherMin = other.getMinTrackedCount();
+
+	std::vector<HeavyHitter> merged;
+	merged.reserve(m_counters.size() + other.m_counters.size());
+
+	for(CounterMap::const_iterator it = m_counters.begin();it != m_counters.end();++it)
+	{
+		CounterMap::const_iterator otherIt = other.m_counters.find(it->first);
+		if (otherIt != other.m_counters.end())
+		{
+			merged.push_back(HeavyHitter(it->first,it->second.count + otherIt->second.count,it->second.error + otherIt->second.error));
+		}
+		else
+		{
+			merged.push_back(HeavyHitter(it->first,it->second.count + otherMin,it->second.error + otherMin));
+		}
+	}
+
+	for(CounterMap::const_iterator it = other.m_counters.begin();it != other.m_counters.end();++it)
+	{
+		if (m_counters.find(it->first) == m_counters.end())
+		{
+			merged.push_back(HeavyHitter(it->first,it->second.count + thisMin,it->second.error + thisMin));
+		}
+	}
+
+	std::sort(merged.begin(),merged.end(),heavyHitterByCountDesc);
+	if ((int)merged.size() > m_capacity)
+	{
+		merged.resize(m_capacity);
+	}
+
+	m_counters.clear();
+	for(std::vector<HeavyHitter>::const_iterator it = merged.begin();it != merged.end();++it)
+	{
+		Counter & counter = m_counters[it->value];
+		counter.count = it->count;
+		counter.error = it->error;
+	}
+	rebuildOrder();
+}
+
+RangeInt StringSketch::count(const RangeString & range) const
+{
+	int min = 0;
+	int max = 0;
+
+	for(CounterMap::const_iterator it = m_counters.begin();it != m_counters.end();++it)
+	{
+		if (range.contains(it->first))
+		{
+			min += it->second.count - it->second.error;
+			max += it->second.count;
+		}
+	}
+
+	// untracked values may fall in the range as well
+	max = std::min(m_count,max + getUntrackedCount());
+
+	return RangeInt::createClosedClosed(min,max);
+}
+
+int StringSketch::getDistinctCount() const
+{
+	// the tracked values are a lower bound of the distinct count
+	return std::max((int)m_counters.size(),(int)(m_distinct.estimate() + 0.5));
+}
+
+void StringSketch::getHeavyHitters(std::vector<HeavyHitter> & result) const
+{
+	result.clear();
+	result.reserve(m_counters.size());
+
+	for(CounterMap::const_iterator it = m_counters.begin();it != m_counters.end();++it)
+	{
+		result.push_back(HeavyHitter(it->first,it->second.count,it->second.error));
+	}
+
+	std::sort(result.begin(),result.end(),heavyHitterByValue);
+}
+
+int StringSketch::getUntrackedCount() const
+{
+	int tracked = 0;
+	for(CounterMap::const_iterator it = m_counters.begin();it != m_counters.end();++it)
+	{
+		tracked += it->second.count - it->second.error;
+	}
+	return std::max(0,m_count - tracked);
+}
+
+void StringSketch::increment(const std::string & value,int count,int error)
+{
+	CounterMap::iterator it = m_counters.find(value);
+
+	if (it != m_counters.end())
+	{
+		m_order.erase(std::make_pair(it->second.count,value));
+		it->second.count += count;
+		m_order.insert(std::make_pair(it->second.count,value));
+		return;
+	}
+
+	if ((int)m_counters.size() < m_capacity)
+	{
+		Counter & counter = m_counters[value];
+		counter.count = count;
+		counter.error = error;
+		m_order.insert(std::make_pair(count,value));
+		return;
+	}
+
+	// replace the smallest counter, the new value inherits its count as error
+	CounterOrder::iterator smallest = m_order.begin();
+	const int minCount = smallest->first;
+	m_counters.erase(smallest->second);
+	m_order.erase(smallest);
+
+	Counter & counter = m_counters[value];
+	counter.count = minCount + count;
+	counter.error = minCount + error;
+	m_order.insert(std::make_pair(counter.count,value));
+}
+
+int StringSketch::getMinTrackedCount() const
+{
+	if ((int)m_counters.size() < m_capacity || m_order.empty())
+	{
+		return 0;
+	}
+	return m_order.begin()->first;
+}
+
+void StringSketch::rebuildOrder()
+{
+	m_order.clear();
+	for(CounterMap::const_iterator it = m_counters.begin();it != m_counters.end();++it)
+	{
+		m_order.insert(std::make_pair(it->second.count,it->first));
+	}
+}
+
+PYXWireBuffer & operator >> (PYXWireBuffer & buffer,StringSketch & sketch)
+{
+	unsigned char version;
+	buffer >> version;
+	if (version != knSketchVersion)
+	{
+		PYXTHROW(PYXException,"Unsupported string sketch version " << (int)version);
+	}
+
+	buffer >> sketch.m_capacity >> sketch.m_count;
+	buffer >> sketch.m_boundaries.min >> sketch.m_boundaries.max;
+	sketch.m_boundaries.minType = knClosed;
+	sketch.m_boundaries.maxType = knClosed;
+	buffer >> sketch.m_distinct;
+
+	int size;
+	buffer >> size;
+	sketch.m_counters.clear();
+	std::string value;
+	for(int i=0;i<size;++i)
+	{
+		buffer >> value;
+		StringSketch::Counter & counter = sketch.m_counters[value];
+		buffer >> counter.count >> counter.error;
+	}
+	sketch.rebuildOrder();
+	return buffer;
+}
+
+PYXWireBuffer & operator << (PYXWireBuffer & buffer,const StringSketch & sketch)
+{
+	buffer << knSketchVersion;
+	buffer << sketch.m_capacity << sketch.m_count;
+	buffer << sketch.m_boundaries.min << sketch.m_boundaries.max;
+	buffer << sketch.m_distinct;
+
+	buffer << (int)sketch.m_counters.size();
+	for(StringSketch::CounterMap::const_iterator it = sketch.m_counters.begin();it != sketch.m_counters.end();++it)
+	{
+		buffer << it->first << it->second.count << it->second.error;
+	}
+	return buffer;
+}
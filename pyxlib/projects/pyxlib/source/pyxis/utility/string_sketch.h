@@ -0,0 +1,195 @@
+#ifndef PYXIS__UTILITY__STRING_SKETCH_H
+#define PYXIS__UTILITY__STRING_SKETCH_H
+/******************************************************************************
+string_sketch.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+// pyxlib includes
+#include "pyxlib.h"
+#include "range.h"
+#include "wire_buffer.h"
+
+// boost includes
+#include <boost/cstdint.hpp>
+
+// standard includes
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// HyperLogLog
+///////////////////////////////////////////////////////////////////////////////
+
+/*!
+HyperLogLog estimates the number of distinct values added to it using 2^precision
+one byte registers (4KB for the default precision), with a standard error of
+about 1.04/sqrt(2^precision). Two estimators are merged by taking the maximum of
+each register.
+*/
+//! Distinct count estimator.
+class PYXLIB_DECL HyperLogLog
+{
+public:
+	static const int knDefaultPrecision = 12;
+
+	explicit HyperLogLog(int precision = knDefaultPrecision);
+
+	//! Add a value by its 64 bit hash.
+	void addHash(boost::uint64_t hash);
+
+	//! Add a string value.
+	void add(const std::string & value);
+
+	//! Merge another estimator with the same precision.
+	void add(const HyperLogLog & other);
+
+	//! Estimated number of distinct values.
+	double estimate() const;
+
+	//! 64 bit hash used for strings.
+	static boost::uint64_t hash(const std::string & value);
+
+private:
+	int m_precision;
+	std::vector<unsigned char> m_registers;
+
+public:
+	friend PYXLIB_DECL PYXWireBuffer & operator >> (PYXWireBuffer & buffer,HyperLogLog & hll);
+	friend PYXLIB_DECL PYXWireBuffer & operator << (PYXWireBuffer & buffer,const HyperLogLog & hll);
+};
+
+PYXLIB_DECL PYXWireBuffer & operator >> (PYXWireBuffer & buffer,HyperLogLog & hll);
+PYXLIB_DECL PYXWireBuffer & operator << (PYXWireBuffer & buffer,const HyperLogLog & hll);
+
+///////////////////////////////////////////////////////////////////////////////
+// StringSketch
+///////////////////////////////////////////////////////////////////////////////
+
+/*!
+StringSketch summarizes a string field with bounded memory:
+- the exact count and boundaries (min/max value).
+- a HyperLogLog estimate of the number of distinct values.
+- the most frequent values, tracked with the Space-Saving algorithm. Every
+  tracked value has a count and an over-estimation error, so its real count is
+  between count-error and count.
+
+Unlike StringHistogram it does not grow with the number of distinct values, and
+merging two sketches costs O(capacity).
+*/
+//! Mergeable distinct count and heavy hitters summary of string values.
+class PYXLIB_DECL StringSketch
+{
+public:
+	//! Test method.
+	static void test();
+
+	//! Compare building and merging 100 groups with the exact StringHistogram (not run by the tests).
+	static void benchmark();
+
+	//! Default number of tracked frequent values.
+	static const int knDefaultCapacity = 256;
+
+public:
+	//! A tracked frequent value.
+	struct HeavyHitter
+	{
+		std::string value;
+		int count;
+		int error;
+
+		HeavyHitter() : count(0), error(0)
+		{
+		}
+
+		HeavyHitter(const std::string & _value,int _count,int _error) : value(_value), count(_count), error(_error)
+		{
+		}
+
+		//! The range of the real count of the value.
+		RangeInt getCountRange() const { return RangeInt::createClosedClosed(count-error,count); }
+	};
+
+public:
+	explicit StringSketch(int capacity = knDefaultCapacity);
+
+	template<class InputIterator>
+	StringSketch(InputIterator first,InputIterator last,int capacity = knDefaultCapacity) : m_capacity(capacity), m_count(0)
+	{
+		while(first != last)
+		{
+			add(*first);
+			++first;
+		}
+	}
+
+	StringSketch(const StringSketch & other);
+	StringSketch & operator=(const StringSketch & other);
+
+public:
+	void add(const std::string & value);
+
+	//! Merge another sketch into this one.
+	void add(const StringSketch & other);
+
+	//! Number of values added.
+	int count() const { return m_count; }
+
+	//! Estimated number of values contained in the range.
+	RangeInt count(const RangeString & range) const;
+
+	//! Estimated number of distinct values.
+	int getDistinctCount() const;
+
+	//! The exact min/max values.
+	const RangeString & getBoundaries() const { return m_boundaries; }
+
+	//! Return the tracked values ordered by value.
+	void getHeavyHitters(std::vector<HeavyHitter> & result) const;
+
+	//! Number of values that are not accounted for by the tracked values.
+	int getUntrackedCount() const;
+
+private:
+	struct Counter
+	{
+		int count;
+		int error;
+	};
+
+	typedef std::map<std::string,Counter> CounterMap;
+	typedef std::set<std::pair<int,std::string>> CounterOrder;
+
+	//! Increase the counter of a value, replacing the smallest counter if needed.
+	void increment(const std::string & value,int count,int error);
+
+	//! Smallest tracked count if the sketch is full, 0 otherwise.
+	int getMinTrackedCount() const;
+
+	//! Rebuild the counter order after the counters were replaced.
+	void rebuildOrder();
+
+private:
+	int m_capacity;
+	int m_count;
+	RangeString m_boundaries;
+	HyperLogLog m_distinct;
+	CounterMap m_counters;
+
+	//! The counters ordered by count, to find the one to replace.
+	CounterOrder m_order;
+
+public:
+	friend PYXLIB_DECL PYXWireBuffer & operator >> (PYXWireBuffer & buffer,StringSketch & sketch);
+	friend PYXLIB_DECL PYXWireBuffer & operator << (PYXWireBuffer & buffer,const StringSketch & sketch);
+};
+
+PYXLIB_DECL PYXWireBuffer & operator >> (PYXWireBuffer & buffer,StringSketch & sketch);
+PYXLIB_DECL PYXWireBuffer & operator << (PYXWireBuffer & buffer,const StringSketch & sketch);
+
+#endif // guard
@@ -14,10 +14,207 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/app_services.h"
 #include "pyxis/utility/file_utils.h"
 #include "pyxis/utility/exception.h"
+#include "pyxis/utility/profile.h"
 #include "pyxis/utility/string_utils.h"
+#include "pyxis/utility/tester.h"
+
+// boost includes
+#include <boost/bind.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/detail/interlocked.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
 
 // standard includes
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <exception>
+#include <vector>
+
+// windows includes
+#include <windows.h>
+
+namespace
+{
+
+//! Return true if the sequence number nFirst was taken before nSecond (the numbers wrap around).
+bool isSequenceBefore(long nFirst,long nSecond)
+{
+	return static_cast<long>(static_cast<unsigned long>(nFirst) - static_cast<unsigned long>(nSecond)) < 0;
+}
+
+/*!
+A single producer, single consumer ring buffer of trace messages. Only the thread
+owning the queue adds messages, and only the thread holding Trace::m_mutex removes
+them. The counters only grow: the entry of the message number n is n modulo the
+capacity, and the interlocked increment of a counter publishes the entry.
+*/
+class TraceQueue
+{
+public:
+	//! Number of messages a thread can queue before writing them itself.
+	static const unsigned long knCapacity = 4096;
+
+	struct Entry
+	{
+		Trace::eLevel nLevel;
+
+		//! The order of the message among the messages of all threads.
+		long nSequence;
+
+		//! The file name literal of a TRACE macro, or 0 to use strFile.
+		const char* szFile;
+
+		std::string strFile;
+		int nLine;
+		std::string strMessage;
+	};
+
+	TraceQueue() :
+		m_entries(knCapacity),
+		m_nWritten(0),
+		m_nRead(0),
+		m_nRetired(0)
+	{
+	}
+
+	//! Add a message (the message is swapped into the queue), return false if the queue is full.
+	bool push(long nSequence,Trace::eLevel nLevel,const char* szFile,const std::string & strFile,int nLine,std::string & strMessage)
+	{
+		unsigned long nWritten = static_cast<unsigned long>(static_cast<long>(m_nWritten));
+		if (nWritten - static_cast<unsigned long>(static_cast<long>(m_nRead)) >= knCapacity)
+		{
+			return false;
+		}
+
+		Entry & entry = m_entries[nWritten % knCapacity];
+		entry.nLevel = nLevel;
+		entry.nSequence = nSequence;
+		entry.szFile = szFile;
+		entry.strFile = strFile;
+		entry.nLine = nLine;
+		entry.strMessage.swap(strMessage);
+
+		++m_nWritten;
+		return true;
+	}
+
+	//! Get the sequence number of the oldest message, return false if the queue is empty.
+	bool peek(long & nSequence) const
+	{
+		unsigned long nRead = static_cast<unsigned long>(static_cast<long>(m_nRead));
+		if (nRead == static_cast<unsigned long>(static_cast<long>(m_nWritten)))
+		{
+			return false;
+		}
+
+		nSequence = m_entries[nRead % knCapacity].nSequence;
+		return true;
+	}
+
+	//! Remove the oldest message, return false if the queue is empty.
+	bool pop(Entry & entry)
+	{
+		unsigned long nRead = static_cast<unsigned long>(static_cast<long>(m_nRead));
+		if (nRead == static_cast<unsigned long>(static_cast<long>(m_nWritten)))
+		{
+			return false;
+		}
+
+		Entry & queued = m_entries[nRead % knCapacity];
+		entry.nLevel = queued.nLevel;
+		entry.nSequence = queued.nSequence;
+		entry.szFile = queued.szFile;
+		entry.strFile.swap(queued.strFile);
+		entry.nLine = queued.nLine;
+		entry.strMessage.swap(queued.strMessage);
+
+		++m_nRead;
+		return true;
+	}
+
+	//! Called when the owning thread exits, the queue receives no more messages.
+	void retire()
+	{
+		++m_nRetired;
+	}
+
+	bool isRetired() const
+	{
+		return m_nRetired != 0;
+	}
+
+private:
+	std::vector<Entry> m_entries;
+	boost::detail::atomic_count m_nWritten;
+	boost::detail::atomic_count m_nRead;
+	boost::detail::atomic_count m_nRetired;
+};
+
+//! The period of the writer thread in milliseconds.
+const int knWriterPeriod = 20;
+
+//! The queues of all threads, guarded by Trace::m_mutex.
+std::vector< boost::shared_ptr<TraceQueue> > s_queues;
+
+//! The queue is owned by s_queues, it is removed there once it is written.
+void retireQueue(TraceQueue* pQueue)
+{
+	pQueue->retire();
+}
+
+//! The queue of the current thread.
+boost::thread_specific_ptr<TraceQueue> s_threadQueue(&retireQueue);
+
+//! Set to stop the writer thread.
+boost::detail::atomic_count s_nStopWriter(0);
+
+//! The sequence number of the last message queued by any thread.
+boost::detail::atomic_count s_nSequence(0);
+
+//! The handlers replaced by the crash handlers of the trace.
+std::terminate_handler s_pPreviousTerminate = 0;
+LPTOP_LEVEL_EXCEPTION_FILTER s_pPreviousFilter = 0;
+
+/*!
+Write the queued messages before the process is terminated by an uncaught C++
+exception, then call the previous handler.
+*/
+void flushOnTerminate()
+{
+	Trace::flushOnCrash();
+
+	if (s_pPreviousTerminate != 0)
+	{
+		s_pPreviousTerminate();
+	}
+	std::abort();
+}
+
+/*!
+Write the queued messages before the process is terminated by an unhandled
+structured exception (access violation, stack overflow...), then call the
+previous filter.
+
+\param pExceptionInfo	The exception.
+
+\return The result of the previous filter, or EXCEPTION_CONTINUE_SEARCH.
+*/
+LONG WINAPI flushOnUnhandledException(EXCEPTION_POINTERS* pExceptionInfo)
+{
+	Trace::flushOnCrash();
+
+	if (s_pPreviousFilter != 0)
+	{
+		return s_pPreviousFilter(pExceptionInfo);
+	}
+	return EXCEPTION_CONTINUE_SEARCH;
+}
+
+}
 
 //! Singleton.
 Trace* Trace::m_pTrace = 0;
@@ -52,8 +249,8 @@ const std::string Trace::kstrLevel = "Level";
 const std::string Trace::kstrLevelDesc = "Bit pattern that defines trace level (see Trace::eLevel).";
 
 /*!
-Send a trace message to cout if the trace level is high enough. Do not call
-this method directly, use the macros defined in trace.h instead.
+Queue a trace message. Do not call this method directly, use the macros defined
+in trace.h instead. Errors are written immediately, with all the queued messages.
 
 \param nLevel		The trace level.
 \param strFile		The name of the file where the message originated.
@@ -65,20 +262,142 @@ void Trace::message(	eLevel nLevel,
 						int nLine,
 						const std::string& strMessage	)
 {
-	boost::recursive_mutex::scoped_lock lock(m_mutex);
-	static int messageNoFlush = 0;
 	assert(Trace::getInstance() != 0);
 
-	// trace to output stream, trace level is checked by macro
-	std::ostream& out = Trace::getInstance()->getOutputStream();
+	std::string strQueued(strMessage);
+	enqueue(nLevel, 0, strFile, nLine, strQueued);
+
+	if (nLevel == knError)
+	{
+		flush();
+	}
+}
+
+/*!
+Check the rate limit of a call site. Do not call this method directly, use the
+macros defined in trace.h instead.
+
+\param nLevel		The trace level.
+\param callSite	The call site.
+
+\return true if the message can be traced.
+*/
+bool Trace::isAllowed(eLevel nLevel,CallSite & callSite)
+{
+	if (nLevel == knError)
+	{
+		return true;
+	}
+
+	long nWindow = static_cast<long>(std::time(0));
+	if (callSite.nWindow != nWindow)
+	{
+		// a new second (threads racing here may let a few more messages through)
+		BOOST_INTERLOCKED_EXCHANGE(&callSite.nWindow, nWindow);
+		BOOST_INTERLOCKED_EXCHANGE(&callSite.nCount, 0);
+	}
+
+	if (BOOST_INTERLOCKED_INCREMENT(&callSite.nCount) <= knMaxMessagesPerSecond)
+	{
+		return true;
+	}
+
+	BOOST_INTERLOCKED_INCREMENT(&callSite.nSuppressed);
+	return false;
+}
+
+/*!
+Queue a trace message of a call site. Do not call this method directly, use the
+macros defined in trace.h instead. The file and line are only formatted by the
+writer thread.
+
+\param nLevel		The trace level.
+\param szFile		The name of the file where the message originated (a literal).
+\param nLine		The line in the file where the message originated.
+\param strMessage	The message.
+\param callSite	The call site.
+*/
+void Trace::post(	eLevel nLevel,
+					const char* szFile,
+					int nLine,
+					std::string strMessage,
+					CallSite & callSite	)
+{
+	long nSuppressed = BOOST_INTERLOCKED_EXCHANGE(&callSite.nSuppressed, 0);
+	if (nSuppressed > 0)
+	{
+		strMessage += " (" + StringUtils::toString(nSuppressed) + " similar messages suppressed)";
+	}
+
+	enqueue(nLevel, szFile, std::string(), nLine, strMessage);
+
+	if (nLevel == knError)
+	{
+		flush();
+	}
+}
+
+/*!
+Queue a message in the ring buffer of the calling thread. If the buffer is full,
+the calling thread writes the queued messages itself.
+*/
+void Trace::enqueue(	eLevel nLevel,
+						const char* szFile,
+						const std::string& strFile,
+						int nLine,
+						std::string& strMessage	)
+{
+	long nSequence = ++s_nSequence;
+
+	TraceQueue* pQueue = s_threadQueue.get();
+	if (pQueue == 0)
+	{
+		boost::shared_ptr<TraceQueue> spQueue(new TraceQueue());
+		{
+			boost::recursive_mutex::scoped_lock lock(m_mutex);
+			s_queues.push_back(spQueue);
+		}
+		pQueue = spQueue.get();
+		s_threadQueue.reset(pQueue);
+
+		// the terminate handler is set per thread by the VS2012 runtime
+		std::set_terminate(&flushOnTerminate);
+	}
+
+	if (!pQueue->push(nSequence, nLevel, szFile, strFile, nLine, strMessage))
+	{
+		// the writer thread is behind
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		writeQueuedMessages();
+		pQueue->push(nSequence, nLevel, szFile, strFile, nLine, strMessage);
+	}
+}
+
+/*!
+Write a message to the output stream and the callback.
+
+\param nLevel		The trace level.
+\param strFile		The name of the file where the message originated.
+\param nLine		The line in the file where the message originated.
+\param strMessage	The message.
+*/
+void Trace::write(	eLevel nLevel,
+					const std::string& strFile,
+					int nLine,
+					const std::string& strMessage	)
+{
+	if (m_pTrace == 0)
+	{
+		return;
+	}
+
+	std::ostream& out = m_pTrace->getOutputStream();
 	std::string strPrefix;
-	bool forceFlush = false;
 
 	switch (nLevel)
 	{
 		case knError:
 			strPrefix = kstrErrorPrefix;
-			forceFlush = true;
 			break;
 
 		case knTime:
@@ -133,14 +452,6 @@ void Trace::message(	eLevel nLevel,
 
 	// send to the output stream 
 	out << stream.str() << "\n";
-	
-	messageNoFlush++;
-	
-	if (forceFlush || messageNoFlush>50)
-	{
-		out.flush();
-		messageNoFlush = 0;
-	}
 
 	// If the callback has been set, then we send a copy of the trace 
 	//	output to that callback.
@@ -157,6 +468,132 @@ void Trace::message(	eLevel nLevel,
 	}
 }	
 
+/*!
+Write the queued messages of all threads, merged by sequence number. Only the
+messages queued before the call are written, so a busy thread can not keep the
+writer in the loop. A message whose sequence number was taken just before a
+message of another thread, but queued after it was written, is written with the
+next messages. The queues of the threads that exited are removed once written.
+
+\return The number of messages written.
+*/
+int Trace::writeQueuedMessages()
+{
+	const long nLastSequence = s_nSequence;
+
+	int nCount = 0;
+	TraceQueue::Entry entry;
+
+	for (;;)
+	{
+		// find the queue with the oldest message
+		TraceQueue* pNext = 0;
+		long nNextSequence = 0;
+		for (unsigned int n = 0; n < s_queues.size(); ++n)
+		{
+			long nSequence;
+			if (s_queues[n]->peek(nSequence) &&
+				!isSequenceBefore(nLastSequence, nSequence) &&
+				(pNext == 0 || isSequenceBefore(nSequence, nNextSequence)))
+			{
+				pNext = s_queues[n].get();
+				nNextSequence = nSequence;
+			}
+		}
+
+		if (pNext == 0)
+		{
+			break;
+		}
+
+		pNext->pop(entry);
+		write(entry.nLevel, entry.szFile != 0 ? std::string(entry.szFile) : entry.strFile, entry.nLine, entry.strMessage);
+		++nCount;
+	}
+
+	// a retired queue receives no more messages
+	std::vector< boost::shared_ptr<TraceQueue> >::iterator it = s_queues.begin();
+	while (it != s_queues.end())
+	{
+		long nSequence;
+		if ((*it)->isRetired() && !(*it)->peek(nSequence))
+		{
+			it = s_queues.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	return nCount;
+}
+
+/*!
+The writer thread writes the queued messages every knWriterPeriod milliseconds
+and flushes the stream after writing.
+*/
+void Trace::writerThreadFunc()
+{
+	while (s_nStopWriter == 0)
+	{
+		{
+			boost::recursive_mutex::scoped_lock lock(m_mutex);
+			if (writeQueuedMessages() > 0 && m_pTrace != 0)
+			{
+				m_pTrace->getOutputStream().flush();
+			}
+		}
+
+		boost::system_time const timeout = boost::get_system_time() + boost::posix_time::milliseconds(knWriterPeriod);
+		boost::thread::sleep(timeout);
+	}
+}
+
+/*!
+Write the queued messages when the process exits without destroying the trace.
+*/
+void Trace::flushAtExit()
+{
+	if (m_pTrace != 0)
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		writeQueuedMessages();
+		m_pTrace->getOutputStream().flush();
+	}
+}
+
+/*!
+Write the queued messages when the process crashes. Another thread may hold the
+lock while it crashes, so the lock is only waited for a short time.
+*/
+void Trace::flushOnCrash()
+{
+	if (m_pTrace == 0)
+	{
+		return;
+	}
+
+	for (int nAttempt = 0; nAttempt < 50; ++nAttempt)
+	{
+		if (m_mutex.try_lock())
+		{
+			try
+			{
+				writeQueuedMessages();
+				m_pTrace->getOutputStream().flush();
+			}
+			catch (...)
+			{
+				// the process is going down anyway
+			}
+			m_mutex.unlock();
+			return;
+		}
+		::Sleep(10);
+	}
+}
+
 /*!
 Sets the call back function. (Usually called at app init.)
 
@@ -178,7 +615,8 @@ forms of trace to the log (knAll).
 */
 Trace::Trace() :
 	m_nLevels(knAll),
-	m_out()
+	m_out(),
+	m_pWriterThread(0)
 {
 	// Get the trace file path.
 	boost::filesystem::path tracePath = AppServices::getTraceFilePath();
@@ -221,6 +659,11 @@ Trace::Trace() :
 	m_clock = std::clock();
 	m_out << "Log started: " << StringUtils::now(); // ctime adds newline
 	m_out << std::endl;
+
+	std::atexit(&Trace::flushAtExit);
+	s_pPreviousTerminate = std::set_terminate(&flushOnTerminate);
+	s_pPreviousFilter = ::SetUnhandledExceptionFilter(&flushOnUnhandledException);
+	m_pWriterThread = new boost::thread(&Trace::writerThreadFunc);
 }
 
 /*!
@@ -258,6 +701,8 @@ void Trace::flush()
 
 	if (trace)
 	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		writeQueuedMessages();
 		trace->getOutputStream().flush();		
 	}
 }
@@ -269,6 +714,20 @@ the trace instance can not be re-acquired in this program run.
 void Trace::destroy()
 {
 	PYXException::disableTrace();
+
+	if (m_pTrace != 0 && m_pTrace->m_pWriterThread != 0)
+	{
+		++s_nStopWriter;
+		m_pTrace->m_pWriterThread->join();
+		delete m_pTrace->m_pWriterThread;
+		m_pTrace->m_pWriterThread = 0;
+	}
+
+	{
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		writeQueuedMessages();
+	}
+
 	delete m_pTrace;
 	m_pTrace = 0;
 	bTraceDestroyed = true;
@@ -338,11 +797,15 @@ void Trace::traceOff(Trace::eLevel nTraceLevel)
 }
 
 /*!
-Print out the level of tracing to the trace stream. This method must be called
-by a thread safe method since it is not thread safe on its own.
+Print out the level of tracing to the trace stream, after the queued messages.
 */
 void Trace::traceLevel() const
 {
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	// keep the order with the queued messages
+	writeQueuedMessages();
+
 	// construct and output the trace level directly to the stream
 	std::string strOutput =		"Trace level set to '" + 
 								StringUtils::toString(m_nLevels) + 
@@ -400,3 +863,243 @@ void Trace::traceLevel() const
 		m_pCallbackFunction(Trace::knInfo, strOutput, m_pCallbackUserData);
 	}
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// Testing
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! Tester class
+Tester<Trace> gTester;
+
+//! The messages received by the trace callback during the test.
+struct TraceCapture
+{
+	boost::mutex mutex;
+	std::vector<std::string> messages;
+};
+
+void captureTrace(Trace::eLevel nTraceLevel, const std::string &strMessage, void* pUserData)
+{
+	TraceCapture* pCapture = static_cast<TraceCapture*>(pUserData);
+	boost::mutex::scoped_lock lock(pCapture->mutex);
+	pCapture->messages.push_back(strMessage);
+}
+
+void traceTestMessages(int nThread,int nCount)
+{
+	for (int n = 0; n < nCount; ++n)
+	{
+		TRACE_TEST("trace test thread " << nThread << " message " << n);
+	}
+}
+
+void traceBurst(int nCount)
+{
+	for (int n = 0; n < nCount; ++n)
+	{
+		TRACE_TEST("trace burst message " << n);
+	}
+}
+
+void traceOrderMessage(const std::string & strMessage)
+{
+	TRACE_TEST(strMessage);
+}
+
+//! The position of the first message containing a text, or -1.
+int findMessage(TraceCapture & capture,const std::string & strText)
+{
+	boost::mutex::scoped_lock lock(capture.mutex);
+	for (unsigned int n = 0; n < capture.messages.size(); ++n)
+	{
+		if (capture.messages[n].find(strText) != std::string::npos)
+		{
+			return static_cast<int>(n);
+		}
+	}
+	return -1;
+}
+
+//! Queue messages from a call site of the thread, the way the TRACE macros do once the rate limit allowed them.
+void traceBenchmarkMessages(int nThread,int nCount)
+{
+	Trace::CallSite callSite = { 0, 0, 0 };
+	for (int n = 0; n < nCount; ++n)
+	{
+		std::ostringstream stream;
+		stream << "trace benchmark thread " << nThread << " message " << n;
+		Trace::post(Trace::knTest, __FILE__, __LINE__, stream.str(), callSite);
+	}
+}
+
+int countMessages(TraceCapture & capture,const std::string & strText)
+{
+	boost::mutex::scoped_lock lock(capture.mutex);
+	int nCount = 0;
+	for (unsigned int n = 0; n < capture.messages.size(); ++n)
+	{
+		if (capture.messages[n].find(strText) != std::string::npos)
+		{
+			++nCount;
+		}
+	}
+	return nCount;
+}
+
+}
+
+void Trace::test()
+{
+	const int knThreads = 4;
+	const int knMessages = 100;
+
+	unsigned int nLevels = getInstance()->getLevels();
+	CallbackFunction pOldCallback = m_pCallbackFunction;
+	void* pOldUserData = m_pCallbackUserData;
+
+	getInstance()->setLevels(knAll);
+
+	TraceCapture capture;
+	flush();
+	setCallback(&captureTrace, &capture);
+
+	// messages from several threads are all written, in order for every thread
+	{
+		boost::thread_group threads;
+		for (int nThread = 0; nThread < knThreads; ++nThread)
+		{
+			threads.create_thread(boost::bind(&traceTestMessages, nThread, knMessages));
+		}
+		threads.join_all();
+	}
+	flush();
+
+	std::vector<int> nextMessage(knThreads, 0);
+	{
+		boost::mutex::scoped_lock lock(capture.mutex);
+		for (unsigned int n = 0; n < capture.messages.size(); ++n)
+		{
+			std::string::size_type nPos = capture.messages[n].find("trace test thread ");
+			if (nPos == std::string::npos)
+			{
+				continue;
+			}
+
+			std::istringstream in(capture.messages[n].substr(nPos + 18));
+			int nThread = -1;
+			std::string strWord;
+			int nMessage = -1;
+			in >> nThread >> strWord >> nMessage;
+
+			TEST_ASSERT(0 <= nThread && nThread < knThreads);
+			TEST_ASSERT_EQUAL(nMessage, nextMessage[nThread]);
+			++nextMessage[nThread];
+		}
+	}
+	for (int nThread = 0; nThread < knThreads; ++nThread)
+	{
+		TEST_ASSERT_EQUAL(nextMessage[nThread], knMessages);
+	}
+
+	// a call site is rate limited, the suppressed messages are reported with the next message
+	const int knBurst = 3 * knMaxMessagesPerSecond;
+	traceBurst(knBurst);
+	flush();
+	TEST_ASSERT(countMessages(capture, "trace burst message") < knBurst);
+
+	// the suppressed messages are reported with the first message of the next second
+	CallSite callSite = { 0, 0, 0 };
+	for (int n = 0; n < knBurst; ++n)
+	{
+		isAllowed(knTest, callSite);
+	}
+	TEST_ASSERT(callSite.nSuppressed > 0);
+	--callSite.nWindow;
+	TEST_ASSERT(isAllowed(knTest, callSite));
+	post(knTest, __FILE__, __LINE__, "trace burst end", callSite);
+	flush();
+	TEST_ASSERT(findMessage(capture, "trace burst end (") >= 0);
+
+	// the messages of different threads are written in the order they were traced
+	{
+		boost::thread first(boost::bind(&traceOrderMessage, std::string("trace order first")));
+		first.join();
+		boost::thread second(boost::bind(&traceOrderMessage, std::string("trace order second")));
+		second.join();
+		traceOrderMessage("trace order third");
+	}
+	flush();
+	int nFirst = findMessage(capture, "trace order first");
+	int nSecond = findMessage(capture, "trace order second");
+	int nThird = findMessage(capture, "trace order third");
+	TEST_ASSERT(0 <= nFirst && nFirst < nSecond && nSecond < nThird);
+
+	setCallback(pOldCallback, pOldUserData);
+
+	getInstance()->setLevels(nLevels);
+}
+
+//! Write messages the way the trace did before the queues, to compare.
+void Trace::benchmarkSynchronousWrite(int nThread,int nCount)
+{
+	for (int n = 0; n < nCount; ++n)
+	{
+		std::ostringstream stream;
+		stream << "trace benchmark synchronous thread " << nThread << " message " << n;
+		boost::recursive_mutex::scoped_lock lock(m_mutex);
+		write(knTest, __FILE__, __LINE__, stream.str());
+		if (n % 50 == 0)
+		{
+			m_pTrace->getOutputStream().flush();
+		}
+	}
+}
+
+void Trace::benchmark()
+{
+	const int knThreads = 16;
+	const int knMessages = 2000;
+	const int knTotal = knThreads * knMessages;
+
+	unsigned int nLevels = getInstance()->getLevels();
+	getInstance()->setLevels(knAll);
+	flush();
+
+	PYXHighQualityTimer timer;
+
+	// queued messages: the threads only wait for the writer when their queue is full
+	timer.start();
+	{
+		boost::thread_group threads;
+		for (int nThread = 0; nThread < knThreads; ++nThread)
+		{
+			threads.create_thread(boost::bind(&traceBenchmarkMessages, nThread, knMessages));
+		}
+		threads.join_all();
+	}
+	timer.stop();
+	double fQueuedTime = timer.getTime();
+	flush();
+
+	// every message written under the trace lock
+	timer.start();
+	{
+		boost::thread_group threads;
+		for (int nThread = 0; nThread < knThreads; ++nThread)
+		{
+			threads.create_thread(boost::bind(&Trace::benchmarkSynchronousWrite, nThread, knMessages));
+		}
+		threads.join_all();
+	}
+	timer.stop();
+	double fSynchronousTime = timer.getTime();
+	flush();
+
+	getInstance()->setLevels(nLevels);
+
+	TRACE_INFO("Trace: " << knThreads << " threads logged " << knTotal << " messages in " << fQueuedTime << "[sec] (" << knTotal / std::max(fQueuedTime, 1e-6) << " calls/sec), "
+		<< knTotal / std::max(fSynchronousTime, 1e-6) << " calls/sec when writing under the lock");
+}
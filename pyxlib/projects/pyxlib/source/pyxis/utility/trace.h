@@ -14,6 +14,11 @@ web			: www.pyxisinnovation.com
 // boost includes
 #include <boost/thread/recursive_mutex.hpp>
 
+namespace boost
+{
+	class thread;
+}
+
 // standard includes
 #include <ctime>
 #include <fstream>
@@ -23,15 +28,20 @@ web			: www.pyxisinnovation.com
 /*
 The trace calls are implemented as macros so we can get the file name and line
 number and to avoid the overhead of a method call when trace is disabled.
+Every macro expansion has its own call site used to rate limit the messages.
 */
 //! For internal use only....
 #define TRACE_IMPL( LEVEL, F, L, EXPRESSION) \
 	do {\
 		if ((Trace::getInstance() != 0) && TRACE_ENABLED( LEVEL)) \
 		{ \
-    		std::ostringstream stream; \
-			stream << EXPRESSION; \
-			Trace::message( LEVEL, F, L, stream.str()); \
+			static Trace::CallSite callSite = { 0, 0, 0 }; \
+			if (Trace::isAllowed( LEVEL, callSite)) \
+			{ \
+    			std::ostringstream stream; \
+				stream << EXPRESSION; \
+				Trace::post( LEVEL, F, L, stream.str(), callSite); \
+			} \
 		}\
 	} while (false)
 
@@ -95,6 +105,18 @@ The trace facility allows the program to specify the level of
 logging to perform.  Trace statements should always be 
 created using the macros.  The trace level can  be set with
 the traceOn(), traceOff() or setLevels().
+
+Messages are queued in a lock-free ring buffer owned by the calling thread and
+written to the file (and the callback) by a background writer thread, so the
+threads never wait on each other to log. Every message gets a sequence number and
+the queues are merged by sequence number, so the log keeps the order of the
+trace calls across threads. Errors are written synchronously, with everything
+queued before them, and the queues are written on flush(), destroy(), at exit,
+on std::terminate and on an unhandled structured exception (a crash).
+
+Every call site is limited to knMaxMessagesPerSecond messages per second (errors
+are never limited), the number of suppressed messages is reported with the next
+message of the call site.
 */
 //! Manages application log output.
 class PYXLIB_DECL Trace
@@ -141,6 +163,32 @@ public:
 	static const std::string kstrLevel;
 	static const std::string kstrLevelDesc;
 
+	//! Maximum number of messages per second from a single call site.
+	static const long knMaxMessagesPerSecond = 1000;
+
+	/*!
+	The rate limiting state of a TRACE macro. It is a POD so a function static
+	instance is initialized before any thread can use it.
+	*/
+	//! Rate limiting state of a trace call site.
+	struct CallSite
+	{
+		//! The second the messages are counted for.
+		volatile long nWindow;
+
+		//! Number of messages in the current second.
+		volatile long nCount;
+
+		//! Number of messages suppressed since the last message written.
+		volatile long nSuppressed;
+	};
+
+	//! Test method
+	static void test();
+
+	//! Log from 16 threads and report the calls per second, queued and written under the lock (not run by the tests).
+	static void benchmark();
+
 	//! Get singleton instance.
 	static Trace* getInstance();
 
@@ -185,12 +233,25 @@ public:
 							int nLine,
 							const std::string& strMessage	);
 
+	//! Check the rate limit of a call site. (USE THE MACRO, NOT THIS)
+	static bool isAllowed(eLevel nLevel,CallSite & callSite);
+
+	//! Queue a message of a call site, szFile must be a literal. (USE THE MACRO, NOT THIS)
+	static void post(	eLevel nLevel,
+						const char* szFile,
+						int nLine,
+						std::string strMessage,
+						CallSite & callSite	);
+
 	//! Get a timestamp string.
 	std::string getTimestampString();
 
 	//! flush the log onto disk
 	static void flush();
 
+	//! Flush the log from a crash handler, without waiting long for the lock.
+	static void flushOnCrash();
+
 	//! Destroy the trace instance.
 	static void destroy();
 
@@ -211,6 +272,31 @@ private:
 	//! Get the output stream.
 	inline std::ostream& getOutputStream() {return m_out;}
 
+	//! Queue a message in the ring buffer of the calling thread.
+	static void enqueue(	eLevel nLevel,
+							const char* szFile,
+							const std::string& strFile,
+							int nLine,
+							std::string& strMessage	);
+
+	//! Write a message to the stream and the callback. The caller must lock m_mutex.
+	static void write(	eLevel nLevel,
+						const std::string& strFile,
+						int nLine,
+						const std::string& strMessage	);
+
+	//! Write the queued messages of all threads. The caller must lock m_mutex.
+	static int writeQueuedMessages();
+
+	//! The background writer thread.
+	static void writerThreadFunc();
+
+	//! Write the queued messages when the process exits.
+	static void flushAtExit();
+
+	//! Write messages synchronously from a thread, for the benchmark.
+	static void benchmarkSynchronousWrite(int nThread,int nCount);
+
 private:
 
 	//! The most recent timestamp
@@ -225,6 +311,9 @@ private:
 	//! Output stream.
 	std::ofstream m_out;
 
+	//! The background writer thread.
+	boost::thread* m_pWriterThread;
+
 private:
 
 	//! A mutex to protect the file from multithreaded access.
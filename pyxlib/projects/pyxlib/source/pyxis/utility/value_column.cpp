@@ -15,6 +15,7 @@ web			: www.pyxisinnovation.com
 #include "pyxis/utility/tester.h"
 
 // standard includes
+#include <algorithm>
 #include <sstream>
 
 //! The unit test class
@@ -1158,6 +1159,45 @@ void PYXValueColumn::test()
 		}
 
 	} // END OF TEST 15
+
+	{ // TEST 16: bulk copies of a nullable array of float[2]
+		PYXValueColumn va(PYXValue::knFloat, 5, 2);
+		float pair[2] = {1.5f, -2.0f};
+		va.setValue(1, PYXValue(pair, 2));
+		va.setValue(3, PYXValue(pair, 2));
+		va.setValue(4, PYXValue());
+
+		double values[10];
+		unsigned char hasValues[5];
+		TEST_ASSERT(va.getValues(values, hasValues) == 2);
+		for (int nElement = 0; nElement < 5; ++nElement)
+		{
+			const bool bSet = (nElement == 1 || nElement == 3);
+			TEST_ASSERT(hasValues[nElement] == (bSet ? 1 : 0));
+			TEST_ASSERT(values[2 * nElement] == (bSet ? 1.5 : 0.0));
+			TEST_ASSERT(values[2 * nElement + 1] == (bSet ? -2.0 : 0.0));
+		}
+
+		TEST_ASSERT(va.getDataBytes() == 5 * 2 * sizeof(float));
+		float data[10];
+		TEST_ASSERT(va.getData(data, hasValues) == 2);
+		TEST_ASSERT(data[2] == 1.5f && data[3] == -2.0f);
+		TEST_ASSERT(data[6] == 1.5f && data[7] == -2.0f);
+
+		// packed data is not available for strings
+		PYXValueColumn vs(PYXValue::knString, 5);
+		char bytes[64];
+		bool bThrown = false;
+		try
+		{
+			vs.getData(bytes);
+		}
+		catch (PYXValueColumnException&)
+		{
+			bThrown = true;
+		}
+		TEST_ASSERT(bThrown);
+	} // END OF TEST 16
 }
 
 /*!
@@ -1715,6 +1755,146 @@ bool PYXValueColumn::getValue(const int nIndex, PYXValue* pValue) const
 	return true;
 }
 
+/*!
+Helper: convert a packed array of a numeric type to doubles.
+*/
+template <typename T>
+static void copyAsDouble(const char* ptr, const int nCount, double* pValues)
+{
+	const T* pTyped = reinterpret_cast<const T*>(ptr);
+	for (int n = 0; n < nCount; ++n)
+	{
+		pValues[n] = static_cast<double>(pTyped[n]);
+	}
+}
+
+/*!
+Helper: copy the not-null flags of a column, one byte per element.
+
+\return	The number of elements that are not null.
+*/
+static int copyNotNull(	const char* pNotNull,
+						const int nColumnHeight,
+						unsigned char* pHasValues	)
+{
+	int nNotNull = 0;
+	for (int nIndex = 0; nIndex < nColumnHeight; ++nIndex)
+	{
+		const bool bNotNull = (pNotNull == 0) || bitSet(const_cast<char*>(pNotNull), nIndex);
+		if (pHasValues != 0)
+		{
+			pHasValues[nIndex] = bNotNull ? 1 : 0;
+		}
+		nNotNull += bNotNull ? 1 : 0;
+	}
+	return nNotNull;
+}
+
+/*!
+Copy the packed data of a numeric column in a single call: getHeight() elements
+of getWidth() values each, in the layout of the column (the data of null
+elements is undefined).  This is the fast path for bulk transfers, e.g. to a
+pinned .NET array.
+
+\param	pData		Receives getDataBytes() bytes.
+\param	pHasValues	Optional (may be 0), receives getHeight() flags, 1 where the
+					element is not null.
+
+\return	The number of elements that are not null.
+*/
+int PYXValueColumn::getData(void* pData, unsigned char* pHasValues) const
+{
+	if (m_type == PYXValue::knBool || m_type == PYXValue::knString)
+	{
+		throw PYXValueColumnException("Packed data is only available for numeric columns");
+	}
+
+	assert(pData != 0);
+	memcpy(pData, m_pValues, getDataBytes());
+
+	return copyNotNull(m_pNotNull, m_nColumnHeight, pHasValues);
+}
+
+/*!
+Copy all the values of a numeric or bool column in a single call, converted to
+double: getWidth() values for each of the getHeight() elements.  Null elements
+are set to 0.
+
+\param	pValues		Receives getHeight() * getWidth() values.
+\param	pHasValues	Optional (may be 0), receives getHeight() flags, 1 where the
+					element is not null.
+
+\return	The number of elements that are not null.
+*/
+int PYXValueColumn::getValues(double* pValues, unsigned char* pHasValues) const
+{
+	assert(pValues != 0);
+	const int nCount = m_nColumnHeight * m_nColumnWidth;
+
+	switch (m_type)
+	{
+	case PYXValue::knBool:
+		for (int n = 0; n < nCount; ++n)
+		{
+			pValues[n] = bitSet(m_pValues, n) ? 1.0 : 0.0;
+		}
+		break;
+
+	case PYXValue::knChar:
+		copyAsDouble<char>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knInt8:
+		copyAsDouble<int8_t>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knUInt8:
+		copyAsDouble<uint8_t>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knInt16:
+		copyAsDouble<int16_t>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knUInt16:
+		copyAsDouble<uint16_t>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knInt32:
+		copyAsDouble<int32_t>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knUInt32:
+		copyAsDouble<uint32_t>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knFloat:
+		copyAsDouble<float>(m_pValues, nCount, pValues);
+		break;
+
+	case PYXValue::knDouble:
+		memcpy(pValues, m_pValues, nCount * sizeof(double));
+		break;
+
+	default:
+		throw PYXValueColumnException("Values can only be converted to double for numeric columns");
+	}
+
+	// null elements hold undefined data (explicitly set nulls are flagged in their first byte)
+	if (m_pNotNull != 0)
+	{
+		for (int nIndex = 0; nIndex < m_nColumnHeight; ++nIndex)
+		{
+			if (!bitSet(m_pNotNull, nIndex))
+			{
+				std::fill(pValues + nIndex * m_nColumnWidth, pValues + (nIndex + 1) * m_nColumnWidth, 0.0);
+			}
+		}
+	}
+
+	return copyNotNull(m_pNotNull, m_nColumnHeight, pHasValues);
+}
+
 /*!
 Set the value at given index.
 */
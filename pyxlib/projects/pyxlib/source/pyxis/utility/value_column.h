@@ -100,6 +100,15 @@ public:
 	//! Set a value
 	void setValue(const int nIndex, const PYXValue& value);
 
+	//! Get the size of the packed data of a numeric column
+	int getDataBytes() const {return m_nSlotBytes * m_nColumnHeight;}
+
+	//! Copy the packed data of a numeric column, and the not-null flags
+	int getData(void* pData, unsigned char* pHasValues = 0) const;
+
+	//! Copy all the values converted to double, and the not-null flags
+	int getValues(double* pValues, unsigned char* pHasValues = 0) const;
+
 protected:
 
 	//! Default constructor creates a null column
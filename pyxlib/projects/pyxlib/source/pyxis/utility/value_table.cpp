@@ -360,6 +360,44 @@ void PYXValueTable::setValue(	const int nRow,
 	m_vecColumnData[nColumn]->setValue(nRow,value);
 }
 
+/*!
+Get the size of the packed data of a numeric column.
+*/
+int PYXValueTable::getColumnDataBytes(const int nColumn) const
+{
+	assert((nColumn >= 0) && (nColumn < getNumberOfColumns()));
+
+	return m_vecColumnData[nColumn]->getDataBytes();
+}
+
+/*!
+Copy the packed data of a numeric column in a single call.
+
+\sa PYXValueColumn::getData()
+*/
+int PYXValueTable::getColumnData(	const int nColumn,
+									void* pData,
+									unsigned char* pHasValues	) const
+{
+	assert((nColumn >= 0) && (nColumn < getNumberOfColumns()));
+
+	return m_vecColumnData[nColumn]->getData(pData, pHasValues);
+}
+
+/*!
+Copy the values of a column converted to double in a single call.
+
+\sa PYXValueColumn::getValues()
+*/
+int PYXValueTable::getColumnValues(	const int nColumn,
+									double* pValues,
+									unsigned char* pHasValues	) const
+{
+	assert((nColumn >= 0) && (nColumn < getNumberOfColumns()));
+
+	return m_vecColumnData[nColumn]->getValues(pValues, pHasValues);
+}
+
 /*!
 Current I/O format version: increment every time format changes.
 */
@@ -127,6 +127,15 @@ public:
 	//! Set a value with bounds and type checking
 	void setValue(const int nRow, const int nColumn, const PYXValue& value);
 
+	//! Get the size of the packed data of a numeric column
+	int getColumnDataBytes(const int nColumn) const;
+
+	//! Copy the packed data of a numeric column, and the not-null flags of its rows
+	int getColumnData(const int nColumn, void* pData, unsigned char* pHasValues = 0) const;
+
+	//! Copy the values of a column converted to double, and the not-null flags of its rows
+	int getColumnValues(const int nColumn, double* pValues, unsigned char* pHasValues = 0) const;
+
 protected:
 
 	//! Disable copy assignment
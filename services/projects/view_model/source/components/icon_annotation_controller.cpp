@@ -27,6 +27,7 @@ web			: www.pyxisinnovation.com
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <cassert>
+#include <cmath>
 #include <map>
 #include <vector>
 
@@ -280,7 +281,9 @@ IconAnnotationsController::StyledIcon::StyledIcon(IViewModel * view,const boost:
 		m_patch(patch),
 		m_location(skeleton->getLocation()),
 		m_textGenerated(false),
-		m_colorCalculated(false)
+		m_colorCalculated(false),
+		m_placementVisible(false),
+		m_clusterSize(0)
 {
 	if (m_iconStyle->hasText() && m_iconStyle->getTextAppearAlways())
 	{
@@ -406,6 +409,12 @@ bool IconAnnotationsController::StyledIcon::wasVisualizationGenerated()
 
 bool IconAnnotationsController::StyledIcon::canGenerateVisualization()
 {
+	//don't generate icons hidden by the declutter grid
+	if (!m_placementVisible)
+	{
+		return false;
+	}
+
 	if (m_iconStyle->hasIcon() )
 	{
 		if (!m_iconStyle->getIconTexture())
@@ -463,6 +472,8 @@ void IconAnnotationsController::StyledIcon::generateVisualization()
 			m_textIcon = m_iconStyle->addIcon(getTextTextureItem(),m_patch,m_location,vec2(1.0,1.0),textOffset,this);
 		}
 
+		applyPlacement();
+
 		validateElevation();
 	}
 	catch(...)
@@ -511,11 +522,50 @@ void IconAnnotationsController::StyledIcon::updateVisualization()
 
 			m_textIcon = m_iconStyle->addIcon(textTexture,m_patch,m_location,vec2(1.0,1.0),textOffset);
 
+			applyPlacement();
+
 			setDynamicVisualization(false);
 		}
 	}
 }
 
+void IconAnnotationsController::StyledIcon::setPlacement(bool visible,int clusterSize)
+{
+	m_placementVisible = visible;
+	m_clusterSize = clusterSize;
+
+	applyPlacement();
+}
+
+void IconAnnotationsController::StyledIcon::applyPlacement()
+{
+	//hidden icons keep their visualization with a zero scale
+	double clusterScale = 0;
+
+	if (m_placementVisible)
+	{
+		//a cluster grow up to twice the icon size (at 100 icons)
+		clusterScale = 1 + std::min(1.0,log(static_cast<double>(std::max(1,m_clusterSize)))/log(100.0));
+	}
+
+	if (m_icon)
+	{
+		vec2 scale = m_iconStyle->getIconScale() * clusterScale;
+
+		if (m_skeleton->isGroup())
+		{
+			scale *= 2;
+		}
+
+		m_icon->setScale(scale);
+	}
+
+	if (m_textIcon)
+	{
+		m_textIcon->setScale(m_placementVisible ? vec2(1.0,1.0) : vec2(0.0,0.0));
+	}
+}
+
 void IconAnnotationsController::StyledIcon::validateElevation()
 {
 	double elevation;
@@ -732,7 +782,7 @@ PYXPointer<IconAnnotationsController::IconAnnotationSkeleton> IconAnnotationsCon
 		double u,v;
 		if (patch->getRhombus().isInside(index,&u,&v))
 		{
-			return IconAnnotationSkeleton::create(featureInfo->m_featureID,featureInfo->m_groupID,getStyleSkeleton(m_globalStyle),vec2(u,v),CmlConvertor::toVec3(featureInfo->m_location),featureInfo->m_isGroup);
+			return IconAnnotationSkeleton::create(featureInfo->m_featureID,featureInfo->m_groupID,getStyleSkeleton(m_globalStyle),vec2(u,v),CmlConvertor::toVec3(featureInfo->m_location),featureInfo->m_isGroup,featureInfo->m_weight);
 		}
 	}
 	return PYXPointer<IconAnnotationSkeleton>();
@@ -767,7 +817,7 @@ void IconAnnotationsController::LoadingThread::detach(IconAnnotationsController
 // IconAnnotationsController
 /////////////////////////////////////////////////////////////////////////////
 
-IconAnnotationsController::IconAnnotationsController(ViewOpenGLThread & viewThread) : Component(viewThread), m_iconRenderer(0)
+IconAnnotationsController::IconAnnotationsController(ViewOpenGLThread & viewThread) : Component(viewThread), m_iconRenderer(0), m_declutterGrid(IconDeclutterGrid::create())
 {
 	getViewThread().getViewPortProcessChangeNotifier().attach(this,&IconAnnotationsController::updateLoaders);
 }
@@ -792,6 +842,8 @@ void IconAnnotationsController::render()
 {
 	PerformanceCounter::getTimePerformanceCounter("Start IconAnnotationsController",0.5f,0.5f,1.0f)->makeMeasurement();
 
+	updateDeclutter();
+
 	for(IconAnnotationPatchMap::iterator it = m_visiblePatches.begin(); it != m_visiblePatches.end(); ++it)
 	{
 		if (!it->second)
@@ -820,6 +872,61 @@ void IconAnnotationsController::render()
 	getViewThread().setFrameTimeMeasurement("setup-icons");
 }
 
+void IconAnnotationsController::updateDeclutter()
+{
+	mat4 modelView;
+	mat4 projection;
+	getViewThread().getCamera().getModelViewMatrix(modelView);
+	getViewThread().getCamera().getProjectionMatrix(projection);
+
+	if (!m_declutterGrid->update(projection * modelView,getViewThread().getCamera().getEye(),getViewThread().getViewportWidth(),getViewThread().getViewportHeight()))
+	{
+		return;
+	}
+
+	for(auto & id : m_declutterGrid->getChangedIcons())
+	{
+		DeclutteredIconsMap::iterator iconIt = m_declutteredIcons.find(id);
+
+		if (iconIt != m_declutteredIcons.end())
+		{
+			iconIt->second->setPlacement(m_declutterGrid->isVisible(id),m_declutterGrid->getClusterSize(id));
+		}
+	}
+}
+
+void IconAnnotationsController::removeDeclutteredIcons(IconAnnotationPatch & patch,const ProcRef & procRef)
+{
+	IconAnnotationPatch::DeclutterIdsMap::iterator idsIt = patch.getDeclutterIds().find(procRef);
+
+	if (idsIt == patch.getDeclutterIds().end())
+	{
+		return;
+	}
+
+	for(auto & id : idsIt->second)
+	{
+		m_declutterGrid->remove(id);
+		m_declutteredIcons.erase(id);
+	}
+
+	patch.getDeclutterIds().erase(idsIt);
+}
+
+void IconAnnotationsController::removeDeclutteredIcons(IconAnnotationPatch & patch)
+{
+	for(auto & ids : patch.getDeclutterIds())
+	{
+		for(auto & id : ids.second)
+		{
+			m_declutterGrid->remove(id);
+			m_declutteredIcons.erase(id);
+		}
+	}
+
+	patch.getDeclutterIds().clear();
+}
+
 int IconAnnotationsController::getLoadingProgress() {
 	// there is no loading threads - there is no icons to display
 	if (m_loadingThreads.empty()) 
@@ -882,6 +989,8 @@ void IconAnnotationsController::updateLoaders(PYXPointer<NotifierEvent> e)
 		}
 		m_loadingThreads.clear();
 		m_visiblePatches.clear();
+		m_declutterGrid->clear();
+		m_declutteredIcons.clear();
 
 		m_surface = getViewThread().getSurface();
 
@@ -1011,7 +1120,7 @@ void IconAnnotationsController::borrowIcons(const PYXPointer<Surface::Patch> & p
 						//if this annotation is inside the patch... borrow it
 						if (uv[0]>=0 && uv[0]<=1 && uv[1] >=0 && uv[1]<=1)
 						{
-							skeleton = IconAnnotationSkeleton::create(skeleton->getFeatureID(),skeleton->getGroupID(),skeleton->getStyleSkeleton(),uv,skeleton->getLocation(),skeleton->isGroup());
+							skeleton = IconAnnotationSkeleton::create(skeleton->getFeatureID(),skeleton->getGroupID(),skeleton->getStyleSkeleton(),uv,skeleton->getLocation(),skeleton->isGroup(),skeleton->getWeight());
 							borrowedSkeletons->addAnnotationSkeleton(u*3,v*3,skeleton);
 							borrowedCount++;
 						}
@@ -1050,6 +1159,7 @@ void IconAnnotationsController::onPatchBecomeHidden(PYXPointer<NotifierEvent> e)
 
 	if (it->second)
 	{
+		removeDeclutteredIcons(*(it->second));
 		it->second->getAnnotations()->destroyAnnotations();
 	}
 
@@ -1064,6 +1174,7 @@ void IconAnnotationsController::removeAllAnnotations(const boost::intrusive_ptr<
 	{
 		if (it->second)
 		{
+			removeDeclutteredIcons(*(it->second),procRef);
 			it->second->getAnnotations()->removeAllAnnotationOfPipeline(procRef);
 			it->second->getSkeletons().erase(procRef);
 		}
@@ -1095,10 +1206,13 @@ void IconAnnotationsController::addNewAnnotations(	PYXPointer<Surface::Patch> pa
 
 	ProcRef procRef(process);
 
+	removeDeclutteredIcons(annotations,procRef);
 	annotations.getAnnotations()->removeAllAnnotationOfPipeline(procRef);
 
 	annotations.getSkeletons()[procRef] = newProcessAnnotations;
 
+	std::vector<int> & declutterIds = annotations.getDeclutterIds()[procRef];
+
 	for(int u=0;u<10;u++)
 	{
 		for(int v=0;v<10;v++)
@@ -1107,13 +1221,19 @@ void IconAnnotationsController::addNewAnnotations(	PYXPointer<Surface::Patch> pa
 
 			if (skeleton)
 			{
-				annotations.getAnnotations()->addAnnotation(createAnnotation(patch,process,skeleton));
+				PYXPointer<StyledIcon> icon = createAnnotation(patch,process,skeleton);
+				annotations.getAnnotations()->addAnnotation(icon);
+
+				//the icon is hidden until the declutter grid place it
+				int id = m_declutterGrid->add(skeleton->getLocation(),skeleton->getWeight());
+				m_declutteredIcons[id] = icon;
+				declutterIds.push_back(id);
 			}
 		}
 	}
 }
 
-PYXPointer<Annotation> IconAnnotationsController::createAnnotation(	const PYXPointer<Surface::Patch> & patch, 
+PYXPointer<IconAnnotationsController::StyledIcon> IconAnnotationsController::createAnnotation(	const PYXPointer<Surface::Patch> & patch, 
 																	const boost::intrusive_ptr<IProcess> & process,
 																	const PYXPointer<IconAnnotationSkeleton> & skeleton )
 {
@@ -10,6 +10,7 @@ web			: www.pyxisinnovation.com
 ******************************************************************************/
 
 #include "component.h"
+#include "icon_declutter_grid.h"
 
 #include "pyxis/utility/thread_pool.h"
 
@@ -20,12 +21,13 @@ IconAnnotationsController - responsible to generate Icons from input Pipelines
      - Generate IconSkeletons from pipelines for each patch with background threads
      - On render loop, call PatchIconAnnotation->update() to make annotatation update themselfs
 	 - This Controller doesn't deal with picking annotation, it happen in IconRenderer
+	 - Icons are decluttered on the screen by IconDeclutterGrid: overlapping icons are hidden and clustered into the most important one (by feature weight)
 
 -- OpenGL extentions:
 	 - None
 
 -- Limitations: 
-	 - Too many icons can slow down the FPS
+	 - Too many icons can slow down the FPS (the declutter placement is limited to a budget of icons per frame)
 	 - Too many piplines can slow dwon the FPS
 	 
 */
@@ -215,6 +217,7 @@ public:
 		bool m_isGroup;
 		vec2 m_uv;
 		vec3 m_location;
+		double m_weight;
 		PYXPointer<IconStyleSkeleton> m_styleSkeleton;
 
 	public:
@@ -224,21 +227,23 @@ public:
 		const vec2 & getUV() const { return m_uv; }
 		const vec3 & getLocation() const { return m_location; }
 		bool isGroup() const { return m_isGroup; }
+		double getWeight() const { return m_weight; }
 
 	public:
-		IconAnnotationSkeleton(const std::string & featureID,const std::string & groupID,const PYXPointer<IconStyleSkeleton> & styleSkeleton,const vec2 & uv,const vec3 & location,bool group)
+		IconAnnotationSkeleton(const std::string & featureID,const std::string & groupID,const PYXPointer<IconStyleSkeleton> & styleSkeleton,const vec2 & uv,const vec3 & location,bool group,double weight)
 			:	m_featureID(featureID),
 				m_groupID(groupID),
 				m_styleSkeleton(styleSkeleton),
 				m_uv(uv),
 				m_location(location),
-				m_isGroup(group)
+				m_isGroup(group),
+				m_weight(weight)
 		{
 		}
 
-		static PYXPointer<IconAnnotationSkeleton> create(const std::string & featureID,const std::string & groupID,const PYXPointer<IconStyleSkeleton> & styleSkeleton,const vec2 & uv,const vec3 & location,bool group)
+		static PYXPointer<IconAnnotationSkeleton> create(const std::string & featureID,const std::string & groupID,const PYXPointer<IconStyleSkeleton> & styleSkeleton,const vec2 & uv,const vec3 & location,bool group,double weight)
 		{
-			return PYXNEW(IconAnnotationSkeleton,featureID,groupID,styleSkeleton,uv,location,group);
+			return PYXNEW(IconAnnotationSkeleton,featureID,groupID,styleSkeleton,uv,location,group,weight);
 		}
 	};
 
@@ -279,8 +284,15 @@ public:
 		unsigned char m_color[4];
 		PYXPointer<PYXTaskWithContinuation> m_colorBackgroundTask;
 
+		//! placement from the IconDeclutterGrid, the icon is hidden until placed
+		bool m_placementVisible;
+		int m_clusterSize;
+
 		bool generateText();
 
+		//! scale the icon by its placement (hidden icons get a zero scale)
+		void applyPlacement();
+
 		PYXPointer<PackedTextureItem> getTextTextureItem();
 
 	private:
@@ -291,6 +303,10 @@ public:
 		virtual void onMouseEnter(PYXPointer<AnnotationMouseEvent> eventData);
 		virtual void onMouseLeave(PYXPointer<AnnotationMouseEvent> eventData);
 
+	public:
+		//! set the placement of the icon, clusterSize is the number of icons it represents
+		void setPlacement(bool visible,int clusterSize);
+
 	//UI creation;
 	public:
 		virtual bool wasVisualizationGenerated();
@@ -344,11 +360,17 @@ public:
 		IconAnnotationSkeletonPatchMap m_skeletons;
 		PYXPointer<PatchAnnotations> m_annotations;
 
+		typedef std::map<ProcRef,std::vector<int>> DeclutterIdsMap;
+		DeclutterIdsMap m_declutterIds;
+
 	public:
 		const PYXPointer<PatchAnnotations> & getAnnotations() { return m_annotations; }
 
 		IconAnnotationSkeletonPatchMap & getSkeletons() { return m_skeletons; }
 
+		//! the ids of the icons of each pipeline in the IconDeclutterGrid
+		DeclutterIdsMap & getDeclutterIds() { return m_declutterIds; }
+
 	public:
 		IconAnnotationPatch() : m_annotations(PatchAnnotations::create())
 		{
@@ -371,12 +393,13 @@ public:
 			std::string m_groupID;
 			PYXCoord3DDouble m_location;
 			bool m_isGroup;
+			double m_weight;
 
-			SelectedFeatureInfo(const AnnotationCache::AnnotationInfo & info) : m_featureID(info.m_featureID), m_groupID(info.m_groupID), m_location(info.m_location), m_isGroup(info.m_isGroup)
+			SelectedFeatureInfo(const AnnotationCache::AnnotationInfo & info) : m_featureID(info.m_featureID), m_groupID(info.m_groupID), m_location(info.m_location), m_isGroup(info.m_isGroup), m_weight(info.m_weight)
 			{
 			}
 
-			SelectedFeatureInfo(const std::string & featureId,const std::string & groupID,const PYXCoord3DDouble & location, bool group) : m_featureID(featureId), m_groupID(groupID), m_location(location), m_isGroup(group)
+			SelectedFeatureInfo(const std::string & featureId,const std::string & groupID,const PYXCoord3DDouble & location, bool group, double weight = 0) : m_featureID(featureId), m_groupID(groupID), m_location(location), m_isGroup(group), m_weight(weight)
 			{
 			}
 		};
@@ -482,6 +505,12 @@ protected:
 	typedef std::map<boost::intrusive_ptr<IProcess>,IconStyleCache> IconStyleCacheMap;
 	IconStyleCacheMap m_stylesCache;
 
+	//! screen space placement of the icons of all visible patches
+	PYXPointer<IconDeclutterGrid> m_declutterGrid;
+
+	typedef std::map<int,PYXPointer<StyledIcon>> DeclutteredIconsMap;
+	DeclutteredIconsMap m_declutteredIcons;
+
 public:
 	IconAnnotationsController(ViewOpenGLThread & viewThread);
 
@@ -504,6 +533,13 @@ protected:
 	void onPatchBecomeHidden(PYXPointer<NotifierEvent> e);
 
 	void removeAllAnnotations(const boost::intrusive_ptr<IProcess> & process);
+
+	//! remove the icons of a pipeline (or of all pipelines) of a patch from the declutter grid
+	void removeDeclutteredIcons(IconAnnotationPatch & patch,const ProcRef & procRef);
+	void removeDeclutteredIcons(IconAnnotationPatch & patch);
+
+	//! continue the declutter placement and apply it when a pass completes
+	void updateDeclutter();
 	
 public:
 	void borrowIcons(const PYXPointer<Surface::Patch> & patch);
@@ -519,7 +555,7 @@ protected:
 							boost::intrusive_ptr<IProcess> process,
 							PYXPointer<IconAnnotationSkeletonPatch> newProcessAnnotations);
 
-	PYXPointer<Annotation> createAnnotation(	const PYXPointer<Surface::Patch> & patch, 
+	PYXPointer<StyledIcon> createAnnotation(	const PYXPointer<Surface::Patch> & patch, 
 												const boost::intrusive_ptr<IProcess> & process,
 												const PYXPointer<IconAnnotationSkeleton> & skeleton );
 
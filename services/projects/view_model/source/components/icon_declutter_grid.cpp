@@ -0,0 +1,859 @@
+/******************************************************************************
+icon_declutter_grid.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "StdAfx.h"
+#include "icon_declutter_grid.h"
+
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+/////////////////////////////////////////////////////////////////////////////
+// IconDeclutterGrid
+/////////////////////////////////////////////////////////////////////////////
+
+IconDeclutterGrid::IconDeclutterGrid(double cellSize,int budget)
+	:	m_cellSize(cellSize),
+		m_budget(budget),
+		m_nextId(0),
+		m_hasCamera(false),
+		m_width(0),
+		m_height(0),
+		m_gridColumns(0),
+		m_gridRows(0),
+		m_passActive(false),
+		m_passCursor(m_priorities.end()),
+		m_placedCount(0)
+{
+	assert(cellSize > 0 && budget > 0);
+}
+
+int IconDeclutterGrid::add(const vec3 & location,double priority)
+{
+	int id = m_nextId++;
+
+	IconEntry & entry = m_icons[id];
+	entry.location = location;
+	entry.order = m_priorities.insert(std::make_pair(priority,id));
+	entry.visible = false;
+	entry.clusterSize = 0;
+	entry.cell = knNotPlaced;
+	entry.x = 0;
+	entry.y = 0;
+	entry.shown = false;
+	entry.leader = 0;
+	entry.followers = 0;
+	entry.passItem = -1;
+
+	//an active pass places the icon if it did not walk past its priority yet, otherwise it is placed after the pass
+	m_pendingIcons.push_back(id);
+	return id;
+}
+
+void IconDeclutterGrid::remove(int id)
+{
+	std::map<int,IconEntry>::iterator it = m_icons.find(id);
+
+	if (it == m_icons.end())
+	{
+		return;
+	}
+
+	IconEntry & entry = it->second;
+
+	if (m_passActive)
+	{
+		if (entry.passItem != -1)
+		{
+			PassItem & item = m_passItems[entry.passItem];
+			item.id = -1;
+
+			if (!item.shown && item.leader != -1)
+			{
+				m_passItems[item.leader].followers--;
+			}
+		}
+
+		if (m_passCursor == entry.order)
+		{
+			++m_passCursor;
+		}
+
+		//the icons the removed icon was hiding are placed again after the pass
+		m_pendingLocations.push_back(entry.location);
+	}
+	else if (entry.cell >= 0)
+	{
+		GridCell & cell = m_grid[entry.cell];
+		cell.icons.erase(std::find(cell.icons.begin(),cell.icons.end(),CellIcon(id,&entry)));
+
+		if (entry.shown)
+		{
+			//a removed icon can uncover the icons it was clustering
+			cell.shown = -1;
+			cell.entry = 0;
+			m_pendingLocations.push_back(entry.location);
+			forgetLeader(entry);
+		}
+		else if (entry.leader)
+		{
+			entry.leader->followers--;
+			m_touched.push_back(entry.leader->order->second);
+		}
+	}
+
+	m_priorities.erase(entry.order);
+	m_icons.erase(it);
+}
+
+void IconDeclutterGrid::clear()
+{
+	m_icons.clear();
+	m_priorities.clear();
+	m_grid.clear();
+	m_passItems.clear();
+	m_passGrid.clear();
+	m_pendingIcons.clear();
+	m_pendingLocations.clear();
+	m_touched.clear();
+	m_changedIcons.clear();
+	m_passCursor = m_priorities.end();
+	m_passActive = false;
+	m_hasCamera = false;
+}
+
+bool IconDeclutterGrid::update(const mat4 & projection,const vec3 & eye,int width,int height)
+{
+	m_changedIcons.clear();
+	m_placedCount = 0;
+
+	if (!m_passActive)
+	{
+		if (!isCameraChanged(projection,eye,width,height))
+		{
+			applyChanges();
+			return !m_changedIcons.empty();
+		}
+
+		startPass(projection,eye,width,height);
+	}
+
+	for (int i = 0; i < m_budget && m_passCursor != m_priorities.end(); ++i)
+	{
+		placeNext();
+	}
+
+	if (m_passCursor != m_priorities.end())
+	{
+		return false;
+	}
+
+	completePass();
+	return true;
+}
+
+bool IconDeclutterGrid::isVisible(int id) const
+{
+	std::map<int,IconEntry>::const_iterator it = m_icons.find(id);
+
+	return it != m_icons.end() && it->second.visible;
+}
+
+int IconDeclutterGrid::getClusterSize(int id) const
+{
+	std::map<int,IconEntry>::const_iterator it = m_icons.find(id);
+
+	return it != m_icons.end() ? it->second.clusterSize : 0;
+}
+
+bool IconDeclutterGrid::isBefore(double priorityA,int a,double priorityB,int b)
+{
+	//icons of the same priority keep the order they were added in, like the priority map
+	return priorityA > priorityB || (priorityA == priorityB && a < b);
+}
+
+int IconDeclutterGrid::project(const vec3 & location,double * pX,double * pY) const
+{
+	//hide icons on the far side of the globe
+	if (cml::dot(location,m_eye - location) < 0)
+	{
+		return knOffScreen;
+	}
+
+	vec4 screen = m_projection * vec4(location[0],location[1],location[2],1.0);
+
+	//hide icons behind the camera
+	if (screen[3] <= 0)
+	{
+		return knOffScreen;
+	}
+
+	double x = (1 + screen[0] / screen[3]) / 2 * m_width;
+	double y = (1 - screen[1] / screen[3]) / 2 * m_height;
+
+	//hide icons outside the screen
+	if (x < 0 || x >= m_width || y < 0 || y >= m_height)
+	{
+		return knOffScreen;
+	}
+
+	*pX = x;
+	*pY = y;
+
+	int column = std::min(m_gridColumns - 1,static_cast<int>(x / m_cellSize));
+	int row = std::min(m_gridRows - 1,static_cast<int>(y / m_cellSize));
+
+	return row * m_gridColumns + column;
+}
+
+template<typename Filter>
+int IconDeclutterGrid::findClosest(const std::vector<GridCell> & grid,int cell,double x,double y,Filter filter) const
+{
+	int column = cell % m_gridColumns;
+	int row = cell / m_gridColumns;
+
+	//the shown icon of the cell is the closest one unless a neighbour is within the cell size
+	int closest = grid[cell].shown != -1 && filter(cell) ? cell : -1;
+	double closestDistance = m_cellSize * m_cellSize;
+
+	for (int r = std::max(0,row - 1); r <= std::min(m_gridRows - 1,row + 1); ++r)
+	{
+		for (int c = std::max(0,column - 1); c <= std::min(m_gridColumns - 1,column + 1); ++c)
+		{
+			const GridCell & neighbour = grid[r * m_gridColumns + c];
+
+			if (neighbour.shown == -1 || !filter(r * m_gridColumns + c))
+			{
+				continue;
+			}
+
+			double distance = (neighbour.x - x) * (neighbour.x - x) + (neighbour.y - y) * (neighbour.y - y);
+
+			if (distance < closestDistance)
+			{
+				closest = r * m_gridColumns + c;
+				closestDistance = distance;
+			}
+		}
+	}
+
+	return closest;
+}
+
+bool IconDeclutterGrid::isCameraChanged(const mat4 & projection,const vec3 & eye,int width,int height) const
+{
+	if (!m_hasCamera || width != m_width || height != m_height)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		if (eye[i] != m_eye[i])
+		{
+			return true;
+		}
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			if (projection(i,j) != m_projection(i,j))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void IconDeclutterGrid::startPass(const mat4 & projection,const vec3 & eye,int width,int height)
+{
+	m_hasCamera = true;
+	m_projection = projection;
+	m_eye = eye;
+	m_width = width;
+	m_height = height;
+
+	m_gridColumns = std::max(1,static_cast<int>(width / m_cellSize) + 1);
+	m_gridRows = std::max(1,static_cast<int>(height / m_cellSize) + 1);
+
+	GridCell empty;
+	empty.shown = -1;
+	empty.entry = 0;
+	empty.x = 0;
+	empty.y = 0;
+	m_passGrid.assign(m_gridColumns * m_gridRows,empty);
+
+	//the pass walks the priority order as it goes, so no frame does more than the budget
+	m_passItems.clear();
+	m_passCursor = m_priorities.begin();
+	m_passActive = true;
+
+	//the pass places every icon added or removed so far
+	m_pendingIcons.clear();
+	m_pendingLocations.clear();
+	m_touched.clear();
+}
+
+void IconDeclutterGrid::placeNext()
+{
+	int id = m_passCursor->second;
+	++m_passCursor;
+	++m_placedCount;
+
+	IconEntry & entry = m_icons.find(id)->second;
+	entry.passItem = static_cast<int>(m_passItems.size());
+
+	PassItem item;
+	item.id = id;
+	item.entry = &entry;
+	item.cell = project(entry.location,&item.x,&item.y);
+	item.shown = false;
+	item.leader = -1;
+	item.followers = 0;
+
+	if (item.cell >= 0)
+	{
+		//every shown icon was placed before this one
+		int closest = findClosest(m_passGrid,item.cell,item.x,item.y,[](int) { return true; });
+
+		if (closest != -1)
+		{
+			item.leader = m_passGrid[closest].shown;
+			m_passItems[item.leader].followers++;
+		}
+		else
+		{
+			GridCell & cell = m_passGrid[item.cell];
+			cell.shown = entry.passItem;
+			cell.entry = &entry;
+			cell.x = item.x;
+			cell.y = item.y;
+			item.shown = true;
+		}
+	}
+
+	m_passItems.push_back(item);
+}
+
+void IconDeclutterGrid::completePass()
+{
+	m_grid.swap(m_passGrid);
+	m_passGrid.clear();
+
+	for (std::vector<GridCell>::iterator cell = m_grid.begin(); cell != m_grid.end(); ++cell)
+	{
+		if (cell->shown != -1)
+		{
+			cell->shown = m_passItems[cell->shown].id;
+			cell->entry = cell->shown != -1 ? cell->entry : 0;
+		}
+	}
+
+	for (std::vector<PassItem>::const_iterator item = m_passItems.begin(); item != m_passItems.end(); ++item)
+	{
+		//the icon was removed during the pass
+		if (item->id == -1)
+		{
+			continue;
+		}
+
+		IconEntry & entry = *item->entry;
+		entry.cell = item->cell;
+		entry.x = item->x;
+		entry.y = item->y;
+		entry.shown = item->shown;
+		entry.leader = item->leader != -1 && m_passItems[item->leader].id != -1 ? m_passItems[item->leader].entry : 0;
+		entry.followers = item->followers;
+		entry.passItem = -1;
+
+		if (entry.cell >= 0)
+		{
+			m_grid[entry.cell].icons.push_back(CellIcon(item->id,&entry));
+		}
+
+		publish(item->id,entry);
+	}
+
+	m_passItems.clear();
+	m_passActive = false;
+
+	//place the icons added or removed after the pass walked past them
+	applyChanges();
+
+	std::sort(m_changedIcons.begin(),m_changedIcons.end());
+	m_changedIcons.erase(std::unique(m_changedIcons.begin(),m_changedIcons.end()),m_changedIcons.end());
+}
+
+void IconDeclutterGrid::applyChanges()
+{
+	if (m_pendingIcons.empty() && m_pendingLocations.empty() && m_touched.empty())
+	{
+		return;
+	}
+
+	m_cellMarks.assign(m_grid.size(),0);
+	std::vector<int> cells;
+
+	for (std::vector<vec3>::const_iterator location = m_pendingLocations.begin(); location != m_pendingLocations.end(); ++location)
+	{
+		double x;
+		double y;
+		int cell = project(*location,&x,&y);
+
+		if (cell >= 0)
+		{
+			markNeighbours(cell,cells);
+		}
+	}
+
+	for (std::vector<int>::const_iterator id = m_pendingIcons.begin(); id != m_pendingIcons.end(); ++id)
+	{
+		std::map<int,IconEntry>::iterator it = m_icons.find(*id);
+
+		//removed, or placed by the last pass
+		if (it == m_icons.end() || it->second.cell != knNotPlaced)
+		{
+			continue;
+		}
+
+		IconEntry & entry = it->second;
+		entry.cell = project(entry.location,&entry.x,&entry.y);
+
+		if (entry.cell < 0)
+		{
+			continue;
+		}
+
+		std::vector<CellIcon> & icons = m_grid[entry.cell].icons;
+		std::vector<CellIcon>::iterator position = icons.begin();
+		while (position != icons.end() && isBefore(position->second->order->first,position->first,entry.order->first,*id))
+		{
+			++position;
+		}
+		icons.insert(position,CellIcon(*id,&entry));
+
+		//the icon can only hide icons of its cell, the cells around are placed again if that shows or hides an icon
+		markCell(entry.cell,cells);
+	}
+
+	m_pendingLocations.clear();
+	m_pendingIcons.clear();
+
+	if (!cells.empty())
+	{
+		placeCells(cells);
+	}
+
+	std::sort(m_touched.begin(),m_touched.end());
+	m_touched.erase(std::unique(m_touched.begin(),m_touched.end()),m_touched.end());
+
+	for (std::vector<int>::const_iterator id = m_touched.begin(); id != m_touched.end(); ++id)
+	{
+		std::map<int,IconEntry>::iterator it = m_icons.find(*id);
+
+		if (it != m_icons.end())
+		{
+			publish(*id,it->second);
+		}
+	}
+
+	m_touched.clear();
+}
+
+void IconDeclutterGrid::markCell(int cell,std::vector<int> & cells)
+{
+	if (!m_cellMarks[cell])
+	{
+		m_cellMarks[cell] = 1;
+		cells.push_back(cell);
+	}
+}
+
+void IconDeclutterGrid::markNeighbours(int cell,std::vector<int> & cells)
+{
+	int column = cell % m_gridColumns;
+	int row = cell / m_gridColumns;
+
+	for (int r = std::max(0,row - 1); r <= std::min(m_gridRows - 1,row + 1); ++r)
+	{
+		for (int c = std::max(0,column - 1); c <= std::min(m_gridColumns - 1,column + 1); ++c)
+		{
+			markCell(r * m_gridColumns + c,cells);
+		}
+	}
+}
+
+void IconDeclutterGrid::placeCells(std::vector<int> & cells)
+{
+	std::vector<CellIcon> icons;
+
+	for (;;)
+	{
+		icons.clear();
+
+		for (std::vector<int>::const_iterator cell = cells.begin(); cell != cells.end(); ++cell)
+		{
+			GridCell & gridCell = m_grid[*cell];
+			gridCell.shown = -1;
+
+			icons.insert(icons.end(),gridCell.icons.begin(),gridCell.icons.end());
+		}
+
+		std::sort(icons.begin(),icons.end(),[](const CellIcon & a,const CellIcon & b)
+		{
+			return isBefore(a.second->order->first,a.first,b.second->order->first,b.first);
+		});
+
+		//take the icons out of the clusters of the icons around
+		for (auto & icon : icons)
+		{
+			IconEntry & entry = *icon.second;
+
+			if (entry.leader)
+			{
+				entry.leader->followers--;
+				m_touched.push_back(entry.leader->order->second);
+			}
+
+			entry.shown = false;
+			entry.leader = 0;
+		}
+
+		for (auto & icon : icons)
+		{
+			placeIcon(icon.first,*icon.second);
+		}
+
+		//an icon shown or hidden by the change can show or hide the icons of the cells around it
+		size_t cellsCount = cells.size();
+
+		for (auto & icon : icons)
+		{
+			if (icon.second->shown != icon.second->visible)
+			{
+				markNeighbours(icon.second->cell,cells);
+			}
+		}
+
+		if (cells.size() == cellsCount)
+		{
+			break;
+		}
+	}
+
+	for (auto & icon : icons)
+	{
+		m_touched.push_back(icon.first);
+	}
+}
+
+void IconDeclutterGrid::placeIcon(int id,IconEntry & entry)
+{
+	++m_placedCount;
+
+	//the shown icons of the marked cells were placed before this one, the ones around only count if they come first
+	int closest = findClosest(m_grid,entry.cell,entry.x,entry.y,[&](int cell) -> bool
+	{
+		const GridCell & shown = m_grid[cell];
+		return m_cellMarks[cell] || isBefore(shown.entry->order->first,shown.shown,entry.order->first,id);
+	});
+
+	if (closest != -1)
+	{
+		entry.leader = m_grid[closest].entry;
+		entry.leader->followers++;
+		m_touched.push_back(m_grid[closest].shown);
+		return;
+	}
+
+	GridCell & cell = m_grid[entry.cell];
+	cell.shown = id;
+	cell.entry = &entry;
+	cell.x = entry.x;
+	cell.y = entry.y;
+	entry.shown = true;
+}
+
+void IconDeclutterGrid::forgetLeader(IconEntry & leader)
+{
+	int column = leader.cell % m_gridColumns;
+	int row = leader.cell / m_gridColumns;
+
+	//the icons clustered into an icon are in the cells around it
+	for (int r = std::max(0,row - 1); r <= std::min(m_gridRows - 1,row + 1); ++r)
+	{
+		for (int c = std::max(0,column - 1); c <= std::min(m_gridColumns - 1,column + 1); ++c)
+		{
+			std::vector<CellIcon> & icons = m_grid[r * m_gridColumns + c].icons;
+
+			for (std::vector<CellIcon>::iterator icon = icons.begin(); icon != icons.end(); ++icon)
+			{
+				if (icon->second->leader == &leader)
+				{
+					icon->second->leader = 0;
+				}
+			}
+		}
+	}
+}
+
+void IconDeclutterGrid::publish(int id,IconEntry & entry)
+{
+	int clusterSize = entry.shown ? 1 + entry.followers : 0;
+
+	if (entry.visible != entry.shown || entry.clusterSize != clusterSize)
+	{
+		entry.visible = entry.shown;
+		entry.clusterSize = clusterSize;
+		m_changedIcons.push_back(id);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// IconDeclutterGrid test
+/////////////////////////////////////////////////////////////////////////////
+
+//! Tester class.
+Tester<IconDeclutterGrid> gTester;
+
+void IconDeclutterGrid::test()
+{
+	//the identity projection maps [-1,1] to the screen, the eye is far in front of the points
+	mat4 projection;
+	projection.identity();
+	vec3 eye(0,0,10);
+	const int width = 1000;
+	const int height = 1000;
+
+	//points in the plane z=1, 0.02 is 10 pixels
+	IconDeclutterGrid grid(32,100);
+	int a = grid.add(vec3(0,0,1),10);
+	int b = grid.add(vec3(0.02,0,1),5);
+	int c = grid.add(vec3(0.5,0.5,1),1);
+	int d = grid.add(vec3(0,0,-1),100);
+
+	TEST_ASSERT(!grid.isVisible(a) && !grid.isVisible(b));
+	TEST_ASSERT(grid.update(projection,eye,width,height));
+
+	//the closer icon is clustered into the more important one, the far side icon is hidden
+	TEST_ASSERT(grid.isVisible(a) && grid.getClusterSize(a) == 2);
+	TEST_ASSERT(!grid.isVisible(b));
+	TEST_ASSERT(grid.isVisible(c) && grid.getClusterSize(c) == 1);
+	TEST_ASSERT(!grid.isVisible(d));
+	TEST_ASSERT(grid.getChangedIcons().size() == 2);
+
+	//nothing changed, nothing to do
+	TEST_ASSERT(!grid.update(projection,eye,width,height));
+
+	//zoom in: the icons are 100 pixels apart
+	mat4 zoomed = projection;
+	zoomed(0,0) = 10;
+	zoomed(1,1) = 10;
+	TEST_ASSERT(grid.update(zoomed,eye,width,height));
+	TEST_ASSERT(grid.isVisible(a) && grid.getClusterSize(a) == 1);
+	TEST_ASSERT(grid.isVisible(b) && grid.getClusterSize(b) == 1);
+	TEST_ASSERT(!grid.isVisible(c));
+
+	//removing an icon uncovers the icon it clustered
+	TEST_ASSERT(grid.update(projection,eye,width,height));
+	TEST_ASSERT(!grid.isVisible(b));
+	grid.remove(a);
+	TEST_ASSERT(grid.update(projection,eye,width,height));
+	TEST_ASSERT(!grid.isPassActive());
+	TEST_ASSERT(grid.isVisible(b) && grid.getClusterSize(b) == 1);
+	TEST_ASSERT(std::find(grid.getChangedIcons().begin(),grid.getChangedIcons().end(),b) != grid.getChangedIcons().end());
+
+	//adding an icon only places the icons of its cell: e joins the cluster of b, c is not placed again
+	int e = grid.add(vec3(0.03,0,1),1);
+	TEST_ASSERT(grid.update(projection,eye,width,height));
+	TEST_ASSERT(grid.getPlacedCount() == 1);
+	TEST_ASSERT(!grid.isVisible(e) && grid.getClusterSize(b) == 2);
+	TEST_ASSERT(grid.getChangedIcons().size() == 1 && grid.getChangedIcons()[0] == b);
+
+	//a pass over more icons than the budget spans several frames
+	{
+		IconDeclutterGrid budgetGrid(32,2);
+		for (int i = 0; i < 5; ++i)
+		{
+			budgetGrid.add(vec3(-0.8 + 0.3 * i,0,1),i);
+		}
+		TEST_ASSERT(!budgetGrid.update(projection,eye,width,height));
+		TEST_ASSERT(!budgetGrid.update(projection,eye,width,height));
+		TEST_ASSERT(budgetGrid.isPassActive());
+		TEST_ASSERT(budgetGrid.update(projection,eye,width,height));
+		TEST_ASSERT(budgetGrid.getChangedIcons().size() == 5);
+	}
+
+	//icons added and removed between and during passes are placed like a full pass would
+	{
+		const int iconsCount = 2000;
+		IconDeclutterGrid changedGrid(32,200);
+		std::vector<vec3> locations;
+		std::vector<double> priorities;
+		std::vector<bool> removed;
+
+		srand(2);
+		for (int frame = 0; frame < 16; ++frame)
+		{
+			//move the camera every 6 frames, the passes span several frames
+			mat4 camera = projection;
+			camera(0,0) = camera(1,1) = 1 + frame / 6;
+
+			for (int i = 0; i < iconsCount / 10; ++i)
+			{
+				if (!locations.empty() && rand() % 3 == 0)
+				{
+					int id = rand() % static_cast<int>(locations.size());
+					changedGrid.remove(id);
+					removed[id] = true;
+					continue;
+				}
+
+				locations.push_back(vec3(2.0 * rand() / RAND_MAX - 1,2.0 * rand() / RAND_MAX - 1,1));
+				priorities.push_back(rand() % 10);
+				removed.push_back(false);
+				changedGrid.add(locations.back(),priorities.back());
+			}
+
+			changedGrid.update(camera,eye,width,height);
+
+			if (changedGrid.isPassActive())
+			{
+				continue;
+			}
+
+			IconDeclutterGrid fullGrid(32,iconsCount * 10);
+			std::vector<int> fullIds(locations.size(),-1);
+			for (int id = 0; id < static_cast<int>(locations.size()); ++id)
+			{
+				if (!removed[id])
+				{
+					fullIds[id] = fullGrid.add(locations[id],priorities[id]);
+				}
+			}
+			TEST_ASSERT(fullGrid.update(camera,eye,width,height));
+
+			for (int id = 0; id < static_cast<int>(locations.size()); ++id)
+			{
+				if (!removed[id])
+				{
+					TEST_ASSERT_EQUAL(changedGrid.isVisible(id),fullGrid.isVisible(fullIds[id]));
+					TEST_ASSERT_EQUAL(changedGrid.getClusterSize(id),fullGrid.getClusterSize(fullIds[id]));
+				}
+			}
+		}
+	}
+
+	//a pass over a dense layer is spread over frames, and no frame walks more icons than the budget
+	{
+		const int iconsCount = 2000;
+		const int budget = 200;
+		IconDeclutterGrid denseGrid(32,budget);
+
+		srand(1);
+		for (int i = 0; i < iconsCount; ++i)
+		{
+			double x = 2.0 * rand() / RAND_MAX - 1;
+			double y = 2.0 * rand() / RAND_MAX - 1;
+			denseGrid.add(vec3(x,y,1),rand() % 100);
+		}
+
+		int frames = 0;
+		bool completed = false;
+		while (!completed)
+		{
+			completed = denseGrid.update(projection,eye,width,height);
+			++frames;
+			TEST_ASSERT(denseGrid.getPlacedCount() <= budget);
+		}
+		TEST_ASSERT(frames == iconsCount / budget);
+
+		int visibleCount = 0;
+		for (int id = 0; id < iconsCount; ++id)
+		{
+			visibleCount += denseGrid.isVisible(id) ? 1 : 0;
+		}
+
+		//a 1000x1000 screen with 32 pixels cells can't show more than a cell per icon
+		TEST_ASSERT(visibleCount > 0 && visibleCount <= 32 * 32);
+
+		//incremental: removing a few icons only places the icons of the cells around them
+		for (int id = 0; id < 5; ++id)
+		{
+			denseGrid.remove(id);
+		}
+		denseGrid.update(projection,eye,width,height);
+		TEST_ASSERT(!denseGrid.isPassActive());
+		TEST_ASSERT(denseGrid.getPlacedCount() > 0 && denseGrid.getPlacedCount() < iconsCount / 2);
+	}
+}
+
+void IconDeclutterGrid::benchmark()
+{
+	mat4 projection;
+	projection.identity();
+	vec3 eye(0,0,10);
+	const int width = 1000;
+	const int height = 1000;
+
+	const int iconsCount = 200000;
+	const int budget = 20000;
+	IconDeclutterGrid benchmarkGrid(32,budget);
+
+	srand(1);
+	PYXHighQualityTimer timer;
+	timer.start();
+	for (int i = 0; i < iconsCount; ++i)
+	{
+		double x = 2.0 * rand() / RAND_MAX - 1;
+		double y = 2.0 * rand() / RAND_MAX - 1;
+		benchmarkGrid.add(vec3(x,y,1),rand() % 100);
+	}
+	timer.stop();
+	double addTime = timer.getTime();
+
+	int frames = 0;
+	double maxFrameTime = 0;
+	bool completed = false;
+	while (!completed)
+	{
+		timer.start();
+		completed = benchmarkGrid.update(projection,eye,width,height);
+		timer.stop();
+		maxFrameTime = std::max(maxFrameTime,timer.getTime());
+		++frames;
+	}
+
+	int visibleCount = 0;
+	for (int id = 0; id < iconsCount; ++id)
+	{
+		visibleCount += benchmarkGrid.isVisible(id) ? 1 : 0;
+	}
+
+	for (int id = 0; id < 100; ++id)
+	{
+		benchmarkGrid.remove(id);
+	}
+	timer.start();
+	benchmarkGrid.update(projection,eye,width,height);
+	timer.stop();
+	double removeTime = timer.getTime();
+	int removePlaced = benchmarkGrid.getPlacedCount();
+
+	TRACE_INFO("IconDeclutterGrid: " << iconsCount << " icons added in " << addTime << "[sec], placed in " << frames <<
+		" frames (max " << maxFrameTime << "[sec] per frame), " << visibleCount << " visible, 100 icons removed in " <<
+		removeTime << "[sec] placing " << removePlaced << " icons");
+}
@@ -0,0 +1,212 @@
+#pragma once
+#ifndef VIEW_MODEL__ICON_DECLUTTER_GRID_H
+#define VIEW_MODEL__ICON_DECLUTTER_GRID_H
+/******************************************************************************
+icon_declutter_grid.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "cml_utils.h"
+
+#include "pyxis/utility/object.h"
+
+#include <functional>
+#include <map>
+#include <vector>
+
+/*!
+IconDeclutterGrid - decide which icons are shown, hidden or clustered on the screen
+
+-- Description:
+     - Icons are added and removed as their patches load and unload, the grid keeps them ordered by priority.
+     - A placement pass projects the icons to the screen by priority order. An icon is shown if no shown icon
+	   is closer than the cell size (in pixels), otherwise it is hidden and counted in the cluster of the closest
+	   shown icon. A screen grid of the cell size make each test take constant time.
+     - A pass is started when the camera moved, so the placement follow the zoom level.
+	 - At most "budget" icons are placed on every frame. A pass over more icons span several frames (using the camera
+	   of its first frame), walking the priority order as it goes, and its placement is published when it completes.
+	 - The grid keeps the icons of every cell between passes. Adding or removing an icon places again only the icons
+	   of the cells around it, spreading to the neighbour cells only while an icon is shown or hidden by the change.
+	   The result is the placement a full pass would make.
+
+-- Limitations:
+	 - Icons are placed by their location, the size of their bitmap is ignored.
+*/
+//! IconDeclutterGrid - decide which icons are shown, hidden or clustered on the screen
+class IconDeclutterGrid : public PYXObject
+{
+public:
+	static void test();
+
+	//! Time placing a layer of 200000 icons (not run by the tests).
+	static void benchmark();
+
+	static PYXPointer<IconDeclutterGrid> create(double cellSize = 32.0,int budget = 20000)
+	{
+		return PYXNEW(IconDeclutterGrid,cellSize,budget);
+	}
+
+	IconDeclutterGrid(double cellSize,int budget);
+
+public:
+	//! add an icon, return its id. The icon is hidden until it is placed.
+	int add(const vec3 & location,double priority);
+
+	//! remove an icon
+	void remove(int id);
+
+	//! remove all icons
+	void clear();
+
+	//! continue the placement, return true if a pass has completed or icons were placed again on this frame
+	bool update(const mat4 & projection,const vec3 & eye,int width,int height);
+
+	//! return true if the icon is shown
+	bool isVisible(int id) const;
+
+	//! return the number of icons represented by the icon (1 if it has no cluster, 0 if hidden)
+	int getClusterSize(int id) const;
+
+	//! the icons whose placement was changed by the last update
+	const std::vector<int> & getChangedIcons() const { return m_changedIcons; }
+
+	int getIconsCount() const { return static_cast<int>(m_icons.size()); }
+
+	//! the number of icons placed by the last update
+	int getPlacedCount() const { return m_placedCount; }
+
+	bool isPassActive() const { return m_passActive; }
+
+private:
+	typedef std::multimap<double,int,std::greater<double>> PriorityMap;
+
+	//! the cell of an icon not placed with the current camera yet
+	static const int knNotPlaced = -2;
+
+	//! the cell of an icon outside the screen
+	static const int knOffScreen = -1;
+
+	struct IconEntry
+	{
+		vec3 location;
+		PriorityMap::iterator order;
+
+		//! the published placement
+		bool visible;
+		int clusterSize;
+
+		//! the placement with the camera of the last pass
+		int cell;
+		double x;
+		double y;
+		bool shown;
+
+		//! the shown icon clustering this icon, NULL if none
+		IconEntry * leader;
+
+		//! the number of icons clustered into this icon
+		int followers;
+
+		//! the item of the icon in the active pass, -1 if not placed yet
+		int passItem;
+	};
+
+	struct PassItem
+	{
+		//! the icon, -1 if it was removed during the pass
+		int id;
+		IconEntry * entry;
+		int cell;
+		double x;
+		double y;
+		bool shown;
+
+		//! the pass item clustering this item, -1 if none
+		int leader;
+		int followers;
+	};
+
+	typedef std::pair<int,IconEntry *> CellIcon;
+
+	struct GridCell
+	{
+		//! the shown icon (the pass item during a pass), -1 if none
+		int shown;
+		IconEntry * entry;
+		double x;
+		double y;
+
+		//! the icons in the cell by priority order (empty during a pass)
+		std::vector<CellIcon> icons;
+	};
+
+	//! return true if icon a is placed before icon b
+	static bool isBefore(double priorityA,int a,double priorityB,int b);
+
+	//! project a location to the screen, return its cell or knOffScreen
+	int project(const vec3 & location,double * pX,double * pY) const;
+
+	//! find the cell of the closest shown icon within the cell size, among the cells accepted by the filter
+	template<typename Filter>
+	int findClosest(const std::vector<GridCell> & grid,int cell,double x,double y,Filter filter) const;
+
+	bool isCameraChanged(const mat4 & projection,const vec3 & eye,int width,int height) const;
+
+	void startPass(const mat4 & projection,const vec3 & eye,int width,int height);
+	void placeNext();
+	void completePass();
+
+	//! place the icons added or removed since the last pass
+	void applyChanges();
+	void markCell(int cell,std::vector<int> & cells);
+	void markNeighbours(int cell,std::vector<int> & cells);
+	void placeCells(std::vector<int> & cells);
+	void placeIcon(int id,IconEntry & entry);
+	void forgetLeader(IconEntry & leader);
+	void publish(int id,IconEntry & entry);
+
+private:
+	double m_cellSize;
+	int m_budget;
+
+	int m_nextId;
+	std::map<int,IconEntry> m_icons;
+	PriorityMap m_priorities;
+
+	//! the camera of the last pass
+	bool m_hasCamera;
+	mat4 m_projection;
+	vec3 m_eye;
+	int m_width;
+	int m_height;
+
+	int m_gridColumns;
+	int m_gridRows;
+
+	//! the placement of the last pass, updated as icons are added and removed
+	std::vector<GridCell> m_grid;
+
+	bool m_passActive;
+	PriorityMap::iterator m_passCursor;
+	std::vector<PassItem> m_passItems;
+	std::vector<GridCell> m_passGrid;
+
+	//! icons added since the last pass started
+	std::vector<int> m_pendingIcons;
+
+	//! locations of the icons to place again around
+	std::vector<vec3> m_pendingLocations;
+
+	//! icons whose placement may differ from the published one
+	std::vector<int> m_touched;
+
+	std::vector<unsigned char> m_cellMarks;
+
+	int m_placedCount;
+	std::vector<int> m_changedIcons;
+};
+
+#endif
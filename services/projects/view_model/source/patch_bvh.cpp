@@ -0,0 +1,741 @@
+/******************************************************************************
+patch_bvh.cpp
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "StdAfx.h"
+#include "patch_bvh.h"
+
+#include "pyxis/utility/profile.h"
+#include "pyxis/utility/tester.h"
+#include "pyxis/utility/trace.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+
+/////////////////////////////////////////////////////////////////////////////
+// PatchBVH
+/////////////////////////////////////////////////////////////////////////////
+
+PatchBVH::PatchBVH() : m_root(-1), m_freeNode(-1), m_count(0), m_generation(0)
+{
+}
+
+int PatchBVH::insert(const PYXPointer<Surface::Patch::VertexBuffer> & vertices,const PYXPointer<Surface::Patch> & patch)
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	int leaf = allocateNode();
+	m_nodes[leaf].patch = patch;
+	setLeafBounds(leaf,vertices);
+	insertLeaf(leaf);
+
+	m_count++;
+	return leaf;
+}
+
+void PatchBVH::remove(int id)
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	assert(id >= 0 && id < static_cast<int>(m_nodes.size()) && m_nodes[id].isLeaf() && "invalid mesh id");
+
+	removeLeaf(id);
+	freeNode(id);
+
+	m_count--;
+}
+
+void PatchBVH::update(int id,const PYXPointer<Surface::Patch::VertexBuffer> & vertices)
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	assert(id >= 0 && id < static_cast<int>(m_nodes.size()) && m_nodes[id].isLeaf() && "invalid mesh id");
+
+	//the leaf keeps its id, it is moved to the best place for its new box
+	removeLeaf(id);
+	setLeafBounds(id,vertices);
+	insertLeaf(id);
+}
+
+void PatchBVH::synchronize(const Surface::PatchVector & patches)
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	m_generation++;
+
+	for(auto & patch : patches)
+	{
+		const PYXPointer<Surface::Patch::VertexBuffer> & vertices = patch->vertices;
+
+		if (!vertices)
+		{
+			continue;
+		}
+
+		std::map<Surface::Patch*,PatchEntry>::iterator it = m_patches.find(patch.get());
+
+		if (it == m_patches.end())
+		{
+			PatchEntry entry = { insert(vertices,patch), m_generation };
+			m_patches[patch.get()] = entry;
+		}
+		else
+		{
+			it->second.generation = m_generation;
+
+			if (m_nodes[it->second.id].vertices != vertices)
+			{
+				update(it->second.id,vertices);
+			}
+		}
+	}
+
+	//remove patches that are no longer visible
+	std::map<Surface::Patch*,PatchEntry>::iterator it = m_patches.begin();
+
+	while (it != m_patches.end())
+	{
+		if (it->second.generation != m_generation)
+		{
+			remove(it->second.id);
+			m_patches.erase(it++);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void PatchBVH::clear()
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	m_nodes.clear();
+	m_patches.clear();
+	m_root = -1;
+	m_freeNode = -1;
+	m_count = 0;
+}
+
+bool PatchBVH::intersects(const Ray & ray,double & time,int & id) const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	id = -1;
+
+	if (m_root == -1)
+	{
+		return false;
+	}
+
+	vec3 inverseDirection = getInverseDirection(ray);
+
+	std::vector<int> stack;
+	stack.push_back(m_root);
+
+	while (!stack.empty())
+	{
+		const Node & node = m_nodes[stack.back()];
+		int index = stack.back();
+		stack.pop_back();
+
+		double entryTime;
+
+		//skip nodes that are farther than the closest hit
+		if (!intersectsBox(ray,inverseDirection,node,entryTime) || (id != -1 && entryTime > time))
+		{
+			continue;
+		}
+
+		if (node.isLeaf())
+		{
+			double leafTime = 0;
+
+			if (node.vertices->intersects(ray,leafTime) && (id == -1 || leafTime < time))
+			{
+				time = leafTime;
+				id = index;
+			}
+		}
+		else
+		{
+			stack.push_back(node.left);
+			stack.push_back(node.right);
+		}
+	}
+
+	return id != -1;
+}
+
+void PatchBVH::intersects(const std::vector<Ray> & rays,std::vector<double> & times,std::vector<int> & ids) const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	times.assign(rays.size(),0);
+	ids.assign(rays.size(),-1);
+
+	if (m_root == -1 || rays.empty())
+	{
+		return;
+	}
+
+	std::vector<vec3> inverseDirections;
+	std::vector<int> active;
+	inverseDirections.reserve(rays.size());
+	active.reserve(rays.size());
+
+	for(int i = 0; i < static_cast<int>(rays.size()); ++i)
+	{
+		inverseDirections.push_back(getInverseDirection(rays[i]));
+		active.push_back(i);
+	}
+
+	intersectsPacket(m_root,rays,inverseDirections,active,times,ids);
+}
+
+void PatchBVH::intersectsPacket(int index,const std::vector<Ray> & rays,const std::vector<vec3> & inverseDirections,const std::vector<int> & active,std::vector<double> & times,std::vector<int> & ids) const
+{
+	const Node & node = m_nodes[index];
+
+	//the rays of the packet that hit this node
+	std::vector<int> hitting;
+	hitting.reserve(active.size());
+
+	for(auto & ray : active)
+	{
+		double entryTime;
+
+		if (intersectsBox(rays[ray],inverseDirections[ray],node,entryTime) && (ids[ray] == -1 || entryTime <= times[ray]))
+		{
+			hitting.push_back(ray);
+		}
+	}
+
+	if (hitting.empty())
+	{
+		return;
+	}
+
+	if (node.isLeaf())
+	{
+		for(auto & ray : hitting)
+		{
+			double leafTime = 0;
+
+			if (node.vertices->intersects(rays[ray],leafTime) && (ids[ray] == -1 || leafTime < times[ray]))
+			{
+				times[ray] = leafTime;
+				ids[ray] = index;
+			}
+		}
+	}
+	else
+	{
+		intersectsPacket(node.left,rays,inverseDirections,hitting,times,ids);
+		intersectsPacket(node.right,rays,inverseDirections,hitting,times,ids);
+	}
+}
+
+PYXPointer<Surface::Patch> PatchBVH::getPatch(int id) const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	assert(id >= 0 && id < static_cast<int>(m_nodes.size()) && m_nodes[id].isLeaf() && "invalid mesh id");
+
+	return m_nodes[id].patch;
+}
+
+int PatchBVH::getCount() const
+{
+	boost::recursive_mutex::scoped_lock lock(m_mutex);
+
+	return m_count;
+}
+
+int PatchBVH::allocateNode()
+{
+	int index;
+
+	if (m_freeNode != -1)
+	{
+		index = m_freeNode;
+		m_freeNode = m_nodes[index].parent;
+	}
+	else
+	{
+		index = static_cast<int>(m_nodes.size());
+		m_nodes.push_back(Node());
+	}
+
+	Node & node = m_nodes[index];
+	node.parent = -1;
+	node.left = -1;
+	node.right = -1;
+
+	return index;
+}
+
+void PatchBVH::freeNode(int index)
+{
+	Node & node = m_nodes[index];
+	node.vertices.reset();
+	node.patch.reset();
+	node.left = -1;
+	node.right = -1;
+	node.parent = m_freeNode;
+
+	m_freeNode = index;
+}
+
+void PatchBVH::setLeafBounds(int leaf,const PYXPointer<Surface::Patch::VertexBuffer> & vertices)
+{
+	Node & node = m_nodes[leaf];
+	node.vertices = vertices;
+
+	//the box of all the vertices (the bbox sphere of the VertexBuffer is computed from a subset of them)
+	node.min = vertices->vertices_doubles[0][0];
+	node.max = vertices->vertices_doubles[0][0];
+
+	for(int u = 0; u < 10; u++)
+	{
+		for(int v = 0; v < 10; v++)
+		{
+			const vec3 & vertex = vertices->vertices_doubles[u][v];
+
+			for(int i = 0; i < 3; i++)
+			{
+				node.min[i] = std::min(node.min[i],vertex[i]);
+				node.max[i] = std::max(node.max[i],vertex[i]);
+			}
+		}
+	}
+}
+
+void PatchBVH::insertLeaf(int leaf)
+{
+	if (m_root == -1)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = -1;
+		return;
+	}
+
+	vec3 leafMin = m_nodes[leaf].min;
+	vec3 leafMax = m_nodes[leaf].max;
+
+	//find the best sibling: the cost of a node is the area it adds to the tree
+	int sibling = m_root;
+
+	while (!m_nodes[sibling].isLeaf())
+	{
+		const Node & node = m_nodes[sibling];
+
+		double area = getArea(node.min,node.max);
+		double combinedArea = getCombinedArea(node.min,node.max,leafMin,leafMax);
+
+		//the cost of a new parent for this node and the leaf
+		double cost = 2 * combinedArea;
+
+		//the minimum cost of pushing the leaf further down the tree
+		double inheritanceCost = 2 * (combinedArea - area);
+
+		double childrenCost[2];
+		int children[2] = { node.left, node.right };
+
+		for(int i = 0; i < 2; i++)
+		{
+			const Node & child = m_nodes[children[i]];
+			double childArea = getCombinedArea(child.min,child.max,leafMin,leafMax);
+
+			childrenCost[i] = (child.isLeaf() ? childArea : childArea - getArea(child.min,child.max)) + inheritanceCost;
+		}
+
+		if (cost < childrenCost[0] && cost < childrenCost[1])
+		{
+			break;
+		}
+
+		sibling = childrenCost[0] < childrenCost[1] ? children[0] : children[1];
+	}
+
+	//create a new parent for the sibling and the leaf
+	int parent = allocateNode();
+	int grandParent = m_nodes[sibling].parent;
+
+	m_nodes[parent].parent = grandParent;
+	m_nodes[parent].left = sibling;
+	m_nodes[parent].right = leaf;
+	m_nodes[sibling].parent = parent;
+	m_nodes[leaf].parent = parent;
+
+	if (grandParent == -1)
+	{
+		m_root = parent;
+	}
+	else if (m_nodes[grandParent].left == sibling)
+	{
+		m_nodes[grandParent].left = parent;
+	}
+	else
+	{
+		m_nodes[grandParent].right = parent;
+	}
+
+	refit(parent);
+}
+
+void PatchBVH::removeLeaf(int leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = -1;
+		return;
+	}
+
+	int parent = m_nodes[leaf].parent;
+	int grandParent = m_nodes[parent].parent;
+	int sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+	//replace the parent with the sibling
+	m_nodes[sibling].parent = grandParent;
+
+	if (grandParent == -1)
+	{
+		m_root = sibling;
+	}
+	else
+	{
+		if (m_nodes[grandParent].left == parent)
+		{
+			m_nodes[grandParent].left = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].right = sibling;
+		}
+
+		refit(grandParent);
+	}
+
+	m_nodes[leaf].parent = -1;
+	freeNode(parent);
+}
+
+void PatchBVH::refit(int index)
+{
+	while (index != -1)
+	{
+		Node & node = m_nodes[index];
+		const Node & left = m_nodes[node.left];
+		const Node & right = m_nodes[node.right];
+
+		node.min = left.min;
+		node.min.minimize(right.min);
+		node.max = left.max;
+		node.max.maximize(right.max);
+
+		index = node.parent;
+	}
+}
+
+vec3 PatchBVH::getInverseDirection(const Ray & ray)
+{
+	const vec3 & direction = ray.getDirection();
+	vec3 inverse;
+
+	for(int i = 0; i < 3; i++)
+	{
+		//a huge value instead of infinity, so a ray on the plane of a box face doesn't produce NaN
+		inverse[i] = direction[i] != 0 ? 1 / direction[i] : DBL_MAX;
+	}
+
+	return inverse;
+}
+
+bool PatchBVH::intersectsBox(const Ray & ray,const vec3 & inverseDirection,const Node & node,double & entryTime)
+{
+	const vec3 & origin = ray.getOrigin();
+
+	double entry = -DBL_MAX;
+	double exit = DBL_MAX;
+
+	for(int i = 0; i < 3; i++)
+	{
+		double t1 = (node.min[i] - origin[i]) * inverseDirection[i];
+		double t2 = (node.max[i] - origin[i]) * inverseDirection[i];
+
+		entry = std::max(entry,std::min(t1,t2));
+		exit = std::min(exit,std::max(t1,t2));
+	}
+
+	entryTime = entry;
+
+	//the box is hit in front of the origin
+	return exit >= std::max(entry,0.0);
+}
+
+double PatchBVH::getArea(const vec3 & min,const vec3 & max)
+{
+	vec3 size = max - min;
+
+	return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+double PatchBVH::getCombinedArea(const vec3 & minA,const vec3 & maxA,const vec3 & minB,const vec3 & maxB)
+{
+	vec3 min = minA;
+	vec3 max = maxA;
+	min.minimize(minB);
+	max.maximize(maxB);
+
+	return getArea(min,max);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// PatchBVH test
+/////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+//! create a 10x10 mesh over the square [x,x+size]x[y,y+size] with a bumpy height around z
+PYXPointer<Surface::Patch::VertexBuffer> createTestMesh(double x,double y,double size,double z)
+{
+	PYXPointer<Surface::Patch::VertexBuffer> vertices = Surface::Patch::VertexBuffer::create();
+	vertices->zero = vec3(x,y,z);
+
+	for(int u = 0; u < 10; u++)
+	{
+		for(int v = 0; v < 10; v++)
+		{
+			vertices->setVertex(u,v,vec3(x + size * u / 9,y + size * v / 9,z + 0.01 * ((u * 7 + v * 3) % 5)));
+		}
+	}
+
+	vertices->updateBBox();
+	return vertices;
+}
+
+//! test all meshes, as ViewOpenGLThread::findRayIntersection did before the PatchBVH
+bool intersectsAll(const std::map<int,PYXPointer<Surface::Patch::VertexBuffer>> & meshes,const Ray & ray,double & time,int & id)
+{
+	id = -1;
+
+	for(auto & mesh : meshes)
+	{
+		double meshTime = 0;
+
+		if (mesh.second->intersects(ray,meshTime) && (id == -1 || meshTime < time))
+		{
+			time = meshTime;
+			id = mesh.first;
+		}
+	}
+
+	return id != -1;
+}
+
+//! a grid of meshes, every second row is raised to overlap its neighbours
+void createTestGrid(int gridSize,PatchBVH & bvh,std::map<int,PYXPointer<Surface::Patch::VertexBuffer>> & meshes)
+{
+	for(int x = 0; x < gridSize; x++)
+	{
+		for(int y = 0; y < gridSize; y++)
+		{
+			PYXPointer<Surface::Patch::VertexBuffer> mesh = createTestMesh(x,y,(y % 2) ? 1.5 : 1.0,(y % 2) ? 0.5 : 0.0);
+			meshes[bvh.insert(mesh)] = mesh;
+		}
+	}
+}
+
+Ray createTestRay(double gridSize)
+{
+	vec3 origin(gridSize * rand() / RAND_MAX,gridSize * rand() / RAND_MAX,10);
+	vec3 direction(0.2 * rand() / RAND_MAX - 0.1,0.2 * rand() / RAND_MAX - 0.1,-1);
+
+	return Ray(origin,direction);
+}
+
+}
+
+//! Tester class.
+Tester<PatchBVH> gTester;
+
+void PatchBVH::test()
+{
+	srand(7);
+
+	const int gridSize = 64;
+	PatchBVH bvh;
+	std::map<int,PYXPointer<Surface::Patch::VertexBuffer>> meshes;
+	createTestGrid(gridSize,bvh,meshes);
+
+	TEST_ASSERT(bvh.getCount() == gridSize * gridSize);
+
+	//a ray hits the closest mesh
+	{
+		double time;
+		int id;
+		TEST_ASSERT(bvh.intersects(Ray(vec3(0.5,1.2,10),vec3(0,0,-1)),time,id));
+		TEST_ASSERT(meshes[id]->vertices_doubles[0][0][2] == 0.5);
+		TEST_ASSERT(!bvh.intersects(Ray(vec3(0.5,1.2,10),vec3(0,0,1)),time,id));
+		TEST_ASSERT(!bvh.intersects(Ray(vec3(-10,-10,10),vec3(0,0,-1)),time,id));
+	}
+
+	const int raysCount = 4000;
+	std::vector<Ray> rays;
+	for(int i = 0; i < raysCount; i++)
+	{
+		rays.push_back(createTestRay(gridSize));
+	}
+
+	//the hierarchy finds the same hits as testing all meshes
+	std::vector<double> expectedTimes(raysCount);
+	std::vector<int> expectedIds(raysCount);
+	for(int i = 0; i < raysCount; i++)
+	{
+		intersectsAll(meshes,rays[i],expectedTimes[i],expectedIds[i]);
+	}
+
+	std::vector<double> times(raysCount);
+	std::vector<int> ids(raysCount);
+	for(int i = 0; i < raysCount; i++)
+	{
+		bvh.intersects(rays[i],times[i],ids[i]);
+	}
+
+	for(int i = 0; i < raysCount; i++)
+	{
+		TEST_ASSERT(ids[i] == expectedIds[i]);
+		TEST_ASSERT(ids[i] == -1 || fabs(times[i] - expectedTimes[i]) < 1e-9);
+	}
+
+	//a packet finds the same hits as single rays
+	std::vector<double> packetTimes;
+	std::vector<int> packetIds;
+	for(int i = 0; i < raysCount; i += 16)
+	{
+		std::vector<Ray> packet(rays.begin() + i,rays.begin() + std::min(raysCount,i + 16));
+		std::vector<double> subTimes;
+		std::vector<int> subIds;
+		bvh.intersects(packet,subTimes,subIds);
+		packetTimes.insert(packetTimes.end(),subTimes.begin(),subTimes.end());
+		packetIds.insert(packetIds.end(),subIds.begin(),subIds.end());
+	}
+
+	TEST_ASSERT(packetIds == ids);
+	TEST_ASSERT(packetTimes == times);
+
+	//incremental updates: remove a mesh out of three and raise the remaining even rows
+	for(std::map<int,PYXPointer<Surface::Patch::VertexBuffer>>::iterator it = meshes.begin(); it != meshes.end();)
+	{
+		if (it->first % 3 == 0)
+		{
+			bvh.remove(it->first);
+			meshes.erase(it++);
+			continue;
+		}
+
+		if (it->second->vertices_doubles[0][0][2] == 0)
+		{
+			const vec3 & corner = it->second->vertices_doubles[0][0];
+			it->second = createTestMesh(corner[0],corner[1],1.0,1.0);
+			bvh.update(it->first,it->second);
+		}
+		++it;
+	}
+
+	TEST_ASSERT(bvh.getCount() == static_cast<int>(meshes.size()));
+
+	for(int i = 0; i < raysCount; i++)
+	{
+		double expectedTime = 0;
+		int expectedId;
+		double time = 0;
+		int id;
+		intersectsAll(meshes,rays[i],expectedTime,expectedId);
+		bvh.intersects(rays[i],time,id);
+		TEST_ASSERT(id == expectedId);
+		TEST_ASSERT(id == -1 || fabs(time - expectedTime) < 1e-9);
+	}
+
+	//removed ids are reused
+	{
+		int removed = meshes.begin()->first;
+		bvh.remove(removed);
+		meshes.erase(removed);
+		PYXPointer<Surface::Patch::VertexBuffer> mesh = createTestMesh(0,0,1.0,2.0);
+		int id = bvh.insert(mesh);
+		meshes[id] = mesh;
+		TEST_ASSERT(id == removed);
+
+		double time;
+		TEST_ASSERT(bvh.intersects(Ray(vec3(0.5,0.5,10),vec3(0,0,-1)),time,id));
+		TEST_ASSERT(meshes[id] == mesh);
+		TEST_ASSERT(!bvh.getPatch(id));
+	}
+
+	bvh.clear();
+	TEST_ASSERT(bvh.getCount() == 0);
+	{
+		double time;
+		int id;
+		TEST_ASSERT(!bvh.intersects(Ray(vec3(0.5,0.5,10),vec3(0,0,-1)),time,id));
+	}
+}
+
+void PatchBVH::benchmark()
+{
+	srand(7);
+
+	const int gridSize = 64;
+	PatchBVH bvh;
+	std::map<int,PYXPointer<Surface::Patch::VertexBuffer>> meshes;
+	createTestGrid(gridSize,bvh,meshes);
+
+	const int raysCount = 4000;
+	std::vector<Ray> rays;
+	for(int i = 0; i < raysCount; i++)
+	{
+		rays.push_back(createTestRay(gridSize));
+	}
+
+	PYXHighQualityTimer timer;
+	double time;
+	int id;
+
+	timer.start();
+	for(int i = 0; i < raysCount; i++)
+	{
+		intersectsAll(meshes,rays[i],time,id);
+	}
+	timer.stop();
+	double allTime = timer.getTime();
+
+	timer.start();
+	for(int i = 0; i < raysCount; i++)
+	{
+		bvh.intersects(rays[i],time,id);
+	}
+	timer.stop();
+	double bvhTime = timer.getTime();
+
+	timer.start();
+	for(int i = 0; i < raysCount; i += 16)
+	{
+		std::vector<Ray> packet(rays.begin() + i,rays.begin() + std::min(raysCount,i + 16));
+		std::vector<double> times;
+		std::vector<int> ids;
+		bvh.intersects(packet,times,ids);
+	}
+	timer.stop();
+	double packetTime = timer.getTime();
+
+	TRACE_INFO("PatchBVH: " << raysCount << " rays over " << bvh.getCount() << " meshes: all meshes " << allTime << "[sec], bvh " << bvhTime << "[sec], packets of 16 " << packetTime << "[sec]");
+}
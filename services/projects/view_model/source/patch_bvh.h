@@ -0,0 +1,134 @@
+#pragma once
+#ifndef VIEW_MODEL__PATCH_BVH_H
+#define VIEW_MODEL__PATCH_BVH_H
+/******************************************************************************
+patch_bvh.h
+
+begin		: 2026-10-19
+copyright	: (C) 2026 by the PYXIS innovation inc.
+web			: www.pyxisinnovation.com
+******************************************************************************/
+
+#include "cml_utils.h"
+#include "ray.h"
+#include "surface.h"
+
+#include "pyxis/utility/object.h"
+
+#include <boost/thread/recursive_mutex.hpp>
+
+#include <map>
+#include <vector>
+
+/*!
+PatchBVH - bounding volume hierarchy over the meshes of the loaded surface patches, used to find ray intersections.
+
+-- Description:
+	 - Each leaf holds the VertexBuffer of a patch and the axis aligned box of its vertices.
+	 - Leaves are inserted, removed and updated incrementally: a leaf is inserted next to the node that increases the
+	   boxes area the least, and the boxes of its ancestors are refitted.
+	 - synchronize() updates the leaves from the visible patches of a Surface: new meshes are inserted, meshes that
+	   were replaced (elevation loaded) are updated and patches that are no longer visible are removed.
+	 - A ray visits the nodes it hits and skips nodes that are farther than the closest hit found so far.
+	 - A packet of rays visits the tree once, each node is tested by the rays that hit its parent.
+	 - The index doesn't use OpenGL, it can be built from VertexBuffers only.
+
+-- Limitations:
+	 - The tree is not rebalanced, the insertion heuristic keeps it reasonable for the patches of a surface.
+*/
+//! PatchBVH - bounding volume hierarchy over the meshes of the loaded surface patches
+class PatchBVH : public PYXObject
+{
+public:
+	static void test();
+
+	//! Time 4000 rays over a grid of 4096 meshes, testing all meshes, the hierarchy and packets (not run by the tests).
+	static void benchmark();
+
+	static PYXPointer<PatchBVH> create()
+	{
+		return PYXNEW(PatchBVH);
+	}
+
+	PatchBVH();
+
+public:
+	//! insert a mesh, return its id
+	int insert(const PYXPointer<Surface::Patch::VertexBuffer> & vertices,const PYXPointer<Surface::Patch> & patch = PYXPointer<Surface::Patch>());
+
+	//! remove a mesh
+	void remove(int id);
+
+	//! replace the vertices of a mesh
+	void update(int id,const PYXPointer<Surface::Patch::VertexBuffer> & vertices);
+
+	//! update the meshes to match the given patches
+	void synchronize(const Surface::PatchVector & patches);
+
+	//! remove all the meshes
+	void clear();
+
+	//! find the closest intersection of a ray, return false if the ray doesn't hit any mesh
+	bool intersects(const Ray & ray,double & time,int & id) const;
+
+	//! find the closest intersection of each ray (id is -1 if the ray doesn't hit any mesh)
+	void intersects(const std::vector<Ray> & rays,std::vector<double> & times,std::vector<int> & ids) const;
+
+	//! get the patch of a mesh (null if the mesh was inserted without a patch)
+	PYXPointer<Surface::Patch> getPatch(int id) const;
+
+	int getCount() const;
+
+private:
+	struct Node
+	{
+		vec3 min;
+		vec3 max;
+
+		//! the parent node, or the next free node
+		int parent;
+		int left;
+		int right;
+
+		PYXPointer<Surface::Patch::VertexBuffer> vertices;
+		PYXPointer<Surface::Patch> patch;
+
+		bool isLeaf() const { return left == -1; }
+	};
+
+	struct PatchEntry
+	{
+		int id;
+		int generation;
+	};
+
+	int allocateNode();
+	void freeNode(int index);
+
+	void setLeafBounds(int leaf,const PYXPointer<Surface::Patch::VertexBuffer> & vertices);
+
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	void refit(int index);
+
+	void intersectsPacket(int index,const std::vector<Ray> & rays,const std::vector<vec3> & inverseDirections,const std::vector<int> & active,std::vector<double> & times,std::vector<int> & ids) const;
+
+	static vec3 getInverseDirection(const Ray & ray);
+	static bool intersectsBox(const Ray & ray,const vec3 & inverseDirection,const Node & node,double & entryTime);
+	static double getArea(const vec3 & min,const vec3 & max);
+	static double getCombinedArea(const vec3 & minA,const vec3 & maxA,const vec3 & minB,const vec3 & maxB);
+
+private:
+	mutable boost::recursive_mutex m_mutex;
+
+	std::vector<Node> m_nodes;
+	int m_root;
+	int m_freeNode;
+	int m_count;
+
+	//! the leaves of the synchronized patches
+	std::map<Surface::Patch*,PatchEntry> m_patches;
+	int m_generation;
+};
+
+#endif
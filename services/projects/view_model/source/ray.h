@@ -51,6 +51,7 @@ public:
 	{
 		m_origin = other.m_origin;
 		m_direction = other.m_direction;
+		return *this;
 	}
 
 	const vec3 & getOrigin() const { return m_origin; }
@@ -560,6 +560,9 @@ PYXPointer<PYXGeometry> View::getScreenGeometry(int borderOffsetInPixels)
 	auto width = getViewportWidth() - borderOffsetInPixels*2;
 	auto height = getViewportHeight() - borderOffsetInPixels*2;
 
+	//sample the screen border with a packet of rays
+	std::vector<Ray> rays;
+
 	for(int i=0;i<40;i++)
 	{
 		int x = borderOffsetInPixels;
@@ -586,10 +589,18 @@ PYXPointer<PYXGeometry> View::getScreenGeometry(int borderOffsetInPixels)
 			break;
 		}
 		
-		auto ray = m_openGLThread->getRay(vec2(x,y));
-		vec3 intersection;
-		if (m_openGLThread->findRayIntersection(ray,intersection))
+		rays.push_back(m_openGLThread->getRay(vec2(x,y)));
+	}
+
+	std::vector<vec3> intersections;
+	std::vector<bool> found;
+	m_openGLThread->findRayIntersections(rays,intersections,found);
+
+	for(unsigned int i=0;i<rays.size();i++)
+	{
+		if (found[i])
 		{
+			vec3 intersection = intersections[i];
 			intersection.normalize();
 			verticies.push_back(CmlConvertor::toPYXCoord3D(intersection));
 		}
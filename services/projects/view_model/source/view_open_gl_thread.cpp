@@ -77,6 +77,7 @@ ViewOpenGLThread::ViewOpenGLThread(View & view)
 	copyViewState();
 	
 	m_pointerLocation.zero();
+	m_patchBVH = PatchBVH::create();
 	m_nMouseX = 0;
 	m_nMouseY = 0;
 	m_needToFindPointerLocation = true;
@@ -508,6 +509,9 @@ void ViewOpenGLThread::setupRender()
 	
 	setFrameTimeMeasurement("setup-terrain-update");
 
+	//update the picking hierarchy with the patches loaded or unloaded by this frame
+	m_patchBVH->synchronize(getSurface()->getVisiblePatches());
+
 	PerformanceCounter::getTimePerformanceCounter("start find pointer location",0.0f,0.0f,1.0f)->makeMeasurement();
 
 	std::map<std::string,long> status = MemoryManager::getInstance()->getMemoryStatus();
@@ -1213,35 +1217,10 @@ void ViewOpenGLThread::cameraChanged(PYXPointer<NotifierEvent> event)
 
 bool ViewOpenGLThread::findRayIntersection(const Ray & ray,vec3 & intersection)
 {
-	PYXPointer<Surface::Patch> intersectedPatch;
 	double minTime = 0;
+	int id;
 
-	Surface::PatchVector & visible = getSurface()->getVisiblePatches();
-	Surface::PatchVector::iterator it = visible.begin();
-
-	while(it != visible.end())
-	{
-		//fast look up first...
-		if (ray.intersectsWithSphere((*it)->getBBox().getCenter(),(*it)->getBBox().getRadius()))
-		{
-			PYXPointer<Surface::Patch::VertexBuffer> mesh = (*it)->vertices;
-			if (mesh)
-			{
-				double time = 0;
-				if (mesh->intersects(ray,time))
-				{
-					if (!intersectedPatch || time < minTime)
-					{
-						minTime = time;
-						intersectedPatch = *it;
-					}
-				}
-			}
-		}
-		++it;
-	}
-
-	if (intersectedPatch)
+	if (m_patchBVH->intersects(ray,minTime,id))
 	{
 		intersection = ray.getPointFromTime(minTime);
 		return true;
@@ -1250,36 +1229,42 @@ bool ViewOpenGLThread::findRayIntersection(const Ray & ray,vec3 & intersection)
 	return false;
 }
 
+void ViewOpenGLThread::findRayIntersections(const std::vector<Ray> & rays,std::vector<vec3> & intersections,std::vector<bool> & found)
+{
+	std::vector<double> times;
+	std::vector<int> ids;
+
+	m_patchBVH->intersects(rays,times,ids);
+
+	intersections.resize(rays.size());
+	found.resize(rays.size());
+
+	for(unsigned int i = 0; i < rays.size(); ++i)
+	{
+		found[i] = ids[i] != -1;
+
+		if (found[i])
+		{
+			intersections[i] = rays[i].getPointFromTime(times[i]);
+		}
+		else
+		{
+			intersections[i].zero();
+		}
+	}
+}
+
 void ViewOpenGLThread::findPointerLocation()
 {
 	Ray ray = getMouseRay();
 
 	PYXPointer<Surface::Patch> intersectedPatch;
 	double minTime = 0;
+	int id;
 
-	Surface::PatchVector & visible = getSurface()->getVisiblePatches();
-	Surface::PatchVector::iterator it = visible.begin();
-
-	while(it != visible.end())
+	if (m_patchBVH->intersects(ray,minTime,id))
 	{
-		//fast look up first...
-		if (ray.intersectsWithSphere((*it)->getBBox().getCenter(),(*it)->getBBox().getRadius()))
-		{
-			PYXPointer<Surface::Patch::VertexBuffer> mesh = (*it)->vertices;
-			if (mesh)
-			{
-				double time = 0;
-				if (mesh->intersects(ray,time))
-				{
-					if (!intersectedPatch || time < minTime)
-					{
-						minTime = time;
-						intersectedPatch = *it;
-					}
-				}
-			}
-		}
-		++it;
+		intersectedPatch = m_patchBVH->getPatch(id);
 	}
 
 	if (intersectedPatch)
@@ -15,6 +15,7 @@ web			: www.pyxisinnovation.com
 #include "open_gl_context.h"
 #include "camera.h"
 #include "ray.h"
+#include "patch_bvh.h"
 #include "surface_fillers.h"
 #include "annotation.h"
 #include "component.h"
@@ -181,6 +182,9 @@ protected:
 	int  m_pointerResolution;
 
 	PYXPointer<Surface::Patch> m_pointerPatch;
+
+	//! bounding volume hierarchy over the meshes of the visible patches, synchronized every frame
+	PYXPointer<PatchBVH> m_patchBVH;
 	
 	//! find pointer location on surface by intersecting the STile mesh
 	void findPointerLocation();
@@ -203,6 +207,9 @@ public:
 	//! find intersection point of a ray with the earth mesh
 	bool findRayIntersection(const Ray & ray,vec3 & intersection);
 
+	//! find the intersection points of a packet of rays with the earth mesh, found[i] is false if rays[i] doesn't hit the mesh
+	void findRayIntersections(const std::vector<Ray> & rays,std::vector<vec3> & intersections,std::vector<bool> & found);
+
 	//! gets pointer location of the earth surface (on the earth mesh)
 	const vec3 & getPointerLocation();
 